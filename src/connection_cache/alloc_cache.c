@@ -257,6 +257,11 @@ spatialite_alloc_connection ()
     cache->decimal_precision = -1;
     cache->GEOS_handle = NULL;
     cache->PROJ_handle = NULL;
+    cache->wkt_parser = NULL;
+    cache->ewkt_parser = NULL;
+    cache->geojson_parser = NULL;
+    cache->kml_parser = NULL;
+    cache->gml_parser = NULL;
     cache->pool_index = pool_index;
     confirm (pool_index, cache);
 /* initializing the XML error buffers */
@@ -345,6 +350,13 @@ free_internal_cache (struct splite_internal_cache *cache)
     cache->PROJ_handle = NULL;
 #endif
 
+/* freeing the reusable text geometry parsers */
+    gaiaWktParserDestroy (cache->wkt_parser);
+    gaiaEwktParserDestroy (cache->ewkt_parser);
+    gaiaGeoJsonParserDestroy (cache->geojson_parser);
+    gaiaKmlParserDestroy (cache->kml_parser);
+    gaiaGmlParserDestroy (cache->gml_parser);
+
 /* freeing the XML error buffers */
     gaiaOutBufferReset (cache->xmlParsingErrors);
     gaiaOutBufferReset (cache->xmlSchemaValidationErrors);
@@ -736,6 +736,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 {
 /* populating the target DB - by distinct layers */
     int ret;
+    int reuse;
     sqlite3_stmt *stmt;
     sqlite3_stmt *stmt_ext;
     sqlite3_stmt *stmt_pattern;
@@ -804,7 +805,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_text_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3Dtext ? "3d" : "2d");
-		if (append
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse
 		    && check_text_table (handle, name, dxf->srid,
 					 lyr->is3Dtext))
 		  {
@@ -825,7 +827,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraText)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -972,7 +974,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_point_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3Dpoint ? "3d" : "2d");
-		if (append
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse
 		    && check_point_table (handle, name, dxf->srid,
 					  lyr->is3Dpoint))
 		  {
@@ -994,7 +997,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraPoint)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -1137,7 +1140,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_line_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3Dline ? "3d" : "2d");
-		if (append
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse
 		    && check_line_table (handle, name, dxf->srid,
 					 lyr->is3Dline))
 		  {
@@ -1159,7 +1163,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraLine)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -1314,7 +1318,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_polyg_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3Dpolyg ? "3d" : "2d");
-		if (append
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse
 		    && check_polyg_table (handle, name, dxf->srid,
 					  lyr->is3Dpolyg))
 		  {
@@ -1336,7 +1341,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraPolyg)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -1560,7 +1565,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		    name =
 			sqlite3_mprintf ("%s%s_hatch_2d", dxf->prefix,
 					 lyr->layer_name);
-		if (append && check_hatch_tables (handle, name, dxf->srid))
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse && check_hatch_tables (handle, name, dxf->srid))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_hatch_boundary_stmt (handle, name, &stmt))
@@ -1715,7 +1721,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_instext_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3DinsText ? "3d" : "2d");
-		if (append && check_insert_table (handle, name))
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse && check_insert_table (handle, name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_insert_stmt (handle, name, &stmt))
@@ -1743,7 +1750,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraInsText)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -1883,7 +1890,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_inspoint_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3DinsPoint ? "3d" : "2d");
-		if (append && check_insert_table (handle, name))
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse && check_insert_table (handle, name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_insert_stmt (handle, name, &stmt))
@@ -1911,7 +1919,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraInsPoint)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -2051,7 +2059,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_insline_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3DinsLine ? "3d" : "2d");
-		if (append && check_insert_table (handle, name))
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse && check_insert_table (handle, name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_insert_stmt (handle, name, &stmt))
@@ -2079,7 +2088,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraInsLine)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -2219,7 +2228,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 			sqlite3_mprintf ("%s%s_inspolyg_%s", dxf->prefix,
 					 lyr->layer_name,
 					 lyr->is3DinsPolyg ? "3d" : "2d");
-		if (append && check_insert_table (handle, name))
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse && check_insert_table (handle, name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_insert_stmt (handle, name, &stmt))
@@ -2247,7 +2257,7 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		if (lyr->hasExtraInsPolyg)
 		  {
 		      attr_name = create_extra_attr_table_name (name);
-		      if (append && check_extra_attr_table (handle, attr_name))
+		      if (reuse && check_extra_attr_table (handle, attr_name))
 			{
 			    /* appending into the already existing table */
 			    if (!create_extra_stmt
@@ -2384,7 +2394,8 @@ import_by_layer (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 		    name =
 			sqlite3_mprintf ("%s%s_inspolyg_2d", dxf->prefix,
 					 lyr->layer_name);
-		if (append && check_insert_table (handle, name))
+		reuse = dxf_append_table (dxf, name, append);
+		if (reuse && check_insert_table (handle, name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_insert_stmt (handle, name, &stmt))
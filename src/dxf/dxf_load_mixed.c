@@ -794,6 +794,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
     int insLine3D = 0;
     int insPolyg3D = 0;
     int ret;
+    int reuse;
     sqlite3_stmt *stmt;
     sqlite3_stmt *stmt_ext;
     sqlite3_stmt *stmt_pattern;
@@ -874,7 +875,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%stext_layer_%s", dxf->prefix,
 				   text3D ? "3d" : "2d");
-	  if (append && check_text_table (handle, name, dxf->srid, text3D))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_text_table (handle, name, dxf->srid, text3D))
 	    {
 		/* appending into the already existing table */
 		if (!create_text_stmt (handle, name, &stmt))
@@ -890,7 +892,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraText)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -1026,7 +1028,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%spoint_layer_%s", dxf->prefix,
 				   point3D ? "3d" : "2d");
-	  if (append && check_point_table (handle, name, dxf->srid, point3D))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_point_table (handle, name, dxf->srid, point3D))
 	    {
 		/* appending into the already existing table */
 		if (!create_point_stmt (handle, name, &stmt))
@@ -1042,7 +1045,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraPoint)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -1174,7 +1177,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%sline_layer_%s", dxf->prefix,
 				   line3D ? "3d" : "2d");
-	  if (append && check_line_table (handle, name, dxf->srid, line3D))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_line_table (handle, name, dxf->srid, line3D))
 	    {
 		/* appending into the already existing table */
 		if (!create_line_stmt (handle, name, &stmt))
@@ -1190,7 +1194,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraLine)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -1336,7 +1340,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%spolyg_layer_%s", dxf->prefix,
 				   polyg3D ? "3d" : "2d");
-	  if (append && check_polyg_table (handle, name, dxf->srid, polyg3D))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_polyg_table (handle, name, dxf->srid, polyg3D))
 	    {
 		/* appending into the already existing table */
 		if (!create_polyg_stmt (handle, name, &stmt))
@@ -1352,7 +1357,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraPolyg)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -1570,7 +1575,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name = sqlite3_mprintf ("hatch_layer_2d");
 	  else
 	      name = sqlite3_mprintf ("%shatch_layer_2d", dxf->prefix);
-	  if (append && check_hatch_tables (handle, name, dxf->srid))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_hatch_tables (handle, name, dxf->srid))
 	    {
 		/* appending into the already existing tables */
 		if (!create_hatch_boundary_stmt (handle, name, &stmt))
@@ -1707,7 +1713,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%sinstext_layer_%s", dxf->prefix,
 				   insText3D ? "3d" : "2d");
-	  if (append && check_insert_table (handle, name))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_insert_table (handle, name))
 	    {
 		/* appending into the already existing table */
 		if (!create_insert_stmt (handle, name, &stmt))
@@ -1732,7 +1739,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraInsText)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -1864,7 +1871,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%sinspoint_layer_%s", dxf->prefix,
 				   insPoint3D ? "3d" : "2d");
-	  if (append && check_insert_table (handle, name))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_insert_table (handle, name))
 	    {
 		/* appending into the already existing table */
 		if (!create_insert_stmt (handle, name, &stmt))
@@ -1889,7 +1897,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraInsPoint)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -2020,7 +2028,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%sinsline_layer_%s", dxf->prefix,
 				   insLine3D ? "3d" : "2d");
-	  if (append && check_insert_table (handle, name))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_insert_table (handle, name))
 	    {
 		/* appending into the already existing table */
 		if (!create_insert_stmt (handle, name, &stmt))
@@ -2045,7 +2054,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraInsLine)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -2177,7 +2186,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name =
 		  sqlite3_mprintf ("%sinspolyg_layer_%s", dxf->prefix,
 				   insPolyg3D ? "3d" : "2d");
-	  if (append && check_insert_table (handle, name))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_insert_table (handle, name))
 	    {
 		/* appending into the already existing table */
 		if (!create_insert_stmt (handle, name, &stmt))
@@ -2202,7 +2212,7 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	  if (hasExtraInsPolyg)
 	    {
 		extra_name = create_extra_attr_table_name (name);
-		if (append && check_extra_attr_table (handle, extra_name))
+		if (reuse && check_extra_attr_table (handle, extra_name))
 		  {
 		      /* appending into the already existing table */
 		      if (!create_extra_stmt (handle, extra_name, &stmt_ext))
@@ -2330,7 +2340,8 @@ import_mixed (sqlite3 * handle, gaiaDxfParserPtr dxf, int append)
 	      name = sqlite3_mprintf ("inshatch_layer_2d");
 	  else
 	      name = sqlite3_mprintf ("%sinshatch_layer_2d", dxf->prefix);
-	  if (append && check_insert_table (handle, name))
+	  reuse = dxf_append_table (dxf, name, append);
+	  if (reuse && check_insert_table (handle, name))
 	    {
 		/* appending into the already existing table */
 		if (!create_insert_stmt (handle, name, &stmt))
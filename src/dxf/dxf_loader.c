@@ -56,6 +56,15 @@ Regione Toscana - Settore Sistema Informativo Territoriale ed Ambientale
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include <io.h>
+#include <direct.h>
+#else
+#include <dirent.h>
+#endif
 
 #if defined(_WIN32) && !defined(__MINGW32__)
 #include "config-msvc.h"
@@ -78,6 +87,12 @@ Regione Toscana - Settore Sistema Informativo Territoriale ed Ambientale
 #define strcasecmp	_stricmp
 #endif /* not WIN32 */
 
+#ifndef _WIN32
+/* DXF files are parsed by a pool of worker threads */
+#define DXF_PARALLEL_LOAD
+#include <pthread.h>
+#endif
+
 DXF_PRIVATE int
 create_text_stmt (sqlite3 * handle, const char *name, sqlite3_stmt ** xstmt)
 {
@@ -3946,3 +3961,755 @@ gaiaLoadFromDxfParser (sqlite3 * handle,
 	ret = import_by_layer (handle, dxf, append);
     return ret;
 }
+
+DXF_PRIVATE int
+dxf_append_table (gaiaDxfParserPtr dxf, const char *name, int append)
+{
+/*
+/ checking if the rows should be appended to an already existing table
+/ - usually this only happens when APPEND is set
+/ - in streaming mode any table created by a previous flush is always
+/   appended, but the first flush storing into some table still has to
+/   respect APPEND exactly as a plain import would do
+*/
+    gaiaDxfStreamPtr stream = (gaiaDxfStreamPtr) (dxf->stream);
+    gaiaDxfStreamTablePtr tbl;
+    if (stream == NULL || stream->handle == NULL)
+	return append;
+    tbl = stream->first_table;
+    while (tbl != NULL)
+      {
+	  if (strcmp (tbl->name, name) == 0)
+	      return 1;
+	  tbl = tbl->next;
+      }
+    tbl = malloc (sizeof (gaiaDxfStreamTable));
+    if (tbl == NULL)
+	return append;
+    tbl->name = malloc (strlen (name) + 1);
+    if (tbl->name == NULL)
+      {
+	  free (tbl);
+	  return append;
+      }
+    strcpy (tbl->name, name);
+    tbl->next = stream->first_table;
+    stream->first_table = tbl;
+    return append;
+}
+
+#ifndef OMIT_GEOS		/* only if GEOS is enabled */
+
+static void
+free_dxf_stream_tables (gaiaDxfStreamPtr stream)
+{
+/* memory cleanup - destroying the list of tables stored into */
+    gaiaDxfStreamTablePtr tbl = stream->first_table;
+    gaiaDxfStreamTablePtr n_tbl;
+    while (tbl != NULL)
+      {
+	  n_tbl = tbl->next;
+	  free (tbl->name);
+	  free (tbl);
+	  tbl = n_tbl;
+      }
+    stream->first_table = NULL;
+}
+
+static void
+copy_dxf_layer_infos (gaiaDxfParserPtr dxf, gaiaDxfParserPtr infos)
+{
+/* applying the Layer infos collected by the first streaming pass */
+    gaiaDxfLayerPtr lyr = dxf->first_layer;
+    while (lyr != NULL)
+      {
+	  gaiaDxfLayerPtr info = infos->first_layer;
+	  while (info != NULL)
+	    {
+		if (strcmp (lyr->layer_name, info->layer_name) == 0)
+		  {
+		      lyr->is3Dtext |= info->is3Dtext;
+		      lyr->is3Dpoint |= info->is3Dpoint;
+		      lyr->is3Dline |= info->is3Dline;
+		      lyr->is3Dpolyg |= info->is3Dpolyg;
+		      lyr->is3DinsText |= info->is3DinsText;
+		      lyr->is3DinsPoint |= info->is3DinsPoint;
+		      lyr->is3DinsLine |= info->is3DinsLine;
+		      lyr->is3DinsPolyg |= info->is3DinsPolyg;
+		      lyr->hasExtraText |= info->hasExtraText;
+		      lyr->hasExtraPoint |= info->hasExtraPoint;
+		      lyr->hasExtraLine |= info->hasExtraLine;
+		      lyr->hasExtraPolyg |= info->hasExtraPolyg;
+		      lyr->hasExtraInsText |= info->hasExtraInsText;
+		      lyr->hasExtraInsPoint |= info->hasExtraInsPoint;
+		      lyr->hasExtraInsLine |= info->hasExtraInsLine;
+		      lyr->hasExtraInsPolyg |= info->hasExtraInsPolyg;
+		      break;
+		  }
+		info = info->next;
+	    }
+	  lyr = lyr->next;
+      }
+}
+
+static int
+store_dxf_stream_batch (gaiaDxfParserPtr dxf)
+{
+/*
+/ streaming mode: storing all pending entities into the DB; any table
+/ created by a previous batch will then be appended (see dxf_append_table)
+*/
+    gaiaDxfStreamPtr stream = (gaiaDxfStreamPtr) (dxf->stream);
+    int ret = 1;
+    copy_dxf_layer_infos (dxf, stream->infos);
+    if (stream->flushes == 0 && dxf->first_block != NULL)
+	ret = import_blocks (stream->handle, dxf, stream->append);
+    if (ret)
+      {
+	  if (stream->mode == GAIA_DXF_IMPORT_MIXED)
+	      ret = import_mixed (stream->handle, dxf, stream->append);
+	  else
+	      ret = import_by_layer (stream->handle, dxf, stream->append);
+      }
+    stream->flushes++;
+    return ret;
+}
+
+DXF_PRIVATE int
+flush_dxf_stream (gaiaDxfParserPtr dxf)
+{
+/*
+/ streaming mode: flushing all pending entities
+/ - first pass: entities are simply discarded (the Layer infos survive)
+/ - second pass: entities are stored into the DB, possibly by another
+/   thread owning the DB connection (see dxf_load_parallel)
+*/
+    gaiaDxfStreamPtr stream = (gaiaDxfStreamPtr) (dxf->stream);
+    gaiaDxfLayerPtr lyr;
+    int ret = 1;
+    if (stream->handoff != NULL)
+	ret = stream->handoff (stream->handoff_ctx, dxf);
+    else if (stream->handle != NULL)
+	ret = store_dxf_stream_batch (dxf);
+    lyr = dxf->first_layer;
+    while (lyr != NULL)
+      {
+	  reset_dxf_layer_entities (lyr);
+	  lyr = lyr->next;
+      }
+    stream->pending = 0;
+    return ret;
+}
+
+static int
+is_small_dxf_file (const char *path)
+{
+/* testing if a DXF file can be parsed by a single pass */
+    struct stat st;
+    if (stat (path, &st) != 0)
+	return 0;
+    if (st.st_size > DXF_STREAM_SINGLE_PASS)
+	return 0;
+    return 1;
+}
+
+static int
+load_from_dxf_file_ex (const void *p_cache, sqlite3 * handle,
+		       gaiaDxfParserPtr dxf, const char *path, int mode,
+		       int append, int (*handoff) (void *, gaiaDxfParserPtr),
+		       void *handoff_ctx)
+{
+/*
+/ parsing a DXF file and storing its entities into the DB - streaming
+/ each batch is either stored directly or passed to HANDOFF
+/ - a small file is parsed just once, all its entities being stored
+/   by a single final batch
+/ - a large file is parsed twice: the first pass only collects the
+/   Layer infos required to create the tables
+*/
+    gaiaDxfStream stream;
+    gaiaDxfStream stream_infos;
+    gaiaDxfParserPtr infos = NULL;
+    int special_rings = GAIA_DXF_RING_NONE;
+    int ret = 0;
+
+    if (dxf == NULL)
+	return 0;
+    if (dxf->linked_rings)
+	special_rings = GAIA_DXF_RING_LINKED;
+    if (dxf->unlinked_rings)
+	special_rings = GAIA_DXF_RING_UNLINKED;
+    stream.handle = handle;
+    stream.mode = mode;
+    stream.append = append;
+    stream.flushes = 0;
+    stream.pending = 0;
+    stream.batch = 0;
+    stream.infos = dxf;
+    stream.first_table = NULL;
+    stream.handoff = handoff;
+    stream.handoff_ctx = handoff_ctx;
+    if (is_small_dxf_file (path))
+	goto store;
+
+/* first pass: collecting the Layer infos */
+    infos =
+	gaiaCreateDxfParser (dxf->srid, dxf->force_dims, dxf->prefix,
+			     dxf->selected_layer, special_rings);
+    if (infos == NULL)
+	return 0;
+    stream_infos.handle = NULL;
+    stream_infos.mode = mode;
+    stream_infos.append = append;
+    stream_infos.flushes = 0;
+    stream_infos.pending = 0;
+    stream_infos.batch = DXF_STREAM_BATCH;
+    stream_infos.infos = NULL;
+    stream_infos.first_table = NULL;
+    stream_infos.handoff = NULL;
+    stream_infos.handoff_ctx = NULL;
+    infos->stream = &stream_infos;
+    if (!parse_dxf_file (p_cache, infos, path))
+	goto stop;
+    flush_dxf_stream (infos);
+    stream.batch = DXF_STREAM_BATCH;
+    stream.infos = infos;
+
+  store:
+/* storing all entities into the DB */
+    dxf->stream = &stream;
+    if (!parse_dxf_file (p_cache, dxf, path))
+	goto stop;
+    if (dxf->first_layer == NULL)
+	goto stop;
+    if (!flush_dxf_stream (dxf))
+	goto stop;
+    ret = 1;
+
+  stop:
+    if (dxf->stream != NULL)
+	free_dxf_stream_tables (&stream);
+    dxf->stream = NULL;
+    if (infos != NULL)
+      {
+	  infos->stream = NULL;
+	  gaiaDestroyDxfParser (infos);
+      }
+    return ret;
+}
+
+static int
+load_from_dxf_file (const void *p_cache, sqlite3 * handle,
+		    gaiaDxfParserPtr dxf, const char *path, int mode,
+		    int append)
+{
+/* parsing a DXF file and storing its entities into the DB - streaming */
+    return load_from_dxf_file_ex (p_cache, handle, dxf, path, mode, append,
+				  NULL, NULL);
+}
+
+GAIAGEO_DECLARE int
+gaiaLoadFromDxfFile (sqlite3 * handle, gaiaDxfParserPtr dxf,
+		     const char *path, int mode, int append)
+{
+    return load_from_dxf_file (NULL, handle, dxf, path, mode, append);
+}
+
+GAIAGEO_DECLARE int
+gaiaLoadFromDxfFile_r (const void *p_cache, sqlite3 * handle,
+		       gaiaDxfParserPtr dxf, const char *path, int mode,
+		       int append)
+{
+    return load_from_dxf_file (p_cache, handle, dxf, path, mode, append);
+}
+
+struct dxf_dir_options
+{
+/* the options shared by all DXF files imported from a directory */
+    int srid;
+    int force_dims;
+    const char *prefix;
+    const char *selected_layer;
+    int special_rings;
+    int mode;
+    int append;
+};
+
+struct dxf_dir_list
+{
+/* the DXF files found within a directory */
+    char **paths;
+    int count;
+    int max;
+};
+
+static int
+is_dxf_file (const char *filename)
+{
+/* testing if a FileName ends with the expected suffix */
+    int len = strlen (filename);
+    int off = len - 4;
+    if (off >= 1)
+      {
+	  if (strcasecmp (filename + off, ".dxf") == 0)
+	      return 1;
+      }
+    return 0;
+}
+
+static void
+add_dxf_dir_path (struct dxf_dir_list *list, const char *dir_path,
+		  const char *name)
+{
+/* adding a DXF file to the list */
+    if (list->count >= list->max)
+      {
+	  int max = (list->max == 0) ? 64 : list->max * 2;
+	  char **paths = realloc (list->paths, sizeof (char *) * max);
+	  if (paths == NULL)
+	      return;
+	  list->paths = paths;
+	  list->max = max;
+      }
+    *(list->paths + list->count) = sqlite3_mprintf ("%s/%s", dir_path, name);
+    list->count += 1;
+}
+
+static void
+free_dxf_dir_list (struct dxf_dir_list *list)
+{
+/* memory cleanup - destroying the list of DXF files */
+    int i;
+    for (i = 0; i < list->count; i++)
+	sqlite3_free (*(list->paths + i));
+    if (list->paths != NULL)
+	free (list->paths);
+}
+
+static int
+cmp_dxf_dir_paths (const void *p1, const void *p2)
+{
+/* sorting the DXF files by name */
+    return strcmp (*((char **) p1), *((char **) p2));
+}
+
+static int
+scan_dxf_dir (const char *dir_path, struct dxf_dir_list *list)
+{
+/* scanning a Directory and listing all DXF files */
+#if defined(_WIN32) && !defined(__MINGW32__)
+/* Visual Studio .NET */
+    struct _finddata_t c_file;
+    intptr_t hFile;
+    if (_chdir (dir_path) < 0)
+	return 0;
+    if ((hFile = _findfirst ("*.*", &c_file)) == -1L)
+	;
+    else
+      {
+	  while (1)
+	    {
+		if ((c_file.attrib & _A_RDONLY) == _A_RDONLY
+		    || (c_file.attrib & _A_NORMAL) == _A_NORMAL)
+		  {
+		      if (is_dxf_file (c_file.name))
+			  add_dxf_dir_path (list, dir_path, c_file.name);
+		  }
+		if (_findnext (hFile, &c_file) != 0)
+		    break;
+	    };
+	  _findclose (hFile);
+      }
+#else
+/* not Visual Studio .NET */
+    struct dirent *entry;
+    DIR *dir = opendir (dir_path);
+    if (!dir)
+	return 0;
+    while (1)
+      {
+	  /* scanning dir-entries */
+	  entry = readdir (dir);
+	  if (!entry)
+	      break;
+	  if (is_dxf_file (entry->d_name))
+	      add_dxf_dir_path (list, dir_path, entry->d_name);
+      }
+    closedir (dir);
+#endif
+    return 1;
+}
+
+static int
+load_dxf_dir_file (const void *p_cache, sqlite3 * handle, const char *path,
+		   const struct dxf_dir_options *options)
+{
+/* parsing and storing a single DXF file */
+    int ret;
+    gaiaDxfParserPtr dxf =
+	gaiaCreateDxfParser (options->srid, options->force_dims,
+			     options->prefix, options->selected_layer,
+			     options->special_rings);
+    if (dxf == NULL)
+	return 0;
+    ret =
+	load_from_dxf_file (p_cache, handle, dxf, path, options->mode,
+			    options->append);
+    gaiaDestroyDxfParser (dxf);
+    return ret;
+}
+
+static void
+report_dxf_dir_file (const char *path, int ret)
+{
+/* reporting the outcome of a DXF file import */
+    if (ret)
+	spatialite_e ("\n*** DXF file successfully loaded\n");
+    else
+	spatialite_e ("Unable to load: %s\n", path);
+}
+
+#ifdef DXF_PARALLEL_LOAD
+
+#define DXF_LOAD_MAX_THREADS	16
+
+struct dxf_load_file
+{
+/* a DXF file streamed by some worker */
+    const char *path;
+    gaiaDxfParserPtr batch;	/* a batch waiting to be stored */
+    int batch_ok;
+    int finished;
+    int reported;
+    int ok;
+};
+
+struct dxf_load_pipeline
+{
+/* state shared by the writer and the parsing workers */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    sqlite3 *handle;
+    const struct dxf_dir_options *options;
+    struct dxf_load_file *files;
+    int n_files;
+    int next_file;		/* the next file to be claimed by a worker */
+    int abort;
+};
+
+struct dxf_load_worker
+{
+/* a parsing worker owning a private connection cache */
+    struct dxf_load_pipeline *pipeline;
+    void *cache;
+    int file_no;		/* the file currently streamed */
+    pthread_t thread;
+};
+
+static int
+dxf_load_threads (int files)
+{
+/* how many parsing workers should be started */
+    int threads;
+    /* the calling thread is busy storing Geometries */
+    threads =
+	splite_env_threads ("SPATIALITE_DXF_THREADS",
+			    splite_cpu_cores () - 1, DXF_LOAD_MAX_THREADS);
+    if (threads > files)
+	threads = files;
+    return threads;
+}
+
+static int
+dxf_load_handoff (void *ctx, gaiaDxfParserPtr dxf)
+{
+/*
+/ a worker has parsed a whole batch: waiting until the writer has
+/ stored it, so that each worker never holds more than a single batch
+*/
+    struct dxf_load_worker *worker = (struct dxf_load_worker *) ctx;
+    struct dxf_load_pipeline *pipe = worker->pipeline;
+    struct dxf_load_file *file = pipe->files + worker->file_no;
+    int ret;
+    pthread_mutex_lock (&(pipe->mutex));
+    file->batch = dxf;
+    pthread_cond_broadcast (&(pipe->cond));
+    while (file->batch != NULL && !(pipe->abort))
+	pthread_cond_wait (&(pipe->cond), &(pipe->mutex));
+    ret = (file->batch == NULL) ? file->batch_ok : 0;
+    file->batch = NULL;
+    pthread_mutex_unlock (&(pipe->mutex));
+    return ret;
+}
+
+static void *
+dxf_load_worker_main (void *arg)
+{
+/* streaming DXF files until the whole list has been claimed */
+    struct dxf_load_worker *worker = (struct dxf_load_worker *) arg;
+    struct dxf_load_pipeline *pipe = worker->pipeline;
+    const struct dxf_dir_options *options = pipe->options;
+    struct dxf_load_file *file;
+    gaiaDxfParserPtr dxf;
+    int ok;
+    while (1)
+      {
+	  pthread_mutex_lock (&(pipe->mutex));
+	  if (pipe->abort || pipe->next_file >= pipe->n_files)
+	    {
+		pthread_mutex_unlock (&(pipe->mutex));
+		break;
+	    }
+	  worker->file_no = pipe->next_file++;
+	  pthread_mutex_unlock (&(pipe->mutex));
+
+	  file = pipe->files + worker->file_no;
+	  ok = 0;
+	  dxf =
+	      gaiaCreateDxfParser (options->srid, options->force_dims,
+				   options->prefix, options->selected_layer,
+				   options->special_rings);
+	  if (dxf != NULL)
+	    {
+		ok = load_from_dxf_file_ex (worker->cache, pipe->handle, dxf,
+					    file->path, options->mode,
+					    options->append, dxf_load_handoff,
+					    worker);
+		gaiaDestroyDxfParser (dxf);
+	    }
+
+	  pthread_mutex_lock (&(pipe->mutex));
+	  file->ok = ok;
+	  file->finished = 1;
+	  pthread_cond_broadcast (&(pipe->cond));
+	  pthread_mutex_unlock (&(pipe->mutex));
+      }
+    return NULL;
+}
+
+static int
+dxf_load_next_event (struct dxf_load_pipeline *pipe, int ordered,
+		     int first_unreported)
+{
+/*
+/ searching a file having a batch to be stored or just finished
+/ (ordered: only the first file not yet reported is considered)
+/ must be called while holding the mutex
+*/
+    int i;
+    int last = ordered ? first_unreported + 1 : pipe->next_file;
+    struct dxf_load_file *file;
+    for (i = first_unreported; i < last && i < pipe->n_files; i++)
+      {
+	  file = pipe->files + i;
+	  if (file->batch != NULL || (file->finished && !(file->reported)))
+	      return i;
+      }
+    return -1;
+}
+
+static int
+dxf_load_parallel (sqlite3 * handle, struct dxf_dir_list *list,
+		   const struct dxf_dir_options *options, int ordered)
+{
+/*
+/ importing all DXF files from the list: worker threads stream the files
+/ exactly as gaiaLoadFromDxfFile() does, while the calling thread stores
+/ every batch into the DB, either in list order or in the order the
+/ batches become ready
+/
+/ returns the number of files successfully loaded; -1 means that no
+/ worker could be started, and the caller is expected to load the
+/ DXF files serially
+*/
+    struct dxf_load_pipeline pipe;
+    struct dxf_load_worker *workers;
+    struct dxf_load_worker *worker;
+    struct dxf_load_file *file;
+    gaiaDxfParserPtr batch;
+    int threads;
+    int started = 0;
+    int first_unreported = 0;
+    int reported = 0;
+    int file_no;
+    int i;
+    int ret;
+    int cnt = 0;
+
+    threads = dxf_load_threads (list->count);
+    if (threads < 1)
+	return -1;
+    pipe.handle = handle;
+    pipe.options = options;
+    pipe.n_files = list->count;
+    pipe.files = malloc (sizeof (struct dxf_load_file) * pipe.n_files);
+    if (pipe.files == NULL)
+	return -1;
+    workers = malloc (sizeof (struct dxf_load_worker) * threads);
+    if (workers == NULL)
+      {
+	  free (pipe.files);
+	  return -1;
+      }
+    for (i = 0; i < pipe.n_files; i++)
+      {
+	  file = pipe.files + i;
+	  file->path = *(list->paths + i);
+	  file->batch = NULL;
+	  file->batch_ok = 0;
+	  file->finished = 0;
+	  file->reported = 0;
+	  file->ok = 0;
+      }
+    pipe.next_file = 0;
+    pipe.abort = 0;
+    pthread_mutex_init (&(pipe.mutex), NULL);
+    pthread_cond_init (&(pipe.cond), NULL);
+
+    for (i = 0; i < threads; i++)
+      {
+	  /* each worker owns a private GEOS context */
+	  worker = workers + started;
+	  worker->pipeline = &pipe;
+	  worker->file_no = -1;
+	  worker->cache = spatialite_alloc_connection ();
+	  if (worker->cache == NULL)
+	      break;
+	  if (pthread_create
+	      (&(worker->thread), NULL, dxf_load_worker_main, worker) != 0)
+	    {
+		spatialite_cleanup_ex (worker->cache);
+		break;
+	    }
+	  started++;
+      }
+    if (started == 0)
+      {
+	  cnt = -1;
+	  goto done;
+      }
+
+    while (reported < pipe.n_files)
+      {
+	  pthread_mutex_lock (&(pipe.mutex));
+	  while ((file_no =
+		  dxf_load_next_event (&pipe, ordered, first_unreported)) < 0)
+	      pthread_cond_wait (&(pipe.cond), &(pipe.mutex));
+	  file = pipe.files + file_no;
+	  batch = file->batch;
+	  pthread_mutex_unlock (&(pipe.mutex));
+	  if (batch != NULL)
+	    {
+		/* storing a batch while its worker is waiting */
+		ret = store_dxf_stream_batch (batch);
+		pthread_mutex_lock (&(pipe.mutex));
+		file->batch_ok = ret;
+		file->batch = NULL;
+		pthread_cond_broadcast (&(pipe.cond));
+		pthread_mutex_unlock (&(pipe.mutex));
+		continue;
+	    }
+	  /* the whole file has been loaded */
+	  report_dxf_dir_file (file->path, file->ok);
+	  if (file->ok)
+	      cnt++;
+	  file->reported = 1;
+	  reported++;
+	  while (first_unreported < pipe.n_files
+		 && pipe.files[first_unreported].reported)
+	      first_unreported++;
+      }
+
+  done:
+    pthread_mutex_lock (&(pipe.mutex));
+    pipe.abort = 1;
+    pthread_cond_broadcast (&(pipe.cond));
+    pthread_mutex_unlock (&(pipe.mutex));
+    for (i = 0; i < started; i++)
+      {
+	  worker = workers + i;
+	  pthread_join (worker->thread, NULL);
+	  spatialite_cleanup_ex (worker->cache);
+      }
+    pthread_cond_destroy (&(pipe.cond));
+    pthread_mutex_destroy (&(pipe.mutex));
+    free (workers);
+    free (pipe.files);
+    return cnt;
+}
+
+#endif /* end DXF_PARALLEL_LOAD */
+
+static int
+load_from_dxf_dir (const void *p_cache, sqlite3 * handle,
+		   const char *dir_path, int srid, int force_dims,
+		   const char *prefix, const char *selected_layer,
+		   int special_rings, int mode, int append, int ordered)
+{
+/* importing all DXF files found within a directory */
+    struct dxf_dir_options options;
+    struct dxf_dir_list list;
+    int cnt = -1;
+    int ret;
+    int i;
+
+    options.srid = srid;
+    options.force_dims = force_dims;
+    options.prefix = prefix;
+    options.selected_layer = selected_layer;
+    options.special_rings = special_rings;
+    options.mode = mode;
+    options.append = append;
+    list.paths = NULL;
+    list.count = 0;
+    list.max = 0;
+    if (!scan_dxf_dir (dir_path, &list))
+	return 0;
+    if (ordered && list.count > 1)
+	qsort (list.paths, list.count, sizeof (char *), cmp_dxf_dir_paths);
+
+#ifdef DXF_PARALLEL_LOAD
+    if (list.count > 1)
+	cnt = dxf_load_parallel (handle, &list, &options, ordered);
+#endif
+    if (cnt < 0)
+      {
+	  /* loading each DXF file in turn */
+	  cnt = 0;
+	  for (i = 0; i < list.count; i++)
+	    {
+		ret =
+		    load_dxf_dir_file (p_cache, handle, *(list.paths + i),
+				       &options);
+		report_dxf_dir_file (*(list.paths + i), ret);
+		if (ret)
+		    cnt++;
+	    }
+      }
+    free_dxf_dir_list (&list);
+    return cnt;
+}
+
+GAIAGEO_DECLARE int
+gaiaLoadFromDxfDir (sqlite3 * handle, const char *dir_path, int srid,
+		    int force_dims, const char *prefix,
+		    const char *selected_layer, int special_rings, int mode,
+		    int append, int ordered)
+{
+    return load_from_dxf_dir (NULL, handle, dir_path, srid, force_dims,
+			      prefix, selected_layer, special_rings, mode,
+			      append, ordered);
+}
+
+GAIAGEO_DECLARE int
+gaiaLoadFromDxfDir_r (const void *p_cache, sqlite3 * handle,
+		      const char *dir_path, int srid, int force_dims,
+		      const char *prefix, const char *selected_layer,
+		      int special_rings, int mode, int append, int ordered)
+{
+    return load_from_dxf_dir (p_cache, handle, dir_path, srid, force_dims,
+			      prefix, selected_layer, special_rings, mode,
+			      append, ordered);
+}
+
+#endif /* GEOS enabled */
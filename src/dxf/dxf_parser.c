@@ -103,6 +103,213 @@ typedef struct dxf_rings_collection
 } dxfRingsCollection;
 typedef dxfRingsCollection *dxfRingsCollectionPtr;
 
+/* initial number of buckets of an Hash Index */
+#define DXF_HASH_BUCKETS	256
+
+/* size of the input buffer used by the DXF scanner */
+#define DXF_READ_BUFFER	65536
+
+typedef struct dxf_hash_item
+{
+/* an item of an Hash Index [Layer or Block] */
+    const char *key1;
+    const char *key2;
+    void *item;
+    struct dxf_hash_item *next;
+} dxfHashItem;
+typedef dxfHashItem *dxfHashItemPtr;
+
+typedef struct dxf_hash_index
+{
+/* an Hash Index supporting fast lookups by name */
+    unsigned int size;
+    unsigned int count;
+    dxfHashItemPtr *buckets;
+} dxfHashIndex;
+typedef dxfHashIndex *dxfHashIndexPtr;
+
+static unsigned int
+dxf_hash_key (const char *key1, const char *key2)
+{
+/* computing the hash value (FNV-1a) for a Layer name or Block Id */
+    unsigned int hash = 2166136261u;
+    const unsigned char *p = (const unsigned char *) key1;
+    while (*p != '\0')
+      {
+	  hash ^= *p++;
+	  hash *= 16777619u;
+      }
+    if (key2 == NULL)
+	return hash;
+    hash ^= 0xff;		/* separator: no valid UTF-8 byte */
+    hash *= 16777619u;
+    p = (const unsigned char *) key2;
+    while (*p != '\0')
+      {
+	  hash ^= *p++;
+	  hash *= 16777619u;
+      }
+    return hash;
+}
+
+static dxfHashIndexPtr
+alloc_dxf_hash_index (unsigned int size)
+{
+/* allocating an empty Hash Index */
+    dxfHashIndexPtr idx = malloc (sizeof (dxfHashIndex));
+    if (idx == NULL)
+	return NULL;
+    idx->size = size;
+    idx->count = 0;
+    idx->buckets = calloc (size, sizeof (dxfHashItemPtr));
+    if (idx->buckets == NULL)
+      {
+	  free (idx);
+	  return NULL;
+      }
+    return idx;
+}
+
+static void
+disable_dxf_hash_index (dxfHashIndexPtr idx)
+{
+/*
+/ an Hash Index lacking some item is useless: all items are released
+/ and any further lookup will then fall back to a linear scan
+*/
+    unsigned int i;
+    dxfHashItemPtr item;
+    dxfHashItemPtr n_item;
+    if (idx == NULL || idx->buckets == NULL)
+	return;
+    for (i = 0; i < idx->size; i++)
+      {
+	  item = *(idx->buckets + i);
+	  while (item != NULL)
+	    {
+		n_item = item->next;
+		free (item);
+		item = n_item;
+	    }
+      }
+    free (idx->buckets);
+    idx->buckets = NULL;
+    idx->size = 0;
+    idx->count = 0;
+}
+
+static int
+is_usable_dxf_hash_index (dxfHashIndexPtr idx)
+{
+/* checking if an Hash Index can be used for lookups */
+    if (idx == NULL)
+	return 0;
+    if (idx->buckets == NULL)
+	return 0;
+    return 1;
+}
+
+static void
+destroy_dxf_hash_index (dxfHashIndexPtr idx)
+{
+/* memory cleanup - destroying an Hash Index */
+    if (idx == NULL)
+	return;
+    disable_dxf_hash_index (idx);
+    free (idx);
+}
+
+static int
+match_dxf_hash_item (dxfHashItemPtr item, const char *key1, const char *key2)
+{
+/* checking if an Hash Item matches the given keys */
+    if (strcmp (item->key1, key1) != 0)
+	return 0;
+    if (key2 == NULL && item->key2 == NULL)
+	return 1;
+    if (key2 == NULL || item->key2 == NULL)
+	return 0;
+    if (strcmp (item->key2, key2) != 0)
+	return 0;
+    return 1;
+}
+
+static void *
+find_dxf_hash_item (dxfHashIndexPtr idx, const char *key1, const char *key2)
+{
+/* attempting to find an item by its keys */
+    dxfHashItemPtr item;
+    if (!is_usable_dxf_hash_index (idx))
+	return NULL;
+    item = *(idx->buckets + (dxf_hash_key (key1, key2) % idx->size));
+    while (item != NULL)
+      {
+	  if (match_dxf_hash_item (item, key1, key2))
+	      return item->item;
+	  item = item->next;
+      }
+    return NULL;
+}
+
+static void
+grow_dxf_hash_index (dxfHashIndexPtr idx)
+{
+/* doubling the number of buckets of an Hash Index */
+    unsigned int i;
+    unsigned int size = idx->size * 2;
+    dxfHashItemPtr item;
+    dxfHashItemPtr n_item;
+    dxfHashItemPtr *buckets = calloc (size, sizeof (dxfHashItemPtr));
+    if (buckets == NULL)
+	return;
+    for (i = 0; i < idx->size; i++)
+      {
+	  item = *(idx->buckets + i);
+	  while (item != NULL)
+	    {
+		unsigned int pos =
+		    dxf_hash_key (item->key1, item->key2) % size;
+		n_item = item->next;
+		item->next = *(buckets + pos);
+		*(buckets + pos) = item;
+		item = n_item;
+	    }
+      }
+    free (idx->buckets);
+    idx->buckets = buckets;
+    idx->size = size;
+}
+
+static int
+insert_dxf_hash_item (dxfHashIndexPtr idx, const char *key1,
+		      const char *key2, void *value)
+{
+/*
+/ inserting an item into an Hash Index; duplicate keys are ignored,
+/ so that lookups always return the first item (as a linear scan would)
+/ - returns 0 if the Hash Index is unusable or out of memory
+*/
+    unsigned int pos;
+    dxfHashItemPtr item;
+    if (!is_usable_dxf_hash_index (idx))
+	return 0;
+    if (find_dxf_hash_item (idx, key1, key2) != NULL)
+	return 1;
+    if (idx->count >= idx->size)
+	grow_dxf_hash_index (idx);
+    pos = dxf_hash_key (key1, key2) % idx->size;
+    item = malloc (sizeof (dxfHashItem));
+    if (item == NULL)
+	return 0;
+    item->key1 = key1;
+    item->key2 = key2;
+    item->item = value;
+    item->next = *(idx->buckets + pos);
+    *(idx->buckets + pos) = item;
+    idx->count += 1;
+    return 1;
+}
+
 static gaiaDxfHatchSegmPtr
 alloc_dxf_hatch_segm (double x0, double y0, double x1, double y1)
 {
@@ -698,26 +905,49 @@ linked_rings (const void *p_cache, gaiaDxfPolylinePtr line)
     line->is_closed = 1;
 }
 
-static void
-insert_dxf_hatch (gaiaDxfParserPtr dxf, const char *layer_name,
-		  gaiaDxfHatchPtr hatch)
+static gaiaDxfLayerPtr
+find_dxf_layer (gaiaDxfParserPtr dxf, const char *layer_name)
 {
-/* inserting a HATCH object into the appropriate Layer */
-    gaiaDxfLayerPtr lyr = dxf->first_layer;
+/* attempting to find a Layer object by its name */
+    gaiaDxfLayerPtr lyr;
+    if (is_usable_dxf_hash_index (dxf->layers_index))
+	return find_dxf_hash_item (dxf->layers_index, layer_name, NULL);
+/* no Hash Index: linear scan */
+    lyr = dxf->first_layer;
     while (lyr != NULL)
       {
 	  if (strcmp (lyr->layer_name, layer_name) == 0)
-	    {
-		/* found the matching Layer */
-		if (lyr->first_hatch == NULL)
-		    lyr->first_hatch = hatch;
-		if (lyr->last_hatch != NULL)
-		    lyr->last_hatch->next = hatch;
-		lyr->last_hatch = hatch;
-		return;
-	    }
+	      return lyr;
 	  lyr = lyr->next;
       }
+    return NULL;
+}
+
+static void
+count_dxf_pending (gaiaDxfParserPtr dxf, int weight)
+{
+/* streaming mode: counting the entities still waiting to be flushed */
+    if (dxf->stream != NULL)
+	((gaiaDxfStreamPtr) (dxf->stream))->pending += weight;
+}
+
+static void
+insert_dxf_hatch (gaiaDxfParserPtr dxf, const char *layer_name,
+		  gaiaDxfHatchPtr hatch)
+{
+/* inserting a HATCH object into the appropriate Layer */
+    gaiaDxfLayerPtr lyr = find_dxf_layer (dxf, layer_name);
+    if (lyr != NULL)
+      {
+	  /* found the matching Layer */
+	  if (lyr->first_hatch == NULL)
+	      lyr->first_hatch = hatch;
+	  if (lyr->last_hatch != NULL)
+	      lyr->last_hatch->next = hatch;
+	  lyr->last_hatch = hatch;
+	  count_dxf_pending (dxf, 1);
+	  return;
+      }
     destroy_dxf_hatch (hatch);
 }
 
@@ -825,34 +1055,31 @@ insert_dxf_text (gaiaDxfParserPtr dxf, const char *layer_name,
 		 gaiaDxfTextPtr txt)
 {
 /* inserting a TEXT object into the appropriate Layer */
-    gaiaDxfLayerPtr lyr = dxf->first_layer;
-    while (lyr != NULL)
-      {
-	  if (strcmp (lyr->layer_name, layer_name) == 0)
+    gaiaDxfLayerPtr lyr = find_dxf_layer (dxf, layer_name);
+    if (lyr != NULL)
+      {
+	  /* found the matching Layer */
+	  if (lyr->first_text == NULL)
+	      lyr->first_text = txt;
+	  if (lyr->last_text != NULL)
+	      lyr->last_text->next = txt;
+	  lyr->last_text = txt;
+	  if (dxf->force_dims == GAIA_DXF_FORCE_2D
+	      || dxf->force_dims == GAIA_DXF_FORCE_3D)
+	      ;
+	  else
 	    {
-		/* found the matching Layer */
-		if (lyr->first_text == NULL)
-		    lyr->first_text = txt;
-		if (lyr->last_text != NULL)
-		    lyr->last_text->next = txt;
-		lyr->last_text = txt;
-		if (dxf->force_dims == GAIA_DXF_FORCE_2D
-		    || dxf->force_dims == GAIA_DXF_FORCE_3D)
-		    ;
-		else
-		  {
-		      if (is_3d_text (txt))
-			  lyr->is3Dtext = 1;
-		  }
-		txt->first = dxf->first_ext;
-		txt->last = dxf->last_ext;
-		dxf->first_ext = NULL;
-		dxf->last_ext = NULL;
-		if (txt->first != NULL)
-		    lyr->hasExtraText = 1;
-		return;
+		if (is_3d_text (txt))
+		    lyr->is3Dtext = 1;
 	    }
-	  lyr = lyr->next;
+	  txt->first = dxf->first_ext;
+	  txt->last = dxf->last_ext;
+	  dxf->first_ext = NULL;
+	  dxf->last_ext = NULL;
+	  if (txt->first != NULL)
+	      lyr->hasExtraText = 1;
+	  count_dxf_pending (dxf, 1);
+	  return;
       }
     destroy_dxf_text (txt);
 }
@@ -976,77 +1203,83 @@ static void
 insert_dxf_insert (gaiaDxfParserPtr dxf, const char *layer_name,
 		   gaiaDxfInsertPtr ins)
 {
-/* inserting an INSERT object into the appropriate Layer */
-    gaiaDxfLayerPtr lyr = dxf->first_layer;
-    while (lyr != NULL)
-      {
-	  if (strcmp (lyr->layer_name, layer_name) == 0)
-	    {
-		/* found the matching Layer */
-		ins->first = dxf->first_ext;
-		ins->last = dxf->last_ext;
-		dxf->first_ext = NULL;
-		dxf->last_ext = NULL;
-		if (ins->hasText)
-		  {
-		      /* indirect Text reference */
-		      gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
-		      if (lyr->first_ins_text == NULL)
-			  lyr->first_ins_text = ins2;
-		      if (lyr->last_ins_text != NULL)
-			  lyr->last_ins_text->next = ins2;
-		      lyr->last_ins_text = ins2;
-		      if (ins2->is3Dtext)
-			  lyr->is3DinsText = 1;
-		      if (ins2->first != NULL)
-			  lyr->hasExtraInsText = 1;
-		  }
-		if (ins->hasPoint)
-		  {
-		      /* indirect Point reference */
-		      gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
-		      if (lyr->first_ins_point == NULL)
-			  lyr->first_ins_point = ins2;
-		      if (lyr->last_ins_point != NULL)
-			  lyr->last_ins_point->next = ins2;
-		      lyr->last_ins_point = ins2;
-		      if (ins2->is3Dpoint)
-			  lyr->is3DinsPoint = 1;
-		      if (ins2->first != NULL)
-			  lyr->hasExtraInsPoint = 1;
-		  }
-		if (ins->hasLine)
-		  {
-		      /* indirect Polyline (Linestring) reference */
-		      gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
-		      if (lyr->first_ins_line == NULL)
-			  lyr->first_ins_line = ins2;
-		      if (lyr->last_ins_line != NULL)
-			  lyr->last_ins_line->next = ins2;
-		      lyr->last_ins_line = ins2;
-		      if (ins2->is3Dline)
-			  lyr->is3DinsLine = 1;
-		      if (ins2->first != NULL)
-			  lyr->hasExtraInsLine = 1;
-		  }
-		if (ins->hasPolyg)
-		  {
-		      /* indirect Polyline (Polygon) reference */
-		      gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
-		      if (lyr->first_ins_polyg == NULL)
-			  lyr->first_ins_polyg = ins2;
-		      if (lyr->last_ins_polyg != NULL)
-			  lyr->last_ins_polyg->next = ins2;
-		      lyr->last_ins_polyg = ins2;
-		      if (ins2->is3Dpolyg)
-			  lyr->is3DinsPolyg = 1;
-		      if (ins2->first != NULL)
-			  lyr->hasExtraInsPolyg = 1;
-		  }
-		destroy_dxf_insert (ins);
-		return;
+/*
+/ inserting an INSERT object into the appropriate Layer
+/ a distinct copy is queued for each kind of entity found in the Block,
+/ and each copy will become a row of its own
+*/
+    int weight = 0;
+    gaiaDxfLayerPtr lyr = find_dxf_layer (dxf, layer_name);
+    if (lyr != NULL)
+      {
+	  /* found the matching Layer */
+	  ins->first = dxf->first_ext;
+	  ins->last = dxf->last_ext;
+	  dxf->first_ext = NULL;
+	  dxf->last_ext = NULL;
+	  if (ins->hasText)
+	    {
+		/* indirect Text reference */
+		gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
+		if (lyr->first_ins_text == NULL)
+		    lyr->first_ins_text = ins2;
+		if (lyr->last_ins_text != NULL)
+		    lyr->last_ins_text->next = ins2;
+		lyr->last_ins_text = ins2;
+		if (ins2->is3Dtext)
+		    lyr->is3DinsText = 1;
+		if (ins2->first != NULL)
+		    lyr->hasExtraInsText = 1;
+		weight++;
 	    }
-	  lyr = lyr->next;
+	  if (ins->hasPoint)
+	    {
+		/* indirect Point reference */
+		gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
+		if (lyr->first_ins_point == NULL)
+		    lyr->first_ins_point = ins2;
+		if (lyr->last_ins_point != NULL)
+		    lyr->last_ins_point->next = ins2;
+		lyr->last_ins_point = ins2;
+		if (ins2->is3Dpoint)
+		    lyr->is3DinsPoint = 1;
+		if (ins2->first != NULL)
+		    lyr->hasExtraInsPoint = 1;
+		weight++;
+	    }
+	  if (ins->hasLine)
+	    {
+		/* indirect Polyline (Linestring) reference */
+		gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
+		if (lyr->first_ins_line == NULL)
+		    lyr->first_ins_line = ins2;
+		if (lyr->last_ins_line != NULL)
+		    lyr->last_ins_line->next = ins2;
+		lyr->last_ins_line = ins2;
+		if (ins2->is3Dline)
+		    lyr->is3DinsLine = 1;
+		if (ins2->first != NULL)
+		    lyr->hasExtraInsLine = 1;
+		weight++;
+	    }
+	  if (ins->hasPolyg)
+	    {
+		/* indirect Polyline (Polygon) reference */
+		gaiaDxfInsertPtr ins2 = clone_dxf_insert (ins);
+		if (lyr->first_ins_polyg == NULL)
+		    lyr->first_ins_polyg = ins2;
+		if (lyr->last_ins_polyg != NULL)
+		    lyr->last_ins_polyg->next = ins2;
+		lyr->last_ins_polyg = ins2;
+		if (ins2->is3Dpolyg)
+		    lyr->is3DinsPolyg = 1;
+		if (ins2->first != NULL)
+		    lyr->hasExtraInsPolyg = 1;
+		weight++;
+	    }
+	  destroy_dxf_insert (ins);
+	  count_dxf_pending (dxf, weight);
+	  return;
       }
     destroy_dxf_insert (ins);
 }
@@ -1097,34 +1330,31 @@ insert_dxf_point (gaiaDxfParserPtr dxf, const char *layer_name,
 		  gaiaDxfPointPtr pt)
 {
 /* inserting a POINT object into the appropriate Layer */
-    gaiaDxfLayerPtr lyr = dxf->first_layer;
-    while (lyr != NULL)
-      {
-	  if (strcmp (lyr->layer_name, layer_name) == 0)
+    gaiaDxfLayerPtr lyr = find_dxf_layer (dxf, layer_name);
+    if (lyr != NULL)
+      {
+	  /* found the matching Layer */
+	  if (lyr->first_point == NULL)
+	      lyr->first_point = pt;
+	  if (lyr->last_point != NULL)
+	      lyr->last_point->next = pt;
+	  lyr->last_point = pt;
+	  if (dxf->force_dims == GAIA_DXF_FORCE_2D
+	      || dxf->force_dims == GAIA_DXF_FORCE_3D)
+	      ;
+	  else
 	    {
-		/* found the matching Layer */
-		if (lyr->first_point == NULL)
-		    lyr->first_point = pt;
-		if (lyr->last_point != NULL)
-		    lyr->last_point->next = pt;
-		lyr->last_point = pt;
-		if (dxf->force_dims == GAIA_DXF_FORCE_2D
-		    || dxf->force_dims == GAIA_DXF_FORCE_3D)
-		    ;
-		else
-		  {
-		      if (is_3d_point (pt))
-			  lyr->is3Dpoint = 1;
-		  }
-		pt->first = dxf->first_ext;
-		pt->last = dxf->last_ext;
-		dxf->first_ext = NULL;
-		dxf->last_ext = NULL;
-		if (pt->first != NULL)
-		    lyr->hasExtraPoint = 1;
-		return;
+		if (is_3d_point (pt))
+		    lyr->is3Dpoint = 1;
 	    }
-	  lyr = lyr->next;
+	  pt->first = dxf->first_ext;
+	  pt->last = dxf->last_ext;
+	  dxf->first_ext = NULL;
+	  dxf->last_ext = NULL;
+	  if (pt->first != NULL)
+	      lyr->hasExtraPoint = 1;
+	  count_dxf_pending (dxf, 1);
+	  return;
       }
     destroy_dxf_point (pt);
 }
@@ -1461,61 +1691,58 @@ insert_dxf_polyline (const void *p_cache, gaiaDxfParserPtr dxf,
 		     const char *layer_name, gaiaDxfPolylinePtr ln)
 {
 /* inserting a POLYLINE object into the appropriate Layer */
-    gaiaDxfLayerPtr lyr = dxf->first_layer;
-    while (lyr != NULL)
-      {
-	  if (strcmp (lyr->layer_name, layer_name) == 0)
-	    {
-		/* found the matching Layer */
-		if (dxf->linked_rings)
-		    linked_rings (p_cache, ln);
-		if (dxf->unlinked_rings)
-		    unlinked_rings (p_cache, ln);
-		if (ln->is_closed)
+    gaiaDxfLayerPtr lyr = find_dxf_layer (dxf, layer_name);
+    if (lyr != NULL)
+      {
+	  /* found the matching Layer */
+	  if (dxf->linked_rings)
+	      linked_rings (p_cache, ln);
+	  if (dxf->unlinked_rings)
+	      unlinked_rings (p_cache, ln);
+	  if (ln->is_closed)
+	    {
+		/* it's a Ring */
+		if (lyr->first_polyg == NULL)
+		    lyr->first_polyg = ln;
+		if (lyr->last_polyg != NULL)
+		    lyr->last_polyg->next = ln;
+		lyr->last_polyg = ln;
+		if (dxf->force_dims == GAIA_DXF_FORCE_2D
+		    || dxf->force_dims == GAIA_DXF_FORCE_3D)
+		    ;
+		else
 		  {
-		      /* it's a Ring */
-		      if (lyr->first_polyg == NULL)
-			  lyr->first_polyg = ln;
-		      if (lyr->last_polyg != NULL)
-			  lyr->last_polyg->next = ln;
-		      lyr->last_polyg = ln;
-		      if (dxf->force_dims == GAIA_DXF_FORCE_2D
-			  || dxf->force_dims == GAIA_DXF_FORCE_3D)
-			  ;
-		      else
-			{
-			    if (is_3d_line (ln))
-				lyr->is3Dpolyg = 1;
-			}
+		      if (is_3d_line (ln))
+			  lyr->is3Dpolyg = 1;
 		  }
+	    }
+	  else
+	    {
+		/* it's a Linestring */
+		if (lyr->first_line == NULL)
+		    lyr->first_line = ln;
+		if (lyr->last_line != NULL)
+		    lyr->last_line->next = ln;
+		lyr->last_line = ln;
+		if (dxf->force_dims == GAIA_DXF_FORCE_2D
+		    || dxf->force_dims == GAIA_DXF_FORCE_3D)
+		    ;
 		else
 		  {
-		      /* it's a Linestring */
-		      if (lyr->first_line == NULL)
-			  lyr->first_line = ln;
-		      if (lyr->last_line != NULL)
-			  lyr->last_line->next = ln;
-		      lyr->last_line = ln;
-		      if (dxf->force_dims == GAIA_DXF_FORCE_2D
-			  || dxf->force_dims == GAIA_DXF_FORCE_3D)
-			  ;
-		      else
-			{
-			    if (is_3d_line (ln))
-				lyr->is3Dline = 1;
-			}
+		      if (is_3d_line (ln))
+			  lyr->is3Dline = 1;
 		  }
-		ln->first = dxf->first_ext;
-		ln->last = dxf->last_ext;
-		dxf->first_ext = NULL;
-		dxf->last_ext = NULL;
-		if (ln->is_closed && ln->first != NULL)
-		    lyr->hasExtraPolyg = 1;
-		if (ln->is_closed == 0 && ln->first != NULL)
-		    lyr->hasExtraLine = 1;
-		return;
 	    }
-	  lyr = lyr->next;
+	  ln->first = dxf->first_ext;
+	  ln->last = dxf->last_ext;
+	  dxf->first_ext = NULL;
+	  dxf->last_ext = NULL;
+	  if (ln->is_closed && ln->first != NULL)
+	      lyr->hasExtraPolyg = 1;
+	  if (ln->is_closed == 0 && ln->first != NULL)
+	      lyr->hasExtraLine = 1;
+	  count_dxf_pending (dxf, 1 + ln->points);
+	  return;
       }
     destroy_dxf_polyline (ln);
 }
@@ -1706,6 +1933,11 @@ insert_dxf_block (gaiaDxfParserPtr dxf)
     if (dxf->last_block != NULL)
 	dxf->last_block->next = blk;
     dxf->last_block = blk;
+    if (dxf->blocks_index == NULL && dxf->first_block == blk)
+	dxf->blocks_index = alloc_dxf_hash_index (DXF_HASH_BUCKETS);
+    if (!insert_dxf_hash_item
+	(dxf->blocks_index, blk->layer_name, blk->block_id, blk))
+	disable_dxf_hash_index (dxf->blocks_index);
 }
 
 static gaiaDxfLayerPtr
@@ -1771,10 +2003,10 @@ alloc_dxf_layer (const char *name, int force_dims)
     return lyr;
 }
 
-static void
-destroy_dxf_layer (gaiaDxfLayerPtr lyr)
+DXF_PRIVATE void
+reset_dxf_layer_entities (gaiaDxfLayerPtr lyr)
 {
-/* memory cleanup - destroying a DXF Layer object */
+/* memory cleanup - destroying all entities of a DXF Layer object */
     gaiaDxfTextPtr txt;
     gaiaDxfTextPtr n_txt;
     gaiaDxfPointPtr pt;
@@ -1857,6 +2089,35 @@ destroy_dxf_layer (gaiaDxfLayerPtr lyr)
 	  destroy_dxf_insert (ins);
 	  ins = n_ins;
       }
+    lyr->first_text = NULL;
+    lyr->last_text = NULL;
+    lyr->first_point = NULL;
+    lyr->last_point = NULL;
+    lyr->first_line = NULL;
+    lyr->last_line = NULL;
+    lyr->first_polyg = NULL;
+    lyr->last_polyg = NULL;
+    lyr->first_hatch = NULL;
+    lyr->last_hatch = NULL;
+    lyr->first_ins_text = NULL;
+    lyr->last_ins_text = NULL;
+    lyr->first_ins_point = NULL;
+    lyr->last_ins_point = NULL;
+    lyr->first_ins_line = NULL;
+    lyr->last_ins_line = NULL;
+    lyr->first_ins_polyg = NULL;
+    lyr->last_ins_polyg = NULL;
+    lyr->first_ins_hatch = NULL;
+    lyr->last_ins_hatch = NULL;
+}
+
+static void
+destroy_dxf_layer (gaiaDxfLayerPtr lyr)
+{
+/* memory cleanup - destroying a DXF Layer object */
+    if (lyr == NULL)
+	return;
+    reset_dxf_layer_entities (lyr);
     if (lyr->layer_name != NULL)
 	free (lyr->layer_name);
     free (lyr);
@@ -1871,6 +2132,10 @@ insert_dxf_layer (gaiaDxfParserPtr dxf, gaiaDxfLayerPtr lyr)
     if (dxf->last_layer != NULL)
 	dxf->last_layer->next = lyr;
     dxf->last_layer = lyr;
+    if (dxf->layers_index == NULL && dxf->first_layer == lyr)
+	dxf->layers_index = alloc_dxf_hash_index (DXF_HASH_BUCKETS);
+    if (!insert_dxf_hash_item (dxf->layers_index, lyr->layer_name, NULL, lyr))
+	disable_dxf_hash_index (dxf->layers_index);
 }
 
 static void
@@ -1888,19 +2153,9 @@ force_missing_layer (gaiaDxfParserPtr dxf)
       }
     if (ok_layer)
       {
-	  int already_defined = 0;
-	  gaiaDxfLayerPtr lyr = dxf->first_layer;
-	  while (lyr != NULL)
-	    {
-		if (strcmp (lyr->layer_name, dxf->curr_layer_name) == 0)
-		  {
-		      already_defined = 1;
-		      break;
-		  }
-		lyr = lyr->next;
-	    }
-	  if (already_defined)
-	      return;
+	  gaiaDxfLayerPtr lyr = find_dxf_layer (dxf, dxf->curr_layer_name);
+	  if (lyr != NULL)
+	      return;		/* already defined */
 	  lyr = alloc_dxf_layer (dxf->curr_layer_name, dxf->force_dims);
 	  insert_dxf_layer (dxf, lyr);
       }
@@ -2066,18 +2321,18 @@ find_dxf_block (gaiaDxfParserPtr dxf, const char *layer_name,
 		const char *block_id)
 {
 /* attempting to find a Block object by its Id */
-    gaiaDxfBlockPtr blk = dxf->first_block;
+    gaiaDxfBlockPtr blk;
+    if (layer_name == NULL || block_id == NULL)
+	return NULL;
+    if (is_usable_dxf_hash_index (dxf->blocks_index))
+	return find_dxf_hash_item (dxf->blocks_index, layer_name, block_id);
+/* no Hash Index: linear scan */
+    blk = dxf->first_block;
     while (blk != NULL)
       {
-	  if (layer_name != NULL && block_id != NULL)
-	    {
-		if (strcmp (blk->layer_name, layer_name) == 0
-		    && strcmp (blk->block_id, block_id) == 0)
-		  {
-		      /* ok, matching item found */
-		      return blk;
-		  }
-	    }
+	  if (strcmp (blk->layer_name, layer_name) == 0
+	      && blk->block_id != NULL && strcmp (blk->block_id, block_id) == 0)
+	      return blk;
 	  blk = blk->next;
       }
     return NULL;
@@ -2712,6 +2967,11 @@ parse_dxf_line (const void *p_cache, gaiaDxfParserPtr dxf, const char *line)
 			dxf->line_no);
 	  return 0;
       }
+    if (*line < 'A' || *line > 'Z')
+      {
+	  /* can't be a tag: skipping all the tag comparisons */
+	  goto attributes;
+      }
     if (strcmp (line, "SECTION") == 0)
       {
 	  /* start SECTION tag */
@@ -2965,6 +3225,7 @@ parse_dxf_line (const void *p_cache, gaiaDxfParserPtr dxf, const char *line)
 	  dxf->eof = 1;
 	  return 1;
       }
+  attributes:
     if (dxf->is_layer)
       {
 	  /* parsing Table attributes */
@@ -3389,6 +3650,9 @@ gaiaCreateDxfParser (int srid,
     if (special_rings == GAIA_DXF_RING_UNLINKED)
 	dxf->unlinked_rings = 1;
     dxf->undeclared_layers = 1;
+    dxf->stream = NULL;
+    dxf->layers_index = NULL;
+    dxf->blocks_index = NULL;
     return dxf;
 }
 
@@ -3447,6 +3711,8 @@ gaiaDestroyDxfParser (gaiaDxfParserPtr dxf)
     if (dxf->curr_hatch != NULL)
 	destroy_dxf_hatch (dxf->curr_hatch);
     reset_dxf_block (dxf);
+    destroy_dxf_hash_index (dxf->layers_index);
+    destroy_dxf_hash_index (dxf->blocks_index);
     free (dxf);
 }
 
@@ -3494,14 +3760,23 @@ save_dxf_filename (gaiaDxfParserPtr dxf, const char *path)
       }
 }
 
-static int
-gaiaParseDxfFileCommon (const void *p_cache, gaiaDxfParserPtr dxf,
-			const char *path)
+DXF_PRIVATE int
+parse_dxf_file (const void *p_cache, gaiaDxfParserPtr dxf, const char *path)
 {
-/* parsing the whole DXF file */
-    int c;
+/*
+/ parsing the whole DXF file
+/ - the input file is read in large blocks, each line being
+/   then located by memchr() and copied (ignoring any CR)
+*/
     char line[4192];
     char *p = line;
+    char *buf;
+    const char *q;
+    const char *end;
+    const char *nl;
+    const char *stop_ln;
+    size_t rd;
+    size_t len;
     FILE *fl;
 
     if (dxf == NULL)
@@ -3514,17 +3789,49 @@ gaiaParseDxfFileCommon (const void *p_cache, gaiaDxfParserPtr dxf,
     fl = fopen (path, "rb");
     if (fl == NULL)
 	return 0;
+    buf = malloc (DXF_READ_BUFFER);
+    if (buf == NULL)
+      {
+	  fclose (fl);
+	  return 0;
+      }
 
 /* scanning the DXF file */
-    while ((c = getc (fl)) != EOF)
+    while ((rd = fread (buf, 1, DXF_READ_BUFFER, fl)) > 0)
       {
-	  if (c == '\r')
-	    {
-		/* ignoring any CR */
-		continue;
-	    }
-	  if (c == '\n')
+	  q = buf;
+	  end = buf + rd;
+	  while (q < end)
 	    {
+		nl = memchr (q, '\n', end - q);
+		stop_ln = (nl == NULL) ? end : nl;
+		len = stop_ln - q;
+		if (memchr (q, '\r', len) == NULL)
+		  {
+		      /* avoiding a potential buffer overflow [Even Rouault] */
+		      if ((size_t) (p - line) + len >= sizeof (line) - 1)
+			  goto stop;
+		      memcpy (p, q, len);
+		      p += len;
+		  }
+		else
+		  {
+		      /* ignoring any CR */
+		      while (q < stop_ln)
+			{
+			    if (*q != '\r')
+			      {
+				  *p++ = *q;
+				  /* avoiding a potential buffer overflow */
+				  if (p - line == sizeof (line) - 1)
+				      goto stop;
+			      }
+			    q++;
+			}
+		  }
+		if (nl == NULL)
+		    break;	/* the line continues into the next block */
+		q = nl + 1;
 		/* end line found */
 		*p = '\0';
 		if (!parse_dxf_line (p_cache, dxf, line))
@@ -3532,21 +3839,27 @@ gaiaParseDxfFileCommon (const void *p_cache, gaiaDxfParserPtr dxf,
 		if (dxf->eof)
 		  {
 		      /* EOF marker found - quitting */
-		      break;
+		      goto done;
+		  }
+		if (dxf->stream != NULL
+		    && ((gaiaDxfStreamPtr) (dxf->stream))->batch > 0
+		    && ((gaiaDxfStreamPtr) (dxf->stream))->pending >=
+		    ((gaiaDxfStreamPtr) (dxf->stream))->batch)
+		  {
+		      /* streaming mode: flushing the pending entities */
+		      if (!flush_dxf_stream (dxf))
+			  goto stop;
 		  }
 		p = line;
-		continue;
 	    }
-	  *p++ = c;
-	  /* Even Rouault 2013-06-02 - avoiding a potential buffer overflow */
-	  if (p - line == sizeof (line) - 1)
-	      goto stop;
-	  /* END - Even Rouault 2013-06-02 */
       }
 
+  done:
+    free (buf);
     fclose (fl);
     return 1;
   stop:
+    free (buf);
     fclose (fl);
     return 0;
 }
@@ -3554,13 +3867,13 @@ gaiaParseDxfFileCommon (const void *p_cache, gaiaDxfParserPtr dxf,
 GAIAGEO_DECLARE int
 gaiaParseDxfFile (gaiaDxfParserPtr dxf, const char *path)
 {
-    return gaiaParseDxfFileCommon (NULL, dxf, path);
+    return parse_dxf_file (NULL, dxf, path);
 }
 
 GAIAGEO_DECLARE int
 gaiaParseDxfFile_r (const void *p_cache, gaiaDxfParserPtr dxf, const char *path)
 {
-    return gaiaParseDxfFileCommon (p_cache, dxf, path);
+    return parse_dxf_file (p_cache, dxf, path);
 }
 
 #endif /* GEOS enabled */
@@ -100,6 +100,46 @@ extern "C"
     } gaiaDxfExport;
     typedef gaiaDxfExport *gaiaDxfExportPtr;
 
+/* pending entities (+ vertices) triggering a flush in streaming mode */
+#define DXF_STREAM_BATCH	65536
+
+/* DXF files up to this size (about a single batch) are parsed just once */
+#define DXF_STREAM_SINGLE_PASS	(DXF_STREAM_BATCH * 16)
+
+    typedef struct dxf_stream_table
+    {
+	char *name;
+	struct dxf_stream_table *next;
+    } gaiaDxfStreamTable;
+    typedef gaiaDxfStreamTable *gaiaDxfStreamTablePtr;
+
+    typedef struct dxf_stream
+    {
+	sqlite3 *handle;	/* NULL while collecting the Layer infos */
+	int mode;
+	int append;
+	int flushes;
+	int pending;
+	int batch;		/* pending entities triggering a flush, 0 = never */
+	gaiaDxfParserPtr infos;	/* the Layer infos collected by the first pass */
+	gaiaDxfStreamTablePtr first_table;	/* tables already stored into */
+	/* storing each batch on behalf of another thread */
+	int (*handoff) (void *ctx, gaiaDxfParserPtr dxf);
+	void *handoff_ctx;
+    } gaiaDxfStream;
+    typedef gaiaDxfStream *gaiaDxfStreamPtr;
+
+    DXF_PRIVATE int
+	parse_dxf_file (const void *p_cache, gaiaDxfParserPtr dxf,
+			const char *path);
+
+    DXF_PRIVATE void reset_dxf_layer_entities (gaiaDxfLayerPtr lyr);
+
+    DXF_PRIVATE int flush_dxf_stream (gaiaDxfParserPtr dxf);
+
+    DXF_PRIVATE int dxf_append_table (gaiaDxfParserPtr dxf, const char *name,
+				      int append);
+
     DXF_PRIVATE int
 	create_text_stmt (sqlite3 * handle, const char *name,
 			  sqlite3_stmt ** xstmt);
@@ -63,6 +63,8 @@ the terms of any one of the MPL, the GPL or the LGPL.
 
 #ifdef _WIN32
 #define strcasecmp	_stricmp
+#else
+#include <unistd.h>
 #endif /* not WIN32 */
 
 /* 64 bit integer: portable format for printf() */
@@ -1435,3 +1437,60 @@ gaiaFileExtFromPath (const char *path)
     strcpy (name, path + pos + 1);
     return name;
 }
+
+SPATIALITE_PRIVATE int
+splite_cpu_cores (void)
+{
+/* how many CPU cores are currently available */
+#ifdef _WIN32
+    return 1;
+#else
+    long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+	return 1;
+    if (cpus > 1024)
+	return 1024;
+    return (int) cpus;
+#endif
+}
+
+SPATIALITE_PRIVATE int
+splite_env_threads (const char *name, int automatic, int max_threads)
+{
+/*
+/ how many worker threads should be started: the environment variable
+/ NAME (if set) overrides the AUTOMATIC count, 0 meaning no workers at all
+*/
+    const char *value = getenv (name);
+    int threads = automatic;
+    if (value != NULL)
+	threads = atoi (value);
+    if (threads > max_threads)
+	threads = max_threads;
+    if (threads < 0)
+	threads = 0;
+    return threads;
+}
+
+SPATIALITE_PRIVATE int
+splite_env_switch (const char *name, int automatic)
+{
+/*
+/ checking an on/off environment variable: 0 (or any negative value)
+/ turns the feature off, any other value turns it on
+*/
+    const char *value = getenv (name);
+    if (value == NULL)
+	return automatic;
+    return (atoi (value) > 0) ? 1 : 0;
+}
+
+SPATIALITE_PRIVATE int
+splite_relaxed_security (void)
+{
+/* checking if SPATIALITE_SECURITY=relaxed allows accessing the file-system */
+    const char *value = getenv ("SPATIALITE_SECURITY");
+    if (value == NULL)
+	return 0;
+    return (strcasecmp (value, "relaxed") == 0) ? 1 : 0;
+}
@@ -64,7 +64,7 @@ typedef union
     ParseTOKENTYPE yy0;
 } YYMINORTYPE;
 #ifndef YYSTACKDEPTH
-#define YYSTACKDEPTH 1000000
+#define YYSTACKDEPTH 0
 #endif
 #define ParseARG_SDECL  struct kml_data *p_data ;
 #define ParseARG_PDECL , struct kml_data *p_data
@@ -64,7 +64,7 @@ typedef union
     ParseTOKENTYPE yy0;
 } YYMINORTYPE;
 #ifndef YYSTACKDEPTH
-#define YYSTACKDEPTH 1000000
+#define YYSTACKDEPTH 0
 #endif
 #define ParseARG_SDECL  struct geoJson_data *p_data ;
 #define ParseARG_PDECL , struct geoJson_data *p_data
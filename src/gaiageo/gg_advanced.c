@@ -46,6 +46,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <sys/types.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <float.h>
 
@@ -55,193 +56,368 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include "config.h"
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GAIA_SSE2_KERNELS
+#endif
+
 #include <spatialite/sqlite.h>
 
 #include <spatialite/gaiageo.h>
 
-GAIAGEO_DECLARE double
-gaiaMeasureLength (int dims, double *coords, int vert)
+/*
+/ planar measurement kernels
+/
+/ any Coords array (XY, XYZ, XYM or XYZM) always stores X and Y as the
+/ two leading doubles of each vertex, so a single kernel parameterized
+/ by the vertex stride serves all dimension models; the callers always
+/ pass a literal stride (2, 3 or 4) so that the compiler is free to
+/ specialize each kernel for every dimension model.
+/ when SSE2 is available two consecutive segments are processed at once.
+*/
+
+static int
+coords_stride (int dims)
 {
-/* computes the total length */
+/* returns the number of doubles for each vertex */
+    switch (dims)
+      {
+      case GAIA_XY_Z:
+      case GAIA_XY_M:
+	  return 3;
+      case GAIA_XY_Z_M:
+	  return 4;
+      };
+    return 2;
+}
+
+static double
+kernel_length (const double *coords, int vert, int stride)
+{
+/* sum of the segment lengths */
     double lung = 0.0;
-    double xx1;
-    double xx2;
-    double yy1;
-    double yy2;
     double x;
     double y;
-    double z;
-    double m;
-    double dist;
-    int ind;
-    if (vert <= 0)
-	return lung;
-    if (dims == GAIA_XY_Z)
-      {
-	  gaiaGetPointXYZ (coords, 0, &xx1, &yy1, &z);
-      }
-    else if (dims == GAIA_XY_M)
-      {
-	  gaiaGetPointXYM (coords, 0, &xx1, &yy1, &m);
-      }
-    else if (dims == GAIA_XY_Z_M)
-      {
-	  gaiaGetPointXYZM (coords, 0, &xx1, &yy1, &z, &m);
-      }
-    else
+    int iv = 1;
+#ifdef GAIA_SSE2_KERNELS
+    double lanes[2];
+    __m128d acc = _mm_setzero_pd ();
+    __m128d pa = _mm_loadu_pd (coords);
+    for (; iv + 1 < vert; iv += 2)
       {
-	  gaiaGetPoint (coords, 0, &xx1, &yy1);
+	  __m128d pb = _mm_loadu_pd (coords + (iv * stride));
+	  __m128d pc = _mm_loadu_pd (coords + ((iv + 1) * stride));
+	  __m128d d0 = _mm_sub_pd (pb, pa);
+	  __m128d d1 = _mm_sub_pd (pc, pb);
+	  __m128d dx = _mm_unpacklo_pd (d0, d1);
+	  __m128d dy = _mm_unpackhi_pd (d0, d1);
+	  acc =
+	      _mm_add_pd (acc,
+			  _mm_sqrt_pd (_mm_add_pd
+				       (_mm_mul_pd (dx, dx),
+					_mm_mul_pd (dy, dy))));
+	  pa = pc;
       }
-    for (ind = 1; ind < vert; ind++)
+    _mm_storeu_pd (lanes, acc);
+    lung = lanes[0] + lanes[1];
+#endif
+    for (; iv < vert; iv++)
       {
-	  if (dims == GAIA_XY_Z)
-	    {
-		gaiaGetPointXYZ (coords, ind, &xx2, &yy2, &z);
-	    }
-	  else if (dims == GAIA_XY_M)
-	    {
-		gaiaGetPointXYM (coords, ind, &xx2, &yy2, &m);
-	    }
-	  else if (dims == GAIA_XY_Z_M)
-	    {
-		gaiaGetPointXYZM (coords, ind, &xx2, &yy2, &z, &m);
-	    }
-	  else
-	    {
-		gaiaGetPoint (coords, ind, &xx2, &yy2);
-	    }
-	  x = xx1 - xx2;
-	  y = yy1 - yy2;
-	  dist = sqrt ((x * x) + (y * y));
-	  lung += dist;
-	  xx1 = xx2;
-	  yy1 = yy2;
+	  x = coords[(iv - 1) * stride] - coords[iv * stride];
+	  y = coords[(iv - 1) * stride + 1] - coords[iv * stride + 1];
+	  lung += sqrt ((x * x) + (y * y));
       }
     return lung;
 }
 
-GAIAGEO_DECLARE double
-gaiaMeasureArea (gaiaRingPtr ring)
+static double
+kernel_area2 (const double *coords, int vert, int stride)
 {
-/* computes the area */
-    int iv;
-    double xx;
-    double yy;
-    double x;
-    double y;
-    double z;
-    double m;
+/*
+/ twice the signed area (shoelace formula)
+/ all coordinates are shifted so to put the origin on the first vertex;
+/ this leaves the result unchanged but avoids losing precision when
+/ handling huge coordinate values (e.g. UTM)
+*/
     double area = 0.0;
-    if (!ring)
+    double x0;
+    double y0;
+    double xa;
+    double ya;
+    double xb;
+    double yb;
+    int iv = 2;
+    if (vert < 3)
 	return 0.0;
-    if (ring->DimensionModel == GAIA_XY_Z)
+    x0 = coords[0];
+    y0 = coords[1];
+#ifdef GAIA_SSE2_KERNELS
+    {
+	double lanes[2];
+	__m128d org = _mm_loadu_pd (coords);
+	__m128d acc = _mm_setzero_pd ();
+	__m128d pa = _mm_sub_pd (_mm_loadu_pd (coords + stride), org);
+	for (; iv + 1 < vert; iv += 2)
+	  {
+	      __m128d pb = _mm_sub_pd (_mm_loadu_pd (coords + (iv * stride)),
+				       org);
+	      __m128d pc =
+		  _mm_sub_pd (_mm_loadu_pd (coords + ((iv + 1) * stride)),
+			      org);
+	      __m128d x_ab = _mm_unpacklo_pd (pa, pb);
+	      __m128d y_ab = _mm_unpackhi_pd (pa, pb);
+	      __m128d x_bc = _mm_unpacklo_pd (pb, pc);
+	      __m128d y_bc = _mm_unpackhi_pd (pb, pc);
+	      acc =
+		  _mm_add_pd (acc,
+			      _mm_sub_pd (_mm_mul_pd (x_ab, y_bc),
+					  _mm_mul_pd (x_bc, y_ab)));
+	      pa = pc;
+	  }
+	_mm_storeu_pd (lanes, acc);
+	area = lanes[0] + lanes[1];
+    }
+#endif
+    xa = coords[(iv - 1) * stride] - x0;
+    ya = coords[(iv - 1) * stride + 1] - y0;
+    for (; iv < vert; iv++)
       {
-	  gaiaGetPointXYZ (ring->Coords, 0, &xx, &yy, &z);
+	  xb = coords[iv * stride] - x0;
+	  yb = coords[iv * stride + 1] - y0;
+	  area += (xa * yb) - (xb * ya);
+	  xa = xb;
+	  ya = yb;
       }
-    else if (ring->DimensionModel == GAIA_XY_M)
+    return area;
+}
+
+static void
+kernel_centroid (const double *coords, int vert, int stride, double *area2,
+		 double *mx, double *my)
+{
+/*
+/ twice the signed area and the first moments of a ring;
+/ just as kernel_area2() the first vertex is assumed to be the origin
+*/
+    double a = 0.0;
+    double cx = 0.0;
+    double cy = 0.0;
+    double x0;
+    double y0;
+    double xa;
+    double ya;
+    double xb;
+    double yb;
+    double term;
+    int iv = 2;
+    *area2 = 0.0;
+    *mx = 0.0;
+    *my = 0.0;
+    if (vert < 3)
+	return;
+    x0 = coords[0];
+    y0 = coords[1];
+#ifdef GAIA_SSE2_KERNELS
+    {
+	double lanes[2];
+	__m128d org = _mm_loadu_pd (coords);
+	__m128d acc_a = _mm_setzero_pd ();
+	__m128d acc_x = _mm_setzero_pd ();
+	__m128d acc_y = _mm_setzero_pd ();
+	__m128d pa = _mm_sub_pd (_mm_loadu_pd (coords + stride), org);
+	for (; iv + 1 < vert; iv += 2)
+	  {
+	      __m128d pb = _mm_sub_pd (_mm_loadu_pd (coords + (iv * stride)),
+				       org);
+	      __m128d pc =
+		  _mm_sub_pd (_mm_loadu_pd (coords + ((iv + 1) * stride)),
+			      org);
+	      __m128d x_ab = _mm_unpacklo_pd (pa, pb);
+	      __m128d y_ab = _mm_unpackhi_pd (pa, pb);
+	      __m128d x_bc = _mm_unpacklo_pd (pb, pc);
+	      __m128d y_bc = _mm_unpackhi_pd (pb, pc);
+	      __m128d t = _mm_sub_pd (_mm_mul_pd (x_ab, y_bc),
+				      _mm_mul_pd (x_bc, y_ab));
+	      acc_a = _mm_add_pd (acc_a, t);
+	      acc_x =
+		  _mm_add_pd (acc_x, _mm_mul_pd (_mm_add_pd (x_ab, x_bc), t));
+	      acc_y =
+		  _mm_add_pd (acc_y, _mm_mul_pd (_mm_add_pd (y_ab, y_bc), t));
+	      pa = pc;
+	  }
+	_mm_storeu_pd (lanes, acc_a);
+	a = lanes[0] + lanes[1];
+	_mm_storeu_pd (lanes, acc_x);
+	cx = lanes[0] + lanes[1];
+	_mm_storeu_pd (lanes, acc_y);
+	cy = lanes[0] + lanes[1];
+    }
+#endif
+    xa = coords[(iv - 1) * stride] - x0;
+    ya = coords[(iv - 1) * stride + 1] - y0;
+    for (; iv < vert; iv++)
       {
-	  gaiaGetPointXYM (ring->Coords, 0, &xx, &yy, &m);
+	  xb = coords[iv * stride] - x0;
+	  yb = coords[iv * stride + 1] - y0;
+	  term = (xa * yb) - (xb * ya);
+	  a += term;
+	  cx += (xa + xb) * term;
+	  cy += (ya + yb) * term;
+	  xa = xb;
+	  ya = yb;
       }
-    else if (ring->DimensionModel == GAIA_XY_Z_M)
+    *area2 = a;
+    *mx = cx;
+    *my = cy;
+}
+
+static int
+kernel_point_in_ring (const double *coords, int cnt, int stride, double pt_x,
+		      double pt_y)
+{
+/*
+/ crossing-number test; the last vertex is ignored because surely
+/ identical to the first one
+/
+/ The definitive reference is "Point in Polyon Strategies" by
+/  Eric Haines [Gems IV]  pp. 24-46.
+/  The code in the Sedgewick book Algorithms (2nd Edition, p.354) is
+/  incorrect.
+*/
+    int isInternal = 0;
+    int i = 0;
+    double xi;
+    double yi;
+    double xj = coords[(cnt - 1) * stride];
+    double yj = coords[(cnt - 1) * stride + 1];
+#ifdef GAIA_SSE2_KERNELS
+    {
+	__m128d px = _mm_set1_pd (pt_x);
+	__m128d py = _mm_set1_pd (pt_y);
+	__m128d pj = _mm_set_pd (yj, xj);
+	int mask;
+	for (; i + 1 < cnt; i += 2)
+	  {
+	      /* testing the (j,i) and (i,i+1) segments at once */
+	      __m128d pa = _mm_loadu_pd (coords + (i * stride));
+	      __m128d pb = _mm_loadu_pd (coords + ((i + 1) * stride));
+	      __m128d vxi = _mm_unpacklo_pd (pa, pb);
+	      __m128d vyi = _mm_unpackhi_pd (pa, pb);
+	      __m128d vxj = _mm_unpacklo_pd (pj, pa);
+	      __m128d vyj = _mm_unpackhi_pd (pj, pa);
+	      __m128d c1 = _mm_and_pd (_mm_cmple_pd (vyi, py),
+				       _mm_cmplt_pd (py, vyj));
+	      __m128d c2 = _mm_and_pd (_mm_cmple_pd (vyj, py),
+				       _mm_cmplt_pd (py, vyi));
+	      __m128d xint =
+		  _mm_add_pd (_mm_div_pd
+			      (_mm_mul_pd
+			       (_mm_sub_pd (vxj, vxi), _mm_sub_pd (py, vyi)),
+			       _mm_sub_pd (vyj, vyi)), vxi);
+	      mask =
+		  _mm_movemask_pd (_mm_and_pd
+				   (_mm_or_pd (c1, c2),
+				    _mm_cmplt_pd (px, xint)));
+	      isInternal ^= (mask & 1) ^ ((mask >> 1) & 1);
+	      pj = pb;
+	  }
+	xj = coords[(i - 1 + cnt) % cnt * stride];
+	yj = coords[(i - 1 + cnt) % cnt * stride + 1];
+    }
+#endif
+    for (; i < cnt; i++)
       {
-	  gaiaGetPointXYZM (ring->Coords, 0, &xx, &yy, &z, &m);
+	  xi = coords[i * stride];
+	  yi = coords[i * stride + 1];
+	  if ((((yi <= pt_y) && (pt_y < yj))
+	       || ((yj <= pt_y) && (pt_y < yi)))
+	      && (pt_x < (xj - xi) * (pt_y - yi) / (yj - yi) + xi))
+	      isInternal = !isInternal;
+	  xj = xi;
+	  yj = yi;
       }
-    else
+    return isInternal;
+}
+
+static double
+measure_length (int dims, const double *coords, int vert)
+{
+/* dispatching the length kernel by dimension model */
+    switch (coords_stride (dims))
       {
-	  gaiaGetPoint (ring->Coords, 0, &xx, &yy);
-      }
-    for (iv = 1; iv < ring->Points; iv++)
+      case 3:
+	  return kernel_length (coords, vert, 3);
+      case 4:
+	  return kernel_length (coords, vert, 4);
+      };
+    return kernel_length (coords, vert, 2);
+}
+
+static double
+measure_area2 (gaiaRingPtr ring)
+{
+/* dispatching the area kernel by dimension model */
+    switch (coords_stride (ring->DimensionModel))
       {
-	  if (ring->DimensionModel == GAIA_XY_Z)
-	    {
-		gaiaGetPointXYZ (ring->Coords, iv, &x, &y, &z);
-	    }
-	  else if (ring->DimensionModel == GAIA_XY_M)
-	    {
-		gaiaGetPointXYM (ring->Coords, iv, &x, &y, &m);
-	    }
-	  else if (ring->DimensionModel == GAIA_XY_Z_M)
-	    {
-		gaiaGetPointXYZM (ring->Coords, iv, &x, &y, &z, &m);
-	    }
-	  else
-	    {
-		gaiaGetPoint (ring->Coords, iv, &x, &y);
-	    }
-	  area += ((xx * y) - (x * yy));
-	  xx = x;
-	  yy = y;
-      }
-    area /= 2.0;
-    return fabs (area);
+      case 3:
+	  return kernel_area2 (ring->Coords, ring->Points, 3);
+      case 4:
+	  return kernel_area2 (ring->Coords, ring->Points, 4);
+      };
+    return kernel_area2 (ring->Coords, ring->Points, 2);
+}
+
+static void
+measure_centroid (gaiaRingPtr ring, double *area2, double *mx, double *my)
+{
+/* dispatching the centroid kernel by dimension model */
+    switch (coords_stride (ring->DimensionModel))
+      {
+      case 3:
+	  kernel_centroid (ring->Coords, ring->Points, 3, area2, mx, my);
+	  return;
+      case 4:
+	  kernel_centroid (ring->Coords, ring->Points, 4, area2, mx, my);
+	  return;
+      };
+    kernel_centroid (ring->Coords, ring->Points, 2, area2, mx, my);
+}
+
+GAIAGEO_DECLARE double
+gaiaMeasureLength (int dims, double *coords, int vert)
+{
+/* computes the total length */
+    if (vert <= 0)
+	return 0.0;
+    return measure_length (dims, coords, vert);
+}
+
+GAIAGEO_DECLARE double
+gaiaMeasureArea (gaiaRingPtr ring)
+{
+/* computes the area */
+    if (!ring)
+	return 0.0;
+    return fabs (measure_area2 (ring) / 2.0);
 }
 
 GAIAGEO_DECLARE void
 gaiaRingCentroid (gaiaRingPtr ring, double *rx, double *ry)
 {
 /* computes the simple ring centroid */
-    double cx = 0.0;
-    double cy = 0.0;
-    double xx;
-    double yy;
-    double x;
-    double y;
-    double z;
-    double m;
-    double coeff;
-    double area;
-    double term;
-    int iv;
+    double area2;
+    double cx;
+    double cy;
     if (!ring)
       {
 	  *rx = -DBL_MAX;
 	  *ry = -DBL_MAX;
 	  return;
       }
-    area = gaiaMeasureArea (ring);
-    coeff = 1.0 / (area * 6.0);
-    if (ring->DimensionModel == GAIA_XY_Z)
-      {
-	  gaiaGetPointXYZ (ring->Coords, 0, &xx, &yy, &z);
-      }
-    else if (ring->DimensionModel == GAIA_XY_M)
-      {
-	  gaiaGetPointXYM (ring->Coords, 0, &xx, &yy, &m);
-      }
-    else if (ring->DimensionModel == GAIA_XY_Z_M)
-      {
-	  gaiaGetPointXYZM (ring->Coords, 0, &xx, &yy, &z, &m);
-      }
-    else
-      {
-	  gaiaGetPoint (ring->Coords, 0, &xx, &yy);
-      }
-    for (iv = 1; iv < ring->Points; iv++)
-      {
-	  if (ring->DimensionModel == GAIA_XY_Z)
-	    {
-		gaiaGetPointXYZ (ring->Coords, iv, &x, &y, &z);
-	    }
-	  else if (ring->DimensionModel == GAIA_XY_M)
-	    {
-		gaiaGetPointXYM (ring->Coords, iv, &x, &y, &m);
-	    }
-	  else if (ring->DimensionModel == GAIA_XY_Z_M)
-	    {
-		gaiaGetPointXYZM (ring->Coords, iv, &x, &y, &z, &m);
-	    }
-	  else
-	    {
-		gaiaGetPoint (ring->Coords, iv, &x, &y);
-	    }
-	  term = (xx * y) - (x * yy);
-	  cx += (xx + x) * term;
-	  cy += (yy + y) * term;
-	  xx = x;
-	  yy = y;
-      }
-    *rx = fabs (cx * coeff);
-    *ry = fabs (cy * coeff);
+    measure_centroid (ring, &area2, &cx, &cy);
+    *rx = ring->Coords[0] + (cx / (area2 * 3.0));
+    *ry = ring->Coords[1] + (cy / (area2 * 3.0));
 }
 
 GAIAGEO_DECLARE void
@@ -305,79 +481,19 @@ GAIAGEO_DECLARE int
 gaiaIsPointOnRingSurface (gaiaRingPtr ring, double pt_x, double pt_y)
 {
 /* tests if a POINT falls inside a RING */
-    int isInternal = 0;
     int cnt;
-    int i;
-    int j;
-    double x;
-    double y;
-    double z;
-    double m;
-    double *vert_x;
-    double *vert_y;
-    double minx = DBL_MAX;
-    double miny = DBL_MAX;
-    double maxx = -DBL_MAX;
-    double maxy = -DBL_MAX;
     cnt = ring->Points;
     cnt--;			/* ignoring last vertex because surely identical to the first one */
     if (cnt < 2)
 	return 0;
-/* allocating and loading an array of vertices */
-    vert_x = malloc (sizeof (double) * (cnt));
-    vert_y = malloc (sizeof (double) * (cnt));
-    for (i = 0; i < cnt; i++)
+    switch (coords_stride (ring->DimensionModel))
       {
-	  if (ring->DimensionModel == GAIA_XY_Z)
-	    {
-		gaiaGetPointXYZ (ring->Coords, i, &x, &y, &z);
-	    }
-	  else if (ring->DimensionModel == GAIA_XY_M)
-	    {
-		gaiaGetPointXYM (ring->Coords, i, &x, &y, &m);
-	    }
-	  else if (ring->DimensionModel == GAIA_XY_Z_M)
-	    {
-		gaiaGetPointXYZM (ring->Coords, i, &x, &y, &z, &m);
-	    }
-	  else
-	    {
-		gaiaGetPoint (ring->Coords, i, &x, &y);
-	    }
-	  vert_x[i] = x;
-	  vert_y[i] = y;
-	  if (x < minx)
-	      minx = x;
-	  if (x > maxx)
-	      maxx = x;
-	  if (y < miny)
-	      miny = y;
-	  if (y > maxy)
-	      maxy = y;
-      }
-    if (pt_x < minx || pt_x > maxx)
-	goto end;		/* outside the bounding box (x axis) */
-    if (pt_y < miny || pt_y > maxy)
-	goto end;		/* outside the bounding box (y axis) */
-    for (i = 0, j = cnt - 1; i < cnt; j = i++)
-      {
-/* The definitive reference is "Point in Polyon Strategies" by
-/  Eric Haines [Gems IV]  pp. 24-46.
-/  The code in the Sedgewick book Algorithms (2nd Edition, p.354) is 
-/  incorrect.
-*/
-	  if ((((vert_y[i] <= pt_y) && (pt_y < vert_y[j]))
-	       || ((vert_y[j] <= pt_y) && (pt_y < vert_y[i])))
-	      && (pt_x <
-		  (vert_x[j] - vert_x[i]) * (pt_y - vert_y[i]) / (vert_y[j] -
-								  vert_y[i]) +
-		  vert_x[i]))
-	      isInternal = !isInternal;
-      }
-  end:
-    free (vert_x);
-    free (vert_y);
-    return isInternal;
+      case 3:
+	  return kernel_point_in_ring (ring->Coords, cnt, 3, pt_x, pt_y);
+      case 4:
+	  return kernel_point_in_ring (ring->Coords, cnt, 4, pt_x, pt_y);
+      };
+    return kernel_point_in_ring (ring->Coords, cnt, 2, pt_x, pt_y);
 }
 
 GAIAGEO_DECLARE double
@@ -1343,6 +1459,259 @@ gaiaIsNotClosedGeomColl_r (const void *cache, gaiaGeomCollPtr geom)
     return 0;
 }
 
+static int
+planar_is_toxic (gaiaGeomCollPtr geom)
+{
+/* same as gaiaIsToxic(), but never setting any GEOS message */
+    int ib;
+    gaiaLinestringPtr line;
+    gaiaPolygonPtr polyg;
+    if (gaiaIsEmpty (geom))
+	return 1;
+    line = geom->FirstLinestring;
+    while (line)
+      {
+	  if (gaiaIsToxicLinestring (line))
+	      return 1;
+	  line = line->Next;
+      }
+    polyg = geom->FirstPolygon;
+    while (polyg)
+      {
+	  if (gaiaIsToxicRing (polyg->Exterior))
+	      return 1;
+	  for (ib = 0; ib < polyg->NumInteriors; ib++)
+	    {
+		if (gaiaIsToxicRing (polyg->Interiors + ib))
+		    return 1;
+	    }
+	  polyg = polyg->Next;
+      }
+    return 0;
+}
+
+GAIAGEO_DECLARE int
+gaiaGeomCollPlanarArea (gaiaGeomCollPtr geom, double *xarea)
+{
+/* computes the total area for this Geometry (native, no GEOS) */
+    int ib;
+    double area = 0.0;
+    gaiaPolygonPtr polyg;
+    if (!geom)
+	return 0;
+    if (planar_is_toxic (geom))
+	return 0;
+    polyg = geom->FirstPolygon;
+    while (polyg)
+      {
+	  area += fabs (measure_area2 (polyg->Exterior));
+	  for (ib = 0; ib < polyg->NumInteriors; ib++)
+	      area -= fabs (measure_area2 (polyg->Interiors + ib));
+	  polyg = polyg->Next;
+      }
+    *xarea = area / 2.0;
+    return 1;
+}
+
+GAIAGEO_DECLARE int
+gaiaGeomCollPlanarLengthOrPerimeter (gaiaGeomCollPtr geom, int perimeter,
+				     double *xlength)
+{
+/* computes the total length or perimeter for this Geometry (native, no GEOS) */
+    int ib;
+    double length = 0.0;
+    gaiaLinestringPtr line;
+    gaiaPolygonPtr polyg;
+    gaiaRingPtr ring;
+    if (!geom)
+	return 0;
+    if (planar_is_toxic (geom))
+	return 0;
+    if (perimeter)
+      {
+	  polyg = geom->FirstPolygon;
+	  while (polyg)
+	    {
+		ring = polyg->Exterior;
+		length +=
+		    measure_length (ring->DimensionModel, ring->Coords,
+				    ring->Points);
+		for (ib = 0; ib < polyg->NumInteriors; ib++)
+		  {
+		      ring = polyg->Interiors + ib;
+		      length +=
+			  measure_length (ring->DimensionModel, ring->Coords,
+					  ring->Points);
+		  }
+		polyg = polyg->Next;
+	    }
+      }
+    else
+      {
+	  line = geom->FirstLinestring;
+	  while (line)
+	    {
+		length +=
+		    measure_length (line->DimensionModel, line->Coords,
+				    line->Points);
+		line = line->Next;
+	    }
+      }
+    *xlength = length;
+    return 1;
+}
+
+struct planar_centroid
+{
+/* helper struct accumulating a Centroid */
+    double base_x;
+    double base_y;
+    double area_sum;
+    double area_x;
+    double area_y;
+    double line_sum;
+    double line_x;
+    double line_y;
+    int pt_count;
+    double pt_x;
+    double pt_y;
+};
+
+static void
+centroid_add_area (struct planar_centroid *ctr, gaiaRingPtr ring,
+		   int is_exterior)
+{
+/* adding a Ring's area contribution (Holes are subtracted) */
+    double area2;
+    double cx;
+    double cy;
+    double weight;
+    measure_centroid (ring, &area2, &cx, &cy);
+    if (area2 == 0.0)
+	return;
+    weight = fabs (area2);
+    if (!is_exterior)
+	weight = -weight;
+/* ring centroid relative to the common base point */
+    cx = (ring->Coords[0] - ctr->base_x) + (cx / (area2 * 3.0));
+    cy = (ring->Coords[1] - ctr->base_y) + (cy / (area2 * 3.0));
+    ctr->area_sum += weight;
+    ctr->area_x += weight * cx;
+    ctr->area_y += weight * cy;
+}
+
+static void
+centroid_add_line (struct planar_centroid *ctr, int dims, const double *coords,
+		   int vert)
+{
+/* adding a Linestring (or Ring) length-weighted contribution */
+    int stride = coords_stride (dims);
+    int iv;
+    double length = 0.0;
+    double x0;
+    double y0;
+    double x1;
+    double y1;
+    double len;
+    for (iv = 1; iv < vert; iv++)
+      {
+	  x0 = coords[(iv - 1) * stride];
+	  y0 = coords[(iv - 1) * stride + 1];
+	  x1 = coords[iv * stride];
+	  y1 = coords[iv * stride + 1];
+	  len = sqrt (((x1 - x0) * (x1 - x0)) + ((y1 - y0) * (y1 - y0)));
+	  if (len == 0.0)
+	      continue;
+	  length += len;
+	  ctr->line_x += len * (x0 + x1) / 2.0;
+	  ctr->line_y += len * (y0 + y1) / 2.0;
+      }
+    ctr->line_sum += length;
+    if (length == 0.0 && vert > 0)
+      {
+	  /* degenerate Linestring: handled just as a Point */
+	  ctr->pt_count += 1;
+	  ctr->pt_x += coords[0];
+	  ctr->pt_y += coords[1];
+      }
+}
+
+GAIAGEO_DECLARE int
+gaiaGeomCollPlanarCentroid (gaiaGeomCollPtr geom, double *x, double *y)
+{
+/* 
+/ determines the Centroid for this Geometry (native, no GEOS)
+/ exactly as GEOS does: the highest dimension having a
+/ non-zero measure always wins
+*/
+    int ib;
+    struct planar_centroid ctr;
+    gaiaPointPtr pt;
+    gaiaLinestringPtr line;
+    gaiaPolygonPtr polyg;
+    gaiaRingPtr ring;
+    if (!geom)
+	return 0;
+    if (planar_is_toxic (geom))
+	return 0;
+    memset (&ctr, 0, sizeof (struct planar_centroid));
+    if (geom->FirstPolygon != NULL)
+      {
+	  ctr.base_x = geom->FirstPolygon->Exterior->Coords[0];
+	  ctr.base_y = geom->FirstPolygon->Exterior->Coords[1];
+      }
+    pt = geom->FirstPoint;
+    while (pt)
+      {
+	  ctr.pt_count += 1;
+	  ctr.pt_x += pt->X;
+	  ctr.pt_y += pt->Y;
+	  pt = pt->Next;
+      }
+    line = geom->FirstLinestring;
+    while (line)
+      {
+	  centroid_add_line (&ctr, line->DimensionModel, line->Coords,
+			     line->Points);
+	  line = line->Next;
+      }
+    polyg = geom->FirstPolygon;
+    while (polyg)
+      {
+	  ring = polyg->Exterior;
+	  centroid_add_area (&ctr, ring, 1);
+	  centroid_add_line (&ctr, ring->DimensionModel, ring->Coords,
+			     ring->Points);
+	  for (ib = 0; ib < polyg->NumInteriors; ib++)
+	    {
+		ring = polyg->Interiors + ib;
+		centroid_add_area (&ctr, ring, 0);
+		centroid_add_line (&ctr, ring->DimensionModel, ring->Coords,
+				   ring->Points);
+	    }
+	  polyg = polyg->Next;
+      }
+    if (ctr.area_sum != 0.0)
+      {
+	  *x = ctr.base_x + (ctr.area_x / ctr.area_sum);
+	  *y = ctr.base_y + (ctr.area_y / ctr.area_sum);
+	  return 1;
+      }
+    if (ctr.line_sum > 0.0)
+      {
+	  *x = ctr.line_x / ctr.line_sum;
+	  *y = ctr.line_y / ctr.line_sum;
+	  return 1;
+      }
+    if (ctr.pt_count > 0)
+      {
+	  *x = ctr.pt_x / (double) ctr.pt_count;
+	  *y = ctr.pt_y / (double) ctr.pt_count;
+	  return 1;
+      }
+    return 0;
+}
+
 GAIAGEO_DECLARE gaiaGeomCollPtr
 gaiaLinearize (gaiaGeomCollPtr geom, int force_multi)
 {
@@ -45,6 +45,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <float.h>
 
 #include <assert.h>
 
@@ -58,6 +59,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <spatialite/debug.h>
 
 #include <spatialite/gaiageo.h>
+#include <spatialite_private.h>
 
 #ifdef _WIN32
 #define strcasecmp	_stricmp
@@ -76,7 +78,6 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #endif
 
 #define EWKT_DYN_NONE	0
-#define EWKT_DYN_POINT	1
 #define EWKT_DYN_LINESTRING	2
 #define EWKT_DYN_POLYGON	3
 #define EWKT_DYN_RING	4
@@ -84,6 +85,9 @@ the terms of any one of the MPL, the GPL or the LGPL.
 
 #define EWKT_DYN_BLOCK 1024
 
+#define EWKT_TOKEN_BLOCK	256
+#define EWKT_POINT_BLOCK	128
+
 
 
 /*
@@ -165,7 +169,25 @@ struct ewkt_dyn_block
     int type[EWKT_DYN_BLOCK];
     void *ptr[EWKT_DYN_BLOCK];
     int index;
+    int first;			/* all entries before this one are cleaned */
     struct ewkt_dyn_block *next;
+    struct ewkt_dyn_block *prev;
+};
+
+struct ewkt_token_block
+{
+/* a block of token values (no malloc() for each single token) */
+    double value[EWKT_TOKEN_BLOCK];
+    int count;
+    struct ewkt_token_block *next;
+};
+
+struct ewkt_point_block
+{
+/* a block of intermediate Points, all released at the end of parsing */
+    gaiaPoint point[EWKT_POINT_BLOCK];
+    int count;
+    struct ewkt_point_block *next;
 };
 
 struct ewkt_data
@@ -176,6 +198,12 @@ struct ewkt_data
     int ewkt_col;
     struct ewkt_dyn_block *ewkt_first_dyn_block;
     struct ewkt_dyn_block *ewkt_last_dyn_block;
+    struct ewkt_token_block ewkt_first_token_block;
+    struct ewkt_token_block *ewkt_last_token_block;
+    struct ewkt_point_block ewkt_first_point_block;
+    struct ewkt_point_block *ewkt_last_point_block;
+    double ewkt_sink_value;	/* handed out once the arena is out of memory */
+    gaiaPoint ewkt_sink_point;
     gaiaGeomCollPtr result;
     YYSTYPE EwktLval;
 };
@@ -193,7 +221,9 @@ ewktCreateDynBlock (void)
 	  p->ptr[i] = NULL;
       }
     p->index = 0;
+    p->first = 0;
     p->next = NULL;
+    p->prev = NULL;
     return p;
 }
 
@@ -213,6 +243,7 @@ ewktMapDynAlloc (struct ewkt_data *p_data, int type, void *ptr)
       {
 	  /* adding a further block to the map */
 	  p = ewktCreateDynBlock ();
+	  p->prev = p_data->ewkt_last_dyn_block;
 	  p_data->ewkt_last_dyn_block->next = p;
 	  p_data->ewkt_last_dyn_block = p;
       }
@@ -222,32 +253,73 @@ ewktMapDynAlloc (struct ewkt_data *p_data, int type, void *ptr)
     p_data->ewkt_last_dyn_block->index++;
 }
 
+static void
+ewktMapDynRemove (struct ewkt_data *p_data, struct ewkt_dyn_block *p, int i)
+{
+/* marking a map entry as cleaned */
+    p->type[i] = EWKT_DYN_NONE;
+    p->ptr[i] = NULL;
+    while (p->first < p->index && p->type[p->first] == EWKT_DYN_NONE)
+	p->first++;
+    if (p == p_data->ewkt_last_dyn_block)
+      {
+	  /* trailing cleaned entries can be immediately recycled */
+	  while (p->index > p->first
+		 && p->type[p->index - 1] == EWKT_DYN_NONE)
+	      p->index--;
+      }
+}
+
 static void
 ewktMapDynClean (struct ewkt_data *p_data, void *ptr)
 {
-/* deleting a dynamic allocation from the map */
-    int i;
-    struct ewkt_dyn_block *p = p_data->ewkt_first_dyn_block;
-    while (p)
+/*
+/ deleting a dynamic allocation from the map
+/
+/ objects are almost always consumed either in the same order
+/ they were allocated (e.g. a list of Linestrings) or just after
+/ being allocated (e.g. the Rings of a Polygon): so we'll search
+/ from both ends of the map at the same time, skipping over any
+/ leading entry already cleaned
+*/
+    int i_fwd;
+    int i_bwd;
+    struct ewkt_dyn_block *fwd = p_data->ewkt_first_dyn_block;
+    struct ewkt_dyn_block *bwd = p_data->ewkt_last_dyn_block;
+    if (fwd == NULL)
+	return;
+    i_fwd = fwd->first;
+    i_bwd = bwd->index - 1;
+    while (1)
       {
-	  for (i = 0; i < EWKT_DYN_BLOCK; i++)
+	  while (fwd != NULL && i_fwd >= fwd->index)
 	    {
-		switch (p->type[i])
-		  {
-		  case EWKT_DYN_POINT:
-		  case EWKT_DYN_LINESTRING:
-		  case EWKT_DYN_POLYGON:
-		  case EWKT_DYN_RING:
-		  case EWKT_DYN_GEOMETRY:
-		      if (p->ptr[i] == ptr)
-			{
-			    p->type[i] = EWKT_DYN_NONE;
-			    return;
-			}
-		      break;
-		  };
+		fwd = fwd->next;
+		if (fwd != NULL)
+		    i_fwd = fwd->first;
 	    }
-	  p = p->next;
+	  while (bwd != NULL && i_bwd < bwd->first)
+	    {
+		bwd = bwd->prev;
+		if (bwd != NULL)
+		    i_bwd = bwd->index - 1;
+	    }
+	  if (fwd == NULL || bwd == NULL)
+	      return;
+	  if (fwd->type[i_fwd] != EWKT_DYN_NONE && fwd->ptr[i_fwd] == ptr)
+	    {
+		ewktMapDynRemove (p_data, fwd, i_fwd);
+		return;
+	    }
+	  if (bwd->type[i_bwd] != EWKT_DYN_NONE && bwd->ptr[i_bwd] == ptr)
+	    {
+		ewktMapDynRemove (p_data, bwd, i_bwd);
+		return;
+	    }
+	  if (fwd == bwd && i_fwd >= i_bwd)
+	      return;
+	  i_fwd++;
+	  i_bwd--;
       }
 }
 
@@ -267,9 +339,6 @@ ewktCleanMapDynAlloc (struct ewkt_data *p_data, int clean_all)
 		      /* deleting Geometry objects */
 		      switch (p->type[i])
 			{
-			case EWKT_DYN_POINT:
-			    gaiaFreePoint ((gaiaPointPtr) (p->ptr[i]));
-			    break;
 			case EWKT_DYN_LINESTRING:
 			    gaiaFreeLinestring ((gaiaLinestringPtr)
 						(p->ptr[i]));
@@ -293,6 +362,102 @@ ewktCleanMapDynAlloc (struct ewkt_data *p_data, int clean_all)
       }
 }
 
+static void
+ewktInitArena (struct ewkt_data *p_data)
+{
+/* initializing the token and point arenas (first blocks are embedded) */
+    p_data->ewkt_first_token_block.count = 0;
+    p_data->ewkt_first_token_block.next = NULL;
+    p_data->ewkt_last_token_block = &(p_data->ewkt_first_token_block);
+    p_data->ewkt_first_point_block.count = 0;
+    p_data->ewkt_first_point_block.next = NULL;
+    p_data->ewkt_last_point_block = &(p_data->ewkt_first_point_block);
+}
+
+static void
+ewktCleanArena (struct ewkt_data *p_data)
+{
+/* releasing the token and point arenas */
+    struct ewkt_token_block *pt;
+    struct ewkt_token_block *ptn;
+    struct ewkt_point_block *pp;
+    struct ewkt_point_block *ppn;
+    pt = p_data->ewkt_first_token_block.next;
+    while (pt)
+      {
+	  ptn = pt->next;
+	  free (pt);
+	  pt = ptn;
+      }
+    pp = p_data->ewkt_first_point_block.next;
+    while (pp)
+      {
+	  ppn = pp->next;
+	  free (pp);
+	  pp = ppn;
+      }
+}
+
+static double *
+ewktTokenValue (struct ewkt_data *p_data, double value)
+{
+/* storing a token value into the arena */
+    struct ewkt_token_block *p = p_data->ewkt_last_token_block;
+    if (p->count >= EWKT_TOKEN_BLOCK)
+      {
+	  /* adding a further block */
+	  p->next = malloc (sizeof (struct ewkt_token_block));
+	  if (p->next == NULL)
+	    {
+		/* out of memory: the parse will fail */
+		p_data->ewkt_parse_error = 1;
+		p_data->ewkt_sink_value = 0.0;
+		return &(p_data->ewkt_sink_value);
+	    }
+	  p = p->next;
+	  p->count = 0;
+	  p->next = NULL;
+	  p_data->ewkt_last_token_block = p;
+      }
+    p->value[p->count] = value;
+    return p->value + p->count++;
+}
+
+static gaiaPointPtr
+ewktArenaPoint (struct ewkt_data *p_data, double x, double y, double z,
+		double m, int dimension_model)
+{
+/* allocating an intermediate Point from the arena */
+    gaiaPointPtr pt;
+    struct ewkt_point_block *p = p_data->ewkt_last_point_block;
+    if (p->count >= EWKT_POINT_BLOCK)
+      {
+	  /* adding a further block */
+	  p->next = malloc (sizeof (struct ewkt_point_block));
+	  if (p->next == NULL)
+	    {
+		/* out of memory: the parse will fail */
+		p_data->ewkt_parse_error = 1;
+		pt = &(p_data->ewkt_sink_point);
+		memset (pt, 0, sizeof (gaiaPoint));
+		return pt;
+	    }
+	  p = p->next;
+	  p->count = 0;
+	  p->next = NULL;
+	  p_data->ewkt_last_point_block = p;
+      }
+    pt = p->point + p->count++;
+    pt->X = x;
+    pt->Y = y;
+    pt->Z = z;
+    pt->M = m;
+    pt->DimensionModel = dimension_model;
+    pt->Next = NULL;
+    pt->Prev = NULL;
+    return pt;
+}
+
 static int
 ewktCheckValidity (gaiaGeomCollPtr geom)
 {
@@ -340,6 +505,42 @@ ewktCheckValidity (gaiaGeomCollPtr geom)
     return 1;
 }
 
+static void
+ewktAttachLinestrings (struct ewkt_data *p_data, gaiaGeomCollPtr geom,
+		       gaiaLinestringPtr first)
+{
+/* moving a list of Linestrings into a Geometry (no coordinate copies) */
+    gaiaLinestringPtr p = first;
+    while (p)
+      {
+	  ewktMapDynClean (p_data, p);
+	  if (geom->FirstLinestring == NULL)
+	      geom->FirstLinestring = p;
+	  if (geom->LastLinestring != NULL)
+	      geom->LastLinestring->Next = p;
+	  geom->LastLinestring = p;
+	  p = p->Next;
+      }
+}
+
+static void
+ewktAttachPolygons (struct ewkt_data *p_data, gaiaGeomCollPtr geom,
+		    gaiaPolygonPtr first)
+{
+/* moving a list of Polygons into a Geometry (no coordinate copies) */
+    gaiaPolygonPtr p = first;
+    while (p)
+      {
+	  ewktMapDynClean (p_data, p);
+	  if (geom->FirstPolygon == NULL)
+	      geom->FirstPolygon = p;
+	  if (geom->LastPolygon != NULL)
+	      geom->LastPolygon->Next = p;
+	  geom->LastPolygon = p;
+	  p = p->Next;
+      }
+}
+
 static gaiaGeomCollPtr
 gaiaEwktGeometryFromPoint (struct ewkt_data *p_data, gaiaPointPtr point)
 {
@@ -349,8 +550,6 @@ gaiaEwktGeometryFromPoint (struct ewkt_data *p_data, gaiaPointPtr point)
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINT;
     gaiaAddPointToGeomColl (geom, point->X, point->Y);
-    ewktMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -363,8 +562,6 @@ gaiaEwktGeometryFromPointZ (struct ewkt_data *p_data, gaiaPointPtr point)
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINTZ;
     gaiaAddPointToGeomCollXYZ (geom, point->X, point->Y, point->Z);
-    ewktMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -377,8 +574,6 @@ gaiaEwktGeometryFromPointM (struct ewkt_data *p_data, gaiaPointPtr point)
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINTM;
     gaiaAddPointToGeomCollXYM (geom, point->X, point->Y, point->M);
-    ewktMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -391,8 +586,6 @@ gaiaEwktGeometryFromPointZM (struct ewkt_data *p_data, gaiaPointPtr point)
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINTZM;
     gaiaAddPointToGeomCollXYZM (geom, point->X, point->Y, point->Z, point->M);
-    ewktMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -402,22 +595,10 @@ gaiaEwktGeometryFromLinestring (struct ewkt_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRING */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
     geom = gaiaAllocGeomColl ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPoint (line->Coords, iv, &x, &y);
-	  gaiaSetPoint (line2->Coords, iv, x, y);
-      }
-    ewktMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    ewktAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -427,23 +608,10 @@ gaiaEwktGeometryFromLinestringZ (struct ewkt_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRINGZ */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
-    double z;
     geom = gaiaAllocGeomCollXYZ ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPointXYZ (line->Coords, iv, &x, &y, &z);
-	  gaiaSetPointXYZ (line2->Coords, iv, x, y, z);
-      }
-    ewktMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    ewktAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -454,23 +622,10 @@ gaiaEwktGeometryFromLinestringM (struct ewkt_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRINGM */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
-    double m;
     geom = gaiaAllocGeomCollXYM ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPointXYM (line->Coords, iv, &x, &y, &m);
-	  gaiaSetPointXYM (line2->Coords, iv, x, y, m);
-      }
-    ewktMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    ewktAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -480,33 +635,17 @@ gaiaEwktGeometryFromLinestringZM (struct ewkt_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRINGZM */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
-    double z;
-    double m;
     geom = gaiaAllocGeomCollXYZM ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPointXYZM (line->Coords, iv, &x, &y, &z, &m);
-	  gaiaSetPointXYZM (line2->Coords, iv, x, y, z, m);
-      }
-    ewktMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    ewktAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
 static gaiaPointPtr
 ewkt_point_xy (struct ewkt_data *p_data, double *x, double *y)
 {
-    gaiaPointPtr pt = gaiaAllocPoint (*x, *y);
-    ewktMapDynAlloc (p_data, EWKT_DYN_POINT, pt);
-    return pt;
+    return ewktArenaPoint (p_data, *x, *y, 0.0, 0.0, GAIA_XY);
 }
 
 /* 
@@ -521,9 +660,7 @@ ewkt_point_xy (struct ewkt_data *p_data, double *x, double *y)
 static gaiaPointPtr
 ewkt_point_xyz (struct ewkt_data *p_data, double *x, double *y, double *z)
 {
-    gaiaPointPtr pt = gaiaAllocPointXYZ (*x, *y, *z);
-    ewktMapDynAlloc (p_data, EWKT_DYN_POINT, pt);
-    return pt;
+    return ewktArenaPoint (p_data, *x, *y, *z, 0.0, GAIA_XY_Z);
 }
 
 /* 
@@ -536,9 +673,7 @@ ewkt_point_xyz (struct ewkt_data *p_data, double *x, double *y, double *z)
 static gaiaPointPtr
 ewkt_point_xym (struct ewkt_data *p_data, double *x, double *y, double *m)
 {
-    gaiaPointPtr pt = gaiaAllocPointXYM (*x, *y, *m);
-    ewktMapDynAlloc (p_data, EWKT_DYN_POINT, pt);
-    return pt;
+    return ewktArenaPoint (p_data, *x, *y, 0.0, *m, GAIA_XY_M);
 }
 
 /* 
@@ -552,9 +687,7 @@ gaiaPointPtr
 ewkt_point_xyzm (struct ewkt_data * p_data, double *x, double *y, double *z,
 		 double *m)
 {
-    gaiaPointPtr pt = gaiaAllocPointXYZM (*x, *y, *z, *m);
-    ewktMapDynAlloc (p_data, EWKT_DYN_POINT, pt);
-    return pt;
+    return ewktArenaPoint (p_data, *x, *y, *z, *m, GAIA_XY_Z_M);
 }
 
 /*
@@ -594,7 +727,6 @@ static gaiaLinestringPtr
 ewkt_linestring_xy (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -612,10 +744,7 @@ ewkt_linestring_xy (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPoint (linestring->Coords, i, p->X, p->Y);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -634,7 +763,6 @@ static gaiaLinestringPtr
 ewkt_linestring_xyz (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -652,10 +780,7 @@ ewkt_linestring_xyz (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPointXYZ (linestring->Coords, i, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -674,7 +799,6 @@ static gaiaLinestringPtr
 ewkt_linestring_xym (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -692,10 +816,7 @@ ewkt_linestring_xym (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPointXYM (linestring->Coords, i, p->X, p->Y, p->M);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -714,7 +835,6 @@ static gaiaLinestringPtr
 ewkt_linestring_xyzm (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -732,10 +852,7 @@ ewkt_linestring_xyzm (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPointXYZM (linestring->Coords, i, p->X, p->Y, p->Z, p->M);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -791,7 +908,6 @@ static gaiaRingPtr
 ewkt_ring_xy (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -816,10 +932,7 @@ ewkt_ring_xy (struct ewkt_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPoint (ring->Coords, index, p->X, p->Y);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -837,7 +950,6 @@ static gaiaRingPtr
 ewkt_ring_xyz (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -862,10 +974,7 @@ ewkt_ring_xyz (struct ewkt_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPointXYZ (ring->Coords, index, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -883,7 +992,6 @@ static gaiaRingPtr
 ewkt_ring_xym (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -908,10 +1016,7 @@ ewkt_ring_xym (struct ewkt_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPointXYM (ring->Coords, index, p->X, p->Y, p->M);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -929,7 +1034,6 @@ static gaiaRingPtr
 ewkt_ring_xyzm (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -954,10 +1058,7 @@ ewkt_ring_xyzm (struct ewkt_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPointXYZM (ring->Coords, index, p->X, p->Y, p->Z, p->M);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -977,27 +1078,52 @@ ewkt_polygon_any_type (struct ewkt_data *p_data, gaiaRingPtr first)
 {
     gaiaRingPtr p;
     gaiaRingPtr p_n;
+    gaiaRingPtr interior;
     gaiaPolygonPtr polygon;
+    int ib = 0;
     /* If no pointers are given, return. */
     if (first == NULL)
 	return NULL;
 
-    /* Creates and allocates a polygon structure with the exterior ring. */
-    polygon = gaiaCreatePolygon (first);
-    if (polygon == NULL)
-	return NULL;
+    /*
+     * Creates a polygon structure directly owning the exterior ring;
+     * the interior rings are then moved (not copied) into the polygon.
+     */
+    polygon = malloc (sizeof (gaiaPolygon));
+    polygon->Exterior = first;
+    polygon->NumInteriors = 0;
+    polygon->NextInterior = 0;
+    polygon->Interiors = NULL;
+    polygon->Next = NULL;
+    polygon->MinX = DBL_MAX;
+    polygon->MinY = DBL_MAX;
+    polygon->MaxX = -DBL_MAX;
+    polygon->MaxY = -DBL_MAX;
+    polygon->DimensionModel = first->DimensionModel;
     ewktMapDynAlloc (p_data, EWKT_DYN_POLYGON, polygon);
+    ewktMapDynClean (p_data, first);
+
+    p = first->Next;
+    while (p != NULL)
+      {
+	  polygon->NumInteriors++;
+	  p = p->Next;
+      }
+    if (polygon->NumInteriors > 0)
+	polygon->Interiors =
+	    malloc (sizeof (gaiaRing) * polygon->NumInteriors);
 
     /* Adds all interior rings into the polygon structure. */
-    p = first;
+    p = first->Next;
+    first->Next = NULL;
     while (p != NULL)
       {
 	  p_n = p->Next;
 	  ewktMapDynClean (p_data, p);
-	  if (p == first)
-	      gaiaFreeRing (p);
-	  else
-	      gaiaAddRingToPolyg (polygon, p);
+	  interior = polygon->Interiors + ib++;
+	  memcpy (interior, p, sizeof (gaiaRing));
+	  interior->Next = NULL;
+	  free (p);
 	  p = p_n;
       }
 
@@ -1127,7 +1253,6 @@ static gaiaGeomCollPtr
 ewkt_multipoint_xy (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1145,10 +1270,7 @@ ewkt_multipoint_xy (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomColl (geom, p->X, p->Y);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1165,7 +1287,6 @@ static gaiaGeomCollPtr
 ewkt_multipoint_xyz (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1183,10 +1304,7 @@ ewkt_multipoint_xyz (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomCollXYZ (geom, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1203,7 +1321,6 @@ static gaiaGeomCollPtr
 ewkt_multipoint_xym (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1221,10 +1338,7 @@ ewkt_multipoint_xym (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomCollXYM (geom, p->X, p->Y, p->M);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1241,7 +1355,6 @@ static gaiaGeomCollPtr
 ewkt_multipoint_xyzm (struct ewkt_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1259,10 +1372,7 @@ ewkt_multipoint_xyzm (struct ewkt_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomCollXYZM (geom, p->X, p->Y, p->Z, p->M);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1279,23 +1389,12 @@ ewkt_multipoint_xyzm (struct ewkt_data *p_data, gaiaPointPtr first)
 static gaiaGeomCollPtr
 ewkt_multilinestring_xy (struct ewkt_data *p_data, gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomColl ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    ewktAttachLinestrings (p_data, a, first);
 
     return a;
 }
@@ -1312,23 +1411,12 @@ ewkt_multilinestring_xy (struct ewkt_data *p_data, gaiaLinestringPtr first)
 static gaiaGeomCollPtr
 ewkt_multilinestring_xyz (struct ewkt_data *p_data, gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomCollXYZ ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY_Z;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    ewktAttachLinestrings (p_data, a, first);
     return a;
 }
 
@@ -1344,23 +1432,12 @@ ewkt_multilinestring_xyz (struct ewkt_data *p_data, gaiaLinestringPtr first)
 static gaiaGeomCollPtr
 ewkt_multilinestring_xym (struct ewkt_data *p_data, gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomCollXYM ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY_M;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    ewktAttachLinestrings (p_data, a, first);
 
     return a;
 }
@@ -1377,23 +1454,12 @@ ewkt_multilinestring_xym (struct ewkt_data *p_data, gaiaLinestringPtr first)
 static gaiaGeomCollPtr
 ewkt_multilinestring_xyzm (struct ewkt_data *p_data, gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomCollXYZM ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY_Z_M;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    ewktAttachLinestrings (p_data, a, first);
     return a;
 }
 
@@ -1413,37 +1479,12 @@ ewkt_multilinestring_xyzm (struct ewkt_data *p_data, gaiaLinestringPtr first)
 static gaiaGeomCollPtr
 ewkt_multipolygon_xy (struct ewkt_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomColl ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    ewktAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1464,37 +1505,12 @@ ewkt_multipolygon_xy (struct ewkt_data *p_data, gaiaPolygonPtr first)
 static gaiaGeomCollPtr
 ewkt_multipolygon_xyz (struct ewkt_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomCollXYZ ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    ewktAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1515,37 +1531,12 @@ ewkt_multipolygon_xyz (struct ewkt_data *p_data, gaiaPolygonPtr first)
 static gaiaGeomCollPtr
 ewkt_multipolygon_xym (struct ewkt_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomCollXYM ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    ewktAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1566,37 +1557,12 @@ ewkt_multipolygon_xym (struct ewkt_data *p_data, gaiaPolygonPtr first)
 static gaiaGeomCollPtr
 ewkt_multipolygon_xyzm (struct ewkt_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomCollXYZM ();
     ewktMapDynAlloc (p_data, EWKT_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  ewktMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    ewktAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1794,36 +1760,60 @@ ewkt_geomColl_xyzm (struct ewkt_data *p_data, gaiaGeomCollPtr first)
 
 
 
-/*
-** This is a linked-list struct to store all the values for each token.
-** All tokens will have a value of 0, except tokens denoted as NUM.
-** NUM tokens are geometry coordinates and will contain the floating
-** point number.
-*/
-typedef struct ewktFlexTokenStruct
+struct ewkt_parser
 {
-    double value;
-    struct ewktFlexTokenStruct *Next;
-} ewktFlexToken;
+/* a reusable Lemon parser and Flex scanner (one for each connection) */
+    void *lemon;
+    yyscan_t scanner;
+    int busy;
+};
 
-/*
-** Function to clean up the linked-list of token values.
-*/
-static int
-ewkt_cleanup (ewktFlexToken * token)
+static void
+ewkt_reset_lemon (void *p)
 {
-    ewktFlexToken *ptok;
-    ewktFlexToken *ptok_n;
-    if (token == NULL)
-	return 0;
-    ptok = token;
-    while (ptok)
+/* resetting a Lemon parser to its initial state, so to be reused */
+    yyParser *pParser = (yyParser *) p;
+    while (pParser->yyidx >= 0)
+	yy_pop_parser_stack (pParser);
+}
+
+static struct ewkt_parser *
+ewkt_get_parser (const void *p_cache)
+{
+/* returning the reusable EWKT parser of this connection */
+    struct ewkt_parser *parser;
+    struct splite_internal_cache *cache =
+	(struct splite_internal_cache *) p_cache;
+    if (cache == NULL)
+	return NULL;
+    if (cache->magic1 != SPATIALITE_CACHE_MAGIC1
+	|| cache->magic2 != SPATIALITE_CACHE_MAGIC2)
+	return NULL;
+    parser = (struct ewkt_parser *) (cache->ewkt_parser);
+    if (parser == NULL)
       {
-	  ptok_n = ptok->Next;
-	  free (ptok);
-	  ptok = ptok_n;
+	  /* lazily creating the parser on first use */
+	  parser = malloc (sizeof (struct ewkt_parser));
+	  parser->lemon = ParseAlloc (malloc);
+	  Ewktlex_init_extra (NULL, &(parser->scanner));
+	  parser->busy = 0;
+	  cache->ewkt_parser = parser;
       }
-    return 0;
+    if (parser->busy)
+	return NULL;
+    return parser;
+}
+
+SPATIALITE_PRIVATE void
+gaiaEwktParserDestroy (void *p)
+{
+/* memory cleanup - destroying a reusable EWKT parser */
+    struct ewkt_parser *parser = (struct ewkt_parser *) p;
+    if (parser == NULL)
+	return;
+    ParseFree (parser->lemon, free);
+    Ewktlex_destroy (parser->scanner);
+    free (parser);
 }
 
 static int
@@ -1880,18 +1870,15 @@ findEwktSrid (const char *buffer, int *base_offset)
     return atoi (dummy + 5);
 }
 
-gaiaGeomCollPtr
-gaiaParseEWKT (const unsigned char *dirty_buffer)
+static gaiaGeomCollPtr
+ewkt_parse (struct ewkt_parser *parser, const unsigned char *dirty_buffer)
 {
-    void *pParser = ParseAlloc (malloc);
-    /* Linked-list of token values */
-    ewktFlexToken *tokens = malloc (sizeof (ewktFlexToken));
-    /* Pointer to the head of the list */
-    ewktFlexToken *head = tokens;
+    void *pParser;
     int yv;
     int srid;
     int base_offset;
     yyscan_t scanner;
+    YY_BUFFER_STATE buffer;
     struct ewkt_data str_data;
 
 /* initializing the helper structs */
@@ -1901,13 +1888,25 @@ gaiaParseEWKT (const unsigned char *dirty_buffer)
     str_data.ewkt_first_dyn_block = NULL;
     str_data.ewkt_last_dyn_block = NULL;
     str_data.result = NULL;
+    ewktInitArena (&str_data);
 
-/* initializing the scanner state */
-    Ewktlex_init_extra (&str_data, &scanner);
-    tokens->Next = NULL;
+/* initializing the parser and scanner state */
+    if (parser != NULL)
+      {
+	  /* reusing the connection's own parser */
+	  parser->busy = 1;
+	  pParser = parser->lemon;
+	  scanner = parser->scanner;
+	  Ewktset_extra (&str_data, scanner);
+      }
+    else
+      {
+	  pParser = ParseAlloc (malloc);
+	  Ewktlex_init_extra (&str_data, &scanner);
+      }
 
     srid = findEwktSrid ((char *) dirty_buffer, &base_offset);
-    Ewkt_scan_string ((char *) dirty_buffer + base_offset, scanner);
+    buffer = Ewkt_scan_string ((char *) dirty_buffer + base_offset, scanner);
 
     /*
        / Keep tokenizing until we reach the end
@@ -1920,21 +1919,27 @@ gaiaParseEWKT (const unsigned char *dirty_buffer)
 		str_data.ewkt_parse_error = 1;
 		break;
 	    }
-	  tokens->Next = malloc (sizeof (ewktFlexToken));
-	  tokens->Next->Next = NULL;
-	  tokens->Next->value = str_data.EwktLval.dval;
 	  /* Pass the token to the wkt parser created from lemon */
-	  Parse (pParser, yv, &(tokens->Next->value), &str_data);
-	  tokens = tokens->Next;
+	  Parse (pParser, yv,
+		 ewktTokenValue (&str_data, str_data.EwktLval.dval),
+		 &str_data);
+	  if (str_data.ewkt_parse_error)
+	      break;
       }
     /* This denotes the end of a line as well as the end of the parser */
     Parse (pParser, EWKT_NEWLINE, 0, &str_data);
-    ParseFree (pParser, free);
-    Ewktlex_destroy (scanner);
-
-    /* Assigning the token as the end to avoid seg faults while cleaning */
-    tokens->Next = NULL;
-    ewkt_cleanup (head);
+    Ewkt_delete_buffer (buffer, scanner);
+    if (parser != NULL)
+      {
+	  ewkt_reset_lemon (pParser);
+	  parser->busy = 0;
+      }
+    else
+      {
+	  ParseFree (pParser, free);
+	  Ewktlex_destroy (scanner);
+      }
+    ewktCleanArena (&str_data);
 
     if (str_data.ewkt_parse_error)
       {
@@ -1968,6 +1973,18 @@ gaiaParseEWKT (const unsigned char *dirty_buffer)
     return str_data.result;
 }
 
+gaiaGeomCollPtr
+gaiaParseEWKT (const unsigned char *dirty_buffer)
+{
+    return ewkt_parse (NULL, dirty_buffer);
+}
+
+GAIAGEO_DECLARE gaiaGeomCollPtr
+gaiaParseEWKT_r (const void *p_cache, const unsigned char *dirty_buffer)
+{
+    return ewkt_parse (ewkt_get_parser (p_cache), dirty_buffer);
+}
+
 
 /*
 ** CAVEAT: we must now undefine any Lemon/Flex own macro
@@ -45,6 +45,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <float.h>
 
 #include <assert.h>
 
@@ -58,9 +59,9 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <spatialite/debug.h>
 
 #include <spatialite/gaiageo.h>
+#include <spatialite_private.h>
 
 #define GEOJSON_DYN_NONE	0
-#define GEOJSON_DYN_POINT	1
 #define GEOJSON_DYN_LINESTRING	2
 #define GEOJSON_DYN_POLYGON	3
 #define GEOJSON_DYN_RING	4
@@ -68,6 +69,9 @@ the terms of any one of the MPL, the GPL or the LGPL.
 
 #define GEOJSON_DYN_BLOCK 1024
 
+#define GEOJSON_TOKEN_BLOCK	256
+#define GEOJSON_POINT_BLOCK	128
+
 
 
 /*
@@ -150,7 +154,25 @@ struct geoJson_dyn_block
     int type[GEOJSON_DYN_BLOCK];
     void *ptr[GEOJSON_DYN_BLOCK];
     int index;
+    int first;			/* all entries before this one are cleaned */
     struct geoJson_dyn_block *next;
+    struct geoJson_dyn_block *prev;
+};
+
+struct geoJson_token_block
+{
+/* a block of token values (no malloc() for each single token) */
+    double value[GEOJSON_TOKEN_BLOCK];
+    int count;
+    struct geoJson_token_block *next;
+};
+
+struct geoJson_point_block
+{
+/* a block of intermediate Points, all released at the end of parsing */
+    gaiaPoint point[GEOJSON_POINT_BLOCK];
+    int count;
+    struct geoJson_point_block *next;
 };
 
 struct geoJson_data
@@ -161,6 +183,12 @@ struct geoJson_data
     int geoJson_col;
     struct geoJson_dyn_block *geoJson_first_dyn_block;
     struct geoJson_dyn_block *geoJson_last_dyn_block;
+    struct geoJson_token_block geoJson_first_token_block;
+    struct geoJson_token_block *geoJson_last_token_block;
+    struct geoJson_point_block geoJson_first_point_block;
+    struct geoJson_point_block *geoJson_last_point_block;
+    double geoJson_sink_value;	/* handed out once the arena is out of memory */
+    gaiaPoint geoJson_sink_point;
     gaiaGeomCollPtr result;
     YYSTYPE GeoJsonLval;
 };
@@ -178,7 +206,9 @@ geoJsonCreateDynBlock (void)
 	  p->ptr[i] = NULL;
       }
     p->index = 0;
+    p->first = 0;
     p->next = NULL;
+    p->prev = NULL;
     return p;
 }
 
@@ -198,6 +228,7 @@ geoJsonMapDynAlloc (struct geoJson_data *p_data, int type, void *ptr)
       {
 	  /* adding a further block to the map */
 	  p = geoJsonCreateDynBlock ();
+	  p->prev = p_data->geoJson_last_dyn_block;
 	  p_data->geoJson_last_dyn_block->next = p;
 	  p_data->geoJson_last_dyn_block = p;
       }
@@ -208,32 +239,74 @@ geoJsonMapDynAlloc (struct geoJson_data *p_data, int type, void *ptr)
     p_data->geoJson_last_dyn_block->index++;
 }
 
+static void
+geoJsonMapDynRemove (struct geoJson_data *p_data, struct geoJson_dyn_block *p,
+		     int i)
+{
+/* marking a map entry as cleaned */
+    p->type[i] = GEOJSON_DYN_NONE;
+    p->ptr[i] = NULL;
+    while (p->first < p->index && p->type[p->first] == GEOJSON_DYN_NONE)
+	p->first++;
+    if (p == p_data->geoJson_last_dyn_block)
+      {
+	  /* trailing cleaned entries can be immediately recycled */
+	  while (p->index > p->first
+		 && p->type[p->index - 1] == GEOJSON_DYN_NONE)
+	      p->index--;
+      }
+}
+
 static void
 geoJsonMapDynClean (struct geoJson_data *p_data, void *ptr)
 {
-/* deleting a dynamic allocation from the map */
-    int i;
-    struct geoJson_dyn_block *p = p_data->geoJson_first_dyn_block;
-    while (p)
+/*
+/ deleting a dynamic allocation from the map
+/
+/ objects are almost always consumed either in the same order
+/ they were allocated (e.g. a list of Linestrings) or just after
+/ being allocated (e.g. the Rings of a Polygon): so we'll search
+/ from both ends of the map at the same time, skipping over any
+/ leading entry already cleaned
+*/
+    int i_fwd;
+    int i_bwd;
+    struct geoJson_dyn_block *fwd = p_data->geoJson_first_dyn_block;
+    struct geoJson_dyn_block *bwd = p_data->geoJson_last_dyn_block;
+    if (fwd == NULL)
+	return;
+    i_fwd = fwd->first;
+    i_bwd = bwd->index - 1;
+    while (1)
       {
-	  for (i = 0; i < GEOJSON_DYN_BLOCK; i++)
+	  while (fwd != NULL && i_fwd >= fwd->index)
 	    {
-		switch (p->type[i])
-		  {
-		  case GEOJSON_DYN_POINT:
-		  case GEOJSON_DYN_LINESTRING:
-		  case GEOJSON_DYN_POLYGON:
-		  case GEOJSON_DYN_RING:
-		  case GEOJSON_DYN_GEOMETRY:
-		      if (p->ptr[i] == ptr)
-			{
-			    p->type[i] = GEOJSON_DYN_NONE;
-			    return;
-			}
-		      break;
-		  };
+		fwd = fwd->next;
+		if (fwd != NULL)
+		    i_fwd = fwd->first;
 	    }
-	  p = p->next;
+	  while (bwd != NULL && i_bwd < bwd->first)
+	    {
+		bwd = bwd->prev;
+		if (bwd != NULL)
+		    i_bwd = bwd->index - 1;
+	    }
+	  if (fwd == NULL || bwd == NULL)
+	      return;
+	  if (fwd->type[i_fwd] != GEOJSON_DYN_NONE && fwd->ptr[i_fwd] == ptr)
+	    {
+		geoJsonMapDynRemove (p_data, fwd, i_fwd);
+		return;
+	    }
+	  if (bwd->type[i_bwd] != GEOJSON_DYN_NONE && bwd->ptr[i_bwd] == ptr)
+	    {
+		geoJsonMapDynRemove (p_data, bwd, i_bwd);
+		return;
+	    }
+	  if (fwd == bwd && i_fwd >= i_bwd)
+	      return;
+	  i_fwd++;
+	  i_bwd--;
       }
 }
 
@@ -253,9 +326,6 @@ geoJsonCleanMapDynAlloc (struct geoJson_data *p_data, int clean_all)
 		      /* deleting Geometry objects */
 		      switch (p->type[i])
 			{
-			case GEOJSON_DYN_POINT:
-			    gaiaFreePoint ((gaiaPointPtr) (p->ptr[i]));
-			    break;
 			case GEOJSON_DYN_LINESTRING:
 			    gaiaFreeLinestring ((gaiaLinestringPtr)
 						(p->ptr[i]));
@@ -279,6 +349,102 @@ geoJsonCleanMapDynAlloc (struct geoJson_data *p_data, int clean_all)
       }
 }
 
+static void
+geoJsonInitArena (struct geoJson_data *p_data)
+{
+/* initializing the token and point arenas (first blocks are embedded) */
+    p_data->geoJson_first_token_block.count = 0;
+    p_data->geoJson_first_token_block.next = NULL;
+    p_data->geoJson_last_token_block = &(p_data->geoJson_first_token_block);
+    p_data->geoJson_first_point_block.count = 0;
+    p_data->geoJson_first_point_block.next = NULL;
+    p_data->geoJson_last_point_block = &(p_data->geoJson_first_point_block);
+}
+
+static void
+geoJsonCleanArena (struct geoJson_data *p_data)
+{
+/* releasing the token and point arenas */
+    struct geoJson_token_block *pt;
+    struct geoJson_token_block *ptn;
+    struct geoJson_point_block *pp;
+    struct geoJson_point_block *ppn;
+    pt = p_data->geoJson_first_token_block.next;
+    while (pt)
+      {
+	  ptn = pt->next;
+	  free (pt);
+	  pt = ptn;
+      }
+    pp = p_data->geoJson_first_point_block.next;
+    while (pp)
+      {
+	  ppn = pp->next;
+	  free (pp);
+	  pp = ppn;
+      }
+}
+
+static double *
+geoJsonTokenValue (struct geoJson_data *p_data, double value)
+{
+/* storing a token value into the arena */
+    struct geoJson_token_block *p = p_data->geoJson_last_token_block;
+    if (p->count >= GEOJSON_TOKEN_BLOCK)
+      {
+	  /* adding a further block */
+	  p->next = malloc (sizeof (struct geoJson_token_block));
+	  if (p->next == NULL)
+	    {
+		/* out of memory: the parse will fail */
+		p_data->geoJson_parse_error = 1;
+		p_data->geoJson_sink_value = 0.0;
+		return &(p_data->geoJson_sink_value);
+	    }
+	  p = p->next;
+	  p->count = 0;
+	  p->next = NULL;
+	  p_data->geoJson_last_token_block = p;
+      }
+    p->value[p->count] = value;
+    return p->value + p->count++;
+}
+
+static gaiaPointPtr
+geoJsonArenaPoint (struct geoJson_data *p_data, double x, double y, double z,
+		   double m, int dimension_model)
+{
+/* allocating an intermediate Point from the arena */
+    gaiaPointPtr pt;
+    struct geoJson_point_block *p = p_data->geoJson_last_point_block;
+    if (p->count >= GEOJSON_POINT_BLOCK)
+      {
+	  /* adding a further block */
+	  p->next = malloc (sizeof (struct geoJson_point_block));
+	  if (p->next == NULL)
+	    {
+		/* out of memory: the parse will fail */
+		p_data->geoJson_parse_error = 1;
+		pt = &(p_data->geoJson_sink_point);
+		memset (pt, 0, sizeof (gaiaPoint));
+		return pt;
+	    }
+	  p = p->next;
+	  p->count = 0;
+	  p->next = NULL;
+	  p_data->geoJson_last_point_block = p;
+      }
+    pt = p->point + p->count++;
+    pt->X = x;
+    pt->Y = y;
+    pt->Z = z;
+    pt->M = m;
+    pt->DimensionModel = dimension_model;
+    pt->Next = NULL;
+    pt->Prev = NULL;
+    return pt;
+}
+
 static int
 geoJsonCheckValidity (gaiaGeomCollPtr geom)
 {
@@ -326,6 +492,42 @@ geoJsonCheckValidity (gaiaGeomCollPtr geom)
     return 1;
 }
 
+static void
+geoJsonAttachLinestrings (struct geoJson_data *p_data, gaiaGeomCollPtr geom,
+			  gaiaLinestringPtr first)
+{
+/* moving a list of Linestrings into a Geometry (no coordinate copies) */
+    gaiaLinestringPtr p = first;
+    while (p)
+      {
+	  geoJsonMapDynClean (p_data, p);
+	  if (geom->FirstLinestring == NULL)
+	      geom->FirstLinestring = p;
+	  if (geom->LastLinestring != NULL)
+	      geom->LastLinestring->Next = p;
+	  geom->LastLinestring = p;
+	  p = p->Next;
+      }
+}
+
+static void
+geoJsonAttachPolygons (struct geoJson_data *p_data, gaiaGeomCollPtr geom,
+		       gaiaPolygonPtr first)
+{
+/* moving a list of Polygons into a Geometry (no coordinate copies) */
+    gaiaPolygonPtr p = first;
+    while (p)
+      {
+	  geoJsonMapDynClean (p_data, p);
+	  if (geom->FirstPolygon == NULL)
+	      geom->FirstPolygon = p;
+	  if (geom->LastPolygon != NULL)
+	      geom->LastPolygon->Next = p;
+	  geom->LastPolygon = p;
+	  p = p->Next;
+      }
+}
+
 static gaiaGeomCollPtr
 geoJSON_setSrid (gaiaGeomCollPtr geom, int *srid)
 {
@@ -347,8 +549,6 @@ gaiaGeoJsonGeometryFromPoint (struct geoJson_data *p_data, gaiaPointPtr point,
     geom->DeclaredType = GAIA_POINT;
     geom->Srid = srid;
     gaiaAddPointToGeomColl (geom, point->X, point->Y);
-    geoJsonMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -363,8 +563,6 @@ gaiaGeoJsonGeometryFromPointZ (struct geoJson_data *p_data, gaiaPointPtr point,
     geom->DeclaredType = GAIA_POINTZ;
     geom->Srid = srid;
     gaiaAddPointToGeomCollXYZ (geom, point->X, point->Y, point->Z);
-    geoJsonMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -374,23 +572,11 @@ gaiaGeoJsonGeometryFromLinestring (struct geoJson_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRING */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
     geom = gaiaAllocGeomColl ();
     geoJsonMapDynAlloc (p_data, GEOJSON_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
     geom->Srid = srid;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPoint (line->Coords, iv, &x, &y);
-	  gaiaSetPoint (line2->Coords, iv, x, y);
-      }
-    geoJsonMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    geoJsonAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -400,33 +586,18 @@ gaiaGeoJsonGeometryFromLinestringZ (struct geoJson_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRINGZ */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
-    double z;
     geom = gaiaAllocGeomCollXYZ ();
     geoJsonMapDynAlloc (p_data, GEOJSON_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
     geom->Srid = srid;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPointXYZ (line->Coords, iv, &x, &y, &z);
-	  gaiaSetPointXYZ (line2->Coords, iv, x, y, z);
-      }
-    geoJsonMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    geoJsonAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
 static gaiaPointPtr
 geoJSON_point_xy (struct geoJson_data *p_data, double *x, double *y)
 {
-    gaiaPointPtr pt = gaiaAllocPoint (*x, *y);
-    geoJsonMapDynAlloc (p_data, GEOJSON_DYN_POINT, pt);
-    return pt;
+    return geoJsonArenaPoint (p_data, *x, *y, 0.0, 0.0, GAIA_XY);
 }
 
 /* 
@@ -441,9 +612,7 @@ geoJSON_point_xy (struct geoJson_data *p_data, double *x, double *y)
 static gaiaPointPtr
 geoJSON_point_xyz (struct geoJson_data *p_data, double *x, double *y, double *z)
 {
-    gaiaPointPtr pt = gaiaAllocPointXYZ (*x, *y, *z);
-    geoJsonMapDynAlloc (p_data, GEOJSON_DYN_POINT, pt);
-    return pt;
+    return geoJsonArenaPoint (p_data, *x, *y, *z, 0.0, GAIA_XY_Z);
 }
 
 /*
@@ -494,7 +663,6 @@ static gaiaLinestringPtr
 geoJSON_linestring_xy (struct geoJson_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -512,10 +680,7 @@ geoJSON_linestring_xy (struct geoJson_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPoint (linestring->Coords, i, p->X, p->Y);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -534,7 +699,6 @@ static gaiaLinestringPtr
 geoJSON_linestring_xyz (struct geoJson_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -552,10 +716,7 @@ geoJSON_linestring_xyz (struct geoJson_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPointXYZ (linestring->Coords, i, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -622,7 +783,6 @@ static gaiaRingPtr
 geoJSON_ring_xy (struct geoJson_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -647,10 +807,7 @@ geoJSON_ring_xy (struct geoJson_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPoint (ring->Coords, index, p->X, p->Y);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -668,7 +825,6 @@ static gaiaRingPtr
 geoJSON_ring_xyz (struct geoJson_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -693,10 +849,7 @@ geoJSON_ring_xyz (struct geoJson_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPointXYZ (ring->Coords, index, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -716,27 +869,52 @@ geoJSON_polygon_any_type (struct geoJson_data *p_data, gaiaRingPtr first)
 {
     gaiaRingPtr p;
     gaiaRingPtr p_n;
+    gaiaRingPtr interior;
     gaiaPolygonPtr polygon;
+    int ib = 0;
     /* If no pointers are given, return. */
     if (first == NULL)
 	return NULL;
 
-    /* Creates and allocates a polygon structure with the exterior ring. */
-    polygon = gaiaCreatePolygon (first);
-    if (polygon == NULL)
-	return NULL;
+    /*
+     * Creates a polygon structure directly owning the exterior ring;
+     * the interior rings are then moved (not copied) into the polygon.
+     */
+    polygon = malloc (sizeof (gaiaPolygon));
+    polygon->Exterior = first;
+    polygon->NumInteriors = 0;
+    polygon->NextInterior = 0;
+    polygon->Interiors = NULL;
+    polygon->Next = NULL;
+    polygon->MinX = DBL_MAX;
+    polygon->MinY = DBL_MAX;
+    polygon->MaxX = -DBL_MAX;
+    polygon->MaxY = -DBL_MAX;
+    polygon->DimensionModel = first->DimensionModel;
     geoJsonMapDynAlloc (p_data, GEOJSON_DYN_POLYGON, polygon);
+    geoJsonMapDynClean (p_data, first);
+
+    p = first->Next;
+    while (p != NULL)
+      {
+	  polygon->NumInteriors++;
+	  p = p->Next;
+      }
+    if (polygon->NumInteriors > 0)
+	polygon->Interiors =
+	    malloc (sizeof (gaiaRing) * polygon->NumInteriors);
 
     /* Adds all interior rings into the polygon structure. */
-    p = first;
+    p = first->Next;
+    first->Next = NULL;
     while (p != NULL)
       {
 	  p_n = p->Next;
 	  geoJsonMapDynClean (p_data, p);
-	  if (p == first)
-	      gaiaFreeRing (p);
-	  else
-	      gaiaAddRingToPolyg (polygon, p);
+	  interior = polygon->Interiors + ib++;
+	  memcpy (interior, p, sizeof (gaiaRing));
+	  interior->Next = NULL;
+	  free (p);
 	  p = p_n;
       }
 
@@ -872,7 +1050,6 @@ static gaiaGeomCollPtr
 geoJSON_multipoint_xy (struct geoJson_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -890,10 +1067,7 @@ geoJSON_multipoint_xy (struct geoJson_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomColl (geom, p->X, p->Y);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -910,7 +1084,6 @@ static gaiaGeomCollPtr
 geoJSON_multipoint_xyz (struct geoJson_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -928,10 +1101,7 @@ geoJSON_multipoint_xyz (struct geoJson_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomCollXYZ (geom, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -949,23 +1119,12 @@ static gaiaGeomCollPtr
 geoJSON_multilinestring_xy (struct geoJson_data *p_data,
 			    gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomColl ();
     geoJsonMapDynAlloc (p_data, GEOJSON_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    geoJsonAttachLinestrings (p_data, a, first);
 
     return a;
 }
@@ -983,23 +1142,12 @@ static gaiaGeomCollPtr
 geoJSON_multilinestring_xyz (struct geoJson_data *p_data,
 			     gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomCollXYZ ();
     geoJsonMapDynAlloc (p_data, GEOJSON_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY_Z;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    geoJsonAttachLinestrings (p_data, a, first);
     return a;
 }
 
@@ -1019,37 +1167,12 @@ geoJSON_multilinestring_xyz (struct geoJson_data *p_data,
 static gaiaGeomCollPtr
 geoJSON_multipolygon_xy (struct geoJson_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomColl ();
     geoJsonMapDynAlloc (p_data, GEOJSON_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    geoJsonAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1070,37 +1193,12 @@ geoJSON_multipolygon_xy (struct geoJson_data *p_data, gaiaPolygonPtr first)
 static gaiaGeomCollPtr
 geoJSON_multipolygon_xyz (struct geoJson_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomCollXYZ ();
     geoJsonMapDynAlloc (p_data, GEOJSON_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  geoJsonMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    geoJsonAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1249,48 +1347,70 @@ geoJSON_geomColl_xyz (struct geoJson_data *p_data, gaiaGeomCollPtr first)
 
 
 
-/*
-** This is a linked-list struct to store all the values for each token.
-** All tokens will have a value of 0, except tokens denoted as NUM.
-** NUM tokens are geometry coordinates and will contain the floating
-** point number.
-*/
-typedef struct geoJsonFlexTokenStruct
+struct geoJson_parser
 {
-    double value;
-    struct geoJsonFlexTokenStruct *Next;
-} geoJsonFlexToken;
+/* a reusable Lemon parser and Flex scanner (one for each connection) */
+    void *lemon;
+    yyscan_t scanner;
+    int busy;
+};
 
-/*
-** Function to clean up the linked-list of token values.
-*/
-static int
-geoJSON_cleanup (geoJsonFlexToken * token)
+static void
+geoJson_reset_lemon (void *p)
 {
-    geoJsonFlexToken *ptok;
-    geoJsonFlexToken *ptok_n;
-    if (token == NULL)
-	return 0;
-    ptok = token;
-    while (ptok)
+/* resetting a Lemon parser to its initial state, so to be reused */
+    yyParser *pParser = (yyParser *) p;
+    while (pParser->yyidx >= 0)
+	yy_pop_parser_stack (pParser);
+}
+
+static struct geoJson_parser *
+geoJson_get_parser (const void *p_cache)
+{
+/* returning the reusable GeoJSON parser of this connection */
+    struct geoJson_parser *parser;
+    struct splite_internal_cache *cache =
+	(struct splite_internal_cache *) p_cache;
+    if (cache == NULL)
+	return NULL;
+    if (cache->magic1 != SPATIALITE_CACHE_MAGIC1
+	|| cache->magic2 != SPATIALITE_CACHE_MAGIC2)
+	return NULL;
+    parser = (struct geoJson_parser *) (cache->geojson_parser);
+    if (parser == NULL)
       {
-	  ptok_n = ptok->Next;
-	  free (ptok);
-	  ptok = ptok_n;
+	  /* lazily creating the parser on first use */
+	  parser = malloc (sizeof (struct geoJson_parser));
+	  parser->lemon = ParseAlloc (malloc);
+	  GeoJsonlex_init_extra (NULL, &(parser->scanner));
+	  parser->busy = 0;
+	  cache->geojson_parser = parser;
       }
-    return 0;
+    if (parser->busy)
+	return NULL;
+    return parser;
 }
 
-gaiaGeomCollPtr
-gaiaParseGeoJSON (const unsigned char *dirty_buffer)
+SPATIALITE_PRIVATE void
+gaiaGeoJsonParserDestroy (void *p)
+{
+/* memory cleanup - destroying a reusable GeoJSON parser */
+    struct geoJson_parser *parser = (struct geoJson_parser *) p;
+    if (parser == NULL)
+	return;
+    ParseFree (parser->lemon, free);
+    GeoJsonlex_destroy (parser->scanner);
+    free (parser);
+}
+
+static gaiaGeomCollPtr
+geoJson_parse (struct geoJson_parser *parser,
+	       const unsigned char *dirty_buffer)
 {
-    void *pParser = ParseAlloc (malloc);
-    /* Linked-list of token values */
-    geoJsonFlexToken *tokens = malloc (sizeof (geoJsonFlexToken));
-    /* Pointer to the head of the list */
-    geoJsonFlexToken *head = tokens;
+    void *pParser;
     int yv;
     yyscan_t scanner;
+    YY_BUFFER_STATE buffer;
     struct geoJson_data str_data;
 
 /* initializing the helper structs */
@@ -1300,13 +1420,24 @@ gaiaParseGeoJSON (const unsigned char *dirty_buffer)
     str_data.geoJson_first_dyn_block = NULL;
     str_data.geoJson_last_dyn_block = NULL;
     str_data.result = NULL;
+    geoJsonInitArena (&str_data);
 
-/* initializing the scanner state */
-    GeoJsonlex_init_extra (&str_data, &scanner);
-
-    tokens->Next = NULL;
+/* initializing the parser and scanner state */
+    if (parser != NULL)
+      {
+	  /* reusing the connection's own parser */
+	  parser->busy = 1;
+	  pParser = parser->lemon;
+	  scanner = parser->scanner;
+	  GeoJsonset_extra (&str_data, scanner);
+      }
+    else
+      {
+	  pParser = ParseAlloc (malloc);
+	  GeoJsonlex_init_extra (&str_data, &scanner);
+      }
 
-    GeoJson_scan_string ((char *) dirty_buffer, scanner);
+    buffer = GeoJson_scan_string ((char *) dirty_buffer, scanner);
 
     /*
        / Keep tokenizing until we reach the end
@@ -1319,21 +1450,27 @@ gaiaParseGeoJSON (const unsigned char *dirty_buffer)
 		str_data.geoJson_parse_error = 1;
 		break;
 	    }
-	  tokens->Next = malloc (sizeof (geoJsonFlexToken));
-	  tokens->Next->Next = NULL;
-	  tokens->Next->value = str_data.GeoJsonLval.dval;
 	  /* Pass the token to the wkt parser created from lemon */
-	  Parse (pParser, yv, &(tokens->Next->value), &str_data);
-	  tokens = tokens->Next;
+	  Parse (pParser, yv,
+		 geoJsonTokenValue (&str_data, str_data.GeoJsonLval.dval),
+		 &str_data);
+	  if (str_data.geoJson_parse_error)
+	      break;
       }
     /* This denotes the end of a line as well as the end of the parser */
     Parse (pParser, GEOJSON_NEWLINE, 0, &str_data);
-    ParseFree (pParser, free);
-    GeoJsonlex_destroy (scanner);
-
-    /* Assigning the token as the end to avoid seg faults while cleaning */
-    tokens->Next = NULL;
-    geoJSON_cleanup (head);
+    GeoJson_delete_buffer (buffer, scanner);
+    if (parser != NULL)
+      {
+	  geoJson_reset_lemon (pParser);
+	  parser->busy = 0;
+      }
+    else
+      {
+	  ParseFree (pParser, free);
+	  GeoJsonlex_destroy (scanner);
+      }
+    geoJsonCleanArena (&str_data);
 
     if (str_data.geoJson_parse_error)
       {
@@ -1366,6 +1503,18 @@ gaiaParseGeoJSON (const unsigned char *dirty_buffer)
     return str_data.result;
 }
 
+gaiaGeomCollPtr
+gaiaParseGeoJSON (const unsigned char *dirty_buffer)
+{
+    return geoJson_parse (NULL, dirty_buffer);
+}
+
+GAIAGEO_DECLARE gaiaGeomCollPtr
+gaiaParseGeoJSON_r (const void *p_cache, const unsigned char *dirty_buffer)
+{
+    return geoJson_parse (geoJson_get_parser (p_cache), dirty_buffer);
+}
+
 
 /*
 ** CAVEAT: we must now undefine any Lemon/Flex own macro
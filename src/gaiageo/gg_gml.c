@@ -91,12 +91,11 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #define GML_DYN_DYNLINE	1
 #define GML_DYN_GEOM	2
 #define GML_DYN_DYNPG	3
-#define GML_DYN_NODE	4
-#define GML_DYN_COORD	5
-#define GML_DYN_ATTRIB	6
 
 #define GML_DYN_BLOCK 1024
 
+#define GML_ARENA_BLOCK	65536
+
 
 
 /*
@@ -173,12 +172,11 @@ typedef union
 
 
 /*
-** This is a linked-list struct to store all the values for each token.
+** This struct stores the value of each token (allocated from the arena).
 */
 typedef struct gmlFlexTokenStruct
 {
     char *value;
-    struct gmlFlexTokenStruct *Next;
 } gmlFlexToken;
 
 typedef struct gml_coord
@@ -229,7 +227,17 @@ struct gml_dyn_block
     int type[GML_DYN_BLOCK];
     void *ptr[GML_DYN_BLOCK];
     int index;
+    int first;			/* all entries before this one are cleaned */
     struct gml_dyn_block *next;
+    struct gml_dyn_block *prev;
+};
+
+struct gml_arena_block
+{
+/* a memory block for tokens, nodes, attributes and coords */
+    size_t size;
+    size_t used;
+    struct gml_arena_block *next;
 };
 
 struct gml_data
@@ -240,8 +248,17 @@ struct gml_data
     int gml_col;
     struct gml_dyn_block *gml_first_dyn_block;
     struct gml_dyn_block *gml_last_dyn_block;
+    struct gml_arena_block *gml_arena;
     gmlNodePtr result;
     YYSTYPE GmlLval;
+    union
+    {
+	gmlFlexToken token;
+	gmlCoord coord;
+	gmlAttr attr;
+	gmlNode node;
+    } gml_sink;			/* handed out once the arena is out of memory */
+    char gml_no_string[1];
 };
 
 static struct gml_dyn_block *
@@ -257,7 +274,9 @@ gmlCreateDynBlock (void)
 	  p->ptr[i] = NULL;
       }
     p->index = 0;
+    p->first = 0;
     p->next = NULL;
+    p->prev = NULL;
     return p;
 }
 
@@ -277,6 +296,7 @@ gmlMapDynAlloc (struct gml_data *p_data, int type, void *ptr)
       {
 	  /* adding a further block to the map */
 	  p = gmlCreateDynBlock ();
+	  p->prev = p_data->gml_last_dyn_block;
 	  p_data->gml_last_dyn_block->next = p;
 	  p_data->gml_last_dyn_block = p;
       }
@@ -285,33 +305,73 @@ gmlMapDynAlloc (struct gml_data *p_data, int type, void *ptr)
     p_data->gml_last_dyn_block->index++;
 }
 
+static void
+gmlMapDynRemove (struct gml_data *p_data, struct gml_dyn_block *p, int i)
+{
+/* marking a map entry as cleaned */
+    p->type[i] = GML_DYN_NONE;
+    p->ptr[i] = NULL;
+    while (p->first < p->index && p->type[p->first] == GML_DYN_NONE)
+	p->first++;
+    if (p == p_data->gml_last_dyn_block)
+      {
+	  /* trailing cleaned entries can be immediately recycled */
+	  while (p->index > p->first
+		 && p->type[p->index - 1] == GML_DYN_NONE)
+	      p->index--;
+      }
+}
+
 static void
 gmlMapDynClean (struct gml_data *p_data, void *ptr)
 {
-/* deleting a dynamic allocation from the map */
-    int i;
-    struct gml_dyn_block *p = p_data->gml_first_dyn_block;
-    while (p)
+/*
+/ deleting a dynamic allocation from the map
+/
+/ objects are almost always consumed either in the same order
+/ they were allocated (e.g. a list of Linestrings) or just after
+/ being allocated (e.g. the Rings of a Polygon): so we'll search
+/ from both ends of the map at the same time, skipping over any
+/ leading entry already cleaned
+*/
+    int i_fwd;
+    int i_bwd;
+    struct gml_dyn_block *fwd = p_data->gml_first_dyn_block;
+    struct gml_dyn_block *bwd = p_data->gml_last_dyn_block;
+    if (fwd == NULL)
+	return;
+    i_fwd = fwd->first;
+    i_bwd = bwd->index - 1;
+    while (1)
       {
-	  for (i = 0; i < GML_DYN_BLOCK; i++)
+	  while (fwd != NULL && i_fwd >= fwd->index)
 	    {
-		switch (p->type[i])
-		  {
-		  case GML_DYN_DYNLINE:
-		  case GML_DYN_GEOM:
-		  case GML_DYN_DYNPG:
-		  case GML_DYN_NODE:
-		  case GML_DYN_COORD:
-		  case GML_DYN_ATTRIB:
-		      if (p->ptr[i] == ptr)
-			{
-			    p->type[i] = GML_DYN_NONE;
-			    return;
-			}
-		      break;
-		  };
+		fwd = fwd->next;
+		if (fwd != NULL)
+		    i_fwd = fwd->first;
+	    }
+	  while (bwd != NULL && i_bwd < bwd->first)
+	    {
+		bwd = bwd->prev;
+		if (bwd != NULL)
+		    i_bwd = bwd->index - 1;
+	    }
+	  if (fwd == NULL || bwd == NULL)
+	      return;
+	  if (fwd->type[i_fwd] != GML_DYN_NONE && fwd->ptr[i_fwd] == ptr)
+	    {
+		gmlMapDynRemove (p_data, fwd, i_fwd);
+		return;
+	    }
+	  if (bwd->type[i_bwd] != GML_DYN_NONE && bwd->ptr[i_bwd] == ptr)
+	    {
+		gmlMapDynRemove (p_data, bwd, i_bwd);
+		return;
 	    }
-	  p = p->next;
+	  if (fwd == bwd && i_fwd >= i_bwd)
+	      return;
+	  i_fwd++;
+	  i_bwd--;
       }
 }
 
@@ -415,15 +475,6 @@ gmlCleanMapDynAlloc (struct gml_data *p_data, int clean_all)
 			    gml_free_dyn_polygon ((gmlDynamicPolygonPtr)
 						  (p->ptr[i]));
 			    break;
-			case GML_DYN_NODE:
-			    gml_free_node ((gmlNodePtr) (p->ptr[i]));
-			    break;
-			case GML_DYN_COORD:
-			    gml_free_coord ((gmlCoordPtr) (p->ptr[i]));
-			    break;
-			case GML_DYN_ATTRIB:
-			    gml_free_attrib ((gmlAttrPtr) (p->ptr[i]));
-			    break;
 			};
 		  }
 	    }
@@ -463,36 +514,125 @@ gml_add_polygon_ring (struct gml_data *p_data, gmlDynamicPolygonPtr dyn_pg,
     gmlMapDynClean (p_data, p);
 }
 
+static void *
+gmlArenaAlloc (struct gml_data *p_data, size_t size)
+{
+/* allocating memory from the arena (released all at once) */
+    void *ptr;
+    size_t block_size;
+    struct gml_arena_block *p = p_data->gml_arena;
+    size = (size + 7) & ~((size_t) 7);
+    if (p == NULL || p->used + size > p->size)
+      {
+	  /* adding a further block */
+	  block_size = GML_ARENA_BLOCK;
+	  if (size > block_size)
+	      block_size = size;
+	  p = malloc (sizeof (struct gml_arena_block) + block_size);
+	  if (p == NULL)
+	    {
+		p_data->gml_parse_error = 1;
+		return NULL;
+	    }
+	  p->size = block_size;
+	  p->used = 0;
+	  p->next = p_data->gml_arena;
+	  p_data->gml_arena = p;
+      }
+    ptr = (char *) (p + 1) + p->used;
+    p->used += size;
+    return ptr;
+}
+
+static void *
+gmlArenaItem (struct gml_data *p_data, size_t size)
+{
+/*
+/ allocating a token, node, attribute or coord from the arena
+/
+/ once the arena is out of memory the parse error is set, and the
+/ parser is simply kept busy by a scratch item until the whole tree
+/ is discarded
+*/
+    void *ptr = NULL;
+    if (!(p_data->gml_parse_error))
+	ptr = gmlArenaAlloc (p_data, size);
+    if (ptr == NULL)
+      {
+	  ptr = &(p_data->gml_sink);
+	  memset (ptr, 0, sizeof (p_data->gml_sink));
+      }
+    return ptr;
+}
+
+static char *
+gmlArenaString (struct gml_data *p_data, const char *str, int len)
+{
+/* copying a string into the arena */
+    char *out = gmlArenaAlloc (p_data, len + 1);
+    if (out == NULL)
+      {
+	  p_data->gml_no_string[0] = '\0';
+	  return p_data->gml_no_string;
+      }
+    memcpy (out, str, len);
+    *(out + len) = '\0';
+    return out;
+}
+
+static void
+gmlCleanArena (struct gml_data *p_data)
+{
+/* releasing the arena */
+    struct gml_arena_block *pn;
+    struct gml_arena_block *p = p_data->gml_arena;
+    while (p)
+      {
+	  pn = p->next;
+	  free (p);
+	  p = pn;
+      }
+    p_data->gml_arena = NULL;
+}
+
 static void
 gml_freeString (char **ptr)
 {
 /* releasing a string from the lexer */
-    if (*ptr != NULL)
-	free (*ptr);
     *ptr = NULL;
 }
 
 static void
 gml_saveString (char **ptr, const char *str)
 {
-/* saving a string from the lexer */
-    int len = strlen (str);
-    gml_freeString (ptr);
-    *ptr = malloc (len + 1);
-    strcpy (*ptr, str);
+/*
+/ saving a string from the lexer
+/
+/ the token text stays valid until the next call to yylex(),
+/ and will then be copied into the arena by the caller
+*/
+    *ptr = (char *) str;
+}
+
+static gmlFlexToken *
+gmlArenaToken (struct gml_data *p_data, const char *str)
+{
+/* saving some token into the arena */
+    gmlFlexToken *tok = gmlArenaItem (p_data, sizeof (gmlFlexToken));
+    if (str == NULL)
+	tok->value = NULL;
+    else
+	tok->value = gmlArenaString (p_data, str, strlen (str));
+    return tok;
 }
 
 static gmlCoordPtr
 gml_coord (struct gml_data *p_data, void *value)
 {
-/* creating a coord Item */
-    int len;
+/* creating a coord Item (the token string is already in the arena) */
     gmlFlexToken *tok = (gmlFlexToken *) value;
-    gmlCoordPtr c = malloc (sizeof (gmlCoord));
-    gmlMapDynAlloc (p_data, GML_DYN_COORD, c);
-    len = strlen (tok->value);
-    c->Value = malloc (len + 1);
-    strcpy (c->Value, tok->value);
+    gmlCoordPtr c = gmlArenaItem (p_data, sizeof (gmlCoord));
+    c->Value = tok->value;
     c->Next = NULL;
     return c;
 }
@@ -504,77 +644,31 @@ gml_attribute (struct gml_data *p_data, void *key, void *value)
     int len;
     gmlFlexToken *k_tok = (gmlFlexToken *) key;
     gmlFlexToken *v_tok = (gmlFlexToken *) value;
-    gmlAttrPtr a = malloc (sizeof (gmlAttr));
-    gmlMapDynAlloc (p_data, GML_DYN_ATTRIB, a);
-    len = strlen (k_tok->value);
-    a->Key = malloc (len + 1);
-    strcpy (a->Key, k_tok->value);
+    gmlAttrPtr a = gmlArenaItem (p_data, sizeof (gmlAttr));
+    if (p_data->gml_parse_error)
+	return a;
+    a->Key = k_tok->value;
     len = strlen (v_tok->value);
 /* we need to de-quote the string, removing first and last ".." */
     if (*(v_tok->value + 0) == '"' && *(v_tok->value + len - 1) == '"')
-      {
-	  int bytesToCopy = len - 2;
-	  char *startingPointForCopy = v_tok->value + 1;
-	  a->Value = malloc (bytesToCopy + 1);
-	  memcpy (a->Value, startingPointForCopy, bytesToCopy);
-	  *(a->Value + bytesToCopy) = '\0';
-      }
+	a->Value = gmlArenaString (p_data, v_tok->value + 1, len - 2);
     else
-      {
-	  a->Value = malloc (len + 1);
-	  strcpy (a->Value, v_tok->value);
-      }
+	a->Value = v_tok->value;
     a->Next = NULL;
     return a;
 }
 
-static void
-gml_freeTree (struct gml_data *p_data, gmlNodePtr t)
-{
-/* deleting a GML tree */
-    gmlNodePtr n;
-    gmlNodePtr nn;
-    n = t;
-    while (n)
-      {
-	  nn = n->Next;
-	  gmlMapDynClean (p_data, n);
-	  gml_free_node (n);
-	  n = nn;
-      }
-}
-
 static gmlNodePtr
 gml_createNode (struct gml_data *p_data, void *tag, void *attributes,
 		void *coords)
 {
 /* creating a node */
-    gmlAttrPtr a;
-    gmlCoordPtr c;
-    int len;
     gmlFlexToken *tok = (gmlFlexToken *) tag;
-    gmlNodePtr n = malloc (sizeof (gmlNode));
-    gmlMapDynAlloc (p_data, GML_DYN_NODE, n);
-    len = strlen (tok->value);
-    n->Tag = malloc (len + 1);
-    strcpy (n->Tag, tok->value);
+    gmlNodePtr n = gmlArenaItem (p_data, sizeof (gmlNode));
+    n->Tag = tok->value;
     n->Type = GML_PARSER_OPEN_NODE;
     n->Error = 0;
-    a = (gmlAttrPtr) attributes;
-    while (a)
-      {
-	  /* transferring ownership of attributes */
-	  gmlMapDynClean (p_data, a);
-	  a = a->Next;
-      }
     n->Attributes = attributes;
-    c = (gmlCoordPtr) coords;
-    while (c)
-      {
-	  /* transferring ownership of attributes */
-	  gmlMapDynClean (p_data, c);
-	  c = c->Next;
-      }
     n->Coordinates = coords;
     n->Next = NULL;
     return n;
@@ -584,23 +678,11 @@ static gmlNodePtr
 gml_createSelfClosedNode (struct gml_data *p_data, void *tag, void *attributes)
 {
 /* creating a self-closed node */
-    gmlAttrPtr a;
-    int len;
     gmlFlexToken *tok = (gmlFlexToken *) tag;
-    gmlNodePtr n = malloc (sizeof (gmlNode));
-    gmlMapDynAlloc (p_data, GML_DYN_NODE, n);
-    len = strlen (tok->value);
-    n->Tag = malloc (len + 1);
-    strcpy (n->Tag, tok->value);
+    gmlNodePtr n = gmlArenaItem (p_data, sizeof (gmlNode));
+    n->Tag = tok->value;
     n->Type = GML_PARSER_SELF_CLOSED_NODE;
     n->Error = 0;
-    a = (gmlAttrPtr) attributes;
-    while (a)
-      {
-	  /* transferring ownership of attributes */
-	  gmlMapDynClean (p_data, a);
-	  a = a->Next;
-      }
     n->Attributes = attributes;
     n->Coordinates = NULL;
     n->Next = NULL;
@@ -611,13 +693,9 @@ static gmlNodePtr
 gml_closingNode (struct gml_data *p_data, void *tag)
 {
 /* creating a closing node */
-    int len;
     gmlFlexToken *tok = (gmlFlexToken *) tag;
-    gmlNodePtr n = malloc (sizeof (gmlNode));
-    gmlMapDynAlloc (p_data, GML_DYN_NODE, n);
-    len = strlen (tok->value);
-    n->Tag = malloc (len + 1);
-    strcpy (n->Tag, tok->value);
+    gmlNodePtr n = gmlArenaItem (p_data, sizeof (gmlNode));
+    n->Tag = tok->value;
     n->Type = GML_PARSER_CLOSED_NODE;
     n->Error = 0;
     n->Attributes = NULL;
@@ -626,40 +704,6 @@ gml_closingNode (struct gml_data *p_data, void *tag)
     return n;
 }
 
-static int
-gml_cleanup (gmlFlexToken * token)
-{
-    gmlFlexToken *ptok;
-    gmlFlexToken *ptok_n;
-    if (token == NULL)
-	return 0;
-    ptok = token;
-    while (ptok)
-      {
-	  ptok_n = ptok->Next;
-	  if (ptok->value != NULL)
-	      free (ptok->value);
-	  free (ptok);
-	  ptok = ptok_n;
-      }
-    return 0;
-}
-
-static void
-gml_xferString (char **p, const char *str)
-{
-/* saving some token */
-    int len;
-    if (str == NULL)
-      {
-	  *p = NULL;
-	  return;
-      }
-    len = strlen (str);
-    *p = malloc (len + 1);
-    strcpy (*p, str);
-}
-
 static int
 guessGmlSrid (gmlNodePtr node)
 {
@@ -3480,19 +3524,73 @@ gml_build_geometry (const void *cache, struct gml_data *p_data, gmlNodePtr tree,
 
 
 
+struct gml_parser
+{
+/* a reusable Lemon parser and Flex scanner (one for each connection) */
+    void *lemon;
+    yyscan_t scanner;
+    int busy;
+};
+
+static void
+gml_reset_lemon (void *p)
+{
+/* resetting a Lemon parser to its initial state, so to be reused */
+    yyParser *pParser = (yyParser *) p;
+    while (pParser->yyidx >= 0)
+	yy_pop_parser_stack (pParser);
+}
+
+static struct gml_parser *
+gml_get_parser (const void *p_cache)
+{
+/* returning the reusable GML parser of this connection */
+    struct gml_parser *parser;
+    struct splite_internal_cache *cache =
+	(struct splite_internal_cache *) p_cache;
+    if (cache == NULL)
+	return NULL;
+    if (cache->magic1 != SPATIALITE_CACHE_MAGIC1
+	|| cache->magic2 != SPATIALITE_CACHE_MAGIC2)
+	return NULL;
+    parser = (struct gml_parser *) (cache->gml_parser);
+    if (parser == NULL)
+      {
+	  /* lazily creating the parser on first use */
+	  parser = malloc (sizeof (struct gml_parser));
+	  parser->lemon = ParseAlloc (malloc);
+	  Gmllex_init_extra (NULL, &(parser->scanner));
+	  parser->busy = 0;
+	  cache->gml_parser = parser;
+      }
+    if (parser->busy)
+	return NULL;
+    return parser;
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlParserDestroy (void *p)
+{
+/* memory cleanup - destroying a reusable GML parser */
+    struct gml_parser *parser = (struct gml_parser *) p;
+    if (parser == NULL)
+	return;
+    ParseFree (parser->lemon, free);
+    Gmllex_destroy (parser->scanner);
+    free (parser);
+}
+
 static gaiaGeomCollPtr
 gaiaParseGmlCommon (const void *cache, const unsigned char *dirty_buffer,
 		    sqlite3 * sqlite_handle)
 {
-    void *pParser = ParseAlloc (malloc);
-    /* Linked-list of token values */
-    gmlFlexToken *tokens = malloc (sizeof (gmlFlexToken));
-    /* Pointer to the head of the list */
-    gmlFlexToken *head = tokens;
+    void *pParser;
     int yv;
     gaiaGeomCollPtr geom = NULL;
     yyscan_t scanner;
+    YY_BUFFER_STATE buffer;
     struct gml_data str_data;
+    struct gml_parser *parser = gml_get_parser (cache);
 
 /* initializing the helper structs */
     str_data.gml_line = 1;
@@ -3500,15 +3598,26 @@ gaiaParseGmlCommon (const void *cache, const unsigned char *dirty_buffer,
     str_data.gml_parse_error = 0;
     str_data.gml_first_dyn_block = NULL;
     str_data.gml_last_dyn_block = NULL;
+    str_data.gml_arena = NULL;
     str_data.result = NULL;
 
-/* initializing the scanner state */
-    Gmllex_init_extra (&str_data, &scanner);
+/* initializing the parser and scanner state */
+    if (parser != NULL)
+      {
+	  /* reusing the connection's own parser */
+	  parser->busy = 1;
+	  pParser = parser->lemon;
+	  scanner = parser->scanner;
+	  Gmlset_extra (&str_data, scanner);
+      }
+    else
+      {
+	  pParser = ParseAlloc (malloc);
+	  Gmllex_init_extra (&str_data, &scanner);
+      }
 
     str_data.GmlLval.pval = NULL;
-    tokens->value = NULL;
-    tokens->Next = NULL;
-    Gml_scan_string ((char *) dirty_buffer, scanner);
+    buffer = Gml_scan_string ((char *) dirty_buffer, scanner);
 
     /*
        / Keep tokenizing until we reach the end
@@ -3521,50 +3630,47 @@ gaiaParseGmlCommon (const void *cache, const unsigned char *dirty_buffer,
 		str_data.gml_parse_error = 1;
 		break;
 	    }
-	  tokens->Next = malloc (sizeof (gmlFlexToken));
-	  tokens->Next->Next = NULL;
-	  gml_xferString (&(tokens->Next->value), str_data.GmlLval.pval);
 	  /* Pass the token to the wkt parser created from lemon */
-	  Parse (pParser, yv, &(tokens->Next->value), &str_data);
-	  tokens = tokens->Next;
+	  Parse (pParser, yv, gmlArenaToken (&str_data, str_data.GmlLval.pval),
+		 &str_data);
+	  if (str_data.gml_parse_error)
+	      break;
       }
     /* This denotes the end of a line as well as the end of the parser */
     Parse (pParser, GML_NEWLINE, 0, &str_data);
-    ParseFree (pParser, free);
-    Gmllex_destroy (scanner);
-
-    /* Assigning the token as the end to avoid seg faults while cleaning */
-    tokens->Next = NULL;
-    gml_cleanup (head);
+    Gml_delete_buffer (buffer, scanner);
+    if (parser != NULL)
+      {
+	  gml_reset_lemon (pParser);
+	  parser->busy = 0;
+      }
+    else
+      {
+	  ParseFree (pParser, free);
+	  Gmllex_destroy (scanner);
+      }
     gml_freeString (&(str_data.GmlLval.pval));
 
     if (str_data.gml_parse_error)
       {
-	  if (str_data.result)
-	    {
-		/* if a Geometry-result has been produced, the stack is already cleaned */
-		gml_freeTree (&str_data, str_data.result);
-		gmlCleanMapDynAlloc (&str_data, 0);
-	    }
-	  else
-	    {
-		/* otherwise we are required to clean the stack */
-		gmlCleanMapDynAlloc (&str_data, 1);
-	    }
+	  /* nodes are all released together with the arena */
+	  gmlCleanMapDynAlloc (&str_data, str_data.result ? 0 : 1);
+	  gmlCleanArena (&str_data);
 	  return NULL;
       }
 
     if (str_data.result == NULL)
       {
 	  gmlCleanMapDynAlloc (&str_data, 0);
+	  gmlCleanArena (&str_data);
 	  return NULL;
       }
 
     /* attempting to build a geometry from GML */
     geom =
 	gml_build_geometry (cache, &str_data, str_data.result, sqlite_handle);
-    gml_freeTree (&str_data, str_data.result);
     gmlCleanMapDynAlloc (&str_data, 0);
+    gmlCleanArena (&str_data);
     return geom;
 }
 
@@ -3581,6 +3687,246 @@ gaiaParseGml_r (const void *p_cache, const unsigned char *dirty_buffer,
     return gaiaParseGmlCommon (p_cache, dirty_buffer, sqlite_handle);
 }
 
+struct gml_nodes_builder
+{
+/* a GML nodes chain directly fed by some external XML parser */
+    gmlNodePtr first;
+    gmlNodePtr last;
+    int error;
+};
+
+static char *
+gml_nodes_name (const char *prefix, const char *name)
+{
+/* building a (possibly qualified) Tag or Key */
+    int len;
+    char *str;
+    if (name == NULL)
+	name = "";
+    if (prefix == NULL)
+      {
+	  len = strlen (name);
+	  str = malloc (len + 1);
+	  strcpy (str, name);
+	  return str;
+      }
+    len = strlen (prefix) + strlen (name) + 1;
+    str = malloc (len + 1);
+    sprintf (str, "%s:%s", prefix, name);
+    return str;
+}
+
+static void
+gml_nodes_append (struct gml_nodes_builder *p, const char *prefix,
+		  const char *name, int type)
+{
+/* appending a further node into the chain */
+    gmlNodePtr n = malloc (sizeof (gmlNode));
+    n->Tag = gml_nodes_name (prefix, name);
+    n->Type = type;
+    n->Error = 0;
+    n->Attributes = NULL;
+    n->Coordinates = NULL;
+    n->Next = NULL;
+    if (p->first == NULL)
+	p->first = n;
+    if (p->last != NULL)
+	p->last->Next = n;
+    p->last = n;
+}
+
+SPATIALITE_PRIVATE void *
+gaiaGmlNodesCreate (void)
+{
+/* creating an empty GML nodes builder */
+    struct gml_nodes_builder *p = malloc (sizeof (struct gml_nodes_builder));
+    p->first = NULL;
+    p->last = NULL;
+    p->error = 0;
+    return p;
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlNodesReset (void *builder)
+{
+/* resetting a GML nodes builder to its initial empty state */
+    gmlNodePtr n;
+    gmlNodePtr nn;
+    struct gml_nodes_builder *p = (struct gml_nodes_builder *) builder;
+    if (p == NULL)
+	return;
+    n = p->first;
+    while (n)
+      {
+	  nn = n->Next;
+	  gml_free_node (n);
+	  n = nn;
+      }
+    p->first = NULL;
+    p->last = NULL;
+    p->error = 0;
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlNodesDestroy (void *builder)
+{
+/* memory cleanup - destroying a GML nodes builder */
+    if (builder == NULL)
+	return;
+    gaiaGmlNodesReset (builder);
+    free (builder);
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlNodesOpenTag (void *builder, const char *prefix, const char *name,
+		     int self_closed)
+{
+/* appending an opening (or self-closed) node */
+    struct gml_nodes_builder *p = (struct gml_nodes_builder *) builder;
+    if (p->error)
+	return;
+    gml_nodes_append (p, prefix, name,
+		      self_closed ? GML_PARSER_SELF_CLOSED_NODE :
+		      GML_PARSER_OPEN_NODE);
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlNodesAttribute (void *builder, const char *prefix, const char *name,
+		       const char *value)
+{
+/* adding an attribute to the latest opening node */
+    int len;
+    gmlAttrPtr a;
+    gmlAttrPtr last;
+    struct gml_nodes_builder *p = (struct gml_nodes_builder *) builder;
+    if (p->error)
+	return;
+    if (p->last == NULL || p->last->Type == GML_PARSER_CLOSED_NODE)
+      {
+	  p->error = 1;
+	  return;
+      }
+    if (value == NULL)
+	value = "";
+    a = malloc (sizeof (gmlAttr));
+    a->Key = gml_nodes_name (prefix, name);
+    len = strlen (value);
+    a->Value = malloc (len + 1);
+    strcpy (a->Value, value);
+    a->Next = NULL;
+    last = p->last->Attributes;
+    if (last == NULL)
+	p->last->Attributes = a;
+    else
+      {
+	  while (last->Next != NULL)
+	      last = last->Next;
+	  last->Next = a;
+      }
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlNodesCoordinates (void *builder, const char *text)
+{
+/* splitting a text value into coordinate tokens, just as the lexer does */
+    const char *p_in;
+    const char *start;
+    gmlCoordPtr c;
+    gmlCoordPtr last = NULL;
+    struct gml_nodes_builder *p = (struct gml_nodes_builder *) builder;
+    if (p->error)
+	return;
+    if (p->last == NULL || p->last->Type != GML_PARSER_OPEN_NODE
+	|| p->last->Coordinates != NULL)
+      {
+	  p->error = 1;
+	  return;
+      }
+    p_in = text;
+    while (*p_in != '\0')
+      {
+	  if (*p_in == ' ' || *p_in == '\t' || *p_in == '\n' || *p_in == '\r')
+	    {
+		p_in++;
+		continue;
+	    }
+	  start = p_in;
+	  while (*p_in != '\0' && *p_in != ' ' && *p_in != '\t'
+		 && *p_in != '\n' && *p_in != '\r')
+	    {
+		if ((*p_in >= '0' && *p_in <= '9') || *p_in == ','
+		    || *p_in == '.' || *p_in == '+' || *p_in == '-')
+		    ;
+		else
+		  {
+		      /* not a valid GML coordinate */
+		      p->error = 1;
+		      return;
+		  }
+		p_in++;
+	    }
+	  c = malloc (sizeof (gmlCoord));
+	  c->Value = malloc (p_in - start + 1);
+	  memcpy (c->Value, start, p_in - start);
+	  *(c->Value + (p_in - start)) = '\0';
+	  c->Next = NULL;
+	  if (last == NULL)
+	      p->last->Coordinates = c;
+	  else
+	      last->Next = c;
+	  last = c;
+      }
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlNodesCloseTag (void *builder, const char *prefix, const char *name)
+{
+/* appending a closing node */
+    struct gml_nodes_builder *p = (struct gml_nodes_builder *) builder;
+    if (p->error)
+	return;
+    gml_nodes_append (p, prefix, name, GML_PARSER_CLOSED_NODE);
+}
+
+SPATIALITE_PRIVATE void
+gaiaGmlNodesSetError (void *builder)
+{
+/* marking the current GML nodes chain as invalid */
+    struct gml_nodes_builder *p = (struct gml_nodes_builder *) builder;
+    p->error = 1;
+}
+
+SPATIALITE_PRIVATE void *
+gaiaGmlNodesBuild (const void *p_cache, void *builder,
+		   const void *sqlite_handle)
+{
+/*
+/ attempting to build a geometry from a GML nodes chain
+/ [no text serialization and no lexing/parsing at all]
+*/
+    gaiaGeomCollPtr geom;
+    struct gml_data str_data;
+    struct gml_nodes_builder *p = (struct gml_nodes_builder *) builder;
+    if (p == NULL)
+	return NULL;
+    if (p->error || p->first == NULL)
+	return NULL;
+
+    str_data.gml_line = 1;
+    str_data.gml_col = 1;
+    str_data.gml_parse_error = 0;
+    str_data.gml_first_dyn_block = NULL;
+    str_data.gml_last_dyn_block = NULL;
+    str_data.gml_arena = NULL;
+    str_data.result = NULL;
+    str_data.GmlLval.pval = NULL;
+    geom =
+	gml_build_geometry (p_cache, &str_data, p->first,
+			    (sqlite3 *) sqlite_handle);
+    gmlCleanMapDynAlloc (&str_data, 0);
+    return geom;
+}
+
 
 /*
 ** CAVEAT: we must now undefine any Lemon/Flex own macro
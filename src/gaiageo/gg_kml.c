@@ -58,6 +58,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <spatialite/debug.h>
 
 #include <spatialite/gaiageo.h>
+#include <spatialite_private.h>
 
 #if defined(_WIN32) || defined(WIN32)
 #include <io.h>
@@ -83,12 +84,11 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #define KML_DYN_DYNLINE	1
 #define KML_DYN_GEOM	2
 #define KML_DYN_DYNPG	3
-#define KML_DYN_NODE	4
-#define KML_DYN_COORD	5
-#define KML_DYN_ATTRIB	6
 
 #define KML_DYN_BLOCK 1024
 
+#define KML_ARENA_BLOCK	65536
+
 
 
 /*
@@ -165,12 +165,11 @@ typedef union
 
 
 /*
-** This is a linked-list struct to store all the values for each token.
+** This struct stores the value of each token (allocated from the arena).
 */
 typedef struct kmlFlexTokenStruct
 {
     char *value;
-    struct kmlFlexTokenStruct *Next;
 } kmlFlexToken;
 
 typedef struct kml_coord
@@ -225,6 +224,14 @@ struct kml_dyn_block
     struct kml_dyn_block *next;
 };
 
+struct kml_arena_block
+{
+/* a memory block for tokens, nodes, attributes and coords */
+    size_t size;
+    size_t used;
+    struct kml_arena_block *next;
+};
+
 struct kml_data
 {
 /* a struct used to make the lexer-parser reentrant and thread-safe */
@@ -233,8 +240,17 @@ struct kml_data
     int kml_col;
     struct kml_dyn_block *kml_first_dyn_block;
     struct kml_dyn_block *kml_last_dyn_block;
+    struct kml_arena_block *kml_arena;
     kmlNodePtr result;
     YYSTYPE KmlLval;
+    union
+    {
+	kmlFlexToken token;
+	kmlCoord coord;
+	kmlAttr attr;
+	kmlNode node;
+    } kml_sink;			/* handed out once the arena is out of memory */
+    char kml_no_string[1];
 };
 
 static struct kml_dyn_block *
@@ -278,36 +294,6 @@ kmlMapDynAlloc (struct kml_data *p_data, int type, void *ptr)
     p_data->kml_last_dyn_block->index++;
 }
 
-static void
-kmlMapDynClean (struct kml_data *p_data, void *ptr)
-{
-/* deleting a dynamic allocation from the map */
-    int i;
-    struct kml_dyn_block *p = p_data->kml_first_dyn_block;
-    while (p)
-      {
-	  for (i = 0; i < KML_DYN_BLOCK; i++)
-	    {
-		switch (p->type[i])
-		  {
-		  case KML_DYN_DYNLINE:
-		  case KML_DYN_GEOM:
-		  case KML_DYN_DYNPG:
-		  case KML_DYN_NODE:
-		  case KML_DYN_COORD:
-		  case KML_DYN_ATTRIB:
-		      if (p->ptr[i] == ptr)
-			{
-			    p->type[i] = KML_DYN_NONE;
-			    return;
-			}
-		      break;
-		  };
-	    }
-	  p = p->next;
-      }
-}
-
 static void
 kml_free_dyn_polygon (kmlDynamicPolygonPtr dyn)
 {
@@ -328,59 +314,6 @@ kml_free_dyn_polygon (kmlDynamicPolygonPtr dyn)
     free (dyn);
 }
 
-static void
-kml_free_coord (kmlCoordPtr c)
-{
-/* deleting a KML coordinate */
-    if (c == NULL)
-	return;
-    if (c->Value)
-	free (c->Value);
-    free (c);
-}
-
-static void
-kml_free_attrib (kmlAttrPtr a)
-{
-/* deleting a KML attribute */
-    if (a == NULL)
-	return;
-    if (a->Key)
-	free (a->Key);
-    if (a->Value)
-	free (a->Value);
-    free (a);
-}
-
-static void
-kml_free_node (kmlNodePtr n)
-{
-/* deleting a KML node */
-    kmlAttrPtr a;
-    kmlAttrPtr an;
-    kmlCoordPtr c;
-    kmlCoordPtr cn;
-    if (n == NULL)
-	return;
-    a = n->Attributes;
-    while (a)
-      {
-	  an = a->Next;
-	  kml_free_attrib (a);
-	  a = an;
-      }
-    c = n->Coordinates;
-    while (c)
-      {
-	  cn = c->Next;
-	  kml_free_coord (c);
-	  c = cn;
-      }
-    if (n->Tag)
-	free (n->Tag);
-    free (n);
-}
-
 static void
 kmlCleanMapDynAlloc (struct kml_data *p_data, int clean_all)
 {
@@ -408,15 +341,6 @@ kmlCleanMapDynAlloc (struct kml_data *p_data, int clean_all)
 			    kml_free_dyn_polygon ((kmlDynamicPolygonPtr)
 						  (p->ptr[i]));
 			    break;
-			case KML_DYN_NODE:
-			    kml_free_node ((kmlNodePtr) (p->ptr[i]));
-			    break;
-			case KML_DYN_COORD:
-			    kml_free_coord ((kmlCoordPtr) (p->ptr[i]));
-			    break;
-			case KML_DYN_ATTRIB:
-			    kml_free_attrib ((kmlAttrPtr) (p->ptr[i]));
-			    break;
 			};
 		  }
 	    }
@@ -455,36 +379,125 @@ kml_add_polygon_ring (kmlDynamicPolygonPtr dyn_pg, gaiaDynamicLinePtr dyn,
     dyn_pg->last = p;
 }
 
+static void *
+kmlArenaAlloc (struct kml_data *p_data, size_t size)
+{
+/* allocating memory from the arena (released all at once) */
+    void *ptr;
+    size_t block_size;
+    struct kml_arena_block *p = p_data->kml_arena;
+    size = (size + 7) & ~((size_t) 7);
+    if (p == NULL || p->used + size > p->size)
+      {
+	  /* adding a further block */
+	  block_size = KML_ARENA_BLOCK;
+	  if (size > block_size)
+	      block_size = size;
+	  p = malloc (sizeof (struct kml_arena_block) + block_size);
+	  if (p == NULL)
+	    {
+		p_data->kml_parse_error = 1;
+		return NULL;
+	    }
+	  p->size = block_size;
+	  p->used = 0;
+	  p->next = p_data->kml_arena;
+	  p_data->kml_arena = p;
+      }
+    ptr = (char *) (p + 1) + p->used;
+    p->used += size;
+    return ptr;
+}
+
+static void *
+kmlArenaItem (struct kml_data *p_data, size_t size)
+{
+/*
+/ allocating a token, node, attribute or coord from the arena
+/
+/ once the arena is out of memory the parse error is set, and the
+/ parser is simply kept busy by a scratch item until the whole tree
+/ is discarded
+*/
+    void *ptr = NULL;
+    if (!(p_data->kml_parse_error))
+	ptr = kmlArenaAlloc (p_data, size);
+    if (ptr == NULL)
+      {
+	  ptr = &(p_data->kml_sink);
+	  memset (ptr, 0, sizeof (p_data->kml_sink));
+      }
+    return ptr;
+}
+
+static char *
+kmlArenaString (struct kml_data *p_data, const char *str, int len)
+{
+/* copying a string into the arena */
+    char *out = kmlArenaAlloc (p_data, len + 1);
+    if (out == NULL)
+      {
+	  p_data->kml_no_string[0] = '\0';
+	  return p_data->kml_no_string;
+      }
+    memcpy (out, str, len);
+    *(out + len) = '\0';
+    return out;
+}
+
+static void
+kmlCleanArena (struct kml_data *p_data)
+{
+/* releasing the arena */
+    struct kml_arena_block *pn;
+    struct kml_arena_block *p = p_data->kml_arena;
+    while (p)
+      {
+	  pn = p->next;
+	  free (p);
+	  p = pn;
+      }
+    p_data->kml_arena = NULL;
+}
+
 static void
 kml_freeString (char **ptr)
 {
 /* releasing a string from the lexer */
-    if (*ptr != NULL)
-	free (*ptr);
     *ptr = NULL;
 }
 
 static void
 kml_saveString (char **ptr, const char *str)
 {
-/* saving a string from the lexer */
-    int len = strlen (str);
-    kml_freeString (ptr);
-    *ptr = malloc (len + 1);
-    strcpy (*ptr, str);
+/*
+/ saving a string from the lexer
+/
+/ the token text stays valid until the next call to yylex(),
+/ and will then be copied into the arena by the caller
+*/
+    *ptr = (char *) str;
+}
+
+static kmlFlexToken *
+kmlArenaToken (struct kml_data *p_data, const char *str)
+{
+/* saving some token into the arena */
+    kmlFlexToken *tok = kmlArenaItem (p_data, sizeof (kmlFlexToken));
+    if (str == NULL)
+	tok->value = NULL;
+    else
+	tok->value = kmlArenaString (p_data, str, strlen (str));
+    return tok;
 }
 
 static kmlCoordPtr
 kml_coord (struct kml_data *p_data, void *value)
 {
-/* creating a coord Item */
-    int len;
+/* creating a coord Item (the token string is already in the arena) */
     kmlFlexToken *tok = (kmlFlexToken *) value;
-    kmlCoordPtr c = malloc (sizeof (kmlCoord));
-    kmlMapDynAlloc (p_data, KML_DYN_COORD, c);
-    len = strlen (tok->value);
-    c->Value = malloc (len + 1);
-    strcpy (c->Value, tok->value);
+    kmlCoordPtr c = kmlArenaItem (p_data, sizeof (kmlCoord));
+    c->Value = tok->value;
     c->Next = NULL;
     return c;
 }
@@ -496,74 +509,31 @@ kml_attribute (struct kml_data *p_data, void *key, void *value)
     int len;
     kmlFlexToken *k_tok = (kmlFlexToken *) key;
     kmlFlexToken *v_tok = (kmlFlexToken *) value;
-    kmlAttrPtr a = malloc (sizeof (kmlAttr));
-    kmlMapDynAlloc (p_data, KML_DYN_ATTRIB, a);
-    len = strlen (k_tok->value);
-    a->Key = malloc (len + 1);
-    strcpy (a->Key, k_tok->value);
+    kmlAttrPtr a = kmlArenaItem (p_data, sizeof (kmlAttr));
+    if (p_data->kml_parse_error)
+	return a;
+    a->Key = k_tok->value;
     len = strlen (v_tok->value);
 /* we need to de-quote the string, removing first and last ".." */
     if (*(v_tok->value + 0) == '"' && *(v_tok->value + len - 1) == '"')
-      {
-	  a->Value = malloc (len - 1);
-	  memcpy (a->Value, v_tok->value + 1, len - 1);
-	  *(a->Value + len - 1) = '\0';
-      }
+	a->Value = kmlArenaString (p_data, v_tok->value + 1, len - 2);
     else
-      {
-	  a->Value = malloc (len + 1);
-	  strcpy (a->Value, v_tok->value);
-      }
+	a->Value = v_tok->value;
     a->Next = NULL;
     return a;
 }
 
-static void
-kml_freeTree (kmlNodePtr t)
-{
-/* deleting a KML tree */
-    kmlNodePtr n;
-    kmlNodePtr nn;
-    n = t;
-    while (n)
-      {
-	  nn = n->Next;
-	  kml_free_node (n);
-	  n = nn;
-      }
-}
-
 static kmlNodePtr
 kml_createNode (struct kml_data *p_data, void *tag, void *attributes,
 		void *coords)
 {
 /* creating a node */
-    kmlAttrPtr a;
-    kmlCoordPtr c;
-    int len;
     kmlFlexToken *tok = (kmlFlexToken *) tag;
-    kmlNodePtr n = malloc (sizeof (kmlNode));
-    kmlMapDynAlloc (p_data, KML_DYN_NODE, n);
-    len = strlen (tok->value);
-    n->Tag = malloc (len + 1);
-    strcpy (n->Tag, tok->value);
+    kmlNodePtr n = kmlArenaItem (p_data, sizeof (kmlNode));
+    n->Tag = tok->value;
     n->Type = KML_PARSER_OPEN_NODE;
     n->Error = 0;
-    a = (kmlAttrPtr) attributes;
-    while (a)
-      {
-	  /* transferring ownership of attributes */
-	  kmlMapDynClean (p_data, a);
-	  a = a->Next;
-      }
     n->Attributes = attributes;
-    c = (kmlCoordPtr) coords;
-    while (c)
-      {
-	  /* transferring ownership of attributes */
-	  kmlMapDynClean (p_data, c);
-	  c = c->Next;
-      }
     n->Coordinates = coords;
     n->Next = NULL;
     return n;
@@ -573,23 +543,11 @@ static kmlNodePtr
 kml_createSelfClosedNode (struct kml_data *p_data, void *tag, void *attributes)
 {
 /* creating a self-closed node */
-    kmlAttrPtr a;
-    int len;
     kmlFlexToken *tok = (kmlFlexToken *) tag;
-    kmlNodePtr n = malloc (sizeof (kmlNode));
-    kmlMapDynAlloc (p_data, KML_DYN_NODE, n);
-    len = strlen (tok->value);
-    n->Tag = malloc (len + 1);
-    strcpy (n->Tag, tok->value);
+    kmlNodePtr n = kmlArenaItem (p_data, sizeof (kmlNode));
+    n->Tag = tok->value;
     n->Type = KML_PARSER_SELF_CLOSED_NODE;
     n->Error = 0;
-    a = (kmlAttrPtr) attributes;
-    while (a)
-      {
-	  /* transferring ownership of attributes */
-	  kmlMapDynClean (p_data, a);
-	  a = a->Next;
-      }
     n->Attributes = attributes;
     n->Coordinates = NULL;
     n->Next = NULL;
@@ -600,13 +558,9 @@ static kmlNodePtr
 kml_closingNode (struct kml_data *p_data, void *tag)
 {
 /* creating a closing node */
-    int len;
     kmlFlexToken *tok = (kmlFlexToken *) tag;
-    kmlNodePtr n = malloc (sizeof (kmlNode));
-    kmlMapDynAlloc (p_data, KML_DYN_NODE, n);
-    len = strlen (tok->value);
-    n->Tag = malloc (len + 1);
-    strcpy (n->Tag, tok->value);
+    kmlNodePtr n = kmlArenaItem (p_data, sizeof (kmlNode));
+    n->Tag = tok->value;
     n->Type = KML_PARSER_CLOSED_NODE;
     n->Error = 0;
     n->Attributes = NULL;
@@ -615,40 +569,6 @@ kml_closingNode (struct kml_data *p_data, void *tag)
     return n;
 }
 
-static int
-kml_cleanup (kmlFlexToken * token)
-{
-    kmlFlexToken *ptok;
-    kmlFlexToken *ptok_n;
-    if (token == NULL)
-	return 0;
-    ptok = token;
-    while (ptok)
-      {
-	  ptok_n = ptok->Next;
-	  if (ptok->value != NULL)
-	      free (ptok->value);
-	  free (ptok);
-	  ptok = ptok_n;
-      }
-    return 0;
-}
-
-static void
-kml_xferString (char **p, const char *str)
-{
-/* saving some token */
-    int len;
-    if (str == NULL)
-      {
-	  *p = NULL;
-	  return;
-      }
-    len = strlen (str);
-    *p = malloc (len + 1);
-    strcpy (*p, str);
-}
-
 static int
 guessKmlGeometryType (kmlNodePtr node)
 {
@@ -1925,17 +1845,70 @@ kml_build_geometry (struct kml_data *p_data, kmlNodePtr tree)
 
 
 
-gaiaGeomCollPtr
-gaiaParseKml (const unsigned char *dirty_buffer)
+struct kml_parser
+{
+/* a reusable Lemon parser and Flex scanner (one for each connection) */
+    void *lemon;
+    yyscan_t scanner;
+    int busy;
+};
+
+static void
+kml_reset_lemon (void *p)
 {
-    void *pParser = ParseAlloc (malloc);
-    /* Linked-list of token values */
-    kmlFlexToken *tokens = malloc (sizeof (kmlFlexToken));
-    /* Pointer to the head of the list */
-    kmlFlexToken *head = tokens;
+/* resetting a Lemon parser to its initial state, so to be reused */
+    yyParser *pParser = (yyParser *) p;
+    while (pParser->yyidx >= 0)
+	yy_pop_parser_stack (pParser);
+}
+
+static struct kml_parser *
+kml_get_parser (const void *p_cache)
+{
+/* returning the reusable KML parser of this connection */
+    struct kml_parser *parser;
+    struct splite_internal_cache *cache =
+	(struct splite_internal_cache *) p_cache;
+    if (cache == NULL)
+	return NULL;
+    if (cache->magic1 != SPATIALITE_CACHE_MAGIC1
+	|| cache->magic2 != SPATIALITE_CACHE_MAGIC2)
+	return NULL;
+    parser = (struct kml_parser *) (cache->kml_parser);
+    if (parser == NULL)
+      {
+	  /* lazily creating the parser on first use */
+	  parser = malloc (sizeof (struct kml_parser));
+	  parser->lemon = ParseAlloc (malloc);
+	  Kmllex_init_extra (NULL, &(parser->scanner));
+	  parser->busy = 0;
+	  cache->kml_parser = parser;
+      }
+    if (parser->busy)
+	return NULL;
+    return parser;
+}
+
+SPATIALITE_PRIVATE void
+gaiaKmlParserDestroy (void *p)
+{
+/* memory cleanup - destroying a reusable KML parser */
+    struct kml_parser *parser = (struct kml_parser *) p;
+    if (parser == NULL)
+	return;
+    ParseFree (parser->lemon, free);
+    Kmllex_destroy (parser->scanner);
+    free (parser);
+}
+
+static gaiaGeomCollPtr
+kml_parse (struct kml_parser *parser, const unsigned char *dirty_buffer)
+{
+    void *pParser;
     int yv;
     gaiaGeomCollPtr geom = NULL;
     yyscan_t scanner;
+    YY_BUFFER_STATE buffer;
     struct kml_data str_data;
 
 /* initializing the helper structs */
@@ -1944,15 +1917,26 @@ gaiaParseKml (const unsigned char *dirty_buffer)
     str_data.kml_parse_error = 0;
     str_data.kml_first_dyn_block = NULL;
     str_data.kml_last_dyn_block = NULL;
+    str_data.kml_arena = NULL;
     str_data.result = NULL;
 
-/* initializing the scanner state */
-    Kmllex_init_extra (&str_data, &scanner);
+/* initializing the parser and scanner state */
+    if (parser != NULL)
+      {
+	  /* reusing the connection's own parser */
+	  parser->busy = 1;
+	  pParser = parser->lemon;
+	  scanner = parser->scanner;
+	  Kmlset_extra (&str_data, scanner);
+      }
+    else
+      {
+	  pParser = ParseAlloc (malloc);
+	  Kmllex_init_extra (&str_data, &scanner);
+      }
 
     str_data.KmlLval.pval = NULL;
-    tokens->value = NULL;
-    tokens->Next = NULL;
-    Kml_scan_string ((char *) dirty_buffer, scanner);
+    buffer = Kml_scan_string ((char *) dirty_buffer, scanner);
 
     /*
        / Keep tokenizing until we reach the end
@@ -1965,53 +1949,63 @@ gaiaParseKml (const unsigned char *dirty_buffer)
 		str_data.kml_parse_error = 1;
 		break;
 	    }
-	  tokens->Next = malloc (sizeof (kmlFlexToken));
-	  tokens->Next->Next = NULL;
-	  kml_xferString (&(tokens->Next->value), str_data.KmlLval.pval);
 	  /* Pass the token to the wkt parser created from lemon */
-	  Parse (pParser, yv, &(tokens->Next->value), &str_data);
-	  tokens = tokens->Next;
+	  Parse (pParser, yv, kmlArenaToken (&str_data, str_data.KmlLval.pval),
+		 &str_data);
+	  if (str_data.kml_parse_error)
+	      break;
       }
     /* This denotes the end of a line as well as the end of the parser */
     Parse (pParser, KML_NEWLINE, 0, &str_data);
-    ParseFree (pParser, free);
-    Kmllex_destroy (scanner);
-
-    /* Assigning the token as the end to avoid seg faults while cleaning */
-    tokens->Next = NULL;
-    kml_cleanup (head);
+    Kml_delete_buffer (buffer, scanner);
+    if (parser != NULL)
+      {
+	  kml_reset_lemon (pParser);
+	  parser->busy = 0;
+      }
+    else
+      {
+	  ParseFree (pParser, free);
+	  Kmllex_destroy (scanner);
+      }
     kml_freeString (&(str_data.KmlLval.pval));
 
     if (str_data.kml_parse_error)
       {
-	  if (str_data.result)
-	    {
-		/* if a Geometry-result has been produced, the stack is already cleaned */
-		kml_freeTree (str_data.result);
-		kmlCleanMapDynAlloc (&str_data, 0);
-	    }
-	  else
-	    {
-		/* otherwise we are required to clean the stack */
-		kmlCleanMapDynAlloc (&str_data, 1);
-	    }
+	  /* nodes are all released together with the arena */
+	  kmlCleanMapDynAlloc (&str_data, str_data.result ? 0 : 1);
+	  kmlCleanArena (&str_data);
 	  return NULL;
       }
 
     if (str_data.result == NULL)
       {
 	  kmlCleanMapDynAlloc (&str_data, 0);
+	  kmlCleanArena (&str_data);
 	  return NULL;
       }
 
     /* attempting to build a geometry from KML */
     geom = kml_build_geometry (&str_data, str_data.result);
-    geom->Srid = 4326;
-    kml_freeTree (str_data.result);
+    if (geom != NULL)
+	geom->Srid = 4326;
     kmlCleanMapDynAlloc (&str_data, 0);
+    kmlCleanArena (&str_data);
     return geom;
 }
 
+gaiaGeomCollPtr
+gaiaParseKml (const unsigned char *dirty_buffer)
+{
+    return kml_parse (NULL, dirty_buffer);
+}
+
+GAIAGEO_DECLARE gaiaGeomCollPtr
+gaiaParseKml_r (const void *p_cache, const unsigned char *dirty_buffer)
+{
+    return kml_parse (kml_get_parser (p_cache), dirty_buffer);
+}
+
 
 /*
 ** CAVEAT: we must now undefine any Lemon/Flex own macro
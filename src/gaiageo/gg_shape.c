@@ -84,6 +84,7 @@ extern const char *locale_charset (void);
 
 #include <spatialite/gaiageo.h>
 #include <spatialite/debug.h>
+#include <spatialite_private.h>
 
 #ifdef _WIN32
 #define atoll	_atoi64
@@ -102,6 +103,245 @@ extern const char *locale_charset (void);
 #define strcasecmp	_stricmp
 #endif /* not WIN32 */
 
+#ifndef _WIN32
+#define SHP_MEMORY_MAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /* not WIN32 */
+
+#define SHP_FILE_SHX	1
+#define SHP_FILE_SHP	2
+#define SHP_FILE_DBF	3
+
+#define SHP_WRITE_BUFFER	(256 * 1024)	/* stdio buffer for each output file */
+
+struct shp_memory_map
+{
+/* read-only memory mapping of the SHX, SHP and DBF files */
+    unsigned char *shx;
+    size_t shx_size;
+    unsigned char *shp;
+    size_t shp_size;
+    unsigned char *dbf;
+    size_t dbf_size;
+    size_t shp_pos;		/* current SHP read position */
+};
+
+struct shp_handle
+{
+/*
+/ the Shapefile object as allocated by gaiaAllocShapefile(), extended by
+/ some private state never exposed by the public struct
+*/
+    gaiaShapefile shp;		/* must be the first member */
+    struct shp_memory_map *map;	/* read mode: the memory-mapped files */
+};
+
+#define SHP_MEMORY_MAP_OF(shp)	(((struct shp_handle *) (shp))->map)
+
+#ifdef SHP_MEMORY_MAP
+static unsigned char *
+shp_map_file (FILE * fl, size_t * size)
+{
+/* mapping a whole file in memory */
+    struct stat st;
+    void *addr;
+    if (fstat (fileno (fl), &st) != 0)
+	return NULL;
+    if (st.st_size <= 0 || (off_t) ((size_t) st.st_size) != st.st_size)
+	return NULL;
+    addr =
+	mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fileno (fl),
+	      0);
+    if (addr == MAP_FAILED)
+	return NULL;
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise (addr, (size_t) st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+    *size = (size_t) st.st_size;
+    return addr;
+}
+#endif
+
+static void
+shp_unmap_files (struct shp_memory_map *map)
+{
+/* releasing a memory mapped Shapefile */
+#ifdef SHP_MEMORY_MAP
+    if (map->shx != NULL)
+	munmap (map->shx, map->shx_size);
+    if (map->shp != NULL)
+	munmap (map->shp, map->shp_size);
+    if (map->dbf != NULL)
+	munmap (map->dbf, map->dbf_size);
+#endif
+    free (map);
+}
+
+static void
+shp_map_files (gaiaShapefilePtr shp)
+{
+/*
+/ attempting to memory-map the SHX, SHP and DBF files: records will then
+/ be decoded in place; the plain buffered stdio path is silently kept
+/ if mapping is unsupported or fails
+/
+/ setting SPATIALITE_SHP_MMAP=0 always selects the stdio path (a mapped
+/ file being truncated by someone else would raise SIGBUS)
+*/
+#ifdef SHP_MEMORY_MAP
+    struct shp_memory_map *map;
+    if (!splite_env_switch ("SPATIALITE_SHP_MMAP", 1))
+	return;
+    map = malloc (sizeof (struct shp_memory_map));
+    if (map == NULL)
+	return;
+    map->shp_pos = 0;
+    map->shp = NULL;
+    map->dbf = NULL;
+    map->shx = shp_map_file (shp->flShx, &(map->shx_size));
+    if (map->shx != NULL)
+	map->shp = shp_map_file (shp->flShp, &(map->shp_size));
+    if (map->shp != NULL)
+	map->dbf = shp_map_file (shp->flDbf, &(map->dbf_size));
+    if (map->dbf == NULL)
+      {
+	  shp_unmap_files (map);
+	  return;
+      }
+    SHP_MEMORY_MAP_OF (shp) = map;
+#else
+    if (shp == NULL)
+	return;			/* silencing stupid compiler warnings */
+#endif
+}
+
+static const unsigned char *
+shp_read_at (gaiaShapefilePtr shp, int which, long offset, int size,
+	     unsigned char *buf, int *rd)
+{
+/*
+/ reading SIZE bytes starting at OFFSET from the SHX, SHP or DBF file
+/ *rd* will contain the number of bytes actually read
+/ 
+/ memory-mapped files are accessed in place, otherwise the bytes are
+/ read into BUF
+*/
+    FILE *fl;
+    struct shp_memory_map *map = SHP_MEMORY_MAP_OF (shp);
+    *rd = 0;
+    if (map != NULL)
+      {
+	  const unsigned char *base;
+	  size_t avail;
+	  if (which == SHP_FILE_SHX)
+	    {
+		base = map->shx;
+		avail = map->shx_size;
+	    }
+	  else if (which == SHP_FILE_SHP)
+	    {
+		base = map->shp;
+		avail = map->shp_size;
+	    }
+	  else
+	    {
+		base = map->dbf;
+		avail = map->dbf_size;
+	    }
+	  if (offset < 0 || (size_t) offset > avail || size < 0)
+	      return buf;
+	  avail -= offset;
+	  *rd = ((size_t) size < avail) ? size : (int) avail;
+	  if (which == SHP_FILE_SHP)
+	      map->shp_pos = offset + *rd;
+	  return base + offset;
+      }
+    if (which == SHP_FILE_SHX)
+	fl = shp->flShx;
+    else if (which == SHP_FILE_SHP)
+	fl = shp->flShp;
+    else
+	fl = shp->flDbf;
+    if (size < 0 || fseek (fl, offset, SEEK_SET) != 0)
+	return buf;
+    *rd = fread (buf, sizeof (unsigned char), size, fl);
+    return buf;
+}
+
+static const unsigned char *
+shp_read_next (gaiaShapefilePtr shp, int size, int *rd)
+{
+/* reading the next SIZE bytes from the SHP file */
+    struct shp_memory_map *map = SHP_MEMORY_MAP_OF (shp);
+    if (map != NULL)
+	return shp_read_at (shp, SHP_FILE_SHP, map->shp_pos, size, NULL, rd);
+    *rd = 0;
+    if (size < 0 || size > shp->ShpBfsz)
+	return shp->BufShp;
+    *rd = fread (shp->BufShp, sizeof (unsigned char), size, shp->flShp);
+    return shp->BufShp;
+}
+
+static int
+shp_parse_parts (const unsigned char *buf_shp, int rd, int zm,
+		 int endian_arch, int *parts, int *points)
+{
+/*
+/ validating the header of a Polyline or Polygon record before decoding
+/ it in place (possibly from a memory-mapped file)
+/
+/ both counts must be non-negative; the parts index, the XY points and
+/ the ZM mandatory Z sections (range + values) must all fit within the
+/ RD bytes actually read; the part offsets must never decrease nor
+/ exceed the points count
+*/
+    int n;
+    int n1;
+    int ind;
+    int off;
+    int prev = 0;
+    int avail;
+    if (rd < 8)
+	return 0;
+    n = gaiaImport32 (buf_shp, GAIA_LITTLE_ENDIAN, endian_arch);
+    n1 = gaiaImport32 (buf_shp + 4, GAIA_LITTLE_ENDIAN, endian_arch);
+    if (n < 0 || n1 < 0 || n > (rd - 8) / 4)
+	return 0;
+    avail = rd - 8 - (n * 4) - (zm * 16);
+    if (avail < 0 || n1 > avail / (16 + (zm * 8)))
+	return 0;
+    for (ind = 0; ind < n; ind++)
+      {
+	  off =
+	      gaiaImport32 (buf_shp + 8 + (ind * 4), GAIA_LITTLE_ENDIAN,
+			    endian_arch);
+	  if (off < prev || off > n1)
+	      return 0;
+	  prev = off;
+      }
+    *parts = n;
+    *points = n1;
+    return 1;
+}
+
+static int
+shp_parse_points (const unsigned char *buf_shp, int rd, int zm,
+		  int endian_arch, int *points)
+{
+/* validating the header of a MultiPoint record, just as above */
+    int n;
+    int avail;
+    if (rd < 4)
+	return 0;
+    n = gaiaImport32 (buf_shp, GAIA_LITTLE_ENDIAN, endian_arch);
+    avail = rd - 4 - (zm * 16);
+    if (n < 0 || avail < 0 || n > avail / (16 + (zm * 8)))
+	return 0;
+    *points = n;
+    return 1;
+}
+
 struct auxdbf_fld
 {
 /* auxiliary DBF field struct */
@@ -367,7 +607,8 @@ GAIAGEO_DECLARE gaiaShapefilePtr
 gaiaAllocShapefile ()
 {
 /* allocates and initializes the Shapefile object */
-    gaiaShapefilePtr shp = malloc (sizeof (gaiaShapefile));
+    struct shp_handle *handle = malloc (sizeof (struct shp_handle));
+    gaiaShapefilePtr shp = &(handle->shp);
     shp->endian_arch = 1;
     shp->Path = NULL;
     shp->Shape = -1;
@@ -393,6 +634,9 @@ gaiaAllocShapefile ()
     shp->Valid = 0;
     shp->IconvObj = NULL;
     shp->LastError = NULL;
+    handle->map = NULL;
+    shp->LastHasM = 0;
+    shp->WriteBuffer = NULL;
     return shp;
 }
 
@@ -402,12 +646,16 @@ gaiaFreeShapefile (gaiaShapefilePtr shp)
 /* frees all memory allocations related to the Shapefile object */
     if (shp->Path)
 	free (shp->Path);
+    if (SHP_MEMORY_MAP_OF (shp))
+	shp_unmap_files (SHP_MEMORY_MAP_OF (shp));
     if (shp->flShp)
 	fclose (shp->flShp);
     if (shp->flShx)
 	fclose (shp->flShx);
     if (shp->flDbf)
 	fclose (shp->flDbf);
+    if (shp->WriteBuffer)
+	free (shp->WriteBuffer);
     if (shp->Dbf)
 	gaiaFreeDbfList (shp->Dbf);
     if (shp->BufShp)
@@ -670,6 +918,7 @@ gaiaOpenShpRead (gaiaShapefilePtr shp, const char *path, const char *charFrom,
     shp->DbfReclen = dbf_reclen;
     shp->Valid = 1;
     shp->endian_arch = endian_arch;
+    shp_map_files (shp);
     return;
   unsupported_conversion:
 /* illegal charset */
@@ -941,6 +1190,7 @@ gaiaOpenShpWrite (gaiaShapefilePtr shp, const char *path, int shape,
     char *pUtf8buf;
     int defaultId = 1;
     struct auxdbf_list *auxdbf = NULL;
+    char *write_buffer = NULL;
     if (charFrom && charTo)
       {
 	  iconv_ret = iconv_open (charTo, charFrom);
@@ -992,6 +1242,16 @@ gaiaOpenShpWrite (gaiaShapefilePtr shp, const char *path, int shape,
 		   sys_err);
 	  goto no_file;
       }
+/* records are written by many small chunks: using large stdio buffers */
+    write_buffer = malloc (SHP_WRITE_BUFFER * 3);
+    if (write_buffer != NULL)
+      {
+	  setvbuf (fl_shx, write_buffer, _IOFBF, SHP_WRITE_BUFFER);
+	  setvbuf (fl_shp, write_buffer + SHP_WRITE_BUFFER, _IOFBF,
+		   SHP_WRITE_BUFFER);
+	  setvbuf (fl_dbf, write_buffer + (SHP_WRITE_BUFFER * 2), _IOFBF,
+		   SHP_WRITE_BUFFER);
+      }
 /* allocating DBF buffer */
     dbf_reclen = 1;		/* an extra byte is needed because in DBF rows first byte is a marker for deletion */
     fld = dbf_list->First;
@@ -1184,6 +1444,7 @@ gaiaOpenShpWrite (gaiaShapefilePtr shp, const char *path, int shape,
     shp->flShp = fl_shp;
     shp->flShx = fl_shx;
     shp->flDbf = fl_dbf;
+    shp->WriteBuffer = write_buffer;
     shp->Dbf = dbf_list;
     shp->BufShp = buf_shp;
     shp->ShpBfsz = buf_size;
@@ -1287,8 +1548,8 @@ to_sqlite_julian_date (int year, int month, int day, double *julian)
 }
 
 static int
-parseDbfField (unsigned char *buf_dbf, void *iconv_obj, gaiaDbfFieldPtr pFld,
-	       int text_dates)
+parseDbfField (const unsigned char *buf_dbf, void *iconv_obj,
+	       gaiaDbfFieldPtr pFld, int text_dates)
 {
 /* parsing a generic DBF field */
     unsigned char buf[512];
@@ -1409,12 +1670,36 @@ parseDbfField (unsigned char *buf_dbf, void *iconv_obj, gaiaDbfFieldPtr pFld,
     return 1;
 }
 
+#define SHP_RING_BANDS_MIN_POINTS	256	/* smaller Rings are directly tested */
+#define SHP_RING_BANDS_MIN_TESTS	8	/* Ring tests before building bands */
+#define SHP_RING_INDEX_MIN	32	/* fewer Exterior Rings are just scanned */
+#define SHP_RING_INDEX_FANOUT	16
+
+struct shp_ring_bands
+{
+/*
+/ the edges of a Ring split into horizontal bands, so that
+/ repeated point-in-ring tests will only scan a single band
+*/
+    double MinY;
+    double MaxY;
+    double Height;
+    int Count;
+    int *Start;			/* Count + 1 offsets into Edges */
+    int *Edges;			/* the ending vertex of each edge */
+};
+
 struct shp_ring_item
 {
 /* a RING item [to be reassembled into a (Multi)Polygon] */
     gaiaRingPtr Ring;
     int IsExterior;
-    gaiaRingPtr Mother;
+    int Seq;
+    int Tests;
+    int Holes;
+    struct shp_ring_bands *Bands;
+    struct shp_ring_item *Mother;
+    gaiaPolygonPtr Polygon;
     struct shp_ring_item *Next;
 };
 
@@ -1425,6 +1710,37 @@ struct shp_ring_collection
     struct shp_ring_item *Last;
 };
 
+struct shp_ring_node
+{
+/* a node of the packed R-Tree indexing the Exterior Rings */
+    double MinX;
+    double MinY;
+    double MaxX;
+    double MaxY;
+    int First;
+    int Last;
+};
+
+struct shp_ring_index
+{
+/* a packed [STR] R-Tree indexing the Exterior Rings */
+    struct shp_ring_item **Leaves;
+    struct shp_ring_node *Nodes;
+    int LeafNodes;
+    int Root;
+};
+
+static void
+shp_free_bands (struct shp_ring_bands *bands)
+{
+/* memory cleanup: Ring bands */
+    if (bands == NULL)
+	return;
+    free (bands->Start);
+    free (bands->Edges);
+    free (bands);
+}
+
 static void
 shp_free_rings (struct shp_ring_collection *ringsColl)
 {
@@ -1437,6 +1753,7 @@ shp_free_rings (struct shp_ring_collection *ringsColl)
 	  pN = p->Next;
 	  if (p->Ring)
 	      gaiaFreeRing (p->Ring);
+	  shp_free_bands (p->Bands);
 	  free (p);
 	  p = pN;
       }
@@ -1452,7 +1769,12 @@ shp_add_ring (struct shp_ring_collection *ringsColl, gaiaRingPtr ring)
     gaiaClockwise (ring);
 /* accordingly to SHP rules interior/exterior depends on direction */
     p->IsExterior = ring->Clockwise;
+    p->Seq = 0;
+    p->Tests = 0;
+    p->Holes = 0;
+    p->Bands = NULL;
     p->Mother = NULL;
+    p->Polygon = NULL;
     p->Next = NULL;
 /* updating the linked list */
     if (ringsColl->First == NULL)
@@ -1463,7 +1785,155 @@ shp_add_ring (struct shp_ring_collection *ringsColl, gaiaRingPtr ring)
 }
 
 static int
-shp_check_rings (gaiaRingPtr exterior, gaiaRingPtr candidate)
+shp_ring_stride (gaiaRingPtr ring)
+{
+/* how many doubles are used by each vertex */
+    if (ring->DimensionModel == GAIA_XY_Z
+	|| ring->DimensionModel == GAIA_XY_M)
+	return 3;
+    if (ring->DimensionModel == GAIA_XY_Z_M)
+	return 4;
+    return 2;
+}
+
+static int
+shp_band_of (struct shp_ring_bands *bands, double y)
+{
+/* identifying the band containing some Y value */
+    double pos = (y - bands->MinY) / bands->Height;
+    if (!(pos > 0.0))
+	return 0;
+    if (pos >= bands->Count)
+	return bands->Count - 1;
+    return (int) pos;
+}
+
+static struct shp_ring_bands *
+shp_build_bands (gaiaRingPtr ring)
+{
+/* splitting the Ring edges into horizontal bands */
+    struct shp_ring_bands *bands;
+    int stride = shp_ring_stride (ring);
+    int cnt = ring->Points - 1;	/* the last vertex repeats the first one */
+    int *cursor;
+    double miny = DBL_MAX;
+    double maxy = -DBL_MAX;
+    double yi;
+    double yj;
+    int total = 0;
+    int b0;
+    int b1;
+    int b;
+    int i;
+    for (i = 0; i < cnt; i++)
+      {
+	  yi = ring->Coords[(i * stride) + 1];
+	  if (yi < miny)
+	      miny = yi;
+	  if (yi > maxy)
+	      maxy = yi;
+      }
+    if (!(maxy > miny))
+	return NULL;
+    bands = malloc (sizeof (struct shp_ring_bands));
+    bands->MinY = miny;
+    bands->MaxY = maxy;
+    bands->Count = cnt / 8;
+    bands->Height = (maxy - miny) / bands->Count;
+    bands->Start = calloc (bands->Count + 1, sizeof (int));
+    bands->Edges = NULL;
+    if (!(bands->Height > 0.0))
+	goto error;
+/* counting how many edges fall within each band */
+    yj = ring->Coords[((cnt - 1) * stride) + 1];
+    for (i = 0; i < cnt; i++)
+      {
+	  yi = ring->Coords[(i * stride) + 1];
+	  b0 = shp_band_of (bands, (yi < yj) ? yi : yj);
+	  b1 = shp_band_of (bands, (yi < yj) ? yj : yi);
+	  for (b = b0; b <= b1; b++)
+	      bands->Start[b + 1] += 1;
+	  total += b1 - b0 + 1;
+	  if (total > cnt * 16)
+	      goto error;	/* too many long edges; not worth it */
+	  yj = yi;
+      }
+    for (b = 0; b < bands->Count; b++)
+	bands->Start[b + 1] += bands->Start[b];
+/* assigning edges to bands */
+    bands->Edges = malloc (sizeof (int) * total);
+    cursor = malloc (sizeof (int) * bands->Count);
+    memcpy (cursor, bands->Start, sizeof (int) * bands->Count);
+    yj = ring->Coords[((cnt - 1) * stride) + 1];
+    for (i = 0; i < cnt; i++)
+      {
+	  yi = ring->Coords[(i * stride) + 1];
+	  b0 = shp_band_of (bands, (yi < yj) ? yi : yj);
+	  b1 = shp_band_of (bands, (yi < yj) ? yj : yi);
+	  for (b = b0; b <= b1; b++)
+	      bands->Edges[cursor[b]++] = i;
+	  yj = yi;
+      }
+    free (cursor);
+    return bands;
+  error:
+    shp_free_bands (bands);
+    return NULL;
+}
+
+static int
+shp_point_in_ring (struct shp_ring_item *item, double x, double y)
+{
+/*
+/ tests if a POINT falls inside a RING, exactly as
+/ gaiaIsPointOnRingSurface() does; rings repeatedly
+/ tested will only check the edges of a single band
+*/
+    gaiaRingPtr ring = item->Ring;
+    struct shp_ring_bands *bands;
+    int stride;
+    int cnt;
+    int isInternal = 0;
+    int b;
+    int k;
+    int i;
+    int j;
+    double xi;
+    double yi;
+    double xj;
+    double yj;
+    if (item->Bands == NULL && ring->Points > SHP_RING_BANDS_MIN_POINTS)
+      {
+	  /* building the bands just once */
+	  item->Tests += 1;
+	  if (item->Tests == SHP_RING_BANDS_MIN_TESTS)
+	      item->Bands = shp_build_bands (ring);
+      }
+    bands = item->Bands;
+    if (bands == NULL)
+	return gaiaIsPointOnRingSurface (ring, x, y);
+    if (!(y >= bands->MinY && y < bands->MaxY))
+	return 0;
+    stride = shp_ring_stride (ring);
+    cnt = ring->Points - 1;
+    b = shp_band_of (bands, y);
+    for (k = bands->Start[b]; k < bands->Start[b + 1]; k++)
+      {
+	  i = bands->Edges[k];
+	  j = (i == 0) ? cnt - 1 : i - 1;
+	  xi = ring->Coords[i * stride];
+	  yi = ring->Coords[(i * stride) + 1];
+	  xj = ring->Coords[j * stride];
+	  yj = ring->Coords[(j * stride) + 1];
+	  if ((((yi <= y) && (y < yj)) || ((yj <= y) && (y < yi)))
+	      && (x < (xj - xi) * (y - yi) / (yj - yi) + xi))
+	      isInternal = !isInternal;
+      }
+    return isInternal;
+}
+
+static int
+shp_check_rings (struct shp_ring_item *exterior, gaiaRingPtr candidate)
 {
 /* 
 / speditively checks if the candidate could be an interior Ring
@@ -1476,8 +1946,6 @@ shp_check_rings (gaiaRingPtr exterior, gaiaRingPtr candidate)
     double x1;
     double y1;
     int mid;
-    int ret0;
-    int ret1;
     if (candidate->DimensionModel == GAIA_XY_Z)
       {
 	  gaiaGetPointXYZ (candidate->Coords, 0, &x0, &y0, &z);
@@ -1513,10 +1981,10 @@ shp_check_rings (gaiaRingPtr exterior, gaiaRingPtr candidate)
       }
 
 /* testing if the first point falls on the exterior ring surface */
-    ret0 = gaiaIsPointOnRingSurface (exterior, x0, y0);
+    if (shp_point_in_ring (exterior, x0, y0))
+	return 1;
 /* testing if the second point falls on the exterior ring surface */
-    ret1 = gaiaIsPointOnRingSurface (exterior, x1, y1);
-    if (ret0 || ret1)
+    if (shp_point_in_ring (exterior, x1, y1))
 	return 1;
     return 0;
 }
@@ -1542,6 +2010,158 @@ shp_mbr_contains (gaiaRingPtr r1, gaiaRingPtr r2)
     return 0;
 }
 
+static int
+shp_cmp_center_x (const void *p1, const void *p2)
+{
+/* sorting Exterior Rings by the X coordinate of their MBR center */
+    gaiaRingPtr r1 = (*((struct shp_ring_item **) p1))->Ring;
+    gaiaRingPtr r2 = (*((struct shp_ring_item **) p2))->Ring;
+    double c1 = r1->MinX + r1->MaxX;
+    double c2 = r2->MinX + r2->MaxX;
+    if (c1 < c2)
+	return -1;
+    if (c1 > c2)
+	return 1;
+    return 0;
+}
+
+static int
+shp_cmp_center_y (const void *p1, const void *p2)
+{
+/* sorting Exterior Rings by the Y coordinate of their MBR center */
+    gaiaRingPtr r1 = (*((struct shp_ring_item **) p1))->Ring;
+    gaiaRingPtr r2 = (*((struct shp_ring_item **) p2))->Ring;
+    double c1 = r1->MinY + r1->MaxY;
+    double c2 = r2->MinY + r2->MaxY;
+    if (c1 < c2)
+	return -1;
+    if (c1 > c2)
+	return 1;
+    return 0;
+}
+
+static void
+shp_node_add_mbr (struct shp_ring_node *node, double minx, double miny,
+		  double maxx, double maxy, int first)
+{
+/* expanding the node's MBR */
+    if (first)
+      {
+	  node->MinX = minx;
+	  node->MinY = miny;
+	  node->MaxX = maxx;
+	  node->MaxY = maxy;
+	  return;
+      }
+    if (minx < node->MinX)
+	node->MinX = minx;
+    if (miny < node->MinY)
+	node->MinY = miny;
+    if (maxx > node->MaxX)
+	node->MaxX = maxx;
+    if (maxy > node->MaxY)
+	node->MaxY = maxy;
+}
+
+static void
+shp_build_ring_index (struct shp_ring_index *index,
+		      struct shp_ring_item **exteriors, int count)
+{
+/* bulk loading the Exterior Rings by Sort-Tile-Recursive */
+    struct shp_ring_node *node;
+    struct shp_ring_node *child;
+    gaiaRingPtr ring;
+    int fanout = SHP_RING_INDEX_FANOUT;
+    int slice = (int) ceil (sqrt ((double) ((count + fanout - 1) / fanout)));
+    int n_nodes = 0;
+    int level_start;
+    int level_end;
+    int i;
+    int k;
+/* vertical slices of about sqrt(N/fanout) leaf nodes each */
+    slice *= fanout;
+    qsort (exteriors, count, sizeof (struct shp_ring_item *),
+	   shp_cmp_center_x);
+    for (i = 0; i < count; i += slice)
+	qsort (exteriors + i, (count - i < slice) ? count - i : slice,
+	       sizeof (struct shp_ring_item *), shp_cmp_center_y);
+    index->Leaves = exteriors;
+/* a packed tree never requires more nodes than leaves */
+    index->Nodes = malloc (sizeof (struct shp_ring_node) * count);
+    for (i = 0; i < count; i += SHP_RING_INDEX_FANOUT)
+      {
+	  node = index->Nodes + n_nodes++;
+	  node->First = i;
+	  node->Last = i + SHP_RING_INDEX_FANOUT;
+	  if (node->Last > count)
+	      node->Last = count;
+	  for (k = node->First; k < node->Last; k++)
+	    {
+		ring = exteriors[k]->Ring;
+		shp_node_add_mbr (node, ring->MinX, ring->MinY, ring->MaxX,
+				  ring->MaxY, k == node->First);
+	    }
+      }
+    index->LeafNodes = n_nodes;
+    level_start = 0;
+    level_end = n_nodes;
+    while (level_end - level_start > 1)
+      {
+	  /* building the upper levels */
+	  for (i = level_start; i < level_end; i += SHP_RING_INDEX_FANOUT)
+	    {
+		node = index->Nodes + n_nodes++;
+		node->First = i;
+		node->Last = i + SHP_RING_INDEX_FANOUT;
+		if (node->Last > level_end)
+		    node->Last = level_end;
+		for (k = node->First; k < node->Last; k++)
+		  {
+		      child = index->Nodes + k;
+		      shp_node_add_mbr (node, child->MinX, child->MinY,
+					child->MaxX, child->MaxY,
+					k == node->First);
+		  }
+	    }
+	  level_start = level_end;
+	  level_end = n_nodes;
+      }
+    index->Root = level_start;
+}
+
+static void
+shp_find_mother (struct shp_ring_index *index, int node_no,
+		 struct shp_ring_item *interior, struct shp_ring_item **mother)
+{
+/*
+/ searching the first Exterior Ring [in Shapefile order]
+/ containing some Interior Ring
+*/
+    struct shp_ring_node *node = index->Nodes + node_no;
+    struct shp_ring_item *exterior;
+    gaiaRingPtr ring = interior->Ring;
+    int i;
+    if (ring->MinX < node->MinX || ring->MaxX > node->MaxX
+	|| ring->MinY < node->MinY || ring->MaxY > node->MaxY)
+	return;
+    if (node_no >= index->LeafNodes)
+      {
+	  /* descending the tree */
+	  for (i = node->First; i < node->Last; i++)
+	      shp_find_mother (index, i, interior, mother);
+	  return;
+      }
+    for (i = node->First; i < node->Last; i++)
+      {
+	  exterior = index->Leaves[i];
+	  if (*mother != NULL && exterior->Seq > (*mother)->Seq)
+	      continue;
+	  if (shp_mbr_contains (exterior->Ring, ring)
+	      && shp_check_rings (exterior, ring))
+	      *mother = exterior;
+      }
+}
+
 static void
 shp_arrange_rings (struct shp_ring_collection *ringsColl)
 {
@@ -1551,27 +2171,71 @@ shp_arrange_rings (struct shp_ring_collection *ringsColl)
 */
     struct shp_ring_item *pInt;
     struct shp_ring_item *pExt;
+    struct shp_ring_item **exteriors;
+    struct shp_ring_index index;
+    struct shp_ring_item *mother;
+    int n_exteriors = 0;
+    int n_interiors = 0;
     pExt = ringsColl->First;
     while (pExt != NULL)
       {
-	  /* looping on Exterior Rings */
 	  if (pExt->IsExterior)
+	      pExt->Seq = n_exteriors++;
+	  else
+	      n_interiors++;
+	  pExt = pExt->Next;
+      }
+    if (n_exteriors >= SHP_RING_INDEX_MIN && n_interiors > 0)
+      {
+	  /* many Exterior Rings: using a spatial index */
+	  exteriors = malloc (sizeof (struct shp_ring_item *) * n_exteriors);
+	  n_exteriors = 0;
+	  pExt = ringsColl->First;
+	  while (pExt != NULL)
+	    {
+		if (pExt->IsExterior)
+		    exteriors[n_exteriors++] = pExt;
+		pExt = pExt->Next;
+	    }
+	  shp_build_ring_index (&index, exteriors, n_exteriors);
+	  pInt = ringsColl->First;
+	  while (pInt != NULL)
 	    {
-		pInt = ringsColl->First;
-		while (pInt != NULL)
+		if (pInt->IsExterior == 0)
 		  {
-		      /* looping on Interior Rings */
-		      if (pInt->IsExterior == 0 && pInt->Mother == NULL
-			  && shp_mbr_contains (pExt->Ring, pInt->Ring))
+		      mother = NULL;
+		      shp_find_mother (&index, index.Root, pInt, &mother);
+		      pInt->Mother = mother;
+		  }
+		pInt = pInt->Next;
+	    }
+	  free (index.Nodes);
+	  free (exteriors);
+      }
+    else
+      {
+	  pExt = ringsColl->First;
+	  while (pExt != NULL)
+	    {
+		/* looping on Exterior Rings */
+		if (pExt->IsExterior)
+		  {
+		      pInt = ringsColl->First;
+		      while (pInt != NULL)
 			{
-			    /* ok, matches */
-			    if (shp_check_rings (pExt->Ring, pInt->Ring))
-				pInt->Mother = pExt->Ring;
+			    /* looping on Interior Rings */
+			    if (pInt->IsExterior == 0 && pInt->Mother == NULL
+				&& shp_mbr_contains (pExt->Ring, pInt->Ring))
+			      {
+				  /* ok, matches */
+				  if (shp_check_rings (pExt, pInt->Ring))
+				      pInt->Mother = pExt;
+			      }
+			    pInt = pInt->Next;
 			}
-		      pInt = pInt->Next;
 		  }
+		pExt = pExt->Next;
 	    }
-	  pExt = pExt->Next;
       }
     pExt = ringsColl->First;
     while (pExt != NULL)
@@ -1592,6 +2256,14 @@ shp_build_area (struct shp_ring_collection *ringsColl, gaiaGeomCollPtr geom)
     gaiaPolygonPtr polyg;
     struct shp_ring_item *pExt;
     struct shp_ring_item *pInt;
+    pInt = ringsColl->First;
+    while (pInt != NULL)
+      {
+	  /* counting the interior rings of each POLYGON */
+	  if (pInt->Mother != NULL)
+	      pInt->Mother->Holes += 1;
+	  pInt = pInt->Next;
+      }
     pExt = ringsColl->First;
     while (pExt != NULL)
       {
@@ -1599,23 +2271,30 @@ shp_build_area (struct shp_ring_collection *ringsColl, gaiaGeomCollPtr geom)
 	    {
 		/* creating a new Polygon */
 		polyg = gaiaInsertPolygonInGeomColl (geom, pExt->Ring);
-		pInt = ringsColl->First;
-		while (pInt != NULL)
-		  {
-		      if (pExt->Ring == pInt->Mother)
-			{
-			    /* adding an interior ring to current POLYGON */
-			    gaiaAddRingToPolyg (polyg, pInt->Ring);
-			    /* releasing Ring ownership */
-			    pInt->Ring = NULL;
-			}
-		      pInt = pInt->Next;
-		  }
+		if (pExt->Holes > 0)
+		    polyg->Interiors = malloc (sizeof (gaiaRing) * pExt->Holes);
+		pExt->Polygon = polyg;
 		/* releasing Ring ownership */
 		pExt->Ring = NULL;
 	    }
 	  pExt = pExt->Next;
       }
+    pInt = ringsColl->First;
+    while (pInt != NULL)
+      {
+	  if (pInt->Mother != NULL)
+	    {
+		/* adding an interior ring to its own POLYGON */
+		polyg = pInt->Mother->Polygon;
+		memcpy (polyg->Interiors + polyg->NumInteriors, pInt->Ring,
+			sizeof (gaiaRing));
+		polyg->NumInteriors += 1;
+		/* releasing Ring ownership */
+		free (pInt->Ring);
+		pInt->Ring = NULL;
+	    }
+	  pInt = pInt->Next;
+      }
 }
 
 GAIAGEO_DECLARE int
@@ -1624,15 +2303,21 @@ gaiaReadShpEntity (gaiaShapefilePtr shp, int current_row, int srid)
     return gaiaReadShpEntity_ex (shp, current_row, srid, 0);
 }
 
-GAIAGEO_DECLARE int
-gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
-		      int text_dates)
+#define SHP_READ_RECORD		1	/* the raw DBF record */
+#define SHP_READ_GEOMETRY	2	/* decoding the SHP Geometry */
+#define SHP_READ_VALUES		4	/* decoding all DBF values */
+
+static int
+shp_read_entity (gaiaShapefilePtr shp, int current_row, int srid,
+		 int text_dates, int mode)
 {
 /* trying to read an entity from shapefile */
     unsigned char buf[512];
+    const unsigned char *p_buf;
+    const unsigned char *buf_shp = NULL;
+    const unsigned char *buf_dbf = NULL;
     int len;
     int rd;
-    int skpos;
     int offset;
     int off_shp;
     int sz;
@@ -1665,32 +2350,35 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     ringsColl.Last = NULL;
 /* positioning and reading the SHX file */
     offset = 100 + (current_row * 8);	/* 100 bytes for the header + current row displacement; each SHX row = 8 bytes */
-    skpos = fseek (shp->flShx, offset, SEEK_SET);
-    if (skpos != 0)
-	goto eof;
-    rd = fread (buf, sizeof (unsigned char), 8, shp->flShx);
+    p_buf = shp_read_at (shp, SHP_FILE_SHX, offset, 8, buf, &rd);
     if (rd != 8)
 	goto eof;
-    off_shp = gaiaImport32 (buf, GAIA_BIG_ENDIAN, shp->endian_arch);
-/* positioning and reading the DBF file */
-    offset = shp->DbfHdsz + (current_row * shp->DbfReclen);
-    skpos = fseek (shp->flDbf, offset, SEEK_SET);
-    if (skpos != 0)
-	goto error;
-    rd = fread (shp->BufDbf, sizeof (unsigned char), shp->DbfReclen,
-		shp->flDbf);
-    if (rd != shp->DbfReclen)
-	goto error;
+    off_shp = gaiaImport32 (p_buf, GAIA_BIG_ENDIAN, shp->endian_arch);
+    if (mode & SHP_READ_RECORD)
+      {
+	  /* positioning and reading the DBF file */
+	  offset = shp->DbfHdsz + (current_row * shp->DbfReclen);
+	  buf_dbf =
+	      shp_read_at (shp, SHP_FILE_DBF, offset, shp->DbfReclen,
+			   shp->BufDbf, &rd);
+	  if (rd != shp->DbfReclen)
+	      goto error;
+	  if (!(mode & SHP_READ_VALUES) && buf_dbf != shp->BufDbf)
+	    {
+		/* deferred decoding: the record must outlive the mapping */
+		memcpy (shp->BufDbf, buf_dbf, shp->DbfReclen);
+	    }
+      }
+    if (!(mode & SHP_READ_GEOMETRY))
+	goto null_shape;
+    shp->LastHasM = 0;
 /* positioning and reading corresponding SHP entity - geometry */
     offset = off_shp * 2;
-    skpos = fseek (shp->flShp, offset, SEEK_SET);
-    if (skpos != 0)
-	goto error;
-    rd = fread (buf, sizeof (unsigned char), 12, shp->flShp);
+    p_buf = shp_read_at (shp, SHP_FILE_SHP, offset, 12, buf, &rd);
     if (rd != 12)
 	goto error;
-    sz = gaiaImport32 (buf + 4, GAIA_BIG_ENDIAN, shp->endian_arch);
-    shape = gaiaImport32 (buf + 8, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+    sz = gaiaImport32 (p_buf + 4, GAIA_BIG_ENDIAN, shp->endian_arch);
+    shape = gaiaImport32 (p_buf + 8, GAIA_LITTLE_ENDIAN, shp->endian_arch);
     if (shape == GAIA_SHP_NULL)
       {
 	  /* handling a NULL shape */
@@ -1708,11 +2396,11 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POINT)
       {
 	  /* shape point */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 16, shp->flShp);
+	  buf_shp = shp_read_next (shp, 16, &rd);
 	  if (rd != 16)
 	      goto error;
-	  x = gaiaImport64 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  y = gaiaImport64 (shp->BufShp + 8, GAIA_LITTLE_ENDIAN,
+	  x = gaiaImport64 (buf_shp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  y = gaiaImport64 (buf_shp + 8, GAIA_LITTLE_ENDIAN,
 			    shp->endian_arch);
 	  if (shp->EffectiveDims == GAIA_XY_Z)
 	    {
@@ -1740,22 +2428,22 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POINTZ)
       {
 	  /* shape point Z */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	    {
 		/* required by some buggish SHP (e.g. the GDAL/OGR ones) */
 		if (rd != 24)
 		    goto error;
 	    }
-	  x = gaiaImport64 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  y = gaiaImport64 (shp->BufShp + 8, GAIA_LITTLE_ENDIAN,
+	  x = gaiaImport64 (buf_shp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  y = gaiaImport64 (buf_shp + 8, GAIA_LITTLE_ENDIAN,
 			    shp->endian_arch);
-	  z = gaiaImport64 (shp->BufShp + 16, GAIA_LITTLE_ENDIAN,
+	  z = gaiaImport64 (buf_shp + 16, GAIA_LITTLE_ENDIAN,
 			    shp->endian_arch);
 	  if (rd == 24)
 	      m = 0.0;
 	  else
-	      m = gaiaImport64 (shp->BufShp + 24, GAIA_LITTLE_ENDIAN,
+	      m = gaiaImport64 (buf_shp + 24, GAIA_LITTLE_ENDIAN,
 				shp->endian_arch);
 	  if (shp->EffectiveDims == GAIA_XY_Z)
 	    {
@@ -1783,13 +2471,13 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POINTM)
       {
 	  /* shape point M */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 24, shp->flShp);
+	  buf_shp = shp_read_next (shp, 24, &rd);
 	  if (rd != 24)
 	      goto error;
-	  x = gaiaImport64 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  y = gaiaImport64 (shp->BufShp + 8, GAIA_LITTLE_ENDIAN,
+	  x = gaiaImport64 (buf_shp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  y = gaiaImport64 (buf_shp + 8, GAIA_LITTLE_ENDIAN,
 			    shp->endian_arch);
-	  m = gaiaImport64 (shp->BufShp + 16, GAIA_LITTLE_ENDIAN,
+	  m = gaiaImport64 (buf_shp + 16, GAIA_LITTLE_ENDIAN,
 			    shp->endian_arch);
 	  if (shp->EffectiveDims == GAIA_XY_Z)
 	    {
@@ -1817,23 +2505,21 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POLYLINE)
       {
 	  /* shape polyline */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-			     shp->endian_arch);
+	  if (!shp_parse_parts (buf_shp, rd, 0, shp->endian_arch, &n, &n1))
+	      goto error;
 	  base = 8 + (n * 4);
 	  start = 0;
 	  for (ind = 0; ind < n; ind++)
 	    {
 		if (ind < (n - 1))
 		    end =
-			gaiaImport32 (shp->BufShp + 8 + ((ind + 1) * 4),
+			gaiaImport32 (buf_shp + 8 + ((ind + 1) * 4),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    end = n1;
@@ -1849,9 +2535,9 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 		points = 0;
 		for (iv = start; iv < end; iv++)
 		  {
-		      x = gaiaImport64 (shp->BufShp + base + (iv * 16),
+		      x = gaiaImport64 (buf_shp + base + (iv * 16),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		      y = gaiaImport64 (shp->BufShp + base + (iv * 16) +
+		      y = gaiaImport64 (buf_shp + base + (iv * 16) +
 					8, GAIA_LITTLE_ENDIAN,
 					shp->endian_arch);
 		      if (shp->EffectiveDims == GAIA_XY_Z)
@@ -1896,16 +2582,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POLYLINEZ)
       {
 	  /* shape polyline Z */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-			     shp->endian_arch);
+	  if (!shp_parse_parts (buf_shp, rd, 1, shp->endian_arch, &n, &n1))
+	      goto error;
 	  hasM = 0;
 	  max_size = 38 + (2 * n) + (n1 * 16);	/* size [in 16 bits words !!!] ZM */
 	  min_size = 30 + (2 * n) + (n1 * 12);	/* size [in 16 bits words !!!] Z-only */
@@ -1913,6 +2597,7 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	      goto error;
 	  if (sz == max_size)
 	      hasM = 1;
+	  shp->LastHasM = hasM;
 	  base = 8 + (n * 4);
 	  baseZ = base + (n1 * 16) + 16;
 	  baseM = baseZ + (n1 * 8) + 16;
@@ -1921,7 +2606,7 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	    {
 		if (ind < (n - 1))
 		    end =
-			gaiaImport32 (shp->BufShp + 8 + ((ind + 1) * 4),
+			gaiaImport32 (buf_shp + 8 + ((ind + 1) * 4),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    end = n1;
@@ -1937,15 +2622,15 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 		points = 0;
 		for (iv = start; iv < end; iv++)
 		  {
-		      x = gaiaImport64 (shp->BufShp + base + (iv * 16),
+		      x = gaiaImport64 (buf_shp + base + (iv * 16),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		      y = gaiaImport64 (shp->BufShp + base + (iv * 16) +
+		      y = gaiaImport64 (buf_shp + base + (iv * 16) +
 					8, GAIA_LITTLE_ENDIAN,
 					shp->endian_arch);
-		      z = gaiaImport64 (shp->BufShp + baseZ + (iv * 8),
+		      z = gaiaImport64 (buf_shp + baseZ + (iv * 8),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		      if (hasM)
-			  m = gaiaImport64 (shp->BufShp + baseM +
+			  m = gaiaImport64 (buf_shp + baseM +
 					    (iv * 8), GAIA_LITTLE_ENDIAN,
 					    shp->endian_arch);
 		      else
@@ -1993,16 +2678,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POLYLINEM)
       {
 	  /* shape polyline M */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-			     shp->endian_arch);
+	  if (!shp_parse_parts (buf_shp, rd, 0, shp->endian_arch, &n, &n1))
+	      goto error;
 	  hasM = 0;
 	  max_size = 30 + (2 * n) + (n1 * 12);	/* size [in 16 bits words !!!] M */
 	  min_size = 22 + (2 * n) + (n1 * 8);	/* size [in 16 bits words !!!] no-M */
@@ -2017,7 +2700,7 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	    {
 		if (ind < (n - 1))
 		    end =
-			gaiaImport32 (shp->BufShp + 8 + ((ind + 1) * 4),
+			gaiaImport32 (buf_shp + 8 + ((ind + 1) * 4),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    end = n1;
@@ -2033,13 +2716,13 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 		points = 0;
 		for (iv = start; iv < end; iv++)
 		  {
-		      x = gaiaImport64 (shp->BufShp + base + (iv * 16),
+		      x = gaiaImport64 (buf_shp + base + (iv * 16),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		      y = gaiaImport64 (shp->BufShp + base + (iv * 16) +
+		      y = gaiaImport64 (buf_shp + base + (iv * 16) +
 					8, GAIA_LITTLE_ENDIAN,
 					shp->endian_arch);
 		      if (hasM)
-			  m = gaiaImport64 (shp->BufShp + baseM +
+			  m = gaiaImport64 (buf_shp + baseM +
 					    (iv * 8), GAIA_LITTLE_ENDIAN,
 					    shp->endian_arch);
 		      else
@@ -2088,23 +2771,21 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POLYGON)
       {
 	  /* shape polygon */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-			     shp->endian_arch);
+	  if (!shp_parse_parts (buf_shp, rd, 0, shp->endian_arch, &n, &n1))
+	      goto error;
 	  base = 8 + (n * 4);
 	  start = 0;
 	  for (ind = 0; ind < n; ind++)
 	    {
 		if (ind < (n - 1))
 		    end =
-			gaiaImport32 (shp->BufShp + 8 + ((ind + 1) * 4),
+			gaiaImport32 (buf_shp + 8 + ((ind + 1) * 4),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    end = n1;
@@ -2120,9 +2801,9 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 		points = 0;
 		for (iv = start; iv < end; iv++)
 		  {
-		      x = gaiaImport64 (shp->BufShp + base + (iv * 16),
+		      x = gaiaImport64 (buf_shp + base + (iv * 16),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		      y = gaiaImport64 (shp->BufShp + base + (iv * 16) +
+		      y = gaiaImport64 (buf_shp + base + (iv * 16) +
 					8, GAIA_LITTLE_ENDIAN,
 					shp->endian_arch);
 		      if (shp->EffectiveDims == GAIA_XY_Z)
@@ -2167,16 +2848,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POLYGONZ)
       {
 	  /* shape polygon Z */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-			     shp->endian_arch);
+	  if (!shp_parse_parts (buf_shp, rd, 1, shp->endian_arch, &n, &n1))
+	      goto error;
 	  hasM = 0;
 	  max_size = 38 + (2 * n) + (n1 * 16);	/* size [in 16 bits words !!!] ZM */
 	  min_size = 30 + (2 * n) + (n1 * 12);	/* size [in 16 bits words !!!] Z-only */
@@ -2184,6 +2863,7 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	      goto error;
 	  if (sz == max_size)
 	      hasM = 1;
+	  shp->LastHasM = hasM;
 	  base = 8 + (n * 4);
 	  baseZ = base + (n1 * 16) + 16;
 	  baseM = baseZ + (n1 * 8) + 16;
@@ -2192,7 +2872,7 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	    {
 		if (ind < (n - 1))
 		    end =
-			gaiaImport32 (shp->BufShp + 8 + ((ind + 1) * 4),
+			gaiaImport32 (buf_shp + 8 + ((ind + 1) * 4),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    end = n1;
@@ -2208,15 +2888,15 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 		points = 0;
 		for (iv = start; iv < end; iv++)
 		  {
-		      x = gaiaImport64 (shp->BufShp + base + (iv * 16),
+		      x = gaiaImport64 (buf_shp + base + (iv * 16),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		      y = gaiaImport64 (shp->BufShp + base + (iv * 16) +
+		      y = gaiaImport64 (buf_shp + base + (iv * 16) +
 					8, GAIA_LITTLE_ENDIAN,
 					shp->endian_arch);
-		      z = gaiaImport64 (shp->BufShp + baseZ + (iv * 8),
+		      z = gaiaImport64 (buf_shp + baseZ + (iv * 8),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		      if (hasM)
-			  m = gaiaImport64 (shp->BufShp + baseM +
+			  m = gaiaImport64 (buf_shp + baseM +
 					    (iv * 8), GAIA_LITTLE_ENDIAN,
 					    shp->endian_arch);
 		      else
@@ -2264,16 +2944,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_POLYGONM)
       {
 	  /* shape polygon M */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
-	  n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-			     shp->endian_arch);
+	  if (!shp_parse_parts (buf_shp, rd, 0, shp->endian_arch, &n, &n1))
+	      goto error;
 	  hasM = 0;
 	  max_size = 30 + (2 * n) + (n1 * 12);	/* size [in 16 bits words !!!] M */
 	  min_size = 22 + (2 * n) + (n1 * 8);	/* size [in 16 bits words !!!] no-M */
@@ -2288,7 +2966,7 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	    {
 		if (ind < (n - 1))
 		    end =
-			gaiaImport32 (shp->BufShp + 8 + ((ind + 1) * 4),
+			gaiaImport32 (buf_shp + 8 + ((ind + 1) * 4),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    end = n1;
@@ -2304,13 +2982,13 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 		points = 0;
 		for (iv = start; iv < end; iv++)
 		  {
-		      x = gaiaImport64 (shp->BufShp + base + (iv * 16),
+		      x = gaiaImport64 (buf_shp + base + (iv * 16),
 					GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		      y = gaiaImport64 (shp->BufShp + base + (iv * 16) +
+		      y = gaiaImport64 (buf_shp + base + (iv * 16) +
 					8, GAIA_LITTLE_ENDIAN,
 					shp->endian_arch);
 		      if (hasM)
-			  m = gaiaImport64 (shp->BufShp + baseM +
+			  m = gaiaImport64 (buf_shp + baseM +
 					    (iv * 8), GAIA_LITTLE_ENDIAN,
 					    shp->endian_arch);
 		      m = 0.0;
@@ -2358,14 +3036,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_MULTIPOINT)
       {
 	  /* shape multipoint */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  if (!shp_parse_points (buf_shp, rd, 0, shp->endian_arch, &n))
+	      goto error;
 	  if (shp->EffectiveDims == GAIA_XY_Z)
 	      geom = gaiaAllocGeomCollXYZ ();
 	  else if (shp->EffectiveDims == GAIA_XY_M)
@@ -2378,9 +3056,9 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	  geom->Srid = srid;
 	  for (iv = 0; iv < n; iv++)
 	    {
-		x = gaiaImport64 (shp->BufShp + 4 + (iv * 16),
+		x = gaiaImport64 (buf_shp + 4 + (iv * 16),
 				  GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		y = gaiaImport64 (shp->BufShp + 4 + (iv * 16) + 8,
+		y = gaiaImport64 (buf_shp + 4 + (iv * 16) + 8,
 				  GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		if (shp->EffectiveDims == GAIA_XY_Z)
 		    gaiaAddPointToGeomCollXYZ (geom, x, y, 0.0);
@@ -2395,14 +3073,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_MULTIPOINTZ)
       {
 	  /* shape multipoint Z */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  if (!shp_parse_points (buf_shp, rd, 1, shp->endian_arch, &n))
+	      goto error;
 	  hasM = 0;
 	  max_size = 36 + (n * 16);	/* size [in 16 bits words !!!] ZM */
 	  min_size = 28 + (n * 12);	/* size [in 16 bits words !!!] Z-only */
@@ -2410,6 +3088,7 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	      goto error;
 	  if (sz == max_size)
 	      hasM = 1;
+	  shp->LastHasM = hasM;
 	  baseZ = 4 + (n * 16) + 16;
 	  baseM = baseZ + (n * 8) + 16;
 	  if (shp->EffectiveDims == GAIA_XY_Z)
@@ -2424,14 +3103,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	  geom->Srid = srid;
 	  for (iv = 0; iv < n; iv++)
 	    {
-		x = gaiaImport64 (shp->BufShp + 4 + (iv * 16),
+		x = gaiaImport64 (buf_shp + 4 + (iv * 16),
 				  GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		y = gaiaImport64 (shp->BufShp + 4 + (iv * 16) + 8,
+		y = gaiaImport64 (buf_shp + 4 + (iv * 16) + 8,
 				  GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		z = gaiaImport64 (shp->BufShp + baseZ + (iv * 8),
+		z = gaiaImport64 (buf_shp + baseZ + (iv * 8),
 				  GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		if (hasM)
-		    m = gaiaImport64 (shp->BufShp + baseM + (iv * 8),
+		    m = gaiaImport64 (buf_shp + baseM + (iv * 8),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    m = 0.0;
@@ -2450,14 +3129,14 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     if (shape == GAIA_SHP_MULTIPOINTM)
       {
 	  /* shape multipoint M */
-	  rd = fread (shp->BufShp, sizeof (unsigned char), 32, shp->flShp);
+	  buf_shp = shp_read_next (shp, 32, &rd);
 	  if (rd != 32)
 	      goto error;
-	  rd = fread (shp->BufShp, sizeof (unsigned char), (sz * 2) - 36,
-		      shp->flShp);
+	  buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 	  if (rd != (sz * 2) - 36)
 	      goto error;
-	  n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  if (!shp_parse_points (buf_shp, rd, 0, shp->endian_arch, &n))
+	      goto error;
 	  hasM = 0;
 	  max_size = 28 + (n * 12);	/* size [in 16 bits words !!!] M */
 	  min_size = 20 + (n * 8);	/* size [in 16 bits words !!!] no-M */
@@ -2478,12 +3157,12 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
 	  geom->Srid = srid;
 	  for (iv = 0; iv < n; iv++)
 	    {
-		x = gaiaImport64 (shp->BufShp + 4 + (iv * 16),
+		x = gaiaImport64 (buf_shp + 4 + (iv * 16),
 				  GAIA_LITTLE_ENDIAN, shp->endian_arch);
-		y = gaiaImport64 (shp->BufShp + 4 + (iv * 16) + 8,
+		y = gaiaImport64 (buf_shp + 4 + (iv * 16) + 8,
 				  GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		if (hasM)
-		    m = gaiaImport64 (shp->BufShp + baseM + (iv * 8),
+		    m = gaiaImport64 (buf_shp + baseM + (iv * 8),
 				      GAIA_LITTLE_ENDIAN, shp->endian_arch);
 		else
 		    m = 0.0;
@@ -2501,16 +3180,24 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
       }
 /* setting up the current SHP ENTITY */
   null_shape:
-    gaiaResetDbfEntity (shp->Dbf);
-    shp->Dbf->RowId = current_row;
+    if (mode & SHP_READ_RECORD)
+      {
+	  gaiaResetDbfEntity (shp->Dbf);
+	  shp->Dbf->RowId = current_row;
+      }
+    else if (shp->Dbf->Geometry)
+	gaiaFreeGeomColl (shp->Dbf->Geometry);
     shp->Dbf->Geometry = geom;
-/* fetching the DBF values */
-    pFld = shp->Dbf->First;
-    while (pFld)
+    if (mode & SHP_READ_VALUES)
       {
-	  if (!parseDbfField (shp->BufDbf, shp->IconvObj, pFld, text_dates))
-	      goto conversion_error;
-	  pFld = pFld->Next;
+	  /* fetching the DBF values */
+	  pFld = shp->Dbf->First;
+	  while (pFld)
+	    {
+		if (!parseDbfField (buf_dbf, shp->IconvObj, pFld, text_dates))
+		    goto conversion_error;
+		pFld = pFld->Next;
+	    }
       }
     if (shp->LastError)
 	free (shp->LastError);
@@ -2543,6 +3230,132 @@ gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
     return 0;
 }
 
+GAIAGEO_DECLARE int
+gaiaReadShpEntity_ex (gaiaShapefilePtr shp, int current_row, int srid,
+		      int text_dates)
+{
+/* trying to read an entity from shapefile */
+    return shp_read_entity (shp, current_row, srid, text_dates,
+			    SHP_READ_RECORD | SHP_READ_GEOMETRY |
+			    SHP_READ_VALUES);
+}
+
+GAIAGEO_DECLARE int
+gaiaReadShpEntityLazy (gaiaShapefilePtr shp, int current_row)
+{
+/* positioning on some entity, but deferring any decoding */
+    return shp_read_entity (shp, current_row, 0, 0, SHP_READ_RECORD);
+}
+
+GAIAGEO_DECLARE int
+gaiaReadShpEntityGeometry (gaiaShapefilePtr shp, int current_row, int srid)
+{
+/* decoding the Geometry of some entity, DBF values being left untouched */
+    return shp_read_entity (shp, current_row, srid, 0, SHP_READ_GEOMETRY);
+}
+
+GAIAGEO_DECLARE int
+gaiaReadShpEntityValue (gaiaShapefilePtr shp, gaiaDbfFieldPtr field,
+			int text_dates)
+{
+/* decoding a single DBF value from the last raw record read */
+    int len;
+    char errMsg[1024];
+    if (field->Value)
+	gaiaFreeValue (field->Value);
+    field->Value = NULL;
+    if (parseDbfField (shp->BufDbf, shp->IconvObj, field, text_dates))
+	return 1;
+    if (shp->LastError)
+	free (shp->LastError);
+    sprintf (errMsg, "Invalid character sequence");
+    len = strlen (errMsg);
+    shp->LastError = malloc (len + 1);
+    strcpy (shp->LastError, errMsg);
+    return 0;
+}
+
+GAIAGEO_DECLARE int
+gaiaShpRecordCount (gaiaShapefilePtr shp)
+{
+/* counting the features declared by the SHX index */
+    long size;
+#ifdef SHP_MEMORY_MAP
+    struct shp_memory_map *map = SHP_MEMORY_MAP_OF (shp);
+#endif
+    if (!(shp->Valid) || shp->ReadOnly == 0)
+	return -1;
+#ifdef SHP_MEMORY_MAP
+    if (map != NULL && map->shx != NULL)
+	size = (long) (map->shx_size);
+    else
+#endif
+      {
+	  if (fseek (shp->flShx, 0, SEEK_END) != 0)
+	      return -1;
+	  size = ftell (shp->flShx);
+      }
+    if (size < 100)
+	return -1;
+    return (int) ((size - 100) / 8);
+}
+
+GAIAGEO_DECLARE int
+gaiaReadShpEntityMbr (gaiaShapefilePtr shp, int current_row, double *minx,
+		      double *miny, double *maxx, double *maxy)
+{
+/*
+/ reading the MBR of some feature directly from the SHP record
+/ header, without decoding either the Geometry or the DBF values
+*/
+    unsigned char buf[512];
+    const unsigned char *p_buf;
+    int rd;
+    int offset;
+    int shape;
+    *minx = DBL_MAX;
+    *miny = DBL_MAX;
+    *maxx = -DBL_MAX;
+    *maxy = -DBL_MAX;
+    if (!(shp->Valid) || shp->ReadOnly == 0 || current_row < 0)
+	return 0;
+/* positioning and reading the SHX file */
+    offset = 100 + (current_row * 8);
+    p_buf = shp_read_at (shp, SHP_FILE_SHX, offset, 8, buf, &rd);
+    if (rd != 8)
+	return 0;
+    offset = gaiaImport32 (p_buf, GAIA_BIG_ENDIAN, shp->endian_arch) * 2;
+/* reading the SHP record header */
+    p_buf = shp_read_at (shp, SHP_FILE_SHP, offset, 12, buf, &rd);
+    if (rd != 12)
+	return 0;
+    shape = gaiaImport32 (p_buf + 8, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+    if (shape != shp->Shape)
+	return 1;		/* NULL or mismatching shape: empty MBR */
+    if (shape == GAIA_SHP_POINT || shape == GAIA_SHP_POINTZ
+	|| shape == GAIA_SHP_POINTM)
+      {
+	  p_buf = shp_read_next (shp, 16, &rd);
+	  if (rd != 16)
+	      return 0;
+	  *minx = gaiaImport64 (p_buf, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  *miny =
+	      gaiaImport64 (p_buf + 8, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  *maxx = *minx;
+	  *maxy = *miny;
+	  return 1;
+      }
+/* any other shape starts by its own BBOX */
+    p_buf = shp_read_next (shp, 32, &rd);
+    if (rd != 32)
+	return 0;
+    *minx = gaiaImport64 (p_buf, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+    *miny = gaiaImport64 (p_buf + 8, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+    *maxx = gaiaImport64 (p_buf + 16, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+    *maxy = gaiaImport64 (p_buf + 24, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+    return 1;
+}
+
 static void
 gaiaSaneClockwise (gaiaPolygonPtr polyg)
 {
@@ -4417,8 +5230,9 @@ gaiaShpAnalyze (gaiaShapefilePtr shp)
 / the same check is needed in order to detect if there are POLYGONS or MULTIPOLYGONS 
  */
     unsigned char buf[512];
+    const unsigned char *p_buf;
+    const unsigned char *buf_shp = NULL;
     int rd;
-    int skpos;
     int offset;
     int off_shp;
     int sz;
@@ -4444,23 +5258,17 @@ gaiaShpAnalyze (gaiaShapefilePtr shp)
       {
 	  /* positioning and reading the SHX file */
 	  offset = 100 + (current_row * 8);	/* 100 bytes for the header + current row displacement; each SHX row = 8 bytes */
-	  skpos = fseek (shp->flShx, offset, SEEK_SET);
-	  if (skpos != 0)
-	      goto exit;
-	  rd = fread (buf, sizeof (unsigned char), 8, shp->flShx);
+	  p_buf = shp_read_at (shp, SHP_FILE_SHX, offset, 8, buf, &rd);
 	  if (rd != 8)
 	      goto exit;
-	  off_shp = gaiaImport32 (buf, GAIA_BIG_ENDIAN, shp->endian_arch);
+	  off_shp = gaiaImport32 (p_buf, GAIA_BIG_ENDIAN, shp->endian_arch);
 	  /* positioning and reading corresponding SHP entity - geometry */
 	  offset = off_shp * 2;
-	  skpos = fseek (shp->flShp, offset, SEEK_SET);
-	  if (skpos != 0)
-	      goto exit;
-	  rd = fread (buf, sizeof (unsigned char), 12, shp->flShp);
+	  p_buf = shp_read_at (shp, SHP_FILE_SHP, offset, 12, buf, &rd);
 	  if (rd != 12)
 	      goto exit;
-	  sz = gaiaImport32 (buf + 4, GAIA_BIG_ENDIAN, shp->endian_arch);
-	  shape = gaiaImport32 (buf + 8, GAIA_LITTLE_ENDIAN, shp->endian_arch);
+	  sz = gaiaImport32 (p_buf + 4, GAIA_BIG_ENDIAN, shp->endian_arch);
+	  shape = gaiaImport32 (p_buf + 8, GAIA_LITTLE_ENDIAN, shp->endian_arch);
 	  if ((sz * 2) > shp->ShpBfsz)
 	    {
 		/* current buffer is too small; we need to allocate a bigger buffer */
@@ -4472,18 +5280,16 @@ gaiaShpAnalyze (gaiaShapefilePtr shp)
 	      || shape == GAIA_SHP_POLYLINEM)
 	    {
 		/* shape polyline */
-		rd = fread (shp->BufShp, sizeof (unsigned char), 32,
-			    shp->flShp);
+		buf_shp = shp_read_next (shp, 32, &rd);
 		if (rd != 32)
 		    goto exit;
-		rd = fread (shp->BufShp, sizeof (unsigned char),
-			    (sz * 2) - 36, shp->flShp);
+		buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 		if (rd != (sz * 2) - 36)
 		    goto exit;
-		n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN,
-				  shp->endian_arch);
-		n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-				   shp->endian_arch);
+		if (!shp_parse_parts
+		    (buf_shp, rd, (shape == GAIA_SHP_POLYLINEZ) ? 1 : 0,
+		     shp->endian_arch, &n, &n1))
+		    goto exit;
 		if (n > 1)
 		    multi++;
 		if (shape == GAIA_SHP_POLYLINEZ)
@@ -4503,25 +5309,23 @@ gaiaShpAnalyze (gaiaShapefilePtr shp)
 		ringsColl.First = NULL;
 		ringsColl.Last = NULL;
 
-		rd = fread (shp->BufShp, sizeof (unsigned char), 32,
-			    shp->flShp);
+		buf_shp = shp_read_next (shp, 32, &rd);
 		if (rd != 32)
 		    goto exit;
-		rd = fread (shp->BufShp, sizeof (unsigned char),
-			    (sz * 2) - 36, shp->flShp);
+		buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 		if (rd != (sz * 2) - 36)
 		    goto exit;
-		n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN,
-				  shp->endian_arch);
-		n1 = gaiaImport32 (shp->BufShp + 4, GAIA_LITTLE_ENDIAN,
-				   shp->endian_arch);
+		if (!shp_parse_parts
+		    (buf_shp, rd, (shape == GAIA_SHP_POLYGONZ) ? 1 : 0,
+		     shp->endian_arch, &n, &n1))
+		    goto exit;
 		base = 8 + (n * 4);
 		start = 0;
 		for (ind = 0; ind < n; ind++)
 		  {
 		      if (ind < (n - 1))
 			  end =
-			      gaiaImport32 (shp->BufShp + 8 +
+			      gaiaImport32 (buf_shp + 8 +
 					    ((ind + 1) * 4),
 					    GAIA_LITTLE_ENDIAN,
 					    shp->endian_arch);
@@ -4532,10 +5336,10 @@ gaiaShpAnalyze (gaiaShapefilePtr shp)
 		      points = 0;
 		      for (iv = start; iv < end; iv++)
 			{
-			    x = gaiaImport64 (shp->BufShp + base +
+			    x = gaiaImport64 (buf_shp + base +
 					      (iv * 16), GAIA_LITTLE_ENDIAN,
 					      shp->endian_arch);
-			    y = gaiaImport64 (shp->BufShp + base +
+			    y = gaiaImport64 (buf_shp + base +
 					      (iv * 16) + 8,
 					      GAIA_LITTLE_ENDIAN,
 					      shp->endian_arch);
@@ -4569,16 +5373,14 @@ gaiaShpAnalyze (gaiaShapefilePtr shp)
 	  if (shape == GAIA_SHP_MULTIPOINTZ)
 	    {
 		/* shape multipoint Z */
-		rd = fread (shp->BufShp, sizeof (unsigned char), 32,
-			    shp->flShp);
+		buf_shp = shp_read_next (shp, 32, &rd);
 		if (rd != 32)
 		    goto exit;
-		rd = fread (shp->BufShp, sizeof (unsigned char),
-			    (sz * 2) - 36, shp->flShp);
+		buf_shp = shp_read_next (shp, (sz * 2) - 36, &rd);
 		if (rd != (sz * 2) - 36)
 		    goto exit;
-		n = gaiaImport32 (shp->BufShp, GAIA_LITTLE_ENDIAN,
-				  shp->endian_arch);
+		if (!shp_parse_points (buf_shp, rd, 1, shp->endian_arch, &n))
+		    goto exit;
 		ZM_size = 38 + (n * 16);	/* size [in 16 bits words !!!] ZM */
 		if (sz == ZM_size)
 		    hasM = 1;
@@ -5229,4 +6031,59 @@ gaiaReadDbfEntity_ex (gaiaDbfPtr dbf, int current_row, int *deleted,
     return 0;
 }
 
+GAIAGEO_DECLARE int
+gaiaReadDbfEntityLazy (gaiaDbfPtr dbf, int current_row, int *deleted)
+{
+/* positioning on some DBF entity, but deferring any decoding */
+    int rd;
+    int skpos;
+    int offset;
+/* positioning and reading the DBF file */
+    offset = dbf->DbfHdsz + (current_row * dbf->DbfReclen);
+    skpos = fseek (dbf->flDbf, offset, SEEK_SET);
+    if (skpos != 0)
+	goto eof;
+    rd = fread (dbf->BufDbf, sizeof (unsigned char), dbf->DbfReclen,
+		dbf->flDbf);
+    if (rd != dbf->DbfReclen)
+	goto eof;
+/* setting up the current DBF ENTITY */
+    gaiaResetDbfEntity (dbf->Dbf);
+    dbf->Dbf->RowId = current_row;
+    if (*(dbf->BufDbf) == '*')
+	*deleted = 1;
+    else
+	*deleted = 0;
+    if (dbf->LastError)
+	free (dbf->LastError);
+    dbf->LastError = NULL;
+    return 1;
+  eof:
+    if (dbf->LastError)
+	free (dbf->LastError);
+    dbf->LastError = NULL;
+    return 0;
+}
+
+GAIAGEO_DECLARE int
+gaiaReadDbfEntityValue (gaiaDbfPtr dbf, gaiaDbfFieldPtr field,
+			int text_dates)
+{
+/* decoding a single DBF value from the last raw record read */
+    int len;
+    char errMsg[1024];
+    if (field->Value)
+	gaiaFreeValue (field->Value);
+    field->Value = NULL;
+    if (parseDbfField (dbf->BufDbf, dbf->IconvObj, field, text_dates))
+	return 1;
+    if (dbf->LastError)
+	free (dbf->LastError);
+    sprintf (errMsg, "Invalid character sequence");
+    len = strlen (errMsg);
+    dbf->LastError = malloc (len + 1);
+    strcpy (dbf->LastError, errMsg);
+    return 0;
+}
+
 #endif /* ICONV enabled/disabled */
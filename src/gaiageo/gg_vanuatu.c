@@ -48,6 +48,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <float.h>
 
 #include <assert.h>
 
@@ -61,6 +62,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <spatialite/debug.h>
 
 #include <spatialite/gaiageo.h>
+#include <spatialite_private.h>
 
 #if defined(_WIN32) || defined(WIN32)
 #include <io.h>
@@ -73,7 +75,6 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #endif
 
 #define VANUATU_DYN_NONE	0
-#define VANUATU_DYN_POINT	1
 #define VANUATU_DYN_LINESTRING	2
 #define VANUATU_DYN_POLYGON	3
 #define VANUATU_DYN_RING	4
@@ -81,6 +82,9 @@ the terms of any one of the MPL, the GPL or the LGPL.
 
 #define VANUATU_DYN_BLOCK 1024
 
+#define VANUATU_TOKEN_BLOCK	256
+#define VANUATU_POINT_BLOCK	128
+
 
 
 /*
@@ -163,7 +167,25 @@ struct vanuatu_dyn_block
     int type[VANUATU_DYN_BLOCK];
     void *ptr[VANUATU_DYN_BLOCK];
     int index;
+    int first;			/* all entries before this one are cleaned */
     struct vanuatu_dyn_block *next;
+    struct vanuatu_dyn_block *prev;
+};
+
+struct vanuatu_token_block
+{
+/* a block of token values (no malloc() for each single token) */
+    double value[VANUATU_TOKEN_BLOCK];
+    int count;
+    struct vanuatu_token_block *next;
+};
+
+struct vanuatu_point_block
+{
+/* a block of intermediate Points, all released at the end of parsing */
+    gaiaPoint point[VANUATU_POINT_BLOCK];
+    int count;
+    struct vanuatu_point_block *next;
 };
 
 struct vanuatu_data
@@ -174,6 +196,12 @@ struct vanuatu_data
     int vanuatu_col;
     struct vanuatu_dyn_block *vanuatu_first_dyn_block;
     struct vanuatu_dyn_block *vanuatu_last_dyn_block;
+    struct vanuatu_token_block vanuatu_first_token_block;
+    struct vanuatu_token_block *vanuatu_last_token_block;
+    struct vanuatu_point_block vanuatu_first_point_block;
+    struct vanuatu_point_block *vanuatu_last_point_block;
+    double vanuatu_sink_value;	/* handed out once the arena is out of memory */
+    gaiaPoint vanuatu_sink_point;
     gaiaGeomCollPtr result;
     YYSTYPE VanuatuWktlval;
 };
@@ -191,7 +219,9 @@ vanuatuCreateDynBlock (void)
 	  p->ptr[i] = NULL;
       }
     p->index = 0;
+    p->first = 0;
     p->next = NULL;
+    p->prev = NULL;
     return p;
 }
 
@@ -211,6 +241,7 @@ vanuatuMapDynAlloc (struct vanuatu_data *p_data, int type, void *ptr)
       {
 	  /* adding a further block to the map */
 	  p = vanuatuCreateDynBlock ();
+	  p->prev = p_data->vanuatu_last_dyn_block;
 	  p_data->vanuatu_last_dyn_block->next = p;
 	  p_data->vanuatu_last_dyn_block = p;
       }
@@ -221,32 +252,74 @@ vanuatuMapDynAlloc (struct vanuatu_data *p_data, int type, void *ptr)
     p_data->vanuatu_last_dyn_block->index++;
 }
 
+static void
+vanuatuMapDynRemove (struct vanuatu_data *p_data, struct vanuatu_dyn_block *p,
+		     int i)
+{
+/* marking a map entry as cleaned */
+    p->type[i] = VANUATU_DYN_NONE;
+    p->ptr[i] = NULL;
+    while (p->first < p->index && p->type[p->first] == VANUATU_DYN_NONE)
+	p->first++;
+    if (p == p_data->vanuatu_last_dyn_block)
+      {
+	  /* trailing cleaned entries can be immediately recycled */
+	  while (p->index > p->first
+		 && p->type[p->index - 1] == VANUATU_DYN_NONE)
+	      p->index--;
+      }
+}
+
 static void
 vanuatuMapDynClean (struct vanuatu_data *p_data, void *ptr)
 {
-/* deleting a dynamic allocation from the map */
-    int i;
-    struct vanuatu_dyn_block *p = p_data->vanuatu_first_dyn_block;
-    while (p)
+/*
+/ deleting a dynamic allocation from the map
+/
+/ objects are almost always consumed either in the same order
+/ they were allocated (e.g. a list of Linestrings) or just after
+/ being allocated (e.g. the Rings of a Polygon): so we'll search
+/ from both ends of the map at the same time, skipping over any
+/ leading entry already cleaned
+*/
+    int i_fwd;
+    int i_bwd;
+    struct vanuatu_dyn_block *fwd = p_data->vanuatu_first_dyn_block;
+    struct vanuatu_dyn_block *bwd = p_data->vanuatu_last_dyn_block;
+    if (fwd == NULL)
+	return;
+    i_fwd = fwd->first;
+    i_bwd = bwd->index - 1;
+    while (1)
       {
-	  for (i = 0; i < VANUATU_DYN_BLOCK; i++)
+	  while (fwd != NULL && i_fwd >= fwd->index)
 	    {
-		switch (p->type[i])
-		  {
-		  case VANUATU_DYN_POINT:
-		  case VANUATU_DYN_LINESTRING:
-		  case VANUATU_DYN_POLYGON:
-		  case VANUATU_DYN_RING:
-		  case VANUATU_DYN_GEOMETRY:
-		      if (p->ptr[i] == ptr)
-			{
-			    p->type[i] = VANUATU_DYN_NONE;
-			    return;
-			}
-		      break;
-		  };
+		fwd = fwd->next;
+		if (fwd != NULL)
+		    i_fwd = fwd->first;
 	    }
-	  p = p->next;
+	  while (bwd != NULL && i_bwd < bwd->first)
+	    {
+		bwd = bwd->prev;
+		if (bwd != NULL)
+		    i_bwd = bwd->index - 1;
+	    }
+	  if (fwd == NULL || bwd == NULL)
+	      return;
+	  if (fwd->type[i_fwd] != VANUATU_DYN_NONE && fwd->ptr[i_fwd] == ptr)
+	    {
+		vanuatuMapDynRemove (p_data, fwd, i_fwd);
+		return;
+	    }
+	  if (bwd->type[i_bwd] != VANUATU_DYN_NONE && bwd->ptr[i_bwd] == ptr)
+	    {
+		vanuatuMapDynRemove (p_data, bwd, i_bwd);
+		return;
+	    }
+	  if (fwd == bwd && i_fwd >= i_bwd)
+	      return;
+	  i_fwd++;
+	  i_bwd--;
       }
 }
 
@@ -266,9 +339,6 @@ vanuatuCleanMapDynAlloc (struct vanuatu_data *p_data, int clean_all)
 		      /* deleting Geometry objects */
 		      switch (p->type[i])
 			{
-			case VANUATU_DYN_POINT:
-			    gaiaFreePoint ((gaiaPointPtr) (p->ptr[i]));
-			    break;
 			case VANUATU_DYN_LINESTRING:
 			    gaiaFreeLinestring ((gaiaLinestringPtr)
 						(p->ptr[i]));
@@ -292,6 +362,102 @@ vanuatuCleanMapDynAlloc (struct vanuatu_data *p_data, int clean_all)
       }
 }
 
+static void
+vanuatuInitArena (struct vanuatu_data *p_data)
+{
+/* initializing the token and point arenas (first blocks are embedded) */
+    p_data->vanuatu_first_token_block.count = 0;
+    p_data->vanuatu_first_token_block.next = NULL;
+    p_data->vanuatu_last_token_block = &(p_data->vanuatu_first_token_block);
+    p_data->vanuatu_first_point_block.count = 0;
+    p_data->vanuatu_first_point_block.next = NULL;
+    p_data->vanuatu_last_point_block = &(p_data->vanuatu_first_point_block);
+}
+
+static void
+vanuatuCleanArena (struct vanuatu_data *p_data)
+{
+/* releasing the token and point arenas */
+    struct vanuatu_token_block *pt;
+    struct vanuatu_token_block *ptn;
+    struct vanuatu_point_block *pp;
+    struct vanuatu_point_block *ppn;
+    pt = p_data->vanuatu_first_token_block.next;
+    while (pt)
+      {
+	  ptn = pt->next;
+	  free (pt);
+	  pt = ptn;
+      }
+    pp = p_data->vanuatu_first_point_block.next;
+    while (pp)
+      {
+	  ppn = pp->next;
+	  free (pp);
+	  pp = ppn;
+      }
+}
+
+static double *
+vanuatuTokenValue (struct vanuatu_data *p_data, double value)
+{
+/* storing a token value into the arena */
+    struct vanuatu_token_block *p = p_data->vanuatu_last_token_block;
+    if (p->count >= VANUATU_TOKEN_BLOCK)
+      {
+	  /* adding a further block */
+	  p->next = malloc (sizeof (struct vanuatu_token_block));
+	  if (p->next == NULL)
+	    {
+		/* out of memory: the parse will fail */
+		p_data->vanuatu_parse_error = 1;
+		p_data->vanuatu_sink_value = 0.0;
+		return &(p_data->vanuatu_sink_value);
+	    }
+	  p = p->next;
+	  p->count = 0;
+	  p->next = NULL;
+	  p_data->vanuatu_last_token_block = p;
+      }
+    p->value[p->count] = value;
+    return p->value + p->count++;
+}
+
+static gaiaPointPtr
+vanuatuArenaPoint (struct vanuatu_data *p_data, double x, double y, double z,
+		   double m, int dimension_model)
+{
+/* allocating an intermediate Point from the arena */
+    gaiaPointPtr pt;
+    struct vanuatu_point_block *p = p_data->vanuatu_last_point_block;
+    if (p->count >= VANUATU_POINT_BLOCK)
+      {
+	  /* adding a further block */
+	  p->next = malloc (sizeof (struct vanuatu_point_block));
+	  if (p->next == NULL)
+	    {
+		/* out of memory: the parse will fail */
+		p_data->vanuatu_parse_error = 1;
+		pt = &(p_data->vanuatu_sink_point);
+		memset (pt, 0, sizeof (gaiaPoint));
+		return pt;
+	    }
+	  p = p->next;
+	  p->count = 0;
+	  p->next = NULL;
+	  p_data->vanuatu_last_point_block = p;
+      }
+    pt = p->point + p->count++;
+    pt->X = x;
+    pt->Y = y;
+    pt->Z = z;
+    pt->M = m;
+    pt->DimensionModel = dimension_model;
+    pt->Next = NULL;
+    pt->Prev = NULL;
+    return pt;
+}
+
 static int
 vanuatuCheckValidity (gaiaGeomCollPtr geom)
 {
@@ -339,6 +505,42 @@ vanuatuCheckValidity (gaiaGeomCollPtr geom)
     return 1;
 }
 
+static void
+vanuatuAttachLinestrings (struct vanuatu_data *p_data, gaiaGeomCollPtr geom,
+			  gaiaLinestringPtr first)
+{
+/* moving a list of Linestrings into a Geometry (no coordinate copies) */
+    gaiaLinestringPtr p = first;
+    while (p)
+      {
+	  vanuatuMapDynClean (p_data, p);
+	  if (geom->FirstLinestring == NULL)
+	      geom->FirstLinestring = p;
+	  if (geom->LastLinestring != NULL)
+	      geom->LastLinestring->Next = p;
+	  geom->LastLinestring = p;
+	  p = p->Next;
+      }
+}
+
+static void
+vanuatuAttachPolygons (struct vanuatu_data *p_data, gaiaGeomCollPtr geom,
+		       gaiaPolygonPtr first)
+{
+/* moving a list of Polygons into a Geometry (no coordinate copies) */
+    gaiaPolygonPtr p = first;
+    while (p)
+      {
+	  vanuatuMapDynClean (p_data, p);
+	  if (geom->FirstPolygon == NULL)
+	      geom->FirstPolygon = p;
+	  if (geom->LastPolygon != NULL)
+	      geom->LastPolygon->Next = p;
+	  geom->LastPolygon = p;
+	  p = p->Next;
+      }
+}
+
 static gaiaGeomCollPtr
 gaiaGeometryFromPoint (struct vanuatu_data *p_data, gaiaPointPtr point)
 {
@@ -348,8 +550,6 @@ gaiaGeometryFromPoint (struct vanuatu_data *p_data, gaiaPointPtr point)
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINT;
     gaiaAddPointToGeomColl (geom, point->X, point->Y);
-    vanuatuMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -362,8 +562,6 @@ gaiaGeometryFromPointZ (struct vanuatu_data *p_data, gaiaPointPtr point)
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINTZ;
     gaiaAddPointToGeomCollXYZ (geom, point->X, point->Y, point->Z);
-    vanuatuMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -376,8 +574,6 @@ gaiaGeometryFromPointM (struct vanuatu_data *p_data, gaiaPointPtr point)
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINTM;
     gaiaAddPointToGeomCollXYM (geom, point->X, point->Y, point->M);
-    vanuatuMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -390,8 +586,6 @@ gaiaGeometryFromPointZM (struct vanuatu_data *p_data, gaiaPointPtr point)
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_POINTZM;
     gaiaAddPointToGeomCollXYZM (geom, point->X, point->Y, point->Z, point->M);
-    vanuatuMapDynClean (p_data, point);
-    gaiaFreePoint (point);
     return geom;
 }
 
@@ -400,22 +594,10 @@ gaiaGeometryFromLinestring (struct vanuatu_data *p_data, gaiaLinestringPtr line)
 {
 /* builds a GEOMETRY containing a LINESTRING */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
     geom = gaiaAllocGeomColl ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPoint (line->Coords, iv, &x, &y);
-	  gaiaSetPoint (line2->Coords, iv, x, y);
-      }
-    vanuatuMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    vanuatuAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -425,23 +607,10 @@ gaiaGeometryFromLinestringZ (struct vanuatu_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRINGZ */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
-    double z;
     geom = gaiaAllocGeomCollXYZ ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPointXYZ (line->Coords, iv, &x, &y, &z);
-	  gaiaSetPointXYZ (line2->Coords, iv, x, y, z);
-      }
-    vanuatuMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    vanuatuAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -452,23 +621,10 @@ gaiaGeometryFromLinestringM (struct vanuatu_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRINGM */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
-    double m;
     geom = gaiaAllocGeomCollXYM ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPointXYM (line->Coords, iv, &x, &y, &m);
-	  gaiaSetPointXYM (line2->Coords, iv, x, y, m);
-      }
-    vanuatuMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    vanuatuAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -478,24 +634,10 @@ gaiaGeometryFromLinestringZM (struct vanuatu_data *p_data,
 {
 /* builds a GEOMETRY containing a LINESTRINGZM */
     gaiaGeomCollPtr geom = NULL;
-    gaiaLinestringPtr line2;
-    int iv;
-    double x;
-    double y;
-    double z;
-    double m;
     geom = gaiaAllocGeomCollXYZM ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
     geom->DeclaredType = GAIA_LINESTRING;
-    line2 = gaiaAddLinestringToGeomColl (geom, line->Points);
-    for (iv = 0; iv < line2->Points; iv++)
-      {
-	  /* sets the POINTS for the exterior ring */
-	  gaiaGetPointXYZM (line->Coords, iv, &x, &y, &z, &m);
-	  gaiaSetPointXYZM (line2->Coords, iv, x, y, z, m);
-      }
-    vanuatuMapDynClean (p_data, line);
-    gaiaFreeLinestring (line);
+    vanuatuAttachLinestrings (p_data, geom, line);
     return geom;
 }
 
@@ -533,9 +675,7 @@ Greg Wilson			gvwilson@cs.toronto.ca
 static gaiaPointPtr
 vanuatu_point_xy (struct vanuatu_data *p_data, double *x, double *y)
 {
-    gaiaPointPtr pt = gaiaAllocPoint (*x, *y);
-    vanuatuMapDynAlloc (p_data, VANUATU_DYN_POINT, pt);
-    return pt;
+    return vanuatuArenaPoint (p_data, *x, *y, 0.0, 0.0, GAIA_XY);
 }
 
 /* 
@@ -550,9 +690,7 @@ vanuatu_point_xy (struct vanuatu_data *p_data, double *x, double *y)
 static gaiaPointPtr
 vanuatu_point_xyz (struct vanuatu_data *p_data, double *x, double *y, double *z)
 {
-    gaiaPointPtr pt = gaiaAllocPointXYZ (*x, *y, *z);
-    vanuatuMapDynAlloc (p_data, VANUATU_DYN_POINT, pt);
-    return pt;
+    return vanuatuArenaPoint (p_data, *x, *y, *z, 0.0, GAIA_XY_Z);
 }
 
 /* 
@@ -565,9 +703,7 @@ vanuatu_point_xyz (struct vanuatu_data *p_data, double *x, double *y, double *z)
 static gaiaPointPtr
 vanuatu_point_xym (struct vanuatu_data *p_data, double *x, double *y, double *m)
 {
-    gaiaPointPtr pt = gaiaAllocPointXYM (*x, *y, *m);
-    vanuatuMapDynAlloc (p_data, VANUATU_DYN_POINT, pt);
-    return pt;
+    return vanuatuArenaPoint (p_data, *x, *y, 0.0, *m, GAIA_XY_M);
 }
 
 /* 
@@ -581,9 +717,7 @@ gaiaPointPtr
 vanuatu_point_xyzm (struct vanuatu_data * p_data, double *x, double *y,
 		    double *z, double *m)
 {
-    gaiaPointPtr pt = gaiaAllocPointXYZM (*x, *y, *z, *m);
-    vanuatuMapDynAlloc (p_data, VANUATU_DYN_POINT, pt);
-    return pt;
+    return vanuatuArenaPoint (p_data, *x, *y, *z, *m, GAIA_XY_Z_M);
 }
 
 /*
@@ -623,7 +757,6 @@ static gaiaLinestringPtr
 vanuatu_linestring_xy (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -641,10 +774,7 @@ vanuatu_linestring_xy (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPoint (linestring->Coords, i, p->X, p->Y);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -663,7 +793,6 @@ static gaiaLinestringPtr
 vanuatu_linestring_xyz (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -681,10 +810,7 @@ vanuatu_linestring_xyz (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPointXYZ (linestring->Coords, i, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -703,7 +829,6 @@ static gaiaLinestringPtr
 vanuatu_linestring_xym (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -721,10 +846,7 @@ vanuatu_linestring_xym (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPointXYM (linestring->Coords, i, p->X, p->Y, p->M);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -743,7 +865,6 @@ static gaiaLinestringPtr
 vanuatu_linestring_xyzm (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     int points = 0;
     int i = 0;
     gaiaLinestringPtr linestring;
@@ -761,10 +882,7 @@ vanuatu_linestring_xyzm (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaSetPointXYZM (linestring->Coords, i, p->X, p->Y, p->Z, p->M);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
 	  i++;
       }
 
@@ -821,7 +939,6 @@ static gaiaRingPtr
 vanuatu_ring_xy (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -846,10 +963,7 @@ vanuatu_ring_xy (struct vanuatu_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPoint (ring->Coords, index, p->X, p->Y);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -867,7 +981,6 @@ static gaiaRingPtr
 vanuatu_ring_xyz (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -892,10 +1005,7 @@ vanuatu_ring_xyz (struct vanuatu_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPointXYZ (ring->Coords, index, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -913,7 +1023,6 @@ static gaiaRingPtr
 vanuatu_ring_xym (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -938,10 +1047,7 @@ vanuatu_ring_xym (struct vanuatu_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPointXYM (ring->Coords, index, p->X, p->Y, p->M);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -959,7 +1065,6 @@ static gaiaRingPtr
 vanuatu_ring_xyzm (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaRingPtr ring = NULL;
     int numpoints;
     int index;
@@ -984,10 +1089,7 @@ vanuatu_ring_xyzm (struct vanuatu_data *p_data, gaiaPointPtr first)
     for (index = 0; index < numpoints; index++)
       {
 	  gaiaSetPointXYZM (ring->Coords, index, p->X, p->Y, p->Z, p->M);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
 
     return ring;
@@ -1007,27 +1109,52 @@ vanuatu_polygon_any_type (struct vanuatu_data *p_data, gaiaRingPtr first)
 {
     gaiaRingPtr p;
     gaiaRingPtr p_n;
+    gaiaRingPtr interior;
     gaiaPolygonPtr polygon;
+    int ib = 0;
     /* If no pointers are given, return. */
     if (first == NULL)
 	return NULL;
 
-    /* Creates and allocates a polygon structure with the exterior ring. */
-    polygon = gaiaCreatePolygon (first);
-    if (polygon == NULL)
-	return NULL;
+    /*
+     * Creates a polygon structure directly owning the exterior ring;
+     * the interior rings are then moved (not copied) into the polygon.
+     */
+    polygon = malloc (sizeof (gaiaPolygon));
+    polygon->Exterior = first;
+    polygon->NumInteriors = 0;
+    polygon->NextInterior = 0;
+    polygon->Interiors = NULL;
+    polygon->Next = NULL;
+    polygon->MinX = DBL_MAX;
+    polygon->MinY = DBL_MAX;
+    polygon->MaxX = -DBL_MAX;
+    polygon->MaxY = -DBL_MAX;
+    polygon->DimensionModel = first->DimensionModel;
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_POLYGON, polygon);
+    vanuatuMapDynClean (p_data, first);
+
+    p = first->Next;
+    while (p != NULL)
+      {
+	  polygon->NumInteriors++;
+	  p = p->Next;
+      }
+    if (polygon->NumInteriors > 0)
+	polygon->Interiors =
+	    malloc (sizeof (gaiaRing) * polygon->NumInteriors);
 
     /* Adds all interior rings into the polygon structure. */
-    p = first;
+    p = first->Next;
+    first->Next = NULL;
     while (p != NULL)
       {
 	  p_n = p->Next;
 	  vanuatuMapDynClean (p_data, p);
-	  if (p == first)
-	      gaiaFreeRing (p);
-	  else
-	      gaiaAddRingToPolyg (polygon, p);
+	  interior = polygon->Interiors + ib++;
+	  memcpy (interior, p, sizeof (gaiaRing));
+	  interior->Next = NULL;
+	  free (p);
 	  p = p_n;
       }
 
@@ -1158,7 +1285,6 @@ static gaiaGeomCollPtr
 vanuatu_multipoint_xy (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1176,10 +1302,7 @@ vanuatu_multipoint_xy (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomColl (geom, p->X, p->Y);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1196,7 +1319,6 @@ static gaiaGeomCollPtr
 vanuatu_multipoint_xyz (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1214,10 +1336,7 @@ vanuatu_multipoint_xyz (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomCollXYZ (geom, p->X, p->Y, p->Z);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1234,7 +1353,6 @@ static gaiaGeomCollPtr
 vanuatu_multipoint_xym (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1252,10 +1370,7 @@ vanuatu_multipoint_xym (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomCollXYM (geom, p->X, p->Y, p->M);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1272,7 +1387,6 @@ static gaiaGeomCollPtr
 vanuatu_multipoint_xyzm (struct vanuatu_data *p_data, gaiaPointPtr first)
 {
     gaiaPointPtr p = first;
-    gaiaPointPtr p_n;
     gaiaGeomCollPtr geom = NULL;
 
     /* If no pointers are given, return. */
@@ -1290,10 +1404,7 @@ vanuatu_multipoint_xyzm (struct vanuatu_data *p_data, gaiaPointPtr first)
     while (p != NULL)
       {
 	  gaiaAddPointToGeomCollXYZM (geom, p->X, p->Y, p->Z, p->M);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePoint (p);
-	  p = p_n;
+	  p = p->Next;
       }
     return geom;
 }
@@ -1311,23 +1422,12 @@ static gaiaGeomCollPtr
 vanuatu_multilinestring_xy (struct vanuatu_data *p_data,
 			    gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomColl ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    vanuatuAttachLinestrings (p_data, a, first);
 
     return a;
 }
@@ -1345,23 +1445,12 @@ static gaiaGeomCollPtr
 vanuatu_multilinestring_xyz (struct vanuatu_data *p_data,
 			     gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomCollXYZ ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY_Z;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    vanuatuAttachLinestrings (p_data, a, first);
     return a;
 }
 
@@ -1378,23 +1467,12 @@ static gaiaGeomCollPtr
 vanuatu_multilinestring_xym (struct vanuatu_data *p_data,
 			     gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomCollXYM ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY_M;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    vanuatuAttachLinestrings (p_data, a, first);
 
     return a;
 }
@@ -1412,23 +1490,12 @@ static gaiaGeomCollPtr
 vanuatu_multilinestring_xyzm (struct vanuatu_data *p_data,
 			      gaiaLinestringPtr first)
 {
-    gaiaLinestringPtr p = first;
-    gaiaLinestringPtr p_n;
-    gaiaLinestringPtr new_line;
     gaiaGeomCollPtr a = gaiaAllocGeomCollXYZM ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, a);
     a->DeclaredType = GAIA_MULTILINESTRING;
     a->DimensionModel = GAIA_XY_Z_M;
 
-    while (p)
-      {
-	  new_line = gaiaAddLinestringToGeomColl (a, p->Points);
-	  gaiaCopyLinestringCoords (new_line, p);
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreeLinestring (p);
-	  p = p_n;
-      }
+    vanuatuAttachLinestrings (p_data, a, first);
     return a;
 }
 
@@ -1448,37 +1515,12 @@ vanuatu_multilinestring_xyzm (struct vanuatu_data *p_data,
 static gaiaGeomCollPtr
 vanuatu_multipolygon_xy (struct vanuatu_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomColl ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    vanuatuAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1499,37 +1541,12 @@ vanuatu_multipolygon_xy (struct vanuatu_data *p_data, gaiaPolygonPtr first)
 static gaiaGeomCollPtr
 vanuatu_multipolygon_xyz (struct vanuatu_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomCollXYZ ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    vanuatuAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1550,37 +1567,12 @@ vanuatu_multipolygon_xyz (struct vanuatu_data *p_data, gaiaPolygonPtr first)
 static gaiaGeomCollPtr
 vanuatu_multipolygon_xym (struct vanuatu_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomCollXYM ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    vanuatuAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1601,37 +1593,12 @@ vanuatu_multipolygon_xym (struct vanuatu_data *p_data, gaiaPolygonPtr first)
 static gaiaGeomCollPtr
 vanuatu_multipolygon_xyzm (struct vanuatu_data *p_data, gaiaPolygonPtr first)
 {
-    gaiaPolygonPtr p = first;
-    gaiaPolygonPtr p_n;
-    int i = 0;
-    gaiaPolygonPtr new_polyg;
-    gaiaRingPtr i_ring;
-    gaiaRingPtr o_ring;
     gaiaGeomCollPtr geom = gaiaAllocGeomCollXYZM ();
     vanuatuMapDynAlloc (p_data, VANUATU_DYN_GEOMETRY, geom);
 
     geom->DeclaredType = GAIA_MULTIPOLYGON;
 
-    while (p)
-      {
-	  i_ring = p->Exterior;
-	  new_polyg =
-	      gaiaAddPolygonToGeomColl (geom, i_ring->Points, p->NumInteriors);
-	  o_ring = new_polyg->Exterior;
-	  gaiaCopyRingCoords (o_ring, i_ring);
-
-	  for (i = 0; i < new_polyg->NumInteriors; i++)
-	    {
-		i_ring = p->Interiors + i;
-		o_ring = gaiaAddInteriorRing (new_polyg, i, i_ring->Points);
-		gaiaCopyRingCoords (o_ring, i_ring);
-	    }
-
-	  p_n = p->Next;
-	  vanuatuMapDynClean (p_data, p);
-	  gaiaFreePolygon (p);
-	  p = p_n;
-      }
+    vanuatuAttachPolygons (p_data, geom, first);
 
     return geom;
 }
@@ -1824,48 +1791,70 @@ vanuatu_geomColl_xyzm (struct vanuatu_data *p_data, gaiaGeomCollPtr first)
 
 
 
-/*
-** This is a linked-list struct to store all the values for each token.
-** All tokens will have a value of 0, except tokens denoted as NUM.
-** NUM tokens are geometry coordinates and will contain the floating
-** point number.
-*/
-typedef struct vanuatuFlexTokenStruct
+struct vanuatu_parser
 {
-    double value;
-    struct vanuatuFlexTokenStruct *Next;
-} vanuatuFlexToken;
+/* a reusable Lemon parser and Flex scanner (one for each connection) */
+    void *lemon;
+    yyscan_t scanner;
+    int busy;
+};
 
-/*
-** Function to clean up the linked-list of token values.
-*/
-static int
-vanuatu_cleanup (vanuatuFlexToken * token)
+static void
+vanuatu_reset_lemon (void *p)
 {
-    vanuatuFlexToken *ptok;
-    vanuatuFlexToken *ptok_n;
-    if (token == NULL)
-	return 0;
-    ptok = token;
-    while (ptok)
+/* resetting a Lemon parser to its initial state, so to be reused */
+    yyParser *pParser = (yyParser *) p;
+    while (pParser->yyidx >= 0)
+	yy_pop_parser_stack (pParser);
+}
+
+static struct vanuatu_parser *
+vanuatu_get_parser (const void *p_cache)
+{
+/* returning the reusable WKT parser of this connection */
+    struct vanuatu_parser *parser;
+    struct splite_internal_cache *cache =
+	(struct splite_internal_cache *) p_cache;
+    if (cache == NULL)
+	return NULL;
+    if (cache->magic1 != SPATIALITE_CACHE_MAGIC1
+	|| cache->magic2 != SPATIALITE_CACHE_MAGIC2)
+	return NULL;
+    parser = (struct vanuatu_parser *) (cache->wkt_parser);
+    if (parser == NULL)
       {
-	  ptok_n = ptok->Next;
-	  free (ptok);
-	  ptok = ptok_n;
+	  /* lazily creating the parser on first use */
+	  parser = malloc (sizeof (struct vanuatu_parser));
+	  parser->lemon = ParseAlloc (malloc);
+	  VanuatuWktlex_init_extra (NULL, &(parser->scanner));
+	  parser->busy = 0;
+	  cache->wkt_parser = parser;
       }
-    return 0;
+    if (parser->busy)
+	return NULL;
+    return parser;
 }
 
-gaiaGeomCollPtr
-gaiaParseWkt (const unsigned char *dirty_buffer, short type)
+SPATIALITE_PRIVATE void
+gaiaWktParserDestroy (void *p)
 {
-    void *pParser = ParseAlloc (malloc);
-    /* Linked-list of token values */
-    vanuatuFlexToken *tokens = malloc (sizeof (vanuatuFlexToken));
-    /* Pointer to the head of the list */
-    vanuatuFlexToken *head = tokens;
+/* memory cleanup - destroying a reusable WKT parser */
+    struct vanuatu_parser *parser = (struct vanuatu_parser *) p;
+    if (parser == NULL)
+	return;
+    ParseFree (parser->lemon, free);
+    VanuatuWktlex_destroy (parser->scanner);
+    free (parser);
+}
+
+static gaiaGeomCollPtr
+vanuatu_parse (struct vanuatu_parser *parser,
+	       const unsigned char *dirty_buffer, short type)
+{
+    void *pParser;
     int yv;
     yyscan_t scanner;
+    YY_BUFFER_STATE buffer;
     struct vanuatu_data str_data;
 
 /* initializing the helper structs */
@@ -1875,13 +1864,24 @@ gaiaParseWkt (const unsigned char *dirty_buffer, short type)
     str_data.vanuatu_first_dyn_block = NULL;
     str_data.vanuatu_last_dyn_block = NULL;
     str_data.result = NULL;
+    vanuatuInitArena (&str_data);
 
-/* initializing the scanner state */
-    VanuatuWktlex_init_extra (&str_data, &scanner);
-
-    tokens->Next = NULL;
+/* initializing the parser and scanner state */
+    if (parser != NULL)
+      {
+	  /* reusing the connection's own parser */
+	  parser->busy = 1;
+	  pParser = parser->lemon;
+	  scanner = parser->scanner;
+	  VanuatuWktset_extra (&str_data, scanner);
+      }
+    else
+      {
+	  pParser = ParseAlloc (malloc);
+	  VanuatuWktlex_init_extra (&str_data, &scanner);
+      }
 
-    VanuatuWkt_scan_string ((char *) dirty_buffer, scanner);
+    buffer = VanuatuWkt_scan_string ((char *) dirty_buffer, scanner);
 
     /*
        / Keep tokenizing until we reach the end
@@ -1894,21 +1894,27 @@ gaiaParseWkt (const unsigned char *dirty_buffer, short type)
 		str_data.vanuatu_parse_error = 1;
 		break;
 	    }
-	  tokens->Next = malloc (sizeof (vanuatuFlexToken));
-	  tokens->Next->Next = NULL;
-	  tokens->Next->value = str_data.VanuatuWktlval.dval;
 	  /* Pass the token to the wkt parser created from lemon */
-	  Parse (pParser, yv, &(tokens->Next->value), &str_data);
-	  tokens = tokens->Next;
+	  Parse (pParser, yv,
+		 vanuatuTokenValue (&str_data, str_data.VanuatuWktlval.dval),
+		 &str_data);
+	  if (str_data.vanuatu_parse_error)
+	      break;
       }
     /* This denotes the end of a line as well as the end of the parser */
     Parse (pParser, VANUATU_NEWLINE, 0, &str_data);
-    ParseFree (pParser, free);
-    VanuatuWktlex_destroy (scanner);
-
-    /* Assigning the token as the end to avoid seg faults while cleaning */
-    tokens->Next = NULL;
-    vanuatu_cleanup (head);
+    VanuatuWkt_delete_buffer (buffer, scanner);
+    if (parser != NULL)
+      {
+	  vanuatu_reset_lemon (pParser);
+	  parser->busy = 0;
+      }
+    else
+      {
+	  ParseFree (pParser, free);
+	  VanuatuWktlex_destroy (scanner);
+      }
+    vanuatuCleanArena (&str_data);
 
     /*
      ** Sandro Furieri 2010 Apr 4
@@ -1959,6 +1965,19 @@ gaiaParseWkt (const unsigned char *dirty_buffer, short type)
     return str_data.result;
 }
 
+gaiaGeomCollPtr
+gaiaParseWkt (const unsigned char *dirty_buffer, short type)
+{
+    return vanuatu_parse (NULL, dirty_buffer, type);
+}
+
+GAIAGEO_DECLARE gaiaGeomCollPtr
+gaiaParseWkt_r (const void *p_cache, const unsigned char *dirty_buffer,
+		short type)
+{
+    return vanuatu_parse (vanuatu_get_parser (p_cache), dirty_buffer, type);
+}
+
 /******************************************************************************
 ** This is the end of the code that was created by Team Vanuatu 
 ** of The University of Toronto.
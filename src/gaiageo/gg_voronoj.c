@@ -123,159 +123,37 @@ struct concave_hull_str
     double count;
 };
 
-static double *
-voronoj_sorted_up (struct voronoj_aux *voronoj, int *count)
-{
-/* returning a sorted array of coordinates */
-    double *array = NULL;
-    int cnt = 0;
-    int ok = 1;
-    int i;
-    struct voronoj_point *pt = voronoj->first_up;
-    while (pt)
-      {
-	  /* counting how many points are there */
-	  cnt++;
-	  pt = pt->next;
-      }
-    *count = cnt;
-    if (cnt == 0)
-	return NULL;
-
-/* allocating and populating the array */
-    array = malloc (sizeof (double) * *count);
-    cnt = 0;
-    pt = voronoj->first_up;
-    while (pt)
-      {
-	  *(array + cnt++) = pt->coord;
-	  pt = pt->next;
-      }
-
-/* sorting the array */
-    while (ok)
-      {
-	  ok = 0;
-	  for (i = 1; i < *count; i++)
-	    {
-		if (*(array + i - 1) > *(array + i))
-		  {
-		      /* swapping two values */
-		      double save = *(array + i - 1);
-		      *(array + i - 1) = *(array + i);
-		      *(array + i) = save;
-		      ok = 1;
-		  }
-	    }
-      }
-    return array;
-}
-
-static double *
-voronoj_sorted_low (struct voronoj_aux *voronoj, int *count)
+struct voronoj_edge
 {
-/* returning a sorted array of coordinates */
-    double *array = NULL;
-    int cnt = 0;
-    int ok = 1;
-    int i;
-    struct voronoj_point *pt = voronoj->first_low;
-    while (pt)
-      {
-	  /* counting how many points are there */
-	  cnt++;
-	  pt = pt->next;
-      }
-    *count = cnt;
-    if (cnt == 0)
-	return NULL;
-
-/* allocating and populating the array */
-    array = malloc (sizeof (double) * *count);
-    cnt = 0;
-    pt = voronoj->first_low;
-    while (pt)
-      {
-	  *(array + cnt++) = pt->coord;
-	  pt = pt->next;
-      }
-
-/* sorting the array */
-    while (ok)
-      {
-	  ok = 0;
-	  for (i = 1; i < *count; i++)
-	    {
-		if (*(array + i - 1) > *(array + i))
-		  {
-		      /* swapping two values */
-		      double save = *(array + i - 1);
-		      *(array + i - 1) = *(array + i);
-		      *(array + i) = save;
-		      ok = 1;
-		  }
-	    }
-      }
-    return array;
-}
+/* an auxiliary struct - a triangle's edge (used to identify adjacent triangles) */
+    double x1;			/* lesser end-point */
+    double y1;
+    double x2;			/* greater end-point */
+    double y2;
+    struct voronoj_triangle *triangle;
+    int which;			/* 12, 23 or 31 */
+};
 
-static double *
-voronoj_sorted_left (struct voronoj_aux *voronoj, int *count)
+static int
+voronoj_cmp_coords (const void *p1, const void *p2)
 {
-/* returning a sorted array of coordinates */
-    double *array = NULL;
-    int cnt = 0;
-    int ok = 1;
-    int i;
-    struct voronoj_point *pt = voronoj->first_left;
-    while (pt)
-      {
-	  /* counting how many points are there */
-	  cnt++;
-	  pt = pt->next;
-      }
-    *count = cnt;
-    if (cnt == 0)
-	return NULL;
-
-/* allocating and populating the array */
-    array = malloc (sizeof (double) * *count);
-    cnt = 0;
-    pt = voronoj->first_left;
-    while (pt)
-      {
-	  *(array + cnt++) = pt->coord;
-	  pt = pt->next;
-      }
-
-/* sorting the array */
-    while (ok)
-      {
-	  ok = 0;
-	  for (i = 1; i < *count; i++)
-	    {
-		if (*(array + i - 1) > *(array + i))
-		  {
-		      /* swapping two values */
-		      double save = *(array + i - 1);
-		      *(array + i - 1) = *(array + i);
-		      *(array + i) = save;
-		      ok = 1;
-		  }
-	    }
-      }
-    return array;
+/* comparison function for QSORT - frame coordinates */
+    double c1 = *((const double *) p1);
+    double c2 = *((const double *) p2);
+    if (c1 < c2)
+	return -1;
+    if (c1 > c2)
+	return 1;
+    return 0;
 }
 
 static double *
-voronoj_sorted_right (struct voronoj_aux *voronoj, int *count)
+voronoj_sorted (struct voronoj_point *first, int *count)
 {
 /* returning a sorted array of coordinates */
     double *array = NULL;
     int cnt = 0;
-    int ok = 1;
-    int i;
-    struct voronoj_point *pt = voronoj->first_right;
+    struct voronoj_point *pt = first;
     while (pt)
       {
 	  /* counting how many points are there */
@@ -289,7 +167,7 @@ voronoj_sorted_right (struct voronoj_aux *voronoj, int *count)
 /* allocating and populating the array */
     array = malloc (sizeof (double) * *count);
     cnt = 0;
-    pt = voronoj->first_right;
+    pt = first;
     while (pt)
       {
 	  *(array + cnt++) = pt->coord;
@@ -297,21 +175,7 @@ voronoj_sorted_right (struct voronoj_aux *voronoj, int *count)
       }
 
 /* sorting the array */
-    while (ok)
-      {
-	  ok = 0;
-	  for (i = 1; i < *count; i++)
-	    {
-		if (*(array + i - 1) > *(array + i))
-		  {
-		      /* swapping two values */
-		      double save = *(array + i - 1);
-		      *(array + i - 1) = *(array + i);
-		      *(array + i) = save;
-		      ok = 1;
-		  }
-	    }
-      }
+    qsort (array, *count, sizeof (double), voronoj_cmp_coords);
     return array;
 }
 
@@ -377,102 +241,173 @@ voronoj_add_frame_point (struct voronoj_aux *voronoj, double x, double y)
       }
 }
 
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+/* strict IEEE-754 double arithmetic: exact expansions can be computed */
+#define VORONOJ_EXACT_ORIENT
+
+static void
+voronoj_two_product (double a, double b, double *hi, double *lo)
+{
+/* exact product (Dekker): a * b == hi + lo */
+    double c;
+    double a_hi;
+    double a_lo;
+    double b_hi;
+    double b_lo;
+    *hi = a * b;
+    c = 134217729.0 * a;
+    a_hi = c - (c - a);
+    a_lo = a - a_hi;
+    c = 134217729.0 * b;
+    b_hi = c - (c - b);
+    b_lo = b - b_hi;
+    *lo = ((a_hi * b_hi - *hi) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+}
+
 static int
-voronoj_same_edge (double ax1, double ay1, double ax2, double ay2, double bx1,
-		   double by1, double bx2, double by2)
+voronoj_grow_expansion (double *e, int n, double b)
 {
-/* testing if two segments are the same */
-    if (ax1 == bx1 && ay1 == by1 && ax2 == bx2 && ay2 == by2)
-	return 1;
-    if (ax1 == bx2 && ay1 == by2 && ax2 == bx1 && ay2 == by1)
-	return 1;
-    return 0;
+/*
+/ exactly adding B to the expansion E (Shewchuk's Grow-Expansion,
+/ zero components being discarded); returns the new expansion length
+*/
+    double q = b;
+    double sum;
+    double bv;
+    double av;
+    double err;
+    int i;
+    int m = 0;
+    for (i = 0; i < n; i++)
+      {
+	  sum = q + e[i];
+	  bv = sum - q;
+	  av = sum - bv;
+	  err = (q - av) + (e[i] - bv);
+	  if (err != 0.0)
+	      e[m++] = err;
+	  q = sum;
+      }
+    if (q != 0.0)
+	e[m++] = q;
+    return m;
+}
+
+static double
+voronoj_orient_exact (double ax, double ay, double bx, double by, double cx,
+		      double cy)
+{
+/*
+/ exact orientation: the determinant is expanded as
+/ ax*(by-cy) + bx*(cy-ay) + cx*(ay-by), and its six products are
+/ summed without any rounding error; the sign of the expansion is
+/ the sign of its largest component
+*/
+    double e[12];
+    double hi;
+    double lo;
+    int n = 0;
+    voronoj_two_product (ax, by, &hi, &lo);
+    n = voronoj_grow_expansion (e, n, lo);
+    n = voronoj_grow_expansion (e, n, hi);
+    voronoj_two_product (-ax, cy, &hi, &lo);
+    n = voronoj_grow_expansion (e, n, lo);
+    n = voronoj_grow_expansion (e, n, hi);
+    voronoj_two_product (bx, cy, &hi, &lo);
+    n = voronoj_grow_expansion (e, n, lo);
+    n = voronoj_grow_expansion (e, n, hi);
+    voronoj_two_product (-bx, ay, &hi, &lo);
+    n = voronoj_grow_expansion (e, n, lo);
+    n = voronoj_grow_expansion (e, n, hi);
+    voronoj_two_product (cx, ay, &hi, &lo);
+    n = voronoj_grow_expansion (e, n, lo);
+    n = voronoj_grow_expansion (e, n, hi);
+    voronoj_two_product (-cx, by, &hi, &lo);
+    n = voronoj_grow_expansion (e, n, lo);
+    n = voronoj_grow_expansion (e, n, hi);
+    if (n == 0)
+	return 0.0;
+    return e[n - 1];
+}
+#endif
+
+static double
+voronoj_orient (double ax, double ay, double bx, double by, double cx,
+		double cy)
+{
+/*
+/ orientation of C in respect to the A-B line: positive if C lays
+/ on the left side, negative if on the right side, zero if collinear
+/
+/ any determinant smaller than the worst possible rounding error
+/ (Shewchuk's static filter) is computed again by exact arithmetic;
+/ on platforms lacking strict IEEE-754 doubles it is simply
+/ considered to be zero
+*/
+    double detleft = (ax - cx) * (by - cy);
+    double detright = (ay - cy) * (bx - cx);
+    double det = detleft - detright;
+    double errbound =
+	(3.0 + 16.0 * DBL_EPSILON) * DBL_EPSILON * (fabs (detleft) +
+						    fabs (detright));
+    if (det > errbound || -det > errbound)
+	return det;
+#ifdef VORONOJ_EXACT_ORIENT
+    return voronoj_orient_exact (ax, ay, bx, by, cx, cy);
+#else
+    return 0.0;
+#endif
 }
 
 static int
-voronoj_internal (const void *p_cache, struct voronoj_triangle *triangle)
+voronoj_internal (struct voronoj_triangle *triangle)
 {
-/* checking if the circumcenter falls inside the triangle */
-    int ret;
-    gaiaGeomCollPtr pt = gaiaAllocGeomColl ();
-    gaiaGeomCollPtr tri = gaiaAllocGeomColl ();
-    gaiaPolygonPtr pg = gaiaAddPolygonToGeomColl (tri, 4, 0);
-    gaiaRingPtr rng = pg->Exterior;
-    gaiaSetPoint (rng->Coords, 0, triangle->x1, triangle->y1);
-    gaiaSetPoint (rng->Coords, 1, triangle->x2, triangle->y2);
-    gaiaSetPoint (rng->Coords, 2, triangle->x3, triangle->y3);
-    gaiaSetPoint (rng->Coords, 3, triangle->x1, triangle->y1);
-    gaiaAddPointToGeomColl (pt, triangle->cx, triangle->cy);
-    gaiaMbrGeometry (pt);
-    gaiaMbrGeometry (tri);
-    if (p_cache != NULL)
-	ret = gaiaGeomCollIntersects_r (p_cache, tri, pt);
-    else
-	ret = gaiaGeomCollIntersects (tri, pt);
-    gaiaFreeGeomColl (pt);
-    gaiaFreeGeomColl (tri);
-    return ret;
+/* checking if the circumcenter falls inside the triangle (or on its boundary) */
+    double o1 = voronoj_orient (triangle->x1, triangle->y1, triangle->x2,
+				triangle->y2, triangle->cx, triangle->cy);
+    double o2 = voronoj_orient (triangle->x2, triangle->y2, triangle->x3,
+				triangle->y3, triangle->cx, triangle->cy);
+    double o3 = voronoj_orient (triangle->x3, triangle->y3, triangle->x1,
+				triangle->y1, triangle->cx, triangle->cy);
+    int neg = (o1 < 0.0 || o2 < 0.0 || o3 < 0.0);
+    int pos = (o1 > 0.0 || o2 > 0.0 || o3 > 0.0);
+    if (neg && pos)
+	return 0;
+    return 1;
 }
 
 static double
-voronoj_test_point (const void *p_cache, double x1, double y1, double x2,
-		    double y2, double x, double y)
+voronoj_test_point (double x1, double y1, double x2, double y2, double x,
+		    double y)
 {
 /* point-segment distance */
-    double dist;
-    gaiaGeomCollPtr pt = gaiaAllocGeomColl ();
-    gaiaGeomCollPtr segm = gaiaAllocGeomColl ();
-    gaiaLinestringPtr ln = gaiaAddLinestringToGeomColl (segm, 2);
-    gaiaSetPoint (ln->Coords, 0, x1, y1);
-    gaiaSetPoint (ln->Coords, 1, x2, y2);
-    gaiaAddPointToGeomColl (pt, x, y);
-    if (p_cache != NULL)
-	gaiaGeomCollDistance_r (p_cache, segm, pt, &dist);
-    else
-	gaiaGeomCollDistance (segm, pt, &dist);
-    gaiaFreeGeomColl (pt);
-    gaiaFreeGeomColl (segm);
-    return dist;
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    double len2;
+    double r;
+    double s;
+    if (x1 == x2 && y1 == y2)
+	return sqrt (((x - x1) * (x - x1)) + ((y - y1) * (y - y1)));
+    len2 = (dx * dx) + (dy * dy);
+    r = (((x - x1) * dx) + ((y - y1) * dy)) / len2;
+    if (r <= 0.0)
+	return sqrt (((x - x1) * (x - x1)) + ((y - y1) * (y - y1)));
+    if (r >= 1.0)
+	return sqrt (((x - x2) * (x - x2)) + ((y - y2) * (y - y2)));
+    s = (((y1 - y) * dx) - ((x1 - x) * dy)) / len2;
+    return fabs (s) * sqrt (len2);
 }
 
 static int
-voronoj_check_nearest_edge (const void *p_cache, struct voronoj_triangle *tri,
-			    int which)
+voronoj_check_nearest_edge (struct voronoj_triangle *tri, int which)
 {
 /* testing if direction outside */
-    double d_1_2;
-    double d_2_3;
-    double d_3_1;
-    gaiaGeomCollPtr pt = gaiaAllocGeomColl ();
-    gaiaGeomCollPtr segm = gaiaAllocGeomColl ();
-    gaiaLinestringPtr ln = gaiaAddLinestringToGeomColl (segm, 2);
-    gaiaSetPoint (ln->Coords, 0, tri->x1, tri->y1);
-    gaiaSetPoint (ln->Coords, 1, tri->x2, tri->y2);
-    gaiaAddPointToGeomColl (pt, tri->cx, tri->cy);
-    if (p_cache != NULL)
-	gaiaGeomCollDistance_r (p_cache, segm, pt, &d_1_2);
-    else
-	gaiaGeomCollDistance (segm, pt, &d_1_2);
-    gaiaFreeGeomColl (segm);
-    segm = gaiaAllocGeomColl ();
-    ln = gaiaAddLinestringToGeomColl (segm, 2);
-    gaiaSetPoint (ln->Coords, 0, tri->x2, tri->y2);
-    gaiaSetPoint (ln->Coords, 1, tri->x3, tri->y3);
-    if (p_cache != NULL)
-	gaiaGeomCollDistance_r (p_cache, segm, pt, &d_2_3);
-    else
-	gaiaGeomCollDistance (segm, pt, &d_2_3);
-    gaiaFreeGeomColl (segm);
-    segm = gaiaAllocGeomColl ();
-    ln = gaiaAddLinestringToGeomColl (segm, 2);
-    gaiaSetPoint (ln->Coords, 0, tri->x3, tri->y3);
-    gaiaSetPoint (ln->Coords, 1, tri->x1, tri->y1);
-    if (p_cache != NULL)
-	gaiaGeomCollDistance_r (p_cache, segm, pt, &d_3_1);
-    else
-	gaiaGeomCollDistance (segm, pt, &d_3_1);
-    gaiaFreeGeomColl (segm);
-    gaiaFreeGeomColl (pt);
+    double d_1_2 = voronoj_test_point (tri->x1, tri->y1, tri->x2, tri->y2,
+				       tri->cx, tri->cy);
+    double d_2_3 = voronoj_test_point (tri->x2, tri->y2, tri->x3, tri->y3,
+				       tri->cx, tri->cy);
+    double d_3_1 = voronoj_test_point (tri->x3, tri->y3, tri->x1, tri->y1,
+				       tri->cx, tri->cy);
 
     if (which == 12 && d_1_2 < d_2_3 && d_1_2 < d_3_1)
 	return 0;
@@ -483,6 +418,130 @@ voronoj_check_nearest_edge (const void *p_cache, struct voronoj_triangle *tri,
     return 1;
 }
 
+static void
+voronoj_set_edge (struct voronoj_edge *edge, struct voronoj_triangle *tri,
+		  int which, double x1, double y1, double x2, double y2)
+{
+/* initializing an edge - always storing the lesser end-point first */
+    if (x1 < x2 || (x1 == x2 && y1 <= y2))
+      {
+	  edge->x1 = x1;
+	  edge->y1 = y1;
+	  edge->x2 = x2;
+	  edge->y2 = y2;
+      }
+    else
+      {
+	  edge->x1 = x2;
+	  edge->y1 = y2;
+	  edge->x2 = x1;
+	  edge->y2 = y1;
+      }
+    edge->triangle = tri;
+    edge->which = which;
+}
+
+static int
+voronoj_cmp_edges (const void *p1, const void *p2)
+{
+/* comparison function for QSORT - triangle edges */
+    const struct voronoj_edge *e1 = (const struct voronoj_edge *) p1;
+    const struct voronoj_edge *e2 = (const struct voronoj_edge *) p2;
+    if (e1->x1 != e2->x1)
+	return (e1->x1 < e2->x1) ? -1 : 1;
+    if (e1->y1 != e2->y1)
+	return (e1->y1 < e2->y1) ? -1 : 1;
+    if (e1->x2 != e2->x2)
+	return (e1->x2 < e2->x2) ? -1 : 1;
+    if (e1->y2 != e2->y2)
+	return (e1->y2 < e2->y2) ? -1 : 1;
+/* same edge: preserving the triangles' order */
+    if (e1->triangle != e2->triangle)
+	return (e1->triangle < e2->triangle) ? -1 : 1;
+    if (e1->which != e2->which)
+	return (e1->which < e2->which) ? -1 : 1;
+    return 0;
+}
+
+static int
+voronoj_same_edge (struct voronoj_edge *e1, struct voronoj_edge *e2)
+{
+/* testing if two segments are the same */
+    if (e1->x1 == e2->x1 && e1->y1 == e2->y1 && e1->x2 == e2->x2
+	&& e1->y2 == e2->y2)
+	return 1;
+    return 0;
+}
+
+static void
+voronoj_link (struct voronoj_triangle *tri, int which,
+	      struct voronoj_triangle *tri2, int trace)
+{
+/* registering an adjacent triangle */
+    if (which == 12)
+      {
+	  tri->tri_1_2 = tri2;
+	  tri->trace_1_2 = trace;
+      }
+    else if (which == 23)
+      {
+	  tri->tri_2_3 = tri2;
+	  tri->trace_2_3 = trace;
+      }
+    else
+      {
+	  tri->tri_3_1 = tri2;
+	  tri->trace_3_1 = trace;
+      }
+}
+
+static void
+voronoj_adjacent_triangles (struct voronoj_aux *voronoj)
+{
+/*
+/ identifying triangles sharing the same edge
+/
+/ all edges are sorted, so that shared edges become consecutive items
+/ (any edge is shared by two triangles at most)
+*/
+    struct voronoj_edge *edges;
+    struct voronoj_edge *e1;
+    struct voronoj_edge *e2;
+    struct voronoj_triangle *triangle;
+    int count = voronoj->count * 3;
+    int ind;
+    if (count == 0)
+	return;
+    edges = malloc (sizeof (struct voronoj_edge) * count);
+    for (ind = 0; ind < voronoj->count; ind++)
+      {
+	  triangle = voronoj->array + ind;
+	  voronoj_set_edge (edges + (ind * 3), triangle, 12, triangle->x1,
+			    triangle->y1, triangle->x2, triangle->y2);
+	  voronoj_set_edge (edges + (ind * 3) + 1, triangle, 23, triangle->x2,
+			    triangle->y2, triangle->x3, triangle->y3);
+	  voronoj_set_edge (edges + (ind * 3) + 2, triangle, 31, triangle->x3,
+			    triangle->y3, triangle->x1, triangle->y1);
+      }
+    qsort (edges, count, sizeof (struct voronoj_edge), voronoj_cmp_edges);
+    ind = 0;
+    while (ind < count - 1)
+      {
+	  e1 = edges + ind;
+	  e2 = edges + ind + 1;
+	  if (e1->triangle != e2->triangle && voronoj_same_edge (e1, e2))
+	    {
+		/* the lesser triangle will trace the shared edge */
+		voronoj_link (e1->triangle, e1->which, e2->triangle, 1);
+		voronoj_link (e2->triangle, e2->which, e1->triangle, 0);
+		ind += 2;
+	    }
+	  else
+	      ind++;
+      }
+    free (edges);
+}
+
 static void
 voronoj_minmax (double x, double y, double *minx, double *miny, double *maxx,
 		double *maxy)
@@ -499,7 +558,7 @@ voronoj_minmax (double x, double y, double *minx, double *miny, double *maxx,
 }
 
 static void
-voronoj_frame_point (const void *p_cache, double intercept, double slope,
+voronoj_frame_point (double intercept, double slope,
 		     struct voronoj_aux *voronoj, double cx, double cy,
 		     double mx, double my, int direct, double *x, double *y)
 {
@@ -587,8 +646,8 @@ voronoj_frame_point (const void *p_cache, double intercept, double slope,
     if (direct)
       {
 	  /* cutting the edge in two */
-	  d1 = voronoj_test_point (p_cache, cx, cy, pre_x1, pre_y1, mx, my);
-	  d2 = voronoj_test_point (p_cache, cx, cy, pre_x2, pre_y2, mx, my);
+	  d1 = voronoj_test_point (cx, cy, pre_x1, pre_y1, mx, my);
+	  d2 = voronoj_test_point (cx, cy, pre_x2, pre_y2, mx, my);
 	  if (d1 < d2)
 	    {
 		*x = pre_x1;
@@ -603,8 +662,8 @@ voronoj_frame_point (const void *p_cache, double intercept, double slope,
     else
       {
 	  /* going outside */
-	  d1 = voronoj_test_point (p_cache, cx, cy, pre_x1, pre_y1, mx, my);
-	  d2 = voronoj_test_point (p_cache, cx, cy, pre_x2, pre_y2, mx, my);
+	  d1 = voronoj_test_point (cx, cy, pre_x1, pre_y1, mx, my);
+	  d2 = voronoj_test_point (cx, cy, pre_x2, pre_y2, mx, my);
 	  if (d1 > d2)
 	    {
 		*x = pre_x1;
@@ -632,11 +691,9 @@ voronoj_build_r (const void *p_cache, int count, void *p_first,
     gaiaPolygonPtr first = (gaiaPolygonPtr) p_first;
     struct voronoj_aux *voronoj = NULL;
     struct voronoj_triangle *triangle;
-    struct voronoj_triangle *tri2;
     gaiaPolygonPtr pg;
     gaiaRingPtr rng;
     int ind = 0;
-    int i2;
     int direct;
     double x;
     double y;
@@ -775,121 +832,11 @@ voronoj_build_r (const void *p_cache, int count, void *p_first,
     voronoj->maxy = maxy + delta;
 
 /* identifying triangles sharing the same edge */
+    voronoj_adjacent_triangles (voronoj);
+
     for (ind = 0; ind < voronoj->count; ind++)
       {
 	  triangle = voronoj->array + ind;
-	  for (i2 = ind + 1; i2 < voronoj->count; i2++)
-	    {
-		tri2 = voronoj->array + i2;
-		if (triangle->tri_1_2 == NULL && tri2->tri_1_2 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x1, triangle->y1, triangle->x2,
-			   triangle->y2, tri2->x1, tri2->y1, tri2->x2,
-			   tri2->y2))
-			{
-			    triangle->tri_1_2 = tri2;
-			    triangle->trace_1_2 = 1;
-			    tri2->tri_1_2 = triangle;
-			}
-		  }
-		if (triangle->tri_1_2 == NULL && tri2->tri_2_3 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x1, triangle->y1, triangle->x2,
-			   triangle->y2, tri2->x2, tri2->y2, tri2->x3,
-			   tri2->y3))
-			{
-			    triangle->tri_1_2 = tri2;
-			    triangle->trace_1_2 = 1;
-			    tri2->tri_2_3 = triangle;
-			}
-		  }
-		if (triangle->tri_1_2 == NULL && tri2->tri_3_1 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x1, triangle->y1, triangle->x2,
-			   triangle->y2, tri2->x3, tri2->y3, tri2->x1,
-			   tri2->y1))
-			{
-			    triangle->tri_1_2 = tri2;
-			    triangle->trace_1_2 = 1;
-			    tri2->tri_3_1 = triangle;
-			}
-		  }
-		if (triangle->tri_2_3 == NULL && tri2->tri_1_2 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x2, triangle->y2, triangle->x3,
-			   triangle->y3, tri2->x1, tri2->y1, tri2->x2,
-			   tri2->y2))
-			{
-			    triangle->tri_2_3 = tri2;
-			    triangle->trace_2_3 = 1;
-			    tri2->tri_1_2 = triangle;
-			}
-		  }
-		if (triangle->tri_2_3 == NULL && tri2->tri_2_3 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x2, triangle->y2, triangle->x3,
-			   triangle->y3, tri2->x2, tri2->y2, tri2->x3,
-			   tri2->y3))
-			{
-			    triangle->tri_2_3 = tri2;
-			    triangle->trace_2_3 = 1;
-			    tri2->tri_2_3 = triangle;
-			}
-		  }
-		if (triangle->tri_2_3 == NULL && tri2->tri_3_1 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x2, triangle->y2, triangle->x3,
-			   triangle->y3, tri2->x3, tri2->y3, tri2->x1,
-			   tri2->y1))
-			{
-			    triangle->tri_2_3 = tri2;
-			    triangle->trace_2_3 = 1;
-			    tri2->tri_3_1 = triangle;
-			}
-		  }
-		if (triangle->tri_3_1 == NULL && tri2->tri_1_2 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x3, triangle->y3, triangle->x1,
-			   triangle->y1, tri2->x1, tri2->y1, tri2->x2,
-			   tri2->y2))
-			{
-			    triangle->tri_3_1 = tri2;
-			    triangle->trace_3_1 = 1;
-			    tri2->tri_1_2 = triangle;
-			}
-		  }
-		if (triangle->tri_3_1 == NULL && tri2->tri_2_3 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x3, triangle->y3, triangle->x1,
-			   triangle->y1, tri2->x2, tri2->y2, tri2->x3,
-			   tri2->y3))
-			{
-			    triangle->tri_3_1 = tri2;
-			    triangle->trace_3_1 = 1;
-			    tri2->tri_2_3 = triangle;
-			}
-		  }
-		if (triangle->tri_3_1 == NULL && tri2->tri_3_1 == NULL)
-		  {
-		      if (voronoj_same_edge
-			  (triangle->x3, triangle->y3, triangle->x1,
-			   triangle->y1, tri2->x3, tri2->y3, tri2->x1,
-			   tri2->y1))
-			{
-			    triangle->tri_3_1 = tri2;
-			    triangle->trace_3_1 = 1;
-			    tri2->tri_3_1 = triangle;
-			}
-		  }
-	    }
 
 	  /* identifying vertices on the frame */
 	  if (triangle->tri_1_2 == NULL)
@@ -904,9 +851,9 @@ voronoj_build_r (const void *p_cache, int count, void *p_first,
 		      intercept = my - (slope * mx);
 		  }
 		direct = 1;
-		if (!voronoj_internal (p_cache, triangle))
-		    direct = voronoj_check_nearest_edge (p_cache, triangle, 12);
-		voronoj_frame_point (p_cache, intercept, slope, voronoj,
+		if (!voronoj_internal (triangle))
+		    direct = voronoj_check_nearest_edge (triangle, 12);
+		voronoj_frame_point (intercept, slope, voronoj,
 				     triangle->cx, triangle->cy, mx, my, direct,
 				     &x, &y);
 		triangle->x_1_2 = x;
@@ -924,9 +871,9 @@ voronoj_build_r (const void *p_cache, int count, void *p_first,
 		      intercept = my - (slope * mx);
 		  }
 		direct = 1;
-		if (!voronoj_internal (p_cache, triangle))
-		    direct = voronoj_check_nearest_edge (p_cache, triangle, 23);
-		voronoj_frame_point (p_cache, intercept, slope, voronoj,
+		if (!voronoj_internal (triangle))
+		    direct = voronoj_check_nearest_edge (triangle, 23);
+		voronoj_frame_point (intercept, slope, voronoj,
 				     triangle->cx, triangle->cy, mx, my, direct,
 				     &x, &y);
 		triangle->x_2_3 = x;
@@ -944,9 +891,9 @@ voronoj_build_r (const void *p_cache, int count, void *p_first,
 		      intercept = my - (slope * mx);
 		  }
 		direct = 1;
-		if (!voronoj_internal (p_cache, triangle))
-		    direct = voronoj_check_nearest_edge (p_cache, triangle, 31);
-		voronoj_frame_point (p_cache, intercept, slope, voronoj,
+		if (!voronoj_internal (triangle))
+		    direct = voronoj_check_nearest_edge (triangle, 31);
+		voronoj_frame_point (intercept, slope, voronoj,
 				     triangle->cx, triangle->cy, mx, my, direct,
 				     &x, &y);
 		triangle->x_3_1 = x;
@@ -1176,7 +1123,7 @@ voronoj_export_common (const void *p_cache, void *p_voronoj, void *p_result,
 
 /* setting up the frame's upper edge */
     last = voronoj->minx;
-    array = voronoj_sorted_up (voronoj, &count);
+    array = voronoj_sorted (voronoj->first_up, &count);
     if (array)
       {
 	  for (i = 0; i < count; i++)
@@ -1237,7 +1184,7 @@ voronoj_export_common (const void *p_cache, void *p_voronoj, void *p_result,
 
 /* setting up the frame's lower edge */
     last = voronoj->minx;
-    array = voronoj_sorted_low (voronoj, &count);
+    array = voronoj_sorted (voronoj->first_low, &count);
     if (array)
       {
 	  for (i = 0; i < count; i++)
@@ -1298,7 +1245,7 @@ voronoj_export_common (const void *p_cache, void *p_voronoj, void *p_result,
 
 /* setting up the frame's left edge */
     last = voronoj->miny;
-    array = voronoj_sorted_left (voronoj, &count);
+    array = voronoj_sorted (voronoj->first_left, &count);
     if (array)
       {
 	  for (i = 0; i < count; i++)
@@ -1359,7 +1306,7 @@ voronoj_export_common (const void *p_cache, void *p_voronoj, void *p_result,
 
     /* setting up the frame's right edge */
     last = voronoj->miny;
-    array = voronoj_sorted_right (voronoj, &count);
+    array = voronoj_sorted (voronoj->first_right, &count);
     if (array)
       {
 	  for (i = 0; i < count; i++)
@@ -1510,51 +1457,24 @@ concave_hull_stats (struct concave_hull_str *concave, double length)
     concave->mean = concave->mean + ((length - concave->mean) / concave->count);
 }
 
+static double
+concave_hull_segment_length (double x1, double y1, double x2, double y2)
+{
+/* segment length */
+    return sqrt (((x2 - x1) * (x2 - x1)) + ((y2 - y1) * (y2 - y1)));
+}
+
 static int
-concave_hull_filter (const void *p_cache, double x1, double y1,
-		     double x2, double y2, double x3, double y3, double limit)
+concave_hull_filter (double x1, double y1, double x2, double y2, double x3,
+		     double y3, double limit)
 {
 /* filtering triangles to be inserted into the Concave Hull */
-    gaiaGeomCollPtr segm;
-    gaiaLinestringPtr ln;
-    double length;
-
-    segm = gaiaAllocGeomColl ();
-    ln = gaiaAddLinestringToGeomColl (segm, 2);
-    gaiaSetPoint (ln->Coords, 0, x1, y1);
-    gaiaSetPoint (ln->Coords, 1, x2, y2);
-    if (p_cache != NULL)
-	gaiaGeomCollLength_r (p_cache, segm, &length);
-    else
-	gaiaGeomCollLength (segm, &length);
-    gaiaFreeGeomColl (segm);
-    if (length >= limit)
+    if (concave_hull_segment_length (x1, y1, x2, y2) >= limit)
 	return 0;
-
-    segm = gaiaAllocGeomColl ();
-    ln = gaiaAddLinestringToGeomColl (segm, 2);
-    gaiaSetPoint (ln->Coords, 0, x2, y2);
-    gaiaSetPoint (ln->Coords, 1, x3, y3);
-    if (p_cache != NULL)
-	gaiaGeomCollLength_r (p_cache, segm, &length);
-    else
-	gaiaGeomCollLength (segm, &length);
-    gaiaFreeGeomColl (segm);
-    if (length >= limit)
+    if (concave_hull_segment_length (x2, y2, x3, y3) >= limit)
 	return 0;
-
-    segm = gaiaAllocGeomColl ();
-    ln = gaiaAddLinestringToGeomColl (segm, 2);
-    gaiaSetPoint (ln->Coords, 0, x3, y3);
-    gaiaSetPoint (ln->Coords, 1, x1, y1);
-    if (p_cache != NULL)
-	gaiaGeomCollLength_r (p_cache, segm, &length);
-    else
-	gaiaGeomCollLength (segm, &length);
-    gaiaFreeGeomColl (segm);
-    if (length >= limit)
+    if (concave_hull_segment_length (x3, y3, x1, y1) >= limit)
 	return 0;
-
     return 1;
 }
 
@@ -1631,7 +1551,6 @@ concave_hull_build_common (const void *p_cache, void *p_first,
     gaiaRingPtr rng_out;
     gaiaGeomCollPtr segm;
     gaiaGeomCollPtr result;
-    gaiaLinestringPtr ln;
     double x;
     double y;
     double z;
@@ -1642,7 +1561,6 @@ concave_hull_build_common (const void *p_cache, void *p_first,
     double y2;
     double x3;
     double y3;
-    double length;
     double std_dev;
     int count;
 
@@ -1705,38 +1623,13 @@ concave_hull_build_common (const void *p_cache, void *p_first,
 		y3 = y;
 	    }
 
-	  segm = gaiaAllocGeomColl ();
-	  ln = gaiaAddLinestringToGeomColl (segm, 2);
-	  gaiaSetPoint (ln->Coords, 0, x1, y1);
-	  gaiaSetPoint (ln->Coords, 1, x2, y2);
-	  if (p_cache != NULL)
-	      gaiaGeomCollLength_r (p_cache, segm, &length);
-	  else
-	      gaiaGeomCollLength (segm, &length);
-	  gaiaFreeGeomColl (segm);
-	  concave_hull_stats (&concave, length);
-
-	  segm = gaiaAllocGeomColl ();
-	  ln = gaiaAddLinestringToGeomColl (segm, 2);
-	  gaiaSetPoint (ln->Coords, 0, x2, y2);
-	  gaiaSetPoint (ln->Coords, 1, x3, y3);
-	  if (p_cache != NULL)
-	      gaiaGeomCollLength_r (p_cache, segm, &length);
-	  else
-	      gaiaGeomCollLength (segm, &length);
-	  gaiaFreeGeomColl (segm);
-	  concave_hull_stats (&concave, length);
-
-	  segm = gaiaAllocGeomColl ();
-	  ln = gaiaAddLinestringToGeomColl (segm, 2);
-	  gaiaSetPoint (ln->Coords, 0, x3, y3);
-	  gaiaSetPoint (ln->Coords, 1, x1, y1);
-	  if (p_cache != NULL)
-	      gaiaGeomCollLength_r (p_cache, segm, &length);
-	  else
-	      gaiaGeomCollLength (segm, &length);
-	  gaiaFreeGeomColl (segm);
-	  concave_hull_stats (&concave, length);
+	  concave_hull_stats (&concave,
+			      concave_hull_segment_length (x1, y1, x2, y2));
+	  concave_hull_stats (&concave,
+			      concave_hull_segment_length (x2, y2, x3, y3));
+
+	  concave_hull_stats (&concave,
+			      concave_hull_segment_length (x3, y3, x1, y1));
 
 	  pg = pg->Next;
       }
@@ -1808,8 +1701,7 @@ concave_hull_build_common (const void *p_cache, void *p_first,
 		y3 = y;
 	    }
 
-	  if (concave_hull_filter
-	      (p_cache, x1, y1, x2, y2, x3, y3, std_dev * factor))
+	  if (concave_hull_filter (x1, y1, x2, y2, x3, y3, std_dev * factor))
 	    {
 		/* inserting this triangle into the Concave Hull */
 		pg_out = gaiaAddPolygonToGeomColl (result, 4, 0);
@@ -6416,3 +6416,755 @@ gaiaToFgf (gaiaGeomCollPtr geom, unsigned char **result, int *size,
 	  polyg = polyg->Next;
       }
 }
+
+/*
+/ direct Text -> BLOB encoding for simple Geometries
+/
+/ the common cases (POINT, LINESTRING, POLYGON and their MULTI forms,
+/ either XY or XYZ) are recognized by a hand-written single pass scanner
+/ directly writing the SpatiaLite BLOB, so to avoid going through the
+/ flex/lemon parsers and a gaiaGeomColl object.
+/ these scanners only accept a strict subset of the syntax accepted by
+/ the flex lexers (same number format, same blanks, same keywords) and
+/ always produce exactly the same BLOB; anything else simply returns 0,
+/ and the caller is expected to fall back to the full parser.
+*/
+
+struct text_blob
+{
+/* a BLOB directly encoded from some text Geometry */
+    const char *p;		/* current text position */
+    char close;			/* closing bracket of coordinate lists */
+    int has_z;			/* XYZ dimensions */
+    unsigned char *blob;
+    int size;
+    int alloc;
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+    int endian_arch;
+};
+
+static int
+text_blob_room (struct text_blob *tb, int bytes)
+{
+/* ensuring that the BLOB still has enough free room */
+    unsigned char *p;
+    int alloc = tb->alloc;
+    if (tb->size + bytes <= alloc)
+	return 1;
+    while (tb->size + bytes > alloc)
+      {
+	  if (alloc > 0x3fffffff)
+	      return 0;
+	  alloc *= 2;
+      }
+    p = realloc (tb->blob, alloc);
+    if (p == NULL)
+	return 0;
+    tb->blob = p;
+    tb->alloc = alloc;
+    return 1;
+}
+
+static int
+text_blob_int32 (struct text_blob *tb, int value)
+{
+/* appending a 32 bit integer to the BLOB */
+    if (!text_blob_room (tb, 4))
+	return 0;
+    gaiaExport32 (tb->blob + tb->size, value, 1, tb->endian_arch);
+    tb->size += 4;
+    return 1;
+}
+
+static int
+text_blob_entity (struct text_blob *tb, int type)
+{
+/* appending the ENTITY header of some MULTIxxxx item */
+    if (!text_blob_room (tb, 5))
+	return 0;
+    *(tb->blob + tb->size) = GAIA_MARK_ENTITY;
+    gaiaExport32 (tb->blob + tb->size + 1, type, 1, tb->endian_arch);
+    tb->size += 5;
+    return 1;
+}
+
+static int
+text_blob_vertex (struct text_blob *tb, double x, double y, double z,
+		  int mbr)
+{
+/* appending a vertex to the BLOB */
+    int bytes = tb->has_z ? 24 : 16;
+    if (!text_blob_room (tb, bytes))
+	return 0;
+    gaiaExport64 (tb->blob + tb->size, x, 1, tb->endian_arch);
+    gaiaExport64 (tb->blob + tb->size + 8, y, 1, tb->endian_arch);
+    if (tb->has_z)
+	gaiaExport64 (tb->blob + tb->size + 16, z, 1, tb->endian_arch);
+    tb->size += bytes;
+    if (mbr)
+      {
+	  /* interior rings never contribute to the MBR */
+	  if (x < tb->minx)
+	      tb->minx = x;
+	  if (y < tb->miny)
+	      tb->miny = y;
+	  if (x > tb->maxx)
+	      tb->maxx = x;
+	  if (y > tb->maxy)
+	      tb->maxy = y;
+      }
+    return 1;
+}
+
+static int
+text_blob_start (struct text_blob *tb, const unsigned char *text,
+		 char close, int type, int srid)
+{
+/* initializing the BLOB and its main header */
+    int len = strlen ((const char *) text);
+    tb->close = close;
+    tb->alloc = 64 + len;
+    tb->blob = malloc (tb->alloc);
+    if (tb->blob == NULL)
+	return 0;
+    tb->minx = DBL_MAX;
+    tb->miny = DBL_MAX;
+    tb->maxx = -DBL_MAX;
+    tb->maxy = -DBL_MAX;
+    tb->endian_arch = gaiaEndianArch ();
+    *(tb->blob) = GAIA_MARK_START;	/* START signature */
+    *(tb->blob + 1) = GAIA_LITTLE_ENDIAN;	/* byte ordering */
+    gaiaExport32 (tb->blob + 2, srid, 1, tb->endian_arch);	/* the SRID */
+    *(tb->blob + 38) = GAIA_MARK_MBR;	/* MBR signature */
+    gaiaExport32 (tb->blob + 39, type, 1, tb->endian_arch);	/* geometric class */
+    tb->size = 43;
+    return 1;
+}
+
+static int
+text_blob_finish (struct text_blob *tb)
+{
+/* completing the BLOB: MBR and END signature */
+    if (!text_blob_room (tb, 1))
+	return 0;
+    gaiaExport64 (tb->blob + 6, tb->minx, 1, tb->endian_arch);	/* MBR - minimum X */
+    gaiaExport64 (tb->blob + 14, tb->miny, 1, tb->endian_arch);	/* MBR - minimum Y */
+    gaiaExport64 (tb->blob + 22, tb->maxx, 1, tb->endian_arch);	/* MBR - maximum X */
+    gaiaExport64 (tb->blob + 30, tb->maxy, 1, tb->endian_arch);	/* MBR - maximum Y */
+    *(tb->blob + tb->size) = GAIA_MARK_END;	/* END signature */
+    tb->size += 1;
+    return 1;
+}
+
+static int
+text_blob_class (int type, int has_z)
+{
+/* the BLOB geometric class for an XY or XYZ type */
+    if (!has_z)
+	return type;
+    switch (type)
+      {
+      case GAIA_POINT:
+	  return GAIA_POINTZ;
+      case GAIA_LINESTRING:
+	  return GAIA_LINESTRINGZ;
+      case GAIA_POLYGON:
+	  return GAIA_POLYGONZ;
+      case GAIA_MULTIPOINT:
+	  return GAIA_MULTIPOINTZ;
+      case GAIA_MULTILINESTRING:
+	  return GAIA_MULTILINESTRINGZ;
+      case GAIA_MULTIPOLYGON:
+	  return GAIA_MULTIPOLYGONZ;
+      };
+    return type;
+}
+
+static void
+text_blob_blanks (struct text_blob *tb)
+{
+/* skipping blanks (the same ones ignored by the flex lexers) */
+    while (*(tb->p) == ' ' || *(tb->p) == '\t' || *(tb->p) == '\n')
+	tb->p++;
+}
+
+static int
+text_blob_expect (struct text_blob *tb, char c)
+{
+/* skipping blanks and then expecting a given punctuation mark */
+    text_blob_blanks (tb);
+    if (*(tb->p) != c)
+	return 0;
+    tb->p++;
+    return 1;
+}
+
+static int
+text_blob_number (struct text_blob *tb, double *value)
+{
+/*
+/ scanning a number exactly as the flex lexers do: an optional sign,
+/ some digits and then an optional decimal part (no exponent).
+/ the number must be followed by a blank, a comma or a closing bracket,
+/ so that tokens such as "1-2" are left to the full parser
+*/
+    const char *p;
+    text_blob_blanks (tb);
+    p = tb->p;
+    if (*p == '-' || *p == '+')
+	p++;
+    if (*p < '0' || *p > '9')
+	return 0;
+    while (*p >= '0' && *p <= '9')
+	p++;
+    if (*p == '.')
+      {
+	  p++;
+	  while (*p >= '0' && *p <= '9')
+	      p++;
+      }
+    if (*p != ' ' && *p != '\t' && *p != '\n' && *p != ',' && *p != tb->close)
+	return 0;
+    *value = atof (tb->p);
+    tb->p = p;
+    return 1;
+}
+
+static int
+wkt_blob_vertex (struct text_blob *tb, int mbr)
+{
+/* encoding a WKT "x y [z]" vertex */
+    double x;
+    double y;
+    double z = 0.0;
+    if (!text_blob_number (tb, &x))
+	return 0;
+    if (!text_blob_number (tb, &y))
+	return 0;
+    if (tb->has_z)
+      {
+	  if (!text_blob_number (tb, &z))
+	      return 0;
+      }
+    return text_blob_vertex (tb, x, y, z, mbr);
+}
+
+static int
+wkt_blob_vertices (struct text_blob *tb, int min_points, int mbr)
+{
+/* encoding a WKT "(x y, x y, ...)" list: # points + coords */
+    int offset;
+    int count = 0;
+    if (!text_blob_expect (tb, '('))
+	return 0;
+    offset = tb->size;
+    if (!text_blob_int32 (tb, 0))
+	return 0;
+    while (1)
+      {
+	  if (!wkt_blob_vertex (tb, mbr))
+	      return 0;
+	  count++;
+	  text_blob_blanks (tb);
+	  if (*(tb->p) == ',')
+	    {
+		tb->p++;
+		continue;
+	    }
+	  if (*(tb->p) != ')')
+	      return 0;
+	  tb->p++;
+	  break;
+      }
+    if (count < min_points)
+	return 0;
+    gaiaExport32 (tb->blob + offset, count, 1, tb->endian_arch);
+    return 1;
+}
+
+static int
+wkt_blob_rings (struct text_blob *tb)
+{
+/* encoding a WKT "((ring), (ring), ...)" Polygon: # rings + rings */
+    int offset;
+    int count = 0;
+    if (!text_blob_expect (tb, '('))
+	return 0;
+    offset = tb->size;
+    if (!text_blob_int32 (tb, 0))
+	return 0;
+    while (1)
+      {
+	  if (!wkt_blob_vertices (tb, 4, count == 0))
+	      return 0;
+	  count++;
+	  text_blob_blanks (tb);
+	  if (*(tb->p) == ',')
+	    {
+		tb->p++;
+		continue;
+	    }
+	  if (*(tb->p) != ')')
+	      return 0;
+	  tb->p++;
+	  break;
+      }
+    gaiaExport32 (tb->blob + offset, count, 1, tb->endian_arch);
+    return 1;
+}
+
+static int
+wkt_blob_collection (struct text_blob *tb, int type)
+{
+/* encoding the items of a WKT MULTIxxxx: # entities + entities */
+    int offset;
+    int count = 0;
+    int bracketed = 0;
+    int item = text_blob_class (type, tb->has_z);
+    if (!text_blob_expect (tb, '('))
+	return 0;
+    offset = tb->size;
+    if (!text_blob_int32 (tb, 0))
+	return 0;
+    if (type == GAIA_POINT)
+      {
+	  /* both MULTIPOINT(x y, ...) and MULTIPOINT((x y), ...) are valid */
+	  text_blob_blanks (tb);
+	  if (*(tb->p) == '(')
+	      bracketed = 1;
+      }
+    while (1)
+      {
+	  if (!text_blob_entity (tb, item))
+	      return 0;
+	  switch (type)
+	    {
+	    case GAIA_POINT:
+		if (bracketed && !text_blob_expect (tb, '('))
+		    return 0;
+		if (!wkt_blob_vertex (tb, 1))
+		    return 0;
+		if (bracketed && !text_blob_expect (tb, ')'))
+		    return 0;
+		break;
+	    case GAIA_LINESTRING:
+		if (!wkt_blob_vertices (tb, 2, 1))
+		    return 0;
+		break;
+	    case GAIA_POLYGON:
+		if (!wkt_blob_rings (tb))
+		    return 0;
+		break;
+	    };
+	  count++;
+	  text_blob_blanks (tb);
+	  if (*(tb->p) == ',')
+	    {
+		tb->p++;
+		continue;
+	    }
+	  if (*(tb->p) != ')')
+	      return 0;
+	  tb->p++;
+	  break;
+      }
+    gaiaExport32 (tb->blob + offset, count, 1, tb->endian_arch);
+    return 1;
+}
+
+static int
+wkt_blob_keyword (const char *p, const char *keyword)
+{
+/* case-insensitive WKT keyword: returns its length, 0 if not matching */
+    int i;
+    for (i = 0; *(keyword + i) != '\0'; i++)
+      {
+	  char c = *(p + i);
+	  if (c >= 'a' && c <= 'z')
+	      c -= 'a' - 'A';
+	  if (c != *(keyword + i))
+	      return 0;
+      }
+    return i;
+}
+
+GAIAGEO_DECLARE int
+gaiaSimpleWktToBlob (const unsigned char *wkt, short type, int srid,
+		     unsigned char **blob, int *blob_size)
+{
+/* directly encoding a simple WKT Geometry as a SpatiaLite BLOB */
+    struct text_blob tb;
+    const char *p;
+    const char *q;
+    int len;
+    int cls;
+    int declared;
+    int ok = 0;
+    *blob = NULL;
+    *blob_size = 0;
+    if (wkt == NULL)
+	return 0;
+
+/* identifying the Geometry class */
+    p = (const char *) wkt;
+    while (*p == ' ' || *p == '\t' || *p == '\n')
+	p++;
+    if ((len = wkt_blob_keyword (p, "MULTIPOINT")) > 0)
+	cls = GAIA_MULTIPOINT;
+    else if ((len = wkt_blob_keyword (p, "MULTILINESTRING")) > 0)
+	cls = GAIA_MULTILINESTRING;
+    else if ((len = wkt_blob_keyword (p, "MULTIPOLYGON")) > 0)
+	cls = GAIA_MULTIPOLYGON;
+    else if ((len = wkt_blob_keyword (p, "POINT")) > 0)
+	cls = GAIA_POINT;
+    else if ((len = wkt_blob_keyword (p, "LINESTRING")) > 0)
+	cls = GAIA_LINESTRING;
+    else if ((len = wkt_blob_keyword (p, "POLYGON")) > 0)
+	cls = GAIA_POLYGON;
+    else
+	return 0;
+    p += len;
+
+/* checking for the optional Z suffix; M and ZM are left to the parser */
+    tb.has_z = 0;
+    q = p;
+    while (*q == ' ' || *q == '\t' || *q == '\n')
+	q++;
+    if (*q == 'Z' || *q == 'z')
+      {
+	  if (*(q + 1) == 'M' || *(q + 1) == 'm')
+	      return 0;
+	  tb.has_z = 1;
+	  p = q + 1;
+      }
+    else if (*q == 'M' || *q == 'm')
+	return 0;
+
+/* the same GEOMETRY CLASS check applied by gaiaParseWkt() */
+    declared = cls;
+    if (cls == GAIA_POINT && tb.has_z)
+	declared = GAIA_POINTZ;
+    if (type >= 0 && declared != type)
+	return 0;
+
+    if (!text_blob_start
+	(&tb, wkt, ')', text_blob_class (cls, tb.has_z), srid))
+	return 0;
+    tb.p = p;
+    switch (cls)
+      {
+      case GAIA_POINT:
+	  ok = text_blob_expect (&tb, '(') && wkt_blob_vertex (&tb, 1)
+	      && text_blob_expect (&tb, ')');
+	  break;
+      case GAIA_LINESTRING:
+	  ok = wkt_blob_vertices (&tb, 2, 1);
+	  break;
+      case GAIA_POLYGON:
+	  ok = wkt_blob_rings (&tb);
+	  break;
+      case GAIA_MULTIPOINT:
+	  ok = wkt_blob_collection (&tb, GAIA_POINT);
+	  break;
+      case GAIA_MULTILINESTRING:
+	  ok = wkt_blob_collection (&tb, GAIA_LINESTRING);
+	  break;
+      case GAIA_MULTIPOLYGON:
+	  ok = wkt_blob_collection (&tb, GAIA_POLYGON);
+	  break;
+      };
+    if (ok)
+      {
+	  /* nothing but blanks may follow */
+	  text_blob_blanks (&tb);
+	  if (*(tb.p) != '\0')
+	      ok = 0;
+      }
+    if (ok)
+	ok = text_blob_finish (&tb);
+    if (!ok)
+      {
+	  free (tb.blob);
+	  return 0;
+      }
+    *blob = tb.blob;
+    *blob_size = tb.size;
+    return 1;
+}
+
+static int
+geojson_blob_position (struct text_blob *tb, int mbr)
+{
+/* encoding a GeoJSON "[x, y]" or "[x, y, z]" position */
+    double x;
+    double y;
+    double z = 0.0;
+    if (!text_blob_expect (tb, '['))
+	return 0;
+    if (!text_blob_number (tb, &x))
+	return 0;
+    if (!text_blob_expect (tb, ','))
+	return 0;
+    if (!text_blob_number (tb, &y))
+	return 0;
+    if (tb->has_z)
+      {
+	  if (!text_blob_expect (tb, ','))
+	      return 0;
+	  if (!text_blob_number (tb, &z))
+	      return 0;
+      }
+    if (!text_blob_expect (tb, ']'))
+	return 0;
+    return text_blob_vertex (tb, x, y, z, mbr);
+}
+
+static int
+geojson_blob_positions (struct text_blob *tb, int min_points, int mbr)
+{
+/* encoding a GeoJSON "[[x, y], [x, y], ...]" array: # points + coords */
+    int offset;
+    int count = 0;
+    if (!text_blob_expect (tb, '['))
+	return 0;
+    offset = tb->size;
+    if (!text_blob_int32 (tb, 0))
+	return 0;
+    while (1)
+      {
+	  if (!geojson_blob_position (tb, mbr))
+	      return 0;
+	  count++;
+	  text_blob_blanks (tb);
+	  if (*(tb->p) == ',')
+	    {
+		tb->p++;
+		continue;
+	    }
+	  if (*(tb->p) != ']')
+	      return 0;
+	  tb->p++;
+	  break;
+      }
+    if (count < min_points)
+	return 0;
+    gaiaExport32 (tb->blob + offset, count, 1, tb->endian_arch);
+    return 1;
+}
+
+static int
+geojson_blob_rings (struct text_blob *tb)
+{
+/* encoding a GeoJSON Polygon array: # rings + rings */
+    int offset;
+    int count = 0;
+    if (!text_blob_expect (tb, '['))
+	return 0;
+    offset = tb->size;
+    if (!text_blob_int32 (tb, 0))
+	return 0;
+    while (1)
+      {
+	  if (!geojson_blob_positions (tb, 4, count == 0))
+	      return 0;
+	  count++;
+	  text_blob_blanks (tb);
+	  if (*(tb->p) == ',')
+	    {
+		tb->p++;
+		continue;
+	    }
+	  if (*(tb->p) != ']')
+	      return 0;
+	  tb->p++;
+	  break;
+      }
+    gaiaExport32 (tb->blob + offset, count, 1, tb->endian_arch);
+    return 1;
+}
+
+static int
+geojson_blob_collection (struct text_blob *tb, int type)
+{
+/* encoding the items of a GeoJSON MultiXxxx: # entities + entities */
+    int offset;
+    int count = 0;
+    int item = text_blob_class (type, tb->has_z);
+    if (!text_blob_expect (tb, '['))
+	return 0;
+    offset = tb->size;
+    if (!text_blob_int32 (tb, 0))
+	return 0;
+    while (1)
+      {
+	  if (!text_blob_entity (tb, item))
+	      return 0;
+	  switch (type)
+	    {
+	    case GAIA_POINT:
+		if (!geojson_blob_position (tb, 1))
+		    return 0;
+		break;
+	    case GAIA_LINESTRING:
+		if (!geojson_blob_positions (tb, 2, 1))
+		    return 0;
+		break;
+	    case GAIA_POLYGON:
+		if (!geojson_blob_rings (tb))
+		    return 0;
+		break;
+	    };
+	  count++;
+	  text_blob_blanks (tb);
+	  if (*(tb->p) == ',')
+	    {
+		tb->p++;
+		continue;
+	    }
+	  if (*(tb->p) != ']')
+	      return 0;
+	  tb->p++;
+	  break;
+      }
+    gaiaExport32 (tb->blob + offset, count, 1, tb->endian_arch);
+    return 1;
+}
+
+static int
+geojson_blob_dims (const char *p)
+{
+/* peeking at the first position: 2 or 3 coordinates, 0 if unknown */
+    int commas = 0;
+    while (*p == '[' || *p == ' ' || *p == '\t' || *p == '\n')
+	p++;
+    while (*p != ']')
+      {
+	  if (*p == '\0' || *p == '[')
+	      return 0;
+	  if (*p == ',')
+	      commas++;
+	  p++;
+      }
+    if (commas == 1)
+	return 2;
+    if (commas == 2)
+	return 3;
+    return 0;
+}
+
+static int
+geojson_blob_token (struct text_blob *tb, const char *token)
+{
+/* skipping blanks and then expecting a given (case-sensitive) token */
+    int len = strlen (token);
+    text_blob_blanks (tb);
+    if (strncmp (tb->p, token, len) != 0)
+	return 0;
+    tb->p += len;
+    return 1;
+}
+
+GAIAGEO_DECLARE int
+gaiaSimpleGeoJSONToBlob (const unsigned char *geojson, unsigned char **blob,
+			 int *blob_size)
+{
+/* directly encoding a simple GeoJSON Geometry as a SpatiaLite BLOB */
+    struct text_blob tb;
+    int cls;
+    int srid;
+    int dims;
+    int ok = 0;
+    *blob = NULL;
+    *blob_size = 0;
+    if (geojson == NULL)
+	return 0;
+
+/* expecting exactly {"type":"Xxxx","coordinates":[...]} */
+    tb.p = (const char *) geojson;
+    if (!text_blob_expect (&tb, '{'))
+	return 0;
+    if (!geojson_blob_token (&tb, "\"type\""))
+	return 0;
+    if (!text_blob_expect (&tb, ':'))
+	return 0;
+    if (geojson_blob_token (&tb, "\"Point\""))
+	cls = GAIA_POINT;
+    else if (geojson_blob_token (&tb, "\"LineString\""))
+	cls = GAIA_LINESTRING;
+    else if (geojson_blob_token (&tb, "\"Polygon\""))
+	cls = GAIA_POLYGON;
+    else if (geojson_blob_token (&tb, "\"MultiPoint\""))
+	cls = GAIA_MULTIPOINT;
+    else if (geojson_blob_token (&tb, "\"MultiLineString\""))
+	cls = GAIA_MULTILINESTRING;
+    else if (geojson_blob_token (&tb, "\"MultiPolygon\""))
+	cls = GAIA_MULTIPOLYGON;
+    else
+	return 0;
+    if (!text_blob_expect (&tb, ','))
+	return 0;
+    if (!geojson_blob_token (&tb, "\"coordinates\""))
+	return 0;
+    if (!text_blob_expect (&tb, ':'))
+	return 0;
+    dims = geojson_blob_dims (tb.p);
+    if (dims == 0)
+	return 0;
+    tb.has_z = (dims == 3);
+
+/*
+/ without any "crs" the GeoJSON parser sets SRID -1 for
+/ Point and LineString, and leaves all other classes to 0
+*/
+    if (cls == GAIA_POINT || cls == GAIA_LINESTRING)
+	srid = -1;
+    else
+	srid = 0;
+
+    if (!text_blob_start
+	(&tb, geojson, ']', text_blob_class (cls, tb.has_z), srid))
+	return 0;
+    switch (cls)
+      {
+      case GAIA_POINT:
+	  ok = geojson_blob_position (&tb, 1);
+	  break;
+      case GAIA_LINESTRING:
+	  ok = geojson_blob_positions (&tb, 2, 1);
+	  break;
+      case GAIA_POLYGON:
+	  ok = geojson_blob_rings (&tb);
+	  break;
+      case GAIA_MULTIPOINT:
+	  ok = geojson_blob_collection (&tb, GAIA_POINT);
+	  break;
+      case GAIA_MULTILINESTRING:
+	  ok = geojson_blob_collection (&tb, GAIA_LINESTRING);
+	  break;
+      case GAIA_MULTIPOLYGON:
+	  ok = geojson_blob_collection (&tb, GAIA_POLYGON);
+	  break;
+      };
+    if (ok)
+	ok = text_blob_expect (&tb, '}');
+    if (ok)
+      {
+	  /* nothing but blanks may follow */
+	  text_blob_blanks (&tb);
+	  if (*(tb.p) != '\0')
+	      ok = 0;
+      }
+    if (ok)
+	ok = text_blob_finish (&tb);
+    if (!ok)
+      {
+	  free (tb.blob);
+	  return 0;
+      }
+    *blob = tb.blob;
+    *blob_size = tb.size;
+    return 1;
+}
@@ -48,6 +48,9 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
 
 #if defined(_WIN32) && !defined(__MINGW32__)
 #include "config-msvc.h"
@@ -64,15 +67,19 @@ gaiaOutClean (char *buffer)
 {
 /* cleans unneeded trailing zeros */
     int i;
-    for (i = strlen (buffer) - 1; i > 0; i--)
+    if (strchr (buffer, '.') != NULL)
       {
-	  if (buffer[i] == '0')
+	  /* integer digits must never be suppressed */
+	  for (i = strlen (buffer) - 1; i > 0; i--)
+	    {
+		if (buffer[i] == '0')
+		    buffer[i] = '\0';
+		else
+		    break;
+	    }
+	  if (buffer[i] == '.')
 	      buffer[i] = '\0';
-	  else
-	      break;
       }
-    if (buffer[i] == '.')
-	buffer[i] = '\0';
     if (strcmp (buffer, "-0") == 0)
       {
 	  /* avoiding to return embarassing NEGATIVE ZEROes */
@@ -111,112 +118,292 @@ gaiaOutBufferReset (gaiaOutBufferPtr buf)
     buf->Error = 0;
 }
 
+static int
+gaiaOutBufferGrow (gaiaOutBufferPtr buf, int len)
+{
+/* 
+/ ensuring that at least LEN more bytes (plus the string terminator)
+/ will fit into the output buffer
+/
+/ the buffer geometrically grows (x1.5) so to keep the cost of very 
+/ long outputs (hundreds of MB) linear; returns 0 on failure
+*/
+    int required;
+    int new_size;
+    char *new_buf;
+    if (len < 0)
+	return 0;
+    if (len > INT_MAX - 1 - buf->WriteOffset)
+      {
+	  /* exceeding the max supported buffer size */
+	  buf->Error = 1;
+	  return 0;
+      }
+    required = buf->WriteOffset + len + 1;
+    if (required <= buf->BufferSize)
+	return 1;
+    if (buf->BufferSize == 0)
+	new_size = 1024;
+    else if (buf->BufferSize > INT_MAX / 3 * 2)
+	new_size = INT_MAX;
+    else
+	new_size = buf->BufferSize + (buf->BufferSize / 2);
+    if (new_size < required)
+	new_size = required;
+    new_buf = realloc (buf->Buffer, new_size);
+    if (!new_buf)
+      {
+	  buf->Error = 1;
+	  return 0;
+      }
+    buf->Buffer = new_buf;
+    buf->BufferSize = new_size;
+    return 1;
+}
+
+GAIAGEO_DECLARE void
+gaiaOutBufferReserve (gaiaOutBufferPtr buf, int size)
+{
+/* preallocating room for SIZE more bytes */
+    gaiaOutBufferGrow (buf, size);
+}
+
+GAIAGEO_DECLARE void
+gaiaAppendToOutBufferLen (gaiaOutBufferPtr buf, const char *text, int len)
+{
+/* appending a text string of known length */
+    if (!gaiaOutBufferGrow (buf, len))
+	return;
+    memcpy (buf->Buffer + buf->WriteOffset, text, len);
+    buf->WriteOffset += len;
+    *(buf->Buffer + buf->WriteOffset) = '\0';
+}
+
 GAIAGEO_DECLARE void
 gaiaAppendToOutBuffer (gaiaOutBufferPtr buf, const char *text)
 {
 /* appending a text string */
-    int len = strlen (text);
-    int free_size = buf->BufferSize - buf->WriteOffset;
-    if ((len + 1) > free_size)
+    gaiaAppendToOutBufferLen (buf, text, strlen (text));
+}
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+/* strict IEEE-754 double arithmetic: rounding errors are predictable */
+#define GAIA_OUT_FAST_DOUBLE
+
+static const double out_pow10[16] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15
+};
+
+static int
+gaiaOutFastDouble (char *out, double value, int precision)
+{
+/*
+/ fast conversion of a number into its "%.*f" representation 
+/ (trailing zeros suppressed) avoiding any printf-like call
+/
+/ only values requiring no more than 15 significant digits are
+/ supported; returns the length of the output string, or -1 if
+/ the generic printf-like conversion is required
+/
+/ SQLite's printf rounds an approximate decimal expansion of the value,
+/ so it may disagree with the exact binary value about a number lying
+/ very close to a rounding tie (e.g. 1.005 printed as "1.01"); any such
+/ ambiguous number is left to SQLite, thus always getting exactly the
+/ same text the writers used to print
+*/
+    double abs_value = (value < 0.0) ? -value : value;
+    double scale;
+    double hi;
+    double frac;
+    sqlite3_uint64 scaled;
+    sqlite3_uint64 divisor;
+    sqlite3_uint64 int_part;
+    sqlite3_uint64 frac_part;
+    char digits[32];
+    int nd = 0;
+    int len = 0;
+    int i;
+    if (precision < 0 || precision > 15)
+	return -1;
+    scale = out_pow10[precision];
+    hi = abs_value * scale;
+    if (!(hi < 1e15))
+	return -1;		/* too big, Infinity or NaN */
+
+/* rounding half up, unless too close to a tie */
+    scaled = (sqlite3_uint64) hi;
+    frac = hi - (double) scaled;
+    if (fabs (frac - 0.5) <= (hi + 1.0) * 1e-12)
+	return -1;
+    if (frac > 0.5)
+	scaled++;
+    if (scaled == 0)
       {
-	  /* we must allocate a bigger buffer */
-	  int new_size;
-	  char *new_buf;
-	  if (buf->BufferSize == 0)
-	      new_size = (len + 1) + 1024;
-	  else if (buf->BufferSize <= 4196)
-	      new_size = buf->BufferSize + (len + 1) + 4196;
-	  else if (buf->BufferSize <= 65536)
-	      new_size = buf->BufferSize + (len + 1) + 65536;
-	  else
-	      new_size = buf->BufferSize + (len + 1) + (1024 * 1024);
-	  new_buf = malloc (new_size);
-	  if (!new_buf)
+	  /* avoiding to return embarassing NEGATIVE ZEROes */
+	  out[0] = '0';
+	  out[1] = '\0';
+	  return 1;
+      }
+
+    divisor = (sqlite3_uint64) scale;
+    int_part = scaled / divisor;
+    frac_part = scaled % divisor;
+    if (value < 0.0)
+	out[len++] = '-';
+    do
+      {
+	  digits[nd++] = '0' + (char) (int_part % 10);
+	  int_part /= 10;
+      }
+    while (int_part > 0);
+    while (nd > 0)
+	out[len++] = digits[--nd];
+    if (frac_part > 0)
+      {
+	  /* suppressing unneeded trailing zeros */
+	  nd = precision;
+	  while (frac_part % 10 == 0)
 	    {
-		buf->Error = 1;
-		return;
+		frac_part /= 10;
+		nd--;
 	    }
-	  memcpy (new_buf, buf->Buffer, buf->WriteOffset);
-	  if (buf->Buffer)
-	      free (buf->Buffer);
-	  buf->Buffer = new_buf;
-	  buf->BufferSize = new_size;
+	  out[len++] = '.';
+	  for (i = nd - 1; i >= 0; i--)
+	    {
+		out[len + i] = '0' + (char) (frac_part % 10);
+		frac_part /= 10;
+	    }
+	  len += nd;
       }
-    strcpy (buf->Buffer + buf->WriteOffset, text);
-    buf->WriteOffset += len;
+    out[len] = '\0';
+    return len;
+}
+#endif
+
+GAIAGEO_DECLARE void
+gaiaAppendDoubleToOutBuffer (gaiaOutBufferPtr buf, double value, int precision)
+{
+/* appending a number formatted as "%.*f" (trailing zeros suppressed) */
+    char *text;
+#ifdef GAIA_OUT_FAST_DOUBLE
+    char fast[64];
+    int len = gaiaOutFastDouble (fast, value, precision);
+    if (len >= 0)
+      {
+	  gaiaAppendToOutBufferLen (buf, fast, len);
+	  return;
+      }
+#endif
+    text = sqlite3_mprintf ("%.*f", precision, value);
+    gaiaOutClean (text);
+    gaiaAppendToOutBuffer (buf, text);
+    sqlite3_free (text);
+}
+
+static int
+gaiaOutDims (int dimension_model)
+{
+/* returns the number of coordinates for each vertex */
+    switch (dimension_model)
+      {
+      case GAIA_XY_Z:
+      case GAIA_XY_M:
+	  return 3;
+      case GAIA_XY_Z_M:
+	  return 4;
+      };
+    return 2;
+}
+
+static void
+gaiaOutReserveGeometry (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom,
+			int precision, int vertex_overhead)
+{
+/*
+/ preallocating the estimated size of the text representation
+/ of some Geometry, so to avoid many intermediate reallocations
+/ while appending each single vertex
+*/
+    gaiaPointPtr point;
+    gaiaLinestringPtr line;
+    gaiaPolygonPtr polyg;
+    gaiaRingPtr ring;
+    int ib;
+    double vertices = 0.0;
+    double coords = 0.0;
+    double size;
+    if (precision < 0)
+	precision = 6;
+    if (precision > 18)
+	precision = 18;
+    point = geom->FirstPoint;
+    while (point)
+      {
+	  vertices += 1.0;
+	  coords += gaiaOutDims (point->DimensionModel);
+	  point = point->Next;
+      }
+    line = geom->FirstLinestring;
+    while (line)
+      {
+	  vertices += line->Points;
+	  coords += (double) (line->Points) * gaiaOutDims (line->DimensionModel);
+	  line = line->Next;
+      }
+    polyg = geom->FirstPolygon;
+    while (polyg)
+      {
+	  ring = polyg->Exterior;
+	  vertices += ring->Points;
+	  coords += (double) (ring->Points) * gaiaOutDims (ring->DimensionModel);
+	  for (ib = 0; ib < polyg->NumInteriors; ib++)
+	    {
+		ring = polyg->Interiors + ib;
+		vertices += ring->Points;
+		coords +=
+		    (double) (ring->Points) * gaiaOutDims (ring->DimensionModel);
+	    }
+	  polyg = polyg->Next;
+      }
+/* each coordinate: sign, some integer digits, decimal point and separator */
+    size = coords * (precision + 6) + vertices * vertex_overhead + 256.0;
+    if (size > INT_MAX / 2)
+	size = INT_MAX / 2;
+    gaiaOutBufferReserve (out_buf, (int) size);
 }
 
 static void
 gaiaOutPointStrict (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats a WKT POINT [Strict 2D] */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
-    buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-    gaiaOutClean (buf_y);
-    buf = sqlite3_mprintf ("%s %s", buf_x, buf_y);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
 }
 
 static void
 gaiaOutPoint (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats a WKT POINT */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
-    if (precision < 0)
-	buf_x = sqlite3_mprintf ("%1.6f", point->X);
-    else
-	buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
     if (precision < 0)
-	buf_y = sqlite3_mprintf ("%1.6f", point->Y);
-    else
-	buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-    gaiaOutClean (buf_y);
-    buf = sqlite3_mprintf ("%s %s", buf_x, buf_y);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+	precision = 6;
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
 }
 
 GAIAGEO_DECLARE void
 gaiaOutPointZex (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats a WKT POINTZ */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf;
     if (precision < 0)
-	buf_x = sqlite3_mprintf ("%1.6f", point->X);
-    else
-	buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
-    if (precision < 0)
-	buf_y = sqlite3_mprintf ("%1.6f", point->Y);
-    else
-	buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-    gaiaOutClean (buf_y);
-    if (precision < 0)
-	buf_z = sqlite3_mprintf ("%1.6f", point->Z);
-    else
-	buf_z = sqlite3_mprintf ("%.*f", precision, point->Z);
-    gaiaOutClean (buf_z);
-    buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_z);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    sqlite3_free (buf_z);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+	precision = 6;
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Z, precision);
 }
 
 GAIAGEO_DECLARE void
@@ -233,157 +420,72 @@ static void
 gaiaOutPointM (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats a WKT POINTM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_m;
-    char *buf;
     if (precision < 0)
-	buf_x = sqlite3_mprintf ("%1.6f", point->X);
-    else
-	buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
-    if (precision < 0)
-	buf_y = sqlite3_mprintf ("%1.6f", point->Y);
-    else
-	buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-    gaiaOutClean (buf_y);
-    if (precision < 0)
-	buf_m = sqlite3_mprintf ("%1.6f", point->M);
-    else
-	buf_m = sqlite3_mprintf ("%.*f", precision, point->M);
-    gaiaOutClean (buf_m);
-    buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_m);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    sqlite3_free (buf_m);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+	precision = 6;
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->M, precision);
 }
 
 static void
 gaiaOutPointZM (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats a WKT POINTZM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf_m;
-    char *buf;
     if (precision < 0)
-	buf_x = sqlite3_mprintf ("%1.6f", point->X);
-    else
-	buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
-    if (precision < 0)
-	buf_y = sqlite3_mprintf ("%1.6f", point->Y);
-    else
-	buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-    gaiaOutClean (buf_y);
-    if (precision < 0)
-	buf_z = sqlite3_mprintf ("%1.6f", point->Z);
-    else
-	buf_z = sqlite3_mprintf ("%.*f", precision, point->Z);
-    gaiaOutClean (buf_z);
-    if (precision < 0)
-	buf_m = sqlite3_mprintf ("%1.6f", point->M);
-    else
-	buf_m = sqlite3_mprintf ("%.*f", precision, point->M);
-    gaiaOutClean (buf_m);
-    buf = sqlite3_mprintf ("%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    sqlite3_free (buf_z);
-    sqlite3_free (buf_m);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+	precision = 6;
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Z, precision);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->M, precision);
 }
 
 static void
 gaiaOutEwktPoint (gaiaOutBufferPtr out_buf, gaiaPointPtr point)
 {
 /* formats an EWKT POINT */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
-    buf_x = sqlite3_mprintf ("%1.15f", point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%1.15f", point->Y);
-    gaiaOutClean (buf_y);
-    buf = sqlite3_mprintf ("%s %s", buf_x, buf_y);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, 15);
 }
 
 GAIAGEO_DECLARE void
 gaiaOutEwktPointZ (gaiaOutBufferPtr out_buf, gaiaPointPtr point)
 {
 /* formats an EWKT POINTZ */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf;
-    buf_x = sqlite3_mprintf ("%1.15f", point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%1.15f", point->Y);
-    gaiaOutClean (buf_y);
-    buf_z = sqlite3_mprintf ("%1.15f", point->Z);
-    gaiaOutClean (buf_z);
-    buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_z);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    sqlite3_free (buf_z);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Z, 15);
 }
 
 static void
 gaiaOutEwktPointM (gaiaOutBufferPtr out_buf, gaiaPointPtr point)
 {
 /* formats an EWKT POINTM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_m;
-    char *buf;
-    buf_x = sqlite3_mprintf ("%1.15f", point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%1.15f", point->Y);
-    gaiaOutClean (buf_y);
-    buf_m = sqlite3_mprintf ("%1.15f", point->M);
-    gaiaOutClean (buf_m);
-    buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_m);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    sqlite3_free (buf_m);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->M, 15);
 }
 
 static void
 gaiaOutEwktPointZM (gaiaOutBufferPtr out_buf, gaiaPointPtr point)
 {
 /* formats an EWKT POINTZM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf_m;
-    char *buf;
-    buf_x = sqlite3_mprintf ("%1.15f", point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%1.15f", point->Y);
-    gaiaOutClean (buf_y);
-    buf_z = sqlite3_mprintf ("%1.15f", point->Z);
-    gaiaOutClean (buf_z);
-    buf_m = sqlite3_mprintf ("%1.15f", point->M);
-    gaiaOutClean (buf_m);
-    buf = sqlite3_mprintf ("%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    sqlite3_free (buf_z);
-    sqlite3_free (buf_m);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Z, 15);
+    gaiaAppendToOutBuffer (out_buf, " ");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->M, 15);
 }
 
 static void
@@ -391,9 +493,6 @@ gaiaOutLinestringStrict (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line,
 			 int precision)
 {
 /* formats a WKT LINESTRING [Strict 2D] */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     double x;
     double y;
     double z;
@@ -417,18 +516,11 @@ gaiaOutLinestringStrict (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line,
 	    {
 		gaiaGetPoint (line->Coords, iv, &x, &y);
 	    }
-	  buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
 	  if (iv > 0)
-	      buf = sqlite3_mprintf (",%s %s", buf_x, buf_y);
-	  else
-	      buf = sqlite3_mprintf ("%s %s", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
       }
 }
 
@@ -437,33 +529,19 @@ gaiaOutLinestring (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line,
 		   int precision)
 {
 /* formats a WKT LINESTRING */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     double x;
     double y;
     int iv;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPoint (line->Coords, iv, &x, &y);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
 	  if (iv > 0)
-	      buf = sqlite3_mprintf (", %s %s", buf_x, buf_y);
-	  else
-	      buf = sqlite3_mprintf ("%s %s", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
       }
 }
 
@@ -472,41 +550,22 @@ gaiaOutLinestringZex (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line,
 		      int precision)
 {
 /* formats a WKT LINESTRINGZ */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf;
     double x;
     double y;
     double z;
     int iv;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPointXYZ (line->Coords, iv, &x, &y, &z);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
-	  if (precision < 0)
-	      buf_z = sqlite3_mprintf ("%1.6f", z);
-	  else
-	      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-	  gaiaOutClean (buf_z);
 	  if (iv > 0)
-	      buf = sqlite3_mprintf (", %s %s %s", buf_x, buf_y, buf_z);
-	  else
-	      buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_z);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
       }
 }
 
@@ -525,41 +584,22 @@ gaiaOutLinestringM (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line,
 		    int precision)
 {
 /* formats a WKT LINESTRINGM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_m;
-    char *buf;
     double x;
     double y;
     double m;
     int iv;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPointXYM (line->Coords, iv, &x, &y, &m);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
-	  if (precision < 0)
-	      buf_m = sqlite3_mprintf ("%1.6f", m);
-	  else
-	      buf_m = sqlite3_mprintf ("%.*f", precision, m);
-	  gaiaOutClean (buf_m);
 	  if (iv > 0)
-	      buf = sqlite3_mprintf (", %s %s %s", buf_x, buf_y, buf_m);
-	  else
-	      buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, precision);
       }
 }
 
@@ -568,50 +608,25 @@ gaiaOutLinestringZM (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line,
 		     int precision)
 {
 /* formats a WKT LINESTRINGZM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf_m;
-    char *buf;
     double x;
     double y;
     double z;
     double m;
     int iv;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPointXYZM (line->Coords, iv, &x, &y, &z, &m);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
-	  if (precision < 0)
-	      buf_z = sqlite3_mprintf ("%1.6f", z);
-	  else
-	      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-	  gaiaOutClean (buf_z);
-	  if (precision < 0)
-	      buf_m = sqlite3_mprintf ("%1.6f", m);
-	  else
-	      buf_m = sqlite3_mprintf ("%.*f", precision, m);
-	  gaiaOutClean (buf_m);
 	  if (iv > 0)
-	      buf =
-		  sqlite3_mprintf (", %s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  else
-	      buf = sqlite3_mprintf ("%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, precision);
       }
 }
 
@@ -619,27 +634,17 @@ static void
 gaiaOutEwktLinestring (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line)
 {
 /* formats an EWKT LINESTRING */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     double x;
     double y;
     int iv;
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPoint (line->Coords, iv, &x, &y);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
 	  if (iv > 0)
-	      buf = sqlite3_mprintf (",%s %s", buf_x, buf_y);
-	  else
-	      buf = sqlite3_mprintf ("%s %s", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
       }
 }
 
@@ -647,10 +652,6 @@ GAIAGEO_DECLARE void
 gaiaOutEwktLinestringZ (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line)
 {
 /* formats an EWKT LINESTRINGZ */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf;
     double x;
     double y;
     double z;
@@ -658,21 +659,13 @@ gaiaOutEwktLinestringZ (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line)
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPointXYZ (line->Coords, iv, &x, &y, &z);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
-	  buf_z = sqlite3_mprintf ("%1.15f", z);
-	  gaiaOutClean (buf_z);
 	  if (iv > 0)
-	      buf = sqlite3_mprintf (",%s %s %s", buf_x, buf_y, buf_z);
-	  else
-	      buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_z);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, 15);
       }
 }
 
@@ -680,10 +673,6 @@ static void
 gaiaOutEwktLinestringM (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line)
 {
 /* formats an EWKT LINESTRINGM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_m;
-    char *buf;
     double x;
     double y;
     double m;
@@ -691,21 +680,13 @@ gaiaOutEwktLinestringM (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line)
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPointXYM (line->Coords, iv, &x, &y, &m);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
-	  buf_m = sqlite3_mprintf ("%1.15f", m);
-	  gaiaOutClean (buf_m);
 	  if (iv > 0)
-	      buf = sqlite3_mprintf (",%s %s %s", buf_x, buf_y, buf_m);
-	  else
-	      buf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, 15);
       }
 }
 
@@ -713,11 +694,6 @@ static void
 gaiaOutEwktLinestringZM (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line)
 {
 /* formats an EWKT LINESTRINGZM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf_m;
-    char *buf;
     double x;
     double y;
     double z;
@@ -726,25 +702,15 @@ gaiaOutEwktLinestringZM (gaiaOutBufferPtr out_buf, gaiaLinestringPtr line)
     for (iv = 0; iv < line->Points; iv++)
       {
 	  gaiaGetPointXYZM (line->Coords, iv, &x, &y, &z, &m);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
-	  buf_z = sqlite3_mprintf ("%1.15f", z);
-	  gaiaOutClean (buf_z);
-	  buf_m = sqlite3_mprintf ("%1.15f", m);
-	  gaiaOutClean (buf_m);
 	  if (iv > 0)
-	      buf =
-		  sqlite3_mprintf (",%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  else
-	      buf = sqlite3_mprintf ("%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, 15);
       }
 }
 
@@ -753,9 +719,6 @@ gaiaOutPolygonStrict (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg,
 		      int precision)
 {
 /* formats a WKT POLYGON [Strict 2D] */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     int ib;
     int iv;
     double x;
@@ -781,20 +744,15 @@ gaiaOutPolygonStrict (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg,
 	    {
 		gaiaGetPoint (ring->Coords, iv, &x, &y);
 	    }
-	  buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
 	  if (iv == 0)
-	      buf = sqlite3_mprintf ("(%s %s", buf_x, buf_y);
-	  else if (iv == (ring->Points - 1))
-	      buf = sqlite3_mprintf (",%s %s)", buf_x, buf_y);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf = sqlite3_mprintf (",%s %s", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -817,20 +775,15 @@ gaiaOutPolygonStrict (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg,
 		  {
 		      gaiaGetPoint (ring->Coords, iv, &x, &y);
 		  }
-		buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		gaiaOutClean (buf_x);
-		buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		gaiaOutClean (buf_y);
 		if (iv == 0)
-		    buf = sqlite3_mprintf (",(%s %s", buf_x, buf_y);
-		else if (iv == (ring->Points - 1))
-		    buf = sqlite3_mprintf (",%s %s)", buf_x, buf_y);
+		    gaiaAppendToOutBuffer (out_buf, ",(");
 		else
-		    buf = sqlite3_mprintf (",%s %s", buf_x, buf_y);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -839,37 +792,25 @@ static void
 gaiaOutPolygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg, int precision)
 {
 /* formats a WKT POLYGON */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     int ib;
     int iv;
     double x;
     double y;
     gaiaRingPtr ring = polyg->Exterior;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPoint (ring->Coords, iv, &x, &y);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
 	  if (iv == 0)
-	      buf = sqlite3_mprintf ("(%s %s", buf_x, buf_y);
-	  else if (iv == (ring->Points - 1))
-	      buf = sqlite3_mprintf (", %s %s)", buf_x, buf_y);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf = sqlite3_mprintf (", %s %s", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -877,26 +818,15 @@ gaiaOutPolygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg, int precision)
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPoint (ring->Coords, iv, &x, &y);
-		if (precision < 0)
-		    buf_x = sqlite3_mprintf ("%1.6f", x);
-		else
-		    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		gaiaOutClean (buf_x);
-		if (precision < 0)
-		    buf_y = sqlite3_mprintf ("%1.6f", y);
-		else
-		    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		gaiaOutClean (buf_y);
 		if (iv == 0)
-		    buf = sqlite3_mprintf (", (%s %s", buf_x, buf_y);
-		else if (iv == (ring->Points - 1))
-		    buf = sqlite3_mprintf (", %s %s)", buf_x, buf_y);
+		    gaiaAppendToOutBuffer (out_buf, ", (");
 		else
-		    buf = sqlite3_mprintf (", %s %s", buf_x, buf_y);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ", ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -906,45 +836,28 @@ gaiaOutPolygonZex (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg,
 		   int precision)
 {
 /* formats a WKT POLYGONZ */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf;
     int ib;
     int iv;
     double x;
     double y;
     double z;
     gaiaRingPtr ring = polyg->Exterior;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPointXYZ (ring->Coords, iv, &x, &y, &z);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
-	  if (precision < 0)
-	      buf_z = sqlite3_mprintf ("%1.6f", z);
-	  else
-	      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-	  gaiaOutClean (buf_z);
 	  if (iv == 0)
-	      buf = sqlite3_mprintf ("(%s %s %s", buf_x, buf_y, buf_z);
-	  else if (iv == (ring->Points - 1))
-	      buf = sqlite3_mprintf (", %s %s %s)", buf_x, buf_y, buf_z);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf = sqlite3_mprintf (", %s %s %s", buf_x, buf_y, buf_z);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -952,32 +865,17 @@ gaiaOutPolygonZex (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg,
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPointXYZ (ring->Coords, iv, &x, &y, &z);
-		if (precision < 0)
-		    buf_x = sqlite3_mprintf ("%1.6f", x);
-		else
-		    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		gaiaOutClean (buf_x);
-		if (precision < 0)
-		    buf_y = sqlite3_mprintf ("%1.6f", y);
-		else
-		    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		gaiaOutClean (buf_y);
-		if (precision < 0)
-		    buf_z = sqlite3_mprintf ("%1.6f", z);
-		else
-		    buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		gaiaOutClean (buf_z);
 		if (iv == 0)
-		    buf = sqlite3_mprintf (", (%s %s %s", buf_x, buf_y, buf_z);
-		else if (iv == (ring->Points - 1))
-		    buf = sqlite3_mprintf (", %s %s %s)", buf_x, buf_y, buf_z);
+		    gaiaAppendToOutBuffer (out_buf, ", (");
 		else
-		    buf = sqlite3_mprintf (", %s %s %s", buf_x, buf_y, buf_z);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_z);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ", ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -996,45 +894,28 @@ static void
 gaiaOutPolygonM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg, int precision)
 {
 /* formats a WKT POLYGONM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_m;
-    char *buf;
     int ib;
     int iv;
     double x;
     double y;
     double m;
     gaiaRingPtr ring = polyg->Exterior;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPointXYM (ring->Coords, iv, &x, &y, &m);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
-	  if (precision < 0)
-	      buf_m = sqlite3_mprintf ("%1.6f", m);
-	  else
-	      buf_m = sqlite3_mprintf ("%.*f", precision, m);
-	  gaiaOutClean (buf_m);
 	  if (iv == 0)
-	      buf = sqlite3_mprintf ("(%s %s %s", buf_x, buf_y, buf_m);
-	  else if (iv == (ring->Points - 1))
-	      buf = sqlite3_mprintf (", %s %s %s)", buf_x, buf_y, buf_m);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf = sqlite3_mprintf (", %s %s %s", buf_x, buf_y, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, precision);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -1042,32 +923,17 @@ gaiaOutPolygonM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg, int precision)
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPointXYM (ring->Coords, iv, &x, &y, &m);
-		if (precision < 0)
-		    buf_x = sqlite3_mprintf ("%1.6f", x);
-		else
-		    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		gaiaOutClean (buf_x);
-		if (precision < 0)
-		    buf_y = sqlite3_mprintf ("%1.6f", y);
-		else
-		    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		gaiaOutClean (buf_y);
-		if (precision < 0)
-		    buf_m = sqlite3_mprintf ("%1.6f", m);
-		else
-		    buf_m = sqlite3_mprintf ("%.*f", precision, m);
-		gaiaOutClean (buf_m);
 		if (iv == 0)
-		    buf = sqlite3_mprintf (", (%s %s %s", buf_x, buf_y, buf_m);
-		else if (iv == (ring->Points - 1))
-		    buf = sqlite3_mprintf (", %s %s %s)", buf_x, buf_y, buf_m);
+		    gaiaAppendToOutBuffer (out_buf, ", (");
 		else
-		    buf = sqlite3_mprintf (", %s %s %s", buf_x, buf_y, buf_m);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_m);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ", ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, m, precision);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -1076,11 +942,6 @@ static void
 gaiaOutPolygonZM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg, int precision)
 {
 /* formats a WKT POLYGONZM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf_m;
-    char *buf;
     int ib;
     int iv;
     double x;
@@ -1088,45 +949,24 @@ gaiaOutPolygonZM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg, int precision)
     double z;
     double m;
     gaiaRingPtr ring = polyg->Exterior;
+    if (precision < 0)
+	precision = 6;
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPointXYZM (ring->Coords, iv, &x, &y, &z, &m);
-	  if (precision < 0)
-	      buf_x = sqlite3_mprintf ("%1.6f", x);
-	  else
-	      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  if (precision < 0)
-	      buf_y = sqlite3_mprintf ("%1.6f", y);
-	  else
-	      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
-	  if (precision < 0)
-	      buf_z = sqlite3_mprintf ("%1.6f", z);
-	  else
-	      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-	  gaiaOutClean (buf_z);
-	  if (precision < 0)
-	      buf_m = sqlite3_mprintf ("%1.6f", m);
-	  else
-	      buf_m = sqlite3_mprintf ("%.*f", precision, m);
-	  gaiaOutClean (buf_m);
 	  if (iv == 0)
-	      buf =
-		  sqlite3_mprintf ("(%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  else if (iv == (ring->Points - 1))
-	      buf =
-		  sqlite3_mprintf (", %s %s %s %s)", buf_x, buf_y, buf_z,
-				   buf_m);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf =
-		  sqlite3_mprintf (", %s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ", ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, precision);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -1134,44 +974,19 @@ gaiaOutPolygonZM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg, int precision)
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPointXYZM (ring->Coords, iv, &x, &y, &z, &m);
-		if (precision < 0)
-		    buf_x = sqlite3_mprintf ("%1.6f", x);
-		else
-		    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		gaiaOutClean (buf_x);
-		if (precision < 0)
-		    buf_y = sqlite3_mprintf ("%1.6f", y);
-		else
-		    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		gaiaOutClean (buf_y);
-		if (precision < 0)
-		    buf_z = sqlite3_mprintf ("%1.6f", z);
-		else
-		    buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		gaiaOutClean (buf_z);
-		if (precision < 0)
-		    buf_m = sqlite3_mprintf ("%1.6f", m);
-		else
-		    buf_m = sqlite3_mprintf ("%.*f", precision, m);
-		gaiaOutClean (buf_m);
 		if (iv == 0)
-		    buf =
-			sqlite3_mprintf (", (%s %s %s %s", buf_x, buf_y, buf_z,
-					 buf_m);
-		else if (iv == (ring->Points - 1))
-		    buf =
-			sqlite3_mprintf (", %s %s %s %s)", buf_x, buf_y, buf_z,
-					 buf_m);
+		    gaiaAppendToOutBuffer (out_buf, ", (");
 		else
-		    buf =
-			sqlite3_mprintf (", %s %s %s %s", buf_x, buf_y, buf_z,
-					 buf_m);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_z);
-		sqlite3_free (buf_m);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ", ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, m, precision);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -1180,9 +995,6 @@ static void
 gaiaOutEwktPolygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 {
 /* formats an EWKT POLYGON */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     int ib;
     int iv;
     double x;
@@ -1191,20 +1003,15 @@ gaiaOutEwktPolygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPoint (ring->Coords, iv, &x, &y);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
 	  if (iv == 0)
-	      buf = sqlite3_mprintf ("(%s %s", buf_x, buf_y);
-	  else if (iv == (ring->Points - 1))
-	      buf = sqlite3_mprintf (",%s %s)", buf_x, buf_y);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf = sqlite3_mprintf (",%s %s", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -1212,20 +1019,15 @@ gaiaOutEwktPolygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPoint (ring->Coords, iv, &x, &y);
-		buf_x = sqlite3_mprintf ("%1.15f", x);
-		gaiaOutClean (buf_x);
-		buf_y = sqlite3_mprintf ("%1.15f", y);
-		gaiaOutClean (buf_y);
 		if (iv == 0)
-		    buf = sqlite3_mprintf (",(%s %s", buf_x, buf_y);
-		else if (iv == (ring->Points - 1))
-		    buf = sqlite3_mprintf (",%s %s)", buf_x, buf_y);
+		    gaiaAppendToOutBuffer (out_buf, ",(");
 		else
-		    buf = sqlite3_mprintf (",%s %s", buf_x, buf_y);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -1234,10 +1036,6 @@ GAIAGEO_DECLARE void
 gaiaOutEwktPolygonZ (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 {
 /* formats an EWKT POLYGONZ */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf;
     int ib;
     int iv;
     double x;
@@ -1247,23 +1045,17 @@ gaiaOutEwktPolygonZ (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPointXYZ (ring->Coords, iv, &x, &y, &z);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
-	  buf_z = sqlite3_mprintf ("%1.15f", z);
-	  gaiaOutClean (buf_z);
 	  if (iv == 0)
-	      buf = sqlite3_mprintf ("(%s %s %s", buf_x, buf_y, buf_z);
-	  else if (iv == (ring->Points - 1))
-	      buf = sqlite3_mprintf (",%s %s %s)", buf_x, buf_y, buf_z);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf = sqlite3_mprintf (",%s %s %s", buf_x, buf_y, buf_z);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, 15);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -1271,23 +1063,17 @@ gaiaOutEwktPolygonZ (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPointXYZ (ring->Coords, iv, &x, &y, &z);
-		buf_x = sqlite3_mprintf ("%1.15f", x);
-		gaiaOutClean (buf_x);
-		buf_y = sqlite3_mprintf ("%1.15f", y);
-		gaiaOutClean (buf_y);
-		buf_z = sqlite3_mprintf ("%1.15f", z);
-		gaiaOutClean (buf_z);
 		if (iv == 0)
-		    buf = sqlite3_mprintf (",(%s %s %s", buf_x, buf_y, buf_z);
-		else if (iv == (ring->Points - 1))
-		    buf = sqlite3_mprintf (",%s %s %s)", buf_x, buf_y, buf_z);
+		    gaiaAppendToOutBuffer (out_buf, ",(");
 		else
-		    buf = sqlite3_mprintf (",%s %s %s", buf_x, buf_y, buf_z);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_z);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, z, 15);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -1296,10 +1082,6 @@ static void
 gaiaOutEwktPolygonM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 {
 /* formats an EWKT POLYGONM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_m;
-    char *buf;
     int ib;
     int iv;
     double x;
@@ -1309,23 +1091,17 @@ gaiaOutEwktPolygonM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPointXYM (ring->Coords, iv, &x, &y, &m);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
-	  buf_m = sqlite3_mprintf ("%1.15f", m);
-	  gaiaOutClean (buf_m);
 	  if (iv == 0)
-	      buf = sqlite3_mprintf ("(%s %s %s", buf_x, buf_y, buf_m);
-	  else if (iv == (ring->Points - 1))
-	      buf = sqlite3_mprintf (",%s %s %s)", buf_x, buf_y, buf_m);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf = sqlite3_mprintf (",%s %s %s", buf_x, buf_y, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, 15);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -1333,23 +1109,17 @@ gaiaOutEwktPolygonM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPointXYM (ring->Coords, iv, &x, &y, &m);
-		buf_x = sqlite3_mprintf ("%1.15f", x);
-		gaiaOutClean (buf_x);
-		buf_y = sqlite3_mprintf ("%1.15f", y);
-		gaiaOutClean (buf_y);
-		buf_m = sqlite3_mprintf ("%1.15f", m);
-		gaiaOutClean (buf_m);
 		if (iv == 0)
-		    buf = sqlite3_mprintf (",(%s %s %s", buf_x, buf_y, buf_m);
-		else if (iv == (ring->Points - 1))
-		    buf = sqlite3_mprintf (",%s %s %s)", buf_x, buf_y, buf_m);
+		    gaiaAppendToOutBuffer (out_buf, ",(");
 		else
-		    buf = sqlite3_mprintf (",%s %s %s", buf_x, buf_y, buf_m);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_m);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, m, 15);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -1358,11 +1128,6 @@ static void
 gaiaOutEwktPolygonZM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 {
 /* formats an EWKT POLYGONZM */
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
-    char *buf_m;
-    char *buf;
     int ib;
     int iv;
     double x;
@@ -1373,29 +1138,19 @@ gaiaOutEwktPolygonZM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
     for (iv = 0; iv < ring->Points; iv++)
       {
 	  gaiaGetPointXYZM (ring->Coords, iv, &x, &y, &z, &m);
-	  buf_x = sqlite3_mprintf ("%1.15f", x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%1.15f", y);
-	  gaiaOutClean (buf_y);
-	  buf_z = sqlite3_mprintf ("%1.15f", z);
-	  gaiaOutClean (buf_z);
-	  buf_m = sqlite3_mprintf ("%1.15f", m);
-	  gaiaOutClean (buf_m);
 	  if (iv == 0)
-	      buf =
-		  sqlite3_mprintf ("(%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  else if (iv == (ring->Points - 1))
-	      buf =
-		  sqlite3_mprintf (",%s %s %s %s)", buf_x, buf_y, buf_z, buf_m);
+	      gaiaAppendToOutBuffer (out_buf, "(");
 	  else
-	      buf =
-		  sqlite3_mprintf (",%s %s %s %s", buf_x, buf_y, buf_z, buf_m);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  sqlite3_free (buf_z);
-	  sqlite3_free (buf_m);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	      gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, z, 15);
+	  gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, m, 15);
+	  if (iv > 0 && iv == (ring->Points - 1))
+	      gaiaAppendToOutBuffer (out_buf, ")");
       }
     for (ib = 0; ib < polyg->NumInteriors; ib++)
       {
@@ -1403,32 +1158,19 @@ gaiaOutEwktPolygonZM (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polyg)
 	  for (iv = 0; iv < ring->Points; iv++)
 	    {
 		gaiaGetPointXYZM (ring->Coords, iv, &x, &y, &z, &m);
-		buf_x = sqlite3_mprintf ("%1.15f", x);
-		gaiaOutClean (buf_x);
-		buf_y = sqlite3_mprintf ("%1.15f", y);
-		gaiaOutClean (buf_y);
-		buf_z = sqlite3_mprintf ("%1.15f", z);
-		gaiaOutClean (buf_z);
-		buf_m = sqlite3_mprintf ("%1.15f", m);
-		gaiaOutClean (buf_m);
 		if (iv == 0)
-		    buf =
-			sqlite3_mprintf (",(%s %s %s %s", buf_x, buf_y, buf_z,
-					 buf_m);
-		else if (iv == (ring->Points - 1))
-		    buf =
-			sqlite3_mprintf (",%s %s %s %s)", buf_x, buf_y, buf_z,
-					 buf_m);
+		    gaiaAppendToOutBuffer (out_buf, ",(");
 		else
-		    buf =
-			sqlite3_mprintf (",%s %s %s %s", buf_x, buf_y, buf_z,
-					 buf_m);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_z);
-		sqlite3_free (buf_m);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		    gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, z, 15);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, m, 15);
+		if (iv > 0 && iv == (ring->Points - 1))
+		    gaiaAppendToOutBuffer (out_buf, ")");
 	    }
       }
 }
@@ -1445,6 +1187,7 @@ gaiaOutWktEx (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision)
     gaiaPolygonPtr polyg;
     if (!geom)
 	return;
+    gaiaOutReserveGeometry (out_buf, geom, precision, 2);
     point = geom->FirstPoint;
     while (point)
       {
@@ -1829,6 +1572,7 @@ gaiaOutWktStrict (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision)
 	precision = 18;
     if (!geom)
 	return;
+    gaiaOutReserveGeometry (out_buf, geom, precision, 1);
     point = geom->FirstPoint;
     while (point)
       {
@@ -1997,6 +1741,7 @@ gaiaToEWKT (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom)
     gaiaPolygonPtr polyg;
     if (!geom)
 	return;
+    gaiaOutReserveGeometry (out_buf, geom, 15, 1);
     sprintf (buf, "SRID=%d;", geom->Srid);
     gaiaAppendToOutBuffer (out_buf, buf);
     point = geom->FirstPoint;
@@ -2355,36 +2100,22 @@ static void
 SvgCoords (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats POINT as SVG-attributes x,y */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
-    buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%.*f", precision, point->Y * -1);
-    gaiaOutClean (buf_y);
-    buf = sqlite3_mprintf ("x=\"%s\" y=\"%s\"", buf_x, buf_y);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+    gaiaAppendToOutBuffer (out_buf, "x=\"");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, "\" y=\"");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y * -1, precision);
+    gaiaAppendToOutBuffer (out_buf, "\"");
 }
 
 static void
 SvgCircle (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats POINT as SVG-attributes cx,cy */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
-    buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%.*f", precision, point->Y * -1);
-    gaiaOutClean (buf_y);
-    buf = sqlite3_mprintf ("cx=\"%s\" cy=\"%s\"", buf_x, buf_y);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
+    gaiaAppendToOutBuffer (out_buf, "cx=\"");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, "\" cy=\"");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y * -1, precision);
+    gaiaAppendToOutBuffer (out_buf, "\"");
 }
 
 static void
@@ -2392,9 +2123,6 @@ SvgPathRelative (gaiaOutBufferPtr out_buf, int dims, int points, double *coords,
 		 int precision, int closePath)
 {
 /* formats LINESTRING as SVG-path d-attribute with relative coordinate moves */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     double x;
     double y;
     double z;
@@ -2420,34 +2148,31 @@ SvgPathRelative (gaiaOutBufferPtr out_buf, int dims, int points, double *coords,
 	    {
 		gaiaGetPoint (coords, iv, &x, &y);
 	    }
-	  buf_x = sqlite3_mprintf ("%.*f", precision, x - lastX);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, (y - lastY) * -1);
-	  gaiaOutClean (buf_y);
-	  if (iv == 0)
-	      buf = sqlite3_mprintf ("M %s %s l ", buf_x, buf_y);
-	  else
-	      buf = sqlite3_mprintf ("%s %s ", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  lastX = x;
-	  lastY = y;
 	  if (iv == points - 1 && closePath == 1)
 	      gaiaAppendToOutBuffer (out_buf, "z ");
 	  else
-	      gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
-      }
-}
-
-static void
-SvgPathAbsolute (gaiaOutBufferPtr out_buf, int dims, int points, double *coords,
-		 int precision, int closePath)
+	    {
+		if (iv == 0)
+		    gaiaAppendToOutBuffer (out_buf, "M ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x - lastX, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, (y - lastY) * -1,
+					     precision);
+		if (iv == 0)
+		    gaiaAppendToOutBuffer (out_buf, " l ");
+		else
+		    gaiaAppendToOutBuffer (out_buf, " ");
+	    }
+	  lastX = x;
+	  lastY = y;
+      }
+}
+
+static void
+SvgPathAbsolute (gaiaOutBufferPtr out_buf, int dims, int points, double *coords,
+		 int precision, int closePath)
 {
 /* formats LINESTRING as SVG-path d-attribute with relative coordinate moves */
-    char *buf_x;
-    char *buf_y;
-    char *buf;
     double x;
     double y;
     double z;
@@ -2471,21 +2196,20 @@ SvgPathAbsolute (gaiaOutBufferPtr out_buf, int dims, int points, double *coords,
 	    {
 		gaiaGetPoint (coords, iv, &x, &y);
 	    }
-	  buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, y * -1);
-	  gaiaOutClean (buf_y);
-	  if (iv == 0)
-	      buf = sqlite3_mprintf ("M %s %s L ", buf_x, buf_y);
-	  else
-	      buf = sqlite3_mprintf ("%s %s ", buf_x, buf_y);
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
 	  if (iv == points - 1 && closePath == 1)
 	      gaiaAppendToOutBuffer (out_buf, "z ");
 	  else
-	      gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	    {
+		if (iv == 0)
+		    gaiaAppendToOutBuffer (out_buf, "M ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, y * -1, precision);
+		if (iv == 0)
+		    gaiaAppendToOutBuffer (out_buf, " L ");
+		else
+		    gaiaAppendToOutBuffer (out_buf, " ");
+	    }
       }
 }
 
@@ -2506,6 +2230,7 @@ gaiaOutSvg (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int relative,
 	precision = 18;
     if (!geom)
 	return;
+    gaiaOutReserveGeometry (out_buf, geom, precision, 2);
     point = geom->FirstPoint;
     while (point)
       {
@@ -2816,33 +2541,16 @@ static void
 out_kml_point (gaiaOutBufferPtr out_buf, gaiaPointPtr point, int precision)
 {
 /* formats POINT as KML [x,y] */
-    char *buf_x = NULL;
-    char *buf_y = NULL;
-    char *buf_z = NULL;
-    char *buf = NULL;
-    buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-    gaiaOutClean (buf_x);
-    buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-    gaiaOutClean (buf_y);
-    if (point->DimensionModel == GAIA_XY_Z
-	|| point->DimensionModel == GAIA_XY_Z_M)
-      {
-	  buf_z = sqlite3_mprintf ("%.*f", precision, point->Z);
-	  gaiaOutClean (buf_z);
-      }
     gaiaAppendToOutBuffer (out_buf, "<Point><coordinates>");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+    gaiaAppendToOutBuffer (out_buf, ",");
+    gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
     if (point->DimensionModel == GAIA_XY_Z
 	|| point->DimensionModel == GAIA_XY_Z_M)
       {
-	  buf = sqlite3_mprintf ("%s,%s,%s", buf_x, buf_y, buf_z);
-	  sqlite3_free (buf_z);
+	  gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, point->Z, precision);
       }
-    else
-	buf = sqlite3_mprintf ("%s,%s", buf_x, buf_y);
-    sqlite3_free (buf_x);
-    sqlite3_free (buf_y);
-    gaiaAppendToOutBuffer (out_buf, buf);
-    sqlite3_free (buf);
     gaiaAppendToOutBuffer (out_buf, "</coordinates></Point>");
 }
 
@@ -2851,10 +2559,6 @@ out_kml_linestring (gaiaOutBuffer * out_buf, int dims, int points,
 		    double *coords, int precision)
 {
 /* formats LINESTRING as KML [x,y] */
-    char *buf_x = NULL;
-    char *buf_y = NULL;
-    char *buf_z = NULL;
-    char *buf = NULL;
     int iv;
     double x = 0.0;
     double y = 0.0;
@@ -2880,31 +2584,16 @@ out_kml_linestring (gaiaOutBuffer * out_buf, int dims, int points,
 	    {
 		gaiaGetPoint (coords, iv, &x, &y);
 	    }
-	  buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
+	  if (iv > 0)
+	      gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
 	  if (dims == GAIA_XY_Z || dims == GAIA_XY_Z_M)
 	    {
-		buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		gaiaOutClean (buf_z);
-		if (iv == 0)
-		    buf = sqlite3_mprintf ("%s,%s,%s", buf_x, buf_y, buf_z);
-		else
-		    buf = sqlite3_mprintf (" %s,%s,%s", buf_x, buf_y, buf_z);
-		sqlite3_free (buf_z);
-	    }
-	  else
-	    {
-		if (iv == 0)
-		    buf = sqlite3_mprintf ("%s,%s", buf_x, buf_y);
-		else
-		    buf = sqlite3_mprintf (" %s,%s", buf_x, buf_y);
+		gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
 	    }
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
       }
     gaiaAppendToOutBuffer (out_buf, "</coordinates></LineString>");
 }
@@ -2914,10 +2603,6 @@ out_kml_polygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polygon,
 		 int precision)
 {
 /* formats POLYGON as KML [x,y] */
-    char *buf_x = NULL;
-    char *buf_y = NULL;
-    char *buf_z = NULL;
-    char *buf = NULL;
     gaiaRingPtr ring;
     int iv;
     int ib;
@@ -2948,32 +2633,17 @@ out_kml_polygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polygon,
 	    {
 		gaiaGetPoint (ring->Coords, iv, &x, &y);
 	    }
-	  buf_x = sqlite3_mprintf ("%.*f", precision, x);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, y);
-	  gaiaOutClean (buf_y);
+	  if (iv > 0)
+	      gaiaAppendToOutBuffer (out_buf, " ");
+	  gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+	  gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
 	  if (ring->DimensionModel == GAIA_XY_Z
 	      || ring->DimensionModel == GAIA_XY_Z_M)
 	    {
-		buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		gaiaOutClean (buf_z);
-		if (iv == 0)
-		    buf = sqlite3_mprintf ("%s,%s,%s", buf_x, buf_y, buf_z);
-		else
-		    buf = sqlite3_mprintf (" %s,%s,%s", buf_x, buf_y, buf_z);
-		sqlite3_free (buf_z);
-	    }
-	  else
-	    {
-		if (iv == 0)
-		    buf = sqlite3_mprintf ("%s,%s", buf_x, buf_y);
-		else
-		    buf = sqlite3_mprintf (" %s,%s", buf_x, buf_y);
+		gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
 	    }
-	  sqlite3_free (buf_x);
-	  sqlite3_free (buf_y);
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
       }
     gaiaAppendToOutBuffer (out_buf,
 			   "</coordinates></LinearRing></outerBoundaryIs>");
@@ -3002,35 +2672,17 @@ out_kml_polygon (gaiaOutBufferPtr out_buf, gaiaPolygonPtr polygon,
 		  {
 		      gaiaGetPoint (ring->Coords, iv, &x, &y);
 		  }
-		buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		gaiaOutClean (buf_x);
-		buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		gaiaOutClean (buf_y);
+		if (iv > 0)
+		    gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
 		if (ring->DimensionModel == GAIA_XY_Z
 		    || ring->DimensionModel == GAIA_XY_Z_M)
 		  {
-		      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		      gaiaOutClean (buf_z);
-		      if (iv == 0)
-			  buf =
-			      sqlite3_mprintf ("%s,%s,%s", buf_x, buf_y, buf_z);
-		      else
-			  buf =
-			      sqlite3_mprintf (" %s,%s,%s", buf_x, buf_y,
-					       buf_z);
-		      sqlite3_free (buf_z);
-		  }
-		else
-		  {
-		      if (iv == 0)
-			  buf = sqlite3_mprintf ("%s,%s", buf_x, buf_y);
-		      else
-			  buf = sqlite3_mprintf (" %s,%s", buf_x, buf_y);
+		      gaiaAppendToOutBuffer (out_buf, ",");
+		      gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
 		  }
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
 	    }
 	  gaiaAppendToOutBuffer (out_buf,
 				 "</coordinates></LinearRing></innerBoundaryIs>");
@@ -3052,6 +2704,7 @@ gaiaOutFullKml (gaiaOutBufferPtr out_buf, const char *name, const char *desc,
 	return;
     if (precision > 18)
 	precision = 18;
+    gaiaOutReserveGeometry (out_buf, geom, precision, 1);
 
 /* counting how many elementary geometries are there */
     point = geom->FirstPoint;
@@ -3150,6 +2803,7 @@ gaiaOutBareKml (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision)
 	return;
     if (precision > 18)
 	precision = 18;
+    gaiaOutReserveGeometry (out_buf, geom, precision, 1);
 
 /* counting how many elementary geometries are there */
     point = geom->FirstPoint;
@@ -3237,14 +2891,16 @@ gaiaOutGml (gaiaOutBufferPtr out_buf, int version, int precision,
     int is_multi = 1;
     int is_coll = 0;
     char buf[2048];
-    char *xbuf;
-    char *buf_x;
-    char *buf_y;
-    char *buf_z;
+    const char *separator;
     if (!geom)
 	return;
     if (precision > 18)
 	precision = 18;
+    gaiaOutReserveGeometry (out_buf, geom, precision, 1);
+    if (version == 3)
+	separator = " ";
+    else
+	separator = ",";
 
     switch (geom->DeclaredType)
       {
@@ -3338,47 +2994,15 @@ gaiaOutGml (gaiaOutBufferPtr out_buf, int version, int precision,
 	  else
 	      strcat (buf, "<gml:coordinates>");
 	  gaiaAppendToOutBuffer (out_buf, buf);
-	  buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-	  gaiaOutClean (buf_y);
+	  gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+	  gaiaAppendToOutBuffer (out_buf, separator);
+	  gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
 	  if (point->DimensionModel == GAIA_XY_Z
 	      || point->DimensionModel == GAIA_XY_Z_M)
 	    {
-		buf_z = sqlite3_mprintf ("%.*f", precision, point->Z);
-		gaiaOutClean (buf_z);
-		if (version == 3)
-		  {
-		      xbuf = sqlite3_mprintf ("%s %s %s", buf_x, buf_y, buf_z);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
-		      sqlite3_free (buf_z);
-		  }
-		else
-		  {
-		      xbuf = sqlite3_mprintf ("%s,%s,%s", buf_x, buf_y, buf_z);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
-		      sqlite3_free (buf_z);
-		  }
+		gaiaAppendToOutBuffer (out_buf, separator);
+		gaiaAppendDoubleToOutBuffer (out_buf, point->Z, precision);
 	    }
-	  else
-	    {
-		if (version == 3)
-		  {
-		      xbuf = sqlite3_mprintf ("%s %s", buf_x, buf_y);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
-		  }
-		else
-		  {
-		      xbuf = sqlite3_mprintf ("%s,%s", buf_x, buf_y);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
-		  }
-	    }
-	  gaiaAppendToOutBuffer (out_buf, xbuf);
-	  sqlite3_free (xbuf);
 	  if (version == 3)
 	      strcpy (buf, "</gml:pos>");
 	  else
@@ -3477,60 +3101,16 @@ gaiaOutGml (gaiaOutBufferPtr out_buf, int version, int precision,
 		  {
 		      gaiaGetPoint (line->Coords, iv, &x, &y);
 		  }
-		if (iv == 0)
-		    *buf = '\0';
-		else
-		    strcpy (buf, " ");
+		if (iv > 0)
+		    gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, separator);
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
 		if (has_z)
 		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		      gaiaOutClean (buf_z);
-		      if (version == 3)
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s %s %s", buf, buf_x,
-						 buf_y, buf_z);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			    sqlite3_free (buf_z);
-			}
-		      else
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s,%s,%s", buf, buf_x,
-						 buf_y, buf_z);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			    sqlite3_free (buf_z);
-			}
-		  }
-		else
-		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      if (version == 3)
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s %s", buf, buf_x, buf_y);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			}
-		      else
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s,%s", buf, buf_x, buf_y);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			}
+		      gaiaAppendToOutBuffer (out_buf, separator);
+		      gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
 		  }
-		gaiaAppendToOutBuffer (out_buf, xbuf);
-		sqlite3_free (xbuf);
 	    }
 	  if (is_multi)
 	    {
@@ -3654,60 +3234,16 @@ gaiaOutGml (gaiaOutBufferPtr out_buf, int version, int precision,
 		  {
 		      gaiaGetPoint (ring->Coords, iv, &x, &y);
 		  }
-		if (iv == 0)
-		    *buf = '\0';
-		else
-		    strcpy (buf, " ");
+		if (iv > 0)
+		    gaiaAppendToOutBuffer (out_buf, " ");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, separator);
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
 		if (has_z)
 		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		      gaiaOutClean (buf_z);
-		      if (version == 3)
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s %s %s", buf, buf_x,
-						 buf_y, buf_z);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			    sqlite3_free (buf_z);
-			}
-		      else
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s,%s,%s", buf, buf_x,
-						 buf_y, buf_z);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			    sqlite3_free (buf_z);
-			}
+		      gaiaAppendToOutBuffer (out_buf, separator);
+		      gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
 		  }
-		else
-		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      if (version == 3)
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s %s", buf, buf_x, buf_y);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			}
-		      else
-			{
-			    xbuf =
-				sqlite3_mprintf ("%s%s,%s", buf, buf_x, buf_y);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			}
-		  }
-		gaiaAppendToOutBuffer (out_buf, xbuf);
-		sqlite3_free (xbuf);
 	    }
 	  /* closing the Exterior Ring */
 	  if (version == 3)
@@ -3766,62 +3302,17 @@ gaiaOutGml (gaiaOutBufferPtr out_buf, int version, int precision,
 			{
 			    gaiaGetPoint (ring->Coords, iv, &x, &y);
 			}
-		      if (iv == 0)
-			  *buf = '\0';
-		      else
-			  strcpy (buf, " ");
+		      if (iv > 0)
+			  gaiaAppendToOutBuffer (out_buf, " ");
+		      gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		      gaiaAppendToOutBuffer (out_buf, separator);
+		      gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
 		      if (has_z)
 			{
-			    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-			    gaiaOutClean (buf_x);
-			    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-			    gaiaOutClean (buf_y);
-			    buf_z = sqlite3_mprintf ("%.*f", precision, z);
-			    gaiaOutClean (buf_z);
-			    if (version == 3)
-			      {
-				  xbuf =
-				      sqlite3_mprintf ("%s%s %s %s", buf, buf_x,
-						       buf_y, buf_z);
-				  sqlite3_free (buf_x);
-				  sqlite3_free (buf_y);
-				  sqlite3_free (buf_z);
-			      }
-			    else
-			      {
-				  xbuf =
-				      sqlite3_mprintf ("%s%s,%s,%s", buf, buf_x,
-						       buf_y, buf_z);
-				  sqlite3_free (buf_x);
-				  sqlite3_free (buf_y);
-				  sqlite3_free (buf_z);
-			      }
+			    gaiaAppendToOutBuffer (out_buf, separator);
+			    gaiaAppendDoubleToOutBuffer (out_buf, z,
+							 precision);
 			}
-		      else
-			{
-			    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-			    gaiaOutClean (buf_x);
-			    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-			    gaiaOutClean (buf_y);
-			    if (version == 3)
-			      {
-				  xbuf =
-				      sqlite3_mprintf ("%s%s %s", buf, buf_x,
-						       buf_y);
-				  sqlite3_free (buf_x);
-				  sqlite3_free (buf_y);
-			      }
-			    else
-			      {
-				  xbuf =
-				      sqlite3_mprintf ("%s%s,%s", buf, buf_x,
-						       buf_y);
-				  sqlite3_free (buf_x);
-				  sqlite3_free (buf_y);
-			      }
-			}
-		      gaiaAppendToOutBuffer (out_buf, xbuf);
-		      sqlite3_free (xbuf);
 		  }
 		/* closing the Interior Ring */
 		if (version == 3)
@@ -3892,184 +3383,189 @@ gaiaOutGml (gaiaOutBufferPtr out_buf, int version, int precision,
     gaiaAppendToOutBuffer (out_buf, buf);
 }
 
-GAIAGEO_DECLARE void
-gaiaOutGeoJSON (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision,
-		int options)
+static void
+gaiaOutGeoJSONHeader (gaiaOutBufferPtr out_buf, int declared_type, int srid,
+		      double minx, double miny, double maxx, double maxy,
+		      int precision, int options, char *end_json,
+		      int *is_multi)
 {
-/*
-/ prints the GeoJSON representation of current geometry
-/ *result* returns the encoded GeoJSON or NULL if any error is encountered
-*/
-    gaiaPointPtr point;
-    gaiaLinestringPtr line;
-    gaiaPolygonPtr polyg;
-    gaiaRingPtr ring;
-    int iv;
-    int ib;
-    double x;
-    double y;
-    double z;
-    double m;
-    int has_z;
-    int is_multi = 0;
-    int multi_count = 0;
-    char *bbox;
+/* opening a GeoJSON geometry [BBOX and CRS included if required] */
+    gaiaOutBuffer bbox;
     char crs[2048];
     char *buf;
-    char *buf_x;
-    char *buf_y;
-    char *buf_m;
-    char *buf_z;
-    char endJson[16];
-    if (!geom)
-	return;
-    if (precision > 18)
-	precision = 18;
-
     if (options != 0)
       {
-	  bbox = NULL;
+	  gaiaOutBufferInitialize (&bbox);
 	  *crs = '\0';
-	  if (geom->Srid > 0)
+	  if (srid > 0)
 	    {
 		if (options == 2 || options == 3)
 		  {
 		      /* including short CRS */
 		      sprintf (crs,
 			       ",\"crs\":{\"type\":\"name\",\"properties\":{\"name\":\"EPSG:%d\"}}",
-			       geom->Srid);
+			       srid);
 		  }
 		if (options == 4 || options == 5)
 		  {
 		      /* including long CRS */
 		      sprintf (crs,
 			       ",\"crs\":{\"type\":\"name\",\"properties\":{\"name\":\"urn:ogc:def:crs:EPSG:%d\"}}",
-			       geom->Srid);
+			       srid);
 		  }
 	    }
 	  if (options == 1 || options == 3 || options == 5)
 	    {
 		/* including BBOX */
-		gaiaMbrGeometry (geom);
-		buf_x = sqlite3_mprintf ("%.*f", precision, geom->MinX);
-		gaiaOutClean (buf_x);
-		buf_y = sqlite3_mprintf ("%.*f", precision, geom->MinY);
-		gaiaOutClean (buf_y);
-		buf_z = sqlite3_mprintf ("%.*f", precision, geom->MaxX);
-		gaiaOutClean (buf_z);
-		buf_m = sqlite3_mprintf ("%.*f", precision, geom->MaxY);
-		gaiaOutClean (buf_m);
-		bbox =
-		    sqlite3_mprintf (",\"bbox\":[%s,%s,%s,%s]", buf_x, buf_y,
-				     buf_z, buf_m);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_z);
-		sqlite3_free (buf_m);
+		gaiaAppendToOutBuffer (&bbox, ",\"bbox\":[");
+		gaiaAppendDoubleToOutBuffer (&bbox, minx, precision);
+		gaiaAppendToOutBuffer (&bbox, ",");
+		gaiaAppendDoubleToOutBuffer (&bbox, miny, precision);
+		gaiaAppendToOutBuffer (&bbox, ",");
+		gaiaAppendDoubleToOutBuffer (&bbox, maxx, precision);
+		gaiaAppendToOutBuffer (&bbox, ",");
+		gaiaAppendDoubleToOutBuffer (&bbox, maxy, precision);
+		gaiaAppendToOutBuffer (&bbox, "]");
 	    }
-	  switch (geom->DeclaredType)
+	  switch (declared_type)
 	    {
 	    case GAIA_POINT:
 		buf =
 		    sqlite3_mprintf ("{\"type\":\"Point\"%s%s,\"coordinates\":",
-				     crs, bbox);
-		strcpy (endJson, "}");
+				     crs, bbox.Buffer);
+		strcpy (end_json, "}");
 		break;
 	    case GAIA_LINESTRING:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"LineString\"%s%s,\"coordinates\":[", crs,
-		     bbox);
-		strcpy (endJson, "}");
+		     bbox.Buffer);
+		strcpy (end_json, "}");
 		break;
 	    case GAIA_POLYGON:
 		buf =
 		    sqlite3_mprintf
-		    ("{\"type\":\"Polygon\"%s%s,\"coordinates\":[", crs, bbox);
-		strcpy (endJson, "}");
+		    ("{\"type\":\"Polygon\"%s%s,\"coordinates\":[", crs,
+		     bbox.Buffer);
+		strcpy (end_json, "}");
 		break;
 	    case GAIA_MULTIPOINT:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"MultiPoint\"%s%s,\"coordinates\":[", crs,
-		     bbox);
-		strcpy (endJson, "]}");
+		     bbox.Buffer);
+		strcpy (end_json, "]}");
 		break;
 	    case GAIA_MULTILINESTRING:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"MultiLineString\"%s%s,\"coordinates\":[[",
-		     crs, bbox);
-		strcpy (endJson, "]}");
+		     crs, bbox.Buffer);
+		strcpy (end_json, "]}");
 		break;
 	    case GAIA_MULTIPOLYGON:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"MultiPolygon\"%s%s,\"coordinates\":[[", crs,
-		     bbox);
-		strcpy (endJson, "]}");
+		     bbox.Buffer);
+		strcpy (end_json, "]}");
 		break;
 	    default:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"GeometryCollection\"%s%s,\"geometries\":[",
-		     crs, bbox);
-		strcpy (endJson, "]}");
-		is_multi = 1;
+		     crs, bbox.Buffer);
+		strcpy (end_json, "]}");
+		*is_multi = 1;
 		break;
 	    };
-	  if (bbox)
-	      sqlite3_free (bbox);
+	  gaiaOutBufferReset (&bbox);
       }
     else
       {
 	  /* omitting BBOX */
-	  switch (geom->DeclaredType)
+	  switch (declared_type)
 	    {
 	    case GAIA_POINT:
 		buf = sqlite3_mprintf ("{\"type\":\"Point\",\"coordinates\":");
-		strcpy (endJson, "}");
+		strcpy (end_json, "}");
 		break;
 	    case GAIA_LINESTRING:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"LineString\",\"coordinates\":[");
-		strcpy (endJson, "}");
+		strcpy (end_json, "}");
 		break;
 	    case GAIA_POLYGON:
 		buf =
 		    sqlite3_mprintf ("{\"type\":\"Polygon\",\"coordinates\":[");
-		strcpy (endJson, "}");
+		strcpy (end_json, "}");
 		break;
 	    case GAIA_MULTIPOINT:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"MultiPoint\",\"coordinates\":[");
-		strcpy (endJson, "]}");
+		strcpy (end_json, "]}");
 		break;
 	    case GAIA_MULTILINESTRING:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"MultiLineString\",\"coordinates\":[[");
-		strcpy (endJson, "]}");
+		strcpy (end_json, "]}");
 		break;
 	    case GAIA_MULTIPOLYGON:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"MultiPolygon\",\"coordinates\":[[");
-		strcpy (endJson, "]}");
+		strcpy (end_json, "]}");
 		break;
 	    default:
 		buf =
 		    sqlite3_mprintf
 		    ("{\"type\":\"GeometryCollection\",\"geometries\":[");
-		strcpy (endJson, "]}");
-		is_multi = 1;
+		strcpy (end_json, "]}");
+		*is_multi = 1;
 		break;
 	    };
       }
     gaiaAppendToOutBuffer (out_buf, buf);
     sqlite3_free (buf);
+}
+
+GAIAGEO_DECLARE void
+gaiaOutGeoJSON (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision,
+		int options)
+{
+/*
+/ prints the GeoJSON representation of current geometry
+/ *result* returns the encoded GeoJSON or NULL if any error is encountered
+*/
+    gaiaPointPtr point;
+    gaiaLinestringPtr line;
+    gaiaPolygonPtr polyg;
+    gaiaRingPtr ring;
+    int iv;
+    int ib;
+    double x;
+    double y;
+    double z;
+    double m;
+    int has_z;
+    int is_multi = 0;
+    int multi_count = 0;
+    const char *buf;
+    char endJson[16];
+    if (!geom)
+	return;
+    if (precision > 18)
+	precision = 18;
+    gaiaOutReserveGeometry (out_buf, geom, precision, 3);
+
+    if (options == 1 || options == 3 || options == 5)
+	gaiaMbrGeometry (geom);
+    gaiaOutGeoJSONHeader (out_buf, geom->DeclaredType, geom->Srid, geom->MinX,
+			  geom->MinY, geom->MaxX, geom->MaxY, precision,
+			  options, endJson, &is_multi);
     point = geom->FirstPoint;
     while (point)
       {
@@ -4087,33 +3583,17 @@ gaiaOutGeoJSON (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision,
 		/* adding a further Point */
 		gaiaAppendToOutBuffer (out_buf, ",");
 	    }
-	  buf_x = sqlite3_mprintf ("%.*f", precision, point->X);
-	  gaiaOutClean (buf_x);
-	  buf_y = sqlite3_mprintf ("%.*f", precision, point->Y);
-	  gaiaOutClean (buf_y);
-	  has_z = 0;
+	  gaiaAppendToOutBuffer (out_buf, "[");
+	  gaiaAppendDoubleToOutBuffer (out_buf, point->X, precision);
+	  gaiaAppendToOutBuffer (out_buf, ",");
+	  gaiaAppendDoubleToOutBuffer (out_buf, point->Y, precision);
 	  if (point->DimensionModel == GAIA_XY_Z
 	      || point->DimensionModel == GAIA_XY_Z_M)
 	    {
-		buf_z = sqlite3_mprintf ("%.*f", precision, point->Z);
-		gaiaOutClean (buf_z);
-		has_z = 1;
-	    }
-	  if (has_z)
-	    {
-		buf = sqlite3_mprintf ("[%s,%s,%s]", buf_x, buf_y, buf_z);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
-		sqlite3_free (buf_z);
-	    }
-	  else
-	    {
-		buf = sqlite3_mprintf ("[%s,%s]", buf_x, buf_y);
-		sqlite3_free (buf_x);
-		sqlite3_free (buf_y);
+		gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, point->Z, precision);
 	    }
-	  gaiaAppendToOutBuffer (out_buf, buf);
-	  sqlite3_free (buf);
+	  gaiaAppendToOutBuffer (out_buf, "]");
 	  if (is_multi)
 	    {
 		gaiaAppendToOutBuffer (out_buf, "}");
@@ -4160,41 +3640,19 @@ gaiaOutGeoJSON (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision,
 		  {
 		      gaiaGetPoint (line->Coords, iv, &x, &y);
 		  }
-		if (has_z)
-		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		      gaiaOutClean (buf_z);
-		      if (iv == 0)
-			  buf =
-			      sqlite3_mprintf ("[%s,%s,%s]", buf_x, buf_y,
-					       buf_z);
-		      else
-			  buf =
-			      sqlite3_mprintf (",[%s,%s,%s]", buf_x, buf_y,
-					       buf_z);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
-		      sqlite3_free (buf_z);
-		  }
+		if (iv == 0)
+		    gaiaAppendToOutBuffer (out_buf, "[");
 		else
+		    gaiaAppendToOutBuffer (out_buf, ",[");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		if (has_z)
 		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      if (iv == 0)
-			  buf = sqlite3_mprintf ("[%s,%s]", buf_x, buf_y);
-		      else
-			  buf = sqlite3_mprintf (",[%s,%s]", buf_x, buf_y);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
+		      gaiaAppendToOutBuffer (out_buf, ",");
+		      gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
 		  }
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		gaiaAppendToOutBuffer (out_buf, "]");
 	    }
 	  /* closing the LineString */
 	  gaiaAppendToOutBuffer (out_buf, "]");
@@ -4245,41 +3703,19 @@ gaiaOutGeoJSON (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision,
 		  {
 		      gaiaGetPoint (ring->Coords, iv, &x, &y);
 		  }
-		if (has_z)
-		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      buf_z = sqlite3_mprintf ("%.*f", precision, z);
-		      gaiaOutClean (buf_z);
-		      if (iv == 0)
-			  buf =
-			      sqlite3_mprintf ("[[%s,%s,%s]", buf_x, buf_y,
-					       buf_z);
-		      else
-			  buf =
-			      sqlite3_mprintf (",[%s,%s,%s]", buf_x, buf_y,
-					       buf_z);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
-		      sqlite3_free (buf_z);
-		  }
+		if (iv == 0)
+		    gaiaAppendToOutBuffer (out_buf, "[[");
 		else
+		    gaiaAppendToOutBuffer (out_buf, ",[");
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBuffer (out_buf, ",");
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		if (has_z)
 		  {
-		      buf_x = sqlite3_mprintf ("%.*f", precision, x);
-		      gaiaOutClean (buf_x);
-		      buf_y = sqlite3_mprintf ("%.*f", precision, y);
-		      gaiaOutClean (buf_y);
-		      if (iv == 0)
-			  buf = sqlite3_mprintf ("[[%s,%s]", buf_x, buf_y);
-		      else
-			  buf = sqlite3_mprintf (",[%s,%s]", buf_x, buf_y);
-		      sqlite3_free (buf_x);
-		      sqlite3_free (buf_y);
+		      gaiaAppendToOutBuffer (out_buf, ",");
+		      gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
 		  }
-		gaiaAppendToOutBuffer (out_buf, buf);
-		sqlite3_free (buf);
+		gaiaAppendToOutBuffer (out_buf, "]");
 	    }
 	  /* closing the Exterior Ring */
 	  gaiaAppendToOutBuffer (out_buf, "]");
@@ -4309,43 +3745,20 @@ gaiaOutGeoJSON (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision,
 			{
 			    gaiaGetPoint (ring->Coords, iv, &x, &y);
 			}
-		      if (has_z)
-			{
-			    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-			    gaiaOutClean (buf_x);
-			    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-			    gaiaOutClean (buf_y);
-			    buf_z = sqlite3_mprintf ("%.*f", precision, z);
-			    gaiaOutClean (buf_z);
-			    if (iv == 0)
-				buf =
-				    sqlite3_mprintf (",[[%s,%s,%s]", buf_x,
-						     buf_y, buf_z);
-			    else
-				buf =
-				    sqlite3_mprintf (",[%s,%s,%s]", buf_x,
-						     buf_y, buf_z);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
-			    sqlite3_free (buf_z);
-			}
+		      if (iv == 0)
+			  gaiaAppendToOutBuffer (out_buf, ",[[");
 		      else
+			  gaiaAppendToOutBuffer (out_buf, ",[");
+		      gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		      gaiaAppendToOutBuffer (out_buf, ",");
+		      gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		      if (has_z)
 			{
-			    buf_x = sqlite3_mprintf ("%.*f", precision, x);
-			    gaiaOutClean (buf_x);
-			    buf_y = sqlite3_mprintf ("%.*f", precision, y);
-			    gaiaOutClean (buf_y);
-			    if (iv == 0)
-				buf =
-				    sqlite3_mprintf (",[[%s,%s]", buf_x, buf_y);
-			    else
-				buf =
-				    sqlite3_mprintf (",[%s,%s]", buf_x, buf_y);
-			    sqlite3_free (buf_x);
-			    sqlite3_free (buf_y);
+			    gaiaAppendToOutBuffer (out_buf, ",");
+			    gaiaAppendDoubleToOutBuffer (out_buf, z,
+							 precision);
 			}
-		      gaiaAppendToOutBuffer (out_buf, buf);
-		      sqlite3_free (buf);
+		      gaiaAppendToOutBuffer (out_buf, "]");
 		  }
 		/* closing the Interior Ring */
 		gaiaAppendToOutBuffer (out_buf, "]");
@@ -4361,3 +3774,370 @@ gaiaOutGeoJSON (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom, int precision,
       }
     gaiaAppendToOutBuffer (out_buf, endJson);
 }
+
+struct geojson_blob
+{
+/* helper struct: walking a SpatiaLite BLOB-Geometry */
+    const unsigned char *blob;
+    unsigned int size;
+    int little_endian;
+    int endian_arch;
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+};
+
+static int
+geojson_blob_class (int type, int *dims, int *has_z)
+{
+/* decoding an uncompressed class type: returns the base class or 0 */
+    int base;
+    if (type < 0)
+	return 0;
+    base = type % 1000;
+    if (base < GAIA_POINT || base > GAIA_GEOMETRYCOLLECTION)
+	return 0;
+    switch (type / 1000)
+      {
+      case 0:
+	  *dims = 2;
+	  *has_z = 0;
+	  break;
+      case 1:
+	  *dims = 3;
+	  *has_z = 1;
+	  break;
+      case 2:
+	  *dims = 3;
+	  *has_z = 0;
+	  break;
+      case 3:
+	  *dims = 4;
+	  *has_z = 1;
+	  break;
+      default:
+	  return 0;
+      };
+    return base;
+}
+
+static int
+geojson_blob_vertices (struct geojson_blob *gb, unsigned int *offset,
+		       int dims, int has_z, int update_mbr,
+		       gaiaOutBufferPtr out_buf, int precision,
+		       const char *first, const char *next)
+{
+/* 
+/ validating (out_buf == NULL) or printing a counted vertex sequence
+/ returns the number of vertices, 0 on invalid BLOB
+*/
+    int nverts;
+    int iv;
+    double x;
+    double y;
+    double z;
+    unsigned int off = *offset;
+    if (gb->size - 1 < off + 4)
+	return 0;
+    nverts = gaiaImport32 (gb->blob + off, gb->little_endian, gb->endian_arch);
+    off += 4;
+    if (nverts < 1
+	|| (unsigned int) nverts > (gb->size - 1 - off) / (8 * dims))
+	return 0;
+    for (iv = 0; iv < nverts; iv++)
+      {
+	  x = gaiaImport64 (gb->blob + off, gb->little_endian,
+			    gb->endian_arch);
+	  y = gaiaImport64 (gb->blob + off + 8, gb->little_endian,
+			    gb->endian_arch);
+	  if (out_buf == NULL)
+	    {
+		if (update_mbr)
+		  {
+		      if (x < gb->minx)
+			  gb->minx = x;
+		      if (y < gb->miny)
+			  gb->miny = y;
+		      if (x > gb->maxx)
+			  gb->maxx = x;
+		      if (y > gb->maxy)
+			  gb->maxy = y;
+		  }
+	    }
+	  else
+	    {
+		gaiaAppendToOutBuffer (out_buf, (iv == 0) ? first : next);
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBufferLen (out_buf, ",", 1);
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		if (has_z)
+		  {
+		      z = gaiaImport64 (gb->blob + off + 16, gb->little_endian,
+					gb->endian_arch);
+		      gaiaAppendToOutBufferLen (out_buf, ",", 1);
+		      gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
+		  }
+		gaiaAppendToOutBufferLen (out_buf, "]", 1);
+	    }
+	  off += 8 * dims;
+      }
+    *offset = off;
+    return nverts;
+}
+
+static int
+geojson_blob_entity (struct geojson_blob *gb, unsigned int *offset, int base,
+		     int dims, int has_z, gaiaOutBufferPtr out_buf,
+		     int precision)
+{
+/* 
+/ validating (out_buf == NULL) or printing the coordinates of
+/ an elementary Point, Linestring or Polygon
+*/
+    int rings;
+    int ib;
+    double x;
+    double y;
+    double z;
+    if (base == GAIA_POINT)
+      {
+	  if (gb->size - 1 < *offset + 8 * dims)
+	      return 0;
+	  x = gaiaImport64 (gb->blob + *offset, gb->little_endian,
+			    gb->endian_arch);
+	  y = gaiaImport64 (gb->blob + *offset + 8, gb->little_endian,
+			    gb->endian_arch);
+	  if (out_buf == NULL)
+	    {
+		if (x < gb->minx)
+		    gb->minx = x;
+		if (y < gb->miny)
+		    gb->miny = y;
+		if (x > gb->maxx)
+		    gb->maxx = x;
+		if (y > gb->maxy)
+		    gb->maxy = y;
+	    }
+	  else
+	    {
+		gaiaAppendToOutBufferLen (out_buf, "[", 1);
+		gaiaAppendDoubleToOutBuffer (out_buf, x, precision);
+		gaiaAppendToOutBufferLen (out_buf, ",", 1);
+		gaiaAppendDoubleToOutBuffer (out_buf, y, precision);
+		if (has_z)
+		  {
+		      z = gaiaImport64 (gb->blob + *offset + 16,
+					gb->little_endian, gb->endian_arch);
+		      gaiaAppendToOutBufferLen (out_buf, ",", 1);
+		      gaiaAppendDoubleToOutBuffer (out_buf, z, precision);
+		  }
+		gaiaAppendToOutBufferLen (out_buf, "]", 1);
+	    }
+	  *offset += 8 * dims;
+	  return 1;
+      }
+    if (base == GAIA_LINESTRING)
+      {
+	  if (!geojson_blob_vertices
+	      (gb, offset, dims, has_z, 1, out_buf, precision, "[", ",["))
+	      return 0;
+	  if (out_buf != NULL)
+	      gaiaAppendToOutBufferLen (out_buf, "]", 1);
+	  return 1;
+      }
+    /* Polygon: the Exterior Ring alone determines the MBR */
+    if (gb->size - 1 < *offset + 4)
+	return 0;
+    rings =
+	gaiaImport32 (gb->blob + *offset, gb->little_endian, gb->endian_arch);
+    *offset += 4;
+    if (rings < 1)
+	return 0;
+    for (ib = 0; ib < rings; ib++)
+      {
+	  if (!geojson_blob_vertices
+	      (gb, offset, dims, has_z, (ib == 0), out_buf, precision,
+	       (ib == 0) ? "[[" : ",[[", ",["))
+	      return 0;
+	  if (out_buf != NULL)
+	      gaiaAppendToOutBufferLen (out_buf, "]", 1);
+      }
+    if (out_buf != NULL)
+	gaiaAppendToOutBufferLen (out_buf, "]", 1);
+    return 1;
+}
+
+static int
+geojson_blob_next (struct geojson_blob *gb, unsigned int *offset,
+		   int *base, int *dims, int *has_z)
+{
+/* fetching the class type of the next collection item */
+    int type;
+    if (gb->size - 1 < *offset + 5)
+	return 0;
+    type =
+	gaiaImport32 (gb->blob + *offset + 1, gb->little_endian,
+		      gb->endian_arch);
+    *offset += 5;
+    *base = geojson_blob_class (type, dims, has_z);
+    if (*base < GAIA_POINT || *base > GAIA_POLYGON)
+	return 0;
+    return 1;
+}
+
+GAIAGEO_DECLARE int
+gaiaOutGeoJSONFromSpatiaLiteBlob (gaiaOutBufferPtr out_buf,
+				  const unsigned char *blob,
+				  unsigned int size, int precision,
+				  int options)
+{
+/*
+/ prints the GeoJSON representation of a SpatiaLite BLOB-Geometry
+/ directly walking the BLOB (no intermediate Geometry object); the
+/ output is exactly the same produced by gaiaOutGeoJSON
+/
+/ returns 0 (and prints nothing) if the BLOB can't be handled this
+/ way: compressed or otherwise unusual BLOBs must follow the usual
+/ gaiaFromSpatiaLiteBlobWkb() + gaiaOutGeoJSON() path
+*/
+    struct geojson_blob gb;
+    int type;
+    int base;
+    int dims;
+    int has_z;
+    int item_base;
+    int item_dims;
+    int item_has_z;
+    int srid;
+    int entities;
+    int ie;
+    int pass;
+    int is_multi = 0;
+    int multi_count = 0;
+    int kind_count;
+    unsigned int start;
+    unsigned int offset;
+    char endJson[16];
+    const char *item_header[3] = {
+	"{\"type\":\"Point\",\"coordinates\":",
+	"{\"type\":\"LineString\",\"coordinates\":[",
+	"{\"type\":\"Polygon\",\"coordinates\":["
+    };
+    if (blob == NULL || size < 45)
+	return 0;
+    if (*(blob + 0) != GAIA_MARK_START || *(blob + (size - 1)) != GAIA_MARK_END
+	|| *(blob + 38) != GAIA_MARK_MBR)
+	return 0;
+    if (*(blob + 1) == GAIA_LITTLE_ENDIAN)
+	gb.little_endian = 1;
+    else if (*(blob + 1) == GAIA_BIG_ENDIAN)
+	gb.little_endian = 0;
+    else
+	return 0;
+    gb.blob = blob;
+    gb.size = size;
+    gb.endian_arch = gaiaEndianArch ();
+    gb.minx = DBL_MAX;
+    gb.miny = DBL_MAX;
+    gb.maxx = -DBL_MAX;
+    gb.maxy = -DBL_MAX;
+    type = gaiaImport32 (blob + 39, gb.little_endian, gb.endian_arch);
+    base = geojson_blob_class (type, &dims, &has_z);
+    if (base == 0)
+	return 0;
+    srid = gaiaImport32 (blob + 2, gb.little_endian, gb.endian_arch);
+    if (precision > 18)
+	precision = 18;
+    if (base <= GAIA_POLYGON)
+      {
+	  /* an elementary Geometry */
+	  entities = 1;
+	  start = 43;
+      }
+    else
+      {
+	  /* a MULTIxx or GEOMETRYCOLLECTION */
+	  entities =
+	      gaiaImport32 (blob + 43, gb.little_endian, gb.endian_arch);
+	  if (entities < 0)
+	      return 0;
+	  start = 47;
+      }
+
+/* first pass: validating the whole BLOB and computing the MBR */
+    offset = start;
+    for (ie = 0; ie < entities; ie++)
+      {
+	  item_base = base;
+	  item_dims = dims;
+	  item_has_z = has_z;
+	  if (base > GAIA_POLYGON)
+	    {
+		if (!geojson_blob_next
+		    (&gb, &offset, &item_base, &item_dims, &item_has_z))
+		    return 0;
+	    }
+	  if (!geojson_blob_entity
+	      (&gb, &offset, item_base, item_dims, item_has_z, NULL,
+	       precision))
+	      return 0;
+      }
+
+    gaiaOutBufferReserve (out_buf,
+			  (size / 8) * ((precision > 0 ? precision : 0) + 8) +
+			  256);
+    gaiaOutGeoJSONHeader (out_buf, base, srid, gb.minx, gb.miny, gb.maxx,
+			  gb.maxy, precision, options, endJson, &is_multi);
+
+/* 
+/ further passes: printing Points, then Linestrings, then Polygons
+/ (just the same order followed by gaiaOutGeoJSON)
+*/
+    for (pass = GAIA_POINT; pass <= GAIA_POLYGON; pass++)
+      {
+	  kind_count = 0;
+	  offset = start;
+	  for (ie = 0; ie < entities; ie++)
+	    {
+		item_base = base;
+		item_dims = dims;
+		item_has_z = has_z;
+		if (base > GAIA_POLYGON)
+		    geojson_blob_next (&gb, &offset, &item_base, &item_dims,
+				       &item_has_z);
+		if (item_base != pass)
+		  {
+		      /* skipping an item of a different kind */
+		      geojson_blob_entity (&gb, &offset, item_base,
+					   item_dims, item_has_z, NULL,
+					   precision);
+		      continue;
+		  }
+		if (is_multi)
+		  {
+		      if (multi_count > 0)
+			  gaiaAppendToOutBufferLen (out_buf, ",", 1);
+		      gaiaAppendToOutBuffer (out_buf, item_header[pass - 1]);
+		  }
+		else if (kind_count > 0)
+		  {
+		      /* adding a further item */
+		      if (pass == GAIA_POINT)
+			  gaiaAppendToOutBufferLen (out_buf, ",", 1);
+		      else
+			  gaiaAppendToOutBufferLen (out_buf, ",[", 2);
+		  }
+		geojson_blob_entity (&gb, &offset, item_base, item_dims,
+				     item_has_z, out_buf, precision);
+		if (is_multi)
+		  {
+		      gaiaAppendToOutBufferLen (out_buf, "}", 1);
+		      multi_count++;
+		  }
+		kind_count++;
+	    }
+      }
+    gaiaAppendToOutBuffer (out_buf, endJson);
+    return 1;
+}
@@ -48,8 +48,8 @@ the terms of any one of the MPL, the GPL or the LGPL.
      spatialite_e( "Giving up.  Parser stack overflow\n");
 }
 
-// Increase this number if necessary
-%stack_size 1000000
+// 0 = growing the stack on demand (parsers are reused by each connection)
+%stack_size 0
 
 // Header files to be included in gml.c
 %include {
@@ -70,8 +70,8 @@ Greg Wilson			gvwilson@cs.toronto.ca
      spatialite_e( "Giving up.  Parser stack overflow\n");
 }
 
-// Increase this number if necessary
-%stack_size 1000000
+// 0 = growing the stack on demand (parsers are reused by each connection)
+%stack_size 0
 
 // Header files to be included in vanuatuWkt.c
 %include {
@@ -50,12 +50,22 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <float.h>
 
 #include <spatialite/sqlite.h>
 #include <spatialite/debug.h>
 #include <spatialite.h>
 #include <spatialite/gaiaaux.h>
+#include <spatialite/gaiageo.h>
 #include <spatialite/geopackage.h>
+#include "geopackage_internal.h"
+#include <spatialite_private.h>
+
+#ifndef _WIN32
+/* reading the origin in a background thread */
+#define CVT_THREADS
+#include <pthread.h>
+#endif
 
 struct pk_item
 {
@@ -177,7 +187,7 @@ static int
 create_gpkg_destination (sqlite3 * handle, const char *create_sql,
 			 const char *table_name, const char *column_name,
 			 const char *geometry_type, int has_z, int has_m,
-			 int srid, int spatial_index)
+			 int srid)
 {
 /* attempting to create a GPKG destination table */
     int ret;
@@ -223,23 +233,6 @@ create_gpkg_destination (sqlite3 * handle, const char *create_sql,
 	  return 0;
       }
 
-    if (spatial_index)
-      {
-	  /* adding Spatial Index support */
-	  sql =
-	      sqlite3_mprintf
-	      ("SELECT gpkgAddSpatialIndex(Lower(%Q), Lower(%Q))",
-	       table_name, column_name);
-	  ret = sqlite3_exec (handle, sql, NULL, NULL, &sql_err);
-	  sqlite3_free (sql);
-	  if (ret != SQLITE_OK)
-	    {
-		spatialite_e ("gpkgAddSpatialIndex \"%s\" error: %s\n",
-			      table_name, sql_err);
-		sqlite3_free (sql_err);
-		return 0;
-	    }
-      }
     return 1;
 }
 
@@ -422,7 +415,7 @@ create_Spatialite2GPKG_statements (sqlite3 * handle_in, sqlite3 * handle_out,
 				   const char *table_name,
 				   const char *geometry_column,
 				   sqlite3_stmt ** stmt_in,
-				   sqlite3_stmt ** stmt_out)
+				   sqlite3_stmt ** stmt_out, int *geom_index)
 {
 /* attempting to create the IN and OUT prepared stmts */
     int ret;
@@ -440,6 +433,7 @@ create_Spatialite2GPKG_statements (sqlite3 * handle_in, sqlite3 * handle_out,
     char *xtable;
     int first_in = 1;
     int first_out = 1;
+    int n_cols = 0;
     char *sql_err = NULL;
     sqlite3_stmt *xstmt_in;
     sqlite3_stmt *xstmt_out;
@@ -477,20 +471,19 @@ create_Spatialite2GPKG_statements (sqlite3 * handle_in, sqlite3 * handle_out,
 		xname = gaiaDoubleQuotedSql (name);
 		if (strcasecmp (name, geometry_column) == 0)
 		  {
-		      /* the geometry column */
+		      /* the geometry column: transcoded by do_copy_table */
+		      *geom_index = n_cols++;
 		      prev_sql = in_sql;
 		      if (first_in)
 			{
 			    in_sql =
-				sqlite3_mprintf ("%s AsGPB(\"%s\")", prev_sql,
-						 xname);
+				sqlite3_mprintf ("%s \"%s\"", prev_sql, xname);
 			    first_in = 0;
 			}
 		      else
 			{
 			    in_sql =
-				sqlite3_mprintf ("%s, AsGPB(\"%s\")", prev_sql,
-						 xname);
+				sqlite3_mprintf ("%s, \"%s\"", prev_sql, xname);
 			}
 		      sqlite3_free (prev_sql);
 		      prev_sql = out_sql;
@@ -513,6 +506,7 @@ create_Spatialite2GPKG_statements (sqlite3 * handle_in, sqlite3 * handle_out,
 		      free (xname);
 		      continue;
 		  }
+		n_cols++;
 		prev_sql = in_sql;
 		if (first_in)
 		  {
@@ -595,7 +589,7 @@ create_GPKG2Spatialite_statements (sqlite3 * handle_in, sqlite3 * handle_out,
 				   const char *table_name,
 				   const char *geometry_column,
 				   sqlite3_stmt ** stmt_in,
-				   sqlite3_stmt ** stmt_out)
+				   sqlite3_stmt ** stmt_out, int *geom_index)
 {
 /* attempting to create the IN and OUT prepared stmts */
     int ret;
@@ -613,6 +607,7 @@ create_GPKG2Spatialite_statements (sqlite3 * handle_in, sqlite3 * handle_out,
     char *xtable;
     int first_in = 1;
     int first_out = 1;
+    int n_cols = 0;
     char *sql_err = NULL;
     sqlite3_stmt *xstmt_in;
     sqlite3_stmt *xstmt_out;
@@ -650,20 +645,19 @@ create_GPKG2Spatialite_statements (sqlite3 * handle_in, sqlite3 * handle_out,
 		xname = gaiaDoubleQuotedSql (name);
 		if (strcasecmp (name, geometry_column) == 0)
 		  {
-		      /* the geometry column */
+		      /* the geometry column: transcoded by do_copy_table */
+		      *geom_index = n_cols++;
 		      prev_sql = in_sql;
 		      if (first_in)
 			{
 			    in_sql =
-				sqlite3_mprintf ("%s GeomFromGPB(\"%s\")",
-						 prev_sql, xname);
+				sqlite3_mprintf ("%s \"%s\"", prev_sql, xname);
 			    first_in = 0;
 			}
 		      else
 			{
 			    in_sql =
-				sqlite3_mprintf ("%s, GeomFromGPB(\"%s\")",
-						 prev_sql, xname);
+				sqlite3_mprintf ("%s, \"%s\"", prev_sql, xname);
 			}
 		      sqlite3_free (prev_sql);
 		      prev_sql = out_sql;
@@ -686,6 +680,7 @@ create_GPKG2Spatialite_statements (sqlite3 * handle_in, sqlite3 * handle_out,
 		      free (xname);
 		      continue;
 		  }
+		n_cols++;
 		prev_sql = in_sql;
 		if (first_in)
 		  {
@@ -763,81 +758,744 @@ create_GPKG2Spatialite_statements (sqlite3 * handle_in, sqlite3 * handle_out,
     return 0;
 }
 
+#define CVT_BATCH_ROWS	256	/* rows in each batch */
+#define CVT_BATCH_SLOTS	4	/* batches in flight between reader and writer */
+
+#define CVT_BATCH_MORE	0	/* a full batch: more rows may follow */
+#define CVT_BATCH_EOF	1	/* the last batch */
+#define CVT_BATCH_ERROR	2	/* reading from the origin failed */
+
+struct cvt_value
+{
+/* a column value buffered between the reader and the writer */
+    int type;
+    sqlite3_int64 int_value;
+    double dbl_value;
+    int offset;			/* TEXT or BLOB: offset into the batch buffer */
+    int size;
+};
+
+struct cvt_batch
+{
+/* a batch of rows read from the origin table */
+    int rows;
+    int status;
+    struct cvt_value *values;	/* rows * columns */
+    unsigned char *buffer;	/* TEXT and BLOB bytes */
+    int buf_size;
+    int buf_alloc;
+};
+
+struct cvt_copy
+{
+/* copying one table from the origin into the destination */
+    sqlite3 *handle_in;
+    sqlite3_stmt *stmt_in;
+    const char *table_name;
+    int columns;
+    int geom_index;		/* the Geometry column within stmt_in */
+    int to_gpkg;		/* SpatiaLite -> GPKG, or else GPKG -> SpatiaLite */
+    struct cvt_batch batches[CVT_BATCH_SLOTS];
+#ifdef CVT_THREADS
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int filled;			/* batches ready for the writer */
+    int abort;			/* the writer gave up */
+#endif
+};
+
+struct cvt_mbr
+{
+/* the MBR accumulated while walking a geometry */
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+};
+
 static int
-do_copy_table (sqlite3 * handle_in, sqlite3 * handle_out,
-	       sqlite3_stmt * stmt_in, sqlite3_stmt * stmt_out,
-	       const char *table_name)
+cvt_walk_coords (unsigned char *p, unsigned char *end, int n_coords,
+		 int coord_size, struct cvt_mbr *mbr, int endian_arch)
 {
-/* copying all rows from IN and OUT tables */
-    int ret;
-    char *sql_err = NULL;
+/* validating a run of coords, optionally updating the MBR */
+    int iv;
+    double x;
+    double y;
+    if (n_coords < 1 || (end - p) / coord_size < n_coords)
+	return 0;
+    for (iv = 0; iv < n_coords; iv++)
+      {
+	  if (mbr != NULL)
+	    {
+		x = gaiaImport64 (p, 1, endian_arch);
+		y = gaiaImport64 (p + 8, 1, endian_arch);
+		if (x != x || y != y)
+		    return 0;	/* NaN: empty Point */
+		if (x < mbr->minx)
+		    mbr->minx = x;
+		if (y < mbr->miny)
+		    mbr->miny = y;
+		if (x > mbr->maxx)
+		    mbr->maxx = x;
+		if (y > mbr->maxy)
+		    mbr->maxy = y;
+	    }
+	  p += coord_size;
+      }
+    return 1;
+}
 
-    while (1)
+static int
+cvt_walk_simple (unsigned char **xp, unsigned char *end, int type,
+		 struct cvt_mbr *mbr, int endian_arch)
+{
+/* walking the body of a Point, Linestring or Polygon */
+    unsigned char *p = *xp;
+    int coord_size;
+    int n;
+    int rings;
+    int ib;
+    switch (type / 1000)
       {
-	  /* scrolling the result set rows */
-	  ret = sqlite3_step (stmt_in);
+      case 0:
+	  coord_size = 16;
+	  break;
+      case 1:
+      case 2:
+	  coord_size = 24;
+	  break;
+      default:
+	  coord_size = 32;
+	  break;
+      };
+    switch (type % 1000)
+      {
+      case GAIA_POINT:
+	  if (!cvt_walk_coords (p, end, 1, coord_size, mbr, endian_arch))
+	      return 0;
+	  p += coord_size;
+	  break;
+      case GAIA_LINESTRING:
+	  if (end - p < 4)
+	      return 0;
+	  n = gaiaImport32 (p, 1, endian_arch);
+	  p += 4;
+	  if (!cvt_walk_coords (p, end, n, coord_size, mbr, endian_arch))
+	      return 0;
+	  p += n * coord_size;
+	  break;
+      case GAIA_POLYGON:
+	  if (end - p < 4)
+	      return 0;
+	  rings = gaiaImport32 (p, 1, endian_arch);
+	  p += 4;
+	  if (rings < 1)
+	      return 0;
+	  for (ib = 0; ib < rings; ib++)
+	    {
+		/* only the Exterior Ring contributes to the MBR */
+		if (end - p < 4)
+		    return 0;
+		n = gaiaImport32 (p, 1, endian_arch);
+		p += 4;
+		if (!cvt_walk_coords
+		    (p, end, n, coord_size, (ib == 0) ? mbr : NULL,
+		     endian_arch))
+		    return 0;
+		p += n * coord_size;
+	    }
+	  break;
+      default:
+	  return 0;
+      };
+    *xp = p;
+    return 1;
+}
+
+static int
+cvt_walk_body (unsigned char *p, unsigned char *end, int type,
+	       unsigned char mark_in, unsigned char mark_out,
+	       struct cvt_mbr *mbr, int endian_arch)
+{
+/*
+/ walking a little-endian geometry body (the same layout in both
+/ SpatiaLite BLOBs and WKB) and replacing the marker preceding each
+/ collection item; anything the generic decoders could reshape (empty
+/ or mixed-dimension items, unordered collections, non-ISO type codes)
+/ is refused
+*/
+    int items;
+    int item_type;
+    int last_type = 0;
+    int i;
+    mbr->minx = DBL_MAX;
+    mbr->miny = DBL_MAX;
+    mbr->maxx = -DBL_MAX;
+    mbr->maxy = -DBL_MAX;
+    if (type < 0 || type > 3999 || (type / 1000) * 1000 + 7 < type)
+	return 0;
+    if (type % 1000 >= GAIA_POINT && type % 1000 <= GAIA_POLYGON)
+      {
+	  if (!cvt_walk_simple (&p, end, type, mbr, endian_arch))
+	      return 0;
+	  return (p == end) ? 1 : 0;
+      }
+    if (type % 1000 < GAIA_MULTIPOINT)
+	return 0;
+    if (end - p < 4)
+	return 0;
+    items = gaiaImport32 (p, 1, endian_arch);
+    p += 4;
+    if (items < 1)
+	return 0;
+    for (i = 0; i < items; i++)
+      {
+	  if (end - p < 5 || *p != mark_in)
+	      return 0;
+	  *p = mark_out;
+	  item_type = gaiaImport32 (p + 1, 1, endian_arch);
+	  p += 5;
+	  if (item_type / 1000 != type / 1000)
+	      return 0;
+	  if (type % 1000 == GAIA_GEOMETRYCOLLECTION)
+	    {
+		/* Points, then Linestrings, then Polygons */
+		if (item_type < last_type)
+		    return 0;
+		last_type = item_type;
+	    }
+	  else if (item_type % 1000 != type % 1000 - 3)
+	      return 0;
+	  if (!cvt_walk_simple (&p, end, item_type, mbr, endian_arch))
+	      return 0;
+      }
+    return (p == end) ? 1 : 0;
+}
+
+static int
+cvt_blob_to_gpb (const unsigned char *blob, int size, unsigned char *gpb)
+{
+/*
+/ direct transcoding: SpatiaLite BLOB -> GPB
+/ the output (exactly size + 1 bytes) is the one gaiaToGPB would build
+*/
+    int srid;
+    int type;
+    struct cvt_mbr mbr;
+    int body = size - 44;
+    int endian_arch = gaiaEndianArch ();
+    if (size < 45 || *(blob + 0) != GAIA_MARK_START
+	|| *(blob + 1) != GAIA_LITTLE_ENDIAN || *(blob + 38) != GAIA_MARK_MBR
+	|| *(blob + size - 1) != GAIA_MARK_END)
+	return 0;
+    srid = gaiaImport32 (blob + 2, 1, endian_arch);
+    type = gaiaImport32 (blob + 39, 1, endian_arch);
+    gpb += GEOPACKAGE_HEADER_LEN + GEOPACKAGE_2D_ENVELOPE_LEN;
+    *gpb = 0x01;		/* WKB little-endian */
+    gaiaExport32 (gpb + 1, type, 1, endian_arch);
+    memcpy (gpb + 5, blob + 43, body);
+    if (!cvt_walk_body
+	(gpb + 5, gpb + 5 + body, type, GAIA_MARK_ENTITY, 0x01, &mbr,
+	 endian_arch))
+	return 0;
+    gpb -= GEOPACKAGE_HEADER_LEN + GEOPACKAGE_2D_ENVELOPE_LEN;
+    gpkgSetHeader2DLittleEndian (gpb, srid, endian_arch);
+    gpkgSetHeader2DMbr (gpb + GEOPACKAGE_HEADER_LEN, mbr.minx, mbr.miny,
+			mbr.maxx, mbr.maxy, endian_arch);
+    return 1;
+}
+
+static int
+cvt_gpb_wkb_offset (const unsigned char *gpb, int size)
+{
+/* locating the WKB payload of a plain (not empty, not extended) GPB */
+    int offset;
+    unsigned char flags;
+    if (size < GEOPACKAGE_HEADER_LEN || *(gpb + 0) != GEOPACKAGE_MAGIC1
+	|| *(gpb + 1) != GEOPACKAGE_MAGIC2 || *(gpb + 2) != GEOPACKAGE_VERSION)
+	return -1;
+    flags = *(gpb + 3);
+    if (flags & (GEOPACKAGE_WKB_EXTENDEDGEOMETRY_FLAG |
+		 GEOPACKAGE_WKB_EMPTY_FLAG))
+	return -1;
+    switch ((flags >> 1) & 0x07)
+      {
+      case 0:
+	  offset = GEOPACKAGE_HEADER_LEN;
+	  break;
+      case GEOPACKAGE_2D_ENVELOPE:
+	  offset = GEOPACKAGE_HEADER_LEN + GEOPACKAGE_2D_ENVELOPE_LEN;
+	  break;
+      case GEOPACKAGE_3D_ENVELOPE:
+      case GEOPACKAGE_2DM_ENVELOPE:
+	  offset = GEOPACKAGE_HEADER_LEN + GEOPACKAGE_3D_ENVELOPE_LEN;
+	  break;
+      case GEOPACKAGE_3DM_ENVELOPE:
+	  offset = GEOPACKAGE_HEADER_LEN + GEOPACKAGE_4D_ENVELOPE_LEN;
+	  break;
+      default:
+	  return -1;
+      };
+    if (size < offset + 5)
+	return -1;
+    return offset;
+}
+
+static int
+cvt_gpb_to_blob (const unsigned char *gpb, int size, int offset,
+		 unsigned char *blob)
+{
+/*
+/ direct transcoding: GPB -> SpatiaLite BLOB
+/ the output (exactly size - offset + 39 bytes) is the one
+/ gaiaToSpatiaLiteBlobWkb would build from gaiaFromGeoPackageGeometryBlob
+*/
+    int srid;
+    int type;
+    struct cvt_mbr mbr;
+    int body = size - offset - 5;
+    int endian_arch = gaiaEndianArch ();
+    const unsigned char *wkb = gpb + offset;
+    if (*wkb != 0x01)
+	return 0;		/* big-endian WKB */
+    srid =
+	gaiaImport32 (gpb + 4, *(gpb + 3) & GEOPACKAGE_WKB_LITTLEENDIAN,
+		      endian_arch);
+    type = gaiaImport32 (wkb + 1, 1, endian_arch);
+    memcpy (blob + 43, wkb + 5, body);
+    if (!cvt_walk_body
+	(blob + 43, blob + 43 + body, type, 0x01, GAIA_MARK_ENTITY, &mbr,
+	 endian_arch))
+	return 0;
+    *(blob + 0) = GAIA_MARK_START;
+    *(blob + 1) = GAIA_LITTLE_ENDIAN;
+    gaiaExport32 (blob + 2, srid, 1, endian_arch);
+    gaiaExport64 (blob + 6, mbr.minx, 1, endian_arch);
+    gaiaExport64 (blob + 14, mbr.miny, 1, endian_arch);
+    gaiaExport64 (blob + 22, mbr.maxx, 1, endian_arch);
+    gaiaExport64 (blob + 30, mbr.maxy, 1, endian_arch);
+    *(blob + 38) = GAIA_MARK_MBR;
+    gaiaExport32 (blob + 39, type, 1, endian_arch);
+    *(blob + 43 + body) = GAIA_MARK_END;
+    return 1;
+}
+
+static unsigned char *
+cvt_batch_room (struct cvt_batch *batch, int size)
+{
+/* reserving room for size more bytes in the batch buffer */
+    unsigned char *buf;
+    int alloc;
+    if (batch->buf_size + size > batch->buf_alloc)
+      {
+	  alloc = batch->buf_alloc * 2;
+	  if (alloc < batch->buf_size + size)
+	      alloc = batch->buf_size + size + 65536;
+	  buf = realloc (batch->buffer, alloc);
+	  if (buf == NULL)
+	      return NULL;
+	  batch->buffer = buf;
+	  batch->buf_alloc = alloc;
+      }
+    return batch->buffer + batch->buf_size;
+}
+
+static int
+cvt_batch_bytes (struct cvt_batch *batch, struct cvt_value *value,
+		 const void *bytes, int size)
+{
+/* copying some TEXT or BLOB value into the batch buffer */
+    unsigned char *p = cvt_batch_room (batch, size);
+    if (p == NULL)
+	return 0;
+    if (size > 0)
+	memcpy (p, bytes, size);
+    value->offset = batch->buf_size;
+    value->size = size;
+    batch->buf_size += size;
+    return 1;
+}
+
+static int
+cvt_batch_geometry (struct cvt_copy *copy, struct cvt_batch *batch,
+		    struct cvt_value *value)
+{
+/* transcoding the Geometry of the current row into the batch buffer */
+    const unsigned char *in =
+	sqlite3_column_blob (copy->stmt_in, copy->geom_index);
+    int in_size = sqlite3_column_bytes (copy->stmt_in, copy->geom_index);
+    unsigned char *out;
+    int out_size;
+    int offset;
+    int len;
+    unsigned char *p_result = NULL;
+    gaiaGeomCollPtr geom;
+    if (copy->to_gpkg)
+      {
+	  out_size = in_size + 1;
+	  out = cvt_batch_room (batch, out_size);
+	  if (out == NULL)
+	      return 0;
+	  if (cvt_blob_to_gpb (in, in_size, out))
+	      goto done;
+	  /* generic fallback, just as AsGPB() */
+	  geom = gaiaFromSpatiaLiteBlobWkb (in, in_size);
+	  if (geom != NULL)
+	    {
+		gaiaToGPB (geom, &p_result, &len);
+		gaiaFreeGeomColl (geom);
+	    }
+      }
+    else
+      {
+	  offset = cvt_gpb_wkb_offset (in, in_size);
+	  if (offset > 0)
+	    {
+		out_size = in_size - offset + 39;
+		out = cvt_batch_room (batch, out_size);
+		if (out == NULL)
+		    return 0;
+		if (cvt_gpb_to_blob (in, in_size, offset, out))
+		    goto done;
+	    }
+	  /* generic fallback, just as GeomFromGPB() */
+	  geom = gaiaFromGeoPackageGeometryBlob (in, in_size);
+	  if (geom != NULL)
+	    {
+		gaiaToSpatiaLiteBlobWkb (geom, &p_result, &len);
+		gaiaFreeGeomColl (geom);
+	    }
+      }
+    if (p_result == NULL)
+      {
+	  value->type = SQLITE_NULL;
+	  return 1;
+      }
+    value->type = SQLITE_BLOB;
+    if (!cvt_batch_bytes (batch, value, p_result, len))
+      {
+	  free (p_result);
+	  return 0;
+      }
+    free (p_result);
+    return 1;
+
+  done:
+    value->type = SQLITE_BLOB;
+    value->offset = batch->buf_size;
+    value->size = out_size;
+    batch->buf_size += out_size;
+    return 1;
+}
+
+static void
+cvt_fill_batch (struct cvt_copy *copy, struct cvt_batch *batch)
+{
+/* reading the next batch of rows from the origin table */
+    int ret;
+    int c;
+    struct cvt_value *value;
+    batch->rows = 0;
+    batch->buf_size = 0;
+    batch->status = CVT_BATCH_MORE;
+    while (batch->rows < CVT_BATCH_ROWS)
+      {
+	  ret = sqlite3_step (copy->stmt_in);
 	  if (ret == SQLITE_DONE)
-	      break;		/* end of result set */
-	  if (ret == SQLITE_ROW)
 	    {
-		int c;
-		int cols = sqlite3_column_count (stmt_in);
-		sqlite3_reset (stmt_out);
-		sqlite3_clear_bindings (stmt_out);
-		for (c = 0; c < cols; c++)
+		batch->status = CVT_BATCH_EOF;
+		return;
+	    }
+	  if (ret != SQLITE_ROW)
+	    {
+		spatialite_e ("Error while querying from \"%s\": %s\n",
+			      copy->table_name,
+			      sqlite3_errmsg (copy->handle_in));
+		batch->status = CVT_BATCH_ERROR;
+		return;
+	    }
+	  value = batch->values + (batch->rows * copy->columns);
+	  for (c = 0; c < copy->columns; c++, value++)
+	    {
+		value->type = sqlite3_column_type (copy->stmt_in, c);
+		if (c == copy->geom_index)
 		  {
-		      /* binding column values */
-		      switch (sqlite3_column_type (stmt_in, c))
-			{
-			case SQLITE_INTEGER:
-			    sqlite3_bind_int64 (stmt_out, c + 1,
-						sqlite3_column_int64 (stmt_in,
-								      c));
-			    break;
-			case SQLITE_FLOAT:
-			    sqlite3_bind_double (stmt_out, c + 1,
-						 sqlite3_column_double (stmt_in,
-									c));
-			    break;
-			case SQLITE_TEXT:
-			    sqlite3_bind_text (stmt_out, c + 1,
-					       (const char *)
-					       sqlite3_column_text (stmt_in, c),
-					       sqlite3_column_bytes (stmt_in,
-								     c),
-					       SQLITE_STATIC);
-			    break;
-			case SQLITE_BLOB:
-			    sqlite3_bind_blob (stmt_out, c + 1,
-					       sqlite3_column_blob (stmt_in, c),
-					       sqlite3_column_bytes (stmt_in,
-								     c),
-					       SQLITE_STATIC);
-			    break;
-			default:
-			    sqlite3_bind_null (stmt_out, c + 1);
-			    break;
-			};
+		      if (value->type != SQLITE_BLOB)
+			  value->type = SQLITE_NULL;
+		      else if (!cvt_batch_geometry (copy, batch, value))
+			  goto no_memory;
+		      continue;
 		  }
-		ret = sqlite3_step (stmt_out);
-		if (ret == SQLITE_DONE || ret == SQLITE_ROW)
-		    ;
-		else
+		switch (value->type)
 		  {
-		      /* an unexpected error occurred */
-		      spatialite_e ("Error while inserting into \"%s\": %s\n",
-				    table_name, sqlite3_errmsg (handle_out));
-		      goto stop;
-		  }
+		  case SQLITE_INTEGER:
+		      value->int_value =
+			  sqlite3_column_int64 (copy->stmt_in, c);
+		      break;
+		  case SQLITE_FLOAT:
+		      value->dbl_value =
+			  sqlite3_column_double (copy->stmt_in, c);
+		      break;
+		  case SQLITE_TEXT:
+		      if (!cvt_batch_bytes
+			  (batch, value, sqlite3_column_text (copy->stmt_in, c),
+			   sqlite3_column_bytes (copy->stmt_in, c)))
+			  goto no_memory;
+		      break;
+		  case SQLITE_BLOB:
+		      if (!cvt_batch_bytes
+			  (batch, value, sqlite3_column_blob (copy->stmt_in, c),
+			   sqlite3_column_bytes (copy->stmt_in, c)))
+			  goto no_memory;
+		      break;
+		  };
 	    }
+	  batch->rows++;
+      }
+    return;
+
+  no_memory:
+    spatialite_e ("Error while copying \"%s\": insufficient memory\n",
+		  copy->table_name);
+    batch->status = CVT_BATCH_ERROR;
+}
+
+static int
+cvt_flush_batch (struct cvt_copy *copy, struct cvt_batch *batch,
+		 sqlite3 * handle_out, sqlite3_stmt * stmt_out)
+{
+/* inserting a batch of rows into the destination table */
+    int ret;
+    int r;
+    int c;
+    struct cvt_value *value = batch->values;
+    for (r = 0; r < batch->rows; r++)
+      {
+	  /* every parameter is rebound on each row */
+	  sqlite3_reset (stmt_out);
+	  for (c = 0; c < copy->columns; c++, value++)
+	    {
+		switch (value->type)
+		  {
+		  case SQLITE_INTEGER:
+		      sqlite3_bind_int64 (stmt_out, c + 1, value->int_value);
+		      break;
+		  case SQLITE_FLOAT:
+		      sqlite3_bind_double (stmt_out, c + 1, value->dbl_value);
+		      break;
+		  case SQLITE_TEXT:
+		      sqlite3_bind_text (stmt_out, c + 1,
+					 (const char *) batch->buffer +
+					 value->offset, value->size,
+					 SQLITE_STATIC);
+		      break;
+		  case SQLITE_BLOB:
+		      sqlite3_bind_blob (stmt_out, c + 1,
+					 batch->buffer + value->offset,
+					 value->size, SQLITE_STATIC);
+		      break;
+		  default:
+		      sqlite3_bind_null (stmt_out, c + 1);
+		      break;
+		  };
+	    }
+	  ret = sqlite3_step (stmt_out);
+	  if (ret == SQLITE_DONE || ret == SQLITE_ROW)
+	      ;
 	  else
 	    {
 		/* an unexpected error occurred */
-		spatialite_e ("Error while querying from \"%s\": %s\n",
-			      table_name, sqlite3_errmsg (handle_in));
-		goto stop;
+		spatialite_e ("Error while inserting into \"%s\": %s\n",
+			      copy->table_name, sqlite3_errmsg (handle_out));
+		return 0;
+	    }
+      }
+    return 1;
+}
+
+#ifdef CVT_THREADS
+static void *
+cvt_reader (void *arg)
+{
+/* background thread: reading and transcoding batches of rows */
+    struct cvt_copy *copy = (struct cvt_copy *) arg;
+    struct cvt_batch *batch;
+    int slot = 0;
+    while (1)
+      {
+	  pthread_mutex_lock (&(copy->mutex));
+	  while (copy->filled == CVT_BATCH_SLOTS && !copy->abort)
+	      pthread_cond_wait (&(copy->cond), &(copy->mutex));
+	  if (copy->abort)
+	    {
+		pthread_mutex_unlock (&(copy->mutex));
+		break;
+	    }
+	  pthread_mutex_unlock (&(copy->mutex));
+	  batch = copy->batches + slot;
+	  cvt_fill_batch (copy, batch);
+	  pthread_mutex_lock (&(copy->mutex));
+	  copy->filled += 1;
+	  pthread_cond_broadcast (&(copy->cond));
+	  pthread_mutex_unlock (&(copy->mutex));
+	  if (batch->status != CVT_BATCH_MORE)
+	      break;
+	  slot = (slot + 1) % CVT_BATCH_SLOTS;
+      }
+    return NULL;
+}
+
+static int
+cvt_threads_enabled (sqlite3 * handle_in, sqlite3 * handle_out)
+{
+/*
+/ checking if the origin can be read by a background thread:
+/ SPATIALITE_GPKG_THREADS counts the reader threads exactly as all other
+/ *_THREADS variables do, but a single one is started at most; 0 forces
+/ the serial copy
+/
+/ a thread-safe library can still run in single-thread mode, as set by
+/ sqlite3_config() or by the open flags: both connections must own a
+/ mutex, i.e. they must be in serialized mode
+*/
+    if (splite_env_threads ("SPATIALITE_GPKG_THREADS", 1, 1) < 1)
+	return 0;
+    if (!sqlite3_threadsafe ())
+	return 0;
+    if (sqlite3_db_mutex (handle_in) == NULL
+	|| sqlite3_db_mutex (handle_out) == NULL)
+	return 0;
+    return 1;
+}
+
+static int
+cvt_copy_threaded (struct cvt_copy *copy, sqlite3 * handle_out,
+		   sqlite3_stmt * stmt_out, int *ok)
+{
+/*
+/ copying while a background thread reads and transcodes the following
+/ batches; the two connections are never used by both threads
+*/
+    pthread_t reader;
+    struct cvt_batch *batch;
+    int slot = 0;
+    int status;
+    pthread_mutex_init (&(copy->mutex), NULL);
+    pthread_cond_init (&(copy->cond), NULL);
+    copy->filled = 0;
+    copy->abort = 0;
+    if (pthread_create (&reader, NULL, cvt_reader, copy) != 0)
+      {
+	  pthread_cond_destroy (&(copy->cond));
+	  pthread_mutex_destroy (&(copy->mutex));
+	  return 0;
+      }
+    *ok = 1;
+    while (1)
+      {
+	  pthread_mutex_lock (&(copy->mutex));
+	  while (copy->filled == 0)
+	      pthread_cond_wait (&(copy->cond), &(copy->mutex));
+	  pthread_mutex_unlock (&(copy->mutex));
+	  batch = copy->batches + slot;
+	  status = batch->status;
+	  if (status == CVT_BATCH_ERROR
+	      || !cvt_flush_batch (copy, batch, handle_out, stmt_out))
+	    {
+		*ok = 0;
+		status = CVT_BATCH_ERROR;
+	    }
+	  pthread_mutex_lock (&(copy->mutex));
+	  copy->filled -= 1;
+	  if (status == CVT_BATCH_ERROR)
+	      copy->abort = 1;
+	  pthread_cond_broadcast (&(copy->cond));
+	  pthread_mutex_unlock (&(copy->mutex));
+	  if (status != CVT_BATCH_MORE)
+	      break;
+	  slot = (slot + 1) % CVT_BATCH_SLOTS;
+      }
+    pthread_join (reader, NULL);
+    pthread_cond_destroy (&(copy->cond));
+    pthread_mutex_destroy (&(copy->mutex));
+    return 1;
+}
+#endif /* end CVT_THREADS */
+
+static int
+do_copy_table (sqlite3 * handle_in, sqlite3 * handle_out,
+	       sqlite3_stmt * stmt_in, sqlite3_stmt * stmt_out,
+	       const char *table_name, int geom_index, int to_gpkg)
+{
+/*
+/ copying all rows from IN and OUT tables
+/
+/ Geometries are directly transcoded between SpatiaLite BLOBs and GPB,
+/ both wrapping the same little-endian WKB-like body; rows are moved in
+/ batches, read by a background thread when available
+*/
+    int ret;
+    char *sql_err = NULL;
+    struct cvt_copy copy;
+    struct cvt_batch *batch;
+    int i;
+    int ok = 0;
+    int done = 0;
+
+    copy.handle_in = handle_in;
+    copy.stmt_in = stmt_in;
+    copy.table_name = table_name;
+    copy.columns = sqlite3_column_count (stmt_in);
+    copy.geom_index = geom_index;
+    copy.to_gpkg = to_gpkg;
+    for (i = 0; i < CVT_BATCH_SLOTS; i++)
+      {
+	  batch = copy.batches + i;
+	  batch->rows = 0;
+	  batch->status = CVT_BATCH_MORE;
+	  batch->values = NULL;
+	  batch->buffer = NULL;
+	  batch->buf_size = 0;
+	  batch->buf_alloc = 0;
+      }
+    for (i = 0; i < CVT_BATCH_SLOTS; i++)
+      {
+	  batch = copy.batches + i;
+	  batch->values =
+	      malloc (sizeof (struct cvt_value) * CVT_BATCH_ROWS *
+		      (copy.columns > 0 ? copy.columns : 1));
+	  if (batch->values == NULL)
+	      goto stop;
+      }
+
+#ifdef CVT_THREADS
+    if (cvt_threads_enabled (handle_in, handle_out))
+	done = cvt_copy_threaded (&copy, handle_out, stmt_out, &ok);
+#endif
+    if (!done)
+      {
+	  /* reading and inserting in turn */
+	  batch = copy.batches;
+	  while (1)
+	    {
+		cvt_fill_batch (&copy, batch);
+		if (batch->status == CVT_BATCH_ERROR
+		    || !cvt_flush_batch (&copy, batch, handle_out, stmt_out))
+		    break;
+		if (batch->status == CVT_BATCH_EOF)
+		  {
+		      ok = 1;
+		      break;
+		  }
 	    }
       }
+    if (!ok)
+	goto stop;
+    for (i = 0; i < CVT_BATCH_SLOTS; i++)
+      {
+	  free (copy.batches[i].values);
+	  free (copy.batches[i].buffer);
+      }
 
 /* committing the still pending transaction */
     ret = sqlite3_exec (handle_out, "COMMIT", NULL, NULL, &sql_err);
@@ -850,6 +1508,11 @@ do_copy_table (sqlite3 * handle_in, sqlite3 * handle_out,
     return 1;
 
   stop:
+    for (i = 0; i < CVT_BATCH_SLOTS; i++)
+      {
+	  free (copy.batches[i].values);
+	  free (copy.batches[i].buffer);
+      }
 /* invalidating the still pending transaction */
     ret = sqlite3_exec (handle_out, "ROLLBACK", NULL, NULL, &sql_err);
     if (ret != SQLITE_OK)
@@ -861,6 +1524,204 @@ do_copy_table (sqlite3 * handle_in, sqlite3 * handle_out,
     return 0;
 }
 
+static int
+do_gpkg_spatial_index (sqlite3 * handle, const char *table_name,
+		       const char *column_name)
+{
+/*
+/ creating the GPKG Spatial Index once all rows have been copied,
+/ then bulk-loading it from the GPB envelopes in a single transaction
+*/
+    int ret;
+    char *sql_err = NULL;
+    char *sql;
+    char *xtable;
+    char *xcolumn;
+    sqlite3_stmt *stmt_in = NULL;
+    sqlite3_stmt *stmt_out = NULL;
+    const unsigned char *gpb;
+    int gpb_len;
+    unsigned char flags;
+    int little_endian;
+    int endian_arch = gaiaEndianArch ();
+    double min_x;
+    double max_x;
+    double min_y;
+    double max_y;
+    int has_z;
+    double min_z;
+    double max_z;
+    int has_m;
+    double min_m;
+    double max_m;
+
+/* adding Spatial Index support */
+    sql =
+	sqlite3_mprintf
+	("SELECT gpkgAddSpatialIndex(Lower(%Q), Lower(%Q))",
+	 table_name, column_name);
+    ret = sqlite3_exec (handle, sql, NULL, NULL, &sql_err);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+      {
+	  spatialite_e ("gpkgAddSpatialIndex \"%s\" error: %s\n",
+			table_name, sql_err);
+	  sqlite3_free (sql_err);
+	  return 0;
+      }
+
+/* preparing the IN and OUT stmts */
+    xtable = gaiaDoubleQuotedSql (table_name);
+    xcolumn = gaiaDoubleQuotedSql (column_name);
+    sql =
+	sqlite3_mprintf ("SELECT ROWID, \"%s\" FROM \"%s\"", xcolumn, xtable);
+    ret = sqlite3_prepare_v2 (handle, sql, strlen (sql), &stmt_in, NULL);
+    sqlite3_free (sql);
+    if (ret == SQLITE_OK)
+      {
+	  sql =
+	      sqlite3_mprintf ("INSERT OR REPLACE INTO \"rtree_%s_%s\" "
+			       "VALUES (?, ?, ?, ?, ?)", xtable, xcolumn);
+	  ret =
+	      sqlite3_prepare_v2 (handle, sql, strlen (sql), &stmt_out, NULL);
+	  sqlite3_free (sql);
+      }
+    free (xtable);
+    free (xcolumn);
+    if (ret != SQLITE_OK)
+      {
+	  spatialite_e ("Spatial Index \"%s\" error: %s\n", table_name,
+			sqlite3_errmsg (handle));
+	  goto error;
+      }
+
+    ret = sqlite3_exec (handle, "BEGIN", NULL, NULL, &sql_err);
+    if (ret != SQLITE_OK)
+      {
+	  spatialite_e ("BEGIN TRANSACTION error: %s\n", sql_err);
+	  sqlite3_free (sql_err);
+	  goto error;
+      }
+    while (1)
+      {
+	  /* scrolling the result set rows */
+	  ret = sqlite3_step (stmt_in);
+	  if (ret == SQLITE_DONE)
+	      break;		/* end of result set */
+	  if (ret != SQLITE_ROW)
+	    {
+		spatialite_e ("Spatial Index \"%s\" error: %s\n", table_name,
+			      sqlite3_errmsg (handle));
+		goto rollback;
+	    }
+	  if (sqlite3_column_type (stmt_in, 1) != SQLITE_BLOB)
+	      continue;
+	  gpb = sqlite3_column_blob (stmt_in, 1);
+	  gpb_len = sqlite3_column_bytes (stmt_in, 1);
+	  if (cvt_gpb_wkb_offset (gpb, gpb_len) < 0)
+	      continue;		/* not a GPB, or an empty one */
+	  flags = *(gpb + 3);
+	  if (((flags >> 1) & 0x07) != 0)
+	    {
+		/* every envelope starts by min_x, max_x, min_y, max_y */
+		little_endian = flags & GEOPACKAGE_WKB_LITTLEENDIAN;
+		min_x = gaiaImport64 (gpb + 8, little_endian, endian_arch);
+		max_x = gaiaImport64 (gpb + 16, little_endian, endian_arch);
+		min_y = gaiaImport64 (gpb + 24, little_endian, endian_arch);
+		max_y = gaiaImport64 (gpb + 32, little_endian, endian_arch);
+	    }
+	  else if (!gaiaGetEnvelopeFromGPB
+		   (gpb, gpb_len, &min_x, &max_x, &min_y, &max_y, &has_z,
+		    &min_z, &max_z, &has_m, &min_m, &max_m))
+	      continue;
+	  sqlite3_reset (stmt_out);
+	  sqlite3_bind_int64 (stmt_out, 1, sqlite3_column_int64 (stmt_in, 0));
+	  sqlite3_bind_double (stmt_out, 2, min_x);
+	  sqlite3_bind_double (stmt_out, 3, max_x);
+	  sqlite3_bind_double (stmt_out, 4, min_y);
+	  sqlite3_bind_double (stmt_out, 5, max_y);
+	  ret = sqlite3_step (stmt_out);
+	  if (ret != SQLITE_DONE && ret != SQLITE_ROW)
+	    {
+		spatialite_e ("Spatial Index \"%s\" error: %s\n", table_name,
+			      sqlite3_errmsg (handle));
+		goto rollback;
+	    }
+      }
+    sqlite3_finalize (stmt_in);
+    sqlite3_finalize (stmt_out);
+    ret = sqlite3_exec (handle, "COMMIT", NULL, NULL, &sql_err);
+    if (ret != SQLITE_OK)
+      {
+	  spatialite_e ("COMMIT TRANSACTION error: %s\n", sql_err);
+	  sqlite3_free (sql_err);
+	  return 0;
+      }
+    return 1;
+
+  rollback:
+    ret = sqlite3_exec (handle, "ROLLBACK", NULL, NULL, &sql_err);
+    if (ret != SQLITE_OK)
+      {
+	  spatialite_e ("ROLLBACK TRANSACTION error: %s\n", sql_err);
+	  sqlite3_free (sql_err);
+      }
+  error:
+    if (stmt_in != NULL)
+	sqlite3_finalize (stmt_in);
+    if (stmt_out != NULL)
+	sqlite3_finalize (stmt_out);
+    return 0;
+}
+
+static int
+do_spatialite_spatial_index (sqlite3 * handle_in, sqlite3 * handle_out,
+			     const char *table_name, const char *column_name)
+{
+/*
+/ creating a SpatiaLite Spatial Index once all rows have been copied,
+/ only if the GPKG origin had an R*Tree for this Geometry
+*/
+    int ret;
+    int i;
+    char **results;
+    int rows;
+    int columns;
+    int count = 0;
+    char *sql;
+    char *sql_err = NULL;
+
+    sql = sqlite3_mprintf ("SELECT Count(*) FROM gpkg_extensions "
+			   "WHERE Lower(table_name) = Lower(%Q) AND "
+			   "Lower(column_name) = Lower(%Q) AND "
+			   "extension_name = 'gpkg_rtree_index'", table_name,
+			   column_name);
+    ret = sqlite3_get_table (handle_in, sql, &results, &rows, &columns, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+	return 1;		/* no GPKG extensions at all */
+    for (i = 1; i <= rows; i++)
+	count = atoi (results[(i * columns) + 0]);
+    sqlite3_free_table (results);
+    if (count <= 0)
+	return 1;
+
+/* CreateSpatialIndex() bulk-loads the R*Tree from the BLOB MBRs */
+    sql =
+	sqlite3_mprintf ("SELECT CreateSpatialIndex(Lower(%Q), Lower(%Q))",
+			 table_name, column_name);
+    ret = sqlite3_exec (handle_out, sql, NULL, NULL, &sql_err);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+      {
+	  spatialite_e ("CreateSpatialIndex \"%s\" error: %s\n", table_name,
+			sql_err);
+	  sqlite3_free (sql_err);
+	  return 0;
+      }
+    return 1;
+}
+
 static int
 do_insert_content (sqlite3 * handle, const char *table_name,
 		   const char *geometry_column, int srid)
@@ -935,6 +1796,7 @@ copy_spatialite2GPKG (sqlite3 * handle_in, sqlite3 * handle_out, int legacy)
 		int has_m = 0;
 		int srid;
 		int spatial_index;
+		int geom_index = -1;
 		table_name = results[(i * columns) + 0];
 		geometry_column = results[(i * columns) + 1];
 		if (legacy)
@@ -1055,7 +1917,7 @@ copy_spatialite2GPKG (sqlite3 * handle_in, sqlite3 * handle_out, int legacy)
 		  }
 		if (!create_gpkg_destination
 		    (handle_out, create_sql, table_name, geometry_column,
-		     geometry_type, has_z, has_m, srid, spatial_index))
+		     geometry_type, has_z, has_m, srid))
 		  {
 		      /* error: unable to create the target destination */
 		      sqlite3_free (create_sql);
@@ -1065,14 +1927,15 @@ copy_spatialite2GPKG (sqlite3 * handle_in, sqlite3 * handle_out, int legacy)
 		sqlite3_free (create_sql);
 		if (!create_Spatialite2GPKG_statements
 		    (handle_in, handle_out, table_name, geometry_column,
-		     &stmt_in, &stmt_out))
+		     &stmt_in, &stmt_out, &geom_index))
 		  {
 		      /* error: unable to create the IN and OUT stmts */
 		      sqlite3_free_table (results);
 		      return 0;
 		  }
 		if (!do_copy_table
-		    (handle_in, handle_out, stmt_in, stmt_out, table_name))
+		    (handle_in, handle_out, stmt_in, stmt_out, table_name,
+		     geom_index, 1))
 		  {
 		      sqlite3_finalize (stmt_in);
 		      sqlite3_finalize (stmt_out);
@@ -1081,6 +1944,13 @@ copy_spatialite2GPKG (sqlite3 * handle_in, sqlite3 * handle_out, int legacy)
 		  }
 		sqlite3_finalize (stmt_in);
 		sqlite3_finalize (stmt_out);
+		if (spatial_index
+		    && !do_gpkg_spatial_index (handle_out, table_name,
+					       geometry_column))
+		  {
+		      sqlite3_free_table (results);
+		      return 0;
+		  }
 		if (!do_insert_content
 		    (handle_out, table_name, geometry_column, srid))
 		  {
@@ -1125,6 +1995,7 @@ copy_GPKG2Spatialite (sqlite3 * handle_in, sqlite3 * handle_out)
 		int has_m = 0;
 		int srid;
 		const char *dims = "XY";
+		int geom_index = -1;
 		table_name = results[(i * columns) + 0];
 		geometry_column = results[(i * columns) + 1];
 		geometry_type = results[(i * columns) + 2];
@@ -1160,14 +2031,15 @@ copy_GPKG2Spatialite (sqlite3 * handle_in, sqlite3 * handle_out)
 		sqlite3_free (create_sql);
 		if (!create_GPKG2Spatialite_statements
 		    (handle_in, handle_out, table_name, geometry_column,
-		     &stmt_in, &stmt_out))
+		     &stmt_in, &stmt_out, &geom_index))
 		  {
 		      /* error: unable to create the IN and OUT stmts */
 		      sqlite3_free_table (results);
 		      return 0;
 		  }
 		if (!do_copy_table
-		    (handle_in, handle_out, stmt_in, stmt_out, table_name))
+		    (handle_in, handle_out, stmt_in, stmt_out, table_name,
+		     geom_index, 0))
 		  {
 		      sqlite3_finalize (stmt_in);
 		      sqlite3_finalize (stmt_out);
@@ -1176,6 +2048,12 @@ copy_GPKG2Spatialite (sqlite3 * handle_in, sqlite3 * handle_out)
 		  }
 		sqlite3_finalize (stmt_in);
 		sqlite3_finalize (stmt_out);
+		if (!do_spatialite_spatial_index
+		    (handle_in, handle_out, table_name, geometry_column))
+		  {
+		      sqlite3_free_table (results);
+		      return 0;
+		  }
 	    }
       }
     sqlite3_free_table (results);
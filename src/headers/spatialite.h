@@ -318,6 +318,11 @@ extern "C"
  \n By explicitly specifying some expected geometry type this first scan
   will be skipped at all thus introducing a noticeable performance gain.
  \n Anyway, declaring a mismatching geometry type will surely cause a failure.
+ \n On platforms supporting POSIX threads large Shapefiles are decoded by
+  a pool of worker threads (one less than the available CPU cores), while
+  the calling thread simply inserts rows in their original order; the
+  SPATIALITE_SHP_THREADS environment variable can explicitly set the
+  number of workers (0 will disable at all any worker thread).
  */
     SPATIALITE_DECLARE int load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path,
 					       char *table, char *charset,
@@ -890,6 +895,72 @@ extern "C"
 					    int precision, int option,
 					    int *rows);
 
+/**
+ Dumps a full geometry-table into an external GeoJSON file as a collection
+ of Features [all other columns will be exported as Feature properties]
+
+ \param sqlite handle to current DB connection
+ \param table the name of the table to be exported
+ \param geom_col the name of the geometry column
+ \param outfile_path pathname for the GeoJSON file to be written to
+ \param precision number of decimal digits for coordinates
+ \param option the format to use for output
+ \param ndjson if TRUE a newline-delimited sequence of Features will be
+ written, one per line; otherwise a single FeatureCollection will be written
+ \param rows on completion will contain the total number of exported rows
+ 
+ \sa dump_geojson_ex
+
+ \note valid values for option are the same supported by dump_geojson_ex.
+ Rows containing a NULL geometry will be exported as well ("geometry":null);
+ BLOB values other than the geometry will always be exported as null.
+ The output file is written in large sequential chunks, and geometries are
+ directly encoded from their BLOB representation whenever possible.
+
+ \return 0 on failure, any other value on success
+ */
+    SPATIALITE_DECLARE int dump_geojson_features (sqlite3 * sqlite,
+						  char *table, char *geom_col,
+						  char *outfile_path,
+						  int precision, int option,
+						  int ndjson, int *rows);
+
+/**
+ Loads an external GeoJSON file into a newly created table
+
+ \param sqlite handle to current DB connection
+ \param path pathname of the GeoJSON file to be imported
+ \param table the name of the table to be created
+ \param geom_column the name of the geometry column; if NULL
+ then "Geometry" will be assumed by default.
+ \param srid the SRID to be set for Geometries; any negative value
+ means the SRID declared by a (legacy) "crs" member, or 4326 if none.
+ \param spatial_index if TRUE an R*Tree Spatial Index will be created
+ \param verbose if TRUE a short report is shown on stderr
+ \param rows on completion will contain the total number of imported rows
+ \param err_msg on completion will contain an error message (if any)
+
+ \sa dump_geojson_features
+
+ \note the input can be a FeatureCollection, a single Feature or Geometry,
+ or a sequence of Features (newline-delimited GeoJSON).
+ \n The layout of the table is inferred from the leading Features:
+ every Feature property becomes a column (INTEGER, DOUBLE or TEXT; nested
+ objects and arrays are stored as JSON TEXT), and the Geometry type is
+ the narrowest one fitting all sampled Geometries. Properties first
+ found later on are added as further columns, and the Geometry type is
+ widened as required (e.g. POINT to MULTIPOINT, XY to XYZ, or GEOMETRY).
+ \n All rows are inserted within a single transaction, and the Spatial
+ Index is built at the end.
+
+ \return 0 on failure, any other value on success
+ */
+    SPATIALITE_DECLARE int load_geojson (sqlite3 * sqlite, char *path,
+					 char *table, char *geom_column,
+					 int srid, int spatial_index,
+					 int verbose, int *rows,
+					 char *err_msg);
+
 /**
  Updates the LAYER_STATICS metadata table
 
@@ -1513,6 +1513,59 @@ extern "C"
     GAIAGEO_DECLARE void gaiaRingCentroid (gaiaRingPtr ring, double *rx,
 					   double *ry);
 
+/**
+ Measures the total planar Area for a Geometry object
+
+ \param geom pointer to Geometry object
+ \param area on completion this variable will contain the measured area
+
+ \return 0 on failure: any other value on success
+
+ \sa gaiaGeomCollArea, gaiaMeasureArea
+
+ \remark internal method: doesn't require any GEOS support.
+ */
+    GAIAGEO_DECLARE int gaiaGeomCollPlanarArea (gaiaGeomCollPtr geom,
+						double *area);
+
+/**
+ Measures the total planar Length or Perimeter for a Geometry object
+
+ \param geom pointer to Geometry object
+ \param perimeter if TRUE only Polygons will be considered, otherwise
+ only Linestrings will be considered.
+ \param length on completion this variable will contain the measured length
+ or perimeter
+
+ \return 0 on failure: any other value on success
+
+ \sa gaiaGeomCollLengthOrPerimeter, gaiaMeasureLength
+
+ \remark internal method: doesn't require any GEOS support.
+ */
+    GAIAGEO_DECLARE int gaiaGeomCollPlanarLengthOrPerimeter (gaiaGeomCollPtr
+							     geom,
+							     int perimeter,
+							     double *length);
+
+/**
+ Determines the Centroid for a Geometry object
+
+ \param geom pointer to Geometry object
+ \param x on completion this variable will contain the centroid X coordinate
+ \param y on completion this variable will contain the centroid Y coordinate
+
+ \return 0 on failure: any other value on success
+
+ \sa gaiaGeomCollCentroid, gaiaRingCentroid
+
+ \note returns exactly the same Centroid returned by GEOS.
+
+ \remark internal method: doesn't require any GEOS support.
+ */
+    GAIAGEO_DECLARE int gaiaGeomCollPlanarCentroid (gaiaGeomCollPtr geom,
+						    double *x, double *y);
+
 /**
  Determines the direction for a Ring object
 
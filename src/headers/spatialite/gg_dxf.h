@@ -635,6 +635,12 @@ extern "C"
 	gaiaDxfHatchPtr curr_hatch;
 /** internal parser variable */
 	int undeclared_layers;
+/** internal parser variable: streaming mode */
+	void *stream;
+/** internal parser variable: Layers hash index */
+	void *layers_index;
+/** internal parser variable: Blocks hash index */
+	void *blocks_index;
     } gaiaDxfParser;
 /**
  Typedef for DXF Layer object
@@ -770,6 +776,142 @@ extern "C"
 					       gaiaDxfParserPtr parser,
 					       int mode, int append);
 
+/**
+ Parsing a DXF file and directly storing all Geometries into a DB
+
+ \param db_handle handle to a valid DB connection
+ \param parser pointer to DXF Parser object
+ \param dxf_path pathname of the DXF external file to be parsed
+ \param mode should be one of GAIA_DXF_IMPORT_BY_LAYER or GAIA_DXF_IMPORT_MIXED
+ \param append boolean flag: if set and some required DB table already exists 
+  will attempt to append further rows into the existing table.
+  otherwise an error will be returned.
+
+ \return 0 on failure, any other value on success
+
+ \sa gaiaLoadFromDxfFile_r, gaiaCreateDxfParser, gaiaDestroyDxfParser,
+ gaiaParseDxfFile, gaiaLoadFromDxfParser
+
+ \note same as calling gaiaParseDxfFile and then gaiaLoadFromDxfParser,
+ but streaming: Geometries are stored into the DB as soon as they have
+ been parsed, so that only BLOCK definitions are kept in memory and
+ peak memory usage is not related to the size of the DXF file.\n
+ the DXF file is read twice: a first quick pass simply collects the
+ Layer properties (dimensions, Extra Attributes) required to create the
+ DB tables.\n
+ the pointer to the DXF Parser object is expected to be the one 
+ returned by a previous call to gaiaCreateDxfParser and never used before.\n
+ not reentrant and thread unsafe.
+ */
+    GAIAGEO_DECLARE int gaiaLoadFromDxfFile (sqlite3 * db_handle,
+					     gaiaDxfParserPtr parser,
+					     const char *dxf_path, int mode,
+					     int append);
+
+/**
+ Parsing a DXF file and directly storing all Geometries into a DB
+
+ \param p_cache a memory pointer returned by spatialite_alloc_connection()
+ \param db_handle handle to a valid DB connection
+ \param parser pointer to DXF Parser object
+ \param dxf_path pathname of the DXF external file to be parsed
+ \param mode should be one of GAIA_DXF_IMPORT_BY_LAYER or GAIA_DXF_IMPORT_MIXED
+ \param append boolean flag: if set and some required DB table already exists 
+  will attempt to append further rows into the existing table.
+  otherwise an error will be returned.
+
+ \return 0 on failure, any other value on success
+
+ \sa gaiaLoadFromDxfFile, gaiaCreateDxfParser, gaiaDestroyDxfParser,
+ gaiaParseDxfFile_r, gaiaLoadFromDxfParser
+
+ \note same as gaiaLoadFromDxfFile\n
+ reentrant and thread-safe.
+ */
+    GAIAGEO_DECLARE int gaiaLoadFromDxfFile_r (const void *p_cache,
+					       sqlite3 * db_handle,
+					       gaiaDxfParserPtr parser,
+					       const char *dxf_path, int mode,
+					       int append);
+
+/**
+ Importing all DXF files found within a directory into a DB
+
+ \param db_handle handle to a valid DB connection
+ \param dir_path pathname of the directory containing the DXF files
+ \param srid the SRID value to be used for all Geometries
+ \param force_dims should be one of GAIA_DXF_AUTO_2D_3D, GAIA_DXF_FORCE_2D 
+ or GAIA_DXF_FORCE_3D
+ \param prefix an optional prefix to be used for DB target tables 
+ (could be NULL)
+ \param selected_layer if set, only the DXF Layer of corresponding name will 
+ be imported (could be NULL)
+ \param special_rings rings handling: should be one of GAIA_DXF_RING_NONE, 
+ GAIA_DXF_RING_LINKED of GAIA_DXF_RING_UNLINKED
+ \param mode should be one of GAIA_DXF_IMPORT_BY_LAYER or GAIA_DXF_IMPORT_MIXED
+ \param append boolean flag: if set and some required DB table already exists 
+  will attempt to append further rows into the existing table.
+  otherwise an error will be returned.
+ \param ordered boolean flag: if set the DXF files will always be stored 
+  into the DB in alphabetical order, otherwise in the order they become ready.
+
+ \return the total number of DXF files successfully imported.
+
+ \sa gaiaLoadFromDxfDir_r, gaiaLoadFromDxfFile
+
+ \note on multi-core platforms the DXF files are parsed in parallel by
+ a pool of worker threads, each one streaming its file batch by batch
+ exactly as gaiaLoadFromDxfFile does, while the calling thread stores
+ every parsed batch into the DB. The number of workers
+ can be set by the SPATIALITE_DXF_THREADS environment variable (0 means
+ parsing and storing each file in turn by gaiaLoadFromDxfFile).\n
+ not reentrant and thread unsafe.
+ */
+    GAIAGEO_DECLARE int gaiaLoadFromDxfDir (sqlite3 * db_handle,
+					    const char *dir_path, int srid,
+					    int force_dims, const char *prefix,
+					    const char *selected_layer,
+					    int special_rings, int mode,
+					    int append, int ordered);
+
+/**
+ Importing all DXF files found within a directory into a DB
+
+ \param p_cache a memory pointer returned by spatialite_alloc_connection()
+ \param db_handle handle to a valid DB connection
+ \param dir_path pathname of the directory containing the DXF files
+ \param srid the SRID value to be used for all Geometries
+ \param force_dims should be one of GAIA_DXF_AUTO_2D_3D, GAIA_DXF_FORCE_2D 
+ or GAIA_DXF_FORCE_3D
+ \param prefix an optional prefix to be used for DB target tables 
+ (could be NULL)
+ \param selected_layer if set, only the DXF Layer of corresponding name will 
+ be imported (could be NULL)
+ \param special_rings rings handling: should be one of GAIA_DXF_RING_NONE, 
+ GAIA_DXF_RING_LINKED of GAIA_DXF_RING_UNLINKED
+ \param mode should be one of GAIA_DXF_IMPORT_BY_LAYER or GAIA_DXF_IMPORT_MIXED
+ \param append boolean flag: if set and some required DB table already exists 
+  will attempt to append further rows into the existing table.
+  otherwise an error will be returned.
+ \param ordered boolean flag: if set the DXF files will always be stored 
+  into the DB in alphabetical order, otherwise in the order they become ready.
+
+ \return the total number of DXF files successfully imported.
+
+ \sa gaiaLoadFromDxfDir, gaiaLoadFromDxfFile_r
+
+ \note same as gaiaLoadFromDxfDir\n
+ reentrant and thread-safe.
+ */
+    GAIAGEO_DECLARE int gaiaLoadFromDxfDir_r (const void *p_cache,
+					      sqlite3 * db_handle,
+					      const char *dir_path, int srid,
+					      int force_dims,
+					      const char *prefix,
+					      const char *selected_layer,
+					      int special_rings, int mode,
+					      int append, int ordered);
+
 /**
  Initializing a DXF Writer Object
 
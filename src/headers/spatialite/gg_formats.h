@@ -336,6 +336,61 @@ extern "C"
     GAIAGEO_DECLARE void gaiaAppendToOutBuffer (gaiaOutBufferPtr buf,
 						const char *text);
 
+/**
+ Appends a text string of known length at the end of Text output buffer
+
+ \param buf pointer to gaiaOutBufferStruct structure.
+ \param text the text string to be appended.
+ \param len the length (in bytes) of the text string.
+
+ \sa gaiaAppendToOutBuffer, gaiaOutBufferReserve
+
+ \note same as gaiaAppendToOutBuffer(), but avoiding to compute
+ the string length again when the caller already knows it.
+ */
+    GAIAGEO_DECLARE void gaiaAppendToOutBufferLen (gaiaOutBufferPtr buf,
+						   const char *text, int len);
+
+/**
+ Preallocates room for further data into a Text output buffer
+
+ \param buf pointer to gaiaOutBufferStruct structure.
+ \param size the number of bytes expected to be appended.
+
+ \sa gaiaOutBufferInitialize, gaiaAppendToOutBuffer
+
+ \note the Text buffer geometrically grows when required, so calling
+ this function is never mandatory: anyway a reasonable estimate of the
+ final size will avoid many intermediate reallocations.
+ \n the Error flag will be set if the required memory is unavailable.
+ */
+    GAIAGEO_DECLARE void gaiaOutBufferReserve (gaiaOutBufferPtr buf,
+					       int size);
+
+/**
+ Appends a decimal number at the end of Text output buffer
+
+ \param buf pointer to gaiaOutBufferStruct structure.
+ \param value the number to be appended.
+ \param precision the number of decimal digits to be printed.
+
+ \sa gaiaAppendToOutBuffer
+
+ \note the number is printed exactly as SQLite's "%.*f" format would
+ print it (so 1.005 printed with two decimals becomes "1.01"), then any
+ unneeded trailing zero is suppressed and negative zero is printed as "0".
+ This is the same representation used by all Geometry text writers
+ (WKT, EWKT, SVG, KML, GML, GeoJSON).
+ \n No dynamic memory allocation is required when the value scaled by
+ 10^precision is less than 1e15 and is not too close to a rounding tie;
+ all other values are formatted by sqlite3_mprintf(). So with the fixed
+ EWKT precision of 15 decimals only values smaller than 1 (in absolute
+ value) take the fast path.
+ */
+    GAIAGEO_DECLARE void gaiaAppendDoubleToOutBuffer (gaiaOutBufferPtr buf,
+						      double value,
+						      int precision);
+
 /**
  Creates a BLOB-Geometry representing a Point
 
@@ -790,6 +845,60 @@ extern "C"
     GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseWkt (const unsigned char
 						  *in_buffer, short type);
 
+/**
+ Creates a Geometry object from WKT notation
+
+ \param p_cache a memory pointer returned by spatialite_alloc_connection()
+ \param in_buffer pointer to WKT buffer
+ \param type the expected Geometry Class Type
+ \n if actual type defined in WKT doesn't corresponds to this, an error will
+ be raised.
+
+ \return the pointer to the newly created Geometry object: NULL on failure
+
+ \sa gaiaParseWkt
+
+ \note you are responsible to destroy (before or after) any allocated Geometry,
+ unless you've passed ownership of the Geometry object to some further object:
+ in this case destroying the higher order object will implicitly destroy any
+ contained child object.\n
+ the Lemon parser and the Flex scanner will be reused by any further call
+ sharing the same connection.
+ */
+    GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseWkt_r (const void *p_cache,
+						    const unsigned char
+						    *in_buffer, short type);
+
+/**
+ Directly encodes a simple WKT Geometry as a SpatiaLite BLOB-Geometry
+
+ \param in_buffer pointer to WKT buffer
+ \param type the expected Geometry Class Type (any negative value
+ for no restriction)
+ \param srid the SRID to be set into the BLOB-Geometry
+ \param blob on completion will contain a pointer to BLOB-Geometry:
+ NULL on failure.
+ \param blob_size on completion this variable will contain the BLOB's size
+ (in bytes)
+
+ \return 0 if the WKT isn't supported by this fast path: any other value
+ on success.
+
+ \sa gaiaParseWkt, gaiaToSpatiaLiteBlobWkb
+
+ \note only POINT, LINESTRING, POLYGON, MULTIPOINT, MULTILINESTRING and
+ MULTIPOLYGON (XY or XYZ) are directly encoded, and the resulting BLOB is
+ exactly the same that gaiaParseWkt() followed by gaiaToSpatiaLiteBlobWkb()
+ would return; on 0 the caller is expected to fall back to gaiaParseWkt().\n
+ the returned BLOB corresponds to dynamically allocated memory:
+ so you are responsible to free() it [unless SQLite will take care
+ of memory cleanup via buffer binding].
+ */
+    GAIAGEO_DECLARE int gaiaSimpleWktToBlob (const unsigned char *in_buffer,
+					     short type, int srid,
+					     unsigned char **blob,
+					     int *blob_size);
+
 /**
  Encodes a Geometry object into WKT notation
 
@@ -855,6 +964,27 @@ extern "C"
     GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseEWKT (const unsigned char
 						   *in_buffer);
 
+/**
+ Creates a Geometry object from EWKT notation
+
+ \param p_cache a memory pointer returned by spatialite_alloc_connection()
+ \param in_buffer pointer to EWKT buffer
+
+ \return the pointer to the newly created Geometry object: NULL on failure
+
+ \sa gaiaParseEWKT
+
+ \note you are responsible to destroy (before or after) any allocated Geometry,
+ unless you've passed ownership of the Geometry object to some further object:
+ in this case destroying the higher order object will implicitly destroy any
+ contained child object.\n
+ the Lemon parser and the Flex scanner will be reused by any further call
+ sharing the same connection.
+ */
+    GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseEWKT_r (const void *p_cache,
+						     const unsigned char
+						     *in_buffer);
+
 /**
  Encodes a Geometry object into EWKT notation
 
@@ -968,6 +1098,27 @@ extern "C"
     GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseKml (const unsigned char
 						  *in_buffer);
 
+/**
+ Creates a Geometry object from KML notation
+
+ \param p_cache a memory pointer returned by spatialite_alloc_connection()
+ \param in_buffer pointer to KML buffer
+
+ \return the pointer to the newly created Geometry object: NULL on failure
+
+ \sa gaiaParseKml
+
+ \note you are responsible to destroy (before or after) any allocated Geometry,
+ unless you've passed ownership of the Geometry object to some further object:
+ in this case destroying the higher order object will implicitly destroy any
+ contained child object.\n
+ the Lemon parser and the Flex scanner will be reused by any further call
+ sharing the same connection.
+ */
+    GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseKml_r (const void *p_cache,
+						    const unsigned char
+						    *in_buffer);
+
 /**
  Encodes a Geometry object into KML notation
 
@@ -1074,6 +1225,56 @@ extern "C"
     GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseGeoJSON (const unsigned char
 						      *in_buffer);
 
+/**
+ Creates a Geometry object from GeoJSON notation
+
+ \param p_cache a memory pointer returned by spatialite_alloc_connection()
+ \param in_buffer pointer to GeoJSON buffer
+
+ \return the pointer to the newly created Geometry object: NULL on failure
+
+ \sa gaiaParseGeoJSON
+
+ \note you are responsible to destroy (before or after) any allocated Geometry,
+ unless you've passed ownership of the Geometry object to some further object:
+ in this case destroying the higher order object will implicitly destroy any
+ contained child object.\n
+ the Lemon parser and the Flex scanner will be reused by any further call
+ sharing the same connection.
+ */
+    GAIAGEO_DECLARE gaiaGeomCollPtr gaiaParseGeoJSON_r (const void *p_cache,
+							const unsigned char
+							*in_buffer);
+
+/**
+ Directly encodes a simple GeoJSON Geometry as a SpatiaLite BLOB-Geometry
+
+ \param in_buffer pointer to GeoJSON buffer
+ \param blob on completion will contain a pointer to BLOB-Geometry:
+ NULL on failure.
+ \param blob_size on completion this variable will contain the BLOB's size
+ (in bytes)
+
+ \return 0 if the GeoJSON isn't supported by this fast path: any other
+ value on success.
+
+ \sa gaiaParseGeoJSON, gaiaToSpatiaLiteBlobWkb
+
+ \note only plain {"type":...,"coordinates":...} objects (no "bbox", no
+ "crs") of class Point, LineString, Polygon, MultiPoint, MultiLineString
+ and MultiPolygon (XY or XYZ) are directly encoded, and the resulting BLOB
+ is exactly the same that gaiaParseGeoJSON() followed by
+ gaiaToSpatiaLiteBlobWkb() would return; on 0 the caller is expected to
+ fall back to gaiaParseGeoJSON().\n
+ the returned BLOB corresponds to dynamically allocated memory:
+ so you are responsible to free() it [unless SQLite will take care
+ of memory cleanup via buffer binding].
+ */
+    GAIAGEO_DECLARE int gaiaSimpleGeoJSONToBlob (const unsigned char
+						 *in_buffer,
+						 unsigned char **blob,
+						 int *blob_size);
+
 /**
  Encodes a Geometry object into GeoJSON notation
 
@@ -1095,6 +1296,35 @@ extern "C"
     GAIAGEO_DECLARE void gaiaOutGeoJSON (gaiaOutBufferPtr out_buf,
 					 gaiaGeomCollPtr geom, int precision,
 					 int options);
+
+/**
+ Encodes a SpatiaLite BLOB-Geometry into GeoJSON notation
+
+ \param out_buf pointer to dynamically growing Text buffer
+ \param blob pointer to the SpatiaLite BLOB-Geometry
+ \param size the BLOB's size (in bytes)
+ \param precision decimal digits to be used for coordinates
+ \param options GeoJSON specific options (same as gaiaOutGeoJSON)
+
+ \return 0 if the BLOB can't be directly encoded: in this case nothing
+ will be printed at all; any other value on success.
+
+ \sa gaiaOutGeoJSON
+
+ \note the BLOB is directly walked, so avoiding to build any intermediate
+ Geometry object; the output is exactly the same produced by gaiaOutGeoJSON.
+ Compressed geometries are not supported by this function: callers are
+ expected to fall back on gaiaFromSpatiaLiteBlobWkb() + gaiaOutGeoJSON()
+ when 0 is returned.
+ */
+    GAIAGEO_DECLARE int gaiaOutGeoJSONFromSpatiaLiteBlob (gaiaOutBufferPtr
+							  out_buf,
+							  const unsigned char
+							  *blob,
+							  unsigned int size,
+							  int precision,
+							  int options);
+
 /**
  Encodes a Geometry object into SVG notation
 
@@ -1455,6 +1685,66 @@ extern "C"
 					      int current_row, int srid,
 					      int text_dates);
 
+/**
+ Positions a Shapefile object on some feature, deferring any decoding
+
+ \param shp pointer to the Shapefile object.
+ \param current_row the row number identifying the feature to be read.
+
+ \return 0 on failure: any other value on success.
+
+ \sa gaiaReadShpEntity_ex, gaiaReadShpEntityGeometry, gaiaReadShpEntityValue
+
+ \note on completion the Shapefile's \e Dbf member will contain the feature
+ read, but both the \e Dbf->Geometry member and all data attributes values
+ will be NULL: they can then be decoded on demand by calling
+ gaiaReadShpEntityGeometry() and gaiaReadShpEntityValue().
+
+ \remark the Shapefile object should be opened in \e read mode.
+ */
+    GAIAGEO_DECLARE int gaiaReadShpEntityLazy (gaiaShapefilePtr shp,
+					       int current_row);
+
+/**
+ Decodes the Geometry of a feature from a Shapefile object
+
+ \param shp pointer to the Shapefile object.
+ \param current_row the row number identifying the feature to be read.
+ \param srid feature's SRID 
+
+ \return 0 on failure: any other value on success.
+
+ \sa gaiaReadShpEntityLazy, gaiaReadShpEntityValue
+
+ \note on completion the \e Dbf->Geometry member will contain the
+ corresponding Geometry; any data attribute value will be left untouched.
+
+ \remark the Shapefile object should be opened in \e read mode.
+ */
+    GAIAGEO_DECLARE int gaiaReadShpEntityGeometry (gaiaShapefilePtr shp,
+						   int current_row, int srid);
+
+/**
+ Decodes a single data attribute of the feature last read from a
+ Shapefile object
+
+ \param shp pointer to the Shapefile object.
+ \param field pointer to some item of the \e Dbf->First linked list.
+ \param text_dates is TRUE all DBF dates will be considered as TEXT
+
+ \return 0 on failure: any other value on success.
+
+ \sa gaiaReadShpEntityLazy, gaiaReadShpEntityGeometry
+
+ \note on completion the \e field->Value member will contain the
+ corresponding value.
+
+ \remark the Shapefile object should be opened in \e read mode.
+ */
+    GAIAGEO_DECLARE int gaiaReadShpEntityValue (gaiaShapefilePtr shp,
+						gaiaDbfFieldPtr field,
+						int text_dates);
+
 /**
  Prescans a Shapefile object gathering informations
 
@@ -1470,6 +1760,45 @@ extern "C"
  */
     GAIAGEO_DECLARE void gaiaShpAnalyze (gaiaShapefilePtr shp);
 
+/**
+ Counts the features contained within a Shapefile object
+
+ \param shp pointer to the Shapefile object.
+
+ \return the number of features declared by the SHX index, or -1 on failure.
+
+ \sa gaiaOpenShpRead, gaiaReadShpEntity, gaiaReadShpEntityMbr
+
+ \remark the Shapefile object should be opened in \e read mode.
+ */
+    GAIAGEO_DECLARE int gaiaShpRecordCount (gaiaShapefilePtr shp);
+
+/**
+ Reads the MBR of a feature from a Shapefile object
+
+ \param shp pointer to the Shapefile object.
+ \param current_row the row number identifying the feature to be read.
+ \param minx on completion will contain the MBR's min X coordinate.
+ \param miny on completion will contain the MBR's min Y coordinate.
+ \param maxx on completion will contain the MBR's max X coordinate.
+ \param maxy on completion will contain the MBR's max Y coordinate.
+
+ \return 0 on failure: any other value on success.
+
+ \sa gaiaOpenShpRead, gaiaReadShpEntity, gaiaShpRecordCount
+
+ \note the MBR is directly read from the SHP record header, neither the
+ Geometry nor the DBF attributes will be decoded.
+ \n a NULL feature will return an empty MBR (min values greater than
+ max values).
+
+ \remark the Shapefile object should be opened in \e read mode.
+ */
+    GAIAGEO_DECLARE int gaiaReadShpEntityMbr (gaiaShapefilePtr shp,
+					      int current_row, double *minx,
+					      double *miny, double *maxx,
+					      double *maxy);
+
 /**
  Writes a feature into a Shapefile object
                                             
@@ -1614,6 +1943,45 @@ extern "C"
     GAIAGEO_DECLARE int gaiaReadDbfEntity_ex (gaiaDbfPtr dbf, int current_row,
 					      int *deleted, int text_dates);
 
+/**
+ Positions a DBF File object on some record, deferring any decoding
+
+ \param dbf pointer to the DBF File object.
+ \param current_row the row number identifying the record to be read.
+ \param deleted on completion this variable will contain 0 if the record
+ just read is valid: any other value if the record just read is marked as
+ \e logically \e deleted.
+
+ \return 0 on failure: any other value on success.
+
+ \sa gaiaReadDbfEntity_ex, gaiaReadDbfEntityValue
+
+ \note on completion all values in the DBF File \e First linked list will
+ be NULL: they can then be decoded on demand by calling
+ gaiaReadDbfEntityValue().
+
+ \remark the DBF File object should be opened in \e read mode.
+ */
+    GAIAGEO_DECLARE int gaiaReadDbfEntityLazy (gaiaDbfPtr dbf, int current_row,
+					       int *deleted);
+
+/**
+ Decodes a single value of the record last read from a DBF File object
+
+ \param dbf pointer to the DBF File object.
+ \param field pointer to some item of the DBF File \e First linked list.
+ \param text_dates is TRUE all DBF dates will be considered as TEXT
+
+ \return 0 on failure: any other value on success.
+
+ \sa gaiaReadDbfEntityLazy
+
+ \remark the DBF File object should be opened in \e read mode.
+ */
+    GAIAGEO_DECLARE int gaiaReadDbfEntityValue (gaiaDbfPtr dbf,
+						gaiaDbfFieldPtr field,
+						int text_dates);
+
 /**
  Writes a record into a DBF File object
 
@@ -1704,6 +2072,11 @@ extern "C"
  \li file consistency: checking expected formatting rules.
  \li identifying the number / type / name of fields [aka columns].
  \li identifying the actual number of lines within the file.
+ \n On platforms supporting both memory mapped files and POSIX threads
+  large files are split into chunks parsed at the same time by many
+  threads (up to the available CPU cores); the SPATIALITE_TXT_THREADS
+  environment variable can explicitly set the number of threads (1 will
+  disable at all any parallel parsing).
  */
     GAIAGEO_DECLARE int gaiaTextReaderParse (gaiaTextReaderPtr reader);
 
@@ -446,6 +446,10 @@ extern "C"
 	int EffectiveType;	/* the effective Geometry-type, as determined by gaiaShpAnalyze() */
 /** SHP actual dims: one of GAIA_XY, GAIA_XY_Z, GAIA_XY_M, GAIA_XY_ZM */
 	int EffectiveDims;	/* the effective Dimensions [XY, XYZ, XYM, XYZM], as determined by gaiaShpAnalyze() */
+/** read mode: TRUE if the last Z feature read actually carried M values */
+	int LastHasM;		/* the last feature read had M values */
+/** write mode: opaque reference to the output buffers (may be NULL) */
+	void *WriteBuffer;	/* write mode: stdio buffers for SHX, SHP and DBF */
     } gaiaShapefile;
 /**
  Typedef for SHP file handler structure
@@ -144,6 +144,15 @@ extern "C"
  \note the progress_callback function must have this signature: 
  \b void \b myfunct(\b int \b count, \b void \b *ptr);
  \n and will cyclically report how many features have been processed since the initial call start.
+
+ \note when paging an HTTP source the following pages are fetched in
+ background while the current one is being loaded; pages are always
+ loaded in their natural order. The SPATIALITE_WFS_THREADS environment
+ variable sets how many pages may be fetched ahead (default 4; 0 means
+ fetching each page only when it is about to be loaded). No page is
+ fetched beyond the last one, as announced either by the numberMatched
+ count of the first page or by any page returning less than page_size
+ features.
  */
     SPATIALITE_DECLARE int load_from_wfs_paged (sqlite3 * sqlite,
 						const char *path_or_url,
@@ -144,6 +144,11 @@ extern "C"
 	int pool_index;
 	void (*geos_warning) (const char *fmt, ...);
 	void (*geos_error) (const char *fmt, ...);
+	void *wkt_parser;
+	void *ewkt_parser;
+	void *geojson_parser;
+	void *kml_parser;
+	void *gml_parser;
 	unsigned char magic2;
     };
 
@@ -692,6 +697,56 @@ extern "C"
 						  int blob_sz, double *E,
 						  double *N, double *Z);
 
+    SPATIALITE_PRIVATE void gaiaWktParserDestroy (void *parser);
+
+    SPATIALITE_PRIVATE void gaiaEwktParserDestroy (void *parser);
+
+    SPATIALITE_PRIVATE void gaiaGeoJsonParserDestroy (void *parser);
+
+    SPATIALITE_PRIVATE void gaiaKmlParserDestroy (void *parser);
+
+    SPATIALITE_PRIVATE void gaiaGmlParserDestroy (void *parser);
+
+    SPATIALITE_PRIVATE void *gaiaGmlNodesCreate (void);
+
+    SPATIALITE_PRIVATE void gaiaGmlNodesReset (void *builder);
+
+    SPATIALITE_PRIVATE void gaiaGmlNodesDestroy (void *builder);
+
+    SPATIALITE_PRIVATE void gaiaGmlNodesOpenTag (void *builder,
+						 const char *prefix,
+						 const char *name,
+						 int self_closed);
+
+    SPATIALITE_PRIVATE void gaiaGmlNodesAttribute (void *builder,
+						   const char *prefix,
+						   const char *name,
+						   const char *value);
+
+    SPATIALITE_PRIVATE void gaiaGmlNodesCoordinates (void *builder,
+						     const char *text);
+
+    SPATIALITE_PRIVATE void gaiaGmlNodesCloseTag (void *builder,
+						  const char *prefix,
+						  const char *name);
+
+    SPATIALITE_PRIVATE void gaiaGmlNodesSetError (void *builder);
+
+    SPATIALITE_PRIVATE void *gaiaGmlNodesBuild (const void *p_cache,
+						void *builder,
+						const void *sqlite_handle);
+
+    SPATIALITE_PRIVATE int splite_cpu_cores (void);
+
+    SPATIALITE_PRIVATE int splite_env_threads (const char *name,
+					       int automatic,
+					       int max_threads);
+
+    SPATIALITE_PRIVATE int splite_env_switch (const char *name,
+					      int automatic);
+
+    SPATIALITE_PRIVATE int splite_relaxed_security (void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -84,6 +84,13 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #define FRMT64 "%lld"
 #endif
 
+#ifndef _WIN32
+/* shapefiles are decoded by a pool of worker threads */
+#define SHP_PARALLEL_LOAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 struct auxdbf_fld
 {
 /* auxiliary DBF field struct */
@@ -395,6 +402,651 @@ load_shapefile_ex (sqlite3 * sqlite, char *shp_path, char *table,
 			       spatial_index, 0, rows, err_msg);
 }
 
+static void
+shp_load_bind_row (sqlite3_stmt * stmt, gaiaDbfListPtr dbf,
+		   const char *pk_name, int pk_type, int current_row,
+		   unsigned char *blob, int blob_size)
+{
+/* binding query params; the Geometry BLOB (if any) is released by SQLite */
+    gaiaDbfFieldPtr dbf_field;
+    int pk_set = 0;
+    int cnt = 0;
+    sqlite3_reset (stmt);
+    sqlite3_clear_bindings (stmt);
+    dbf_field = dbf->First;
+    while (dbf_field)
+      {
+	  /* Primary Key value */
+	  if (strcasecmp (pk_name, dbf_field->Name) == 0)
+	    {
+		if (pk_type == SQLITE_TEXT)
+		    sqlite3_bind_text (stmt, 1,
+				       dbf_field->Value->TxtValue,
+				       strlen (dbf_field->Value->TxtValue),
+				       SQLITE_STATIC);
+		else if (pk_type == SQLITE_FLOAT)
+		    sqlite3_bind_double (stmt, 1, dbf_field->Value->DblValue);
+		else
+		    sqlite3_bind_int64 (stmt, 1, dbf_field->Value->IntValue);
+		pk_set = 1;
+	    }
+	  dbf_field = dbf_field->Next;
+      }
+    if (!pk_set)
+	sqlite3_bind_int (stmt, 1, current_row);
+    dbf_field = dbf->First;
+    while (dbf_field)
+      {
+	  /* column values */
+	  if (strcasecmp (pk_name, dbf_field->Name) == 0)
+	    {
+		/* skipping the Primary Key field */
+		dbf_field = dbf_field->Next;
+		continue;
+	    }
+	  if (!(dbf_field->Value))
+	      sqlite3_bind_null (stmt, cnt + 2);
+	  else
+	    {
+		switch (dbf_field->Value->Type)
+		  {
+		  case GAIA_INT_VALUE:
+		      sqlite3_bind_int64 (stmt, cnt + 2,
+					  dbf_field->Value->IntValue);
+		      break;
+		  case GAIA_DOUBLE_VALUE:
+		      sqlite3_bind_double (stmt, cnt + 2,
+					   dbf_field->Value->DblValue);
+		      break;
+		  case GAIA_TEXT_VALUE:
+		      sqlite3_bind_text (stmt, cnt + 2,
+					 dbf_field->Value->TxtValue,
+					 strlen (dbf_field->Value->TxtValue),
+					 SQLITE_STATIC);
+		      break;
+		  default:
+		      sqlite3_bind_null (stmt, cnt + 2);
+		      break;
+		  }
+	    }
+	  cnt++;
+	  dbf_field = dbf_field->Next;
+      }
+    if (blob)
+	sqlite3_bind_blob (stmt, cnt + 2, blob, blob_size, free);
+    else
+      {
+	  /* handling a NULL-Geometry */
+	  sqlite3_bind_null (stmt, cnt + 2);
+      }
+}
+
+struct shp_load_lazy
+{
+/* the Geometry type being lazily promoted while loading a Shapefile */
+    int active;
+    int multi_type;		/* required by multi-part rows */
+    int check_m;		/* Z rows could still require XYZM */
+    int metadata_version;	/* 0 means no Spatial Metadata at all */
+    const char *table;
+    const char *column;
+    int compressed;
+};
+
+static int
+shp_load_is_multi (gaiaGeomCollPtr geom)
+{
+/* checking if a Geometry read from the Shapefile has many parts */
+    int count = 0;
+    gaiaLinestringPtr ln;
+    gaiaPolygonPtr pg;
+    if (!geom)
+	return 0;
+    ln = geom->FirstLinestring;
+    while (ln)
+      {
+	  count++;
+	  ln = ln->Next;
+      }
+    pg = geom->FirstPolygon;
+    while (pg)
+      {
+	  count++;
+	  pg = pg->Next;
+      }
+    return (count > 1) ? 1 : 0;
+}
+
+static int
+shp_load_promote (sqlite3 * sqlite, struct shp_load_lazy *lazy,
+		  gaiaShapefilePtr shp, int multi, int has_m, int loaded,
+		  char *err_msg)
+{
+/*
+/ promoting the Geometry type as soon as some row requires it:
+/ the Spatial Metadata and triggers are updated, and all rows
+/ already inserted are cast to the wider type
+/
+/ returns 0 on failure; shp->EffectiveType and shp->EffectiveDims
+/ always reflect the current type of the Geometry column
+*/
+    int type = shp->EffectiveType;
+    int dims = shp->EffectiveDims;
+    int code;
+    int n_dims;
+    const char *txt_type;
+    const char *txt_dims;
+    char *expr;
+    char *prev;
+    char *xtable;
+    char *xcolumn;
+    char *sql;
+    char *errMsg = NULL;
+    int ret;
+    if (multi)
+	type = lazy->multi_type;
+    if (has_m && lazy->check_m)
+	dims = GAIA_XY_Z_M;
+    if (type == shp->EffectiveType && dims == shp->EffectiveDims)
+	return 1;
+    if (lazy->metadata_version)
+      {
+	  /* updating the Spatial Metadata */
+	  switch (type)
+	    {
+	    case GAIA_LINESTRING:
+		code = 2;
+		txt_type = "LINESTRING";
+		break;
+	    case GAIA_MULTILINESTRING:
+		code = 5;
+		txt_type = "MULTILINESTRING";
+		break;
+	    case GAIA_POLYGON:
+		code = 3;
+		txt_type = "POLYGON";
+		break;
+	    default:
+		code = 6;
+		txt_type = "MULTIPOLYGON";
+		break;
+	    };
+	  switch (dims)
+	    {
+	    case GAIA_XY_Z:
+		code += 1000;
+		n_dims = 3;
+		txt_dims = "XYZ";
+		break;
+	    case GAIA_XY_M:
+		code += 2000;
+		n_dims = 3;
+		txt_dims = "XYM";
+		break;
+	    case GAIA_XY_Z_M:
+		code += 3000;
+		n_dims = 4;
+		txt_dims = "XYZM";
+		break;
+	    default:
+		n_dims = 2;
+		txt_dims = "XY";
+		break;
+	    };
+	  if (lazy->metadata_version == 3)
+	      sql = sqlite3_mprintf ("UPDATE geometry_columns SET "
+				     "geometry_type = %d, coord_dimension = %d "
+				     "WHERE Lower(f_table_name) = Lower(%Q) AND "
+				     "Lower(f_geometry_column) = Lower(%Q)",
+				     code, n_dims, lazy->table, lazy->column);
+	  else
+	      sql = sqlite3_mprintf ("UPDATE geometry_columns SET "
+				     "type = %Q, coord_dimension = %Q "
+				     "WHERE Lower(f_table_name) = Lower(%Q) AND "
+				     "Lower(f_geometry_column) = Lower(%Q)",
+				     txt_type, txt_dims, lazy->table,
+				     lazy->column);
+	  ret = sqlite3_exec (sqlite, sql, NULL, 0, &errMsg);
+	  sqlite3_free (sql);
+	  if (ret != SQLITE_OK)
+	      goto error;
+	  updateGeometryTriggers (sqlite, lazy->table, lazy->column);
+      }
+    if (loaded > 0)
+      {
+	  /* casting all rows already inserted */
+	  xtable = gaiaDoubleQuotedSql (lazy->table);
+	  xcolumn = gaiaDoubleQuotedSql (lazy->column);
+	  expr = sqlite3_mprintf ("\"%s\"", xcolumn);
+	  if (type != shp->EffectiveType)
+	    {
+		prev = expr;
+		expr = sqlite3_mprintf ("CastToMulti(%s)", prev);
+		sqlite3_free (prev);
+	    }
+	  if (dims != shp->EffectiveDims)
+	    {
+		prev = expr;
+		expr = sqlite3_mprintf ("CastToXYZM(%s)", prev);
+		sqlite3_free (prev);
+	    }
+	  if (lazy->compressed)
+	    {
+		prev = expr;
+		expr = sqlite3_mprintf ("CompressGeometry(%s)", prev);
+		sqlite3_free (prev);
+	    }
+	  sql = sqlite3_mprintf ("UPDATE \"%s\" SET \"%s\" = %s", xtable,
+				 xcolumn, expr);
+	  free (xtable);
+	  free (xcolumn);
+	  sqlite3_free (expr);
+	  ret = sqlite3_exec (sqlite, sql, NULL, 0, &errMsg);
+	  sqlite3_free (sql);
+	  if (ret != SQLITE_OK)
+	      goto error;
+      }
+    shp->EffectiveType = type;
+    shp->EffectiveDims = dims;
+    return 1;
+
+  error:
+    if (!err_msg)
+	spatialite_e ("load shapefile error: <%s>\n", errMsg);
+    else
+	sprintf (err_msg, "load shapefile error: <%s>\n", errMsg);
+    sqlite3_free (errMsg);
+    return 0;
+}
+
+#ifdef SHP_PARALLEL_LOAD
+
+#define SHP_LOAD_BATCH		256	/* rows decoded by a worker in one go */
+#define SHP_LOAD_MIN_ROWS	4096	/* smaller shapefiles are loaded serially */
+#define SHP_LOAD_MAX_THREADS	16
+
+struct shp_load_row
+{
+/* a decoded row, ready to be bound */
+    gaiaDbfListPtr dbf;
+    unsigned char *blob;
+    int blob_size;
+    int type;			/* Geometry type used for decoding */
+    int dims;
+    int multi;			/* a multi-part Geometry */
+    int has_m;			/* a Z Geometry with M values */
+};
+
+struct shp_load_batch
+{
+/* a batch of consecutive rows decoded by the same worker */
+    int ready;
+    int count;
+    int eof;
+    char *error;
+    struct shp_load_row rows[SHP_LOAD_BATCH];
+};
+
+struct shp_load_pipeline
+{
+/* state shared by the writer and the decoding workers */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct shp_load_batch *slots;
+    int n_slots;
+    int n_batches;
+    int next_batch;		/* the next batch to be claimed by a worker */
+    int consumed;		/* batches already inserted by the writer */
+    int abort;
+    int srid;
+    int text_dates;
+    int compressed;
+    int type;			/* the current Geometry type */
+    int dims;
+};
+
+struct shp_load_worker
+{
+/* a decoding worker owning a private Shapefile handle */
+    struct shp_load_pipeline *pipeline;
+    gaiaShapefilePtr shp;
+    pthread_t thread;
+};
+
+static int
+shp_load_threads (int rows)
+{
+/* how many decoding workers should be started */
+    int automatic = 0;
+    if (rows >= SHP_LOAD_MIN_ROWS)
+      {
+	  /* the calling thread is busy inserting rows */
+	  automatic = splite_cpu_cores () - 1;
+      }
+    return splite_env_threads ("SPATIALITE_SHP_THREADS", automatic,
+			       SHP_LOAD_MAX_THREADS);
+}
+
+static void
+shp_load_reset_batch (struct shp_load_batch *batch)
+{
+/* releasing all rows still held by a batch */
+    int i;
+    struct shp_load_row *row;
+    for (i = 0; i < batch->count; i++)
+      {
+	  row = batch->rows + i;
+	  if (row->dbf)
+	      gaiaFreeDbfList (row->dbf);
+	  if (row->blob)
+	      free (row->blob);
+	  row->dbf = NULL;
+	  row->blob = NULL;
+      }
+    if (batch->error)
+	free (batch->error);
+    batch->error = NULL;
+    batch->count = 0;
+    batch->eof = 0;
+    batch->ready = 0;
+}
+
+static void *
+shp_load_worker_main (void *arg)
+{
+/* decoding batches of rows until the whole Shapefile has been claimed */
+    struct shp_load_worker *worker = (struct shp_load_worker *) arg;
+    struct shp_load_pipeline *pipe = worker->pipeline;
+    gaiaShapefilePtr shp = worker->shp;
+    struct shp_load_batch *batch;
+    struct shp_load_row *row;
+    gaiaGeomCollPtr geom;
+    int batch_no;
+    int current_row;
+    int i;
+    while (1)
+      {
+	  pthread_mutex_lock (&(pipe->mutex));
+	  while (!(pipe->abort) && pipe->next_batch < pipe->n_batches
+		 && pipe->next_batch >= pipe->consumed + pipe->n_slots)
+	      pthread_cond_wait (&(pipe->cond), &(pipe->mutex));
+	  if (pipe->abort || pipe->next_batch >= pipe->n_batches)
+	    {
+		pthread_mutex_unlock (&(pipe->mutex));
+		break;
+	    }
+	  batch_no = pipe->next_batch++;
+	  shp->EffectiveType = pipe->type;
+	  shp->EffectiveDims = pipe->dims;
+	  pthread_mutex_unlock (&(pipe->mutex));
+
+	  batch = pipe->slots + (batch_no % pipe->n_slots);
+	  current_row = batch_no * SHP_LOAD_BATCH;
+	  for (i = 0; i < SHP_LOAD_BATCH; i++, current_row++)
+	    {
+		if (!gaiaReadShpEntity_ex
+		    (shp, current_row, pipe->srid, pipe->text_dates))
+		  {
+		      if (shp->LastError)
+			{
+			    batch->error = malloc (strlen (shp->LastError) + 1);
+			    strcpy (batch->error, shp->LastError);
+			}
+		      else
+			  batch->eof = 1;	/* normal SHP EOF */
+		      break;
+		  }
+		/* the Geometry is directly encoded, not cloned */
+		row = batch->rows + i;
+		geom = shp->Dbf->Geometry;
+		shp->Dbf->Geometry = NULL;
+		row->dbf = gaiaCloneDbfEntity (shp->Dbf);
+		row->blob = NULL;
+		row->blob_size = 0;
+		row->type = shp->EffectiveType;
+		row->dims = shp->EffectiveDims;
+		row->multi = shp_load_is_multi (geom);
+		row->has_m = shp->LastHasM;
+		if (geom)
+		  {
+		      if (pipe->compressed)
+			  gaiaToCompressedBlobWkb (geom, &(row->blob),
+						   &(row->blob_size));
+		      else
+			  gaiaToSpatiaLiteBlobWkb (geom, &(row->blob),
+						   &(row->blob_size));
+		      gaiaFreeGeomColl (geom);
+		  }
+	    }
+	  batch->count = i;
+
+	  pthread_mutex_lock (&(pipe->mutex));
+	  batch->ready = 1;
+	  pthread_cond_broadcast (&(pipe->cond));
+	  pthread_mutex_unlock (&(pipe->mutex));
+      }
+    return NULL;
+}
+
+static int
+shp_load_redecode (gaiaShapefilePtr shp, struct shp_load_row *row,
+		   int current_row, int srid, int compressed, char *err_msg)
+{
+/* decoding again the Geometry of some row as the current wider type */
+    if (!gaiaReadShpEntityGeometry (shp, current_row, srid))
+      {
+	  if (!err_msg)
+	      spatialite_e ("%s\n", shp->LastError);
+	  else
+	      sprintf (err_msg, "%s\n", shp->LastError);
+	  return 0;
+      }
+    if (row->blob)
+	free (row->blob);
+    row->blob = NULL;
+    row->blob_size = 0;
+    if (shp->Dbf->Geometry)
+      {
+	  if (compressed)
+	      gaiaToCompressedBlobWkb (shp->Dbf->Geometry, &(row->blob),
+				       &(row->blob_size));
+	  else
+	      gaiaToSpatiaLiteBlobWkb (shp->Dbf->Geometry, &(row->blob),
+				       &(row->blob_size));
+      }
+    row->type = shp->EffectiveType;
+    row->dims = shp->EffectiveDims;
+    return 1;
+}
+
+static int
+shp_load_parallel (sqlite3 * sqlite, sqlite3_stmt * stmt,
+		   gaiaShapefilePtr shp, const char *shp_path,
+		   const char *charset, int srid, int text_dates,
+		   int compressed, const char *pk_name, int pk_type,
+		   struct shp_load_lazy *lazy, int *current_row,
+		   char *err_msg)
+{
+/*
+/ inserting all rows from the Shapefile: worker threads decode batches
+/ of rows (DBF values, charset conversion, rings arrangement, Geometry
+/ BLOB encoding) while the calling thread simply binds and inserts them
+/ in their natural order
+/
+/ returns 1 on success and 0 on failure; -1 means that no worker could
+/ be started, and the caller is expected to load the Shapefile serially
+*/
+    struct shp_load_pipeline pipe;
+    struct shp_load_worker *workers;
+    struct shp_load_worker *worker;
+    struct shp_load_batch *batch;
+    struct shp_load_row *row;
+    int rows;
+    int threads;
+    int started = 0;
+    int batch_no;
+    int stop = 0;
+    int ret;
+    int i;
+    int result = 1;
+
+    rows = gaiaShpRecordCount (shp);
+    threads = shp_load_threads (rows);
+    if (threads < 1 || rows <= 0)
+	return -1;
+    pipe.n_batches = (rows + SHP_LOAD_BATCH - 1) / SHP_LOAD_BATCH;
+    if (threads > pipe.n_batches)
+	threads = pipe.n_batches;
+    pipe.n_slots = threads * 4;
+    pipe.slots = malloc (sizeof (struct shp_load_batch) * pipe.n_slots);
+    if (pipe.slots == NULL)
+	return -1;
+    for (i = 0; i < pipe.n_slots; i++)
+      {
+	  batch = pipe.slots + i;
+	  batch->count = 0;
+	  batch->error = NULL;
+	  shp_load_reset_batch (batch);
+      }
+    pipe.next_batch = 0;
+    pipe.consumed = 0;
+    pipe.abort = 0;
+    pipe.srid = srid;
+    pipe.text_dates = text_dates;
+    pipe.compressed = compressed;
+    pipe.type = shp->EffectiveType;
+    pipe.dims = shp->EffectiveDims;
+    pthread_mutex_init (&(pipe.mutex), NULL);
+    pthread_cond_init (&(pipe.cond), NULL);
+
+    workers = malloc (sizeof (struct shp_load_worker) * threads);
+    if (workers == NULL)
+      {
+	  result = -1;
+	  goto done;
+      }
+    for (i = 0; i < threads; i++)
+      {
+	  /* each worker reads the Shapefile by itself */
+	  worker = workers + started;
+	  worker->pipeline = &pipe;
+	  worker->shp = gaiaAllocShapefile ();
+	  gaiaOpenShpRead (worker->shp, shp_path, charset, "UTF-8");
+	  if (!(worker->shp->Valid) || worker->shp->Shape != shp->Shape)
+	    {
+		gaiaFreeShapefile (worker->shp);
+		break;
+	    }
+	  if (pthread_create
+	      (&(worker->thread), NULL, shp_load_worker_main, worker) != 0)
+	    {
+		gaiaFreeShapefile (worker->shp);
+		break;
+	    }
+	  started++;
+      }
+    if (started == 0)
+      {
+	  result = -1;
+	  goto done;
+      }
+
+    for (batch_no = 0; batch_no < pipe.n_batches && !stop; batch_no++)
+      {
+	  batch = pipe.slots + (batch_no % pipe.n_slots);
+	  pthread_mutex_lock (&(pipe.mutex));
+	  while (!(batch->ready))
+	      pthread_cond_wait (&(pipe.cond), &(pipe.mutex));
+	  pthread_mutex_unlock (&(pipe.mutex));
+	  for (i = 0; i < batch->count; i++)
+	    {
+		/* inserting rows from shapefile */
+		row = batch->rows + i;
+		if (lazy->active)
+		  {
+		      if (!shp_load_promote
+			  (sqlite, lazy, shp, row->multi, row->has_m,
+			   *current_row, err_msg))
+			{
+			    result = 0;
+			    break;
+			}
+		      if (row->type != shp->EffectiveType
+			  || row->dims != shp->EffectiveDims)
+			{
+			    /* decoded before the latest promotion */
+			    pthread_mutex_lock (&(pipe.mutex));
+			    pipe.type = shp->EffectiveType;
+			    pipe.dims = shp->EffectiveDims;
+			    pthread_mutex_unlock (&(pipe.mutex));
+			    if (!shp_load_redecode
+				(shp, row, *current_row, srid, compressed,
+				 err_msg))
+			      {
+				  result = 0;
+				  break;
+			      }
+			}
+		  }
+		*current_row += 1;
+		shp_load_bind_row (stmt, row->dbf, pk_name, pk_type,
+				   *current_row, row->blob, row->blob_size);
+		row->blob = NULL;
+		ret = sqlite3_step (stmt);
+		if (ret == SQLITE_DONE || ret == SQLITE_ROW)
+		    ;
+		else
+		  {
+		      if (!err_msg)
+			  spatialite_e ("load shapefile error: <%s>\n",
+					sqlite3_errmsg (sqlite));
+		      else
+			  sprintf (err_msg, "load shapefile error: <%s>\n",
+				   sqlite3_errmsg (sqlite));
+		      result = 0;
+		      break;
+		  }
+	    }
+	  if (result && batch->error)
+	    {
+		if (!err_msg)
+		    spatialite_e ("%s\n", batch->error);
+		else
+		    sprintf (err_msg, "%s\n", batch->error);
+		result = 0;
+	    }
+	  if (!result || batch->eof)
+	      stop = 1;
+	  /* recycling the batch slot */
+	  pthread_mutex_lock (&(pipe.mutex));
+	  shp_load_reset_batch (batch);
+	  pipe.consumed = batch_no + 1;
+	  pthread_cond_broadcast (&(pipe.cond));
+	  pthread_mutex_unlock (&(pipe.mutex));
+      }
+
+  done:
+    pthread_mutex_lock (&(pipe.mutex));
+    pipe.abort = 1;
+    pthread_cond_broadcast (&(pipe.cond));
+    pthread_mutex_unlock (&(pipe.mutex));
+    for (i = 0; i < started; i++)
+      {
+	  worker = workers + i;
+	  pthread_join (worker->thread, NULL);
+	  gaiaFreeShapefile (worker->shp);
+      }
+    for (i = 0; i < pipe.n_slots; i++)
+	shp_load_reset_batch (pipe.slots + i);
+    pthread_cond_destroy (&(pipe.cond));
+    pthread_mutex_destroy (&(pipe.mutex));
+    free (workers);
+    free (pipe.slots);
+    return result;
+}
+
+#endif /* end SHP_PARALLEL_LOAD */
+
 SPATIALITE_DECLARE int
 load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 		    char *charset, int srid, char *g_column, char *gtype,
@@ -432,12 +1084,22 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
     int pk_autoincr = 1;
     char *xname;
     int pk_type = SQLITE_INTEGER;
-    int pk_set;
+    int lazy_types = 1;
+    int type;
+    int dims;
+    struct shp_load_lazy lazy;
     gaiaOutBuffer sql_statement;
     if (!geo_column)
 	geo_column = "Geometry";
     if (rows)
 	*rows = -1;
+    lazy.active = 0;
+    lazy.multi_type = 0;
+    lazy.check_m = 0;
+    lazy.metadata_version = 0;
+    lazy.table = table;
+    lazy.column = geo_column;
+    lazy.compressed = compressed;
     if (!xgtype)
 	;
     else
@@ -820,6 +1482,9 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
     if (metadata)
       {
 	  /* creating Geometry column */
+	  lazy.metadata_version = checkSpatialMetaData (sqlite);
+	  if (lazy.metadata_version != 1 && lazy.metadata_version != 3)
+	      lazy_types = 0;	/* unsupported: analyzing first */
 	  switch (shp->Shape)
 	    {
 	    case GAIA_SHP_POINT:
@@ -838,7 +1503,15 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 		if (xgtype == NULL)
 		  {
 		      /* auto-decting if MULTILINESTRING is required */
-		      gaiaShpAnalyze (shp);
+		      if (lazy_types)
+			{
+			    /* optimistically starting as LINESTRING */
+			    lazy.active = 1;
+			    lazy.multi_type = GAIA_MULTILINESTRING;
+			    shp->EffectiveType = GAIA_LINESTRING;
+			}
+		      else
+			  gaiaShpAnalyze (shp);
 		      if (shp->EffectiveType == GAIA_LINESTRING)
 			  geom_type = "LINESTRING";
 		      else
@@ -903,7 +1576,15 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 		if (xgtype == NULL)
 		  {
 		      /* auto-decting if MULTIPOLYGON is required */
-		      gaiaShpAnalyze (shp);
+		      if (lazy_types)
+			{
+			    /* optimistically starting as POLYGON */
+			    lazy.active = 1;
+			    lazy.multi_type = GAIA_MULTIPOLYGON;
+			    shp->EffectiveType = GAIA_POLYGON;
+			}
+		      else
+			  gaiaShpAnalyze (shp);
 		      if (shp->EffectiveType == GAIA_POLYGON)
 			  geom_type = "POLYGON";
 		      else
@@ -963,8 +1644,17 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 		  }
 		break;
 	    };
+	  if (lazy.active && shp->EffectiveDims == GAIA_XY_Z_M)
+	    {
+		/* optimistically starting as XYZ */
+		lazy.check_m = 1;
+		shp->EffectiveDims = GAIA_XY_Z;
+	    }
 	  if (coerce2d)
-	      shp->EffectiveDims = GAIA_XY;
+	    {
+		lazy.check_m = 0;
+		shp->EffectiveDims = GAIA_XY;
+	    }
 	  switch (shp->EffectiveDims)
 	    {
 	    case GAIA_XY_Z:
@@ -1029,9 +1719,27 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 		/* 
 		   / fixing anyway the Geometry type for 
 		   / LINESTRING/MULTILINESTRING or 
-		   / POLYGON/MULTIPOLYGON
+		   / POLYGON/MULTIPOLYGON, lazily promoted
+		   / while loading the rows
 		 */
-		gaiaShpAnalyze (shp);
+		lazy.active = 1;
+		if (shp->Shape == GAIA_SHP_POLYLINE
+		    || shp->Shape == GAIA_SHP_POLYLINEM
+		    || shp->Shape == GAIA_SHP_POLYLINEZ)
+		  {
+		      lazy.multi_type = GAIA_MULTILINESTRING;
+		      shp->EffectiveType = GAIA_LINESTRING;
+		  }
+		else
+		  {
+		      lazy.multi_type = GAIA_MULTIPOLYGON;
+		      shp->EffectiveType = GAIA_POLYGON;
+		  }
+		if (shp->EffectiveDims == GAIA_XY_Z_M)
+		  {
+		      lazy.check_m = 1;
+		      shp->EffectiveDims = GAIA_XY_Z;
+		  }
 	    }
       }
     /* preparing the INSERT INTO parametrerized statement */
@@ -1096,6 +1804,19 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 	  goto clean_up;
       }
     current_row = 0;
+#ifdef SHP_PARALLEL_LOAD
+    ret =
+	shp_load_parallel (sqlite, stmt, shp, shp_path, charset, srid,
+			   text_dates, compressed, pk_name, pk_type, &lazy,
+			   &current_row, err_msg);
+    if (ret >= 0)
+      {
+	  if (!ret)
+	      sqlError = 1;
+	  sqlite3_finalize (stmt);
+	  goto clean_up;
+      }
+#endif
     while (1)
       {
 	  /* inserting rows from shapefile */
@@ -1113,75 +1834,37 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 		goto clean_up;
 	    }
 	  current_row++;
-	  /* binding query params */
-	  sqlite3_reset (stmt);
-	  sqlite3_clear_bindings (stmt);
-	  pk_set = 0;
-	  cnt = 0;
-	  dbf_field = shp->Dbf->First;
-	  while (dbf_field)
-	    {
-		/* Primary Key value */
-		if (strcasecmp (pk_name, dbf_field->Name) == 0)
+	  if (lazy.active)
+	    {
+		type = shp->EffectiveType;
+		dims = shp->EffectiveDims;
+		if (!shp_load_promote
+		    (sqlite, &lazy, shp,
+		     shp_load_is_multi (shp->Dbf->Geometry), shp->LastHasM,
+		     current_row - 1, err_msg))
 		  {
-		      if (pk_type == SQLITE_TEXT)
-			  sqlite3_bind_text (stmt, 1,
-					     dbf_field->Value->TxtValue,
-					     strlen (dbf_field->
-						     Value->TxtValue),
-					     SQLITE_STATIC);
-		      else if (pk_type == SQLITE_FLOAT)
-			  sqlite3_bind_double (stmt, 1,
-					       dbf_field->Value->DblValue);
-		      else
-			  sqlite3_bind_int64 (stmt, 1,
-					      dbf_field->Value->IntValue);
-		      pk_set = 1;
-		  }
-		dbf_field = dbf_field->Next;
-	    }
-	  if (!pk_set)
-	      sqlite3_bind_int (stmt, 1, current_row);
-	  cnt = 0;
-	  dbf_field = shp->Dbf->First;
-	  while (dbf_field)
-	    {
-		/* column values */
-		if (strcasecmp (pk_name, dbf_field->Name) == 0)
-		  {
-		      /* skipping the Primary Key field */
-		      dbf_field = dbf_field->Next;
-		      continue;
+		      sqlError = 1;
+		      sqlite3_finalize (stmt);
+		      goto clean_up;
 		  }
-		if (!(dbf_field->Value))
-		    sqlite3_bind_null (stmt, cnt + 2);
-		else
+		if (type != shp->EffectiveType || dims != shp->EffectiveDims)
 		  {
-		      switch (dbf_field->Value->Type)
+		      /* decoding again this row as the wider type */
+		      if (!gaiaReadShpEntityGeometry
+			  (shp, current_row - 1, srid))
 			{
-			case GAIA_INT_VALUE:
-			    sqlite3_bind_int64 (stmt, cnt + 2,
-						dbf_field->Value->IntValue);
-			    break;
-			case GAIA_DOUBLE_VALUE:
-			    sqlite3_bind_double (stmt, cnt + 2,
-						 dbf_field->Value->DblValue);
-			    break;
-			case GAIA_TEXT_VALUE:
-			    sqlite3_bind_text (stmt, cnt + 2,
-					       dbf_field->Value->TxtValue,
-					       strlen (dbf_field->
-						       Value->TxtValue),
-					       SQLITE_STATIC);
-			    break;
-			default:
-			    sqlite3_bind_null (stmt, cnt + 2);
-			    break;
+			    if (!err_msg)
+				spatialite_e ("%s\n", shp->LastError);
+			    else
+				sprintf (err_msg, "%s\n", shp->LastError);
+			    sqlError = 1;
+			    sqlite3_finalize (stmt);
+			    goto clean_up;
 			}
 		  }
-		cnt++;
-		dbf_field = dbf_field->Next;
 	    }
+	  blob = NULL;
+	  blob_size = 0;
 	  if (shp->Dbf->Geometry)
 	    {
 		if (compressed)
@@ -1190,13 +1873,9 @@ load_shapefile_ex2 (sqlite3 * sqlite, char *shp_path, char *table,
 		else
 		    gaiaToSpatiaLiteBlobWkb (shp->Dbf->Geometry, &blob,
 					     &blob_size);
-		sqlite3_bind_blob (stmt, cnt + 2, blob, blob_size, free);
-	    }
-	  else
-	    {
-		/* handling a NULL-Geometry */
-		sqlite3_bind_null (stmt, cnt + 2);
 	    }
+	  shp_load_bind_row (stmt, shp->Dbf, pk_name, pk_type, current_row,
+			     blob, blob_size);
 	  ret = sqlite3_step (stmt);
 	  if (ret == SQLITE_DONE || ret == SQLITE_ROW)
 	      ;
@@ -1524,6 +2203,12 @@ recover_unregistered_geometry (sqlite3 * handle, const char *table,
 /* attempting to recover an unregistered Geometry */
     int len;
     int error = 0;
+    int ret;
+    int rows;
+    int columns;
+    char **results;
+    char *sql;
+    char *xtable;
     gaiaVectorLayersListPtr list;
     gaiaVectorLayerPtr lyr;
 
@@ -1557,10 +2242,23 @@ recover_unregistered_geometry (sqlite3 * handle, const char *table,
 	list->Last->Next = lyr;
     list->Last = lyr;
 
-    if (!doComputeFieldInfos
-	(handle, lyr->TableName, lyr->GeometryName,
-	 SPATIALITE_STATISTICS_LEGACY, lyr))
+/*
+/ checking that the table really exists; the DBF fields widths
+/ will be computed later while spooling the exported rows
+*/
+    xtable = gaiaDoubleQuotedSql (table);
+    sql = sqlite3_mprintf ("PRAGMA table_info(\"%s\")", xtable);
+    free (xtable);
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
 	error = 1;
+    else
+      {
+	  if (rows < 1)
+	      error = 1;
+	  sqlite3_free_table (results);
+      }
 
     if (list->First == NULL || error)
       {
@@ -2608,133 +3306,632 @@ attached_layer (sqlite3 * handle, const char *db_prefix, const char *table,
     return NULL;
 }
 
-SPATIALITE_DECLARE int
-dump_shapefile (sqlite3 * sqlite, char *table, char *column, char *shp_path,
-		char *charset, char *geom_type, int verbose, int *xrows,
-		char *err_msg)
+#define SHP_EXPORT_SPOOL_BUFFER	(1024 * 1024)
+
+struct shp_export_value
 {
-/* SHAPEFILE dump */
-    char *sql;
-    char *dummy;
-    int shape = -1;
+/* a single column value, either just fetched or read back from the spool */
+    int type;
+    sqlite3_int64 int_value;
+    double dbl_value;
+    const unsigned char *data;	/* TEXT or BLOB */
+    int size;
+    unsigned char *buffer;	/* spool: owned buffer for TEXT or BLOB */
+    int buffer_size;
+};
+
+struct shp_export_column
+{
+/* a result set column and its values statistics */
+    char *name;
+    int int_values;
+    int dbl_values;
+    int txt_values;
+    int blob_values;
+    int max_size;
+    sqlite3_int64 int_min;
+    sqlite3_int64 int_max;
+    double dbl_min;
+    double dbl_max;
+};
+
+static struct shp_export_column *
+shp_export_alloc_columns (sqlite3_stmt * stmt, int n_cols)
+{
+/* allocating the result set columns */
+    struct shp_export_column *columns;
+    struct shp_export_column *col;
+    const char *name;
     int len;
-    int ret;
-    sqlite3_stmt *stmt;
-    int n_cols = 0;
-    int offset = 0;
     int i;
-    int rows = 0;
-    char buf[256];
-    char *xtable;
-    char *xcolumn;
-    const void *blob_value;
-    gaiaShapefilePtr shp = NULL;
-    gaiaDbfListPtr dbf_list;
-    gaiaDbfListPtr dbf_write;
-    gaiaDbfFieldPtr dbf_field;
-    gaiaVectorLayerPtr lyr = NULL;
-    gaiaLayerAttributeFieldPtr fld;
-    gaiaVectorLayersListPtr list;
-    char *db_prefix = NULL;
-    char *table_name = NULL;
-    char *xprefix;
-    char *xxtable;
-    struct auxdbf_list *auxdbf = NULL;
+    columns = malloc (sizeof (struct shp_export_column) * n_cols);
+    for (i = 0; i < n_cols; i++)
+      {
+	  col = columns + i;
+	  name = sqlite3_column_name (stmt, i);
+	  len = strlen (name);
+	  col->name = malloc (len + 1);
+	  strcpy (col->name, name);
+	  col->int_values = 0;
+	  col->dbl_values = 0;
+	  col->txt_values = 0;
+	  col->blob_values = 0;
+	  col->max_size = -1;
+	  col->int_min = 0;
+	  col->int_max = 0;
+	  col->dbl_min = 0.0;
+	  col->dbl_max = 0.0;
+      }
+    return columns;
+}
 
-    if (xrows)
-	*xrows = -1;
-    if (geom_type)
+static void
+shp_export_free_columns (struct shp_export_column *columns, int n_cols)
+{
+/* memory cleanup: result set columns */
+    int i;
+    if (columns == NULL)
+	return;
+    for (i = 0; i < n_cols; i++)
+	free (columns[i].name);
+    free (columns);
+}
+
+static struct shp_export_value *
+shp_export_alloc_values (int n_cols)
+{
+/* allocating a row of values */
+    struct shp_export_value *values;
+    int i;
+    values = malloc (sizeof (struct shp_export_value) * n_cols);
+    for (i = 0; i < n_cols; i++)
       {
-	  /* normalizing required geometry type */
-	  if (strcasecmp ((char *) geom_type, "POINT") == 0)
-	      shape = GAIA_POINT;
-	  if (strcasecmp ((char *) geom_type, "LINESTRING") == 0)
-	      shape = GAIA_LINESTRING;
-	  if (strcasecmp ((char *) geom_type, "POLYGON") == 0)
-	      shape = GAIA_POLYGON;
-	  if (strcasecmp ((char *) geom_type, "MULTIPOINT") == 0)
-	      shape = GAIA_POINT;
+	  values[i].type = SQLITE_NULL;
+	  values[i].data = NULL;
+	  values[i].size = 0;
+	  values[i].buffer = NULL;
+	  values[i].buffer_size = 0;
       }
-/* is the datasource a genuine registered Geometry ?? */
-    list = gaiaGetVectorLayersList (sqlite, table, column,
-				    GAIA_VECTORS_LIST_PESSIMISTIC);
-    if (list == NULL)
+    return values;
+}
+
+static void
+shp_export_free_values (struct shp_export_value *values, int n_cols)
+{
+/* memory cleanup: a row of values */
+    int i;
+    if (values == NULL)
+	return;
+    for (i = 0; i < n_cols; i++)
       {
-	  /* attempting to recover an unregistered Geometry */
-	  list = recover_unregistered_geometry (sqlite, table, column);
+	  if (values[i].buffer)
+	      free (values[i].buffer);
       }
+    free (values);
+}
 
-    if (list == NULL)
+static void
+shp_export_fetch (sqlite3_stmt * stmt, struct shp_export_value *values,
+		  int n_cols)
+{
+/* fetching the current result set row */
+    struct shp_export_value *val;
+    int i;
+    for (i = 0; i < n_cols; i++)
       {
-	  /* attempting to enucleate an eventual DB-prefix */
-	  shp_parse_table_name (table, &db_prefix, &table_name);
-	  if (db_prefix != NULL && table_name != NULL)
-	      list = attached_layer (sqlite, db_prefix, table_name, column);
+	  val = values + i;
+	  val->type = sqlite3_column_type (stmt, i);
+	  switch (val->type)
+	    {
+	    case SQLITE_INTEGER:
+		val->int_value = sqlite3_column_int64 (stmt, i);
+		break;
+	    case SQLITE_FLOAT:
+		val->dbl_value = sqlite3_column_double (stmt, i);
+		break;
+	    case SQLITE_TEXT:
+		val->data = sqlite3_column_text (stmt, i);
+		val->size = sqlite3_column_bytes (stmt, i);
+		break;
+	    case SQLITE_BLOB:
+		val->data = sqlite3_column_blob (stmt, i);
+		val->size = sqlite3_column_bytes (stmt, i);
+		break;
+	    };
       }
+}
 
-    if (list != NULL)
-	lyr = list->First;
-    if (lyr == NULL)
+static int
+shp_export_utf8_length (const unsigned char *text, int size)
+{
+/* counting UTF-8 characters, as the SQL length() function does */
+    int len = 0;
+    int i;
+    for (i = 0; i < size; i++)
       {
-	  gaiaFreeVectorLayersList (list);
-	  if (!err_msg)
-	      spatialite_e
-		  ("Unable to detect GeometryType for \"%s\".\"%s\" ... sorry\n",
-		   table, column);
-	  else
-	      sprintf (err_msg,
-		       "Unable to detect GeometryType for \"%s\".\"%s\" ... sorry\n",
-		       table, column);
-	  return 0;
+	  if ((text[i] & 0xc0) != 0x80)
+	      len++;
       }
+    return len;
+}
 
-    switch (lyr->GeometryType)
+static void
+shp_export_update_stats (struct shp_export_column *columns,
+			 struct shp_export_value *values, int n_cols)
+{
+/*
+/ updating the values statistics: the same rules applied by
+/ update_layer_statistics() on GEOMETRY_COLUMNS_FIELD_INFOS
+*/
+    struct shp_export_column *col;
+    struct shp_export_value *val;
+    int size;
+    int i;
+    for (i = 0; i < n_cols; i++)
       {
-      case GAIA_VECTOR_POINT:
-	  switch (lyr->Dimensions)
+	  col = columns + i;
+	  val = values + i;
+	  switch (val->type)
 	    {
-	    case GAIA_XY:
-		shape = GAIA_POINT;
+	    case SQLITE_INTEGER:
+		if (col->int_values == 0 || val->int_value < col->int_min)
+		    col->int_min = val->int_value;
+		if (col->int_values == 0 || val->int_value > col->int_max)
+		    col->int_max = val->int_value;
+		col->int_values++;
 		break;
-	    case GAIA_XY_Z:
-		shape = GAIA_POINTZ;
+	    case SQLITE_FLOAT:
+		if (col->dbl_values == 0 || val->dbl_value < col->dbl_min)
+		    col->dbl_min = val->dbl_value;
+		if (col->dbl_values == 0 || val->dbl_value > col->dbl_max)
+		    col->dbl_max = val->dbl_value;
+		col->dbl_values++;
 		break;
-	    case GAIA_XY_M:
-		shape = GAIA_POINTM;
+	    case SQLITE_TEXT:
+		size = shp_export_utf8_length (val->data, val->size);
+		if (size > col->max_size)
+		    col->max_size = size;
+		col->txt_values++;
 		break;
-	    case GAIA_XY_Z_M:
-		shape = GAIA_POINTZM;
+	    case SQLITE_BLOB:
+		if (val->size > col->max_size)
+		    col->max_size = val->size;
+		col->blob_values++;
 		break;
 	    };
-	  break;
-      case GAIA_VECTOR_LINESTRING:
-	  switch (lyr->Dimensions)
+      }
+}
+
+static int
+shp_export_spool_write (FILE * spool, struct shp_export_value *values,
+			int n_cols)
+{
+/* appending a row of values to the spool file */
+    struct shp_export_value *val;
+    unsigned char type;
+    int i;
+    for (i = 0; i < n_cols; i++)
+      {
+	  val = values + i;
+	  type = (unsigned char) val->type;
+	  if (fwrite (&type, 1, 1, spool) != 1)
+	      return 0;
+	  switch (val->type)
 	    {
-	    case GAIA_XY:
-		shape = GAIA_LINESTRING;
-		break;
-	    case GAIA_XY_Z:
-		shape = GAIA_LINESTRINGZ;
+	    case SQLITE_INTEGER:
+		if (fwrite (&(val->int_value), sizeof (sqlite3_int64), 1, spool)
+		    != 1)
+		    return 0;
 		break;
-	    case GAIA_XY_M:
-		shape = GAIA_LINESTRINGM;
+	    case SQLITE_FLOAT:
+		if (fwrite (&(val->dbl_value), sizeof (double), 1, spool) != 1)
+		    return 0;
 		break;
-	    case GAIA_XY_Z_M:
-		shape = GAIA_LINESTRINGZM;
+	    case SQLITE_TEXT:
+	    case SQLITE_BLOB:
+		if (fwrite (&(val->size), sizeof (int), 1, spool) != 1)
+		    return 0;
+		if (val->size > 0)
+		  {
+		      if (fwrite (val->data, 1, val->size, spool) !=
+			  (size_t) (val->size))
+			  return 0;
+		  }
 		break;
 	    };
-	  break;
-      case GAIA_VECTOR_POLYGON:
-	  switch (lyr->Dimensions)
+      }
+    return 1;
+}
+
+static int
+shp_export_spool_read (FILE * spool, struct shp_export_value *values,
+		       int n_cols)
+{
+/* reading back a row of values from the spool file */
+    struct shp_export_value *val;
+    unsigned char type;
+    int i;
+    for (i = 0; i < n_cols; i++)
+      {
+	  val = values + i;
+	  if (fread (&type, 1, 1, spool) != 1)
+	      return 0;
+	  val->type = type;
+	  switch (val->type)
 	    {
-	    case GAIA_XY:
-		shape = GAIA_POLYGON;
+	    case SQLITE_INTEGER:
+		if (fread (&(val->int_value), sizeof (sqlite3_int64), 1, spool)
+		    != 1)
+		    return 0;
 		break;
-	    case GAIA_XY_Z:
-		shape = GAIA_POLYGONZ;
+	    case SQLITE_FLOAT:
+		if (fread (&(val->dbl_value), sizeof (double), 1, spool) != 1)
+		    return 0;
 		break;
-	    case GAIA_XY_M:
-		shape = GAIA_POLYGONM;
+	    case SQLITE_TEXT:
+	    case SQLITE_BLOB:
+		if (fread (&(val->size), sizeof (int), 1, spool) != 1)
+		    return 0;
+		if (val->size + 1 > val->buffer_size)
+		  {
+		      /* growing the value buffer */
+		      if (val->buffer)
+			  free (val->buffer);
+		      val->buffer_size = val->size + 1;
+		      val->buffer = malloc (val->buffer_size);
+		      if (val->buffer == NULL)
+			{
+			    val->buffer_size = 0;
+			    return 0;
+			}
+		  }
+		if (val->size > 0)
+		  {
+		      if (fread (val->buffer, 1, val->size, spool) !=
+			  (size_t) (val->size))
+			  return 0;
+		  }
+		val->buffer[val->size] = '\0';	/* TEXT is NUL-terminated */
+		val->data = val->buffer;
+		break;
+	    };
+      }
+    return 1;
+}
+
+static void
+shp_export_add_field (gaiaDbfListPtr dbf_list, const char *name,
+		      int sql_type, int max_len, int *offset)
+{
+/* adding a DBF field */
+    if (sql_type == SQLITE_TEXT)
+      {
+	  if (max_len == 0)	/* avoiding ZERO-length fields */
+	      max_len = 1;
+	  if (max_len > 254)
+	    {
+		/* DBF C: max allowed lenght */
+		max_len = 254;
+	    }
+	  gaiaAddDbfField (dbf_list, (char *) name, 'C', *offset, max_len, 0);
+	  *offset += max_len;
+      }
+    if (sql_type == SQLITE_FLOAT)
+      {
+	  if (max_len > 19)
+	      max_len = 19;
+	  if (max_len < 8)
+	      max_len = 8;
+	  gaiaAddDbfField (dbf_list, (char *) name, 'N', *offset, max_len, 6);
+	  *offset += max_len;
+      }
+    if (sql_type == SQLITE_INTEGER)
+      {
+	  if (max_len > 18)
+	      max_len = 18;
+	  gaiaAddDbfField (dbf_list, (char *) name, 'N', *offset, max_len, 0);
+	  *offset += max_len;
+      }
+}
+
+static gaiaDbfListPtr
+shp_export_dbf_fields (struct shp_export_column *columns, int n_cols,
+		       const char *geom_column, int legacy)
+{
+/*
+/ preparing the DBF fields list from the gathered statistics
+/ (legacy mode: just as from legacy FIELD_INFOS, where a zero
+/ MaxSize is unknown)
+*/
+    gaiaDbfListPtr dbf_list = gaiaAllocDbfList ();
+    struct shp_export_column *col;
+    int offset = 0;
+    int i;
+    for (i = 0; i < n_cols; i++)
+      {
+	  int sql_type = SQLITE_NULL;
+	  int max_len = 0;
+	  col = columns + i;
+	  if (strcasecmp (col->name, geom_column) == 0)
+	    {
+		/* ignoring the Geometry itself */
+		continue;
+	    }
+	  if (col->int_values > 0 && col->dbl_values == 0
+	      && col->txt_values == 0)
+	    {
+		sql_type = SQLITE_INTEGER;
+		max_len = 18;
+		if (col->blob_values == 0)
+		    max_len = compute_max_int_length (col->int_min, col->int_max);
+	    }
+	  if (col->dbl_values > 0 && col->txt_values == 0)
+	    {
+		sql_type = SQLITE_FLOAT;
+		max_len = 19;
+		if (col->int_values == 0 && col->blob_values == 0)
+		    max_len = compute_max_dbl_length (col->dbl_min, col->dbl_max);
+	    }
+	  if (col->txt_values > 0)
+	    {
+		sql_type = SQLITE_TEXT;
+		max_len = 254;
+		if (legacy && col->max_size > 0)
+		    max_len = col->max_size;
+		if (!legacy && col->max_size >= 0)
+		    max_len = col->max_size;
+	    }
+	  if (sql_type == SQLITE_NULL)
+	    {
+		/* considering as TEXT(1) */
+		sql_type = SQLITE_TEXT;
+		max_len = 1;
+	    }
+	  shp_export_add_field (dbf_list, col->name, sql_type, max_len,
+				&offset);
+      }
+    return dbf_list;
+}
+
+static int
+shp_export_fresh_statistics (sqlite3 * sqlite, gaiaVectorLayerPtr lyr)
+{
+/*
+/ checking if GEOMETRY_COLUMNS_FIELD_INFOS can be trusted for sizing
+/ the DBF fields: this is only known for tables using the current
+/ metadata layout, when the statistics have been verified after
+/ the latest INSERT, UPDATE and DELETE
+*/
+    char *sql;
+    char **results;
+    int rows;
+    int columns;
+    int ret;
+    int fresh = 0;
+    if (lyr->LayerType != GAIA_VECTOR_TABLE || lyr->First == NULL)
+	return 0;
+    sql = sqlite3_mprintf ("SELECT s.last_verified > t.last_insert AND "
+			   "s.last_verified > t.last_update AND "
+			   "s.last_verified > t.last_delete "
+			   "FROM geometry_columns_statistics AS s "
+			   "JOIN geometry_columns_time AS t ON "
+			   "(s.f_table_name = t.f_table_name AND "
+			   "s.f_geometry_column = t.f_geometry_column) "
+			   "WHERE Lower(s.f_table_name) = Lower(%Q) AND "
+			   "Lower(s.f_geometry_column) = Lower(%Q)",
+			   lyr->TableName, lyr->GeometryName);
+    ret = sqlite3_get_table (sqlite, sql, &results, &rows, &columns, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+	return 0;
+    if (rows == 1 && results[columns] != NULL && atoi (results[columns]) == 1)
+	fresh = 1;
+    sqlite3_free_table (results);
+    return fresh;
+}
+
+static int
+shp_export_write_row (gaiaShapefilePtr shp, gaiaDbfListPtr dbf_list,
+		      const char *column, struct shp_export_column *columns,
+		      struct shp_export_value *values, int n_cols)
+{
+/* exporting a row of values into the shapefile */
+    gaiaDbfListPtr dbf_write;
+    gaiaDbfFieldPtr dbf_field;
+    struct auxdbf_list *auxdbf;
+    struct shp_export_value *val;
+    char buf[256];
+    char *sql;
+    int ret;
+    int i;
+    dbf_write = gaiaCloneDbfEntity (dbf_list);
+    auxdbf = alloc_auxdbf (dbf_write);
+    for (i = 0; i < n_cols; i++)
+      {
+	  val = values + i;
+	  if (strcasecmp (column, columns[i].name) == 0)
+	    {
+		/* this one is the internal BLOB encoded GEOMETRY to be exported */
+		if (val->type != SQLITE_BLOB)
+		  {
+		      /* this one is a NULL Geometry */
+		      dbf_write->Geometry = NULL;
+		  }
+		else
+		    dbf_write->Geometry =
+			gaiaFromSpatiaLiteBlobWkb (val->data, val->size);
+	    }
+	  dbf_field = getDbfField (auxdbf, columns[i].name);
+	  if (!dbf_field)
+	      continue;
+	  if (val->type == SQLITE_NULL)
+	    {
+		/* handling NULL values */
+		gaiaSetNullValue (dbf_field);
+	    }
+	  else
+	    {
+		switch (dbf_field->Type)
+		  {
+		  case 'N':
+		      if (val->type == SQLITE_INTEGER)
+			  gaiaSetIntValue (dbf_field, val->int_value);
+		      else if (val->type == SQLITE_FLOAT)
+			  gaiaSetDoubleValue (dbf_field, val->dbl_value);
+		      else
+			  gaiaSetNullValue (dbf_field);
+		      break;
+		  case 'C':
+		      if (val->type == SQLITE_TEXT)
+			  gaiaSetStrValue (dbf_field, (char *) (val->data));
+		      else if (val->type == SQLITE_INTEGER)
+			{
+			    sprintf (buf, FRMT64, val->int_value);
+			    gaiaSetStrValue (dbf_field, buf);
+			}
+		      else if (val->type == SQLITE_FLOAT)
+			{
+			    sql = sqlite3_mprintf ("%1.6f", val->dbl_value);
+			    gaiaSetStrValue (dbf_field, sql);
+			    sqlite3_free (sql);
+			}
+		      else
+			  gaiaSetNullValue (dbf_field);
+		      break;
+		  };
+	    }
+      }
+    free_auxdbf (auxdbf);
+    ret = gaiaWriteShpEntity (shp, dbf_write);
+    gaiaFreeDbfList (dbf_write);
+    return ret;
+}
+
+SPATIALITE_DECLARE int
+dump_shapefile (sqlite3 * sqlite, char *table, char *column, char *shp_path,
+		char *charset, char *geom_type, int verbose, int *xrows,
+		char *err_msg)
+{
+/* SHAPEFILE dump */
+    char *sql;
+    int shape = -1;
+    int ret;
+    sqlite3_stmt *stmt = NULL;
+    int n_cols = 0;
+    int offset = 0;
+    int rows = 0;
+    int spooled = 0;
+    int metadata_version;
+    char *xtable;
+    char *xcolumn;
+    gaiaShapefilePtr shp = NULL;
+    gaiaDbfListPtr dbf_list = NULL;
+    gaiaVectorLayerPtr lyr = NULL;
+    gaiaLayerAttributeFieldPtr fld;
+    gaiaVectorLayersListPtr list;
+    char *db_prefix = NULL;
+    char *table_name = NULL;
+    char *xprefix;
+    char *xxtable;
+    struct shp_export_column *columns = NULL;
+    struct shp_export_value *values = NULL;
+    FILE *spool = NULL;
+    char *spool_buffer = NULL;
+
+    if (xrows)
+	*xrows = -1;
+    if (geom_type)
+      {
+	  /* normalizing required geometry type */
+	  if (strcasecmp ((char *) geom_type, "POINT") == 0)
+	      shape = GAIA_POINT;
+	  if (strcasecmp ((char *) geom_type, "LINESTRING") == 0)
+	      shape = GAIA_LINESTRING;
+	  if (strcasecmp ((char *) geom_type, "POLYGON") == 0)
+	      shape = GAIA_POLYGON;
+	  if (strcasecmp ((char *) geom_type, "MULTIPOINT") == 0)
+	      shape = GAIA_POINT;
+      }
+/* is the datasource a genuine registered Geometry ?? */
+    list = gaiaGetVectorLayersList (sqlite, table, column,
+				    GAIA_VECTORS_LIST_FAST);
+    if (list == NULL)
+      {
+	  /* attempting to recover an unregistered Geometry */
+	  list = recover_unregistered_geometry (sqlite, table, column);
+      }
+
+    if (list == NULL)
+      {
+	  /* attempting to enucleate an eventual DB-prefix */
+	  shp_parse_table_name (table, &db_prefix, &table_name);
+	  if (db_prefix != NULL && table_name != NULL)
+	      list = attached_layer (sqlite, db_prefix, table_name, column);
+      }
+
+    if (list != NULL)
+	lyr = list->First;
+    if (lyr == NULL)
+      {
+	  gaiaFreeVectorLayersList (list);
+	  if (!err_msg)
+	      spatialite_e
+		  ("Unable to detect GeometryType for \"%s\".\"%s\" ... sorry\n",
+		   table, column);
+	  else
+	      sprintf (err_msg,
+		       "Unable to detect GeometryType for \"%s\".\"%s\" ... sorry\n",
+		       table, column);
+	  return 0;
+      }
+
+    switch (lyr->GeometryType)
+      {
+      case GAIA_VECTOR_POINT:
+	  switch (lyr->Dimensions)
+	    {
+	    case GAIA_XY:
+		shape = GAIA_POINT;
+		break;
+	    case GAIA_XY_Z:
+		shape = GAIA_POINTZ;
+		break;
+	    case GAIA_XY_M:
+		shape = GAIA_POINTM;
+		break;
+	    case GAIA_XY_Z_M:
+		shape = GAIA_POINTZM;
+		break;
+	    };
+	  break;
+      case GAIA_VECTOR_LINESTRING:
+	  switch (lyr->Dimensions)
+	    {
+	    case GAIA_XY:
+		shape = GAIA_LINESTRING;
+		break;
+	    case GAIA_XY_Z:
+		shape = GAIA_LINESTRINGZ;
+		break;
+	    case GAIA_XY_M:
+		shape = GAIA_LINESTRINGM;
+		break;
+	    case GAIA_XY_Z_M:
+		shape = GAIA_LINESTRINGZM;
+		break;
+	    };
+	  break;
+      case GAIA_VECTOR_POLYGON:
+	  switch (lyr->Dimensions)
+	    {
+	    case GAIA_XY:
+		shape = GAIA_POLYGON;
+		break;
+	    case GAIA_XY_Z:
+		shape = GAIA_POLYGONZ;
+		break;
+	    case GAIA_XY_M:
+		shape = GAIA_POLYGONM;
 		break;
 	    case GAIA_XY_Z_M:
 		shape = GAIA_POLYGONZM;
@@ -2911,101 +4108,127 @@ dump_shapefile (sqlite3 * sqlite, char *table, char *column, char *shp_path,
     sqlite3_free (sql);
     if (ret != SQLITE_OK)
 	goto sql_error;
+    n_cols = sqlite3_column_count (stmt);
+    columns = shp_export_alloc_columns (stmt, n_cols);
+    values = shp_export_alloc_values (n_cols);
 
-    if (lyr->First == NULL)
+    metadata_version = checkSpatialMetaData (sqlite);
+    if (db_prefix != NULL && lyr->First == NULL)
       {
-	  /* the datasource is probably empty - zero rows */
-	  if (get_default_dbf_fields
+	  /* attached DB: there are no statistics at all */
+	  if (!get_default_dbf_fields
 	      (sqlite, xtable, db_prefix, table_name, &dbf_list))
-	      goto continue_exporting;
+	      dbf_list = gaiaAllocDbfList ();
       }
-
-/* preparing the DBF fields list */
-    dbf_list = gaiaAllocDbfList ();
-    offset = 0;
-    fld = lyr->First;
-    while (fld)
+    else if (db_prefix != NULL
+	     || (metadata_version == 3
+		 && shp_export_fresh_statistics (sqlite, lyr)))
       {
-	  int sql_type = SQLITE_NULL;
-	  int max_len;
-	  if (strcasecmp (fld->AttributeFieldName, column) == 0)
+	  /* the statistics can be trusted: preparing the DBF fields list */
+	  dbf_list = gaiaAllocDbfList ();
+	  offset = 0;
+	  fld = lyr->First;
+	  while (fld)
 	    {
-		/* ignoring the Geometry itself */
+		int sql_type = SQLITE_NULL;
+		int max_len;
+		if (strcasecmp (fld->AttributeFieldName, column) == 0)
+		  {
+		      /* ignoring the Geometry itself */
+		      fld = fld->Next;
+		      continue;
+		  }
+		if (fld->IntegerValuesCount > 0 && fld->DoubleValuesCount == 0
+		    && fld->TextValuesCount == 0)
+		  {
+		      sql_type = SQLITE_INTEGER;
+		      max_len = 18;
+		      if (fld->IntRange)
+			  max_len =
+			      compute_max_int_length (fld->IntRange->MinValue,
+						      fld->IntRange->MaxValue);
+		  }
+		if (fld->DoubleValuesCount > 0 && fld->TextValuesCount == 0)
+		  {
+		      sql_type = SQLITE_FLOAT;
+		      max_len = 19;
+		      if (fld->DoubleRange)
+			  max_len =
+			      compute_max_dbl_length (fld->DoubleRange->MinValue,
+						      fld->DoubleRange->MaxValue);
+		  }
+		if (fld->TextValuesCount > 0)
+		  {
+		      sql_type = SQLITE_TEXT;
+		      max_len = 254;
+		      if (fld->MaxSize)
+			  max_len = fld->MaxSize->MaxSize;
+		  }
+		if (sql_type == SQLITE_NULL)
+		  {
+		      /* considering as TEXT(1) */
+		      sql_type = SQLITE_TEXT;
+		      max_len = 1;
+		  }
+		shp_export_add_field (dbf_list, fld->AttributeFieldName,
+				      sql_type, max_len, &offset);
 		fld = fld->Next;
-		continue;
 	    }
-	  if (fld->IntegerValuesCount > 0 && fld->DoubleValuesCount == 0
-	      && fld->TextValuesCount == 0)
-	    {
-		sql_type = SQLITE_INTEGER;
-		max_len = 18;
-		if (fld->IntRange)
-		    max_len =
-			compute_max_int_length (fld->IntRange->MinValue,
-						fld->IntRange->MaxValue);
+      }
+    else
+      {
+	  /*
+	     / the DBF fields widths are computed while spooling all rows
+	     / into a temporary file, so that the query runs just once
+	   */
+	  spool = tmpfile ();
+	  if (spool != NULL)
+	    {
+		spool_buffer = malloc (SHP_EXPORT_SPOOL_BUFFER);
+		if (spool_buffer != NULL)
+		    setvbuf (spool, spool_buffer, _IOFBF,
+			     SHP_EXPORT_SPOOL_BUFFER);
+	    }
+	  while (1)
+	    {
+		ret = sqlite3_step (stmt);
+		if (ret == SQLITE_DONE)
+		    break;	/* end of result set */
+		if (ret != SQLITE_ROW)
+		    goto sql_error;
+		shp_export_fetch (stmt, values, n_cols);
+		shp_export_update_stats (columns, values, n_cols);
+		if (spool != NULL)
+		  {
+		      if (!shp_export_spool_write (spool, values, n_cols))
+			  goto spool_error;
+		  }
+		spooled++;
 	    }
-	  if (fld->DoubleValuesCount > 0 && fld->TextValuesCount == 0)
+	  if (spool != NULL)
 	    {
-		sql_type = SQLITE_FLOAT;
-		max_len = 19;
-		if (fld->DoubleRange)
-		    max_len =
-			compute_max_dbl_length (fld->DoubleRange->MinValue,
-						fld->DoubleRange->MaxValue);
+		if (fseek (spool, 0, SEEK_SET) != 0)
+		    goto spool_error;
 	    }
-	  if (fld->TextValuesCount > 0)
-	    {
-		sql_type = SQLITE_TEXT;
-		max_len = 254;
-		if (fld->MaxSize)
-		    max_len = fld->MaxSize->MaxSize;
-	    }
-	  if (sql_type == SQLITE_NULL)
-	    {
-		/* considering as TEXT(1) */
-		sql_type = SQLITE_TEXT;
-		max_len = 1;
-	    }
-	  /* adding a DBF field */
-	  if (sql_type == SQLITE_TEXT)
-	    {
-		if (max_len == 0)	/* avoiding ZERO-length fields */
-		    max_len = 1;
-		if (max_len > 254)
-		  {
-		      /* DBF C: max allowed lenght */
-		      max_len = 254;
-		  }
-		gaiaAddDbfField (dbf_list, fld->AttributeFieldName, 'C', offset,
-				 max_len, 0);
-		offset += max_len;
-	    }
-	  if (sql_type == SQLITE_FLOAT)
-	    {
-		if (max_len > 19)
-		    max_len = 19;
-		if (max_len < 8)
-		    max_len = 8;
-		gaiaAddDbfField (dbf_list, fld->AttributeFieldName, 'N', offset,
-				 max_len, 6);
-		offset += max_len;
-	    }
-	  if (sql_type == SQLITE_INTEGER)
+	  else
 	    {
-		if (max_len > 18)
-		    max_len = 18;
-		gaiaAddDbfField (dbf_list, fld->AttributeFieldName, 'N', offset,
-				 max_len, 0);
-		offset += max_len;
+		/* no temporary file: the query will be executed again */
+		ret = sqlite3_reset (stmt);
+		if (ret != SQLITE_OK)
+		    goto sql_error;
 	    }
-	  fld = fld->Next;
+	  if (spooled == 0
+	      && get_default_dbf_fields (sqlite, xtable, db_prefix, table_name,
+					 &dbf_list))
+	      ;			/* the datasource is empty - zero rows */
+	  else
+	      dbf_list =
+		  shp_export_dbf_fields (columns, n_cols, column,
+					 metadata_version != 3
+					 || lyr->LayerType ==
+					 GAIA_VECTOR_UNKNOWN);
       }
 
-/* resetting SQLite query */
-  continue_exporting:
-    ret = sqlite3_reset (stmt);
-    if (ret != SQLITE_OK)
-	goto sql_error;
 /* trying to open shapefile files */
     shp = gaiaAllocShapefile ();
     gaiaOpenShpWrite (shp, shp_path, shape, dbf_list, "UTF-8", charset);
@@ -3016,108 +4239,34 @@ dump_shapefile (sqlite3 * sqlite, char *table, char *column, char *shp_path,
     while (1)
       {
 	  /* scrolling the result set to dump data into shapefile */
-	  ret = sqlite3_step (stmt);
-	  if (ret == SQLITE_DONE)
-	      break;		/* end of result set */
-	  if (ret == SQLITE_ROW)
+	  if (spool != NULL)
 	    {
-		if (n_cols == 0)
-		    n_cols = sqlite3_column_count (stmt);
-		rows++;
-		dbf_write = gaiaCloneDbfEntity (dbf_list);
-		auxdbf = alloc_auxdbf (dbf_write);
-		for (i = 0; i < n_cols; i++)
-		  {
-		      if (strcasecmp
-			  ((char *) column,
-			   (char *) sqlite3_column_name (stmt, i)) == 0)
-			{
-			    /* this one is the internal BLOB encoded GEOMETRY to be exported */
-			    if (sqlite3_column_type (stmt, i) != SQLITE_BLOB)
-			      {
-				  /* this one is a NULL Geometry */
-				  dbf_write->Geometry = NULL;
-			      }
-			    else
-			      {
-				  blob_value = sqlite3_column_blob (stmt, i);
-				  len = sqlite3_column_bytes (stmt, i);
-				  dbf_write->Geometry =
-				      gaiaFromSpatiaLiteBlobWkb (blob_value,
-								 len);
-			      }
-			}
-		      dummy = (char *) sqlite3_column_name (stmt, i);
-		      dbf_field = getDbfField (auxdbf, dummy);
-		      if (!dbf_field)
-			  continue;
-		      if (sqlite3_column_type (stmt, i) == SQLITE_NULL)
-			{
-			    /* handling NULL values */
-			    gaiaSetNullValue (dbf_field);
-			}
-		      else
-			{
-			    switch (dbf_field->Type)
-			      {
-			      case 'N':
-				  if (sqlite3_column_type (stmt, i) ==
-				      SQLITE_INTEGER)
-				      gaiaSetIntValue (dbf_field,
-						       sqlite3_column_int64
-						       (stmt, i));
-				  else if (sqlite3_column_type (stmt, i) ==
-					   SQLITE_FLOAT)
-				      gaiaSetDoubleValue (dbf_field,
-							  sqlite3_column_double
-							  (stmt, i));
-				  else
-				      gaiaSetNullValue (dbf_field);
-				  break;
-			      case 'C':
-				  if (sqlite3_column_type (stmt, i) ==
-				      SQLITE_TEXT)
-				    {
-					dummy =
-					    (char *) sqlite3_column_text (stmt,
-									  i);
-					gaiaSetStrValue (dbf_field, dummy);
-				    }
-				  else if (sqlite3_column_type (stmt, i) ==
-					   SQLITE_INTEGER)
-				    {
-					sprintf (buf, FRMT64,
-						 sqlite3_column_int64 (stmt,
-								       i));
-					gaiaSetStrValue (dbf_field, buf);
-				    }
-				  else if (sqlite3_column_type (stmt, i) ==
-					   SQLITE_FLOAT)
-				    {
-					sql = sqlite3_mprintf ("%1.6f",
-							       sqlite3_column_double
-							       (stmt, i));
-					gaiaSetStrValue (dbf_field, sql);
-					sqlite3_free (sql);
-				    }
-				  else
-				      gaiaSetNullValue (dbf_field);
-				  break;
-			      };
-			}
-		  }
-		free_auxdbf (auxdbf);
-		auxdbf = NULL;
-		if (!gaiaWriteShpEntity (shp, dbf_write))
-		    spatialite_e ("shapefile write error\n");
-		gaiaFreeDbfList (dbf_write);
+		if (rows == spooled)
+		    break;	/* end of spooled rows */
+		if (!shp_export_spool_read (spool, values, n_cols))
+		    goto spool_error;
 	    }
 	  else
-	      goto sql_error;
+	    {
+		ret = sqlite3_step (stmt);
+		if (ret == SQLITE_DONE)
+		    break;	/* end of result set */
+		if (ret != SQLITE_ROW)
+		    goto sql_error;
+		shp_export_fetch (stmt, values, n_cols);
+	    }
+	  rows++;
+	  if (!shp_export_write_row
+	      (shp, dbf_list, column, columns, values, n_cols))
+	      spatialite_e ("shapefile write error\n");
       }
-    if (auxdbf != NULL)
-	free_auxdbf (auxdbf);
     sqlite3_finalize (stmt);
+    if (spool != NULL)
+	fclose (spool);
+    if (spool_buffer != NULL)
+	free (spool_buffer);
+    shp_export_free_columns (columns, n_cols);
+    shp_export_free_values (values, n_cols);
     gaiaFlushShpHeaders (shp);
     gaiaFreeShapefile (shp);
     free (xtable);
@@ -3136,16 +4285,20 @@ dump_shapefile (sqlite3 * sqlite, char *table, char *column, char *shp_path,
     return 1;
   sql_error:
 /* some SQL error occurred */
-    if (auxdbf != NULL)
-	free_auxdbf (auxdbf);
     sqlite3_finalize (stmt);
+    if (spool != NULL)
+	fclose (spool);
+    if (spool_buffer != NULL)
+	free (spool_buffer);
+    shp_export_free_columns (columns, n_cols);
+    shp_export_free_values (values, n_cols);
     free (xtable);
     free (xcolumn);
     gaiaFreeVectorLayersList (list);
-    if (dbf_list)
-	gaiaFreeDbfList (dbf_list);
     if (shp)
 	gaiaFreeShapefile (shp);
+    else if (dbf_list)
+	gaiaFreeDbfList (dbf_list);
     if (!err_msg)
 	spatialite_e ("SELECT failed: %s", sqlite3_errmsg (sqlite));
     else
@@ -3155,10 +4308,39 @@ dump_shapefile (sqlite3 * sqlite, char *table, char *column, char *shp_path,
     if (table_name != NULL)
 	free (table_name);
     return 0;
+  spool_error:
+/* the temporary spool file can't be written or read */
+    sqlite3_finalize (stmt);
+    fclose (spool);
+    if (spool_buffer != NULL)
+	free (spool_buffer);
+    shp_export_free_columns (columns, n_cols);
+    shp_export_free_values (values, n_cols);
+    free (xtable);
+    free (xcolumn);
+    gaiaFreeVectorLayersList (list);
+    if (shp)
+	gaiaFreeShapefile (shp);
+    else if (dbf_list)
+	gaiaFreeDbfList (dbf_list);
+    if (!err_msg)
+	spatialite_e ("ERROR: unable to spool rows into a temporary file");
+    else
+	sprintf (err_msg, "ERROR: unable to spool rows into a temporary file");
+    if (db_prefix != NULL)
+	free (db_prefix);
+    if (table_name != NULL)
+	free (table_name);
+    return 0;
   no_file:
 /* shapefile can't be created/opened */
-    if (auxdbf != NULL)
-	free_auxdbf (auxdbf);
+    sqlite3_finalize (stmt);
+    if (spool != NULL)
+	fclose (spool);
+    if (spool_buffer != NULL)
+	free (spool_buffer);
+    shp_export_free_columns (columns, n_cols);
+    shp_export_free_values (values, n_cols);
     free (xtable);
     free (xcolumn);
     gaiaFreeVectorLayersList (list);
@@ -5729,6 +6911,52 @@ elementary_geometries_ex2 (sqlite3 * sqlite,
 
 #ifndef OMIT_FREEXL		/* including FreeXL */
 
+static void
+xl_column_list (const void *xl_handle, int first_titles,
+		unsigned short columns, gaiaOutBufferPtr list)
+{
+/* building the quoted column list shared by CREATE TABLE and INSERT */
+    FreeXL_CellValue cell;
+    unsigned short col;
+    int ret;
+    char *name;
+    char *xname;
+    char *sql;
+    gaiaOutBufferInitialize (list);
+    for (col = 0; col < columns; col++)
+      {
+	  name = NULL;
+	  if (first_titles)
+	    {
+		/* fetching the column name from the header row */
+		ret = freexl_get_cell_value (xl_handle, 0, col, &cell);
+		if (ret != FREEXL_OK)
+		    ;
+		else if (cell.type == FREEXL_CELL_INT)
+		    name = sqlite3_mprintf ("%d", cell.value.int_value);
+		else if (cell.type == FREEXL_CELL_DOUBLE)
+		    name = sqlite3_mprintf ("%1.2f", cell.value.double_value);
+		else if (cell.type == FREEXL_CELL_TEXT
+			 || cell.type == FREEXL_CELL_SST_TEXT
+			 || cell.type == FREEXL_CELL_DATE
+			 || cell.type == FREEXL_CELL_DATETIME
+			 || cell.type == FREEXL_CELL_TIME)
+		  {
+		      if (strlen (cell.value.text_value) < 256)
+			  name = sqlite3_mprintf ("%s", cell.value.text_value);
+		  }
+	    }
+	  if (name == NULL)
+	      name = sqlite3_mprintf ("col_%d", col);
+	  xname = gaiaDoubleQuotedSql (name);
+	  sqlite3_free (name);
+	  sql = sqlite3_mprintf (", \"%s\"", xname);
+	  free (xname);
+	  gaiaAppendToOutBuffer (list, sql);
+	  sqlite3_free (sql);
+      }
+}
+
 SPATIALITE_DECLARE int
 load_XL (sqlite3 * sqlite, const char *path, const char *table,
 	 unsigned int worksheetIndex, int first_titles, unsigned int *rows,
@@ -5740,8 +6968,6 @@ load_XL (sqlite3 * sqlite, const char *path, const char *table,
     int ret;
     char *errMsg = NULL;
     char *xname;
-    char *dummy;
-    char *xdummy;
     char *sql;
     int sqlError = 0;
     const void *xl_handle;
@@ -5749,6 +6975,7 @@ load_XL (sqlite3 * sqlite, const char *path, const char *table,
     unsigned short columns;
     unsigned short col;
     gaiaOutBuffer sql_statement;
+    gaiaOutBuffer col_list;
     FreeXL_CellValue cell;
     int already_exists = 0;
 
@@ -5829,6 +7056,7 @@ load_XL (sqlite3 * sqlite, const char *path, const char *table,
 	  goto clean_up;
       }
 /* creating the Table */
+    xl_column_list (xl_handle, first_titles, columns, &col_list);
     gaiaOutBufferInitialize (&sql_statement);
     xname = gaiaDoubleQuotedSql (table);
     sql = sqlite3_mprintf ("CREATE TABLE \"%s\"", xname);
@@ -5837,67 +7065,8 @@ load_XL (sqlite3 * sqlite, const char *path, const char *table,
     sqlite3_free (sql);
     gaiaAppendToOutBuffer (&sql_statement,
 			   " (\nPK_UID INTEGER PRIMARY KEY AUTOINCREMENT");
-    for (col = 0; col < columns; col++)
-      {
-	  if (first_titles)
-	    {
-		/* fetching column names */
-		for (col = 0; col < columns; col++)
-		  {
-		      ret = freexl_get_cell_value (xl_handle, 0, col, &cell);
-		      if (ret != FREEXL_OK)
-			  dummy = sqlite3_mprintf ("col_%d", col);
-		      else
-			{
-			    if (cell.type == FREEXL_CELL_INT)
-				dummy =
-				    sqlite3_mprintf ("%d",
-						     cell.value.int_value);
-			    else if (cell.type == FREEXL_CELL_DOUBLE)
-				dummy = sqlite3_mprintf ("%1.2f ",
-							 cell.
-							 value.double_value);
-			    else if (cell.type == FREEXL_CELL_TEXT
-				     || cell.type == FREEXL_CELL_SST_TEXT
-				     || cell.type == FREEXL_CELL_DATE
-				     || cell.type == FREEXL_CELL_DATETIME
-				     || cell.type == FREEXL_CELL_TIME)
-			      {
-				  int len = strlen (cell.value.text_value);
-				  if (len < 256)
-				      dummy =
-					  sqlite3_mprintf ("%s",
-							   cell.
-							   value.text_value);
-				  else
-				      dummy = sqlite3_mprintf ("col_%d", col);
-			      }
-			    else
-				dummy = sqlite3_mprintf ("col_%d", col);
-			}
-		      xdummy = gaiaDoubleQuotedSql (dummy);
-		      sqlite3_free (dummy);
-		      sql = sqlite3_mprintf (", \"%s\"", xdummy);
-		      free (xdummy);
-		      gaiaAppendToOutBuffer (&sql_statement, sql);
-		      sqlite3_free (sql);
-		  }
-	    }
-	  else
-	    {
-		/* setting default column names */
-		for (col = 0; col < columns; col++)
-		  {
-		      dummy = sqlite3_mprintf ("col_%d", col);
-		      xdummy = gaiaDoubleQuotedSql (dummy);
-		      sqlite3_free (dummy);
-		      sql = sqlite3_mprintf (", \"%s\"", xdummy);
-		      free (xdummy);
-		      gaiaAppendToOutBuffer (&sql_statement, sql);
-		      sqlite3_free (sql);
-		  }
-	    }
-      }
+    if (col_list.Buffer != NULL)
+	gaiaAppendToOutBuffer (&sql_statement, col_list.Buffer);
     gaiaAppendToOutBuffer (&sql_statement, ")");
     if (sql_statement.Error == 0 && sql_statement.Buffer != NULL)
       {
@@ -5907,6 +7076,7 @@ load_XL (sqlite3 * sqlite, const char *path, const char *table,
 	    {
 		spatialite_e ("load XL error: %s\n", errMsg);
 		sqlite3_free (errMsg);
+		gaiaOutBufferReset (&col_list);
 		sqlError = 1;
 		goto clean_up;
 	    }
@@ -5918,57 +7088,9 @@ load_XL (sqlite3 * sqlite, const char *path, const char *table,
     free (xname);
     gaiaAppendToOutBuffer (&sql_statement, sql);
     sqlite3_free (sql);
-    for (col = 0; col < columns; col++)
-      {
-	  if (first_titles)
-	    {
-		ret = freexl_get_cell_value (xl_handle, 0, col, &cell);
-		if (ret != FREEXL_OK)
-		    dummy = sqlite3_mprintf ("col_%d", col);
-		else
-		  {
-		      if (cell.type == FREEXL_CELL_INT)
-			  dummy = sqlite3_mprintf ("%d", cell.value.int_value);
-		      else if (cell.type == FREEXL_CELL_DOUBLE)
-			  dummy =
-			      sqlite3_mprintf ("%1.2f",
-					       cell.value.double_value);
-		      else if (cell.type == FREEXL_CELL_TEXT
-			       || cell.type == FREEXL_CELL_SST_TEXT
-			       || cell.type == FREEXL_CELL_DATE
-			       || cell.type == FREEXL_CELL_DATETIME
-			       || cell.type == FREEXL_CELL_TIME)
-			{
-			    int len = strlen (cell.value.text_value);
-			    if (len < 256)
-				dummy =
-				    sqlite3_mprintf ("%s",
-						     cell.value.text_value);
-			    else
-				dummy = sqlite3_mprintf ("col_%d", col);
-			}
-		      else
-			  dummy = sqlite3_mprintf ("col_%d", col);
-		  }
-		xdummy = gaiaDoubleQuotedSql (dummy);
-		sqlite3_free (dummy);
-		sql = sqlite3_mprintf (", \"%s\"", xdummy);
-		free (xdummy);
-		gaiaAppendToOutBuffer (&sql_statement, sql);
-		sqlite3_free (sql);
-	    }
-	  else
-	    {
-		/* setting default column names  */
-		dummy = sqlite3_mprintf ("col_%d", col);
-		xdummy = gaiaDoubleQuotedSql (dummy);
-		sqlite3_free (dummy);
-		sql = sqlite3_mprintf (", \"%s\"", xdummy);
-		free (xdummy);
-		gaiaAppendToOutBuffer (&sql_statement, sql);
-		sqlite3_free (sql);
-	    }
-      }
+    if (col_list.Buffer != NULL)
+	gaiaAppendToOutBuffer (&sql_statement, col_list.Buffer);
+    gaiaOutBufferReset (&col_list);
     gaiaAppendToOutBuffer (&sql_statement, ")\nVALUES (NULL");
     for (col = 0; col < columns; col++)
       {
@@ -5995,9 +7117,8 @@ load_XL (sqlite3 * sqlite, const char *path, const char *table,
 	current_row = 0;
     while (current_row < *rows)
       {
-	  /* binding query params */
+	  /* binding query params: every one is rebound on each row */
 	  sqlite3_reset (stmt);
-	  sqlite3_clear_bindings (stmt);
 	  for (col = 0; col < columns; col++)
 	    {
 		/* column values */
@@ -6201,3 +7322,2248 @@ dump_geojson_ex (sqlite3 * sqlite, char *table, char *geom_col,
     spatialite_e ("The SQL SELECT returned no data to export...\n");
     return 0;
 }
+
+static void
+geojson_escaped_text (gaiaOutBufferPtr out_buf, const unsigned char *text,
+		      int len)
+{
+/* printing a JSON quoted string */
+    int i;
+    int run = 0;
+    char buf[8];
+    gaiaAppendToOutBufferLen (out_buf, "\"", 1);
+    for (i = 0; i < len; i++)
+      {
+	  unsigned char c = text[i];
+	  if (c >= 0x20 && c != '"' && c != '\\')
+	      continue;
+	  /* flushing the pending run of plain chars */
+	  gaiaAppendToOutBufferLen (out_buf, (const char *) text + run,
+				    i - run);
+	  run = i + 1;
+	  switch (c)
+	    {
+	    case '"':
+		gaiaAppendToOutBufferLen (out_buf, "\\\"", 2);
+		break;
+	    case '\\':
+		gaiaAppendToOutBufferLen (out_buf, "\\\\", 2);
+		break;
+	    case '\n':
+		gaiaAppendToOutBufferLen (out_buf, "\\n", 2);
+		break;
+	    case '\r':
+		gaiaAppendToOutBufferLen (out_buf, "\\r", 2);
+		break;
+	    case '\t':
+		gaiaAppendToOutBufferLen (out_buf, "\\t", 2);
+		break;
+	    default:
+		sprintf (buf, "\\u%04x", c);
+		gaiaAppendToOutBufferLen (out_buf, buf, 6);
+		break;
+	    };
+      }
+    gaiaAppendToOutBufferLen (out_buf, (const char *) text + run, len - run);
+    gaiaAppendToOutBufferLen (out_buf, "\"", 1);
+}
+
+static void
+geojson_double (gaiaOutBufferPtr out_buf, double value)
+{
+/* printing a JSON number using the shortest round-trip representation */
+    char buf[64];
+    if (isnan (value) || isinf (value))
+      {
+	  /* not representable in JSON */
+	  gaiaAppendToOutBufferLen (out_buf, "null", 4);
+	  return;
+      }
+    sqlite3_snprintf (sizeof (buf), buf, "%!.15g", value);
+    if (strtod (buf, NULL) != value)
+	sqlite3_snprintf (sizeof (buf), buf, "%!.17g", value);
+    gaiaAppendToOutBuffer (out_buf, buf);
+}
+
+static int
+geojson_flush (FILE * out, gaiaOutBufferPtr out_buf)
+{
+/* writing the buffered GeoJSON text into the output file */
+    if (out_buf->Error)
+	return 0;
+    if (out_buf->WriteOffset > 0)
+      {
+	  if (fwrite (out_buf->Buffer, 1, out_buf->WriteOffset, out) !=
+	      (size_t) (out_buf->WriteOffset))
+	      return 0;
+      }
+    /* the same buffer will be reused */
+    out_buf->WriteOffset = 0;
+    return 1;
+}
+
+SPATIALITE_DECLARE int
+dump_geojson_features (sqlite3 * sqlite, char *table, char *geom_col,
+		       char *outfile_path, int precision, int option,
+		       int ndjson, int *xrows)
+{
+/* dumping a geometry table as GeoJSON Features [including all attributes] */
+    char *sql;
+    char *xtable;
+    sqlite3_stmt *stmt = NULL;
+    FILE *out = NULL;
+    gaiaOutBuffer out_buf;
+    int ret;
+    int rows = 0;
+    int n_cols;
+    int ic;
+    int ig = -1;
+    int first;
+    const char **col_names = NULL;
+    int *col_lens = NULL;
+
+    *xrows = -1;
+    gaiaOutBufferInitialize (&out_buf);
+/* opening/creating the GeoJSON output file */
+    out = fopen (outfile_path, "wb");
+    if (!out)
+	goto no_file;
+
+/* preparing SQL statement */
+    xtable = gaiaDoubleQuotedSql (table);
+    sql = sqlite3_mprintf ("SELECT * FROM \"%s\"", xtable);
+    free (xtable);
+    ret = sqlite3_prepare_v2 (sqlite, sql, strlen (sql), &stmt, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+	goto sql_error;
+
+/* identifying the geometry column and caching all the column names */
+    n_cols = sqlite3_column_count (stmt);
+    col_names = malloc (sizeof (const char *) * n_cols);
+    col_lens = malloc (sizeof (int) * n_cols);
+    for (ic = 0; ic < n_cols; ic++)
+      {
+	  col_names[ic] = sqlite3_column_name (stmt, ic);
+	  col_lens[ic] = strlen (col_names[ic]);
+	  if (ig < 0 && strcasecmp (col_names[ic], geom_col) == 0)
+	      ig = ic;
+      }
+    if (ig < 0)
+      {
+	  spatialite_e ("Dump GeoJSON error: no such column \"%s\"\n",
+			geom_col);
+	  goto error;
+      }
+
+    gaiaOutBufferReserve (&out_buf, 1024 * 1024);
+    if (!ndjson)
+	gaiaAppendToOutBuffer (&out_buf,
+			       "{\"type\":\"FeatureCollection\",\"features\":[\n");
+    while (1)
+      {
+	  /* scrolling the result set */
+	  ret = sqlite3_step (stmt);
+	  if (ret == SQLITE_DONE)
+	      break;		/* end of result set */
+	  if (ret != SQLITE_ROW)
+	      goto sql_error;
+	  if (rows > 0 && !ndjson)
+	      gaiaAppendToOutBufferLen (&out_buf, ",\n", 2);
+	  rows++;
+	  gaiaAppendToOutBuffer (&out_buf,
+				 "{\"type\":\"Feature\",\"geometry\":");
+	  if (sqlite3_column_type (stmt, ig) == SQLITE_BLOB)
+	    {
+		const unsigned char *blob = sqlite3_column_blob (stmt, ig);
+		int size = sqlite3_column_bytes (stmt, ig);
+		if (!gaiaOutGeoJSONFromSpatiaLiteBlob
+		    (&out_buf, blob, size, precision, option))
+		  {
+		      /* compressed geometry or GeoPackage BLOB */
+		      gaiaGeomCollPtr geom =
+			  gaiaFromSpatiaLiteBlobWkbEx (blob, size, 0, 1);
+		      if (geom == NULL)
+			  gaiaAppendToOutBufferLen (&out_buf, "null", 4);
+		      else
+			{
+			    gaiaOutGeoJSON (&out_buf, geom, precision,
+					    option);
+			    gaiaFreeGeomColl (geom);
+			}
+		  }
+	    }
+	  else
+	      gaiaAppendToOutBufferLen (&out_buf, "null", 4);
+	  gaiaAppendToOutBuffer (&out_buf, ",\"properties\":{");
+	  first = 1;
+	  for (ic = 0; ic < n_cols; ic++)
+	    {
+		/* exporting all other columns as Feature properties */
+		if (ic == ig)
+		    continue;
+		if (!first)
+		    gaiaAppendToOutBufferLen (&out_buf, ",", 1);
+		first = 0;
+		geojson_escaped_text (&out_buf,
+				      (const unsigned char *) col_names[ic],
+				      col_lens[ic]);
+		gaiaAppendToOutBufferLen (&out_buf, ":", 1);
+		switch (sqlite3_column_type (stmt, ic))
+		  {
+		  case SQLITE_INTEGER:
+		      {
+			  char buf[64];
+			  sprintf (buf, FRMT64,
+				   sqlite3_column_int64 (stmt, ic));
+			  gaiaAppendToOutBuffer (&out_buf, buf);
+		      }
+		      break;
+		  case SQLITE_FLOAT:
+		      geojson_double (&out_buf,
+				      sqlite3_column_double (stmt, ic));
+		      break;
+		  case SQLITE_TEXT:
+		      geojson_escaped_text (&out_buf,
+					    sqlite3_column_text (stmt, ic),
+					    sqlite3_column_bytes (stmt, ic));
+		      break;
+		  default:
+		      /* NULL and BLOB values */
+		      gaiaAppendToOutBufferLen (&out_buf, "null", 4);
+		      break;
+		  };
+	    }
+	  gaiaAppendToOutBufferLen (&out_buf, "}}", 2);
+	  if (ndjson)
+	      gaiaAppendToOutBufferLen (&out_buf, "\n", 1);
+	  if (out_buf.WriteOffset >= 1024 * 1024)
+	    {
+		if (!geojson_flush (out, &out_buf))
+		    goto write_error;
+	    }
+      }
+    if (!ndjson)
+	gaiaAppendToOutBuffer (&out_buf, "\n]}\n");
+    if (!geojson_flush (out, &out_buf))
+	goto write_error;
+
+    sqlite3_finalize (stmt);
+    free (col_names);
+    free (col_lens);
+    gaiaOutBufferReset (&out_buf);
+    if (fclose (out) != 0)
+      {
+	  spatialite_e ("Dump GeoJSON error: unable to write into '%s'\n",
+			outfile_path);
+	  return 0;
+      }
+    *xrows = rows;
+    return 1;
+
+  sql_error:
+/* an SQL error occurred */
+    spatialite_e ("Dump GeoJSON error: %s\n", sqlite3_errmsg (sqlite));
+    goto error;
+
+  write_error:
+/* writing into the output file failed */
+    spatialite_e ("Dump GeoJSON error: unable to write into '%s'\n",
+		  outfile_path);
+    goto error;
+
+  no_file:
+/* Output file could not be created / opened */
+    spatialite_e ("ERROR: unable to open '%s' for writing\n", outfile_path);
+
+  error:
+    if (stmt)
+	sqlite3_finalize (stmt);
+    if (out)
+	fclose (out);
+    if (col_names)
+	free (col_names);
+    if (col_lens)
+	free (col_lens);
+    gaiaOutBufferReset (&out_buf);
+    return 0;
+}
+
+/* size of the input buffer used by the GeoJSON reader */
+#define GEOJSON_READ_BUFFER	(1024 * 1024)
+
+/* leading Features examined so to infer the layout of the output table */
+#define GEOJSON_SAMPLE_SIZE	4096
+
+/* number of buckets of the Hash Index on property names */
+#define GEOJSON_HASH_BUCKETS	1024
+
+/* max nesting level allowed for GeoJSON arrays and objects */
+#define GEOJSON_MAX_DEPTH	256
+
+struct geojson_value
+{
+/* a property value of the current Feature */
+    int row;			/* the Feature this value belongs to */
+    int type;
+    sqlite3_int64 int_value;
+    double dbl_value;
+    int txt_offset;		/* within the text buffer of the Feature */
+    int txt_len;
+};
+
+struct geojson_column
+{
+/* a Feature property mapped to a table column */
+    char *key;			/* the property name */
+    int key_len;
+    char *name;			/* the corresponding column name */
+    int n_int;			/* sampled INTEGER values */
+    int n_dbl;			/* sampled DOUBLE values */
+    int n_txt;			/* sampled TEXT values */
+    int next_hash;		/* next column within the same bucket */
+    struct geojson_value value;
+};
+
+struct geojson_coords
+{
+/* the raw "coordinates" of the current GeoJSON Geometry */
+    double *xyz;		/* three doubles for each position */
+    int n_points;
+    int max_points;
+    int *counts;		/* items of each nested array [pre-order] */
+    int n_counts;
+    int max_counts;
+    int level;			/* nesting level of positions, -1 if none */
+    int has_z;
+    int invalid;
+};
+
+struct geojson_loader
+{
+/* the current status of a GeoJSON import */
+    sqlite3 *sqlite;
+    FILE *in;
+    unsigned char *buf;
+    int buf_len;
+    int buf_pos;
+    sqlite3_int64 offset;	/* file offset of the buffer */
+    int eof;
+    int stop;
+    int sampling;
+    char *error;
+    gaiaOutBuffer key;		/* the latest property name */
+    gaiaOutBuffer text;		/* all text values of the current Feature */
+    struct geojson_coords coords;
+    struct geojson_column *columns;
+    int n_columns;
+    int max_columns;
+    int n_created;		/* columns already existing in the table */
+    int buckets[GEOJSON_HASH_BUCKETS];
+    int seed;
+    int row;			/* serial number of the current Feature */
+    struct geojson_value id;	/* the Feature "id" member */
+    gaiaGeomCollPtr geom;	/* the Geometry of the current Feature */
+    int feat_type;		/* its GeoJSON type, -1 if none */
+    int feat_z;
+    int feat_invalid;
+    int geom_type;		/* the type of the Geometry column */
+    int has_z;
+    int metadata_version;
+    int crs_srid;
+    int srid;
+    int sampled;
+    int invalid_geoms;
+    const char *table;
+    const char *geom_column;
+    sqlite3_stmt *stmt;
+    int rows;
+};
+
+static int
+geojson_syntax_error (struct geojson_loader *ld)
+{
+/* reporting a malformed GeoJSON input */
+    if (ld->error == NULL)
+	ld->error =
+	    sqlite3_mprintf ("GeoJSON syntax error near offset %lld",
+			     ld->offset + ld->buf_pos);
+    return 0;
+}
+
+static int
+geojson_fill (struct geojson_loader *ld)
+{
+/* refilling the input buffer; returns 0 on EOF */
+    size_t rd;
+    if (ld->eof)
+	return 0;
+    ld->offset += ld->buf_len;
+    rd = fread (ld->buf, 1, GEOJSON_READ_BUFFER, ld->in);
+    ld->buf_len = rd;
+    ld->buf_pos = 0;
+    if (rd == 0)
+      {
+	  ld->eof = 1;
+	  return 0;
+      }
+    if (ld->offset == 0 && rd >= 3 && ld->buf[0] == 0xef
+	&& ld->buf[1] == 0xbb && ld->buf[2] == 0xbf)
+	ld->buf_pos = 3;	/* skipping an UTF-8 BOM */
+    return 1;
+}
+
+static int
+geojson_peek (struct geojson_loader *ld)
+{
+/* returning the next significant char [-1 on EOF] */
+    while (1)
+      {
+	  int c;
+	  if (ld->buf_pos >= ld->buf_len)
+	    {
+		if (!geojson_fill (ld))
+		    return -1;
+		continue;
+	    }
+	  c = ld->buf[ld->buf_pos];
+	  if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == 0x1e)
+	    {
+		/* whitespace and RFC 8142 record separators */
+		ld->buf_pos++;
+		continue;
+	    }
+	  return c;
+      }
+}
+
+static int
+geojson_expect (struct geojson_loader *ld, int expected)
+{
+/* consuming the next significant char */
+    if (geojson_peek (ld) != expected)
+	return geojson_syntax_error (ld);
+    ld->buf_pos++;
+    return 1;
+}
+
+static int
+geojson_separator (struct geojson_loader *ld, int closing, int *more)
+{
+/* consuming a ',' or the closing bracket of an array or object */
+    int c = geojson_peek (ld);
+    ld->buf_pos++;
+    if (c == ',')
+      {
+	  *more = 1;
+	  return 1;
+      }
+    if (c == closing)
+      {
+	  *more = 0;
+	  return 1;
+      }
+    ld->buf_pos--;
+    return geojson_syntax_error (ld);
+}
+
+static void
+geojson_utf8 (gaiaOutBufferPtr out, unsigned int cp)
+{
+/* appending an Unicode code point UTF-8 encoded */
+    char utf8[4];
+    int len;
+    if (cp < 0x80)
+      {
+	  utf8[0] = cp;
+	  len = 1;
+      }
+    else if (cp < 0x800)
+      {
+	  utf8[0] = 0xc0 | (cp >> 6);
+	  utf8[1] = 0x80 | (cp & 0x3f);
+	  len = 2;
+      }
+    else if (cp < 0x10000)
+      {
+	  utf8[0] = 0xe0 | (cp >> 12);
+	  utf8[1] = 0x80 | ((cp >> 6) & 0x3f);
+	  utf8[2] = 0x80 | (cp & 0x3f);
+	  len = 3;
+      }
+    else
+      {
+	  utf8[0] = 0xf0 | (cp >> 18);
+	  utf8[1] = 0x80 | ((cp >> 12) & 0x3f);
+	  utf8[2] = 0x80 | ((cp >> 6) & 0x3f);
+	  utf8[3] = 0x80 | (cp & 0x3f);
+	  len = 4;
+      }
+    gaiaAppendToOutBufferLen (out, utf8, len);
+}
+
+static int
+geojson_hex4 (struct geojson_loader *ld, unsigned int *cp)
+{
+/* decoding the four hex digits of an \u escape */
+    int i;
+    *cp = 0;
+    for (i = 0; i < 4; i++)
+      {
+	  int c;
+	  if (ld->buf_pos >= ld->buf_len && !geojson_fill (ld))
+	      return 0;
+	  c = ld->buf[ld->buf_pos++];
+	  *cp <<= 4;
+	  if (c >= '0' && c <= '9')
+	      *cp |= c - '0';
+	  else if (c >= 'a' && c <= 'f')
+	      *cp |= c - 'a' + 10;
+	  else if (c >= 'A' && c <= 'F')
+	      *cp |= c - 'A' + 10;
+	  else
+	      return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_string (struct geojson_loader *ld, gaiaOutBufferPtr out)
+{
+/* decoding a JSON string [the opening quote is expected next] */
+    if (!geojson_expect (ld, '"'))
+	return 0;
+    while (1)
+      {
+	  int start;
+	  int c;
+	  unsigned int cp;
+	  unsigned int low;
+	  if (ld->buf_pos >= ld->buf_len && !geojson_fill (ld))
+	      return geojson_syntax_error (ld);
+	  /* copying the whole run of plain chars at once */
+	  start = ld->buf_pos;
+	  while (ld->buf_pos < ld->buf_len)
+	    {
+		c = ld->buf[ld->buf_pos];
+		if (c == '"' || c == '\\')
+		    break;
+		ld->buf_pos++;
+	    }
+	  if (ld->buf_pos > start && out != NULL)
+	      gaiaAppendToOutBufferLen (out, (const char *) ld->buf + start,
+					ld->buf_pos - start);
+	  if (ld->buf_pos >= ld->buf_len)
+	      continue;
+	  c = ld->buf[ld->buf_pos++];
+	  if (c == '"')
+	      return 1;
+	  /* an escape sequence */
+	  if (ld->buf_pos >= ld->buf_len && !geojson_fill (ld))
+	      return geojson_syntax_error (ld);
+	  c = ld->buf[ld->buf_pos++];
+	  switch (c)
+	    {
+	    case '"':
+	    case '\\':
+	    case '/':
+		cp = c;
+		break;
+	    case 'b':
+		cp = '\b';
+		break;
+	    case 'f':
+		cp = '\f';
+		break;
+	    case 'n':
+		cp = '\n';
+		break;
+	    case 'r':
+		cp = '\r';
+		break;
+	    case 't':
+		cp = '\t';
+		break;
+	    case 'u':
+		if (!geojson_hex4 (ld, &cp))
+		    return geojson_syntax_error (ld);
+		if (cp >= 0xd800 && cp < 0xdc00)
+		  {
+		      /* an UTF-16 surrogate pair */
+		      if (ld->buf_pos >= ld->buf_len && !geojson_fill (ld))
+			  return geojson_syntax_error (ld);
+		      if (ld->buf[ld->buf_pos] != '\\')
+			  return geojson_syntax_error (ld);
+		      ld->buf_pos++;
+		      if (ld->buf_pos >= ld->buf_len && !geojson_fill (ld))
+			  return geojson_syntax_error (ld);
+		      if (ld->buf[ld->buf_pos] != 'u')
+			  return geojson_syntax_error (ld);
+		      ld->buf_pos++;
+		      if (!geojson_hex4 (ld, &low) || low < 0xdc00
+			  || low > 0xdfff)
+			  return geojson_syntax_error (ld);
+		      cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+		  }
+		break;
+	    default:
+		return geojson_syntax_error (ld);
+	    };
+	  if (out != NULL)
+	      geojson_utf8 (out, cp);
+      }
+}
+
+static int
+geojson_number (struct geojson_loader *ld, double *dbl_value,
+		sqlite3_int64 * int_value, int *is_int, gaiaOutBufferPtr raw)
+{
+/* parsing a JSON number [if RAW isn't NULL the literal will be copied] */
+    char buf[128];
+    char *end;
+    int len = 0;
+    int integer = 1;
+    int negative = 0;
+    int i;
+    sqlite3_uint64 acc = 0;
+    geojson_peek (ld);		/* skipping any leading whitespace */
+    while (1)
+      {
+	  int c;
+	  if (ld->buf_pos >= ld->buf_len && !geojson_fill (ld))
+	      break;
+	  c = ld->buf[ld->buf_pos];
+	  if (c >= '0' && c <= '9')
+	      ;
+	  else if (c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+	    {
+		if (c != '-' || len > 0)
+		    integer = 0;
+	    }
+	  else
+	      break;
+	  if (len >= (int) sizeof (buf) - 1)
+	      return geojson_syntax_error (ld);
+	  buf[len++] = c;
+	  ld->buf_pos++;
+      }
+    buf[len] = '\0';
+    if (len == 0)
+	return geojson_syntax_error (ld);
+    *dbl_value = strtod (buf, &end);
+    if (end != buf + len)
+	return geojson_syntax_error (ld);
+    if (raw != NULL)
+	gaiaAppendToOutBufferLen (raw, buf, len);
+    if (is_int == NULL)
+	return 1;
+    /* checking for a plain integer value fitting into 64 bits */
+    i = 0;
+    if (buf[0] == '-')
+      {
+	  negative = 1;
+	  i = 1;
+      }
+    if (len - i > 19)
+	integer = 0;
+    for (; integer && i < len; i++)
+	acc = (acc * 10) + (buf[i] - '0');
+    if (integer
+	&& acc > (negative ? ((sqlite3_uint64) 1 << 63)
+		  : (((sqlite3_uint64) 1 << 63) - 1)))
+	integer = 0;
+    *is_int = integer;
+    if (integer)
+	*int_value = negative ? (sqlite3_int64) (0 - acc) : (sqlite3_int64) acc;
+    return 1;
+}
+
+static int
+geojson_literal (struct geojson_loader *ld, int *value)
+{
+/* parsing one of the JSON literals true/false/null */
+    char buf[8];
+    int len = 0;
+    geojson_peek (ld);		/* skipping any leading whitespace */
+    while (1)
+      {
+	  int c;
+	  if (ld->buf_pos >= ld->buf_len && !geojson_fill (ld))
+	      break;
+	  c = ld->buf[ld->buf_pos];
+	  if (c < 'a' || c > 'z')
+	      break;
+	  if (len >= (int) sizeof (buf) - 1)
+	      return geojson_syntax_error (ld);
+	  buf[len++] = c;
+	  ld->buf_pos++;
+      }
+    buf[len] = '\0';
+    if (strcmp (buf, "true") == 0)
+	*value = 1;
+    else if (strcmp (buf, "false") == 0)
+	*value = 0;
+    else if (strcmp (buf, "null") == 0)
+	*value = -1;
+    else
+	return geojson_syntax_error (ld);
+    return 1;
+}
+
+static int
+geojson_copy_value (struct geojson_loader *ld, gaiaOutBufferPtr out,
+		    int depth)
+{
+/* 
+/ skipping any JSON value; if OUT isn't NULL the value will be
+/ copied as compact JSON text 
+*/
+    int c;
+    int more;
+    int value;
+    if (depth > GEOJSON_MAX_DEPTH)
+	return geojson_syntax_error (ld);
+    c = geojson_peek (ld);
+    if (c == '{' || c == '[')
+      {
+	  int closing = (c == '{') ? '}' : ']';
+	  char sep[1];
+	  sep[0] = c;
+	  ld->buf_pos++;
+	  if (out != NULL)
+	      gaiaAppendToOutBufferLen (out, sep, 1);
+	  if (geojson_peek (ld) == closing)
+	      more = 0;
+	  else
+	      more = 1;
+	  if (!more)
+	      ld->buf_pos++;
+	  while (more)
+	    {
+		if (c == '{')
+		  {
+		      if (!geojson_copy_value (ld, out, depth + 1))
+			  return 0;
+		      if (!geojson_expect (ld, ':'))
+			  return 0;
+		      if (out != NULL)
+			  gaiaAppendToOutBufferLen (out, ":", 1);
+		  }
+		if (!geojson_copy_value (ld, out, depth + 1))
+		    return 0;
+		if (!geojson_separator (ld, closing, &more))
+		    return 0;
+		if (more && out != NULL)
+		    gaiaAppendToOutBufferLen (out, ",", 1);
+	    }
+	  sep[0] = closing;
+	  if (out != NULL)
+	      gaiaAppendToOutBufferLen (out, sep, 1);
+	  return 1;
+      }
+    if (c == '"')
+      {
+	  if (out == NULL)
+	      return geojson_string (ld, NULL);
+	  /* re-encoding the string as a JSON literal */
+	  ld->key.WriteOffset = 0;
+	  if (!geojson_string (ld, &(ld->key)))
+	      return 0;
+	  geojson_escaped_text (out, (const unsigned char *) ld->key.Buffer,
+				ld->key.WriteOffset);
+	  return 1;
+      }
+    if (c == '-' || (c >= '0' && c <= '9'))
+      {
+	  double dbl;
+	  return geojson_number (ld, &dbl, NULL, NULL, out);
+      }
+    if (!geojson_literal (ld, &value))
+	return 0;
+    if (out != NULL)
+      {
+	  if (value < 0)
+	      gaiaAppendToOutBufferLen (out, "null", 4);
+	  else if (value)
+	      gaiaAppendToOutBufferLen (out, "true", 4);
+	  else
+	      gaiaAppendToOutBufferLen (out, "false", 5);
+      }
+    return 1;
+}
+
+static int
+geojson_key (struct geojson_loader *ld)
+{
+/* parsing an object member name and the following ':' */
+    ld->key.WriteOffset = 0;
+    if (!geojson_string (ld, &(ld->key)))
+	return 0;
+    gaiaAppendToOutBufferLen (&(ld->key), "", 0);	/* NULL-terminating */
+    if (ld->key.Error)
+	return 0;
+    return geojson_expect (ld, ':');
+}
+
+static int
+geojson_value (struct geojson_loader *ld, struct geojson_value *val)
+{
+/* parsing a property value of the current Feature */
+    int c = geojson_peek (ld);
+    int value;
+    int is_int;
+    val->row = ld->row;
+    if (c == '"' || c == '{' || c == '[')
+      {
+	  /* strings, nested objects and arrays are all stored as TEXT */
+	  val->type = SQLITE_TEXT;
+	  val->txt_offset = ld->text.WriteOffset;
+	  if (c == '"')
+	    {
+		if (!geojson_string (ld, &(ld->text)))
+		    return 0;
+	    }
+	  else
+	    {
+		if (!geojson_copy_value (ld, &(ld->text), 0))
+		    return 0;
+	    }
+	  val->txt_len = ld->text.WriteOffset - val->txt_offset;
+	  return 1;
+      }
+    if (c == '-' || (c >= '0' && c <= '9'))
+      {
+	  if (!geojson_number
+	      (ld, &(val->dbl_value), &(val->int_value), &is_int, NULL))
+	      return 0;
+	  val->type = is_int ? SQLITE_INTEGER : SQLITE_FLOAT;
+	  return 1;
+      }
+    if (!geojson_literal (ld, &value))
+	return 0;
+    if (value < 0)
+	val->type = SQLITE_NULL;
+    else
+      {
+	  /* booleans are stored as INTEGER 1/0 */
+	  val->type = SQLITE_INTEGER;
+	  val->int_value = value;
+      }
+    return 1;
+}
+
+static unsigned int
+geojson_hash (const char *key, int len)
+{
+/* FNV-1a hash of a property name */
+    unsigned int hash = 2166136261u;
+    int i;
+    for (i = 0; i < len; i++)
+      {
+	  hash ^= (unsigned char) key[i];
+	  hash *= 16777619u;
+      }
+    return hash % GEOJSON_HASH_BUCKETS;
+}
+
+static int
+geojson_name_in_use (struct geojson_loader *ld, const char *name)
+{
+/* checking if some column name is already in use */
+    int i;
+    if (strcasecmp (name, "PK_UID") == 0)
+	return 1;
+    if (strcasecmp (name, ld->geom_column) == 0)
+	return 1;
+    for (i = 0; i < ld->n_columns; i++)
+      {
+	  if (strcasecmp (name, ld->columns[i].name) == 0)
+	      return 1;
+      }
+    return 0;
+}
+
+static int
+geojson_column (struct geojson_loader *ld, const char *key, int len)
+{
+/* returning the index of the column mapping a property name */
+    unsigned int hash = geojson_hash (key, len);
+    int idx = ld->buckets[hash];
+    struct geojson_column *col;
+    char *name;
+    while (idx >= 0)
+      {
+	  col = ld->columns + idx;
+	  if (col->key_len == len && memcmp (col->key, key, len) == 0)
+	      return idx;
+	  idx = col->next_hash;
+      }
+    /* a new property: adding one more column */
+    if (ld->n_columns >= ld->max_columns)
+      {
+	  struct geojson_column *columns;
+	  int max = ld->max_columns ? ld->max_columns * 2 : 64;
+	  columns = realloc (ld->columns, sizeof (struct geojson_column) * max);
+	  if (columns == NULL)
+	      return -1;
+	  ld->columns = columns;
+	  ld->max_columns = max;
+      }
+    if (len > 0 && memchr (key, '\0', len) == NULL
+	&& !geojson_name_in_use (ld, key))
+      {
+	  name = malloc (len + 1);
+	  if (name == NULL)
+	      return -1;
+	  memcpy (name, key, len + 1);
+      }
+    else
+      {
+	  /* empty or duplicated property name */
+	  char *dummy = NULL;
+	  while (1)
+	    {
+		if (dummy)
+		    sqlite3_free (dummy);
+		dummy = sqlite3_mprintf ("COL_%d", ++(ld->seed));
+		if (!geojson_name_in_use (ld, dummy))
+		    break;
+	    }
+	  name = malloc (strlen (dummy) + 1);
+	  if (name != NULL)
+	      strcpy (name, dummy);
+	  sqlite3_free (dummy);
+	  if (name == NULL)
+	      return -1;
+      }
+    col = ld->columns + ld->n_columns;
+    col->key = malloc (len + 1);
+    if (col->key == NULL)
+      {
+	  free (name);
+	  return -1;
+      }
+    memcpy (col->key, key, len);
+    col->key[len] = '\0';
+    col->key_len = len;
+    col->name = name;
+    col->n_int = 0;
+    col->n_dbl = 0;
+    col->n_txt = 0;
+    col->value.row = -1;
+    col->next_hash = ld->buckets[hash];
+    ld->buckets[hash] = ld->n_columns;
+    return ld->n_columns++;
+}
+
+static int
+geojson_properties (struct geojson_loader *ld)
+{
+/* parsing the "properties" member of a Feature */
+    int more;
+    int idx;
+    int value;
+    if (geojson_peek (ld) == 'n')
+	return geojson_literal (ld, &value);
+    if (!geojson_expect (ld, '{'))
+	return 0;
+    if (geojson_peek (ld) == '}')
+      {
+	  ld->buf_pos++;
+	  return 1;
+      }
+    more = 1;
+    while (more)
+      {
+	  if (!geojson_key (ld))
+	      return 0;
+	  idx = geojson_column (ld, ld->key.Buffer, ld->key.WriteOffset);
+	  if (idx < 0)
+	      return 0;
+	  if (!geojson_value (ld, &(ld->columns[idx].value)))
+	      return 0;
+	  if (!geojson_separator (ld, '}', &more))
+	      return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_coords_grow (struct geojson_coords *crd, int points, int counts)
+{
+/* ensuring room for one more position or nested array */
+    if (points && crd->n_points >= crd->max_points)
+      {
+	  int max = crd->max_points ? crd->max_points * 2 : 1024;
+	  double *xyz = realloc (crd->xyz, sizeof (double) * 3 * max);
+	  if (xyz == NULL)
+	      return 0;
+	  crd->xyz = xyz;
+	  crd->max_points = max;
+      }
+    if (counts && crd->n_counts >= crd->max_counts)
+      {
+	  int max = crd->max_counts ? crd->max_counts * 2 : 256;
+	  int *cnt = realloc (crd->counts, sizeof (int) * max);
+	  if (cnt == NULL)
+	      return 0;
+	  crd->counts = cnt;
+	  crd->max_counts = max;
+      }
+    return 1;
+}
+
+static int
+geojson_coords (struct geojson_loader *ld, int level)
+{
+/* parsing the (nested) arrays of positions of a Geometry */
+    struct geojson_coords *crd = &(ld->coords);
+    int c;
+    int more;
+    int slot;
+    int count = 0;
+    if (level > GEOJSON_MAX_DEPTH)
+	return geojson_syntax_error (ld);
+    if (!geojson_expect (ld, '['))
+	return 0;
+    c = geojson_peek (ld);
+    if (c == '-' || (c >= '0' && c <= '9'))
+      {
+	  /* a single position: coordinates are parsed in place */
+	  double *xyz;
+	  double extra;
+	  if (!geojson_coords_grow (crd, 1, 0))
+	      return 0;
+	  if (crd->level >= 0 && crd->level != level)
+	      crd->invalid = 1;
+	  crd->level = level;
+	  xyz = crd->xyz + (crd->n_points * 3);
+	  xyz[2] = 0.0;
+	  more = 1;
+	  while (more)
+	    {
+		if (!geojson_number
+		    (ld, (count < 3) ? xyz + count : &extra, NULL, NULL, NULL))
+		    return 0;
+		count++;
+		if (!geojson_separator (ld, ']', &more))
+		    return 0;
+	    }
+	  if (count < 2)
+	      crd->invalid = 1;
+	  if (count > 2)
+	      crd->has_z = 1;
+	  crd->n_points++;
+	  return 1;
+      }
+    /* an array of nested arrays */
+    if (!geojson_coords_grow (crd, 0, 1))
+	return 0;
+    slot = crd->n_counts++;
+    if (c == ']')
+	more = 0;
+    else
+	more = 1;
+    if (!more)
+	ld->buf_pos++;
+    while (more)
+      {
+	  if (!geojson_coords (ld, level + 1))
+	      return 0;
+	  count++;
+	  if (!geojson_separator (ld, ']', &more))
+	      return 0;
+      }
+    crd->counts[slot] = count;
+    return 1;
+}
+
+static int
+geojson_type (const char *name)
+{
+/* mapping a GeoJSON Geometry type name */
+    if (strcmp (name, "Point") == 0)
+	return GAIA_POINT;
+    if (strcmp (name, "LineString") == 0)
+	return GAIA_LINESTRING;
+    if (strcmp (name, "Polygon") == 0)
+	return GAIA_POLYGON;
+    if (strcmp (name, "MultiPoint") == 0)
+	return GAIA_MULTIPOINT;
+    if (strcmp (name, "MultiLineString") == 0)
+	return GAIA_MULTILINESTRING;
+    if (strcmp (name, "MultiPolygon") == 0)
+	return GAIA_MULTIPOLYGON;
+    if (strcmp (name, "GeometryCollection") == 0)
+	return GAIA_GEOMETRYCOLLECTION;
+    return -1;
+}
+
+static int
+geojson_next_count (struct geojson_coords *crd, int *ic, int *pt, int min)
+{
+/* fetching the items of the next nested array of positions */
+    int count;
+    if (*ic >= crd->n_counts)
+	return -1;
+    count = crd->counts[(*ic)++];
+    if (count < min || *pt + count > crd->n_points)
+	return -1;
+    return count;
+}
+
+static int
+geojson_build_polygon (gaiaGeomCollPtr geom, struct geojson_coords *crd,
+		       int *ic, int *pt)
+{
+/* adding a Polygon to the Geometry */
+    int rings;
+    int ir;
+    int iv;
+    int count;
+    gaiaPolygonPtr pg = NULL;
+    gaiaRingPtr rng;
+    double *xyz;
+    if (*ic >= crd->n_counts)
+	return 0;
+    rings = crd->counts[(*ic)++];
+    for (ir = 0; ir < rings; ir++)
+      {
+	  count = geojson_next_count (crd, ic, pt, 4);
+	  if (count < 0)
+	      return 0;
+	  if (ir == 0)
+	    {
+		pg = gaiaAddPolygonToGeomColl (geom, count, rings - 1);
+		rng = pg->Exterior;
+	    }
+	  else
+	      rng = gaiaAddInteriorRing (pg, ir - 1, count);
+	  xyz = crd->xyz + (*pt * 3);
+	  for (iv = 0; iv < count; iv++, xyz += 3)
+	    {
+		if (geom->DimensionModel == GAIA_XY_Z)
+		  {
+		      gaiaSetPointXYZ (rng->Coords, iv, xyz[0], xyz[1], xyz[2]);
+		  }
+		else
+		  {
+		      gaiaSetPoint (rng->Coords, iv, xyz[0], xyz[1]);
+		  }
+	    }
+	  *pt += count;
+      }
+    return 1;
+}
+
+static int
+geojson_build_linestring (gaiaGeomCollPtr geom, struct geojson_coords *crd,
+			  int *ic, int *pt)
+{
+/* adding a Linestring to the Geometry */
+    int iv;
+    int count = geojson_next_count (crd, ic, pt, 2);
+    gaiaLinestringPtr ln;
+    double *xyz;
+    if (count < 0)
+	return 0;
+    ln = gaiaAddLinestringToGeomColl (geom, count);
+    xyz = crd->xyz + (*pt * 3);
+    for (iv = 0; iv < count; iv++, xyz += 3)
+      {
+	  if (geom->DimensionModel == GAIA_XY_Z)
+	    {
+		gaiaSetPointXYZ (ln->Coords, iv, xyz[0], xyz[1], xyz[2]);
+	    }
+	  else
+	    {
+		gaiaSetPoint (ln->Coords, iv, xyz[0], xyz[1]);
+	    }
+      }
+    *pt += count;
+    return 1;
+}
+
+static void
+geojson_build_point (gaiaGeomCollPtr geom, double *xyz)
+{
+/* adding a Point to the Geometry */
+    if (geom->DimensionModel == GAIA_XY_Z)
+	gaiaAddPointToGeomCollXYZ (geom, xyz[0], xyz[1], xyz[2]);
+    else
+	gaiaAddPointToGeomColl (geom, xyz[0], xyz[1]);
+}
+
+static int
+geojson_build (struct geojson_loader *ld, int type)
+{
+/* adding the parsed "coordinates" to the Geometry of the Feature */
+    struct geojson_coords *crd = &(ld->coords);
+    int level;
+    int ic = 0;
+    int pt = 0;
+    int i;
+    int count;
+    switch (type)
+      {
+      case GAIA_POINT:
+	  level = 0;
+	  break;
+      case GAIA_LINESTRING:
+      case GAIA_MULTIPOINT:
+	  level = 1;
+	  break;
+      case GAIA_POLYGON:
+      case GAIA_MULTILINESTRING:
+	  level = 2;
+	  break;
+      case GAIA_MULTIPOLYGON:
+	  level = 3;
+	  break;
+      default:
+	  return 0;
+      };
+    if (crd->invalid || (crd->level >= 0 && crd->level != level))
+	return 0;
+    if (crd->n_points == 0)
+	return 1;		/* an empty Geometry */
+    if (crd->has_z)
+	ld->feat_z = 1;
+    if (ld->sampling)
+	return 1;
+
+    if (ld->geom == NULL)
+      {
+	  if (crd->has_z)
+	      ld->geom = gaiaAllocGeomCollXYZ ();
+	  else
+	      ld->geom = gaiaAllocGeomColl ();
+      }
+    else if (crd->has_z && ld->geom->DimensionModel != GAIA_XY_Z)
+      {
+	  /* some previous item of the GeometryCollection was 2D */
+	  gaiaGeomCollPtr geom3d = gaiaCastGeomCollToXYZ (ld->geom);
+	  gaiaFreeGeomColl (ld->geom);
+	  ld->geom = geom3d;
+      }
+    switch (type)
+      {
+      case GAIA_POINT:
+	  geojson_build_point (ld->geom, crd->xyz);
+	  pt = 1;
+	  break;
+      case GAIA_MULTIPOINT:
+	  count = geojson_next_count (crd, &ic, &pt, 0);
+	  if (count < 0)
+	      return 0;
+	  for (i = 0; i < count; i++, pt++)
+	      geojson_build_point (ld->geom, crd->xyz + (pt * 3));
+	  break;
+      case GAIA_LINESTRING:
+	  if (!geojson_build_linestring (ld->geom, crd, &ic, &pt))
+	      return 0;
+	  break;
+      case GAIA_MULTILINESTRING:
+	  if (ic >= crd->n_counts)
+	      return 0;
+	  count = crd->counts[ic++];
+	  for (i = 0; i < count; i++)
+	    {
+		if (!geojson_build_linestring (ld->geom, crd, &ic, &pt))
+		    return 0;
+	    }
+	  break;
+      case GAIA_POLYGON:
+	  if (!geojson_build_polygon (ld->geom, crd, &ic, &pt))
+	      return 0;
+	  break;
+      case GAIA_MULTIPOLYGON:
+	  if (ic >= crd->n_counts)
+	      return 0;
+	  count = crd->counts[ic++];
+	  for (i = 0; i < count; i++)
+	    {
+		if (!geojson_build_polygon (ld->geom, crd, &ic, &pt))
+		    return 0;
+	    }
+	  break;
+      };
+    if (ic != crd->n_counts || pt != crd->n_points)
+	return 0;
+    return 1;
+}
+
+static void
+geojson_geometry_done (struct geojson_loader *ld, int type, int level,
+		       int has_coords, int has_items)
+{
+/* completing a Geometry once its object has been fully parsed */
+    if (type < 0 || (has_coords && has_items))
+	ld->feat_invalid = 1;
+    else if (type == GAIA_GEOMETRYCOLLECTION)
+      {
+	  if (has_coords)
+	      ld->feat_invalid = 1;
+      }
+    else if (!has_coords || !geojson_build (ld, type))
+	ld->feat_invalid = 1;
+    if (level == 0)
+	ld->feat_type = type;
+}
+
+static int
+geojson_type_member (struct geojson_loader *ld, char *type_name, int size)
+{
+/* parsing a "type" member */
+    ld->key.WriteOffset = 0;
+    if (!geojson_string (ld, &(ld->key)))
+	return 0;
+    gaiaAppendToOutBufferLen (&(ld->key), "", 0);
+    if (ld->key.WriteOffset < size)
+	strcpy (type_name, ld->key.Buffer);
+    else
+	*type_name = '\0';
+    return 1;
+}
+
+static int
+geojson_coordinates (struct geojson_loader *ld)
+{
+/* parsing a "coordinates" member */
+    struct geojson_coords *crd = &(ld->coords);
+    crd->n_points = 0;
+    crd->n_counts = 0;
+    crd->level = -1;
+    crd->has_z = 0;
+    crd->invalid = 0;
+    return geojson_coords (ld, 0);
+}
+
+static int geojson_geometry (struct geojson_loader *ld, int level);
+
+static int
+geojson_geometries (struct geojson_loader *ld, int level)
+{
+/* parsing the "geometries" member of a GeometryCollection */
+    int more;
+    if (!geojson_expect (ld, '['))
+	return 0;
+    more = (geojson_peek (ld) != ']');
+    if (!more)
+	ld->buf_pos++;
+    while (more)
+      {
+	  if (!geojson_geometry (ld, level + 1))
+	      return 0;
+	  if (!geojson_separator (ld, ']', &more))
+	      return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_geometry (struct geojson_loader *ld, int level)
+{
+/* parsing a GeoJSON Geometry object */
+    char type_name[32];
+    int has_coords = 0;
+    int has_items = 0;
+    int more;
+    int value;
+    if (level > GEOJSON_MAX_DEPTH)
+	return geojson_syntax_error (ld);
+    if (geojson_peek (ld) == 'n')
+      {
+	  /* a NULL Geometry */
+	  if (!geojson_literal (ld, &value))
+	      return 0;
+	  if (value >= 0)
+	      return geojson_syntax_error (ld);
+	  if (level > 0)
+	      ld->feat_invalid = 1;
+	  return 1;
+      }
+    if (!geojson_expect (ld, '{'))
+	return 0;
+    *type_name = '\0';
+    more = (geojson_peek (ld) != '}');
+    if (!more)
+	ld->buf_pos++;
+    while (more)
+      {
+	  if (!geojson_key (ld))
+	      return 0;
+	  if (strcmp (ld->key.Buffer, "type") == 0)
+	    {
+		if (!geojson_type_member (ld, type_name, sizeof (type_name)))
+		    return 0;
+	    }
+	  else if (strcmp (ld->key.Buffer, "coordinates") == 0)
+	    {
+		if (!geojson_coordinates (ld))
+		    return 0;
+		has_coords = 1;
+	    }
+	  else if (strcmp (ld->key.Buffer, "geometries") == 0)
+	    {
+		if (!geojson_geometries (ld, level))
+		    return 0;
+		has_items = 1;
+	    }
+	  else if (!geojson_copy_value (ld, NULL, 0))
+	      return 0;
+	  if (!geojson_separator (ld, '}', &more))
+	      return 0;
+      }
+    geojson_geometry_done (ld, geojson_type (type_name), level, has_coords,
+			   has_items);
+    return 1;
+}
+
+static int
+geojson_crs_name (struct geojson_loader *ld)
+{
+/* parsing the "properties" of a named "crs": EPSG codes only */
+    int more;
+    const char *name;
+    const char *p;
+    if (!geojson_expect (ld, '{'))
+	return 0;
+    more = (geojson_peek (ld) != '}');
+    if (!more)
+	ld->buf_pos++;
+    while (more)
+      {
+	  if (!geojson_key (ld))
+	      return 0;
+	  if (strcmp (ld->key.Buffer, "name") == 0
+	      && geojson_peek (ld) == '"')
+	    {
+		ld->key.WriteOffset = 0;
+		if (!geojson_string (ld, &(ld->key)))
+		    return 0;
+		gaiaAppendToOutBufferLen (&(ld->key), "", 0);
+		name = ld->key.Buffer;
+		if (strstr (name, "CRS84") != NULL)
+		    ld->crs_srid = 4326;
+		else if ((p = strstr (name, "EPSG:")) != NULL)
+		  {
+		      /* "EPSG:4326" or "urn:ogc:def:crs:EPSG::4326" */
+		      p += 5;
+		      while (*p == ':')
+			  p++;
+		      if (*p >= '0' && *p <= '9')
+			  ld->crs_srid = atoi (p);
+		  }
+	    }
+	  else if (!geojson_copy_value (ld, NULL, 0))
+	      return 0;
+	  if (!geojson_separator (ld, '}', &more))
+	      return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_crs (struct geojson_loader *ld)
+{
+/* parsing a (legacy) "crs" member */
+    int more;
+    if (geojson_peek (ld) != '{')
+	return geojson_copy_value (ld, NULL, 0);
+    ld->buf_pos++;
+    more = (geojson_peek (ld) != '}');
+    if (!more)
+	ld->buf_pos++;
+    while (more)
+      {
+	  if (!geojson_key (ld))
+	      return 0;
+	  if (strcmp (ld->key.Buffer, "properties") == 0
+	      && geojson_peek (ld) == '{')
+	    {
+		if (!geojson_crs_name (ld))
+		    return 0;
+	    }
+	  else if (!geojson_copy_value (ld, NULL, 0))
+	      return 0;
+	  if (!geojson_separator (ld, '}', &more))
+	      return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_merge_types (int type1, int type2)
+{
+/* the narrowest Geometry type able to store both types */
+    if (type1 == type2)
+	return type1;
+    if (type1 == GAIA_POINT || type1 == GAIA_MULTIPOINT)
+      {
+	  if (type2 == GAIA_POINT || type2 == GAIA_MULTIPOINT)
+	      return GAIA_MULTIPOINT;
+      }
+    if (type1 == GAIA_LINESTRING || type1 == GAIA_MULTILINESTRING)
+      {
+	  if (type2 == GAIA_LINESTRING || type2 == GAIA_MULTILINESTRING)
+	      return GAIA_MULTILINESTRING;
+      }
+    if (type1 == GAIA_POLYGON || type1 == GAIA_MULTIPOLYGON)
+      {
+	  if (type2 == GAIA_POLYGON || type2 == GAIA_MULTIPOLYGON)
+	      return GAIA_MULTIPOLYGON;
+      }
+    return GAIA_UNKNOWN;
+}
+
+static const char *
+geojson_type_name (int type)
+{
+/* the Spatial Metadata name of some Geometry type */
+    switch (type)
+      {
+      case GAIA_POINT:
+	  return "POINT";
+      case GAIA_LINESTRING:
+	  return "LINESTRING";
+      case GAIA_POLYGON:
+	  return "POLYGON";
+      case GAIA_MULTIPOINT:
+	  return "MULTIPOINT";
+      case GAIA_MULTILINESTRING:
+	  return "MULTILINESTRING";
+      case GAIA_MULTIPOLYGON:
+	  return "MULTIPOLYGON";
+      case GAIA_GEOMETRYCOLLECTION:
+	  return "GEOMETRYCOLLECTION";
+      };
+    return "GEOMETRY";
+}
+
+static int
+geojson_exec (struct geojson_loader *ld, const char *sql, int verbose)
+{
+/* executing some SQL statement */
+    char *errMsg = NULL;
+    int ret;
+    if (verbose)
+	spatialite_e ("%s;\n", sql);
+    ret = sqlite3_exec (ld->sqlite, sql, NULL, 0, &errMsg);
+    if (ret != SQLITE_OK)
+      {
+	  if (ld->error == NULL)
+	      ld->error = sqlite3_mprintf ("%s", errMsg);
+	  sqlite3_free (errMsg);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_promote (struct geojson_loader *ld, int type, int has_z)
+{
+/*
+/ promoting the Geometry column as soon as some Feature requires it:
+/ the Spatial Metadata and triggers are updated, and all rows 
+/ already inserted are cast to the wider type
+*/
+    char *sql;
+    char *expr;
+    char *prev;
+    char *xtable;
+    char *xcolumn;
+    int ret;
+    if (ld->metadata_version == 3)
+	sql = sqlite3_mprintf ("UPDATE geometry_columns SET "
+			       "geometry_type = %d, coord_dimension = %d "
+			       "WHERE Lower(f_table_name) = Lower(%Q) AND "
+			       "Lower(f_geometry_column) = Lower(%Q)",
+			       type + (has_z ? 1000 : 0), has_z ? 3 : 2,
+			       ld->table, ld->geom_column);
+    else
+	sql = sqlite3_mprintf ("UPDATE geometry_columns SET "
+			       "type = %Q, coord_dimension = %Q "
+			       "WHERE Lower(f_table_name) = Lower(%Q) AND "
+			       "Lower(f_geometry_column) = Lower(%Q)",
+			       geojson_type_name (type), has_z ? "XYZ" : "XY",
+			       ld->table, ld->geom_column);
+    ret = geojson_exec (ld, sql, 0);
+    sqlite3_free (sql);
+    if (!ret)
+	return 0;
+    updateGeometryTriggers (ld->sqlite, ld->table, ld->geom_column);
+    if (ld->rows > 0
+	&& ((type != ld->geom_type && type != GAIA_UNKNOWN)
+	    || has_z != ld->has_z))
+      {
+	  /* casting all rows already inserted */
+	  xtable = gaiaDoubleQuotedSql (ld->table);
+	  xcolumn = gaiaDoubleQuotedSql (ld->geom_column);
+	  expr = sqlite3_mprintf ("\"%s\"", xcolumn);
+	  if (type != ld->geom_type && type != GAIA_UNKNOWN)
+	    {
+		prev = expr;
+		expr = sqlite3_mprintf ("CastToMulti(%s)", prev);
+		sqlite3_free (prev);
+	    }
+	  if (has_z != ld->has_z)
+	    {
+		prev = expr;
+		expr = sqlite3_mprintf ("CastToXYZ(%s)", prev);
+		sqlite3_free (prev);
+	    }
+	  sql = sqlite3_mprintf ("UPDATE \"%s\" SET \"%s\" = %s", xtable,
+				 xcolumn, expr);
+	  free (xtable);
+	  free (xcolumn);
+	  sqlite3_free (expr);
+	  ret = geojson_exec (ld, sql, 0);
+	  sqlite3_free (sql);
+	  if (!ret)
+	      return 0;
+      }
+    ld->geom_type = type;
+    ld->has_z = has_z;
+    return 1;
+}
+
+static const char *
+geojson_column_type (struct geojson_column *col)
+{
+/* the SQL type of a column, as inferred by sampling */
+    if (col->n_txt > 0)
+	return "TEXT";
+    if (col->n_dbl > 0)
+	return "DOUBLE";
+    if (col->n_int > 0)
+	return "INTEGER";
+    return "TEXT";
+}
+
+static int
+geojson_prepare (struct geojson_loader *ld)
+{
+/* preparing the INSERT INTO parametrized statement */
+    gaiaOutBuffer sql_statement;
+    char *sql;
+    char *xname;
+    int i;
+    int ret;
+    if (ld->stmt != NULL)
+	sqlite3_finalize (ld->stmt);
+    ld->stmt = NULL;
+    gaiaOutBufferInitialize (&sql_statement);
+    xname = gaiaDoubleQuotedSql (ld->table);
+    sql = sqlite3_mprintf ("INSERT INTO \"%s\" (", xname);
+    free (xname);
+    gaiaAppendToOutBuffer (&sql_statement, sql);
+    sqlite3_free (sql);
+    for (i = 0; i < ld->n_created; i++)
+      {
+	  xname = gaiaDoubleQuotedSql (ld->columns[i].name);
+	  sql = sqlite3_mprintf ("\"%s\", ", xname);
+	  free (xname);
+	  gaiaAppendToOutBuffer (&sql_statement, sql);
+	  sqlite3_free (sql);
+      }
+    xname = gaiaDoubleQuotedSql (ld->geom_column);
+    sql = sqlite3_mprintf ("\"%s\") VALUES (", xname);
+    free (xname);
+    gaiaAppendToOutBuffer (&sql_statement, sql);
+    sqlite3_free (sql);
+    for (i = 0; i < ld->n_created; i++)
+	gaiaAppendToOutBuffer (&sql_statement, "?, ");
+    gaiaAppendToOutBuffer (&sql_statement, "?)");
+    if (sql_statement.Error == 0 && sql_statement.Buffer != NULL)
+	ret =
+	    sqlite3_prepare_v2 (ld->sqlite, sql_statement.Buffer,
+				strlen (sql_statement.Buffer), &(ld->stmt),
+				NULL);
+    else
+	ret = SQLITE_ERROR;
+    gaiaOutBufferReset (&sql_statement);
+    if (ret != SQLITE_OK)
+      {
+	  if (ld->error == NULL)
+	      ld->error = sqlite3_mprintf ("%s", sqlite3_errmsg (ld->sqlite));
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_create_table (struct geojson_loader *ld, int verbose)
+{
+/* creating the output table */
+    gaiaOutBuffer sql_statement;
+    char *sql;
+    char *xname;
+    int i;
+    int ret;
+    sqlite3_stmt *stmt;
+    gaiaOutBufferInitialize (&sql_statement);
+    xname = gaiaDoubleQuotedSql (ld->table);
+    sql = sqlite3_mprintf ("CREATE TABLE \"%s\" (\n"
+			   "PK_UID INTEGER PRIMARY KEY AUTOINCREMENT", xname);
+    free (xname);
+    gaiaAppendToOutBuffer (&sql_statement, sql);
+    sqlite3_free (sql);
+    for (i = 0; i < ld->n_columns; i++)
+      {
+	  struct geojson_column *col = ld->columns + i;
+	  xname = gaiaDoubleQuotedSql (col->name);
+	  sql = sqlite3_mprintf (",\n\"%s\" %s", xname,
+				 geojson_column_type (col));
+	  free (xname);
+	  gaiaAppendToOutBuffer (&sql_statement, sql);
+	  sqlite3_free (sql);
+      }
+    if (!ld->metadata_version)
+      {
+	  /* no Spatial Metadata: a plain BLOB column */
+	  xname = gaiaDoubleQuotedSql (ld->geom_column);
+	  sql = sqlite3_mprintf (",\n\"%s\" BLOB", xname);
+	  free (xname);
+	  gaiaAppendToOutBuffer (&sql_statement, sql);
+	  sqlite3_free (sql);
+      }
+    gaiaAppendToOutBuffer (&sql_statement, ")");
+    if (sql_statement.Error || sql_statement.Buffer == NULL)
+	ret = 0;
+    else
+	ret = geojson_exec (ld, sql_statement.Buffer, verbose);
+    gaiaOutBufferReset (&sql_statement);
+    if (!ret)
+	return 0;
+    ld->n_created = ld->n_columns;
+    if (!ld->metadata_version)
+	return 1;
+
+    /* creating the Geometry column */
+    sql = sqlite3_mprintf ("SELECT AddGeometryColumn(%Q, %Q, %d, %Q, %Q)",
+			   ld->table, ld->geom_column, ld->srid,
+			   geojson_type_name (ld->geom_type),
+			   ld->has_z ? "XYZ" : "XY");
+    if (verbose)
+	spatialite_e ("%s;\n", sql);
+    ret = sqlite3_prepare_v2 (ld->sqlite, sql, strlen (sql), &stmt, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+      {
+	  ld->error = sqlite3_mprintf ("%s", sqlite3_errmsg (ld->sqlite));
+	  return 0;
+      }
+    ret = sqlite3_step (stmt);
+    if (ret == SQLITE_ROW)
+	ret = sqlite3_column_int (stmt, 0);
+    else
+	ret = 0;
+    sqlite3_finalize (stmt);
+    if (!ret)
+      {
+	  ld->error =
+	      sqlite3_mprintf ("unable to create the Geometry column \"%s\"",
+			       ld->geom_column);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+geojson_add_columns (struct geojson_loader *ld)
+{
+/* adding to the table the properties first found after sampling */
+    char *sql;
+    char *xtable;
+    char *xname;
+    const char *type;
+    int ret;
+    while (ld->n_created < ld->n_columns)
+      {
+	  struct geojson_column *col = ld->columns + ld->n_created;
+	  switch (col->value.type)
+	    {
+	    case SQLITE_INTEGER:
+		type = "INTEGER";
+		break;
+	    case SQLITE_FLOAT:
+		type = "DOUBLE";
+		break;
+	    default:
+		type = "TEXT";
+		break;
+	    };
+	  xtable = gaiaDoubleQuotedSql (ld->table);
+	  xname = gaiaDoubleQuotedSql (col->name);
+	  sql = sqlite3_mprintf ("ALTER TABLE \"%s\" ADD COLUMN \"%s\" %s",
+				 xtable, xname, type);
+	  free (xtable);
+	  free (xname);
+	  ret = geojson_exec (ld, sql, 0);
+	  sqlite3_free (sql);
+	  if (!ret)
+	      return 0;
+	  ld->n_created++;
+      }
+    return geojson_prepare (ld);
+}
+
+static void
+geojson_feature_begin (struct geojson_loader *ld)
+{
+/* resetting the current Feature */
+    ld->row++;
+    ld->text.WriteOffset = 0;
+    ld->id.row = -1;
+    ld->feat_type = -1;
+    ld->feat_z = 0;
+    ld->feat_invalid = 0;
+    if (ld->geom != NULL)
+	gaiaFreeGeomColl (ld->geom);
+    ld->geom = NULL;
+}
+
+static void
+geojson_sample (struct geojson_loader *ld)
+{
+/* updating the table layout by sampling the current Feature */
+    int i;
+    for (i = 0; i < ld->n_columns; i++)
+      {
+	  struct geojson_column *col = ld->columns + i;
+	  if (col->value.row != ld->row)
+	      continue;
+	  switch (col->value.type)
+	    {
+	    case SQLITE_INTEGER:
+		col->n_int++;
+		break;
+	    case SQLITE_FLOAT:
+		col->n_dbl++;
+		break;
+	    case SQLITE_TEXT:
+		col->n_txt++;
+		break;
+	    };
+      }
+    if (!ld->feat_invalid && ld->feat_type >= 0)
+      {
+	  if (ld->geom_type < 0)
+	      ld->geom_type = ld->feat_type;
+	  else
+	      ld->geom_type =
+		  geojson_merge_types (ld->geom_type, ld->feat_type);
+	  if (ld->feat_z)
+	      ld->has_z = 1;
+      }
+    ld->sampled++;
+    if (ld->sampled >= GEOJSON_SAMPLE_SIZE)
+	ld->stop = 1;
+}
+
+static int
+geojson_feature_done (struct geojson_loader *ld)
+{
+/* sampling or inserting the current Feature */
+    int i;
+    int ret;
+    int type;
+    int has_z;
+    unsigned char *blob;
+    int blob_size;
+    if (ld->id.row == ld->row)
+      {
+	  /* the Feature "id", unless some "id" property already exists */
+	  int idx = geojson_column (ld, "id", 2);
+	  if (idx < 0)
+	      return 0;
+	  if (ld->columns[idx].value.row != ld->row)
+	      ld->columns[idx].value = ld->id;
+      }
+    if (ld->sampling)
+      {
+	  geojson_sample (ld);
+	  return 1;
+      }
+
+    if (ld->n_created < ld->n_columns)
+      {
+	  if (!geojson_add_columns (ld))
+	      return 0;
+      }
+    for (i = 0; i < ld->n_created; i++)
+      {
+	  struct geojson_value *val = &(ld->columns[i].value);
+	  if (val->row != ld->row)
+	    {
+		sqlite3_bind_null (ld->stmt, i + 1);
+		continue;
+	    }
+	  switch (val->type)
+	    {
+	    case SQLITE_INTEGER:
+		sqlite3_bind_int64 (ld->stmt, i + 1, val->int_value);
+		break;
+	    case SQLITE_FLOAT:
+		sqlite3_bind_double (ld->stmt, i + 1, val->dbl_value);
+		break;
+	    case SQLITE_TEXT:
+		if (val->txt_len == 0)
+		    sqlite3_bind_text (ld->stmt, i + 1, "", 0, SQLITE_STATIC);
+		else
+		    sqlite3_bind_text (ld->stmt, i + 1,
+				       ld->text.Buffer + val->txt_offset,
+				       val->txt_len, SQLITE_STATIC);
+		break;
+	    default:
+		sqlite3_bind_null (ld->stmt, i + 1);
+		break;
+	    };
+      }
+    if (ld->feat_invalid)
+	ld->invalid_geoms++;
+    if (ld->feat_invalid || ld->geom == NULL)
+	sqlite3_bind_null (ld->stmt, ld->n_created + 1);
+    else
+      {
+	  if (ld->metadata_version)
+	    {
+		/* checking the type of the Geometry column */
+		type = geojson_merge_types (ld->geom_type, ld->feat_type);
+		has_z = ld->has_z;
+		if (ld->geom->DimensionModel == GAIA_XY_Z)
+		    has_z = 1;
+		if (type != ld->geom_type || has_z != ld->has_z)
+		  {
+		      if (!geojson_promote (ld, type, has_z))
+			  return 0;
+		  }
+		if (ld->has_z && ld->geom->DimensionModel != GAIA_XY_Z)
+		  {
+		      gaiaGeomCollPtr geom3d = gaiaCastGeomCollToXYZ (ld->geom);
+		      gaiaFreeGeomColl (ld->geom);
+		      ld->geom = geom3d;
+		  }
+		if (ld->geom_type == GAIA_UNKNOWN)
+		    ld->geom->DeclaredType = ld->feat_type;
+		else
+		    ld->geom->DeclaredType = ld->geom_type;
+	    }
+	  else
+	      ld->geom->DeclaredType = ld->feat_type;
+	  ld->geom->Srid = ld->srid;
+	  gaiaToSpatiaLiteBlobWkb (ld->geom, &blob, &blob_size);
+	  sqlite3_bind_blob (ld->stmt, ld->n_created + 1, blob, blob_size,
+			     free);
+      }
+    ret = sqlite3_step (ld->stmt);
+    if (ret != SQLITE_DONE && ret != SQLITE_ROW)
+      {
+	  if (ld->error == NULL)
+	      ld->error = sqlite3_mprintf ("%s", sqlite3_errmsg (ld->sqlite));
+	  sqlite3_reset (ld->stmt);
+	  return 0;
+      }
+    sqlite3_reset (ld->stmt);
+    ld->rows++;
+    return 1;
+}
+
+static int
+geojson_object (struct geojson_loader *ld, int top)
+{
+/* parsing a FeatureCollection, a Feature or a bare Geometry */
+    char type_name[32];
+    int type;
+    int has_coords = 0;
+    int has_items = 0;
+    int more;
+    int more_items;
+    geojson_feature_begin (ld);
+    *type_name = '\0';
+    if (!geojson_expect (ld, '{'))
+	return 0;
+    more = (geojson_peek (ld) != '}');
+    if (!more)
+	ld->buf_pos++;
+    while (more)
+      {
+	  if (!geojson_key (ld))
+	      return 0;
+	  if (strcmp (ld->key.Buffer, "type") == 0)
+	    {
+		if (!geojson_type_member (ld, type_name, sizeof (type_name)))
+		    return 0;
+	    }
+	  else if (top && strcmp (ld->key.Buffer, "features") == 0)
+	    {
+		if (!geojson_expect (ld, '['))
+		    return 0;
+		more_items = (geojson_peek (ld) != ']');
+		if (!more_items)
+		    ld->buf_pos++;
+		while (more_items)
+		  {
+		      if (!geojson_object (ld, 0))
+			  return 0;
+		      if (ld->stop)
+			  return 1;
+		      if (!geojson_separator (ld, ']', &more_items))
+			  return 0;
+		  }
+	    }
+	  else if (top && strcmp (ld->key.Buffer, "crs") == 0)
+	    {
+		if (!geojson_crs (ld))
+		    return 0;
+	    }
+	  else if (strcmp (ld->key.Buffer, "geometry") == 0)
+	    {
+		if (!geojson_geometry (ld, 0))
+		    return 0;
+	    }
+	  else if (strcmp (ld->key.Buffer, "properties") == 0)
+	    {
+		if (!geojson_properties (ld))
+		    return 0;
+	    }
+	  else if (strcmp (ld->key.Buffer, "id") == 0)
+	    {
+		if (!geojson_value (ld, &(ld->id)))
+		    return 0;
+	    }
+	  else if (strcmp (ld->key.Buffer, "coordinates") == 0)
+	    {
+		if (!geojson_coordinates (ld))
+		    return 0;
+		has_coords = 1;
+	    }
+	  else if (strcmp (ld->key.Buffer, "geometries") == 0)
+	    {
+		if (!geojson_geometries (ld, 0))
+		    return 0;
+		has_items = 1;
+	    }
+	  else if (!geojson_copy_value (ld, NULL, 0))
+	      return 0;
+	  if (!geojson_separator (ld, '}', &more))
+	      return 0;
+      }
+    if (strcmp (type_name, "Feature") == 0)
+	return geojson_feature_done (ld);
+    type = geojson_type (type_name);
+    if (type >= 0)
+      {
+	  /* a bare Geometry is imported as a Feature without properties */
+	  geojson_geometry_done (ld, type, 0, has_coords, has_items);
+	  return geojson_feature_done (ld);
+      }
+    return 1;
+}
+
+static int
+geojson_parse (struct geojson_loader *ld)
+{
+/* 
+/ parsing the whole GeoJSON input: a FeatureCollection, a single
+/ Feature or a sequence of Features (newline-delimited GeoJSON)
+*/
+    int more;
+    while (!ld->stop)
+      {
+	  int c = geojson_peek (ld);
+	  if (c < 0)
+	    {
+		if (ferror (ld->in))
+		  {
+		      if (ld->error == NULL)
+			  ld->error =
+			      sqlite3_mprintf ("unable to read the input file");
+		      return 0;
+		  }
+		return 1;
+	    }
+	  if (c == '[')
+	    {
+		/* an array of Features */
+		ld->buf_pos++;
+		more = (geojson_peek (ld) != ']');
+		if (!more)
+		    ld->buf_pos++;
+		while (more)
+		  {
+		      if (!geojson_object (ld, 1))
+			  return 0;
+		      if (ld->stop)
+			  return 1;
+		      if (!geojson_separator (ld, ']', &more))
+			  return 0;
+		  }
+	    }
+	  else if (!geojson_object (ld, 1))
+	      return 0;
+      }
+    return 1;
+}
+
+SPATIALITE_DECLARE int
+load_geojson (sqlite3 * sqlite, char *path, char *table, char *geom_column,
+	      int srid, int spatial_index, int verbose, int *rows,
+	      char *err_msg)
+{
+/* loading an external GeoJSON file into a newly created table */
+    struct geojson_loader ld;
+    char *sql;
+    char *errMsg = NULL;
+    int i;
+    int ret;
+    int transaction = 0;
+
+    if (rows)
+	*rows = -1;
+    if (geom_column == NULL)
+	geom_column = "Geometry";
+    memset (&ld, 0, sizeof (struct geojson_loader));
+    ld.sqlite = sqlite;
+    ld.table = table;
+    ld.geom_column = geom_column;
+    ld.geom_type = -1;
+    gaiaOutBufferInitialize (&(ld.key));
+    gaiaOutBufferInitialize (&(ld.text));
+    for (i = 0; i < GEOJSON_HASH_BUCKETS; i++)
+	ld.buckets[i] = -1;
+    ld.buf = malloc (GEOJSON_READ_BUFFER);
+    if (ld.buf == NULL)
+	goto error;
+    ld.in = fopen (path, "rb");
+    if (ld.in == NULL)
+      {
+	  ld.error = sqlite3_mprintf ("unable to open '%s' for reading", path);
+	  goto error;
+      }
+    if (verbose)
+	spatialite_e
+	    ("========\nLoading GeoJSON at '%s' into SQLite table '%s'\n",
+	     path, table);
+
+/* step I: inferring the table layout from the leading Features */
+    ld.sampling = 1;
+    if (!geojson_parse (&ld))
+	goto error;
+    if (ld.geom_type < 0)
+	ld.geom_type = GAIA_UNKNOWN;
+    if (srid < 0)
+	srid = (ld.crs_srid > 0) ? ld.crs_srid : 4326;
+    ld.srid = srid;
+    if (fseek (ld.in, 0, SEEK_SET) != 0)
+      {
+	  ld.error = sqlite3_mprintf ("unable to rewind '%s'", path);
+	  goto error;
+      }
+    ld.buf_len = 0;
+    ld.buf_pos = 0;
+    ld.offset = 0;
+    ld.eof = 0;
+    ld.stop = 0;
+    ld.sampling = 0;
+
+/* step II: creating the table */
+    ld.metadata_version = checkSpatialMetaData (sqlite);
+    if (ld.metadata_version != 1 && ld.metadata_version != 3)
+	ld.metadata_version = 0;	/* unsupported: plain BLOB geometries */
+    if (verbose)
+	spatialite_e ("\nBEGIN;\n");
+    if (!geojson_exec (&ld, "BEGIN", 0))
+	goto error;
+    transaction = 1;
+    if (!geojson_create_table (&ld, verbose))
+	goto error;
+    if (!geojson_prepare (&ld))
+	goto error;
+
+/* step III: streaming all Features into the table */
+    if (!geojson_parse (&ld))
+	goto error;
+    sqlite3_finalize (ld.stmt);
+    ld.stmt = NULL;
+    if (spatial_index && ld.metadata_version)
+      {
+	  /* the Spatial Index is built once all rows have been inserted */
+	  sql = sqlite3_mprintf ("SELECT CreateSpatialIndex(%Q, %Q)",
+				 table, geom_column);
+	  ret = geojson_exec (&ld, sql, verbose);
+	  sqlite3_free (sql);
+	  if (!ret)
+	      goto error;
+      }
+    if (verbose)
+	spatialite_e ("COMMIT;\n");
+    if (!geojson_exec (&ld, "COMMIT", 0))
+	goto error;
+    transaction = 0;
+    if (verbose)
+      {
+	  if (ld.invalid_geoms > 0)
+	      spatialite_e
+		  ("Warning: %d invalid GeoJSON Geometries have been set to NULL\n",
+		   ld.invalid_geoms);
+	  spatialite_e
+	      ("\nInserted %d rows into '%s' from GeoJSON\n========\n",
+	       ld.rows, table);
+      }
+    if (err_msg)
+	sprintf (err_msg, "Inserted %d rows into '%s' from GeoJSON", ld.rows,
+		 table);
+    if (rows)
+	*rows = ld.rows;
+    ret = 1;
+    goto clean_up;
+
+  error:
+    if (!err_msg)
+	spatialite_e ("load GeoJSON error: <%s>\n",
+		      ld.error ? ld.error : "out of memory");
+    else
+	sprintf (err_msg, "load GeoJSON error: <%s>\n",
+		 ld.error ? ld.error : "out of memory");
+    if (ld.stmt != NULL)
+	sqlite3_finalize (ld.stmt);
+    if (transaction)
+      {
+	  /* some error occurred - ROLLBACK */
+	  if (verbose)
+	      spatialite_e ("ROLLBACK;\n");
+	  ret = sqlite3_exec (sqlite, "ROLLBACK", NULL, 0, &errMsg);
+	  if (ret != SQLITE_OK)
+	    {
+		spatialite_e ("load GeoJSON error: <%s>\n", errMsg);
+		sqlite3_free (errMsg);
+	    }
+      }
+    ret = 0;
+
+  clean_up:
+    if (ld.in != NULL)
+	fclose (ld.in);
+    if (ld.buf != NULL)
+	free (ld.buf);
+    if (ld.geom != NULL)
+	gaiaFreeGeomColl (ld.geom);
+    for (i = 0; i < ld.n_columns; i++)
+      {
+	  free (ld.columns[i].key);
+	  free (ld.columns[i].name);
+      }
+    if (ld.columns != NULL)
+	free (ld.columns);
+    if (ld.coords.xyz != NULL)
+	free (ld.coords.xyz);
+    if (ld.coords.counts != NULL)
+	free (ld.coords.counts);
+    gaiaOutBufferReset (&(ld.key));
+    gaiaOutBufferReset (&(ld.text));
+    if (ld.error != NULL)
+	sqlite3_free (ld.error);
+    return ret;
+}
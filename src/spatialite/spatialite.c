@@ -8248,25 +8248,32 @@ fnct_AsGeoJSON (sqlite3_context * context, int argc, sqlite3_value ** argv)
 	  n_bytes = sqlite3_value_bytes (argv[0]);
       }
     gaiaOutBufferInitialize (&out_buf);
-    geo =
-	gaiaFromSpatiaLiteBlobWkbEx (p_blob, n_bytes, gpkg_mode,
-				     gpkg_amphibious);
-    if (!geo)
-	sqlite3_result_null (context);
+    if (!gpkg_mode
+	&& gaiaOutGeoJSONFromSpatiaLiteBlob (&out_buf, p_blob, n_bytes,
+					     precision, options))
+	;			/* directly encoded from the BLOB */
     else
       {
-	  /* produce GeoJSON-notation - actual work is done in gaiageo/gg_wkt.c */
-	  gaiaOutGeoJSON (&out_buf, geo, precision, options);
-	  if (out_buf.Error || out_buf.Buffer == NULL)
-	      sqlite3_result_null (context);
-	  else
+	  geo =
+	      gaiaFromSpatiaLiteBlobWkbEx (p_blob, n_bytes, gpkg_mode,
+					   gpkg_amphibious);
+	  if (!geo)
 	    {
-		len = out_buf.WriteOffset;
-		sqlite3_result_text (context, out_buf.Buffer, len, free);
-		out_buf.Buffer = NULL;
+		sqlite3_result_null (context);
+		return;
 	    }
+	  /* produce GeoJSON-notation - actual work is done in gaiageo/gg_wkt.c */
+	  gaiaOutGeoJSON (&out_buf, geo, precision, options);
+	  gaiaFreeGeomColl (geo);
+      }
+    if (out_buf.Error || out_buf.Buffer == NULL)
+	sqlite3_result_null (context);
+    else
+      {
+	  len = out_buf.WriteOffset;
+	  sqlite3_result_text (context, out_buf.Buffer, len, free);
+	  out_buf.Buffer = NULL;
       }
-    gaiaFreeGeomColl (geo);
     gaiaOutBufferReset (&out_buf);
 }
 
@@ -10564,7 +10571,16 @@ geom_from_text1 (sqlite3_context * context, int argc, sqlite3_value ** argv,
 	  return;
       }
     text = sqlite3_value_text (argv[0]);
-    geo = gaiaParseWkt (text, type);
+    if (!gpkg_mode && gaiaSimpleWktToBlob (text, type, 0, &p_result, &len))
+      {
+	  /* simple geometry: directly encoded as a BLOB */
+	  sqlite3_result_blob (context, p_result, len, free);
+	  return;
+      }
+    if (cache != NULL)
+	geo = gaiaParseWkt_r (cache, text, type);
+    else
+	geo = gaiaParseWkt (text, type);
     if (geo == NULL)
       {
 	  sqlite3_result_null (context);
@@ -10608,7 +10624,18 @@ geom_from_text2 (sqlite3_context * context, int argc, sqlite3_value ** argv,
 	  return;
       }
     text = sqlite3_value_text (argv[0]);
-    geo = gaiaParseWkt (text, type);
+    if (!gpkg_mode
+	&& gaiaSimpleWktToBlob (text, type, sqlite3_value_int (argv[1]),
+				&p_result, &len))
+      {
+	  /* simple geometry: directly encoded as a BLOB */
+	  sqlite3_result_blob (context, p_result, len, free);
+	  return;
+      }
+    if (cache != NULL)
+	geo = gaiaParseWkt_r (cache, text, type);
+    else
+	geo = gaiaParseWkt (text, type);
     if (geo == NULL)
       {
 	  sqlite3_result_null (context);
@@ -10976,7 +11003,10 @@ fnct_WktToSql (sqlite3_context * context, int argc, sqlite3_value ** argv)
 	  return;
       }
     text = sqlite3_value_text (argv[0]);
-    geo = gaiaParseWkt (text, -1);
+    if (cache != NULL)
+	geo = gaiaParseWkt_r (cache, text, -1);
+    else
+	geo = gaiaParseWkt (text, -1);
     if (geo == NULL)
       {
 	  sqlite3_result_null (context);
@@ -17915,7 +17945,10 @@ fnct_FromEWKT (sqlite3_context * context, int argc, sqlite3_value ** argv)
 	  return;
       }
     text = sqlite3_value_text (argv[0]);
-    geo = gaiaParseEWKT (text);
+    if (cache != NULL)
+	geo = gaiaParseEWKT_r (cache, text);
+    else
+	geo = gaiaParseEWKT (text);
     if (geo == NULL)
       {
 	  sqlite3_result_null (context);
@@ -17950,7 +17983,16 @@ fnct_FromGeoJSON (sqlite3_context * context, int argc, sqlite3_value ** argv)
 	  return;
       }
     text = sqlite3_value_text (argv[0]);
-    geo = gaiaParseGeoJSON (text);
+    if (!gpkg_mode && gaiaSimpleGeoJSONToBlob (text, &p_result, &len))
+      {
+	  /* simple geometry: directly encoded as a BLOB */
+	  sqlite3_result_blob (context, p_result, len, free);
+	  return;
+      }
+    if (cache != NULL)
+	geo = gaiaParseGeoJSON_r (cache, text);
+    else
+	geo = gaiaParseGeoJSON (text);
     if (geo == NULL)
       {
 	  sqlite3_result_null (context);
@@ -17985,7 +18027,10 @@ fnct_FromKml (sqlite3_context * context, int argc, sqlite3_value ** argv)
 	  return;
       }
     text = sqlite3_value_text (argv[0]);
-    geo = gaiaParseKml (text);
+    if (cache != NULL)
+	geo = gaiaParseKml_r (cache, text);
+    else
+	geo = gaiaParseKml (text);
     if (geo == NULL)
       {
 	  sqlite3_result_null (context);
@@ -19107,9 +19152,11 @@ fnct_IsValid (sqlite3_context * context, int argc, sqlite3_value ** argv)
     gaiaFreeGeomColl (geo);
 }
 
+#endif /* end including GEOS */
+
 static void
-length_common (const void *p_cache, sqlite3_context * context, int argc,
-	       sqlite3_value ** argv, int is_perimeter)
+length_common (sqlite3_context * context, int argc, sqlite3_value ** argv,
+	       int is_perimeter)
 {
 /* common implementation supporting both ST_Length and ST_Perimeter */
     unsigned char *p_blob;
@@ -19304,12 +19351,10 @@ length_common (const void *p_cache, sqlite3_context * context, int argc,
 		    sqlite3_result_null (context);
 		goto stop;
 	    }
-	  else if (p_cache != NULL)
-	      ret =
-		  gaiaGeomCollLengthOrPerimeter_r (p_cache, geo, is_perimeter,
-						   &length);
 	  else
-	      ret = gaiaGeomCollLengthOrPerimeter (geo, is_perimeter, &length);
+	      ret =
+		  gaiaGeomCollPlanarLengthOrPerimeter (geo, is_perimeter,
+						       &length);
 	  if (!ret)
 	      sqlite3_result_null (context);
 	  else
@@ -19333,8 +19378,7 @@ fnct_Length (sqlite3_context * context, int argc, sqlite3_value ** argv)
 / any Polygon (only Linestrings will be considered)
 /
 */
-    void *data = sqlite3_user_data (context);
-    length_common (data, context, argc, argv, 0);
+    length_common (context, argc, argv, 0);
 }
 
 static void
@@ -19351,8 +19395,7 @@ fnct_Perimeter (sqlite3_context * context, int argc, sqlite3_value ** argv)
 / any Linestring (only Polygons will be considered)
 /
 */
-    void *data = sqlite3_user_data (context);
-    length_common (data, context, argc, argv, 1);
+    length_common (context, argc, argv, 1);
 }
 
 static void
@@ -19423,13 +19466,7 @@ fnct_Area (sqlite3_context * context, int argc, sqlite3_value ** argv)
 #endif /* end LWGEOM conditional */
 	    }
 	  else
-	    {
-		void *data = sqlite3_user_data (context);
-		if (data != NULL)
-		    ret = gaiaGeomCollArea_r (data, geo, &area);
-		else
-		    ret = gaiaGeomCollArea (geo, &area);
-	    }
+	      ret = gaiaGeomCollPlanarArea (geo, &area);
 	  if (!ret)
 	      sqlite3_result_null (context);
 	  else
@@ -19483,11 +19520,7 @@ fnct_Centroid (sqlite3_context * context, int argc, sqlite3_value ** argv)
 	      sqlite3_result_null (context);
 	  else
 	    {
-		void *data = sqlite3_user_data (context);
-		if (data != NULL)
-		    ret = gaiaGeomCollCentroid_r (data, geo, &x, &y);
-		else
-		    ret = gaiaGeomCollCentroid (geo, &x, &y);
+		ret = gaiaGeomCollPlanarCentroid (geo, &x, &y);
 		if (!ret)
 		    sqlite3_result_null (context);
 		else
@@ -19505,6 +19538,8 @@ fnct_Centroid (sqlite3_context * context, int argc, sqlite3_value ** argv)
     gaiaFreeGeomColl (geo);
 }
 
+#ifndef OMIT_GEOS		/* including GEOS */
+
 static void
 fnct_PointOnSurface (sqlite3_context * context, int argc, sqlite3_value ** argv)
 {
@@ -28690,20 +28725,12 @@ load_dxf (sqlite3 * db_handle, struct splite_internal_cache *cache,
 	  ret = 0;
 	  goto stop_dxf;
       }
-/* attempting to parse the DXF input file */
-    if (gaiaParseDxfFile_r (cache, dxf, filename))
-      {
-	  /* loading into the DB */
-	  if (!gaiaLoadFromDxfParser (db_handle, dxf, mode, append))
-	    {
-		ret = 0;
-		spatialite_e ("DB error while loading: %s\n", filename);
-	    }
-      }
-    else
+/* attempting to parse the DXF input file and to load it into the DB */
+    if (!gaiaLoadFromDxfFile_r
+	(cache, db_handle, dxf, filename, mode, append))
       {
 	  ret = 0;
-	  spatialite_e ("Unable to parse: %s\n", filename);
+	  spatialite_e ("Unable to load: %s\n", filename);
 	  goto stop_dxf;
       }
     spatialite_e ("\n*** DXF file successfully loaded\n");
@@ -28834,87 +28861,6 @@ fnct_ImportDXF (sqlite3_context * context, int argc, sqlite3_value ** argv)
     sqlite3_result_int (context, ret);
 }
 
-static int
-is_dxf_file (const char *filename)
-{
-/* testing if a FileName ends with the expected suffix */
-    int len = strlen (filename);
-    int off = len - 4;
-    if (off >= 1)
-      {
-	  if (strcasecmp (filename + off, ".dxf") == 0)
-	      return 1;
-      }
-    return 0;
-}
-
-static int
-scan_dxf_dir (sqlite3 * db_handle, struct splite_internal_cache *cache,
-	      char *dir_path, int srid, int append, int force_dims, int mode,
-	      int special_rings, char *prefix, char *layer_name)
-{
-/* scanning a Directory and processing all DXF files */
-    int cnt = 0;
-    char *filepath;
-#if defined(_WIN32) && !defined(__MINGW32__)
-/* Visual Studio .NET */
-    struct _finddata_t c_file;
-    intptr_t hFile;
-    if (_chdir (dir_path) < 0)
-	return 0;
-    if ((hFile = _findfirst ("*.*", &c_file)) == -1L)
-	;
-    else
-      {
-	  while (1)
-	    {
-		if ((c_file.attrib & _A_RDONLY) == _A_RDONLY
-		    || (c_file.attrib & _A_NORMAL) == _A_NORMAL)
-		  {
-		      if (is_dxf_file (c_file.name))
-			{
-			    filepath =
-				sqlite3_mprintf ("%s/%s", dir_path,
-						 c_file.name);
-			    cnt +=
-				load_dxf (db_handle, cache, filepath, srid,
-					  append, force_dims, mode,
-					  special_rings, prefix, layer_name);
-			    sqlite3_free (filepath);
-			}
-		  }
-		if (_findnext (hFile, &c_file) != 0)
-		    break;
-	    };
-	  _findclose (hFile);
-      }
-#else
-/* not Visual Studio .NET */
-    struct dirent *entry;
-    DIR *dir = opendir (dir_path);
-    if (!dir)
-	return 0;
-    while (1)
-      {
-	  /* scanning dir-entries */
-	  entry = readdir (dir);
-	  if (!entry)
-	      break;
-	  if (is_dxf_file (entry->d_name))
-	    {
-		filepath = sqlite3_mprintf ("%s/%s", dir_path, entry->d_name);
-		cnt +=
-		    load_dxf (db_handle, cache, filepath, srid, append,
-			      force_dims, mode, special_rings, prefix,
-			      layer_name);
-		sqlite3_free (filepath);
-	    }
-      }
-    closedir (dir);
-#endif
-    return cnt;
-}
-
 static void
 fnct_ImportDXFfromDir (sqlite3_context * context, int argc,
 		       sqlite3_value ** argv)
@@ -28925,6 +28871,10 @@ fnct_ImportDXFfromDir (sqlite3_context * context, int argc,
 / InportDXFfromDir(TEXT dir_path, INT srid, INT append, TEXT dims,
 /                  TEXT mode, TEXT special_rings, TEXT table_prefix,
 /                  TEXT layer_name)
+/     or
+/ InportDXFfromDir(TEXT dir_path, INT srid, INT append, TEXT dims,
+/                  TEXT mode, TEXT special_rings, TEXT table_prefix,
+/                  TEXT layer_name, INT ordered)
 /
 / returns:
 / 1 on success
@@ -28940,6 +28890,7 @@ fnct_ImportDXFfromDir (sqlite3_context * context, int argc,
     int force_dims = GAIA_DXF_AUTO_2D_3D;
     char *prefix = NULL;
     char *layer_name = NULL;
+    int ordered = 1;
     sqlite3 *db_handle = sqlite3_context_db_handle (context);
     struct splite_internal_cache *cache = sqlite3_user_data (context);
     GAIA_UNUSED ();		/* LCOV_EXCL_LINE */
@@ -29028,10 +28979,20 @@ fnct_ImportDXFfromDir (sqlite3_context * context, int argc,
 		return;
 	    }
       }
+    if (argc > 8)
+      {
+	  if (sqlite3_value_type (argv[8]) != SQLITE_INTEGER)
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+	  ordered = sqlite3_value_int (argv[8]);
+      }
 
     ret =
-	scan_dxf_dir (db_handle, cache, dir_path, srid, append, force_dims,
-		      mode, special_rings, prefix, layer_name);
+	gaiaLoadFromDxfDir_r (cache, db_handle, dir_path, srid, force_dims,
+			      prefix, layer_name, special_rings, mode, append,
+			      ordered);
     sqlite3_result_int (context, ret);
 }
 
@@ -29936,6 +29897,201 @@ fnct_ExportGeoJSON (sqlite3_context * context, int argc, sqlite3_value ** argv)
 	sqlite3_result_int (context, rows);
 }
 
+static void
+fnct_ExportGeoJSONFeatures (sqlite3_context * context, int argc,
+			    sqlite3_value ** argv)
+{
+/* SQL function:
+/ ExportGeoJSONFeatures(TEXT table, TEXT geom_column, TEXT filename)
+/ ExportGeoJSONFeatures(TEXT table, TEXT geom_column, TEXT filename, 
+/                       TEXT format)
+/ ExportGeoJSONFeatures(TEXT table, TEXT geom_column, TEXT filename, 
+/                       TEXT format, INT precision)
+/ ExportGeoJSONFeatures(TEXT table, TEXT geom_column, TEXT filename, 
+/                       TEXT format, INT precision, TEXT layout)
+/
+/ *layout* may be one of the followings:
+/   'FeatureCollection' [default]
+/   'NDJSON' (newline-delimited Features)
+/
+/ returns:
+/ the number of exported rows
+/ NULL on invalid arguments
+*/
+    int ret;
+    char *table;
+    char *geom_col;
+    char *path;
+    int format = 0;
+    int precision = 8;
+    int ndjson = 0;
+    char *fmt = NULL;
+    int rows;
+    sqlite3 *db_handle = sqlite3_context_db_handle (context);
+    GAIA_UNUSED ();		/* LCOV_EXCL_LINE */
+    if (sqlite3_value_type (argv[0]) != SQLITE_TEXT)
+      {
+	  sqlite3_result_null (context);
+	  return;
+      }
+    table = (char *) sqlite3_value_text (argv[0]);
+    if (sqlite3_value_type (argv[1]) != SQLITE_TEXT)
+      {
+	  sqlite3_result_null (context);
+	  return;
+      }
+    geom_col = (char *) sqlite3_value_text (argv[1]);
+    if (sqlite3_value_type (argv[2]) != SQLITE_TEXT)
+      {
+	  sqlite3_result_null (context);
+	  return;
+      }
+    path = (char *) sqlite3_value_text (argv[2]);
+    if (argc > 3)
+      {
+	  if (sqlite3_value_type (argv[3]) != SQLITE_TEXT)
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+	  else
+	    {
+		fmt = (char *) sqlite3_value_text (argv[3]);
+		if (strcasecmp (fmt, "none") == 0)
+		    format = 0;
+		else if (strcasecmp (fmt, "MBR") == 0)
+		    format = 1;
+		else if (strcasecmp (fmt, "withShortCRS") == 0)
+		    format = 2;
+		else if (strcasecmp (fmt, "MBRwithShortCRS") == 0)
+		    format = 3;
+		else if (strcasecmp (fmt, "withLongCRS") == 0)
+		    format = 4;
+		else if (strcasecmp (fmt, "MBRwithLongCRS") == 0)
+		    format = 5;
+		else
+		  {
+		      sqlite3_result_null (context);
+		      return;
+		  }
+	    }
+      }
+    if (argc > 4)
+      {
+	  if (sqlite3_value_type (argv[4]) != SQLITE_INTEGER)
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+	  else
+	      precision = sqlite3_value_int (argv[4]);
+      }
+    if (argc > 5)
+      {
+	  if (sqlite3_value_type (argv[5]) != SQLITE_TEXT)
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+	  fmt = (char *) sqlite3_value_text (argv[5]);
+	  if (strcasecmp (fmt, "FeatureCollection") == 0)
+	      ndjson = 0;
+	  else if (strcasecmp (fmt, "NDJSON") == 0)
+	      ndjson = 1;
+	  else
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+      }
+
+    ret =
+	dump_geojson_features (db_handle, table, geom_col, path, precision,
+			       format, ndjson, &rows);
+
+    if (rows < 0 || !ret)
+	sqlite3_result_null (context);
+    else
+	sqlite3_result_int (context, rows);
+}
+
+static void
+fnct_ImportGeoJSON (sqlite3_context * context, int argc, sqlite3_value ** argv)
+{
+/* SQL function:
+/ ImportGeoJSON(TEXT filename, TEXT table)
+/ ImportGeoJSON(TEXT filename, TEXT table, TEXT geom_column)
+/ ImportGeoJSON(TEXT filename, TEXT table, TEXT geom_column,
+/               INT srid)
+/ ImportGeoJSON(TEXT filename, TEXT table, TEXT geom_column,
+/               INT srid, INT spatial_index)
+/
+/ returns:
+/ the number of imported rows
+/ NULL on invalid arguments
+*/
+    int ret;
+    char *path;
+    char *table;
+    char *geom_col = NULL;
+    int srid = -1;
+    int spatial_index = 0;
+    int rows;
+    sqlite3 *db_handle = sqlite3_context_db_handle (context);
+    GAIA_UNUSED ();		/* LCOV_EXCL_LINE */
+    if (sqlite3_value_type (argv[0]) != SQLITE_TEXT)
+      {
+	  sqlite3_result_null (context);
+	  return;
+      }
+    path = (char *) sqlite3_value_text (argv[0]);
+    if (sqlite3_value_type (argv[1]) != SQLITE_TEXT)
+      {
+	  sqlite3_result_null (context);
+	  return;
+      }
+    table = (char *) sqlite3_value_text (argv[1]);
+    if (argc > 2)
+      {
+	  if (sqlite3_value_type (argv[2]) != SQLITE_TEXT)
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+	  else
+	      geom_col = (char *) sqlite3_value_text (argv[2]);
+      }
+    if (argc > 3)
+      {
+	  if (sqlite3_value_type (argv[3]) != SQLITE_INTEGER)
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+	  else
+	      srid = sqlite3_value_int (argv[3]);
+      }
+    if (argc > 4)
+      {
+	  if (sqlite3_value_type (argv[4]) != SQLITE_INTEGER)
+	    {
+		sqlite3_result_null (context);
+		return;
+	    }
+	  else
+	      spatial_index = sqlite3_value_int (argv[4]);
+      }
+
+    ret =
+	load_geojson (db_handle, path, table, geom_col, srid, spatial_index, 1,
+		      &rows, NULL);
+
+    if (rows < 0 || !ret)
+	sqlite3_result_null (context);
+    else
+	sqlite3_result_int (context, rows);
+}
+
 #ifdef ENABLE_LIBXML2		/* including LIBXML2 */
 static void
 wfs_page_done (int features, void *ptr)
@@ -30077,7 +30233,8 @@ fnct_CountUnsafeTriggers (sqlite3_context * context, int argc,
 	"OR sql LIKE '%ExportDXF%' OR sql LIKE '%ImportDBF%' "
 	"OR sql LIKE '%ExportDBF%' OR sql LIKE '%ImportSHP%' "
 	"OR sql LIKE '%ExportSHP%' OR sql LIKE '%ExportKML%' "
-	"OR sql LIKE '%ExportGeoJSON%' OR sql LIKE '%eval%' "
+	"OR sql LIKE '%ExportGeoJSON%' OR sql LIKE '%ImportGeoJSON%' "
+	"OR sql LIKE '%eval%' "
 	"OR sql LIKE '%ImportWFS%' OR sql LIKE '%ImportXLS%')";
     ret = sqlite3_get_table (sqlite, sql, &results, &rows, &columns, NULL);
     if (ret != SQLITE_OK)
@@ -35568,7 +35725,6 @@ register_spatialite_sql_functions (void *p_db, const void *p_cache)
     sqlite3 *db = p_db;
     struct splite_internal_cache *cache =
 	(struct splite_internal_cache *) p_cache;
-    const char *security_level;
 
 #ifdef LOADABLE_EXTENSION
 /* registering the CLOSE-CALLBACK function */
@@ -37207,10 +37363,7 @@ register_spatialite_sql_functions (void *p_db, const void *p_cache)
 // SPATIALITE_SECURITY=relaxed
 //
 */
-    security_level = getenv ("SPATIALITE_SECURITY");
-    if (security_level == NULL)
-	;
-    else if (strcasecmp (security_level, "relaxed") == 0)
+    if (splite_relaxed_security ())
       {
 	  sqlite3_create_function_v2 (db, "BlobFromFile", 1,
 				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
@@ -37230,6 +37383,9 @@ register_spatialite_sql_functions (void *p_db, const void *p_cache)
 	  sqlite3_create_function_v2 (db, "ImportDXFfromDir", 8,
 				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
 				      fnct_ImportDXFfromDir, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ImportDXFfromDir", 9,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				      fnct_ImportDXFfromDir, 0, 0, 0);
 	  sqlite3_create_function_v2 (db, "ExportDXF", 9,
 				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
 				      fnct_ExportDXF, 0, 0, 0);
@@ -37302,6 +37458,30 @@ register_spatialite_sql_functions (void *p_db, const void *p_cache)
 	  sqlite3_create_function_v2 (db, "ExportGeoJSON", 5,
 				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
 				      fnct_ExportGeoJSON, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ExportGeoJSONFeatures", 3,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ExportGeoJSONFeatures, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ExportGeoJSONFeatures", 4,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ExportGeoJSONFeatures, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ExportGeoJSONFeatures", 5,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ExportGeoJSONFeatures, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ExportGeoJSONFeatures", 6,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ExportGeoJSONFeatures, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ImportGeoJSON", 2,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ImportGeoJSON, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ImportGeoJSON", 3,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ImportGeoJSON, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ImportGeoJSON", 4,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ImportGeoJSON, 0, 0, 0);
+	  sqlite3_create_function_v2 (db, "ImportGeoJSON", 5,
+				      SQLITE_UTF8 | SQLITE_DETERMINISTIC, 0,
+				      fnct_ImportGeoJSON, 0, 0, 0);
 
 	  sqlite3_create_function_v2 (db, "eval", 1, SQLITE_UTF8, 0,
 				      fnct_EvalFunc, 0, 0, 0);
@@ -37626,6 +37806,43 @@ register_spatialite_sql_functions (void *p_db, const void *p_cache)
 
 #endif /* end including PROJ.4 */
 
+    sqlite3_create_function_v2 (db, "GLength", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Length, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "GLength", 2,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Length, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "ST_Length", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Length, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "ST_Length", 2,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Length, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "Perimeter", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Perimeter, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "Perimeter", 2,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Perimeter, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "ST_Perimeter", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Perimeter, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "ST_Perimeter", 2,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Perimeter, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "Area", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Area, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "ST_Area", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Area, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "ST_Centroid", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Centroid, 0, 0, 0);
+    sqlite3_create_function_v2 (db, "Centroid", 1,
+				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
+				fnct_Centroid, 0, 0, 0);
+
 #ifndef OMIT_GEOS		/* including GEOS */
 
     sqlite3_create_function_v2 (db, "GEOS_GetLastErrorMsg", 0, SQLITE_UTF8,
@@ -37679,42 +37896,6 @@ register_spatialite_sql_functions (void *p_db, const void *p_cache)
     sqlite3_create_function_v2 (db, "ST_IsValid", 1,
 				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
 				fnct_IsValid, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "GLength", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Length, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "GLength", 2,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Length, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "ST_Length", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Length, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "ST_Length", 2,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Length, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "Perimeter", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Perimeter, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "Perimeter", 2,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Perimeter, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "ST_Perimeter", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Perimeter, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "ST_Perimeter", 2,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Perimeter, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "Area", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Area, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "ST_Area", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Area, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "ST_Centroid", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Centroid, 0, 0, 0);
-    sqlite3_create_function_v2 (db, "Centroid", 1,
-				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
-				fnct_Centroid, 0, 0, 0);
     sqlite3_create_function_v2 (db, "PointOnSurface", 1,
 				SQLITE_UTF8 | SQLITE_DETERMINISTIC, cache,
 				fnct_PointOnSurface, 0, 0, 0);
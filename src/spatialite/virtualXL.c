@@ -106,6 +106,8 @@ typedef struct VirtualXLCursorStruct
     VirtualXLPtr pVtab;		/* Virtual table of this cursor */
     unsigned int current_row;	/* the current row ID */
     int eof;			/* the EOF marker */
+    FreeXL_CellValue *cells;	/* the current row's cells */
+    char *used;			/* columns fetched on each row */
     VirtualXLConstraintPtr firstConstraint;
     VirtualXLConstraintPtr lastConstraint;
 } VirtualXLCursor;
@@ -346,6 +348,7 @@ vXL_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
     int iArg = 0;
     char str[2048];
     char buf[64];
+    sqlite3_uint64 col_used = ~((sqlite3_uint64) 0);
 
     if (pVTab)
 	pVTab = pVTab;		/* unused arg warning suppression */
@@ -363,11 +366,13 @@ vXL_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
 		strcat (str, buf);
 	    }
       }
-    if (*str != '\0')
-      {
-	  pIndex->idxStr = sqlite3_mprintf ("%s", str);
-	  pIndex->needToFreeIdxStr = 1;
-      }
+#if SQLITE_VERSION_NUMBER >= 3010000
+    if (sqlite3_libversion_number () >= 3010000)
+	col_used = pIndex->colUsed;
+#endif
+/* the columns to be fetched follow the constraints */
+    pIndex->idxStr = sqlite3_mprintf ("%s|%llx", str, col_used);
+    pIndex->needToFreeIdxStr = 1;
 
     return SQLITE_OK;
 }
@@ -390,6 +395,28 @@ vXL_destroy (sqlite3_vtab * pVTab)
     return vXL_disconnect (pVTab);
 }
 
+static void
+vXL_fetch_row (VirtualXLCursorPtr cursor)
+{
+/* fetching the used cells of the current row into the row buffer */
+    int col;
+    FreeXL_CellValue *cell;
+    VirtualXLPtr p_vt = cursor->pVtab;
+    if (cursor->cells == NULL)
+	return;
+    for (col = 0; col < p_vt->columns; col++)
+      {
+	  cell = cursor->cells + col;
+	  cell->type = FREEXL_CELL_NULL;
+	  if (!cursor->used[col] || p_vt->XL_handle == NULL)
+	      continue;
+	  if (freexl_get_cell_value
+	      (p_vt->XL_handle, cursor->current_row - 1, col,
+	       cell) != FREEXL_OK)
+	      cell->type = FREEXL_CELL_NULL;
+      }
+}
+
 static void
 vXL_read_row (VirtualXLCursorPtr cursor)
 {
@@ -400,6 +427,19 @@ vXL_read_row (VirtualXLCursorPtr cursor)
 	  cursor->eof = 1;
 	  return;
       }
+/* fetching all the projected cells of this row at once */
+    vXL_fetch_row (cursor);
+}
+
+static FreeXL_CellValue *
+vXL_cell (VirtualXLCursorPtr cursor, int column)
+{
+/* returning a cell from the current row */
+    VirtualXLPtr p_vt = cursor->pVtab;
+    if (cursor->cells == NULL || cursor->current_row > p_vt->rows
+	|| column < 1 || column > p_vt->columns)
+	return NULL;
+    return cursor->cells + (column - 1);
 }
 
 static int
@@ -413,6 +453,25 @@ vXL_open (sqlite3_vtab * pVTab, sqlite3_vtab_cursor ** ppCursor)
     cursor->firstConstraint = NULL;
     cursor->lastConstraint = NULL;
     cursor->pVtab = (VirtualXLPtr) pVTab;
+    cursor->cells = NULL;
+    cursor->used = NULL;
+    if (cursor->pVtab->columns > 0)
+      {
+	  /* allocating the reusable row buffer */
+	  cursor->cells =
+	      sqlite3_malloc (sizeof (FreeXL_CellValue) *
+			      cursor->pVtab->columns);
+	  cursor->used = sqlite3_malloc (cursor->pVtab->columns);
+	  if (cursor->cells == NULL || cursor->used == NULL)
+	    {
+		sqlite3_free (cursor->cells);
+		sqlite3_free (cursor->used);
+		sqlite3_free (cursor);
+		return SQLITE_NOMEM;
+	    }
+	  /* no column is fetched until xFilter sets the projection */
+	  memset (cursor->used, 0, cursor->pVtab->columns);
+      }
     if (cursor->pVtab->firstLineTitles == 'Y')
 	cursor->current_row = 1;
     else
@@ -448,6 +507,8 @@ vXL_close (sqlite3_vtab_cursor * pCursor)
 /* closing the cursor */
     VirtualXLCursorPtr cursor = (VirtualXLCursorPtr) pCursor;
     vXL_free_constraints (cursor);
+    sqlite3_free (cursor->cells);
+    sqlite3_free (cursor->used);
     sqlite3_free (pCursor);
     return SQLITE_OK;
 }
@@ -498,11 +559,51 @@ vXL_parse_constraint (const char *str, int index, int *iColumn, int *op)
     return 0;
 }
 
+static void
+vXL_parse_projection (VirtualXLCursorPtr cursor, const char *str)
+{
+/* parsing the columns to be fetched, as set by xBestIndex */
+    int col;
+    int bit;
+    int digit;
+    sqlite3_uint64 col_used = 0;
+    const char *in = NULL;
+    if (cursor->used == NULL)
+	return;
+    if (str != NULL)
+	in = strchr (str, '|');
+    if (in == NULL)
+	col_used = ~((sqlite3_uint64) 0);
+    else
+      {
+	  for (in++; *in != '\0'; in++)
+	    {
+		if (*in >= '0' && *in <= '9')
+		    digit = *in - '0';
+		else if (*in >= 'a' && *in <= 'f')
+		    digit = *in - 'a' + 10;
+		else
+		    break;
+		col_used = (col_used << 4) | digit;
+	    }
+      }
+/* column #0 is the row number; bit 63 stands for any further column */
+    for (col = 0; col < cursor->pVtab->columns; col++)
+      {
+	  bit = col + 1;
+	  if (bit > 63)
+	      bit = 63;
+	  cursor->used[col] =
+	      (col_used & (((sqlite3_uint64) 1) << bit)) ? 1 : 0;
+      }
+}
+
 static int
 vXL_eval_constraints (VirtualXLCursorPtr cursor)
 {
 /* evaluating Filter constraints */
     FreeXL_CellValue cell;
+    FreeXL_CellValue *pCell;
     VirtualXLConstraintPtr pC = cursor->firstConstraint;
     if (pC == NULL)
 	return 1;
@@ -543,12 +644,9 @@ vXL_eval_constraints (VirtualXLCursorPtr cursor)
 		  }
 		goto done;
 	    }
-	  if (cursor->pVtab->XL_handle != NULL
-	      && cursor->current_row <= cursor->pVtab->rows
-	      && pC->iColumn <= cursor->pVtab->columns)
-	      freexl_get_cell_value (cursor->pVtab->XL_handle,
-				     cursor->current_row - 1, pC->iColumn - 1,
-				     &cell);
+	  pCell = vXL_cell (cursor, pC->iColumn);
+	  if (pCell != NULL)
+	      cell = *pCell;
 	  else
 	      cell.type = FREEXL_CELL_NULL;
 	  if (cell.type == FREEXL_CELL_INT)
@@ -716,6 +814,7 @@ vXL_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 
 /* resetting any previously set filter constraint */
     vXL_free_constraints (cursor);
+    vXL_parse_projection (cursor, idxStr);
 
     for (i = 0; i < argc; i++)
       {
@@ -726,6 +825,9 @@ vXL_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 	      continue;
 	  pC->iColumn = iColumn;
 	  pC->op = op;
+	  if (cursor->used != NULL && iColumn >= 1
+	      && iColumn <= cursor->pVtab->columns)
+	      cursor->used[iColumn - 1] = 1;
 	  pC->valueType = '\0';
 	  pC->txtValue = NULL;
 	  pC->next = NULL;
@@ -802,6 +904,7 @@ vXL_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 {
 /* fetching value for the Nth column */
     FreeXL_CellValue cell;
+    FreeXL_CellValue *pCell;
     VirtualXLCursorPtr cursor = (VirtualXLCursorPtr) pCursor;
     if (column == 0)
       {
@@ -812,11 +915,9 @@ vXL_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 	      sqlite3_result_int (pContext, cursor->current_row);
 	  return SQLITE_OK;
       }
-    if (cursor->pVtab->XL_handle != NULL
-	&& cursor->current_row <= cursor->pVtab->rows
-	&& column <= cursor->pVtab->columns)
-	freexl_get_cell_value (cursor->pVtab->XL_handle,
-			       cursor->current_row - 1, column - 1, &cell);
+    pCell = vXL_cell (cursor, column);
+    if (pCell != NULL)
+	cell = *pCell;
     else
 	cell.type = FREEXL_CELL_NULL;
     switch (cell.type)
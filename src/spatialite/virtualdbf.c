@@ -78,6 +78,7 @@ typedef struct VirtualDbfStruct
     sqlite3 *db;		/* the sqlite db holding the virtual table */
     gaiaDbfPtr dbf;		/* the DBF struct */
     int text_dates;
+    void *Owner;		/* the cursor positioned on the current row */
 } VirtualDbf;
 typedef VirtualDbf *VirtualDbfPtr;
 
@@ -99,6 +100,8 @@ typedef struct VirtualDbfCursorStruct
 /* extends the sqlite3_vtab_cursor struct */
     VirtualDbfPtr pVtab;	/* Virtual table of this cursor */
     long current_row;		/* the current row ID */
+    int nFields;
+    char *valuesLoaded;		/* the DBF values already decoded */
     int eof;			/* the EOF marker */
     VirtualDbfConstraintPtr firstConstraint;
     VirtualDbfConstraintPtr lastConstraint;
@@ -176,6 +179,7 @@ vdbf_create (sqlite3 * db, void *pAux, int argc, const char *const *argv,
     p_vt->zErrMsg = NULL;
     p_vt->db = db;
     p_vt->dbf = gaiaAllocDbf ();
+    p_vt->Owner = NULL;
     p_vt->text_dates = text_dates;
 /* trying to open file */
     gaiaOpenDbfRead (p_vt->dbf, path, encoding, "UTF-8");
@@ -350,7 +354,7 @@ vdbf_destroy (sqlite3_vtab * pVTab)
 static void
 vdbf_read_row (VirtualDbfCursorPtr cursor, int *deleted_row)
 {
-/* trying to read a "row" from DBF */
+/* trying to read a "row" from DBF - decoding is deferred */
     int ret;
     int deleted;
     if (!(cursor->pVtab->dbf->Valid))
@@ -358,9 +362,12 @@ vdbf_read_row (VirtualDbfCursorPtr cursor, int *deleted_row)
 	  cursor->eof = 1;
 	  return;
       }
+    if (cursor->valuesLoaded)
+	memset (cursor->valuesLoaded, 0, cursor->nFields);
     ret =
-	gaiaReadDbfEntity_ex (cursor->pVtab->dbf, cursor->current_row, &deleted,
-			      cursor->pVtab->text_dates);
+	gaiaReadDbfEntityLazy (cursor->pVtab->dbf, cursor->current_row,
+			       &deleted);
+    cursor->pVtab->Owner = cursor;
     if (!ret)
       {
 	  if (!(cursor->pVtab->dbf->LastError))	/* normal DBF EOF */
@@ -377,6 +384,52 @@ vdbf_read_row (VirtualDbfCursorPtr cursor, int *deleted_row)
     *deleted_row = deleted;
 }
 
+static int
+vdbf_load_value (VirtualDbfCursorPtr cursor, gaiaDbfFieldPtr pFld,
+		 int index)
+{
+/* decoding some DBF value on demand */
+    gaiaDbfPtr dbf = cursor->pVtab->dbf;
+    int deleted;
+    if (cursor->pVtab->Owner != cursor)
+      {
+	  /* some other cursor has been positioned since then */
+	  memset (cursor->valuesLoaded, 0, cursor->nFields);
+	  cursor->pVtab->Owner = cursor;
+	  if (!gaiaReadDbfEntityLazy (dbf, cursor->current_row - 1, &deleted))
+	      return 0;
+      }
+    if (cursor->valuesLoaded[index])
+	return 1;
+    if (!gaiaReadDbfEntityValue (dbf, pFld, cursor->pVtab->text_dates))
+	return 0;
+    cursor->valuesLoaded[index] = 1;
+    return 1;
+}
+
+static void
+vdbf_read_error (VirtualDbfCursorPtr cursor, sqlite3_context * pContext)
+{
+/* reporting a deferred decoding failure */
+    const char *msg = cursor->pVtab->dbf->LastError;
+    if (msg == NULL)
+	msg = "[VirtualDbf module] unable to read the current row";
+    sqlite3_result_error (pContext, msg, -1);
+}
+
+static int
+vdbf_cursor_error (VirtualDbfCursorPtr cursor)
+{
+/* reporting a decoding failure from xFilter or xNext */
+    const char *msg = cursor->pVtab->dbf->LastError;
+    if (msg == NULL)
+	msg = "[VirtualDbf module] unable to read the current row";
+    sqlite3_free (cursor->pVtab->zErrMsg);
+    cursor->pVtab->zErrMsg = sqlite3_mprintf ("%s", msg);
+    cursor->eof = 1;
+    return SQLITE_ERROR;
+}
+
 static int
 vdbf_open (sqlite3_vtab * pVTab, sqlite3_vtab_cursor ** ppCursor)
 {
@@ -390,6 +443,27 @@ vdbf_open (sqlite3_vtab * pVTab, sqlite3_vtab_cursor ** ppCursor)
     cursor->lastConstraint = NULL;
     cursor->pVtab = (VirtualDbfPtr) pVTab;
     cursor->current_row = 0;
+    cursor->nFields = 0;
+    cursor->valuesLoaded = NULL;
+    if (cursor->pVtab->dbf->Valid)
+      {
+	  gaiaDbfFieldPtr pFld = cursor->pVtab->dbf->Dbf->First;
+	  while (pFld)
+	    {
+		cursor->nFields++;
+		pFld = pFld->Next;
+	    }
+	  if (cursor->nFields > 0)
+	    {
+		cursor->valuesLoaded = sqlite3_malloc (cursor->nFields);
+		if (cursor->valuesLoaded == NULL)
+		  {
+		      sqlite3_free (cursor);
+		      return SQLITE_NOMEM;
+		  }
+		memset (cursor->valuesLoaded, 0, cursor->nFields);
+	    }
+      }
     cursor->eof = 0;
     *ppCursor = (sqlite3_vtab_cursor *) cursor;
     while (1)
@@ -427,6 +501,10 @@ vdbf_close (sqlite3_vtab_cursor * pCursor)
 {
 /* closing the cursor */
     VirtualDbfCursorPtr cursor = (VirtualDbfCursorPtr) pCursor;
+    if (cursor->valuesLoaded)
+	sqlite3_free (cursor->valuesLoaded);
+    if (cursor->pVtab->Owner == cursor)
+	cursor->pVtab->Owner = NULL;
     vdbf_free_constraints (cursor);
     sqlite3_free (pCursor);
     return SQLITE_OK;
@@ -481,7 +559,7 @@ vdbf_parse_constraint (const char *str, int index, int *iColumn, int *op)
 static int
 vdbf_eval_constraints (VirtualDbfCursorPtr cursor)
 {
-/* evaluating Filter constraints */
+/* evaluating Filter constraints: -1 on a decoding failure */
     int nCol;
     gaiaDbfFieldPtr pFld;
     VirtualDbfConstraintPtr pC = cursor->firstConstraint;
@@ -527,6 +605,8 @@ vdbf_eval_constraints (VirtualDbfCursorPtr cursor)
 	    {
 		if (nCol == pC->iColumn)
 		  {
+		      if (!vdbf_load_value (cursor, pFld, nCol - 1))
+			  return -1;	/* an error occurred */
 		      if ((pFld->Value))
 			{
 			    switch (pFld->Value->Type)
@@ -689,6 +769,7 @@ vdbf_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
     int op;
     int len;
     int deleted;
+    int ret;
     VirtualDbfConstraintPtr pC;
     VirtualDbfCursorPtr cursor = (VirtualDbfCursorPtr) pCursor;
     if (idxNum)
@@ -745,7 +826,10 @@ vdbf_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 	      break;
 	  if (deleted)
 	      continue;
-	  if (vdbf_eval_constraints (cursor))
+	  ret = vdbf_eval_constraints (cursor);
+	  if (ret < 0)
+	      return vdbf_cursor_error (cursor);
+	  if (ret)
 	      break;
       }
     return SQLITE_OK;
@@ -756,6 +840,7 @@ vdbf_next (sqlite3_vtab_cursor * pCursor)
 {
 /* fetching a next row from cursor */
     int deleted;
+    int ret;
     VirtualDbfCursorPtr cursor = (VirtualDbfCursorPtr) pCursor;
     while (1)
       {
@@ -764,7 +849,10 @@ vdbf_next (sqlite3_vtab_cursor * pCursor)
 	      break;
 	  if (deleted)
 	      continue;
-	  if (vdbf_eval_constraints (cursor))
+	  ret = vdbf_eval_constraints (cursor);
+	  if (ret < 0)
+	      return vdbf_cursor_error (cursor);
+	  if (ret)
 	      break;
       }
     return SQLITE_OK;
@@ -798,6 +886,11 @@ vdbf_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 	  /* column values */
 	  if (nCol == column)
 	    {
+		if (!vdbf_load_value (cursor, pFld, nCol - 1))
+		  {
+		      vdbf_read_error (cursor, pContext);
+		      return SQLITE_ERROR;
+		  }
 		if (!(pFld->Value))
 		    sqlite3_result_null (pContext);
 		else
@@ -813,10 +906,11 @@ vdbf_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 						   pFld->Value->DblValue);
 			    break;
 			case GAIA_TEXT_VALUE:
+			    /* the value could be reset by any other cursor */
 			    sqlite3_result_text (pContext,
 						 pFld->Value->TxtValue,
 						 strlen (pFld->Value->TxtValue),
-						 SQLITE_STATIC);
+						 SQLITE_TRANSIENT);
 			    break;
 			default:
 			    sqlite3_result_null (pContext);
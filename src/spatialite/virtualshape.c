@@ -44,6 +44,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 */
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -80,6 +81,10 @@ typedef struct VirtualShapeStruct
     gaiaShapefilePtr Shp;	/* the Shapefile struct */
     int Srid;			/* the Shapefile SRID */
     int text_dates;
+    unsigned char *SpatialIndex;	/* the quadtree, laid out as a .qix file */
+    int SpatialIndexSize;	/* the quadtree size (in bytes) */
+    int SpatialIndexState;	/* 0 = not yet loaded, 1 = valid, -1 = missing */
+    void *Owner;		/* the cursor positioned on the current row */
 } VirtualShape;
 typedef VirtualShape *VirtualShapePtr;
 
@@ -88,10 +93,15 @@ typedef struct VirtualShapeConstraintStruct
 /* a constraint to be verified for xFilter */
     int iColumn;		/* Column on left-hand side of constraint */
     int op;			/* Constraint operator */
-    char valueType;		/* value Type ('I'=int,'D'=double,'T'=text) */
+    char valueType;		/* value Type ('I'=int,'D'=double,'T'=text,'M'=MBR) */
     sqlite3_int64 intValue;	/* Int64 comparison value */
     double dblValue;		/* Double comparison value */
     char *txtValue;		/* Text comparison value */
+    int mbrMode;		/* FilterMbr mode (MBR comparison) */
+    double minx;		/* MBR comparison frame */
+    double miny;
+    double maxx;
+    double maxy;
     struct VirtualShapeConstraintStruct *next;
 } VirtualShapeConstraint;
 typedef VirtualShapeConstraint *VirtualShapeConstraintPtr;
@@ -104,9 +114,15 @@ typedef struct VirtualShapeCursorStruct
     long current_row;		/* the current row ID */
     int blobSize;
     unsigned char *blobGeometry;
+    int geometryLoaded;		/* the Geometry has been already decoded */
+    int nFields;
+    char *valuesLoaded;		/* the DBF values already decoded */
     int eof;			/* the EOF marker */
     VirtualShapeConstraintPtr firstConstraint;
     VirtualShapeConstraintPtr lastConstraint;
+    int *candidates;		/* the rows selected by the Spatial Index */
+    int nCandidates;
+    int nextCandidate;
 } VirtualShapeCursor;
 typedef VirtualShapeCursor *VirtualShapeCursorPtr;
 
@@ -239,6 +255,10 @@ vshp_create (sqlite3 * db, void *pAux, int argc, const char *const *argv,
     p_vt->Shp = gaiaAllocShapefile ();
     p_vt->Srid = srid;
     p_vt->text_dates = text_dates;
+    p_vt->SpatialIndex = NULL;
+    p_vt->SpatialIndexSize = 0;
+    p_vt->SpatialIndexState = 0;
+    p_vt->Owner = NULL;
 /* trying to open files etc in order to ensure we actually have a genuine shapefile */
     gaiaOpenShpRead (p_vt->Shp, path, encoding, "UTF-8");
     if (!(p_vt->Shp->Valid))
@@ -573,6 +593,7 @@ vshp_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
 /* best index selection */
     int i;
     int iArg = 0;
+    int mbr = 0;
     char str[2048];
     char buf[64];
 
@@ -584,6 +605,9 @@ vshp_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
       {
 	  if (pIndex->aConstraint[i].usable)
 	    {
+		if (pIndex->aConstraint[i].iColumn == 1
+		    && pIndex->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ)
+		    mbr = 1;
 		iArg++;
 		pIndex->aConstraintUsage[i].argvIndex = iArg;
 		pIndex->aConstraintUsage[i].omit = 1;
@@ -597,6 +621,13 @@ vshp_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
 	  pIndex->idxStr = sqlite3_mprintf ("%s", str);
 	  pIndex->needToFreeIdxStr = 1;
       }
+    if (mbr)
+      {
+	  /* Geometry = FilterMbrXXX() will be resolved by the Spatial Index */
+	  pIndex->estimatedCost = 10.0;
+      }
+    else
+	pIndex->estimatedCost = 1000000.0;
 
     return SQLITE_OK;
 }
@@ -608,6 +639,8 @@ vshp_disconnect (sqlite3_vtab * pVTab)
     VirtualShapePtr p_vt = (VirtualShapePtr) pVTab;
     if (p_vt->Shp)
 	gaiaFreeShapefile (p_vt->Shp);
+    if (p_vt->SpatialIndex)
+	free (p_vt->SpatialIndex);
     sqlite3_free (p_vt);
     return SQLITE_OK;
 }
@@ -619,12 +652,490 @@ vshp_destroy (sqlite3_vtab * pVTab)
     return vshp_disconnect (pVTab);
 }
 
+/*
+/ the Spatial Index supporting Geometry = FilterMbrXXX() queries is a
+/ quadtree laid out exactly as a shapelib/MapServer .qix file
+/
+/ an already existing "<path>.qix" will be used as long as it isn't
+/ older than the Shapefile itself; otherwise the quadtree will be built
+/ on the fly by scanning the SHP record headers (and will be stored
+/ on behalf of further connections only if SPATIALITE_SECURITY=relaxed)
+*/
+
+#define VSHP_QIX_HEADER		16
+#define VSHP_QIX_NODE		44
+#define VSHP_QIX_MAX_DEPTH	12
+
+struct vshp_qnode
+{
+/* a quadtree node */
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+    int count;
+    int max_ids;
+    int *ids;
+    struct vshp_qnode *children[4];
+};
+
+static struct vshp_qnode *
+vshp_qnode_alloc (double minx, double miny, double maxx, double maxy)
+{
+/* allocating an empty quadtree node */
+    int q;
+    struct vshp_qnode *node = malloc (sizeof (struct vshp_qnode));
+    if (node == NULL)
+	return NULL;
+    node->minx = minx;
+    node->miny = miny;
+    node->maxx = maxx;
+    node->maxy = maxy;
+    node->count = 0;
+    node->max_ids = 0;
+    node->ids = NULL;
+    for (q = 0; q < 4; q++)
+	node->children[q] = NULL;
+    return node;
+}
+
+static void
+vshp_qnode_free (struct vshp_qnode *node)
+{
+/* memory cleanup - destroying a quadtree node */
+    int q;
+    if (node == NULL)
+	return;
+    for (q = 0; q < 4; q++)
+	vshp_qnode_free (node->children[q]);
+    if (node->ids)
+	free (node->ids);
+    free (node);
+}
+
+static int
+vshp_qnode_insert (struct vshp_qnode *node, int id, double minx,
+		   double miny, double maxx, double maxy, int depth)
+{
+/* inserting a feature into the deepest quadrant fully containing it */
+    int q;
+    double midx;
+    double midy;
+    double qminx;
+    double qminy;
+    double qmaxx;
+    double qmaxy;
+    while (depth > 1)
+      {
+	  midx = (node->minx + node->maxx) / 2.0;
+	  midy = (node->miny + node->maxy) / 2.0;
+	  for (q = 0; q < 4; q++)
+	    {
+		qminx = (q & 1) ? midx : node->minx;
+		qmaxx = (q & 1) ? node->maxx : midx;
+		qminy = (q & 2) ? midy : node->miny;
+		qmaxy = (q & 2) ? node->maxy : midy;
+		if (minx >= qminx && maxx <= qmaxx && miny >= qminy
+		    && maxy <= qmaxy)
+		    break;
+	    }
+	  if (q == 4)
+	      break;
+	  if (node->children[q] == NULL)
+	    {
+		node->children[q] = vshp_qnode_alloc (qminx, qminy, qmaxx,
+						      qmaxy);
+		if (node->children[q] == NULL)
+		    return 0;
+	    }
+	  node = node->children[q];
+	  depth--;
+      }
+    if (node->count == node->max_ids)
+      {
+	  int max_ids = (node->max_ids == 0) ? 4 : node->max_ids * 2;
+	  int *ids = realloc (node->ids, sizeof (int) * max_ids);
+	  if (ids == NULL)
+	      return 0;
+	  node->ids = ids;
+	  node->max_ids = max_ids;
+      }
+    node->ids[node->count++] = id;
+    return 1;
+}
+
+static int
+vshp_qnode_size (struct vshp_qnode *node)
+{
+/* computing the .qix size of some quadtree node (subnodes included) */
+    int q;
+    int size = VSHP_QIX_NODE + (node->count * 4);
+    for (q = 0; q < 4; q++)
+      {
+	  if (node->children[q])
+	      size += vshp_qnode_size (node->children[q]);
+      }
+    return size;
+}
+
+static unsigned char *
+vshp_qnode_store (struct vshp_qnode *node, unsigned char *p, int endian_arch)
+{
+/* serializing a quadtree node as a .qix node [little endian] */
+    int q;
+    int i;
+    int offset = 0;
+    int n_sub = 0;
+    for (q = 0; q < 4; q++)
+      {
+	  if (node->children[q])
+	    {
+		offset += vshp_qnode_size (node->children[q]);
+		n_sub++;
+	    }
+      }
+    gaiaExport32 (p, offset, GAIA_LITTLE_ENDIAN, endian_arch);
+    gaiaExport64 (p + 4, node->minx, GAIA_LITTLE_ENDIAN, endian_arch);
+    gaiaExport64 (p + 12, node->miny, GAIA_LITTLE_ENDIAN, endian_arch);
+    gaiaExport64 (p + 20, node->maxx, GAIA_LITTLE_ENDIAN, endian_arch);
+    gaiaExport64 (p + 28, node->maxy, GAIA_LITTLE_ENDIAN, endian_arch);
+    gaiaExport32 (p + 36, node->count, GAIA_LITTLE_ENDIAN, endian_arch);
+    p += 40;
+    for (i = 0; i < node->count; i++)
+      {
+	  gaiaExport32 (p, node->ids[i], GAIA_LITTLE_ENDIAN, endian_arch);
+	  p += 4;
+      }
+    gaiaExport32 (p, n_sub, GAIA_LITTLE_ENDIAN, endian_arch);
+    p += 4;
+    for (q = 0; q < 4; q++)
+      {
+	  if (node->children[q])
+	      p = vshp_qnode_store (node->children[q], p, endian_arch);
+      }
+    return p;
+}
+
+static void
+vshp_store_qix (VirtualShapePtr p_vt)
+{
+/* attempting to store the quadtree as "<path>.qix" */
+    FILE *out;
+    char *path = sqlite3_mprintf ("%s.qix", p_vt->Shp->Path);
+    out = fopen (path, "wb");
+    if (out != NULL)
+      {
+	  size_t wr = fwrite (p_vt->SpatialIndex, 1, p_vt->SpatialIndexSize,
+			      out);
+	  if (fclose (out) != 0 || wr != (size_t) (p_vt->SpatialIndexSize))
+	    {
+		/* removing a broken file */
+		remove (path);
+	    }
+      }
+    sqlite3_free (path);
+}
+
+static void
+vshp_build_index (VirtualShapePtr p_vt, int count)
+{
+/* building the quadtree by scanning the SHP record headers */
+    gaiaShapefilePtr shp = p_vt->Shp;
+    struct vshp_qnode *root;
+    int endian_arch = gaiaEndianArch ();
+    int row;
+    int depth = 0;
+    int max_nodes = 1;
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+    double rminx = shp->MinX;
+    double rminy = shp->MinY;
+    double rmaxx = shp->MaxX;
+    double rmaxy = shp->MaxY;
+    unsigned char *buf;
+    int size;
+
+/* same depth as chosen by shapelib's shptree */
+    while (max_nodes * 4 < count)
+      {
+	  depth++;
+	  max_nodes *= 2;
+      }
+    if (depth < 1)
+	depth = 1;
+    if (depth > VSHP_QIX_MAX_DEPTH)
+	depth = VSHP_QIX_MAX_DEPTH;
+
+    root = vshp_qnode_alloc (shp->MinX, shp->MinY, shp->MaxX, shp->MaxY);
+    if (root == NULL)
+	return;
+    for (row = 0; row < count; row++)
+      {
+	  if (!gaiaReadShpEntityMbr (shp, row, &minx, &miny, &maxx, &maxy))
+	      goto error;
+	  if (minx > maxx || miny > maxy)
+	      continue;		/* NULL shape */
+	  if (!vshp_qnode_insert (root, row, minx, miny, maxx, maxy, depth))
+	      goto error;
+	  /* the header BBOX could be inaccurate */
+	  if (minx < rminx)
+	      rminx = minx;
+	  if (miny < rminy)
+	      rminy = miny;
+	  if (maxx > rmaxx)
+	      rmaxx = maxx;
+	  if (maxy > rmaxy)
+	      rmaxy = maxy;
+      }
+    root->minx = rminx;
+    root->miny = rminy;
+    root->maxx = rmaxx;
+    root->maxy = rmaxy;
+
+    size = VSHP_QIX_HEADER + vshp_qnode_size (root);
+    buf = malloc (size);
+    if (buf == NULL)
+	goto error;
+    memcpy (buf, "SQT", 3);
+    buf[3] = 1;			/* LSB byte order */
+    buf[4] = 1;			/* version */
+    buf[5] = 0;
+    buf[6] = 0;
+    buf[7] = 0;
+    gaiaExport32 (buf + 8, count, GAIA_LITTLE_ENDIAN, endian_arch);
+    gaiaExport32 (buf + 12, depth, GAIA_LITTLE_ENDIAN, endian_arch);
+    vshp_qnode_store (root, buf + VSHP_QIX_HEADER, endian_arch);
+    vshp_qnode_free (root);
+    p_vt->SpatialIndex = buf;
+    p_vt->SpatialIndexSize = size;
+    if (splite_relaxed_security ())
+	vshp_store_qix (p_vt);
+    return;
+
+  error:
+    vshp_qnode_free (root);
+}
+
+static void
+vshp_load_qix (VirtualShapePtr p_vt, int count)
+{
+/* attempting to load an up-to-date "<path>.qix" */
+    struct stat st_shp;
+    struct stat st_qix;
+    FILE *in;
+    unsigned char *buf;
+    int size;
+    int little_endian;
+    int endian_arch = gaiaEndianArch ();
+    char *path = sqlite3_mprintf ("%s.shp", p_vt->Shp->Path);
+    int ret = stat (path, &st_shp);
+    sqlite3_free (path);
+    if (ret != 0)
+	return;
+    path = sqlite3_mprintf ("%s.qix", p_vt->Shp->Path);
+    ret = stat (path, &st_qix);
+    if (ret != 0 || st_qix.st_mtime < st_shp.st_mtime
+	|| st_qix.st_size < VSHP_QIX_HEADER + VSHP_QIX_NODE
+	|| st_qix.st_size > 0x7fffffff)
+      {
+	  sqlite3_free (path);
+	  return;
+      }
+    in = fopen (path, "rb");
+    sqlite3_free (path);
+    if (in == NULL)
+	return;
+    size = (int) (st_qix.st_size);
+    buf = malloc (size);
+    if (buf == NULL)
+      {
+	  fclose (in);
+	  return;
+      }
+    if (fread (buf, 1, size, in) != (size_t) size)
+	goto error;
+    if (memcmp (buf, "SQT", 3) != 0 || buf[4] != 1)
+	goto error;
+    if (buf[3] == 1)
+	little_endian = GAIA_LITTLE_ENDIAN;
+    else if (buf[3] == 2)
+	little_endian = GAIA_BIG_ENDIAN;
+    else if (buf[3] == 0)
+	little_endian = endian_arch;
+    else
+	goto error;
+    if (gaiaImport32 (buf + 8, little_endian, endian_arch) != count)
+	goto error;		/* not matching the Shapefile */
+    fclose (in);
+    p_vt->SpatialIndex = buf;
+    p_vt->SpatialIndexSize = size;
+    return;
+
+  error:
+    fclose (in);
+    free (buf);
+}
+
+static int
+vshp_add_candidate (VirtualShapeCursorPtr cursor, int id, int *max)
+{
+/* appending a row to the list of candidates */
+    if (cursor->nCandidates == *max)
+      {
+	  int *ids = realloc (cursor->candidates, sizeof (int) * *max * 2);
+	  if (ids == NULL)
+	      return 0;
+	  cursor->candidates = ids;
+	  *max *= 2;
+      }
+    cursor->candidates[cursor->nCandidates++] = id;
+    return 1;
+}
+
+static const unsigned char *
+vshp_qix_search (VirtualShapeCursorPtr cursor, VirtualShapeConstraintPtr pC,
+		 const unsigned char *p, const unsigned char *end,
+		 int little_endian, int depth, int *max)
+{
+/* recursively collecting the ids from all quadtree nodes overlapping the frame */
+    int endian_arch = gaiaEndianArch ();
+    int offset;
+    int count;
+    int n_sub;
+    int i;
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+    if (depth > 64 || end - p < VSHP_QIX_NODE)
+	return NULL;		/* corrupted quadtree */
+    offset = gaiaImport32 (p, little_endian, endian_arch);
+    minx = gaiaImport64 (p + 4, little_endian, endian_arch);
+    miny = gaiaImport64 (p + 12, little_endian, endian_arch);
+    maxx = gaiaImport64 (p + 20, little_endian, endian_arch);
+    maxy = gaiaImport64 (p + 28, little_endian, endian_arch);
+    count = gaiaImport32 (p + 36, little_endian, endian_arch);
+    p += 40;
+    if (offset < 0 || count < 0 || (end - p - 4) / 4 < count)
+	return NULL;
+    if (maxx < pC->minx || minx > pC->maxx || maxy < pC->miny
+	|| miny > pC->maxy)
+      {
+	  /* skipping the whole subtree */
+	  p += (count * 4) + 4;
+	  if (end - p < offset)
+	      return NULL;
+	  return p + offset;
+      }
+    for (i = 0; i < count; i++)
+      {
+	  if (!vshp_add_candidate
+	      (cursor, gaiaImport32 (p, little_endian, endian_arch), max))
+	      return NULL;
+	  p += 4;
+      }
+    n_sub = gaiaImport32 (p, little_endian, endian_arch);
+    p += 4;
+    for (i = 0; i < n_sub; i++)
+      {
+	  p = vshp_qix_search (cursor, pC, p, end, little_endian, depth + 1,
+			       max);
+	  if (p == NULL)
+	      return NULL;
+      }
+    return p;
+}
+
+static int
+vshp_cmp_ids (const void *p1, const void *p2)
+{
+/* compares two row ids [for QSORT] */
+    int id1 = *((const int *) p1);
+    int id2 = *((const int *) p2);
+    if (id1 < id2)
+	return -1;
+    if (id1 > id2)
+	return 1;
+    return 0;
+}
+
+static void
+vshp_spatial_query (VirtualShapeCursorPtr cursor,
+		    VirtualShapeConstraintPtr pC)
+{
+/* selecting the candidate rows by querying the Spatial Index */
+    VirtualShapePtr p_vt = cursor->pVtab;
+    const unsigned char *buf;
+    int little_endian;
+    int max = 64;
+    int count;
+    int i;
+    int n;
+
+    if (p_vt->SpatialIndexState == 0)
+      {
+	  /* lazily loading or building the Spatial Index */
+	  p_vt->SpatialIndexState = -1;
+	  count = gaiaShpRecordCount (p_vt->Shp);
+	  if (count >= 0)
+	    {
+		vshp_load_qix (p_vt, count);
+		if (p_vt->SpatialIndex == NULL)
+		    vshp_build_index (p_vt, count);
+		if (p_vt->SpatialIndex != NULL)
+		    p_vt->SpatialIndexState = 1;
+	    }
+      }
+    if (p_vt->SpatialIndexState != 1)
+	return;
+
+    cursor->candidates = malloc (sizeof (int) * max);
+    if (cursor->candidates == NULL)
+	return;
+    cursor->nCandidates = 0;
+    cursor->nextCandidate = 0;
+    buf = p_vt->SpatialIndex;
+    if (buf[3] == 1)
+	little_endian = GAIA_LITTLE_ENDIAN;
+    else if (buf[3] == 2)
+	little_endian = GAIA_BIG_ENDIAN;
+    else
+	little_endian = gaiaEndianArch ();
+    if (vshp_qix_search
+	(cursor, pC, buf + VSHP_QIX_HEADER, buf + p_vt->SpatialIndexSize,
+	 little_endian, 0, &max) == NULL)
+      {
+	  /* failure: falling back to a full scan */
+	  free (cursor->candidates);
+	  cursor->candidates = NULL;
+	  cursor->nCandidates = 0;
+	  return;
+      }
+
+/* sorting by row, so to read the Shapefile sequentially */
+    qsort (cursor->candidates, cursor->nCandidates, sizeof (int),
+	   vshp_cmp_ids);
+    count = gaiaShpRecordCount (p_vt->Shp);
+    n = 0;
+    for (i = 0; i < cursor->nCandidates; i++)
+      {
+	  /* a corrupted .qix could reference rows not in the Shapefile */
+	  if (cursor->candidates[i] < 0 || cursor->candidates[i] >= count)
+	      continue;
+	  if (n > 0 && cursor->candidates[n - 1] == cursor->candidates[i])
+	      continue;
+	  cursor->candidates[n++] = cursor->candidates[i];
+      }
+    cursor->nCandidates = n;
+}
+
 static void
 vshp_read_row (VirtualShapeCursorPtr cursor)
 {
-/* trying to read a "row" from shapefile */
+/* trying to read a "row" from shapefile - decoding is deferred */
     int ret;
-    gaiaGeomCollPtr geom;
     if (!(cursor->pVtab->Shp->Valid))
       {
 	  cursor->eof = 1;
@@ -635,9 +1146,12 @@ vshp_read_row (VirtualShapeCursorPtr cursor)
 	  free (cursor->blobGeometry);
 	  cursor->blobGeometry = NULL;
       }
-    ret =
-	gaiaReadShpEntity_ex (cursor->pVtab->Shp, cursor->current_row,
-			      cursor->pVtab->Srid, cursor->pVtab->text_dates);
+    cursor->blobSize = 0;
+    cursor->geometryLoaded = 0;
+    if (cursor->valuesLoaded)
+	memset (cursor->valuesLoaded, 0, cursor->nFields);
+    ret = gaiaReadShpEntityLazy (cursor->pVtab->Shp, cursor->current_row);
+    cursor->pVtab->Owner = cursor;
     if (!ret)
       {
 	  if (!(cursor->pVtab->Shp->LastError))	/* normal SHP EOF */
@@ -651,6 +1165,35 @@ vshp_read_row (VirtualShapeCursorPtr cursor)
 	  return;
       }
     cursor->current_row++;
+}
+
+static int
+vshp_sync_row (VirtualShapeCursorPtr cursor)
+{
+/*
+/ the raw DBF record is shared by all cursors: re-reading
+/ it if some other cursor has been positioned since then
+*/
+    if (cursor->pVtab->Owner == cursor)
+	return 1;
+    if (cursor->valuesLoaded)
+	memset (cursor->valuesLoaded, 0, cursor->nFields);
+    cursor->pVtab->Owner = cursor;
+    return gaiaReadShpEntityLazy (cursor->pVtab->Shp,
+				  cursor->current_row - 1);
+}
+
+static int
+vshp_load_geometry (VirtualShapeCursorPtr cursor)
+{
+/* decoding the current Geometry on demand */
+    gaiaGeomCollPtr geom;
+    if (cursor->geometryLoaded)
+	return 1;
+    if (!gaiaReadShpEntityGeometry
+	(cursor->pVtab->Shp, cursor->current_row - 1, cursor->pVtab->Srid))
+	return 0;
+    cursor->geometryLoaded = 1;
     geom = cursor->pVtab->Shp->Dbf->Geometry;
     if (geom)
       {
@@ -658,6 +1201,23 @@ vshp_read_row (VirtualShapeCursorPtr cursor)
 	  gaiaToSpatiaLiteBlobWkb (geom, &(cursor->blobGeometry),
 				   &(cursor->blobSize));
       }
+    return 1;
+}
+
+static int
+vshp_load_value (VirtualShapeCursorPtr cursor, gaiaDbfFieldPtr pFld,
+		 int index)
+{
+/* decoding some DBF value on demand */
+    if (!vshp_sync_row (cursor))
+	return 0;
+    if (cursor->valuesLoaded[index])
+	return 1;
+    if (!gaiaReadShpEntityValue
+	(cursor->pVtab->Shp, pFld, cursor->pVtab->text_dates))
+	return 0;
+    cursor->valuesLoaded[index] = 1;
+    return 1;
 }
 
 static int
@@ -670,10 +1230,35 @@ vshp_open (sqlite3_vtab * pVTab, sqlite3_vtab_cursor ** ppCursor)
 	return SQLITE_ERROR;
     cursor->firstConstraint = NULL;
     cursor->lastConstraint = NULL;
+    cursor->candidates = NULL;
+    cursor->nCandidates = 0;
+    cursor->nextCandidate = 0;
     cursor->pVtab = (VirtualShapePtr) pVTab;
     cursor->current_row = 0;
     cursor->blobGeometry = NULL;
     cursor->blobSize = 0;
+    cursor->geometryLoaded = 0;
+    cursor->nFields = 0;
+    cursor->valuesLoaded = NULL;
+    if (cursor->pVtab->Shp->Valid)
+      {
+	  gaiaDbfFieldPtr pFld = cursor->pVtab->Shp->Dbf->First;
+	  while (pFld)
+	    {
+		cursor->nFields++;
+		pFld = pFld->Next;
+	    }
+	  if (cursor->nFields > 0)
+	    {
+		cursor->valuesLoaded = sqlite3_malloc (cursor->nFields);
+		if (cursor->valuesLoaded == NULL)
+		  {
+		      sqlite3_free (cursor);
+		      return SQLITE_NOMEM;
+		  }
+		memset (cursor->valuesLoaded, 0, cursor->nFields);
+	    }
+      }
     cursor->eof = 0;
     *ppCursor = (sqlite3_vtab_cursor *) cursor;
     vshp_read_row (cursor);
@@ -697,6 +1282,11 @@ vshp_free_constraints (VirtualShapeCursorPtr cursor)
       }
     cursor->firstConstraint = NULL;
     cursor->lastConstraint = NULL;
+    if (cursor->candidates)
+	free (cursor->candidates);
+    cursor->candidates = NULL;
+    cursor->nCandidates = 0;
+    cursor->nextCandidate = 0;
 }
 
 static int
@@ -706,6 +1296,10 @@ vshp_close (sqlite3_vtab_cursor * pCursor)
     VirtualShapeCursorPtr cursor = (VirtualShapeCursorPtr) pCursor;
     if (cursor->blobGeometry)
 	free (cursor->blobGeometry);
+    if (cursor->valuesLoaded)
+	sqlite3_free (cursor->valuesLoaded);
+    if (cursor->pVtab->Owner == cursor)
+	cursor->pVtab->Owner = NULL;
     vshp_free_constraints (cursor);
     sqlite3_free (pCursor);
     return SQLITE_OK;
@@ -760,7 +1354,7 @@ vshp_parse_constraint (const char *str, int index, int *iColumn, int *op)
 static int
 vshp_eval_constraints (VirtualShapeCursorPtr cursor)
 {
-/* evaluating Filter constraints */
+/* evaluating Filter constraints: -1 on a decoding failure */
     int nCol;
     gaiaDbfFieldPtr pFld;
     VirtualShapeConstraintPtr pC = cursor->firstConstraint;
@@ -769,6 +1363,12 @@ vshp_eval_constraints (VirtualShapeCursorPtr cursor)
     while (pC)
       {
 	  int ok = 0;
+	  if (pC->valueType == 'M')
+	    {
+		/* already evaluated by vshp_eval_mbr() */
+		pC = pC->next;
+		continue;
+	    }
 	  if (pC->iColumn == 0)
 	    {
 		/* the PRIMARY KEY column */
@@ -806,6 +1406,8 @@ vshp_eval_constraints (VirtualShapeCursorPtr cursor)
 	    {
 		if (nCol == pC->iColumn)
 		  {
+		      if (!vshp_load_value (cursor, pFld, nCol - 2))
+			  return -1;	/* an error occurred */
 		      if ((pFld->Value))
 			{
 			    switch (pFld->Value->Type)
@@ -954,6 +1556,113 @@ vshp_eval_constraints (VirtualShapeCursorPtr cursor)
     return 1;
 }
 
+static int
+vshp_eval_mbr (VirtualShapeCursorPtr cursor)
+{
+/*
+/ evaluating the MBR constraints against the SHP record header,
+/ so to avoid decoding any row not satisfying them
+/ returns -1 on EOF
+*/
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+    int read = 0;
+    int ok;
+    VirtualShapeConstraintPtr pC = cursor->firstConstraint;
+    while (pC)
+      {
+	  if (pC->valueType != 'M')
+	    {
+		pC = pC->next;
+		continue;
+	    }
+	  if (!read)
+	    {
+		if (!gaiaReadShpEntityMbr
+		    (cursor->pVtab->Shp, cursor->current_row, &minx, &miny,
+		     &maxx, &maxy))
+		    return -1;
+		if (minx > maxx || miny > maxy)
+		    return 0;	/* NULL shape */
+		read = 1;
+	    }
+	  ok = 0;
+	  switch (pC->mbrMode)
+	    {
+	    case GAIA_FILTER_MBR_WITHIN:
+		if (minx >= pC->minx && maxx <= pC->maxx && miny >= pC->miny
+		    && maxy <= pC->maxy)
+		    ok = 1;
+		break;
+	    case GAIA_FILTER_MBR_CONTAINS:
+		if (pC->minx >= minx && pC->maxx <= maxx && pC->miny >= miny
+		    && pC->maxy <= maxy)
+		    ok = 1;
+		break;
+	    case GAIA_FILTER_MBR_INTERSECTS:
+		if (maxx >= pC->minx && minx <= pC->maxx && maxy >= pC->miny
+		    && miny <= pC->maxy)
+		    ok = 1;
+		break;
+	    };
+	  if (!ok)
+	      return 0;
+	  pC = pC->next;
+      }
+    return 1;
+}
+
+static int
+vshp_cursor_error (VirtualShapeCursorPtr cursor)
+{
+/* reporting a decoding failure from xFilter or xNext */
+    const char *msg = cursor->pVtab->Shp->LastError;
+    if (msg == NULL)
+	msg = "[VirtualShape module] unable to read the current row";
+    sqlite3_free (cursor->pVtab->zErrMsg);
+    cursor->pVtab->zErrMsg = sqlite3_mprintf ("%s", msg);
+    cursor->eof = 1;
+    return SQLITE_ERROR;
+}
+
+static int
+vshp_fetch_row (VirtualShapeCursorPtr cursor)
+{
+/* fetching the next row satisfying all Filter constraints */
+    int ret;
+    while (1)
+      {
+	  if (cursor->candidates != NULL)
+	    {
+		/* only visiting the rows selected by the Spatial Index */
+		if (cursor->nextCandidate >= cursor->nCandidates)
+		  {
+		      cursor->eof = 1;
+		      break;
+		  }
+		cursor->current_row =
+		    cursor->candidates[cursor->nextCandidate++];
+	    }
+	  if (vshp_eval_mbr (cursor) == 0)
+	    {
+		/* skipping this row without decoding it */
+		cursor->current_row++;
+		continue;
+	    }
+	  vshp_read_row (cursor);
+	  if (cursor->eof)
+	      break;
+	  ret = vshp_eval_constraints (cursor);
+	  if (ret < 0)
+	      return vshp_cursor_error (cursor);
+	  if (ret)
+	      break;
+      }
+    return SQLITE_OK;
+}
+
 static int
 vshp_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 	     int argc, sqlite3_value ** argv)
@@ -1003,6 +1712,25 @@ vshp_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 		    strcpy (pC->txtValue,
 			    (char *) sqlite3_value_text (argv[i]));
 	    }
+	  if (sqlite3_value_type (argv[i]) == SQLITE_BLOB && iColumn == 1
+	      && op == SQLITE_INDEX_CONSTRAINT_EQ)
+	    {
+		/* could be Geometry = FilterMbrXXX() */
+		int mode;
+		if (gaiaParseFilterMbr
+		    ((unsigned char *) sqlite3_value_blob (argv[i]),
+		     sqlite3_value_bytes (argv[i]), &(pC->minx), &(pC->miny),
+		     &(pC->maxx), &(pC->maxy), &mode))
+		  {
+		      if (mode == GAIA_FILTER_MBR_WITHIN
+			  || mode == GAIA_FILTER_MBR_CONTAINS
+			  || mode == GAIA_FILTER_MBR_INTERSECTS)
+			{
+			    pC->valueType = 'M';
+			    pC->mbrMode = mode;
+			}
+		  }
+	    }
 	  if (cursor->firstConstraint == NULL)
 	      cursor->firstConstraint = pC;
 	  if (cursor->lastConstraint != NULL)
@@ -1016,15 +1744,18 @@ vshp_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
     cursor->blobGeometry = NULL;
     cursor->blobSize = 0;
     cursor->eof = 0;
-    while (1)
+    pC = cursor->firstConstraint;
+    while (pC)
       {
-	  vshp_read_row (cursor);
-	  if (cursor->eof)
-	      break;
-	  if (vshp_eval_constraints (cursor))
-	      break;
+	  if (pC->valueType == 'M')
+	    {
+		/* the first MBR constraint will be resolved by the Spatial Index */
+		vshp_spatial_query (cursor, pC);
+		break;
+	    }
+	  pC = pC->next;
       }
-    return SQLITE_OK;
+    return vshp_fetch_row (cursor);
 }
 
 static int
@@ -1032,15 +1763,7 @@ vshp_next (sqlite3_vtab_cursor * pCursor)
 {
 /* fetching a next row from cursor */
     VirtualShapeCursorPtr cursor = (VirtualShapeCursorPtr) pCursor;
-    while (1)
-      {
-	  vshp_read_row (cursor);
-	  if (cursor->eof)
-	      break;
-	  if (vshp_eval_constraints (cursor))
-	      break;
-      }
-    return SQLITE_OK;
+    return vshp_fetch_row (cursor);
 }
 
 static int
@@ -1051,13 +1774,22 @@ vshp_eof (sqlite3_vtab_cursor * pCursor)
     return cursor->eof;
 }
 
+static void
+vshp_read_error (VirtualShapeCursorPtr cursor, sqlite3_context * pContext)
+{
+/* reporting a deferred decoding failure */
+    const char *msg = cursor->pVtab->Shp->LastError;
+    if (msg == NULL)
+	msg = "[VirtualShape module] unable to read the current row";
+    sqlite3_result_error (pContext, msg, -1);
+}
+
 static int
 vshp_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 	     int column)
 {
 /* fetching value for the Nth column */
     int nCol = 2;
-    gaiaGeomCollPtr geom;
     gaiaDbfFieldPtr pFld;
     VirtualShapeCursorPtr cursor = (VirtualShapeCursorPtr) pCursor;
     if (column == 0)
@@ -1069,8 +1801,12 @@ vshp_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
     if (column == 1)
       {
 	  /* the GEOMETRY column */
-	  geom = cursor->pVtab->Shp->Dbf->Geometry;
-	  if (geom)
+	  if (!vshp_load_geometry (cursor))
+	    {
+		vshp_read_error (cursor, pContext);
+		return SQLITE_ERROR;
+	    }
+	  if (cursor->blobGeometry)
 	      sqlite3_result_blob (pContext, cursor->blobGeometry,
 				   cursor->blobSize, SQLITE_STATIC);
 	  else
@@ -1083,6 +1819,11 @@ vshp_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 	  /* column values */
 	  if (nCol == column)
 	    {
+		if (!vshp_load_value (cursor, pFld, nCol - 2))
+		  {
+		      vshp_read_error (cursor, pContext);
+		      return SQLITE_ERROR;
+		  }
 		if (!(pFld->Value))
 		    sqlite3_result_null (pContext);
 		else
@@ -1098,10 +1839,11 @@ vshp_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 						   pFld->Value->DblValue);
 			    break;
 			case GAIA_TEXT_VALUE:
+			    /* the value could be reset by any other cursor */
 			    sqlite3_result_text (pContext,
 						 pFld->Value->TxtValue,
 						 strlen (pFld->Value->TxtValue),
-						 SQLITE_STATIC);
+						 SQLITE_TRANSIENT);
 			    break;
 			default:
 			    sqlite3_result_null (pContext);
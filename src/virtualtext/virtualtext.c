@@ -64,11 +64,35 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <spatialite/spatialite.h>
 #include <spatialite/gaiaaux.h>
 #include <spatialite/gaiageo.h>
+#include <spatialite_private.h>
 
 #ifdef _WIN32
 #define strcasecmp	_stricmp
 #endif /* not WIN32 */
 
+#ifndef _WIN32
+#define VRTTXT_MEMORY_MAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif /* not WIN32 */
+
+#ifndef _WIN32
+/* large files are parsed by more threads at once */
+#define VRTTXT_PARALLEL_PARSE
+#include <pthread.h>
+#include <unistd.h>
+#endif /* not WIN32 */
+
+#define VRTTXT_PARALLEL_MIN_SIZE	(8 * 1024 * 1024)	/* smaller files are parsed serially */
+#define VRTTXT_PARALLEL_MIN_CHUNK	(1024 * 1024)
+#define VRTTXT_PARALLEL_MAX_THREADS	16
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VRTTXT_SSE2_SCANNER
+#endif
+
 #if OMIT_ICONV == 0		/* if ICONV is disabled no TXT support is available */
 
 struct sqlite3_module virtualtext_module;
@@ -81,6 +105,7 @@ typedef struct VirtualTextStruct
     char *zErrMsg;		/* error message: USED INTERNALLY BY SQLITE */
     sqlite3 *db;		/* the sqlite db holding the virtual table */
     gaiaTextReaderPtr reader;	/* the TextReader object */
+    int ascii_utf8;		/* TRUE if ASCII chars are never changed by the charset converter */
 } VirtualText;
 typedef VirtualText *VirtualTextPtr;
 
@@ -93,6 +118,7 @@ typedef struct VirtualTextConstraintStruct
     sqlite3_int64 intValue;	/* Int64 comparison value */
     double dblValue;		/* Double comparison value */
     char *txtValue;		/* Text comparison value */
+    int txtLen;			/* length (in bytes) of the Text comparison value */
     struct VirtualTextConstraintStruct *next;
 } VirtualTextConstraint;
 typedef VirtualTextConstraint *VirtualTextConstraintPtr;
@@ -103,6 +129,8 @@ typedef struct VirtualTextCursortStruct
     VirtualTextPtr pVtab;	/* Virtual table of this cursor */
     long current_row;		/* the current row ID */
     int eof;			/* the EOF marker */
+    long min_row;		/* the first row to be scanned */
+    long max_row;		/* the last row to be scanned */
     VirtualTextConstraintPtr firstConstraint;
     VirtualTextConstraintPtr lastConstraint;
 } VirtualTextCursor;
@@ -153,6 +181,30 @@ text_clean_double (char *value)
       }
 }
 
+static int
+vtxt_check_ascii (gaiaTextReaderPtr text)
+{
+/*
+/ checking if the charset converter leaves all ASCII chars unchanged;
+/ if so any plain ASCII value can be directly compared against the
+/ raw bytes of the input file
+*/
+    char probe[128];
+    char *utf8;
+    int err;
+    int i;
+    int ok = 0;
+    for (i = 1; i < 128; i++)
+	probe[i - 1] = (char) i;
+    probe[127] = '\0';
+    utf8 = gaiaConvertToUTF8 (text->toUtf8, probe, 127, &err);
+    if (!err && utf8 != NULL && strcmp (utf8, probe) == 0)
+	ok = 1;
+    if (utf8)
+	free (utf8);
+    return ok;
+}
+
 static int
 vtxt_create (sqlite3 * db, void *pAux, int argc, const char *const *argv,
 	     sqlite3_vtab ** ppVTab, char **pzErr)
@@ -255,6 +307,7 @@ vtxt_create (sqlite3 * db, void *pAux, int argc, const char *const *argv,
     p_vt->nRef = 0;
     p_vt->zErrMsg = NULL;
     p_vt->db = db;
+    p_vt->ascii_utf8 = 0;
     text = gaiaTextReaderAlloc (path, field_separator,
 				text_separator, decimal_separator,
 				first_line_titles, encoding);
@@ -283,6 +336,7 @@ vtxt_create (sqlite3 * db, void *pAux, int argc, const char *const *argv,
 	  return SQLITE_OK;
       }
     p_vt->reader = text;
+    p_vt->ascii_utf8 = vtxt_check_ascii (text);
 /* preparing the COLUMNs for this VIRTUAL TABLE */
     sprintf (sql, "CREATE TABLE %s (ROWNO INTEGER", vtable);
     col_name = malloc (sizeof (char *) * text->max_fields);
@@ -340,22 +394,46 @@ vtxt_connect (sqlite3 * db, void *pAux, int argc, const char *const *argv,
     return vtxt_create (db, pAux, argc, argv, ppVTab, pzErr);
 }
 
+static int
+vtxt_supported_op (int op)
+{
+/* checking if a constraint operator can be evaluated by xFilter */
+    switch (op)
+      {
+      case SQLITE_INDEX_CONSTRAINT_EQ:
+      case SQLITE_INDEX_CONSTRAINT_GT:
+      case SQLITE_INDEX_CONSTRAINT_LE:
+      case SQLITE_INDEX_CONSTRAINT_LT:
+      case SQLITE_INDEX_CONSTRAINT_GE:
+	  return 1;
+      };
+    return 0;
+}
+
 static int
 vtxt_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
 {
-/* best index selection */
+/*
+/ best index selection
+/ - constraints on ROWNO directly narrow the range of rows to be scanned
+/ - any other constraint still requires reading each row, but reduces
+/   the number of rows to be returned
+*/
     int i;
     int iArg = 0;
     char str[2048];
     char buf[64];
+    double scanned = 1000000.0;
+    double selected;
+    VirtualTextPtr p_vt = (VirtualTextPtr) pVTab;
 
-    if (pVTab)
-	pVTab = pVTab;		/* unused arg warning suppression */
-
+    if (p_vt->reader != NULL)
+	scanned = p_vt->reader->num_rows;
     *str = '\0';
     for (i = 0; i < pIndex->nConstraint; i++)
       {
-	  if (pIndex->aConstraint[i].usable)
+	  if (pIndex->aConstraint[i].usable
+	      && vtxt_supported_op (pIndex->aConstraint[i].op))
 	    {
 		iArg++;
 		pIndex->aConstraintUsage[i].argvIndex = iArg;
@@ -363,6 +441,26 @@ vtxt_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
 		sprintf (buf, "%d:%d,", pIndex->aConstraint[i].iColumn,
 			 pIndex->aConstraint[i].op);
 		strcat (str, buf);
+		if (pIndex->aConstraint[i].iColumn == 0)
+		  {
+		      if (pIndex->aConstraint[i].op ==
+			  SQLITE_INDEX_CONSTRAINT_EQ)
+			  scanned = 1.0;
+		      else
+			  scanned /= 4.0;
+		  }
+	    }
+      }
+    selected = scanned;
+    for (i = 0; i < pIndex->nConstraint; i++)
+      {
+	  if (pIndex->aConstraintUsage[i].argvIndex > 0
+	      && pIndex->aConstraint[i].iColumn > 0)
+	    {
+		if (pIndex->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ)
+		    selected /= 10.0;
+		else
+		    selected /= 3.0;
 	    }
       }
     if (*str != '\0')
@@ -370,6 +468,21 @@ vtxt_best_index (sqlite3_vtab * pVTab, sqlite3_index_info * pIndex)
 	  pIndex->idxStr = sqlite3_mprintf ("%s", str);
 	  pIndex->needToFreeIdxStr = 1;
       }
+    if (pIndex->nOrderBy == 1 && !(pIndex->aOrderBy[0].desc)
+	&& pIndex->aOrderBy[0].iColumn <= 0)
+      {
+	  /* rows are always returned sorted by ROWNO */
+	  pIndex->orderByConsumed = 1;
+      }
+    if (scanned < 1.0)
+	scanned = 1.0;
+    if (selected < 1.0)
+	selected = 1.0;
+    pIndex->estimatedCost = scanned;
+#if SQLITE_VERSION_NUMBER >= 3008002
+    if (sqlite3_libversion_number () >= 3008002)
+	pIndex->estimatedRows = (sqlite3_int64) selected;
+#endif
 
     return SQLITE_OK;
 }
@@ -404,10 +517,14 @@ vtxt_open (sqlite3_vtab * pVTab, sqlite3_vtab_cursor ** ppCursor)
     cursor->pVtab = (VirtualTextPtr) pVTab;
     cursor->current_row = 0;
     cursor->eof = 0;
+    cursor->min_row = 0;
+    cursor->max_row = -1;
     cursor->firstConstraint = NULL;
     cursor->lastConstraint = NULL;
     *ppCursor = (sqlite3_vtab_cursor *) cursor;
     text = cursor->pVtab->reader;
+    if (text)
+	cursor->max_row = text->num_rows - 1;
     if (!text)
 	cursor->eof = 1;
     else
@@ -495,17 +612,88 @@ vtxt_parse_constraint (const char *str, int index, int *iColumn, int *op)
     return 0;
 }
 
+static const char *
+vtxt_raw_field (gaiaTextReaderPtr text, int field_idx, int *len)
+{
+/*
+/ returning the raw bytes (not yet converted to UTF-8) of some Field
+/ of the current Line; NULL values are identified exactly as
+/ gaiaTextReaderFetchField would do
+*/
+    const char *value;
+    int n;
+    if (field_idx < 0 || field_idx >= text->max_fields
+	|| field_idx >= text->max_current_field)
+	return NULL;
+    value = text->line_buffer + text->field_offsets[field_idx];
+    n = text->field_lens[field_idx];
+    if (n == 1 && *value == '\r' && (field_idx + 1) == text->max_fields)
+	return NULL;
+    if (n <= 0 || *value == '\0')
+	return NULL;
+    *len = n;
+    return value;
+}
+
 static int
-vtxt_eval_constraints (VirtualTextCursorPtr cursor)
+vtxt_raw_text (VirtualTextCursorPtr cursor, const char *value, int len,
+	       const char **str, int *str_len)
 {
-/* evaluating Filter constraints */
-    int nCol;
+/*
+/ attempting to locate a TEXT value directly within the raw bytes:
+/ this is only possible for plain ASCII values when the charset
+/ converter leaves ASCII chars unchanged
+/ - returns -1 if the value requires to be fully decoded
+/ - returns 0 for NULL values
+*/
+    gaiaTextReaderPtr text = cursor->pVtab->reader;
     int i;
+    if (!(cursor->pVtab->ascii_utf8))
+	return -1;
+    for (i = 0; i < len; i++)
+      {
+	  unsigned char c = (unsigned char) (value[i]);
+	  if (c == 0 || c > 127)
+	      return -1;
+      }
+    if (value[len - 1] == '\r')
+      {
+	  /* skipping trailing CR, if any */
+	  len--;
+	  if (len == 0)
+	      return -1;
+      }
+    if (value[0] == text->text_separator
+	&& value[len - 1] == text->text_separator)
+      {
+	  /* skipping the enclosing quotes */
+	  value++;
+	  len -= 2;
+	  if (len <= 0)
+	      return 0;
+      }
+    *str = value;
+    *str_len = len;
+    return 1;
+}
+
+static int
+vtxt_eval_constraints (VirtualTextCursorPtr cursor)
+{
+/*
+/ evaluating Filter constraints
+/ - INTEGER and DOUBLE values are directly parsed from the raw bytes
+/ - plain ASCII TEXT values are directly compared against the raw bytes
+/ - only the remaining TEXT values require to be converted to UTF-8
+*/
     char buf[4096];
     int type;
     const char *value = NULL;
+    int len;
     sqlite3_int64 int_value;
     double dbl_value;
+    const char *str;
+    int str_len;
     char *txt_value = NULL;
     int is_int = 0;
     int is_dbl = 0;
@@ -518,57 +706,64 @@ vtxt_eval_constraints (VirtualTextCursorPtr cursor)
     while (pC)
       {
 	  int ok = 0;
-	  if (pC->iColumn == 0)
+	  int ret = 0;
+	  is_int = 0;
+	  is_dbl = 0;
+	  is_txt = 0;
+	  value = vtxt_raw_field (text, pC->iColumn - 1, &len);
+	  if (value == NULL)
+	      return 0;		/* NULL never matches */
+	  type = text->columns[pC->iColumn - 1].type;
+	  if (type == VRTTXT_INTEGER || type == VRTTXT_DOUBLE)
 	    {
-		/* the ROWNO column */
-		int_value = cursor->current_row;
-		is_int = 1;
-		goto eval;
-	    }
-	  nCol = 1;
-	  for (i = 0; i < text->max_fields; i++)
-	    {
-		is_int = 0;
-		is_dbl = 0;
-		is_txt = 0;
-		if (nCol == pC->iColumn)
+		if (len >= (int) sizeof (buf))
+		    len = sizeof (buf) - 1;
+		memcpy (buf, value, len);
+		buf[len] = '\0';
+		if (type == VRTTXT_INTEGER)
 		  {
-
-		      if (!gaiaTextReaderFetchField (text, i, &type, &value))
-			  ;
-		      else
-			{
-			    if (type == VRTTXT_INTEGER)
-			      {
-				  strcpy (buf, value);
-				  text_clean_integer (buf);
+		      text_clean_integer (buf);
 #if defined(_WIN32) || defined(__MINGW32__)
 /* CAVEAT - M$ runtime has non-standard functions for 64 bits */
-				  int_value = _atoi64 (buf);
+		      int_value = _atoi64 (buf);
 #else
-				  int_value = atoll (buf);
+		      int_value = atoll (buf);
 #endif
-				  is_int = 1;
-			      }
-			    else if (type == VRTTXT_DOUBLE)
-			      {
-				  strcpy (buf, value);
-				  text_clean_double (buf);
-				  dbl_value = atof (buf);
-				  is_dbl = 1;
-			      }
-			    else if (type == VRTTXT_TEXT)
-			      {
-				  txt_value = (char *) value;
-				  is_txt = 1;
-			      }
-			}
-		      goto eval;
+		      is_int = 1;
+		  }
+		else
+		  {
+		      text_clean_double (buf);
+		      dbl_value = atof (buf);
+		      is_dbl = 1;
 		  }
-		nCol++;
 	    }
-	  return 0;
-	eval:
+	  else if (type == VRTTXT_TEXT && pC->valueType == 'T')
+	    {
+		ret = vtxt_raw_text (cursor, value, len, &str, &str_len);
+		if (ret == 0)
+		    return 0;
+		if (ret < 0)
+		  {
+		      /* full decoding is required */
+		      if (!gaiaTextReaderFetchField
+			  (text, pC->iColumn - 1, &type, &value)
+			  || type != VRTTXT_TEXT)
+			  return 0;
+		      txt_value = (char *) value;
+		      ret = strcmp (txt_value, pC->txtValue);
+		      free (txt_value);
+		  }
+		else
+		  {
+		      ret =
+			  memcmp (str, pC->txtValue,
+				  (str_len < pC->txtLen) ? str_len : pC->txtLen);
+		      if (ret == 0)
+			  ret = str_len - pC->txtLen;
+		  }
+		is_txt = 1;
+	    }
 	  ok = 0;
 	  if (pC->valueType == 'I')
 	    {
@@ -684,7 +879,6 @@ vtxt_eval_constraints (VirtualTextCursorPtr cursor)
 	    {
 		if (is_txt)
 		  {
-		      int ret = strcmp (txt_value, pC->txtValue);
 		      switch (pC->op)
 			{
 			case SQLITE_INDEX_CONSTRAINT_EQ:
@@ -710,20 +904,96 @@ vtxt_eval_constraints (VirtualTextCursorPtr cursor)
 			};
 		  }
 	    }
-	  if (txt_value)
-	    {
-		free (txt_value);
-		txt_value = NULL;
-	    }
 	  if (!ok)
 	      return 0;
 	  pC = pC->next;
       }
-    if (txt_value)
-	free (txt_value);
     return 1;
 }
 
+static long
+vtxt_clamp_row (gaiaTextReaderPtr text, double value)
+{
+/* clamping a ROWNO value into the range [-1, num_rows] */
+    if (value < -1.0)
+	return -1;
+    if (value > (double) (text->num_rows))
+	return text->num_rows;
+    return (long) value;
+}
+
+static void
+vtxt_rowno_range (VirtualTextCursorPtr cursor, int op, sqlite3_value * arg)
+{
+/*
+/ a constraint on ROWNO simply narrows the range of rows to be scanned:
+/ LO and HI are the smallest and the largest integers such as
+/ LO >= value and HI <= value
+*/
+    gaiaTextReaderPtr text = cursor->pVtab->reader;
+    double value;
+    long lo;
+    long hi;
+    if (sqlite3_value_type (arg) == SQLITE_INTEGER)
+      {
+	  sqlite3_int64 int_value = sqlite3_value_int64 (arg);
+	  if (int_value < -1)
+	      lo = -1;
+	  else if (int_value > text->num_rows)
+	      lo = text->num_rows;
+	  else
+	      lo = (long) int_value;
+	  hi = lo;
+      }
+    else if (sqlite3_value_type (arg) == SQLITE_FLOAT)
+      {
+	  value = sqlite3_value_double (arg);
+	  if (value != value)
+	    {
+		/* NaN never matches */
+		cursor->max_row = -1;
+		return;
+	    }
+	  hi = vtxt_clamp_row (text, value);
+	  if ((double) hi > value)
+	      hi--;
+	  lo = hi;
+	  if ((double) lo < value)
+	      lo++;
+      }
+    else
+      {
+	  /* TEXT, BLOB or NULL: ROWNO never matches */
+	  cursor->max_row = -1;
+	  return;
+      }
+    switch (op)
+      {
+      case SQLITE_INDEX_CONSTRAINT_EQ:
+	  if (lo > cursor->min_row)
+	      cursor->min_row = lo;
+	  if (hi < cursor->max_row)
+	      cursor->max_row = hi;
+	  break;
+      case SQLITE_INDEX_CONSTRAINT_GT:
+	  if (hi + 1 > cursor->min_row)
+	      cursor->min_row = hi + 1;
+	  break;
+      case SQLITE_INDEX_CONSTRAINT_GE:
+	  if (lo > cursor->min_row)
+	      cursor->min_row = lo;
+	  break;
+      case SQLITE_INDEX_CONSTRAINT_LT:
+	  if (lo - 1 < cursor->max_row)
+	      cursor->max_row = lo - 1;
+	  break;
+      case SQLITE_INDEX_CONSTRAINT_LE:
+	  if (hi < cursor->max_row)
+	      cursor->max_row = hi;
+	  break;
+      };
+}
+
 static int
 vtxt_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 	     int argc, sqlite3_value ** argv)
@@ -741,11 +1011,27 @@ vtxt_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 
 /* resetting any previously set filter constraint */
     vtxt_free_constraints (cursor);
+    cursor->current_row = 0;
+    cursor->eof = 0;
+    cursor->min_row = 0;
+    cursor->max_row = -1;
+    if (!text)
+      {
+	  cursor->eof = 1;
+	  return SQLITE_OK;
+      }
+    cursor->max_row = text->num_rows - 1;
 
     for (i = 0; i < argc; i++)
       {
 	  if (!vtxt_parse_constraint (idxStr, i, &iColumn, &op))
 	      continue;
+	  if (iColumn == 0)
+	    {
+		/* the ROWNO column */
+		vtxt_rowno_range (cursor, op, argv[i]);
+		continue;
+	    }
 	  pC = sqlite3_malloc (sizeof (VirtualTextConstraint));
 	  if (!pC)
 	      continue;
@@ -753,6 +1039,7 @@ vtxt_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 	  pC->op = op;
 	  pC->valueType = '\0';
 	  pC->txtValue = NULL;
+	  pC->txtLen = 0;
 	  pC->next = NULL;
 
 	  if (sqlite3_value_type (argv[i]) == SQLITE_INTEGER)
@@ -771,8 +1058,13 @@ vtxt_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 		len = sqlite3_value_bytes (argv[i]) + 1;
 		pC->txtValue = (char *) sqlite3_malloc (len);
 		if (pC->txtValue)
-		    strcpy (pC->txtValue,
-			    (char *) sqlite3_value_text (argv[i]));
+		  {
+		      strcpy (pC->txtValue,
+			      (char *) sqlite3_value_text (argv[i]));
+		      pC->txtLen = strlen (pC->txtValue);
+		  }
+		else
+		    pC->valueType = '\0';
 	    }
 	  if (cursor->firstConstraint == NULL)
 	      cursor->firstConstraint = pC;
@@ -781,11 +1073,11 @@ vtxt_filter (sqlite3_vtab_cursor * pCursor, int idxNum, const char *idxStr,
 	  cursor->lastConstraint = pC;
       }
 
-    cursor->current_row = 0;
-    cursor->eof = 0;
+    cursor->current_row = cursor->min_row;
     while (1)
       {
-	  if (!gaiaTextReaderGetRow (text, cursor->current_row))
+	  if (cursor->current_row > cursor->max_row
+	      || !gaiaTextReaderGetRow (text, cursor->current_row))
 	    {
 		cursor->eof = 1;
 		break;
@@ -810,7 +1102,8 @@ vtxt_next (sqlite3_vtab_cursor * pCursor)
 	  while (1)
 	    {
 		cursor->current_row++;
-		if (!gaiaTextReaderGetRow (text, cursor->current_row))
+		if (cursor->current_row > cursor->max_row
+		    || !gaiaTextReaderGetRow (text, cursor->current_row))
 		  {
 		      cursor->eof = 1;
 		      break;
@@ -835,8 +1128,7 @@ vtxt_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
 	     int column)
 {
 /* fetching value for the Nth column */
-    int nCol = 1;
-    int i;
+    int i = column - 1;
     char buf[4096];
     int type;
     const char *value;
@@ -850,39 +1142,33 @@ vtxt_column (sqlite3_vtab_cursor * pCursor, sqlite3_context * pContext,
       }
     if (text->current_line_ready == 0)
 	return SQLITE_ERROR;
-    for (i = 0; i < text->max_fields; i++)
+    if (i >= text->max_fields)
+	return SQLITE_OK;
+    if (!gaiaTextReaderFetchField (text, i, &type, &value))
+	sqlite3_result_null (pContext);
+    else
       {
-	  if (nCol == column)
+	  if (type == VRTTXT_INTEGER)
 	    {
-		if (!gaiaTextReaderFetchField (text, i, &type, &value))
-		    sqlite3_result_null (pContext);
-		else
-		  {
-		      if (type == VRTTXT_INTEGER)
-			{
-			    strcpy (buf, value);
-			    text_clean_integer (buf);
+		strcpy (buf, value);
+		text_clean_integer (buf);
 #if defined(_WIN32) || defined(__MINGW32__)
 /* CAVEAT - M$ runtime has non-standard functions for 64 bits */
-			    sqlite3_result_int64 (pContext, _atoi64 (buf));
+		sqlite3_result_int64 (pContext, _atoi64 (buf));
 #else
-			    sqlite3_result_int64 (pContext, atoll (buf));
+		sqlite3_result_int64 (pContext, atoll (buf));
 #endif
-			}
-		      else if (type == VRTTXT_DOUBLE)
-			{
-			    strcpy (buf, value);
-			    text_clean_double (buf);
-			    sqlite3_result_double (pContext, atof (buf));
-			}
-		      else if (type == VRTTXT_TEXT)
-			  sqlite3_result_text (pContext, value, strlen (value),
-					       free);
-		      else
-			  sqlite3_result_null (pContext);
-		  }
 	    }
-	  nCol++;
+	  else if (type == VRTTXT_DOUBLE)
+	    {
+		strcpy (buf, value);
+		text_clean_double (buf);
+		sqlite3_result_double (pContext, atof (buf));
+	    }
+	  else if (type == VRTTXT_TEXT)
+	      sqlite3_result_text (pContext, value, strlen (value), free);
+	  else
+	      sqlite3_result_null (pContext);
       }
     return SQLITE_OK;
 }
@@ -982,6 +1268,20 @@ virtualtext_extension_init (void *xdb)
 **
 */
 
+struct vrttxt_handle
+{
+/*
+/ the TXT-Reader as allocated by gaiaTextReaderAlloc(), extended by
+/ some private state never exposed by the public struct
+*/
+    gaiaTextReader txt;		/* must be the first member */
+    char *map;			/* the memory mapped input file (may be NULL) */
+    size_t map_size;		/* size (in bytes) of the memory mapped file */
+};
+
+#define VRTTXT_MAP_OF(txt)	(((struct vrttxt_handle *) (txt))->map)
+#define VRTTXT_MAP_SIZE_OF(txt)	(((struct vrttxt_handle *) (txt))->map_size)
+
 static struct vrttxt_row_block *
 vrttxt_block_alloc ()
 {
@@ -1030,6 +1330,10 @@ gaiaTextReaderDestroy (gaiaTextReaderPtr reader)
 	  if (reader->rows)
 	      free (reader->rows);
 	  /* closing the input file */
+#ifdef VRTTXT_MEMORY_MAP
+	  if (VRTTXT_MAP_OF (reader) != NULL)
+	      munmap (VRTTXT_MAP_OF (reader), VRTTXT_MAP_SIZE_OF (reader));
+#endif
 	  fclose (reader->text_file);
 	  for (col = 0; col < VRTTXT_FIELDS_MAX; col++)
 	    {
@@ -1055,13 +1359,15 @@ gaiaTextReaderAlloc (const char *path, char field_separator,
 	return NULL;
 
 /* allocating and initializing the struct */
-    reader = malloc (sizeof (gaiaTextReader));
+    reader = malloc (sizeof (struct vrttxt_handle));
     if (!reader)
       {
 	  fclose (in);
 	  return NULL;
       }
     reader->text_file = in;
+    VRTTXT_MAP_OF (reader) = NULL;
+    VRTTXT_MAP_SIZE_OF (reader) = 0;
     reader->field_separator = field_separator;
     reader->text_separator = text_separator;
     reader->decimal_separator = decimal_separator;
@@ -1290,7 +1596,8 @@ vrttxt_set_column_title (gaiaTextReaderPtr txt, int col_no, const char *name)
 }
 
 static void
-vrttxt_add_line (gaiaTextReaderPtr txt, struct vrttxt_line *line)
+vrttxt_add_line (gaiaTextReaderPtr txt, struct vrttxt_line *line,
+		 const char *line_buffer)
 {
 /* appending a Line offset to the main TXT-Reader */
     struct vrttxt_row_block *p_block;
@@ -1366,12 +1673,19 @@ vrttxt_add_line (gaiaTextReaderPtr txt, struct vrttxt_line *line)
       {
 	  /* setting the corresponding Column (aka Field) header */
 	  len = line->field_offsets[ind] - off;
+	  if (txt->columns[ind].type == VRTTXT_TEXT
+	      && !(txt->first_line_titles && first_line))
+	    {
+		/* already TEXT: no further value could change the type */
+		off = line->field_offsets[ind] + 1;
+		continue;
+	    }
 	  if (len == 0)
 	      *(txt->field_buffer) = '\0';
 	  else
 	    {
 		/* retrieving the current Field Value */
-		memcpy (txt->field_buffer, txt->line_buffer + off, len);
+		memcpy (txt->field_buffer, line_buffer + off, len);
 		*(txt->field_buffer + len) = '\0';
 	    }
 	  if (txt->first_line_titles && first_line)
@@ -1507,25 +1821,694 @@ vrttxt_build_line_array (gaiaTextReaderPtr txt)
       }
 }
 
-GAIAGEO_DECLARE int
-gaiaTextReaderParse (gaiaTextReaderPtr txt)
+struct vrttxt_scanner
 {
-/* 
-/ preliminary parsing
-/ - reading the input file until EOF
-/ - then feeding the Row offsets structs
-/   to be used for any subsequent access
+/* searching the next relevant char within a memory buffer */
+    char c1;
+    char c2;
+    char c3;
+    char c4;
+    unsigned char relevant[256];
+};
+
+static void
+vrttxt_scanner_init (struct vrttxt_scanner *scan, char c1, char c2, char c3,
+		     char c4)
+{
+/* initializing a Scanner for up to four relevant chars */
+    memset (scan->relevant, 0, 256);
+    scan->c1 = c1;
+    scan->c2 = c2;
+    scan->c3 = c3;
+    scan->c4 = c4;
+    scan->relevant[(unsigned char) c1] = 1;
+    scan->relevant[(unsigned char) c2] = 1;
+    scan->relevant[(unsigned char) c3] = 1;
+    scan->relevant[(unsigned char) c4] = 1;
+}
+
+#ifdef VRTTXT_SSE2_SCANNER
+static int
+vrttxt_first_bit (int mask)
+{
+/* returning the position of the lowest bit set */
+#if defined(__GNUC__)
+    return __builtin_ctz ((unsigned int) mask);
+#else
+    int pos = 0;
+    while ((mask & 1) == 0)
+      {
+	  mask >>= 1;
+	  pos++;
+      }
+    return pos;
+#endif
+}
+#endif
+
+static size_t
+vrttxt_scan (const struct vrttxt_scanner *scan, const char *buf, size_t pos,
+	     size_t end)
+{
+/*
+/ returning the position of the next relevant char, or END
+/ - blocks of 16 chars at once are tested by the SSE2 kernel
+/ - a lookup table handles the tail (and any other platform)
 */
-    char name[64];
-    int ind;
-    int i2;
+#ifdef VRTTXT_SSE2_SCANNER
+    __m128i v1 = _mm_set1_epi8 (scan->c1);
+    __m128i v2 = _mm_set1_epi8 (scan->c2);
+    __m128i v3 = _mm_set1_epi8 (scan->c3);
+    __m128i v4 = _mm_set1_epi8 (scan->c4);
+    while (pos + 16 <= end)
+      {
+	  __m128i blk = _mm_loadu_si128 ((const __m128i *) (buf + pos));
+	  __m128i hit =
+	      _mm_or_si128 (_mm_or_si128
+			    (_mm_cmpeq_epi8 (blk, v1), _mm_cmpeq_epi8 (blk, v2)),
+			    _mm_or_si128 (_mm_cmpeq_epi8 (blk, v3),
+					  _mm_cmpeq_epi8 (blk, v4)));
+	  int mask = _mm_movemask_epi8 (hit);
+	  if (mask != 0)
+	      return pos + vrttxt_first_bit (mask);
+	  pos += 16;
+      }
+#endif
+    while (pos < end)
+      {
+	  if (scan->relevant[(unsigned char) (buf[pos])])
+	      return pos;
+	  pos++;
+      }
+    return end;
+}
+
+static int
+vrttxt_map_file (gaiaTextReaderPtr txt)
+{
+/*
+/ attempting to memory-map the whole input file; the plain
+/ stdio path is silently kept if mapping is unsupported or fails
+*/
+#ifdef VRTTXT_MEMORY_MAP
+    struct stat st;
+    void *addr;
+    if (VRTTXT_MAP_OF (txt) != NULL)
+	return 1;
+    if (fstat (fileno (txt->text_file), &st) != 0)
+	return 0;
+    if (st.st_size <= 0 || (off_t) ((size_t) st.st_size) != st.st_size)
+	return 0;
+    addr =
+	mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE,
+	      fileno (txt->text_file), 0);
+    if (addr == MAP_FAILED)
+	return 0;
+#ifdef POSIX_MADV_SEQUENTIAL
+    posix_madvise (addr, (size_t) st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+    VRTTXT_MAP_OF (txt) = addr;
+    VRTTXT_MAP_SIZE_OF (txt) = (size_t) st.st_size;
+    return 1;
+#else
+    if (txt == NULL)
+	return 0;		/* silencing stupid compiler warnings */
+    return 0;
+#endif
+}
+
+static int
+vrttxt_grow_buffers (gaiaTextReaderPtr txt, int size)
+{
+/* ensuring that both input buffers can store SIZE bytes */
+    int new_sz = txt->current_buf_sz;
+    char *new_line;
+    char *new_field;
+    if (size <= txt->current_buf_sz)
+	return 1;
+    while (new_sz < size)
+      {
+	  /* same allocation strategy as vrttxt_line_push */
+	  if (new_sz < 4196)
+	      new_sz = 4196;
+	  else if (new_sz < 65536)
+	      new_sz = 65536;
+	  else
+	      new_sz += 1024 * 1024;
+      }
+/* nothing is replaced unless both buffers have been allocated */
+    new_line = malloc (new_sz);
+    if (new_line == NULL)
+	return 0;
+    new_field = malloc (new_sz);
+    if (new_field == NULL)
+      {
+	  free (new_line);
+	  return 0;
+      }
+    free (txt->line_buffer);
+    txt->line_buffer = new_line;
+    free (txt->field_buffer);
+    txt->field_buffer = new_field;
+    txt->current_buf_sz = new_sz;
+    return 1;
+}
+
+static void
+vrttxt_strip_line (gaiaTextReaderPtr txt, const char *line, int len)
+{
+/*
+/ copying a Line into the input buffer exactly as vrttxt_line_push
+/ would do, i.e. discarding any unmasked CR
+*/
+    int i;
+    char c;
+    int masked = 0;
+    int token_start = 1;
+    char *out = txt->line_buffer;
+    for (i = 0; i < len; i++)
+      {
+	  c = line[i];
+	  if (c == txt->text_separator)
+	    {
+		if (masked)
+		    masked = 0;
+		else
+		  {
+		      if (token_start)
+			  masked = 1;
+		  }
+		*out++ = c;
+		continue;
+	    }
+	  token_start = 0;
+	  if (c == '\r' && !masked)
+	      continue;
+	  *out++ = c;
+	  if (c == txt->field_separator && !masked)
+	      token_start = 1;
+      }
+    *out = '\0';
+}
+
+static int
+vrttxt_parse_range (gaiaTextReaderPtr txt, const char *buf, size_t end,
+		    struct vrttxt_line *line, size_t start, size_t stop)
+{
+/*
+/ scanning the memory mapped input file: the Line offsets array is
+/ built in a single sweep jumping from one relevant char (separators,
+/ quotes, CR and LF) to the next, and Field values are inspected in place
+/ - START is expected to be the beginning of a Line
+/ - all Lines beginning before STOP are parsed (the last one could
+/   well end after STOP)
+*/
+    size_t pos = start;
+    size_t next;
+    char c;
+    int masked = 0;
+    int token_start = 1;
+    int stripped_cr = 0;
+    struct vrttxt_scanner scan;
+    vrttxt_scanner_init (&scan, txt->text_separator, txt->field_separator,
+			 '\r', '\n');
+    vrttxt_line_init (line, start);
+
+    while (pos < end)
+      {
+	  next = vrttxt_scan (&scan, buf, pos, end);
+	  if (next > pos)
+	      token_start = 0;	/* skipping plain chars */
+	  if (next >= end)
+	      break;
+	  pos = next;
+	  c = buf[pos];
+	  if (c == txt->text_separator)
+	    {
+		if (masked)
+		    masked = 0;
+		else
+		  {
+		      if (token_start)
+			  masked = 1;
+		  }
+		pos++;
+		continue;
+	    }
+	  token_start = 0;
+	  if (c == '\r')
+	    {
+		if (!masked)
+		    stripped_cr = 1;
+		pos++;
+		continue;
+	    }
+	  if (c == '\n')
+	    {
+		if (masked)
+		  {
+		      pos++;
+		      continue;
+		  }
+		vrttxt_add_field (line, pos);
+		vrttxt_line_end (line, pos);
+		if (!vrttxt_grow_buffers (txt, line->len + 2))
+		  {
+		      txt->error = 1;
+		      return 0;
+		  }
+		if (stripped_cr)
+		  {
+		      /* the Line must be copied, discarding CRs */
+		      vrttxt_strip_line (txt, buf + line->offset, line->len);
+		      vrttxt_add_line (txt, line, txt->line_buffer);
+		  }
+		else
+		    vrttxt_add_line (txt, line, buf + line->offset);
+		if (txt->error)
+		    return 0;
+		pos++;
+		if (pos >= stop)
+		    break;
+		vrttxt_line_init (line, pos);
+		token_start = 1;
+		stripped_cr = 0;
+		continue;
+	    }
+	  if (c == txt->field_separator)
+	    {
+		if (!masked)
+		  {
+		      vrttxt_add_field (line, pos);
+		      token_start = 1;
+		  }
+		pos++;
+		continue;
+	    }
+	  pos++;
+      }
+    if (txt->error)
+	return 0;
+    return 1;
+}
+
+#ifdef VRTTXT_PARALLEL_PARSE
+struct vrttxt_chunk
+{
+/* a chunk of the memory mapped file parsed by a single thread */
+    gaiaTextReaderPtr txt;	/* the main TXT-Reader */
+    gaiaTextReaderPtr target;	/* the TXT-Reader receiving the parsed Lines */
+    struct vrttxt_line *line;
+    size_t start;		/* first byte of the chunk */
+    size_t stop;		/* first byte of the next chunk */
+    int final_state[4];		/* end state for each possible initial state */
+    int masked;			/* the actual quoting state at START */
+    int token_start;
+    int ret;
+    int running;		/* TRUE if a thread has been started */
+    pthread_t thread;
+};
+
+static int
+vrttxt_parse_threads (size_t size)
+{
+/* how many threads should share the initial parsing */
+    int automatic = 1;
+    int threads;
+    if (size >= VRTTXT_PARALLEL_MIN_SIZE)
+      {
+	  automatic = splite_cpu_cores ();
+	  if (size / automatic < VRTTXT_PARALLEL_MIN_CHUNK)
+	      automatic = (int) (size / VRTTXT_PARALLEL_MIN_CHUNK);
+      }
+    threads =
+	splite_env_threads ("SPATIALITE_TXT_THREADS", automatic,
+			    VRTTXT_PARALLEL_MAX_THREADS);
+    if ((off_t) threads > size)
+	threads = (int) size;
+    if (threads < 1)
+	threads = 1;
+    return threads;
+}
+
+static void
+vrttxt_next_state (gaiaTextReaderPtr txt, char c, int *masked,
+		   int *token_start)
+{
+/* updating the quoting state after a relevant char */
+    if (c == txt->text_separator)
+      {
+	  if (*masked)
+	      *masked = 0;
+	  else
+	    {
+		if (*token_start)
+		    *masked = 1;
+	    }
+	  return;
+      }
+    *token_start = 0;
+    if ((c == '\n' || c == txt->field_separator) && !(*masked))
+	*token_start = 1;
+}
+
+static void *
+vrttxt_chunk_states (void *arg)
+{
+/*
+/ phase 1: the quoting state at the start of a chunk is unknown, so
+/ the chunk is simulated at once for all four possible initial states
+/ (masked, token_start); composing these transitions will then give
+/ the actual state at the start of each chunk
+*/
+    struct vrttxt_chunk *chunk = (struct vrttxt_chunk *) arg;
+    gaiaTextReaderPtr txt = chunk->txt;
+    const char *buf = VRTTXT_MAP_OF (txt);
+    struct vrttxt_scanner scan;
+    int masked[4] = { 0, 0, 1, 1 };
+    int token_start[4] = { 0, 1, 0, 1 };
+    size_t pos = chunk->start;
+    size_t next;
+    int s;
+    vrttxt_scanner_init (&scan, txt->text_separator, txt->field_separator,
+			 '\r', '\n');
+    while (pos < chunk->stop)
+      {
+	  next = vrttxt_scan (&scan, buf, pos, chunk->stop);
+	  if (next > pos)
+	    {
+		/* skipping plain chars */
+		for (s = 0; s < 4; s++)
+		    token_start[s] = 0;
+	    }
+	  if (next >= chunk->stop)
+	      break;
+	  for (s = 0; s < 4; s++)
+	      vrttxt_next_state (txt, buf[next], masked + s, token_start + s);
+	  pos = next + 1;
+      }
+    for (s = 0; s < 4; s++)
+	chunk->final_state[s] = (masked[s] * 2) + token_start[s];
+    return NULL;
+}
+
+static void *
+vrttxt_chunk_parse (void *arg)
+{
+/*
+/ phase 2: parsing all Lines beginning within a chunk; the tail of
+/ a Line begun within the previous chunk is simply skipped
+*/
+    struct vrttxt_chunk *chunk = (struct vrttxt_chunk *) arg;
+    gaiaTextReaderPtr txt = chunk->txt;
+    const char *buf = VRTTXT_MAP_OF (txt);
+    size_t end = VRTTXT_MAP_SIZE_OF (txt);
+    struct vrttxt_scanner scan;
+    size_t pos = chunk->start;
+    int masked = chunk->masked;
+    int token_start = chunk->token_start;
+    size_t next;
+    chunk->ret = 1;
+    if (pos > 0 && !(buf[pos - 1] == '\n' && !masked))
+      {
+	  /* searching the first unmasked LF */
+	  vrttxt_scanner_init (&scan, txt->text_separator,
+			       txt->field_separator, '\r', '\n');
+	  while (1)
+	    {
+		next = vrttxt_scan (&scan, buf, pos, chunk->stop);
+		if (next > pos)
+		    token_start = 0;	/* skipping plain chars */
+		pos = next;
+		if (pos >= chunk->stop)
+		    return NULL;	/* no Line begins within this chunk */
+		if (buf[pos] == '\n' && !masked)
+		    break;
+		vrttxt_next_state (txt, buf[pos], &masked, &token_start);
+		pos++;
+	    }
+	  pos++;
+      }
+    if (pos >= chunk->stop)
+	return NULL;
+    chunk->ret =
+	vrttxt_parse_range (chunk->target, buf, end, chunk->line, pos,
+			    chunk->stop);
+    return NULL;
+}
+
+static gaiaTextReaderPtr
+vrttxt_shadow_alloc (gaiaTextReaderPtr txt)
+{
+/* allocating a private TXT-Reader receiving the Lines of a chunk */
+    int col;
+    gaiaTextReaderPtr shadow = malloc (sizeof (struct vrttxt_handle));
+    if (shadow == NULL)
+	return NULL;
+    shadow->text_file = NULL;
+    shadow->toUtf8 = NULL;
+    shadow->field_separator = txt->field_separator;
+    shadow->text_separator = txt->text_separator;
+    shadow->decimal_separator = txt->decimal_separator;
+    shadow->first_line_titles = 0;
+    shadow->error = 0;
+    shadow->first = NULL;
+    shadow->last = NULL;
+    shadow->rows = NULL;
+    shadow->num_rows = 0;
+    shadow->line_no = 0;
+    shadow->max_fields = 0;
+    shadow->current_buf_sz = 1024;
+    shadow->line_buffer = malloc (1024);
+    shadow->field_buffer = malloc (1024);
+    VRTTXT_MAP_OF (shadow) = NULL;
+    VRTTXT_MAP_SIZE_OF (shadow) = 0;
+    for (col = 0; col < VRTTXT_FIELDS_MAX; col++)
+      {
+	  shadow->columns[col].name = NULL;
+	  shadow->columns[col].type = VRTTXT_NULL;
+      }
+    if (shadow->line_buffer == NULL || shadow->field_buffer == NULL)
+	shadow->error = 1;
+    return shadow;
+}
+
+static void
+vrttxt_shadow_free (gaiaTextReaderPtr shadow)
+{
+/* destroying a private TXT-Reader */
+    struct vrttxt_row_block *blk;
+    struct vrttxt_row_block *blkN;
+    blk = shadow->first;
+    while (blk)
+      {
+	  blkN = blk->next;
+	  vrttxt_block_destroy (blk);
+	  blk = blkN;
+      }
+    if (shadow->line_buffer)
+	free (shadow->line_buffer);
+    if (shadow->field_buffer)
+	free (shadow->field_buffer);
+    free (shadow);
+}
+
+static int
+vrttxt_type_rank (int type)
+{
+/* ranking Column types: a Column never moves to a lower rank */
+    switch (type)
+      {
+      case VRTTXT_INTEGER:
+	  return 1;
+      case VRTTXT_DOUBLE:
+	  return 2;
+      case VRTTXT_TEXT:
+	  return 3;
+      };
+    return 0;
+}
+
+static void
+vrttxt_shadow_merge (gaiaTextReaderPtr txt, gaiaTextReaderPtr shadow)
+{
+/* appending the Lines parsed by a private TXT-Reader */
+    struct vrttxt_row_block *blk;
+    int i;
+    int col;
+    if (shadow->error)
+	txt->error = 1;
+    if (!vrttxt_grow_buffers (txt, shadow->current_buf_sz))
+	txt->error = 1;
+    blk = shadow->first;
+    while (blk)
+      {
+	  /* Line Numbers are relative to the chunk */
+	  for (i = 0; i < blk->num_rows; i++)
+	      blk->rows[i].line_no += txt->line_no;
+	  blk->min_line_no += txt->line_no;
+	  blk->max_line_no += txt->line_no;
+	  blk = blk->next;
+      }
+    if (shadow->first != NULL)
+      {
+	  if (txt->first == NULL)
+	      txt->first = shadow->first;
+	  if (txt->last != NULL)
+	      txt->last->next = shadow->first;
+	  txt->last = shadow->last;
+	  shadow->first = NULL;
+	  shadow->last = NULL;
+      }
+    txt->line_no += shadow->line_no;
+    if (shadow->max_fields > txt->max_fields)
+	txt->max_fields = shadow->max_fields;
+    for (col = 0; col < shadow->max_fields; col++)
+      {
+	  if (vrttxt_type_rank (shadow->columns[col].type) >
+	      vrttxt_type_rank (txt->columns[col].type))
+	      txt->columns[col].type = shadow->columns[col].type;
+      }
+}
+
+static int
+vrttxt_parse_parallel (gaiaTextReaderPtr txt, struct vrttxt_line *line,
+		       int threads)
+{
+/*
+/ parsing the memory mapped input file by chunks, each one assigned
+/ to its own thread; the first chunk is directly parsed by the calling
+/ thread into the main TXT-Reader, all other chunks into private ones
+/ that are finally merged in their natural order
+*/
+    struct vrttxt_chunk *chunks;
+    size_t size = VRTTXT_MAP_SIZE_OF (txt);
+    int i;
+    int state;
+    int ok = 1;
+    chunks = malloc (sizeof (struct vrttxt_chunk) * threads);
+    if (chunks == NULL)
+	return -1;
+    for (i = 0; i < threads; i++)
+      {
+	  struct vrttxt_chunk *chunk = chunks + i;
+	  chunk->txt = txt;
+	  chunk->start = (size / threads) * i;
+	  chunk->stop = (i == threads - 1) ? size : (size / threads) * (i + 1);
+	  chunk->masked = 0;
+	  chunk->token_start = 1;
+	  chunk->ret = 0;
+	  chunk->running = 0;
+	  chunk->target = NULL;
+	  chunk->line = NULL;
+	  if (i == 0)
+	    {
+		chunk->target = txt;
+		chunk->line = line;
+		continue;
+	    }
+	  chunk->target = vrttxt_shadow_alloc (txt);
+	  chunk->line = malloc (sizeof (struct vrttxt_line));
+	  if (chunk->target == NULL || chunk->line == NULL)
+	      ok = 0;
+      }
+    if (!ok)
+	goto stop;
+
+/* phase 1: the quoting state at the end of each chunk */
+    for (i = 1; i < threads - 1; i++)
+      {
+	  chunks[i].running =
+	      (pthread_create
+	       (&(chunks[i].thread), NULL, vrttxt_chunk_states,
+		chunks + i) == 0);
+	  if (!(chunks[i].running))
+	      vrttxt_chunk_states (chunks + i);
+      }
+    vrttxt_chunk_states (chunks);
+    for (i = 1; i < threads - 1; i++)
+      {
+	  if (chunks[i].running)
+	      pthread_join (chunks[i].thread, NULL);
+      }
+    state = 1;			/* not masked, token start */
+    for (i = 1; i < threads; i++)
+      {
+	  state = chunks[i - 1].final_state[state];
+	  chunks[i].masked = state / 2;
+	  chunks[i].token_start = state % 2;
+      }
+
+/* phase 2: parsing the Lines of each chunk */
+    for (i = 1; i < threads; i++)
+      {
+	  chunks[i].running =
+	      (pthread_create
+	       (&(chunks[i].thread), NULL, vrttxt_chunk_parse, chunks + i) == 0);
+	  if (!(chunks[i].running))
+	      vrttxt_chunk_parse (chunks + i);
+      }
+    vrttxt_chunk_parse (chunks);
+    for (i = 1; i < threads; i++)
+      {
+	  if (chunks[i].running)
+	      pthread_join (chunks[i].thread, NULL);
+      }
+    for (i = 0; i < threads; i++)
+      {
+	  if (!(chunks[i].ret))
+	      txt->error = 1;
+	  if (i > 0)
+	      vrttxt_shadow_merge (txt, chunks[i].target);
+      }
+
+  stop:
+    for (i = 1; i < threads; i++)
+      {
+	  if (chunks[i].target != NULL)
+	      vrttxt_shadow_free (chunks[i].target);
+	  if (chunks[i].line != NULL)
+	      free (chunks[i].line);
+      }
+    free (chunks);
+    if (!ok)
+	return -1;
+    if (txt->error)
+	return 0;
+    return 1;
+}
+#endif
+
+static int
+vrttxt_parse_mapped (gaiaTextReaderPtr txt, struct vrttxt_line *line)
+{
+/* parsing the memory mapped input file */
+#ifdef VRTTXT_PARALLEL_PARSE
+    int ret;
+    int threads = vrttxt_parse_threads (VRTTXT_MAP_SIZE_OF (txt));
+    if (threads > 1)
+      {
+	  ret = vrttxt_parse_parallel (txt, line, threads);
+	  if (ret >= 0)
+	      return ret;
+	  /* insufficient memory: falling back to serial parsing */
+      }
+#endif
+    return vrttxt_parse_range (txt, VRTTXT_MAP_OF (txt),
+			       VRTTXT_MAP_SIZE_OF (txt), line, 0,
+			       VRTTXT_MAP_SIZE_OF (txt));
+}
+
+static int
+vrttxt_parse_file (gaiaTextReaderPtr txt, struct vrttxt_line *line)
+{
+/* reading the input file until EOF - plain stdio */
     int c;
     int masked = 0;
     int token_start = 1;
     int row_offset = 0;
     off_t offset = 0;
-    struct vrttxt_line line;
-    vrttxt_line_init (&line, 0);
+    vrttxt_line_init (line, 0);
     txt->current_buf_off = 0;
 
     while ((c = getc (txt->text_file)) != EOF)
@@ -1570,12 +2553,12 @@ gaiaTextReaderParse (gaiaTextReaderPtr txt)
 		      offset++;
 		      continue;
 		  }
-		vrttxt_add_field (&line, offset);
-		vrttxt_line_end (&line, offset);
-		vrttxt_add_line (txt, &line);
+		vrttxt_add_field (line, offset);
+		vrttxt_line_end (line, offset);
+		vrttxt_add_line (txt, line, txt->line_buffer);
 		if (txt->error)
 		    return 0;
-		vrttxt_line_init (&line, offset + 1);
+		vrttxt_line_init (line, offset + 1);
 		txt->current_buf_off = 0;
 		token_start = 1;
 		row_offset = 0;
@@ -1597,7 +2580,7 @@ gaiaTextReaderParse (gaiaTextReaderPtr txt)
 		if (txt->error)
 		    return 0;
 		row_offset++;
-		vrttxt_add_field (&line, offset);
+		vrttxt_add_field (line, offset);
 		token_start = 1;
 		offset++;
 		continue;
@@ -1610,6 +2593,32 @@ gaiaTextReaderParse (gaiaTextReaderPtr txt)
       }
     if (txt->error)
 	return 0;
+    return 1;
+}
+
+GAIAGEO_DECLARE int
+gaiaTextReaderParse (gaiaTextReaderPtr txt)
+{
+/* 
+/ preliminary parsing
+/ - reading the input file until EOF
+/ - then feeding the Row offsets structs
+/   to be used for any subsequent access
+*/
+    char name[64];
+    int ind;
+    int i2;
+    int ret;
+    struct vrttxt_line line;
+
+    if (vrttxt_map_file (txt))
+	ret = vrttxt_parse_mapped (txt, &line);
+    else
+	ret = vrttxt_parse_file (txt, &line);
+    if (!ret)
+	return 0;
+    if (txt->error)
+	return 0;
     if (txt->first_line_titles)
       {
 	  /* checking for duplicate column names */
@@ -1656,27 +2665,56 @@ gaiaTextReaderGetRow (gaiaTextReaderPtr txt, int line_no)
 {
 /* reading a Line (identified by relative number */
     int i;
+    size_t next;
     char c;
     int masked = 0;
     int token_start = 1;
     int fld = 0;
     int offset = 0;
     struct vrttxt_row *p_row;
+    struct vrttxt_scanner scan;
     txt->current_line_ready = 0;
     txt->max_current_field = 0;
     if (line_no < 0 || line_no >= txt->num_rows || txt->rows == NULL)
 	return 0;
     p_row = *(txt->rows + line_no);
-    if (fseek (txt->text_file, p_row->offset, SEEK_SET) != 0)
-	return 0;
-    if (fread (txt->line_buffer, 1, p_row->len, txt->text_file) !=
-	(unsigned int) (p_row->len))
-	return 0;
+    if (VRTTXT_MAP_OF (txt) != NULL)
+      {
+	  /* copying the Line from the memory mapped file */
+	  if (p_row->offset < 0
+	      || (size_t) (p_row->offset) + p_row->len >
+	      VRTTXT_MAP_SIZE_OF (txt))
+	      return 0;
+	  memcpy (txt->line_buffer, VRTTXT_MAP_OF (txt) + p_row->offset,
+		  p_row->len);
+      }
+    else
+      {
+	  if (fseek (txt->text_file, p_row->offset, SEEK_SET) != 0)
+	      return 0;
+	  if (fread (txt->line_buffer, 1, p_row->len, txt->text_file) !=
+	      (unsigned int) (p_row->len))
+	      return 0;
+      }
+    vrttxt_scanner_init (&scan, txt->text_separator, txt->field_separator,
+			 txt->field_separator, txt->field_separator);
     txt->field_offsets[0] = 0;
-    for (i = 0; i < p_row->len; i++)
+    i = 0;
+    while (i < p_row->len)
       {
 	  /* parsing Fields */
+	  next = vrttxt_scan (&scan, txt->line_buffer, i, p_row->len);
+	  if (next > (size_t) i)
+	    {
+		/* skipping plain chars */
+		token_start = 0;
+		offset += next - i;
+		i = next;
+		if (i >= p_row->len)
+		    break;
+	    }
 	  c = *(txt->line_buffer + i);
+	  i++;
 	  if (c == txt->text_separator)
 	    {
 		if (masked)
@@ -76,6 +76,7 @@ Regione Toscana - Settore Sistema Informativo Territoriale ed Ambientale
 #ifdef ENABLE_LIBXML2		/* LIBXML2 enabled: supporting XML documents */
 
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 #include <libxml/nanohttp.h>
 
 #define MAX_GTYPES	28
@@ -88,6 +89,12 @@ Regione Toscana - Settore Sistema Informativo Territoriale ed Ambientale
 #define strcasecmp	_stricmp
 #endif /* not WIN32 */
 
+#if !defined(_WIN32) && defined(LIBXML_HTTP_ENABLED)
+/* further WFS pages are fetched in background while loading the current one */
+#define WFS_PREFETCH
+#include <pthread.h>
+#endif
+
 struct wfs_srid_def
 {
 /* a WFS supported SRID */
@@ -157,7 +164,9 @@ struct wfs_layer_schema
     int dims;
     int is_nullable;
     struct wfs_geom_type *types;
-    char *geometry_value;
+    int has_geometry;
+    gaiaGeomCollPtr geometry;
+    void *gml_nodes;
     sqlite3_stmt *stmt;
     sqlite3 *sqlite;
 };
@@ -175,7 +184,8 @@ struct wfs_feature
 /* a WFS feature */
     struct wfs_attribute *first;
     struct wfs_attribute *last;
-    char *geometry_value;
+    unsigned char *geometry_blob;
+    int geometry_size;
 };
 
 static struct wfs_column_def *
@@ -279,8 +289,11 @@ alloc_wfs_layer_schema (const char *layer_name, int swap_axes)
     ptr->types[26].count = 0;
     ptr->types[27].type = GAIA_GEOMETRYCOLLECTIONZM;
     ptr->types[27].count = 0;
-    ptr->geometry_value = NULL;
+    ptr->has_geometry = 0;
+    ptr->geometry = NULL;
+    ptr->gml_nodes = gaiaGmlNodesCreate ();
     ptr->stmt = NULL;
+    ptr->sqlite = NULL;
     return ptr;
 }
 
@@ -305,8 +318,10 @@ free_wfs_layer_schema (struct wfs_layer_schema *ptr)
 	free (ptr->geometry_name);
     if (ptr->types != NULL)
 	free (ptr->types);
-    if (ptr->geometry_value != NULL)
-	free (ptr->geometry_value);
+    if (ptr->geometry != NULL)
+	gaiaFreeGeomColl (ptr->geometry);
+    if (ptr->gml_nodes != NULL)
+	gaiaGmlNodesDestroy (ptr->gml_nodes);
     if (ptr->stmt != NULL)
 	sqlite3_finalize (ptr->stmt);
     free (ptr);
@@ -325,10 +340,11 @@ reset_wfs_values (struct wfs_layer_schema *ptr)
 	  col->pValue = NULL;
 	  col = col->next;
       }
-    if (ptr->geometry_value != NULL)
+    ptr->has_geometry = 0;
+    if (ptr->geometry != NULL)
       {
-	  free (ptr->geometry_value);
-	  ptr->geometry_value = NULL;
+	  gaiaFreeGeomColl (ptr->geometry);
+	  ptr->geometry = NULL;
       }
 }
 
@@ -347,7 +363,7 @@ count_wfs_values (struct wfs_layer_schema *ptr)
 	      count++;
 	  col = col->next;
       }
-    if (ptr->geometry_value != NULL)
+    if (ptr->has_geometry)
 	count++;
     return count;
 }
@@ -542,7 +558,8 @@ create_feature (struct wfs_layer_schema *schema)
     struct wfs_feature *feature = malloc (sizeof (struct wfs_feature));
     feature->first = NULL;
     feature->last = NULL;
-    feature->geometry_value = NULL;
+    feature->geometry_blob = NULL;
+    feature->geometry_size = 0;
     col = schema->first;
     while (col != NULL)
       {
@@ -572,9 +589,10 @@ reset_feature (struct wfs_feature *feature)
 	  attr->value = NULL;
 	  attr = attr->next;
       }
-    if (feature->geometry_value != NULL)
-	free (feature->geometry_value);
-    feature->geometry_value = NULL;
+    if (feature->geometry_blob != NULL)
+	free (feature->geometry_blob);
+    feature->geometry_blob = NULL;
+    feature->geometry_size = 0;
 }
 
 static void
@@ -620,11 +638,13 @@ compare_features (struct wfs_feature *f1, struct wfs_feature *f2)
 	  /* surely different - mismatching attributes count */
 	  return 0;
       }
-    if (f1->geometry_value == NULL && f2->geometry_value == NULL)
+    if (f1->geometry_blob == NULL && f2->geometry_blob == NULL)
 	;
-    else if (f1->geometry_value != NULL && f2->geometry_value != NULL)
+    else if (f1->geometry_blob != NULL && f2->geometry_blob != NULL)
       {
-	  if (strcmp (f1->geometry_value, f2->geometry_value) != 0)
+	  if (f1->geometry_size != f2->geometry_size
+	      || memcmp (f1->geometry_blob, f2->geometry_blob,
+			 f1->geometry_size) != 0)
 	    {
 		/* surely different - mismatching geometry values */
 		return 0;
@@ -798,6 +818,22 @@ wfsParsingError (void *ctx, const char *msg, ...)
     va_end (args);
 }
 
+static void
+wfsReaderError (void *arg, const char *msg, xmlParserSeverities severity,
+		xmlTextReaderLocatorPtr locator)
+{
+/* appending to the current Parsing Error buffer [streaming parser] */
+    gaiaOutBufferPtr buf = arg;
+    char *out;
+    if (severity == XML_PARSER_SEVERITY_VALIDITY_WARNING
+	|| severity == XML_PARSER_SEVERITY_WARNING)
+	return;
+    out = sqlite3_mprintf ("line %d: %s",
+			   xmlTextReaderLocatorLineNumber (locator), msg);
+    gaiaAppendToOutBuffer (buf, out);
+    sqlite3_free (out);
+}
+
 static int
 find_describe_uri (xmlNodePtr node, char **describe_uri)
 {
@@ -849,13 +885,12 @@ find_describe_uri (xmlNodePtr node, char **describe_uri)
 }
 
 static int
-get_DescribeFeatureType_uri (xmlDocPtr xml_doc, char **describe_uri)
+get_DescribeFeatureType_uri (xmlNodePtr root, char **describe_uri)
 {
 /*
 / attempting to retrieve the URI identifying the DescribeFeatureType service
 */
     const char *name;
-    xmlNodePtr root = xmlDocGetRootElement (xml_doc);
     struct _xmlAttr *attr;
     if (root == NULL)
 	return 0;
@@ -1207,88 +1242,33 @@ load_wfs_schema (const char *path_or_url, const char *layer_name, int swap_axes,
     return schema;
 }
 
-static void
-gml_out (gaiaOutBufferPtr buf, const xmlChar * str)
-{
-/* clean GML output */
-    const xmlChar *p = str;
-    while (*p != '\0')
-      {
-	  if (*p == '>')
-	      gaiaAppendToOutBuffer (buf, "&gt;");
-	  else if (*p == '<')
-	      gaiaAppendToOutBuffer (buf, "&lt;");
-	  else if (*p == '&')
-	      gaiaAppendToOutBuffer (buf, "&amp;");
-	  else if (*p == '"')
-	      gaiaAppendToOutBuffer (buf, "&quot;");
-	  else if (*p == '\'')
-	      gaiaAppendToOutBuffer (buf, "&apos;");
-	  else
-	    {
-		char xx[2];
-		xx[0] = *p;
-		xx[1] = '\0';
-		gaiaAppendToOutBuffer (buf, xx);
-	    }
-	  p++;
-      }
+static const char *
+get_xml_ns_prefix (xmlNs * ns)
+{
+/* returning the namespace prefix (if any) */
+    if (ns == NULL)
+	return NULL;
+    return (const char *) (ns->prefix);
 }
 
-static void
-reassemble_gml (xmlNodePtr node, gaiaOutBufferPtr buf)
+static int
+feed_gml_nodes (xmlNodePtr node, void *gml_nodes)
 {
-/* recursively printing the XML-DOM nodes */
+/*
+/ recursively feeding the XML-DOM nodes into the GML builder
+/ [no need to reassemble and then to parse again any GML text]
+*/
     struct _xmlAttr *attr;
     xmlNodePtr child;
-    xmlNs *ns;
-    const xmlChar *namespace;
     int has_children;
     int has_text;
+    int count = 0;
 
     while (node)
       {
 	  if (node->type == XML_ELEMENT_NODE)
 	    {
-		gaiaAppendToOutBuffer (buf, "<");
-		ns = node->ns;
-		namespace = NULL;
-		if (ns != NULL)
-		    namespace = ns->prefix;
-		if (namespace)
-		  {
-		      gml_out (buf, namespace);
-		      gaiaAppendToOutBuffer (buf, ":");
-		  }
-		gml_out (buf, node->name);
-		attr = node->properties;
-		while (attr != NULL)
-		  {
-		      /* attributes */
-		      if (attr->type == XML_ATTRIBUTE_NODE)
-			{
-			    xmlNodePtr text = attr->children;
-			    gaiaAppendToOutBuffer (buf, " ");
-			    ns = attr->ns;
-			    namespace = NULL;
-			    if (ns != NULL)
-				namespace = ns->prefix;
-			    if (namespace)
-			      {
-				  gml_out (buf, namespace);
-				  gaiaAppendToOutBuffer (buf, ":");
-			      }
-			    gml_out (buf, attr->name);
-			    gaiaAppendToOutBuffer (buf, "=\"");
-			    if (text != NULL)
-			      {
-				  if (text->type == XML_TEXT_NODE)
-				      gml_out (buf, text->content);
-			      }
-			    gaiaAppendToOutBuffer (buf, "\"");
-			}
-		      attr = attr->next;
-		  }
+		count++;
 		has_children = 0;
 		has_text = 0;
 		child = node->children;
@@ -1302,70 +1282,70 @@ reassemble_gml (xmlNodePtr node, gaiaOutBufferPtr buf)
 		  }
 		if (has_children)
 		    has_text = 0;
+		if (has_text && node->children->type != XML_TEXT_NODE)
+		  {
+		      /* unsupported mixed content */
+		      gaiaGmlNodesSetError (gml_nodes);
+		      return count;
+		  }
 
-		if (!has_text && !has_children)
-		    gaiaAppendToOutBuffer (buf, " />");
-
-		if (has_text)
+		gaiaGmlNodesOpenTag (gml_nodes, get_xml_ns_prefix (node->ns),
+				     (const char *) (node->name), !has_text
+				     && !has_children);
+		attr = node->properties;
+		while (attr != NULL)
 		  {
-		      child = node->children;
-		      if (child->type == XML_TEXT_NODE)
+		      /* attributes */
+		      if (attr->type == XML_ATTRIBUTE_NODE)
 			{
-			    /* text node */
-			    gaiaAppendToOutBuffer (buf, ">");
-			    gml_out (buf, child->content);
-			    gaiaAppendToOutBuffer (buf, "</");
-			    ns = node->ns;
-			    namespace = NULL;
-			    if (ns != NULL)
-				namespace = ns->prefix;
-			    if (namespace)
+			    const char *value = "";
+			    xmlNodePtr text = attr->children;
+			    if (text != NULL)
 			      {
-				  gml_out (buf, namespace);
-				  gaiaAppendToOutBuffer (buf, ":");
+				  if (text->type == XML_TEXT_NODE)
+				      value = (const char *) (text->content);
 			      }
-			    gml_out (buf, node->name);
-			    gaiaAppendToOutBuffer (buf, ">");
+			    gaiaGmlNodesAttribute (gml_nodes,
+						   get_xml_ns_prefix (attr->ns),
+						   (const char *) (attr->name),
+						   value);
 			}
+		      attr = attr->next;
 		  }
+		if (has_text)
+		    gaiaGmlNodesCoordinates (gml_nodes,
+					     (const char *) (node->children->
+							     content));
 		if (has_children)
-		  {
-		      /* recursively expanding all children */
-		      gaiaAppendToOutBuffer (buf, ">");
-		      reassemble_gml (node->children, buf);
-		      gaiaAppendToOutBuffer (buf, "</");
-		      ns = node->ns;
-		      namespace = NULL;
-		      if (ns != NULL)
-			  namespace = ns->prefix;
-		      if (namespace)
-			{
-			    gml_out (buf, namespace);
-			    gaiaAppendToOutBuffer (buf, ":");
-			}
-		      gml_out (buf, node->name);
-		      gaiaAppendToOutBuffer (buf, ">");
-		  }
+		    feed_gml_nodes (node->children, gml_nodes);
+		if (has_text || has_children)
+		    gaiaGmlNodesCloseTag (gml_nodes,
+					  get_xml_ns_prefix (node->ns),
+					  (const char *) (node->name));
 	    }
 	  node = node->next;
       }
+    return count;
 }
 
 static void
 set_feature_geom (xmlNodePtr node, struct wfs_layer_schema *schema)
 {
 /* saving the feature's geometry value */
-    gaiaOutBuffer gml;
-    gaiaOutBufferInitialize (&gml);
+    if (schema->geometry != NULL)
+	gaiaFreeGeomColl (schema->geometry);
+    schema->geometry = NULL;
 
-    /* reassembling the GML expression */
-    reassemble_gml (node, &gml);
-    if (gml.Buffer != NULL)
+    /* directly building the Geometry from the XML-DOM nodes */
+    gaiaGmlNodesReset (schema->gml_nodes);
+    schema->has_geometry = 0;
+    if (feed_gml_nodes (node, schema->gml_nodes) > 0)
       {
-	  if (schema->geometry_value != NULL)
-	      free (schema->geometry_value);
-	  schema->geometry_value = gml.Buffer;
+	  schema->has_geometry = 1;
+	  schema->geometry =
+	      gaiaGmlNodesBuild (NULL, schema->gml_nodes, schema->sqlite);
       }
+    gaiaGmlNodesReset (schema->gml_nodes);
 }
 
 static void
@@ -1383,7 +1363,8 @@ check_feature_value (xmlNodePtr node, struct wfs_layer_schema *schema)
 {
 /* attempting to extract an attribute value */
     struct wfs_column_def *col;
-    if (strcmp ((const char *) (node->name), schema->geometry_name) == 0)
+    if (schema->geometry_name != NULL
+	&& strcmp ((const char *) (node->name), schema->geometry_name) == 0)
       {
 	  set_feature_geom (node->children, schema);
 	  return;
@@ -1726,12 +1707,10 @@ do_insert (struct wfs_layer_schema *schema, char **err_msg)
     if (schema->geometry_name != NULL)
       {
 	  /* we have a Geometry column */
-	  if (schema->geometry_value != NULL)
+	  if (schema->has_geometry)
 	    {
 		/* preparing the Geometry value */
-		gaiaGeomCollPtr geom =
-		    gaiaParseGml ((unsigned char *) (schema->geometry_value),
-				  schema->sqlite);
+		gaiaGeomCollPtr geom = schema->geometry;
 		if (geom == NULL)
 		    sqlite3_bind_null (stmt, ind);
 		else
@@ -1763,6 +1742,7 @@ do_insert (struct wfs_layer_schema *schema, char **err_msg)
 		      gaiaToSpatiaLiteBlobWkb (geom, &blob, &blob_size);
 		      sqlite3_bind_blob (stmt, ind, blob, blob_size, free);
 		      gaiaFreeGeomColl (geom);
+		      schema->geometry = NULL;
 		      update_geom_stats (schema, type);
 		  }
 	    }
@@ -1838,55 +1818,14 @@ do_save_feature (struct wfs_layer_schema *schema, struct wfs_feature *feature)
     if (schema->geometry_name != NULL)
       {
 	  /* we have a Geometry column */
-	  if (schema->geometry_value != NULL)
-	    {
-		int len = strlen (schema->geometry_value);
-		feature->geometry_value = malloc (len + 1);
-		strcpy (feature->geometry_value, schema->geometry_value);
-	    }
+	  if (schema->geometry != NULL)
+	      gaiaToSpatiaLiteBlobWkb (schema->geometry,
+				       &(feature->geometry_blob),
+				       &(feature->geometry_size));
       }
     return 1;
 }
 
-static void
-parse_wfs_features (xmlNodePtr node, struct wfs_layer_schema *schema, int *rows,
-		    char **err_msg)
-{
-/* recursively parsing the GML payload */
-    xmlNodePtr cur_node = NULL;
-
-    for (cur_node = node; cur_node; cur_node = cur_node->next)
-      {
-	  if (cur_node->type == XML_ELEMENT_NODE)
-	    {
-		char *entity_name;
-		if (cur_node->ns != NULL)
-		    entity_name =
-			sqlite3_mprintf ("%s:%s", cur_node->ns->prefix,
-					 cur_node->name);
-		else
-		    entity_name = sqlite3_mprintf ("%s", cur_node->name);
-		if (strcmp (schema->layer_name, entity_name) == 0
-		    || strcmp (schema->layer_name,
-			       (const char *) (cur_node->name)) == 0)
-		  {
-		      if (parse_wfs_single_feature (cur_node->children, schema))
-			{
-			    if (schema->error == 0)
-			      {
-				  if (do_insert (schema, err_msg))
-				      *rows += 1;
-			      }
-			}
-		  }
-		else
-		    parse_wfs_features (cur_node->children, schema, rows,
-					err_msg);
-		sqlite3_free (entity_name);
-	    }
-      }
-}
-
 static void
 parse_wfs_last_feature (xmlNodePtr node, struct wfs_layer_schema *schema,
 			struct wfs_feature *feature, int *rows)
@@ -1920,7 +1859,8 @@ sniff_feature_value (xmlNodePtr node, struct wfs_layer_schema *schema,
 {
 /* sniffing attribute values */
     struct wfs_column_def *col;
-    if (strcmp ((const char *) (node->name), schema->geometry_name) == 0)
+    if (schema->geometry_name != NULL
+	&& strcmp ((const char *) (node->name), schema->geometry_name) == 0)
       {
 	  *geom = node->children;
 	  return 1;
@@ -2030,29 +1970,6 @@ sniff_wfs_single_feature (xmlNodePtr node, struct wfs_layer_schema *schema)
     return 0;
 }
 
-static void
-sniff_geometries (xmlNodePtr node, struct wfs_layer_schema *schema,
-		  int *sniffed)
-{
-/* recursively parsing the GML payload so to sniff the first geometry */
-    xmlNodePtr cur_node = NULL;
-    for (cur_node = node; cur_node; cur_node = cur_node->next)
-      {
-	  if (cur_node->type == XML_ELEMENT_NODE)
-	    {
-		if (*sniffed)
-		    return;
-		if (sniff_wfs_single_feature (cur_node, schema))
-		  {
-		      *sniffed = 1;
-		      return;
-		  }
-		else
-		    sniff_geometries (cur_node->children, schema, sniffed);
-	    }
-      }
-}
-
 static int
 check_pk_name (struct wfs_layer_schema *schema, const char *pk_column_name,
 	       char *auto_pk_name)
@@ -2373,8 +2290,15 @@ prepare_sql (sqlite3 * sqlite, struct wfs_layer_schema *schema,
       }
     schema->stmt = stmt;
     schema->sqlite = sqlite;
+    return 1;
+}
 
+static int
+do_begin (sqlite3 * sqlite, struct wfs_layer_schema *schema, char **err_msg)
+{
 /* starting an SQL Transaction */
+    int len;
+    char *errMsg = NULL;
     if (sqlite3_exec (sqlite, "BEGIN", NULL, NULL, &errMsg) != SQLITE_OK)
       {
 	  spatialite_e ("loadwfs: BEGIN error:\"%s\"\n", errMsg);
@@ -2388,9 +2312,8 @@ prepare_sql (sqlite3 * sqlite, struct wfs_layer_schema *schema,
 	  *err_msg = malloc (len + 1);
 	  strcpy (*err_msg, errMsg);
 	  sqlite3_free (errMsg);
+	  return 0;
       }
-    if (schema->error)
-	return 0;
     return 1;
 }
 
@@ -2457,7 +2380,8 @@ load_from_wfs (sqlite3 * sqlite, const char *path_or_url,
 }
 
 static int
-test_wfs_paging (const char *path_or_url, int page_size, xmlNodePtr node,
+test_wfs_paging (const char *path_or_url, int page_size, int page_rows,
+		 struct wfs_feature *feature_1,
 		 struct wfs_layer_schema *schema, int *shift_index)
 {
 /* testing if the server does actually supports STARTINDEX */
@@ -2465,16 +2389,14 @@ test_wfs_paging (const char *path_or_url, int page_size, xmlNodePtr node,
     xmlNodePtr root;
     char *page_url;
     int nRows = 0;
-    struct wfs_feature *feature_1 = create_feature (schema);
-    struct wfs_feature *feature_2 = create_feature (schema);
+    struct wfs_feature *feature_2;
     *shift_index = 0;
-    parse_wfs_last_feature (node, schema, feature_1, &nRows);
-    if (nRows < page_size)
+    if (page_rows < page_size)
       {
 	  /* a single page is required: this means no-paging at all */
-	  free_feature (feature_1);
 	  return 1;
       }
+    feature_2 = create_feature (schema);
 
 /* loading the feature to be tested */
     page_url = sqlite3_mprintf ("%s&maxFeatures=1&startIndex=%d",
@@ -2494,7 +2416,6 @@ test_wfs_paging (const char *path_or_url, int page_size, xmlNodePtr node,
 	      xmlFreeDoc (xml_doc);
 	  goto second_chance;
       }
-    free_feature (feature_1);
     free_feature (feature_2);
     if (xml_doc != NULL)
 	xmlFreeDoc (xml_doc);
@@ -2514,14 +2435,12 @@ test_wfs_paging (const char *path_or_url, int page_size, xmlNodePtr node,
     parse_wfs_last_feature (root, schema, feature_2, &nRows);
     if (!compare_features (feature_1, feature_2))
 	goto error;
-    free_feature (feature_1);
     free_feature (feature_2);
     if (xml_doc != NULL)
 	xmlFreeDoc (xml_doc);
     *shift_index = 1;
     return 1;
   error:
-    free_feature (feature_1);
     free_feature (feature_2);
     if (xml_doc != NULL)
 	xmlFreeDoc (xml_doc);
@@ -3186,6 +3105,423 @@ do_adjust_geoms (sqlite3 * sqlite, const char *table, const char *geometry,
       }
 }
 
+static int
+is_wfs_feature (xmlTextReaderPtr reader, struct wfs_layer_schema *schema)
+{
+/* testing if the current XML element is a WFS feature */
+    const char *name = (const char *) xmlTextReaderConstLocalName (reader);
+    const char *prefix = (const char *) xmlTextReaderConstPrefix (reader);
+    int len;
+    if (name == NULL)
+	return 0;
+    if (strcmp (schema->layer_name, name) == 0)
+	return 1;
+    if (prefix == NULL)
+	return 0;
+    len = strlen (prefix);
+    if (strncmp (schema->layer_name, prefix, len) == 0
+	&& *(schema->layer_name + len) == ':'
+	&& strcmp (schema->layer_name + len + 1, name) == 0)
+	return 1;
+    return 0;
+}
+
+static void
+load_wfs_feature (xmlNodePtr node, struct wfs_layer_schema *schema,
+		  struct wfs_feature *last_feature, int *rows, char **err_msg)
+{
+/* inserting a single WFS feature into the target table */
+    if (!parse_wfs_single_feature (node->children, schema))
+	return;
+    if (schema->error)
+	return;
+    if (last_feature != NULL)
+      {
+	  /* saving the last feature so to test paging */
+	  do_save_feature (schema, last_feature);
+      }
+    if (do_insert (schema, err_msg))
+	*rows += 1;
+}
+
+static void
+defer_wfs_feature (xmlDocPtr * pending, xmlNodePtr node)
+{
+/* keeping a copy of some feature preceding the first Geometry */
+    xmlNodePtr root;
+    if (*pending == NULL)
+      {
+	  *pending = xmlNewDoc (BAD_CAST "1.0");
+	  root = xmlNewDocNode (*pending, NULL, BAD_CAST "pending", NULL);
+	  xmlDocSetRootElement (*pending, root);
+      }
+    root = xmlDocGetRootElement (*pending);
+    xmlAddChild (root, xmlDocCopyNode (node, *pending, 1));
+}
+
+static int
+begin_wfs_load (sqlite3 * sqlite, struct wfs_layer_schema *schema,
+		const char *table, const char *pk_column_name,
+		int spatial_index, xmlDocPtr pending,
+		struct wfs_feature *last_feature, int *rows, char **err_msg)
+{
+/* creating the output table and then inserting any deferred feature */
+    xmlNodePtr node;
+
+/* the output table will be created within the SQL Transaction */
+    if (!do_begin (sqlite, schema, err_msg))
+	return 0;
+    if (!prepare_sql
+	(sqlite, schema, table, pk_column_name, spatial_index, err_msg))
+      {
+	  do_rollback (sqlite, schema);
+	  return 0;
+      }
+    if (pending == NULL)
+	return 1;
+    node = xmlDocGetRootElement (pending)->children;
+    while (node != NULL)
+      {
+	  if (node->type == XML_ELEMENT_NODE)
+	      load_wfs_feature (node, schema, last_feature, rows, err_msg);
+	  node = node->next;
+      }
+    return 1;
+}
+
+#ifdef WFS_PREFETCH
+
+#define WFS_PREFETCH_DEFAULT	4
+#define WFS_PREFETCH_MAX	16
+
+struct wfs_page
+{
+/* a WFS page fetched in background */
+    char *payload;
+    int size;
+    int ready;
+    int ok;
+};
+
+struct wfs_prefetch
+{
+/* state shared by the loader and the fetching workers */
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    const char *path_or_url;
+    int page_size;
+    int first_index;		/* startIndex of the first prefetched page */
+    int depth;			/* how many pages may be fetched ahead */
+    int window;			/* growing up to depth as pages are consumed */
+    int last_page;		/* the last page to be fetched; -1 if unknown */
+    struct wfs_page *pages;	/* a ring of depth pages */
+    int next_page;		/* the next page to be claimed by a worker */
+    int consumed;		/* pages already handed to the loader */
+    int abort;
+    pthread_t *threads;
+    int started;
+};
+
+static int
+wfs_prefetch_depth (void)
+{
+/* how many WFS pages should be fetched ahead */
+    return splite_env_threads ("SPATIALITE_WFS_THREADS", WFS_PREFETCH_DEFAULT,
+			       WFS_PREFETCH_MAX);
+}
+
+static int
+fetch_wfs_page (const char *url, char **payload, int *size)
+{
+/* downloading a whole WFS page into memory */
+    char buf[65536];
+    char *p;
+    int len;
+    int max = 0;
+    void *ctx;
+
+    *payload = NULL;
+    *size = 0;
+    ctx = xmlNanoHTTPOpen (url, NULL);
+    if (ctx == NULL)
+	return 0;
+    while ((len = xmlNanoHTTPRead (ctx, buf, sizeof (buf))) > 0)
+      {
+	  if (*size + len > max)
+	    {
+		max = (max == 0) ? 1024 * 1024 : max * 2;
+		while (*size + len > max)
+		    max *= 2;
+		p = realloc (*payload, max);
+		if (p == NULL)
+		  {
+		      len = -1;
+		      break;
+		  }
+		*payload = p;
+	    }
+	  memcpy (*payload + *size, buf, len);
+	  *size += len;
+      }
+    xmlNanoHTTPClose (ctx);
+    if (len < 0 || *size == 0)
+      {
+	  if (*payload != NULL)
+	      free (*payload);
+	  *payload = NULL;
+	  *size = 0;
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+wfs_page_returned (const char *payload, int size)
+{
+/*
+/ searching the root element of a fetched WFS page for the count of
+/ the returned features (WFS 1.1 numberOfFeatures, WFS 2.0 numberReturned)
+/
+/ returns -1 if unknown
+*/
+    const char *names[] = { "numberOfFeatures=\"", "numberReturned=\"", NULL };
+    const char *p = payload;
+    const char *end = payload + size;
+    const char *root;
+    const char *root_end;
+    const char *attr;
+    int i;
+    int len;
+    while (1)
+      {
+	  /* skipping the XML declaration and any comment */
+	  p = memchr (p, '<', end - p);
+	  if (p == NULL || p + 1 >= end)
+	      return -1;
+	  if (*(p + 1) != '?' && *(p + 1) != '!')
+	      break;
+	  p++;
+      }
+    root = p;
+    root_end = memchr (root, '>', end - root);
+    if (root_end == NULL)
+	return -1;
+    for (i = 0; names[i] != NULL; i++)
+      {
+	  len = strlen (names[i]);
+	  for (attr = root; attr + len < root_end; attr++)
+	    {
+		if (strncmp (attr, names[i], len) == 0
+		    && *(attr + len) >= '0' && *(attr + len) <= '9')
+		    return atoi (attr + len);
+	    }
+      }
+    return -1;
+}
+
+static void *
+wfs_prefetch_main (void *arg)
+{
+/* fetching WFS pages ahead of the loader */
+    struct wfs_prefetch *pf = (struct wfs_prefetch *) arg;
+    struct wfs_page *page;
+    char *url;
+    char *payload;
+    int size;
+    int page_no;
+    int returned;
+    int ok;
+    while (1)
+      {
+	  pthread_mutex_lock (&(pf->mutex));
+	  while (!(pf->abort)
+		 && (pf->next_page >= pf->consumed + pf->window
+		     || (pf->last_page >= 0
+			 && pf->next_page > pf->last_page)))
+	      pthread_cond_wait (&(pf->cond), &(pf->mutex));
+	  if (pf->abort)
+	    {
+		pthread_mutex_unlock (&(pf->mutex));
+		break;
+	    }
+	  page_no = pf->next_page++;
+	  pthread_mutex_unlock (&(pf->mutex));
+
+	  url =
+	      sqlite3_mprintf ("%s&maxFeatures=%d&startIndex=%d",
+			       pf->path_or_url, pf->page_size,
+			       pf->first_index + (page_no * pf->page_size));
+	  ok = fetch_wfs_page (url, &payload, &size);
+	  sqlite3_free (url);
+	  returned = ok ? wfs_page_returned (payload, size) : -1;
+
+	  pthread_mutex_lock (&(pf->mutex));
+	  if (!ok || (returned >= 0 && returned < pf->page_size))
+	    {
+		/* a short page: no further page exists */
+		if (pf->last_page < 0 || page_no < pf->last_page)
+		    pf->last_page = page_no;
+	    }
+	  page = pf->pages + (page_no % pf->depth);
+	  page->payload = payload;
+	  page->size = size;
+	  page->ok = ok;
+	  page->ready = 1;
+	  pthread_cond_broadcast (&(pf->cond));
+	  pthread_mutex_unlock (&(pf->mutex));
+      }
+    return NULL;
+}
+
+static void
+destroy_wfs_prefetch (struct wfs_prefetch *pf)
+{
+/* stopping all fetching workers and freeing any unused page */
+    int i;
+    struct wfs_page *page;
+    if (pf == NULL)
+	return;
+    pthread_mutex_lock (&(pf->mutex));
+    pf->abort = 1;
+    pthread_cond_broadcast (&(pf->cond));
+    pthread_mutex_unlock (&(pf->mutex));
+    for (i = 0; i < pf->started; i++)
+	pthread_join (*(pf->threads + i), NULL);
+    for (i = 0; i < pf->depth; i++)
+      {
+	  page = pf->pages + i;
+	  if (page->payload != NULL)
+	      free (page->payload);
+      }
+    pthread_cond_destroy (&(pf->cond));
+    pthread_mutex_destroy (&(pf->mutex));
+    free (pf->threads);
+    free (pf->pages);
+    free (pf);
+}
+
+static struct wfs_prefetch *
+create_wfs_prefetch (const char *path_or_url, int page_size, int first_index,
+		     int end_index)
+{
+/*
+/ starting the workers fetching the WFS pages following first_index
+/ (end_index, if not negative, is the startIndex following the last feature)
+/
+/ returns NULL if prefetching is disabled or unsupported: the caller
+/ is then expected to fetch each page by itself
+*/
+    int i;
+    int depth;
+    struct wfs_page *page;
+    struct wfs_prefetch *pf;
+    if (strncmp (path_or_url, "http://", 7) != 0)
+	return NULL;
+    if (end_index >= 0 && end_index <= first_index)
+	return NULL;
+    depth = wfs_prefetch_depth ();
+    if (depth < 1)
+	return NULL;
+
+    /* must be called before starting any thread */
+    xmlNanoHTTPInit ();
+    pf = malloc (sizeof (struct wfs_prefetch));
+    if (pf == NULL)
+	return NULL;
+    pf->pages = malloc (sizeof (struct wfs_page) * depth);
+    pf->threads = malloc (sizeof (pthread_t) * depth);
+    if (pf->pages == NULL || pf->threads == NULL)
+      {
+	  free (pf->pages);
+	  free (pf->threads);
+	  free (pf);
+	  return NULL;
+      }
+    pf->path_or_url = path_or_url;
+    pf->page_size = page_size;
+    pf->first_index = first_index;
+    pf->depth = depth;
+    /* a single page at first: small layers don't waste any request */
+    pf->window = 1;
+    pf->last_page = -1;
+    if (end_index >= 0)
+	pf->last_page = (end_index - first_index - 1) / page_size;
+    for (i = 0; i < depth; i++)
+      {
+	  page = pf->pages + i;
+	  page->payload = NULL;
+	  page->size = 0;
+	  page->ready = 0;
+	  page->ok = 0;
+      }
+    pf->next_page = 0;
+    pf->consumed = 0;
+    pf->abort = 0;
+    pthread_mutex_init (&(pf->mutex), NULL);
+    pthread_cond_init (&(pf->cond), NULL);
+    pf->started = 0;
+    for (i = 0; i < depth; i++)
+      {
+	  if (pthread_create
+	      (pf->threads + pf->started, NULL, wfs_prefetch_main, pf) != 0)
+	      break;
+	  pf->started += 1;
+      }
+    if (pf->started == 0)
+      {
+	  destroy_wfs_prefetch (pf);
+	  return NULL;
+      }
+    return pf;
+}
+
+static int
+next_wfs_page (struct wfs_prefetch *pf, int start_index, char **payload,
+	       int *size)
+{
+/*
+/ handing the next prefetched page to the loader (preserving the page order)
+/
+/ returns -1 if the requested page doesn't match the prefetched one
+*/
+    struct wfs_page *page;
+    int ok;
+    *payload = NULL;
+    *size = 0;
+    pthread_mutex_lock (&(pf->mutex));
+    if (start_index != pf->first_index + (pf->consumed * pf->page_size))
+      {
+	  pthread_mutex_unlock (&(pf->mutex));
+	  return -1;
+      }
+    if (pf->last_page >= 0 && pf->consumed > pf->last_page)
+      {
+	  /* the page counts were wrong: fetching further pages */
+	  pf->last_page = -1;
+	  pthread_cond_broadcast (&(pf->cond));
+      }
+    page = pf->pages + (pf->consumed % pf->depth);
+    while (!(page->ready))
+	pthread_cond_wait (&(pf->cond), &(pf->mutex));
+    *payload = page->payload;
+    *size = page->size;
+    ok = page->ok;
+    page->payload = NULL;
+    page->size = 0;
+    page->ready = 0;
+    pf->consumed += 1;
+    if (pf->window < pf->depth)
+	pf->window *= 2;
+    if (pf->window > pf->depth)
+	pf->window = pf->depth;
+    /* allowing further pages to be fetched */
+    pthread_cond_broadcast (&(pf->cond));
+    pthread_mutex_unlock (&(pf->mutex));
+    return ok;
+}
+
+#endif /* end WFS_PREFETCH */
+
 SPATIALITE_DECLARE int
 load_from_wfs_paged (sqlite3 * sqlite, const char *path_or_url,
 		     const char *alt_describe_uri, const char *layer_name,
@@ -3195,16 +3531,33 @@ load_from_wfs_paged (sqlite3 * sqlite, const char *path_or_url,
 		     void (*progress_callback) (int, void *),
 		     void *callback_ptr)
 {
-/* attempting to load data from some WFS source [paged]*/
-    xmlDocPtr xml_doc = NULL;
-    xmlNodePtr root;
+/*
+/ attempting to load data from some WFS source [paged]
+/
+/ each page is streamed by an XmlTextReader: only a single
+/ feature at each time is expanded as a DOM subtree, so that
+/ memory usage doesn't depend at all on the page size
+*/
+    xmlTextReaderPtr reader = NULL;
+    xmlNodePtr node;
+    xmlDocPtr pending = NULL;
+    char *payload = NULL;
+    int payload_size;
+#ifdef WFS_PREFETCH
+    struct wfs_prefetch *prefetch = NULL;
+    int end_index = -1;
+    xmlChar *matched;
+#endif
     struct wfs_layer_schema *schema = NULL;
+    struct wfs_feature *last_feature = NULL;
+    struct wfs_feature *p_last;
     int len;
     int ret;
     char *describe_uri = NULL;
     gaiaOutBuffer errBuf;
     int ok = 0;
-    int sniffed = 0;
+    int is_root;
+    int prepared = 0;
     int pageNo = 0;
     int startIdx = 0;
     int nRows;
@@ -3218,6 +3571,7 @@ load_from_wfs_paged (sqlite3 * sqlite, const char *path_or_url,
     if (path_or_url == NULL)
 	return 0;
 
+    gaiaOutBufferInitialize (&errBuf);
     while (1)
       {
 	  if (page_size <= 0)
@@ -3230,96 +3584,202 @@ load_from_wfs_paged (sqlite3 * sqlite, const char *path_or_url,
 		p_page_url = page_url;
 	    }
 
-	  /* loading the WFS payload from URL (or file) */
-	  gaiaOutBufferInitialize (&errBuf);
+	  /* streaming the WFS payload from URL (or file) */
+	  gaiaOutBufferReset (&errBuf);
 	  xmlSetGenericErrorFunc (&errBuf, parsingError);
-	  xml_doc = xmlReadFile (p_page_url, NULL, 0);
+#ifdef WFS_PREFETCH
+	  if (prefetch != NULL
+	      && next_wfs_page (prefetch, startIdx, &payload,
+				&payload_size) < 0)
+	    {
+		/* unexpected page boundaries: prefetching again from here */
+		destroy_wfs_prefetch (prefetch);
+		prefetch =
+		    create_wfs_prefetch (path_or_url, page_size, startIdx, -1);
+		if (prefetch != NULL)
+		    next_wfs_page (prefetch, startIdx, &payload,
+				   &payload_size);
+	    }
+	  if (prefetch != NULL)
+	    {
+		/* the page has already been fetched in background */
+		if (payload != NULL)
+		    reader =
+			xmlReaderForMemory (payload, payload_size, p_page_url,
+					    NULL, 0);
+	    }
+	  else
+#endif
+	      reader = xmlReaderForFile (p_page_url, NULL, 0);
+	  if (reader == NULL && errBuf.Buffer == NULL)
+	    {
+		char *err = sqlite3_mprintf ("unable to load \"%s\"\n",
+					     p_page_url);
+		gaiaAppendToOutBuffer (&errBuf, err);
+		sqlite3_free (err);
+	    }
 	  if (page_url != NULL)
 	      sqlite3_free (page_url);
-	  if (xml_doc == NULL)
+	  page_url = NULL;
+	  if (reader == NULL)
+	      goto parsing_error;
+	  xmlTextReaderSetErrorHandler (reader, wfsReaderError, &errBuf);
+
+	  nRows = 0;
+	  is_root = 1;
+	  p_last = (pageNo == 0) ? last_feature : NULL;
+	  ret = xmlTextReaderRead (reader);
+	  while (ret == 1)
 	    {
-		/* parsing error; not a well-formed XML */
-		if (errBuf.Buffer != NULL && err_msg != NULL)
+		if (xmlTextReaderNodeType (reader) != XML_READER_TYPE_ELEMENT)
 		  {
-		      len = strlen (errBuf.Buffer);
-		      *err_msg = malloc (len + 1);
-		      strcpy (*err_msg, errBuf.Buffer);
+		      ret = xmlTextReaderRead (reader);
+		      continue;
 		  }
-		goto end;
-	    }
+		if (is_root && pageNo == 0)
+		  {
+#ifdef WFS_PREFETCH
+		      /* WFS 2.0: the total count of features, if known */
+		      matched =
+			  xmlTextReaderGetAttribute (reader,
+						     BAD_CAST "numberMatched");
+		      if (matched != NULL)
+			{
+			    if (*matched >= '0' && *matched <= '9')
+				end_index = atoi ((const char *) matched);
+			    xmlFree (matched);
+			}
+#endif
+		      if (alt_describe_uri != NULL)
+			{
+			    /* using the DescribetFeatureType URI from GetCapabilities */
+			    len = strlen (alt_describe_uri);
+			    describe_uri = malloc (len + 1);
+			    strcpy (describe_uri, alt_describe_uri);
+			    ret = 1;
+			}
+		      else
+			{
+			    /* attempting to extract the DescribeFeatureType from the GetFeature document */
+			    node = xmlTextReaderCurrentNode (reader);
+			    ret =
+				get_DescribeFeatureType_uri (node,
+							     &describe_uri);
+			}
+		      if (ret == 0)
+			{
+			    const char *msg =
+				"Unable to retrieve the DescribeFeatureType URI";
+			    if (err_msg != NULL)
+			      {
+				  len = strlen (msg);
+				  *err_msg = malloc (len + 1);
+				  strcpy (*err_msg, msg);
+			      }
+			    goto end;
+			}
 
-	  if (pageNo == 0)
-	    {
-		if (alt_describe_uri != NULL)
+		      /* loading and parsing the WFS schema */
+		      schema =
+			  load_wfs_schema (describe_uri, layer_name, swap_axes,
+					   err_msg);
+		      if (schema == NULL)
+			  goto end;
+		      if (page_size > 0)
+			  last_feature = create_feature (schema);
+		      p_last = last_feature;
+		  }
+		if (is_root)
 		  {
-		      /* using the DescribetFeatureType URI from GetCapabilities */
-		      len = strlen (alt_describe_uri);
-		      describe_uri = malloc (len + 1);
-		      strcpy (describe_uri, alt_describe_uri);
-		      ret = 1;
+		      is_root = 0;
+		      ret = xmlTextReaderRead (reader);
+		      continue;
 		  }
-		else
+		if (!is_wfs_feature (reader, schema))
+		  {
+		      ret = xmlTextReaderRead (reader);
+		      continue;
+		  }
+
+		/* expanding the current feature only */
+		node = xmlTextReaderExpand (reader);
+		if (node == NULL)
 		  {
-		      /* attempting to extract the DescribeFeatureType from the GetFeature document */
-		      ret =
-			  get_DescribeFeatureType_uri (xml_doc, &describe_uri);
+		      ret = -1;
+		      break;
 		  }
-		if (ret == 0)
+		if (!prepared && schema->geometry_name != NULL
+		    && !sniff_wfs_single_feature (node->children, schema))
 		  {
-		      const char *msg =
-			  "Unable to retrieve the DescribeFeatureType URI";
-		      if (err_msg != NULL)
+		      /* still waiting for the first Geometry to be sniffed */
+		      defer_wfs_feature (&pending, node);
+		  }
+		else
+		  {
+		      if (!prepared)
 			{
-			    len = strlen (msg);
-			    *err_msg = malloc (len + 1);
-			    strcpy (*err_msg, msg);
+			    /* creating the output table */
+			    if (!begin_wfs_load
+				(sqlite, schema, table, pk_column_name,
+				 spatial_index, pending, p_last, &nRows,
+				 err_msg))
+				goto end;
+			    prepared = 1;
 			}
-		      goto end;
+		      load_wfs_feature (node, schema, p_last, &nRows, err_msg);
+		      if (schema->error)
+			  break;
 		  }
+		/* skipping the whole feature subtree */
+		ret = xmlTextReaderNext (reader);
+	    }
+	  if (is_root || (ret < 0 && !schema->error))
+	    {
+		/* parsing error; not a well-formed XML */
+		if (prepared)
+		    do_rollback (sqlite, schema);
+		goto parsing_error;
+	    }
 
-		/* loading and parsing the WFS schema */
-		schema =
-		    load_wfs_schema (describe_uri, layer_name, swap_axes,
-				     err_msg);
-		if (schema == NULL)
+	  if (!prepared)
+	    {
+		/* creating the output table (no Geometry was sniffed) */
+		if (!begin_wfs_load
+		    (sqlite, schema, table, pk_column_name, spatial_index,
+		     pending, p_last, &nRows, err_msg))
 		    goto end;
+		prepared = 1;
+	    }
+	  if (pending != NULL)
+	      xmlFreeDoc (pending);
+	  pending = NULL;
 
-		/* creating the output table */
-		root = xmlDocGetRootElement (xml_doc);
-		sniffed = 0;
-		sniff_geometries (root, schema, &sniffed);
-
-		if (page_size > 0)
+	  if (page_size > 0 && pageNo == 0 && !schema->error)
+	    {
+		/* testing if the server does actually support STARTINDEX */
+		if (!test_wfs_paging
+		    (path_or_url, page_size, nRows, last_feature, schema,
+		     &shift_index))
 		  {
-		      /* testing if the server does actually support STARTINDEX */
-		      root = xmlDocGetRootElement (xml_doc);
-		      if (!test_wfs_paging
-			  (path_or_url, page_size, root, schema, &shift_index))
+		      const char *err =
+			  "loawfs: the WFS server doesn't seem to support STARTINDEX\n"
+			  "and consequently WFS paging is not available";
+		      if (err_msg != NULL)
 			{
-			    const char *err =
-				"loawfs: the WFS server doesn't seem to support STARTINDEX\n"
-				"and consequently WFS paging is not available";
-			    if (err_msg != NULL)
-			      {
-				  len = strlen (err);
-				  *err_msg = malloc (len + 1);
-				  strcpy (*err_msg, err);
-			      }
-			    goto end;
+			    len = strlen (err);
+			    *err_msg = malloc (len + 1);
+			    strcpy (*err_msg, err);
 			}
-		      startIdx += shift_index;
+		      do_rollback (sqlite, schema);
+		      goto end;
 		  }
-
-		if (!prepare_sql
-		    (sqlite, schema, table, pk_column_name, spatial_index,
-		     err_msg))
-		    goto end;
+		startIdx += shift_index;
+#ifdef WFS_PREFETCH
+		if (end_index >= 0)
+		    end_index += shift_index;
+#endif
 	    }
 
-	  /* parsing the WFS payload */
-	  root = xmlDocGetRootElement (xml_doc);
-	  nRows = 0;
-	  parse_wfs_features (root, schema, &nRows, err_msg);
 	  *rows += nRows;
 	  if (progress_callback != NULL)
 	    {
@@ -3350,11 +3810,22 @@ load_from_wfs_paged (sqlite3 * sqlite, const char *path_or_url,
 	  if (nRows < page_size)
 	      break;
 
-	  if (xml_doc != NULL)
-	      xmlFreeDoc (xml_doc);
-	  xml_doc = NULL;
+	  xmlFreeTextReader (reader);
+	  reader = NULL;
+	  if (payload != NULL)
+	      free (payload);
+	  payload = NULL;
 	  pageNo++;
 	  startIdx += nRows;
+#ifdef WFS_PREFETCH
+	  if (pageNo == 1)
+	    {
+		/* fetching the following pages in background */
+		prefetch =
+		    create_wfs_prefetch (path_or_url, page_size, startIdx,
+					 end_index);
+	    }
+#endif
       }
 
     if (schema->geometry_type == GAIA_GEOMETRYCOLLECTION)
@@ -3370,15 +3841,33 @@ load_from_wfs_paged (sqlite3 * sqlite, const char *path_or_url,
 	    }
       }
     ok = 1;
+    goto end;
+
+  parsing_error:
+    if (errBuf.Buffer != NULL && err_msg != NULL && *err_msg == NULL)
+      {
+	  len = strlen (errBuf.Buffer);
+	  *err_msg = malloc (len + 1);
+	  strcpy (*err_msg, errBuf.Buffer);
+      }
   end:
+    if (last_feature != NULL)
+	free_feature (last_feature);
+    if (pending != NULL)
+	xmlFreeDoc (pending);
     if (schema != NULL)
 	free_wfs_layer_schema (schema);
     if (describe_uri != NULL)
 	free (describe_uri);
     gaiaOutBufferReset (&errBuf);
     xmlSetGenericErrorFunc ((void *) stderr, NULL);
-    if (xml_doc != NULL)
-	xmlFreeDoc (xml_doc);
+    if (reader != NULL)
+	xmlFreeTextReader (reader);
+    if (payload != NULL)
+	free (payload);
+#ifdef WFS_PREFETCH
+    destroy_wfs_prefetch (prefetch);
+#endif
     return ok;
 }
 
@@ -0,0 +1,363 @@
+/*
+
+ bench_text_parsers.c -- SpatiaLite benchmark
+
+ Author: Sandro Furieri <a.furieri@lqt.it>
+
+ ------------------------------------------------------------------------------
+
+ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+
+ The contents of this file are subject to the Mozilla Public License Version
+ 1.1 (the "License"); you may not use this file except in compliance with
+ the License. You may obtain a copy of the License at
+ http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the
+License.
+
+The Original Code is the SpatiaLite library
+
+The Initial Developer of the Original Code is Alessandro Furieri
+
+Portions created by the Initial Developer are Copyright (C) 2011
+the Initial Developer. All Rights Reserved.
+
+Contributor(s):
+Brad Hards <bradh@frogmouth.net>
+
+Alternatively, the contents of this file may be used under the terms of
+either the GNU General Public License Version 2 or later (the "GPL"), or
+the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+in which case the provisions of the GPL or the LGPL are applicable instead
+of those above. If you wish to allow use of your version of this file only
+under the terms of either the GPL or the LGPL, and not to allow others to
+use your version of this file under the terms of the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice
+and other provisions required by the GPL or the LGPL. If you do not delete
+the provisions above, a recipient may use your version of this file under
+the terms of any one of the MPL, the GPL or the LGPL.
+
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+
+#include "sqlite3.h"
+#include "spatialite.h"
+#include "spatialite/gaiageo.h"
+
+/*
+/ a parse-throughput benchmark for the text geometry parsers:
+/ every format is fed with lots of tiny POINTs (the typical GPS ping),
+/ with mid-sized POLYGONs having a hole and with a single huge
+/ LINESTRING Z, so to expose any per-call or per-vertex overhead
+*/
+
+#define POINT_ROWS		100000
+#define POLYGON_ROWS		10000
+#define POLYGON_VERTICES	64
+#define HUGE_VERTICES		20000
+
+struct text_format
+{
+    const char *name;
+    const char *sql;
+    void (*encode) (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom);
+};
+
+static void
+encode_wkt (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom)
+{
+    gaiaOutWkt (out_buf, geom);
+}
+
+static void
+encode_ewkt (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom)
+{
+    gaiaToEWKT (out_buf, geom);
+}
+
+static void
+encode_geojson (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom)
+{
+    gaiaOutGeoJSON (out_buf, geom, 6, 0);
+}
+
+static void
+encode_kml (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom)
+{
+    gaiaOutBareKml (out_buf, geom, 6);
+}
+
+static void
+encode_gml (gaiaOutBufferPtr out_buf, gaiaGeomCollPtr geom)
+{
+    gaiaOutGml (out_buf, 3, 6, geom);
+}
+
+static struct text_format formats[] = {
+    {"WKT", "SELECT GeomFromText(?)", encode_wkt},
+    {"EWKT", "SELECT GeomFromEWKT(?)", encode_ewkt},
+    {"GeoJSON", "SELECT GeomFromGeoJSON(?)", encode_geojson},
+    {"KML", "SELECT GeomFromKml(?)", encode_kml},
+    {"GML", "SELECT GeomFromGml(?)", encode_gml},
+    {NULL, NULL, NULL}
+};
+
+static gaiaGeomCollPtr
+make_point (int i)
+{
+/* a GPS ping */
+    gaiaGeomCollPtr geom = gaiaAllocGeomColl ();
+    geom->Srid = 4326;
+    geom->DeclaredType = GAIA_POINT;
+    gaiaAddPointToGeomColl (geom, 11.0 + (i % 1000) * 0.001,
+			    43.0 + (i / 1000) * 0.001);
+    return geom;
+}
+
+static gaiaGeomCollPtr
+make_polygon (int i)
+{
+/* a square-ish Polygon with a square hole */
+    gaiaGeomCollPtr geom = gaiaAllocGeomColl ();
+    gaiaPolygonPtr polyg;
+    gaiaRingPtr ring;
+    double x0 = (i % 100) * 10.0;
+    double y0 = (i / 100) * 10.0;
+    int side = POLYGON_VERTICES / 4;
+    int iv;
+    geom->Srid = 4326;
+    geom->DeclaredType = GAIA_POLYGON;
+    polyg = gaiaAddPolygonToGeomColl (geom, POLYGON_VERTICES + 1, 1);
+    ring = polyg->Exterior;
+    for (iv = 0; iv < side; iv++)
+      {
+	  gaiaSetPoint (ring->Coords, iv, x0 + iv * 0.5, y0);
+	  gaiaSetPoint (ring->Coords, side + iv, x0 + 8.0, y0 + iv * 0.5);
+	  gaiaSetPoint (ring->Coords, (2 * side) + iv, x0 + 8.0 - iv * 0.5,
+			y0 + 8.0);
+	  gaiaSetPoint (ring->Coords, (3 * side) + iv, x0, y0 + 8.0 - iv * 0.5);
+      }
+    gaiaSetPoint (ring->Coords, POLYGON_VERTICES, x0, y0);
+    ring = gaiaAddInteriorRing (polyg, 0, 5);
+    gaiaSetPoint (ring->Coords, 0, x0 + 2.0, y0 + 2.0);
+    gaiaSetPoint (ring->Coords, 1, x0 + 2.0, y0 + 4.0);
+    gaiaSetPoint (ring->Coords, 2, x0 + 4.0, y0 + 4.0);
+    gaiaSetPoint (ring->Coords, 3, x0 + 4.0, y0 + 2.0);
+    gaiaSetPoint (ring->Coords, 4, x0 + 2.0, y0 + 2.0);
+    return geom;
+}
+
+static gaiaGeomCollPtr
+make_huge_line (int i)
+{
+/* a very long 3D track */
+    gaiaGeomCollPtr geom = gaiaAllocGeomCollXYZ ();
+    gaiaLinestringPtr line;
+    int iv;
+    geom->Srid = 4326;
+    geom->DeclaredType = GAIA_LINESTRING;
+    line = gaiaAddLinestringToGeomColl (geom, HUGE_VERTICES);
+    for (iv = 0; iv < HUGE_VERTICES; iv++)
+	gaiaSetPointXYZ (line->Coords, iv, i + iv * 0.25, (iv % 100) * 0.5,
+			 iv * 0.125);
+    return geom;
+}
+
+static char *
+geometry_signature (gaiaGeomCollPtr geom)
+{
+/* a format-neutral textual representation (SRID ignored) */
+    char *sig;
+    gaiaOutBuffer out_buf;
+    gaiaOutBufferInitialize (&out_buf);
+    gaiaOutWktEx (&out_buf, geom, 3);
+    sig = out_buf.Buffer;
+    out_buf.Buffer = NULL;
+    gaiaOutBufferReset (&out_buf);
+    return sig;
+}
+
+static int
+check_parsed (sqlite3_stmt * stmt, const char *text, const char *expected)
+{
+/* parsing a single text and comparing the result */
+    gaiaGeomCollPtr geom = NULL;
+    char *sig;
+    int ok;
+    sqlite3_reset (stmt);
+    sqlite3_bind_text (stmt, 1, text, -1, SQLITE_STATIC);
+    if (sqlite3_step (stmt) == SQLITE_ROW
+	&& sqlite3_column_type (stmt, 0) == SQLITE_BLOB)
+	geom =
+	    gaiaFromSpatiaLiteBlobWkb (sqlite3_column_blob (stmt, 0),
+				       sqlite3_column_bytes (stmt, 0));
+    if (geom == NULL)
+	return 0;
+    sig = geometry_signature (geom);
+    gaiaFreeGeomColl (geom);
+    ok = strcmp (sig, expected) == 0;
+    free (sig);
+    return ok;
+}
+
+static int
+run_benchmark (sqlite3 * handle, struct text_format *fmt, const char *label,
+	       gaiaGeomCollPtr (*make) (int), int rows, int repeat)
+{
+/* parsing many texts of the same kind and reporting the throughput */
+    sqlite3_stmt *stmt;
+    gaiaGeomCollPtr geom;
+    gaiaOutBuffer out_buf;
+    char **texts;
+    char *first_sig;
+    char *last_sig;
+    double bytes = 0.0;
+    double secs;
+    clock_t t0;
+    int i;
+    int r;
+    int ok = 1;
+    int ret;
+
+    texts = malloc (sizeof (char *) * rows);
+    geom = make (0);
+    first_sig = geometry_signature (geom);
+    gaiaFreeGeomColl (geom);
+    geom = make (rows - 1);
+    last_sig = geometry_signature (geom);
+    gaiaFreeGeomColl (geom);
+    for (i = 0; i < rows; i++)
+      {
+	  geom = make (i);
+	  gaiaOutBufferInitialize (&out_buf);
+	  fmt->encode (&out_buf, geom);
+	  gaiaFreeGeomColl (geom);
+	  texts[i] = out_buf.Buffer;
+	  bytes += out_buf.WriteOffset;
+	  out_buf.Buffer = NULL;
+	  gaiaOutBufferReset (&out_buf);
+      }
+
+    ret = sqlite3_prepare_v2 (handle, fmt->sql, -1, &stmt, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "%s: %s\n", fmt->sql, sqlite3_errmsg (handle));
+	  ok = 0;
+	  goto end;
+      }
+
+    t0 = clock ();
+    for (r = 0; r < repeat && ok; r++)
+      {
+	  for (i = 0; i < rows; i++)
+	    {
+		sqlite3_reset (stmt);
+		sqlite3_bind_text (stmt, 1, texts[i], -1, SQLITE_STATIC);
+		if (sqlite3_step (stmt) != SQLITE_ROW
+		    || sqlite3_column_type (stmt, 0) != SQLITE_BLOB)
+		  {
+		      fprintf (stderr, "%s %s: unable to parse row #%d\n",
+			       fmt->name, label, i);
+		      ok = 0;
+		      break;
+		  }
+	    }
+      }
+    secs = (double) (clock () - t0) / CLOCKS_PER_SEC;
+    if (secs <= 0.0)
+	secs = 0.000001;
+    if (ok)
+	fprintf (stderr,
+		 "%-8s %-10s %7d rows %8.3f sec %10.0f rows/sec %8.1f MB/sec\n",
+		 fmt->name, label, rows * repeat, secs,
+		 (rows * repeat) / secs,
+		 (bytes * repeat) / (1024.0 * 1024.0) / secs);
+
+    if (ok && !check_parsed (stmt, texts[0], first_sig))
+      {
+	  fprintf (stderr, "%s %s: unexpected first Geometry\n", fmt->name,
+		   label);
+	  ok = 0;
+      }
+    if (ok && !check_parsed (stmt, texts[rows - 1], last_sig))
+      {
+	  fprintf (stderr, "%s %s: unexpected last Geometry\n", fmt->name,
+		   label);
+	  ok = 0;
+      }
+    sqlite3_finalize (stmt);
+
+  end:
+    for (i = 0; i < rows; i++)
+	free (texts[i]);
+    free (texts);
+    free (first_sig);
+    free (last_sig);
+    return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+    int ret;
+    sqlite3 *handle;
+    struct text_format *fmt;
+    void *cache = spatialite_alloc_connection ();
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory database: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -1;
+      }
+
+    spatialite_init_ex (handle, cache, 0);
+
+    for (fmt = formats; fmt->name != NULL; fmt++)
+      {
+	  if (!run_benchmark (handle, fmt, "POINT", make_point, POINT_ROWS, 1))
+	    {
+		sqlite3_close (handle);
+		return -2;
+	    }
+	  if (!run_benchmark
+	      (handle, fmt, "POLYGON", make_polygon, POLYGON_ROWS, 1))
+	    {
+		sqlite3_close (handle);
+		return -3;
+	    }
+	  if (!run_benchmark
+	      (handle, fmt, "LINESTRING", make_huge_line, 1, 5))
+	    {
+		sqlite3_close (handle);
+		return -4;
+	    }
+      }
+
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  return -5;
+      }
+
+    spatialite_cleanup_ex (cache);
+    spatialite_shutdown ();
+    return 0;
+}
@@ -44,6 +44,7 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include "config.h"
 
@@ -1389,6 +1390,667 @@ check_symbol_legacy (int cache_mode)
     return 0;
 }
 
+
+static void
+write_dxf_entity (FILE * out, const char *kind, const char *layer)
+{
+/* writing the header of a DXF entity */
+    fprintf (out, "0\n%s\n8\n%s\n", kind, layer);
+}
+
+static int
+write_stream_dxf (const char *path, int bulk)
+{
+/*
+/ writing a DXF file large enough to be imported in several batches:
+/ a Layer only appearing at the very end follows long Polylines and
+/ INSERTs (each one referencing both a Line and a Point)
+*/
+    int i;
+    int j;
+    FILE *out = fopen (path, "wb");
+    if (out == NULL)
+	return 0;
+    if (bulk)
+      {
+	  fprintf (out, "0\nSECTION\n2\nBLOCKS\n0\nBLOCK\n8\nins\n2\nblk\n");
+	  fprintf (out, "10\n0\n20\n0\n30\n0\n");
+	  write_dxf_entity (out, "LINE", "ins");
+	  fprintf (out, "10\n0\n20\n0\n30\n0\n11\n1\n21\n1\n31\n0\n");
+	  write_dxf_entity (out, "POINT", "ins");
+	  fprintf (out, "10\n0.5\n20\n0.5\n30\n0\n");
+	  fprintf (out, "0\nENDBLK\n0\nENDSEC\n");
+      }
+    fprintf (out, "0\nSECTION\n2\nENTITIES\n");
+    for (i = 0; bulk && i < 100; i++)
+      {
+	  write_dxf_entity (out, "LWPOLYLINE", "bulk");
+	  fprintf (out, "90\n1000\n70\n0\n");
+	  for (j = 0; j < 1000; j++)
+	      fprintf (out, "10\n%d\n20\n%d\n", j, i * 2 + (j % 2));
+      }
+    for (i = 0; bulk && i < 1000; i++)
+      {
+	  write_dxf_entity (out, "INSERT", "ins");
+	  fprintf (out, "2\nblk\n10\n%d\n20\n2\n30\n0\n", i);
+	  fprintf (out, "41\n1\n42\n1\n43\n1\n50\n0\n");
+      }
+    for (i = 0; i < 10; i++)
+      {
+	  write_dxf_entity (out, "POINT", "late");
+	  fprintf (out, "10\n%d\n20\n5\n30\n0\n", i);
+      }
+    fprintf (out, "0\nENDSEC\n0\nEOF\n");
+    fclose (out);
+    return 1;
+}
+
+static int
+count_table_rows (sqlite3 * handle, const char *table)
+{
+/* counting the rows of some table */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    int count = -1;
+    char *sql = sqlite3_mprintf ("SELECT Count(*) FROM \"%w\"", table);
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+	return -1;
+    if (rows == 1)
+	count = atoi (results[1]);
+    sqlite3_free_table (results);
+    return count;
+}
+
+static int
+same_table_rows (sqlite3 * handle, const char *columns_list,
+		 const char *table1, const char *table2)
+{
+/* checking that both tables contain exactly the same rows */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    int same = 0;
+    char *sql =
+	sqlite3_mprintf ("SELECT (SELECT Count(*) FROM \"%w\") - "
+			 "(SELECT Count(*) FROM \"%w\"), "
+			 "(SELECT Count(*) FROM (SELECT %s FROM \"%w\" "
+			 "EXCEPT SELECT %s FROM \"%w\"))",
+			 table1, table2, columns_list, table1, columns_list,
+			 table2);
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "compare \"%s\" error: %s\n", table1,
+		   sqlite3_errmsg (handle));
+	  return 0;
+      }
+    if (rows == 1)
+	same = atoi (results[2]) == 0 && atoi (results[3]) == 0;
+    sqlite3_free_table (results);
+    if (!same)
+	fprintf (stderr, "\"%s\" and \"%s\" differ\n", table1, table2);
+    return same;
+}
+
+static int
+load_stream_dxf (void *cache, sqlite3 * handle, const char *path,
+		 const char *prefix, int mode, int append, int streaming)
+{
+/* importing a DXF file either by streaming or after parsing it */
+    int ret;
+    gaiaDxfParserPtr dxf =
+	gaiaCreateDxfParser (4326, GAIA_DXF_AUTO_2D_3D, prefix, NULL,
+			     GAIA_DXF_RING_NONE);
+    if (dxf == NULL)
+	return 0;
+    if (streaming)
+	ret = gaiaLoadFromDxfFile_r (cache, handle, dxf, path, mode, append);
+    else
+      {
+	  ret = gaiaParseDxfFile_r (cache, dxf, path);
+	  if (ret)
+	      ret = gaiaLoadFromDxfParser (handle, dxf, mode, append);
+      }
+    gaiaDestroyDxfParser (dxf);
+    return ret;
+}
+
+static int
+check_stream ()
+{
+/* importing a DXF file in several batches */
+    int ret;
+    sqlite3 *handle;
+    char *err_msg = NULL;
+    int result = 0;
+    const char *path = "./check_dxf_stream.tmp";
+    const char *late_path = "./check_dxf_late.tmp";
+    void *cache = spatialite_alloc_connection ();
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory database: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -1;
+      }
+    spatialite_init_ex (handle, cache, 0);
+    ret =
+	sqlite3_exec (handle, "SELECT InitSpatialMetadata(1)", NULL, NULL,
+		      &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "InitSpatialMetadata() error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -2;
+      }
+    if (!write_stream_dxf (path, 1) || !write_stream_dxf (late_path, 0))
+      {
+	  fprintf (stderr, "unable to write the streaming DXF files\n");
+	  result = -3;
+	  goto stop;
+      }
+
+/* a table created before the import must not be silently appended */
+    if (!load_stream_dxf
+	(cache, handle, late_path, NULL, GAIA_DXF_IMPORT_BY_LAYER, 0, 1))
+      {
+	  fprintf (stderr, "Unable to load \"%s\"\n", late_path);
+	  result = -4;
+	  goto stop;
+      }
+    if (load_stream_dxf
+	(cache, handle, path, NULL, GAIA_DXF_IMPORT_BY_LAYER, 0, 1))
+      {
+	  fprintf (stderr, "\"late_point_2d\" unexpectedly appended\n");
+	  result = -5;
+	  goto stop;
+      }
+
+/* streaming and parsing the whole file must store the same rows */
+    if (!load_stream_dxf
+	(cache, handle, path, "s_", GAIA_DXF_IMPORT_BY_LAYER, 0, 1)
+	|| !load_stream_dxf (cache, handle, path, "p_",
+			     GAIA_DXF_IMPORT_BY_LAYER, 0, 0))
+      {
+	  fprintf (stderr, "Unable to load \"%s\" byLayer\n", path);
+	  result = -6;
+	  goto stop;
+      }
+    if (count_table_rows (handle, "s_bulk_line_2d") != 100
+	|| count_table_rows (handle, "s_ins_insline_2d") != 1000
+	|| count_table_rows (handle, "s_ins_inspoint_2d") != 1000
+	|| count_table_rows (handle, "s_late_point_2d") != 10)
+      {
+	  fprintf (stderr, "Unexpected rows streaming \"%s\" byLayer\n", path);
+	  result = -7;
+	  goto stop;
+      }
+    if (!same_table_rows (handle, "*", "s_bulk_line_2d", "p_bulk_line_2d")
+	|| !same_table_rows (handle, "*", "s_ins_insline_2d",
+			     "p_ins_insline_2d")
+	|| !same_table_rows (handle, "*", "s_ins_inspoint_2d",
+			     "p_ins_inspoint_2d")
+	|| !same_table_rows (handle, "*", "s_late_point_2d",
+			     "p_late_point_2d"))
+      {
+	  result = -8;
+	  goto stop;
+      }
+
+/* mixed mode: feature ids follow the batch order */
+    if (!load_stream_dxf
+	(cache, handle, path, "sm_", GAIA_DXF_IMPORT_MIXED, 0, 1)
+	|| !load_stream_dxf (cache, handle, path, "pm_",
+			     GAIA_DXF_IMPORT_MIXED, 0, 0))
+      {
+	  fprintf (stderr, "Unable to load \"%s\" mixed\n", path);
+	  result = -9;
+	  goto stop;
+      }
+    if (!same_table_rows
+	(handle, "layer, geometry", "sm_line_layer_2d", "pm_line_layer_2d")
+	|| !same_table_rows (handle, "layer, geometry", "sm_point_layer_2d",
+			     "pm_point_layer_2d")
+	|| !same_table_rows (handle, "layer, x, y", "sm_insline_layer_2d",
+			     "pm_insline_layer_2d"))
+      {
+	  result = -10;
+	  goto stop;
+      }
+
+/* appending once again */
+    if (!load_stream_dxf
+	(cache, handle, path, "s_", GAIA_DXF_IMPORT_BY_LAYER, 1, 1))
+      {
+	  fprintf (stderr, "Unable to append \"%s\" byLayer\n", path);
+	  result = -11;
+	  goto stop;
+      }
+    if (count_table_rows (handle, "s_bulk_line_2d") != 200
+	|| count_table_rows (handle, "s_late_point_2d") != 20)
+      {
+	  fprintf (stderr, "Unexpected rows appending \"%s\"\n", path);
+	  result = -12;
+	  goto stop;
+      }
+
+  stop:
+    unlink (path);
+    unlink (late_path);
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK && result == 0)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  result = -13;
+      }
+    spatialite_cleanup_ex (cache);
+    return result;
+}
+
+
+static void
+put_dxf_pair (FILE * out, int crlf, const char *code, const char *value)
+{
+/* writing a DXF code/value pair, either LF or CRLF terminated */
+    const char *eol = crlf ? "\r\n" : "\n";
+    fprintf (out, "%s%s%s%s", code, eol, value, eol);
+}
+
+static int
+write_scanner_dxf (const char *path, int crlf, int too_long)
+{
+/*
+/ writing a DXF file exercising the buffered scanner and the hash indexes:
+/ 300 Layers, 300 Blocks plus a duplicate Block name, and Text labels
+/ 4000 chars long, so that many lines cross the read buffer boundaries
+/ (the very first boundary splitting a CR/LF pair)
+*/
+    int i;
+    char value[8192];
+    char label[4001];
+    long room;
+    FILE *out = fopen (path, "wb");
+    if (out == NULL)
+	return 0;
+/* comments ending exactly where the first 64 KiB read buffer ends */
+    memset (label, '#', 4000);
+    label[4000] = '\0';
+    while (1)
+      {
+	  room = 65535 - ftell (out) - (crlf ? 5 : 4);
+	  if (room <= 4000)
+	      break;
+	  put_dxf_pair (out, crlf, "999", label);
+      }
+    label[room] = '\0';
+    put_dxf_pair (out, crlf, "999", label);
+    put_dxf_pair (out, crlf, "0", "SECTION");
+    put_dxf_pair (out, crlf, "2", "BLOCKS");
+    for (i = 0; i < 300; i++)
+      {
+	  put_dxf_pair (out, crlf, "0", "BLOCK");
+	  put_dxf_pair (out, crlf, "8", "ins");
+	  sprintf (value, "blk%d", i);
+	  put_dxf_pair (out, crlf, "2", value);
+	  put_dxf_pair (out, crlf, "0", "POINT");
+	  put_dxf_pair (out, crlf, "8", "ins");
+	  sprintf (value, "%d", i);
+	  put_dxf_pair (out, crlf, "10", value);
+	  put_dxf_pair (out, crlf, "20", "0");
+	  put_dxf_pair (out, crlf, "0", "ENDBLK");
+      }
+/* a duplicate Block name: the first declared one always wins */
+    put_dxf_pair (out, crlf, "0", "BLOCK");
+    put_dxf_pair (out, crlf, "8", "ins");
+    put_dxf_pair (out, crlf, "2", "dup");
+    put_dxf_pair (out, crlf, "0", "POINT");
+    put_dxf_pair (out, crlf, "8", "ins");
+    put_dxf_pair (out, crlf, "10", "1");
+    put_dxf_pair (out, crlf, "20", "1");
+    put_dxf_pair (out, crlf, "0", "ENDBLK");
+    put_dxf_pair (out, crlf, "0", "BLOCK");
+    put_dxf_pair (out, crlf, "8", "ins");
+    put_dxf_pair (out, crlf, "2", "dup");
+    put_dxf_pair (out, crlf, "0", "LINE");
+    put_dxf_pair (out, crlf, "8", "ins");
+    put_dxf_pair (out, crlf, "10", "0");
+    put_dxf_pair (out, crlf, "20", "0");
+    put_dxf_pair (out, crlf, "11", "1");
+    put_dxf_pair (out, crlf, "21", "1");
+    put_dxf_pair (out, crlf, "0", "ENDBLK");
+    put_dxf_pair (out, crlf, "0", "ENDSEC");
+
+    put_dxf_pair (out, crlf, "0", "SECTION");
+    put_dxf_pair (out, crlf, "2", "ENTITIES");
+    for (i = 0; i < 300; i++)
+      {
+	  sprintf (value, "lyr%d", i);
+	  put_dxf_pair (out, crlf, "0", "POINT");
+	  put_dxf_pair (out, crlf, "8", value);
+	  put_dxf_pair (out, crlf, "10", value + 3);
+	  put_dxf_pair (out, crlf, "20", "1");
+	  put_dxf_pair (out, crlf, "0", "TEXT");
+	  put_dxf_pair (out, crlf, "8", value);
+	  put_dxf_pair (out, crlf, "10", value + 3);
+	  put_dxf_pair (out, crlf, "20", "2");
+	  put_dxf_pair (out, crlf, "40", "1");
+	  memset (label, 'a' + (i % 26), 4000);
+	  label[4000] = '\0';
+	  put_dxf_pair (out, crlf, "1", label);
+	  put_dxf_pair (out, crlf, "50", "0");
+      }
+    for (i = 0; i < 300; i++)
+      {
+	  put_dxf_pair (out, crlf, "0", "INSERT");
+	  put_dxf_pair (out, crlf, "8", "ins");
+	  sprintf (value, "blk%d", i);
+	  put_dxf_pair (out, crlf, "2", value);
+	  put_dxf_pair (out, crlf, "10", value + 3);
+	  put_dxf_pair (out, crlf, "20", "3");
+      }
+    put_dxf_pair (out, crlf, "0", "INSERT");
+    put_dxf_pair (out, crlf, "8", "ins");
+    put_dxf_pair (out, crlf, "2", "dup");
+    put_dxf_pair (out, crlf, "10", "0");
+    put_dxf_pair (out, crlf, "20", "4");
+    if (too_long)
+      {
+	  /* a line exceeding the maximum supported length */
+	  memset (value, 'x', 5000);
+	  value[5000] = '\0';
+	  put_dxf_pair (out, crlf, "999", value);
+      }
+    put_dxf_pair (out, crlf, "0", "ENDSEC");
+    put_dxf_pair (out, crlf, "0", "EOF");
+    fclose (out);
+    return 1;
+}
+
+static int
+check_scanner ()
+{
+/* testing LF and CRLF files with lines crossing the read buffer */
+    int ret;
+    sqlite3 *handle;
+    char *err_msg = NULL;
+    int result = 0;
+    int i;
+    const char *paths[] = {
+	"./check_dxf_lf.tmp", "./check_dxf_crlf.tmp",
+	"./check_dxf_long.tmp", "./check_dxf_crlf_long.tmp"
+    };
+    const char *prefixes[] = { "lf_", "crlf_" };
+    char name[64];
+    char **results;
+    int rows;
+    int columns;
+    void *cache = spatialite_alloc_connection ();
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory database: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -1;
+      }
+    spatialite_init_ex (handle, cache, 0);
+    ret =
+	sqlite3_exec (handle, "SELECT InitSpatialMetadata(1)", NULL, NULL,
+		      &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "InitSpatialMetadata() error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -2;
+      }
+    for (i = 0; i < 4; i++)
+      {
+	  if (!write_scanner_dxf (paths[i], i % 2, i >= 2))
+	    {
+		fprintf (stderr, "unable to write \"%s\"\n", paths[i]);
+		result = -3;
+		goto stop;
+	    }
+      }
+
+    for (i = 0; i < 2; i++)
+      {
+	  if (!load_stream_dxf
+	      (cache, handle, paths[i], prefixes[i], GAIA_DXF_IMPORT_MIXED, 0,
+	       0))
+	    {
+		fprintf (stderr, "Unable to load \"%s\"\n", paths[i]);
+		result = -4;
+		goto stop;
+	    }
+	  sprintf (name, "%spoint_layer_2d", prefixes[i]);
+	  if (count_table_rows (handle, name) != 300)
+	    {
+		fprintf (stderr, "Unexpected \"%s\" rows\n", name);
+		result = -5;
+		goto stop;
+	    }
+	  sprintf (name, "%sinspoint_layer_2d", prefixes[i]);
+	  if (count_table_rows (handle, name) != 301)
+	    {
+		fprintf (stderr, "Unexpected \"%s\" rows\n", name);
+		result = -6;
+		goto stop;
+	    }
+	  sprintf (name, "%sinsline_layer_2d", prefixes[i]);
+	  if (count_table_rows (handle, name) != -1)
+	    {
+		fprintf (stderr, "The duplicate Block \"dup\" was misplaced\n");
+		result = -7;
+		goto stop;
+	    }
+      }
+
+/* CR chars must never reach the parsed values */
+    ret =
+	sqlite3_get_table (handle,
+			   "SELECT Count(DISTINCT layer), Min(Length(label)), "
+			   "Max(Length(label)), Sum(InStr(label, X'0D') > 0) "
+			   "FROM crlf_text_layer_2d", &results, &rows,
+			   &columns, NULL);
+    if (ret != SQLITE_OK || rows != 1)
+      {
+	  fprintf (stderr, "crlf_text_layer_2d error: %s\n",
+		   sqlite3_errmsg (handle));
+	  result = -8;
+	  goto stop;
+      }
+    ret = atoi (results[4]) == 300 && atoi (results[5]) == 4000
+	&& atoi (results[6]) == 4000 && atoi (results[7]) == 0;
+    sqlite3_free_table (results);
+    if (!ret)
+      {
+	  fprintf (stderr, "Unexpected Text labels from the CRLF file\n");
+	  result = -9;
+	  goto stop;
+      }
+    if (!same_table_rows
+	(handle, "layer, label, geometry", "lf_text_layer_2d",
+	 "crlf_text_layer_2d")
+	|| !same_table_rows (handle, "layer, geometry", "lf_point_layer_2d",
+			     "crlf_point_layer_2d")
+	|| !same_table_rows (handle, "layer, block_id, x, y",
+			     "lf_inspoint_layer_2d", "crlf_inspoint_layer_2d"))
+      {
+	  result = -10;
+	  goto stop;
+      }
+
+/* lines longer than the supported limit are rejected */
+    for (i = 2; i < 4; i++)
+      {
+	  gaiaDxfParserPtr dxf =
+	      gaiaCreateDxfParser (4326, GAIA_DXF_AUTO_2D_3D, NULL, NULL,
+				   GAIA_DXF_RING_NONE);
+	  ret = gaiaParseDxfFile_r (cache, dxf, paths[i]);
+	  gaiaDestroyDxfParser (dxf);
+	  if (ret)
+	    {
+		fprintf (stderr, "\"%s\" unexpectedly parsed\n", paths[i]);
+		result = -11;
+		goto stop;
+	    }
+      }
+
+  stop:
+    for (i = 0; i < 4; i++)
+	unlink (paths[i]);
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK && result == 0)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  result = -12;
+      }
+    spatialite_cleanup_ex (cache);
+    return result;
+}
+
+#ifndef _WIN32
+static int
+check_dir ()
+{
+/* importing a whole directory by a varying number of worker threads */
+    int ret;
+    sqlite3 *handle;
+    char *err_msg = NULL;
+    int result = 0;
+    int i;
+    int t;
+    int ordered;
+    char prefix[16];
+    char table1[64];
+    char table2[64];
+    const char *dir_path = "./check_dxf_dir.tmp";
+    const char *paths[] = {
+	"./check_dxf_dir.tmp/a.dxf",
+	"./check_dxf_dir.tmp/b.dxf",
+	"./check_dxf_dir.tmp/c.dxf"
+    };
+    const char *threads[] = { "0", "1", "3" };
+    const char *tables[] = {
+	"bulk_line_2d", "ins_insline_2d", "ins_inspoint_2d", "late_point_2d"
+    };
+    const char *columns[] = {
+	"layer, geometry", "layer, x, y", "layer, x, y", "layer, geometry"
+    };
+    void *cache = spatialite_alloc_connection ();
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory database: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -1;
+      }
+    spatialite_init_ex (handle, cache, 0);
+    ret =
+	sqlite3_exec (handle, "SELECT InitSpatialMetadata(1)", NULL, NULL,
+		      &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "InitSpatialMetadata() error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -2;
+      }
+    mkdir (dir_path, 0755);
+    if (!write_stream_dxf (paths[0], 1) || !write_stream_dxf (paths[1], 0)
+	|| !write_stream_dxf (paths[2], 1))
+      {
+	  fprintf (stderr, "unable to write the DXF directory\n");
+	  result = -3;
+	  goto stop;
+      }
+
+/* the first serial and ordered import is the reference */
+    for (t = 0; t < 3; t++)
+      {
+	  setenv ("SPATIALITE_DXF_THREADS", threads[t], 1);
+	  for (ordered = 1; ordered >= 0; ordered--)
+	    {
+		sprintf (prefix, "t%s_%d_", threads[t], ordered);
+		ret =
+		    gaiaLoadFromDxfDir_r (cache, handle, dir_path, 4326,
+					  GAIA_DXF_AUTO_2D_3D, prefix, NULL,
+					  GAIA_DXF_RING_NONE,
+					  GAIA_DXF_IMPORT_BY_LAYER, 1,
+					  ordered);
+		if (ret != 3)
+		  {
+		      fprintf (stderr,
+			       "Unexpected %d DXF files loaded by %s threads\n",
+			       ret, threads[t]);
+		      result = -4;
+		      goto stop;
+		  }
+		/* all files are appended into the same tables */
+		sprintf (table1, "%sbulk_line_2d", prefix);
+		sprintf (table2, "%slate_point_2d", prefix);
+		if (count_table_rows (handle, table1) != 200
+		    || count_table_rows (handle, table2) != 30)
+		  {
+		      fprintf (stderr,
+			       "Unexpected rows loaded by %s threads\n",
+			       threads[t]);
+		      result = -5;
+		      goto stop;
+		  }
+		for (i = 0; i < 4; i++)
+		  {
+		      sprintf (table1, "t0_1_%s", tables[i]);
+		      sprintf (table2, "%s%s", prefix, tables[i]);
+		      if (!same_table_rows
+			  (handle, columns[i], table1, table2))
+			{
+			    result = -6;
+			    goto stop;
+			}
+		  }
+	    }
+      }
+
+  stop:
+    unsetenv ("SPATIALITE_DXF_THREADS");
+    for (i = 0; i < 3; i++)
+	unlink (paths[i]);
+    rmdir (dir_path);
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK && result == 0)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  result = -7;
+      }
+    spatialite_cleanup_ex (cache);
+    return result;
+}
+#endif
+
 #endif /* GEOS enabled */
 
 int
@@ -1442,6 +2104,17 @@ main (int argc, char *argv[])
 	      return -12;
       }
 
+    if (check_stream () != 0)
+	return -13;
+
+    if (check_scanner () != 0)
+	return -14;
+
+#ifndef _WIN32
+    if (check_dir () != 0)
+	return -15;
+#endif
+
 #endif /* GEOS enabled */
 
     spatialite_shutdown ();
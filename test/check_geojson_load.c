@@ -0,0 +1,381 @@
+/*
+
+ check_geojson_load.c -- SpatiaLite Test Case
+
+ Author: Sandro Furieri <a.furieri@lqt.it>
+
+ ------------------------------------------------------------------------------
+ 
+ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ 
+ The contents of this file are subject to the Mozilla Public License Version
+ 1.1 (the "License"); you may not use this file except in compliance with
+ the License. You may obtain a copy of the License at
+ http://www.mozilla.org/MPL/
+ 
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the
+License.
+
+The Original Code is the SpatiaLite library
+
+The Initial Developer of the Original Code is Alessandro Furieri
+ 
+Portions created by the Initial Developer are Copyright (C) 2013
+the Initial Developer. All Rights Reserved.
+
+Contributor(s):
+
+Alternatively, the contents of this file may be used under the terms of
+either the GNU General Public License Version 2 or later (the "GPL"), or
+the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+in which case the provisions of the GPL or the LGPL are applicable instead
+of those above. If you wish to allow use of your version of this file only
+under the terms of either the GPL or the LGPL, and not to allow others to
+use your version of this file under the terms of the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice
+and other provisions required by the GPL or the LGPL. If you do not delete
+the provisions above, a recipient may use your version of this file under
+the terms of any one of the MPL, the GPL or the LGPL.
+ 
+*/
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+
+#include "sqlite3.h"
+#include "spatialite.h"
+
+#define SAMPLE	4096		/* the Features sampled by load_geojson() */
+
+static const char *json_path = "./check_geojson_load.tmp";
+
+static int
+query_int (sqlite3 * handle, const char *sql)
+{
+/* returning the integer result of some query, -9999 on failure */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    int value = -9999;
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "\"%s\" error: %s\n", sql, sqlite3_errmsg (handle));
+	  return value;
+      }
+    if (rows == 1 && results[1] != NULL)
+	value = atoi (results[1]);
+    sqlite3_free_table (results);
+    return value;
+}
+
+static int
+check_query (sqlite3 * handle, const char *sql, int expected)
+{
+/* checking the integer result of some query */
+    int value = query_int (handle, sql);
+    if (value == expected)
+	return 1;
+    fprintf (stderr, "\"%s\": got %d, expected %d\n", sql, value, expected);
+    return 0;
+}
+
+static int
+load (sqlite3 * handle, const char *table, int srid, int expected_rows)
+{
+/* loading the temporary GeoJSON file */
+    int ret;
+    int rows = -1;
+    char err_msg[1024];
+    *err_msg = '\0';
+    ret =
+	load_geojson (handle, (char *) json_path, (char *) table, "geom", srid,
+		      1, 0, &rows, err_msg);
+    if (expected_rows < 0)
+      {
+	  /* a failure is expected */
+	  if (ret)
+	    {
+		fprintf (stderr, "%s: unexpected success\n", table);
+		return 0;
+	    }
+	  return 1;
+      }
+    if (!ret || rows != expected_rows)
+      {
+	  fprintf (stderr, "%s: load_geojson() error (%d rows): %s\n", table,
+		   rows, err_msg);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+write_points (int ndjson, const char *late_geometry,
+	      const char *late_properties)
+{
+/*
+/ writing SAMPLE + 4 Point Features followed by a late Feature whose
+/ Geometry and/or properties were never seen while sampling
+*/
+    int i;
+    FILE *out = fopen (json_path, "wb");
+    if (out == NULL)
+	return 0;
+    if (!ndjson)
+	fprintf (out, "{\"type\":\"FeatureCollection\",\"features\":[\n");
+    for (i = 0; i < SAMPLE + 4; i++)
+      {
+	  fprintf (out,
+		   "{\"type\":\"Feature\",\"properties\":{\"n\":%d,\"name\":\"p%d\"},"
+		   "\"geometry\":{\"type\":\"Point\",\"coordinates\":[%d,%d]}}%s\n",
+		   i, i, i % 360 - 180, i % 180 - 90, ndjson ? "" : ",");
+      }
+    fprintf (out, "{\"type\":\"Feature\",\"properties\":{\"n\":%d%s},"
+	     "\"geometry\":%s}\n", i, late_properties, late_geometry);
+    if (!ndjson)
+	fprintf (out, "]}\n");
+    fclose (out);
+    return 1;
+}
+
+static int
+write_text (const char *text)
+{
+/* writing a small GeoJSON file */
+    FILE *out = fopen (json_path, "wb");
+    if (out == NULL)
+	return 0;
+    fputs (text, out);
+    fclose (out);
+    return 1;
+}
+
+static int
+check_promotions (sqlite3 * handle)
+{
+/* the Geometry column widened after the sampled Features */
+    if (!write_points
+	(0, "{\"type\":\"MultiPoint\",\"coordinates\":[[1,2],[3,4]]}", ""))
+	return -10;
+    if (!load (handle, "promo_multi", -1, SAMPLE + 5))
+	return -11;
+    if (!check_query
+	(handle,
+	 "SELECT geometry_type FROM geometry_columns "
+	 "WHERE f_table_name = 'promo_multi'", 4))
+	return -12;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM promo_multi "
+	 "WHERE GeometryType(geom) = 'MULTIPOINT'", SAMPLE + 5))
+	return -13;
+    if (!check_query
+	(handle,
+	 "SELECT ST_NumGeometries(geom) FROM promo_multi WHERE n = 4100", 2))
+	return -14;
+
+    if (!write_points
+	(0, "{\"type\":\"Point\",\"coordinates\":[1,2,3]}", ""))
+	return -15;
+    if (!load (handle, "promo_xyz", -1, SAMPLE + 5))
+	return -16;
+    if (!check_query
+	(handle,
+	 "SELECT geometry_type FROM geometry_columns "
+	 "WHERE f_table_name = 'promo_xyz'", 1001))
+	return -17;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM promo_xyz "
+	 "WHERE CoordDimension(geom) = 'XYZ'", SAMPLE + 5))
+	return -18;
+    if (!check_query (handle, "SELECT ST_Z(geom) FROM promo_xyz WHERE n = 4100", 3))
+	return -19;
+
+    if (!write_points
+	(0, "{\"type\":\"LineString\",\"coordinates\":[[1,2],[3,4]]}", ""))
+	return -20;
+    if (!load (handle, "promo_mixed", -1, SAMPLE + 5))
+	return -21;
+    if (!check_query
+	(handle,
+	 "SELECT geometry_type FROM geometry_columns "
+	 "WHERE f_table_name = 'promo_mixed'", 0))
+	return -22;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM promo_mixed WHERE n = 4100 AND "
+	 "GeometryType(geom) = 'LINESTRING'", 1))
+	return -23;
+    return 0;
+}
+
+static int
+check_late_property (sqlite3 * handle)
+{
+/* a property first seen after the sampled Features (NDJSON input) */
+    if (!write_points
+	(1, "{\"type\":\"Point\",\"coordinates\":[1,2]}", ",\"late\":\"x\""))
+	return -30;
+    if (!load (handle, "late_prop", -1, SAMPLE + 5))
+	return -31;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM pragma_table_info('late_prop') "
+	 "WHERE name = 'late'", 1))
+	return -32;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM late_prop WHERE late IS NOT NULL", 1))
+	return -33;
+    if (!check_query
+	(handle, "SELECT n FROM late_prop WHERE late = 'x'", SAMPLE + 4))
+	return -34;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM late_prop WHERE name = 'p' || n", SAMPLE + 4))
+	return -35;
+    return 0;
+}
+
+static int
+check_inputs (sqlite3 * handle)
+{
+/* GeometryCollections, CRS, invalid Geometries and syntax errors */
+    if (!write_text
+	("{\"type\":\"Feature\",\"properties\":{\"k\":1},\"geometry\":"
+	 "{\"type\":\"GeometryCollection\",\"geometries\":["
+	 "{\"type\":\"Point\",\"coordinates\":[1,2]},"
+	 "{\"type\":\"LineString\",\"coordinates\":[[1,2],[3,4]]}]}}\n"))
+	return -40;
+    if (!load (handle, "gcoll", -1, 1))
+	return -41;
+    if (!check_query
+	(handle,
+	 "SELECT geometry_type FROM geometry_columns "
+	 "WHERE f_table_name = 'gcoll'", 7))
+	return -42;
+    if (!check_query
+	(handle,
+	 "SELECT ST_NumGeometries(geom) FROM gcoll WHERE "
+	 "GeometryType(geom) = 'GEOMETRYCOLLECTION'", 2))
+	return -43;
+
+    if (!write_text
+	("{\"type\":\"FeatureCollection\",\"crs\":{\"type\":\"name\","
+	 "\"properties\":{\"name\":\"urn:ogc:def:crs:EPSG::32632\"}},"
+	 "\"features\":[{\"type\":\"Feature\",\"properties\":{},"
+	 "\"geometry\":{\"type\":\"Point\",\"coordinates\":[500000,4000000]}}]}"))
+	return -44;
+    if (!load (handle, "crs_srid", -1, 1))
+	return -45;
+    if (!check_query
+	(handle,
+	 "SELECT srid FROM geometry_columns WHERE f_table_name = 'crs_srid'",
+	 32632))
+	return -46;
+    if (!check_query
+	(handle, "SELECT Count(*) FROM crs_srid WHERE ST_Srid(geom) = 32632",
+	 1))
+	return -47;
+
+    if (!write_text
+	("{\"type\":\"FeatureCollection\",\"features\":["
+	 "{\"type\":\"Feature\",\"properties\":{\"k\":1},\"geometry\":"
+	 "{\"type\":\"Polygon\",\"coordinates\":[[[0,0],[1,0],[1,1],[0,0]]]}},"
+	 "{\"type\":\"Feature\",\"properties\":{\"k\":2},\"geometry\":"
+	 "{\"type\":\"Polygon\",\"coordinates\":[[[0,0],[1,0],[0,0]]]}}]}"))
+	return -48;
+    if (!load (handle, "invalid_geom", -1, 2))
+	return -49;
+    if (!check_query
+	(handle, "SELECT k FROM invalid_geom WHERE geom IS NULL", 2))
+	return -50;
+
+    if (!write_text
+	("{\"type\":\"FeatureCollection\",\"features\":["
+	 "{\"type\":\"Feature\",\"properties\":{\"k\":1},\"geometry\":"
+	 "{\"type\":\"Point\",\"coordinates\":[1,2]}},"
+	 "{\"type\":\"Feature\",\"properties\":{\"k\":2},\"geometry\":"
+	 "{\"type\":\"Point\",\"coordinates\":[1,2}}]}"))
+	return -51;
+    if (!load (handle, "syntax_error", -1, -1))
+	return -52;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM sqlite_master WHERE name = 'syntax_error'", 0))
+	return -53;
+    if (!check_query
+	(handle,
+	 "SELECT Count(*) FROM geometry_columns "
+	 "WHERE f_table_name = 'syntax_error'", 0))
+	return -54;
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    int ret;
+    sqlite3 *handle;
+    char *err_msg = NULL;
+    void *cache = spatialite_alloc_connection ();
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory database: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -1;
+      }
+
+    spatialite_init_ex (handle, cache, 0);
+
+    ret =
+	sqlite3_exec (handle, "SELECT InitSpatialMetadata(1)", NULL, NULL,
+		      &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "InitSpatialMetadata() error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -2;
+      }
+
+    ret = check_promotions (handle);
+    if (ret == 0)
+	ret = check_late_property (handle);
+    if (ret == 0)
+	ret = check_inputs (handle);
+    unlink (json_path);
+    if (ret != 0)
+      {
+	  sqlite3_close (handle);
+	  return ret;
+      }
+
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  return -3;
+      }
+
+    spatialite_cleanup_ex (cache);
+    spatialite_shutdown ();
+    return 0;
+}
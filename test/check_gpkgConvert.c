@@ -158,6 +158,140 @@ already_existing (const char *path)
     return 1;
 }
 
+static int
+do_check_count (sqlite3 * handle, const char *sql, int expected)
+{
+/* checking a single Count(*) result */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    int count = -1;
+
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n%s\n", sqlite3_errmsg (handle), sql);
+	  return 0;
+      }
+    if (rows == 1 && results[1] != NULL)
+	count = atoi (results[1]);
+    sqlite3_free_table (results);
+    if (count != expected)
+      {
+	  fprintf (stderr, "Unexpected result %d (expected %d)\n%s\n", count,
+		   expected, sql);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+do_check_converted (const char *path, const char *path_origin, int to_gpkg)
+{
+/* checking every converted Geometry against the generic SQL functions */
+    sqlite3 *handle;
+    void *cache = spatialite_alloc_connection ();
+    int ret;
+    int i;
+    char **results;
+    int rows;
+    int columns;
+    char *sql;
+    int ok = 1;
+
+    handle = connect_db (path, SQLITE_OPEN_READONLY, cache);
+    if (handle == NULL)
+      {
+	  spatialite_cleanup_ex (cache);
+	  return 0;
+      }
+    sql = sqlite3_mprintf ("ATTACH DATABASE %Q AS src", path_origin);
+    ret = sqlite3_exec (handle, sql, NULL, NULL, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "ATTACH error: %s\n", sqlite3_errmsg (handle));
+	  ok = 0;
+	  goto stop;
+      }
+    if (to_gpkg)
+	sql = "SELECT f_table_name, f_geometry_column, spatial_index_enabled "
+	    "FROM src.geometry_columns";
+    else
+	sql = "SELECT f_table_name, f_geometry_column, spatial_index_enabled "
+	    "FROM main.geometry_columns";
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "geometry_columns error: %s\n",
+		   sqlite3_errmsg (handle));
+	  ok = 0;
+	  goto stop;
+      }
+    if (rows < 1)
+      {
+	  fprintf (stderr, "No Geometry has been converted\n");
+	  sqlite3_free_table (results);
+	  ok = 0;
+	  goto stop;
+      }
+    for (i = 1; i <= rows && ok; i++)
+      {
+	  const char *table = results[(i * columns) + 0];
+	  const char *column = results[(i * columns) + 1];
+	  int spatial_index = atoi (results[(i * columns) + 2]);
+	  int count;
+	  char **results2;
+	  int rows2;
+	  int columns2;
+
+	  /* the fast transcoder must match AsGPB() and GeomFromGPB() */
+	  sql =
+	      sqlite3_mprintf ("SELECT Count(*) FROM \"%w\" AS a "
+			       "JOIN src.\"%w\" AS b ON (a.ROWID = b.ROWID) "
+			       "WHERE a.\"%w\" IS NOT %s(b.\"%w\")", table,
+			       table, column,
+			       to_gpkg ? "AsGPB" : "GeomFromGPB", column);
+	  ok = do_check_count (handle, sql, 0);
+	  sqlite3_free (sql);
+	  if (!ok || !spatial_index)
+	      continue;
+
+	  /* the Spatial Index must cover every Geometry */
+	  sql =
+	      sqlite3_mprintf ("SELECT Count(*) FROM \"%w\" WHERE \"%w\" "
+			       "IS NOT NULL", table, column);
+	  ret =
+	      sqlite3_get_table (handle, sql, &results2, &rows2, &columns2,
+				 NULL);
+	  sqlite3_free (sql);
+	  if (ret != SQLITE_OK || rows2 != 1)
+	    {
+		ok = 0;
+		continue;
+	    }
+	  count = atoi (results2[1]);
+	  sqlite3_free_table (results2);
+	  if (to_gpkg)
+	      sql =
+		  sqlite3_mprintf ("SELECT Count(*) FROM \"rtree_%w_%w\"",
+				   table, column);
+	  else
+	      sql =
+		  sqlite3_mprintf ("SELECT Count(*) FROM \"idx_%w_%w\"", table,
+				   column);
+	  ok = do_check_count (handle, sql, count);
+	  sqlite3_free (sql);
+      }
+    sqlite3_free_table (results);
+
+  stop:
+    sqlite3_close (handle);
+    spatialite_cleanup_ex (cache);
+    return ok;
+}
+
 static int
 open_connections (const char *path_origin, const char *path_destination,
 		  void *cache_in, void *cache_out, sqlite3 ** xhandle_in,
@@ -240,6 +374,11 @@ main (int argc, char *argv[])
     sqlite3_close (handle_out);
     spatialite_cleanup_ex (cache_in);
     spatialite_cleanup_ex (cache_out);
+    if (!do_check_converted (path_destination, path_origin, 1))
+      {
+	  do_unlink_all ();
+	  return -1;
+      }
 
 /* converting from GPKG to SpatiaLite */
     path_origin = "./out1.gpkg";
@@ -263,6 +402,11 @@ main (int argc, char *argv[])
     sqlite3_close (handle_out);
     spatialite_cleanup_ex (cache_in);
     spatialite_cleanup_ex (cache_out);
+    if (!do_check_converted (path_destination, path_origin, 0))
+      {
+	  do_unlink_all ();
+	  return -1;
+      }
 
 /* converting from SpatiaLite v3 to GPKG */
     ret =
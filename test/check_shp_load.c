@@ -45,11 +45,13 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "config.h"
 
 #include "sqlite3.h"
 #include "spatialite.h"
+#include "spatialite/gaiageo.h"
 
 static int
 do_test (sqlite3 * handle, const void *p_cache)
@@ -148,6 +150,247 @@ do_test (sqlite3 * handle, const void *p_cache)
     return 0;
 }
 
+#ifndef OMIT_ICONV		/* only if ICONV is supported */
+static int
+do_check_same_rows (sqlite3 * handle, const char *table1, const char *table2)
+{
+/* checking that both tables contain exactly the same rows */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    int mismatching;
+    char *sql =
+	sqlite3_mprintf ("SELECT (SELECT Count(*) FROM \"%w\") - "
+			 "(SELECT Count(*) FROM \"%w\"), "
+			 "(SELECT Count(*) FROM (SELECT * FROM \"%w\" "
+			 "EXCEPT SELECT * FROM \"%w\"))",
+			 table1, table2, table1, table2);
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK || rows != 1)
+      {
+	  fprintf (stderr, "compare \"%s\" error: %s\n", table1,
+		   sqlite3_errmsg (handle));
+	  return 0;
+      }
+    mismatching = atoi (results[2]) != 0 || atoi (results[3]) != 0;
+    sqlite3_free_table (results);
+    if (mismatching)
+      {
+	  fprintf (stderr, "\"%s\" and \"%s\" differ\n", table1, table2);
+	  return 0;
+      }
+    return 1;
+}
+
+#ifdef __linux__
+static int
+is_mapped (const char *name)
+{
+/* checking if some file is currently mapped by this process */
+    char line[4096];
+    int found = 0;
+    FILE *in = fopen ("/proc/self/maps", "r");
+    if (in == NULL)
+	return -1;
+    while (fgets (line, sizeof (line), in) != NULL)
+      {
+	  if (strstr (line, name) != NULL)
+	      found = 1;
+      }
+    fclose (in);
+    return found;
+}
+
+static int
+do_check_mmap_switch ()
+{
+/* the mapping is used by default, and is disabled by SPATIALITE_SHP_MMAP */
+    int ret;
+    gaiaShapefilePtr shp = gaiaAllocShapefile ();
+    gaiaOpenShpRead (shp, "./shp/gaza/route", "UTF-8", "UTF-8");
+    ret = shp->Valid && is_mapped ("/gaza/route.shp") != 0;
+    gaiaFreeShapefile (shp);
+    if (!ret)
+      {
+	  fprintf (stderr, "the Shapefile has not been memory mapped\n");
+	  return -11;
+      }
+    setenv ("SPATIALITE_SHP_MMAP", "0", 1);
+    shp = gaiaAllocShapefile ();
+    gaiaOpenShpRead (shp, "./shp/gaza/route", "UTF-8", "UTF-8");
+    ret = shp->Valid && is_mapped ("/gaza/route.shp") == 0;
+    gaiaFreeShapefile (shp);
+    unsetenv ("SPATIALITE_SHP_MMAP");
+    if (!ret)
+      {
+	  fprintf (stderr, "SPATIALITE_SHP_MMAP=0 has been ignored\n");
+	  return -12;
+      }
+    return 0;
+}
+#endif
+
+static int
+copy_file (const char *from, const char *to)
+{
+/* copying a whole file */
+    char buf[8192];
+    size_t rd;
+    int ok = 1;
+    FILE *in;
+    FILE *out;
+    in = fopen (from, "rb");
+    if (in == NULL)
+	return 0;
+    out = fopen (to, "wb");
+    if (out == NULL)
+      {
+	  fclose (in);
+	  return 0;
+      }
+    while ((rd = fread (buf, 1, sizeof (buf), in)) > 0)
+      {
+	  if (fwrite (buf, 1, rd, out) != rd)
+	      ok = 0;
+      }
+    fclose (in);
+    if (fclose (out) != 0)
+	ok = 0;
+    return ok;
+}
+
+static int
+do_check_corrupted (int offset, int value)
+{
+/*
+/ the first record of a copy of route.shp (a 6 parts / 295 points
+/ Polyline) gets a corrupted count or part offset: reading it must
+/ fail cleanly on both read paths, the second record still being valid
+*/
+    int ret;
+    int pass;
+    unsigned char bytes[4];
+    FILE *out;
+    gaiaShapefilePtr shp;
+    if (!copy_file ("./shp/gaza/route.shx", "./corrupted_route.shx")
+	|| !copy_file ("./shp/gaza/route.shp", "./corrupted_route.shp")
+	|| !copy_file ("./shp/gaza/route.dbf", "./corrupted_route.dbf"))
+      {
+	  fprintf (stderr, "unable to copy the route Shapefile\n");
+	  return 0;
+      }
+    out = fopen ("./corrupted_route.shp", "r+b");
+    if (out == NULL)
+	return 0;
+    gaiaExport32 (bytes, value, GAIA_LITTLE_ENDIAN, gaiaEndianArch ());
+    fseek (out, offset, SEEK_SET);
+    fwrite (bytes, 1, 4, out);
+    fclose (out);
+    for (pass = 0; pass < 2; pass++)
+      {
+#ifndef _WIN32
+	  if (pass)
+	      setenv ("SPATIALITE_SHP_MMAP", "0", 1);
+#endif
+	  shp = gaiaAllocShapefile ();
+	  gaiaOpenShpRead (shp, "./corrupted_route", "UTF-8", "UTF-8");
+	  ret = shp->Valid;
+	  if (ret)
+	      ret = gaiaReadShpEntity (shp, 0, 4326) == 0
+		  && shp->LastError != NULL;
+	  if (ret)
+	      ret = gaiaReadShpEntity (shp, 1, 4326) == 1;
+	  gaiaFreeShapefile (shp);
+#ifndef _WIN32
+	  unsetenv ("SPATIALITE_SHP_MMAP");
+#endif
+	  if (!ret)
+	    {
+		fprintf (stderr,
+			 "corrupted record @%d=%d (%s) unexpected result\n",
+			 offset, value, pass ? "stdio" : "mmap");
+		break;
+	    }
+      }
+    unlink ("./corrupted_route.shx");
+    unlink ("./corrupted_route.shp");
+    unlink ("./corrupted_route.dbf");
+    return ret;
+}
+
+static int
+do_test_read_paths (sqlite3 * handle)
+{
+/* reading the same Shapefiles through the memory map and through stdio */
+    int ret;
+    int i;
+    int row_count;
+    char table1[64];
+    char table2[64];
+    const char *paths[] = {
+	"./shapetest1", "./shp/gaza/route", "./shp/gaza/barrier",
+	"./shp/taiwan/leisure", "./shp/foggia/local_councils",
+	"./shp/merano-3d/points", "./shp/merano-3d/roads",
+	"./shp/merano-3d/polygons", NULL
+    };
+    const char *charsets[] = {
+	"UTF-8", "UTF-8", "UTF-8", "UTF-8", "CP1252", "CP1252", "CP1252",
+	"CP1252"
+    };
+
+#ifdef __linux__
+    ret = do_check_mmap_switch ();
+    if (ret != 0)
+	return ret;
+#endif
+
+/* parts count, points count, parts index */
+    if (!do_check_corrupted (144, 0x7fffffff)
+	|| !do_check_corrupted (144, -1)
+	|| !do_check_corrupted (148, 0x10000000)
+	|| !do_check_corrupted (148, -5)
+	|| !do_check_corrupted (160, 1000) || !do_check_corrupted (164, 1))
+	return -17;
+
+    for (i = 0; paths[i] != NULL; i++)
+      {
+	  sprintf (table1, "mmap_%d", i);
+	  sprintf (table2, "stdio_%d", i);
+	  ret = load_shapefile (handle, (char *) (paths[i]), table1,
+				(char *) (charsets[i]), 4326, "geom", 0, 0, 0,
+				0, &row_count, NULL);
+	  if (!ret || row_count <= 0)
+	    {
+		fprintf (stderr, "load_shapefile() \"%s\" error\n",
+			 paths[i]);
+		return -13;
+	    }
+#ifndef _WIN32
+	  setenv ("SPATIALITE_SHP_MMAP", "0", 1);
+#endif
+	  ret = load_shapefile (handle, (char *) (paths[i]), table2,
+				(char *) (charsets[i]), 4326, "geom", 0, 0, 0,
+				0, &row_count, NULL);
+#ifndef _WIN32
+	  unsetenv ("SPATIALITE_SHP_MMAP");
+#endif
+	  if (!ret || row_count <= 0)
+	    {
+		fprintf (stderr, "load_shapefile() \"%s\" (stdio) error\n",
+			 paths[i]);
+		return -14;
+	    }
+	  if (!do_check_same_rows (handle, table1, table2))
+	      return -15;
+	  if (!do_check_same_rows (handle, table2, table1))
+	      return -16;
+      }
+    return 0;
+}
+#endif /* end ICONV conditional */
+
 int
 main (int argc, char *argv[])
 {
@@ -176,6 +419,10 @@ main (int argc, char *argv[])
     if (ret != 0)
 	return ret;
 
+    ret = do_test_read_paths (handle);
+    if (ret != 0)
+	return ret;
+
     ret = sqlite3_close (handle);
     if (ret != SQLITE_OK)
       {
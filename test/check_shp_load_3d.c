@@ -41,6 +41,7 @@ the provisions above, a recipient may use your version of this file under
 the terms of any one of the MPL, the GPL or the LGPL.
  
 */
+#include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -51,6 +52,146 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include "sqlite3.h"
 #include "spatialite.h"
 
+static int
+same_dbf (const char *path1, const char *path2)
+{
+/* checking if two DBF files are byte-identical */
+    FILE *f1;
+    FILE *f2;
+    int c1;
+    int c2;
+    int same = 1;
+    f1 = fopen (path1, "rb");
+    f2 = fopen (path2, "rb");
+    if (f1 == NULL || f2 == NULL)
+	same = 0;
+    while (same)
+      {
+	  c1 = fgetc (f1);
+	  c2 = fgetc (f2);
+	  if (c1 != c2)
+	      same = 0;
+	  if (c1 == EOF)
+	      break;
+      }
+    if (f1 != NULL)
+	fclose (f1);
+    if (f2 != NULL)
+	fclose (f2);
+    return same;
+}
+
+static void
+remove_shapefile (const char *path)
+{
+/* removing an exported Shapefile */
+    char name[1024];
+    sprintf (name, "%s.shp", path);
+    unlink (name);
+    sprintf (name, "%s.shx", path);
+    unlink (name);
+    sprintf (name, "%s.dbf", path);
+    unlink (name);
+    sprintf (name, "%s.prj", path);
+    unlink (name);
+}
+
+static int
+check_multi_promotion (sqlite3 * handle, const char *type, int gtype,
+		       const char *wkt_single, const char *wkt_multi,
+		       const char *threads)
+{
+/*
+/ exporting 5000 single-part rows and a late multi-part one: the loaded
+/ Geometry column must be promoted to MULTI keeping every row unchanged
+*/
+    int ret;
+    char *err_msg = NULL;
+    char *sql;
+    char **results;
+    int rows;
+    int columns;
+    int row_count;
+    int ok;
+
+    sql = sqlite3_mprintf ("CREATE TABLE promo_src (id INTEGER PRIMARY KEY);"
+			   "SELECT AddGeometryColumn('promo_src', 'geom', "
+			   "4326, %Q, 'XY');"
+			   "WITH RECURSIVE s(i) AS (SELECT 1 UNION ALL "
+			   "SELECT i + 1 FROM s WHERE i < 5000) "
+			   "INSERT INTO promo_src (id, geom) SELECT i, "
+			   "GeomFromText(printf(CASE WHEN i = 4500 THEN %Q "
+			   "ELSE %Q END, i, i, i, i, i, i, i, i), 4326) FROM s",
+			   type, wkt_multi, wkt_single);
+    ret = sqlite3_exec (handle, sql, NULL, NULL, &err_msg);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "CREATE promo_src error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -71;
+      }
+    ret =
+	dump_shapefile (handle, "promo_src", "geom", "./shp_promo", "UTF-8",
+			NULL, 0, &row_count, NULL);
+    if (!ret || row_count != 5000)
+      {
+	  fprintf (stderr, "dump_shapefile() error (%s)\n", type);
+	  return -72;
+      }
+#ifndef _WIN32
+    setenv ("SPATIALITE_SHP_THREADS", threads, 1);
+#endif
+    ret =
+	load_shapefile (handle, "./shp_promo", "promo_back", "UTF-8", 4326,
+			"geom", 0, 0, 0, 0, &row_count, NULL);
+#ifndef _WIN32
+    unsetenv ("SPATIALITE_SHP_THREADS");
+#endif
+    remove_shapefile ("./shp_promo");
+    if (!ret || row_count != 5000)
+      {
+	  fprintf (stderr, "load_shapefile() error (%s)\n", type);
+	  return -73;
+      }
+
+    sql = "SELECT geometry_type, "
+	"(SELECT Count(*) FROM promo_back AS b "
+	"JOIN promo_src AS s ON (s.id = b.PK_UID) "
+	"WHERE AsBinary(b.geom) = AsBinary(s.geom)) "
+	"FROM geometry_columns WHERE f_table_name = 'promo_back'";
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -74;
+      }
+    ok = rows == 1 && atoi (results[columns + 0]) == gtype
+	&& atoi (results[columns + 1]) == 5000;
+    if (!ok)
+	fprintf (stderr,
+		 "Unexpected error: %s not promoted to MULTI (threads=%s): "
+		 "%s %s\n", type, threads,
+		 (rows == 1) ? results[columns + 0] : "?",
+		 (rows == 1) ? results[columns + 1] : "?");
+    sqlite3_free_table (results);
+    if (!ok)
+	return -75;
+
+    ret =
+	sqlite3_exec (handle,
+		      "SELECT DropGeoTable('promo_back');"
+		      "SELECT DropGeoTable('promo_src')", NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "DropGeoTable error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -76;
+      }
+    return 0;
+}
+
 static int
 do_test (sqlite3 * handle, const void *p_cache)
 {
@@ -93,6 +234,97 @@ do_test (sqlite3 * handle, const void *p_cache)
 	  return -8;
       }
 
+/* the Geometry type is lazily promoted to XYZM while loading */
+    sql = "SELECT geometry_type, coord_dimension, "
+	"(SELECT Count(*) FROM polygons WHERE CoordDimension(geom) <> 'XYZM') "
+	"FROM geometry_columns WHERE f_table_name = 'polygons'";
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -64;
+      }
+    if (rows != 1)
+      {
+	  fprintf (stderr, "Unexpected num of rows for GEOMETRY_COLUMNS.\n");
+	  return -65;
+      }
+    if (atoi (results[columns + 0]) != 3003
+	|| atoi (results[columns + 1]) != 4
+	|| atoi (results[columns + 2]) != 0)
+      {
+	  fprintf (stderr,
+		   "Unexpected error: polygons not promoted to XYZM: %s %s %s\n",
+		   results[columns + 0], results[columns + 1],
+		   results[columns + 2]);
+	  return -66;
+      }
+    sqlite3_free_table (results);
+
+/* exporting with verified statistics, then again with stale ones */
+    ret =
+	dump_shapefile (handle, "polygons", "geom", "./shp_3d_fresh", "CP1252",
+			NULL, 0, &row_count, NULL);
+    if (!ret || row_count != 10)
+      {
+	  fprintf (stderr, "dump_shapefile() error (fresh)\n");
+	  sqlite3_close (handle);
+	  return -67;
+      }
+    ret =
+	sqlite3_exec (handle, "UPDATE polygons SET geom = geom WHERE ROWID = 1",
+		      NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "UPDATE polygons error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -68;
+      }
+    ret =
+	dump_shapefile (handle, "polygons", "geom", "./shp_3d_stale", "CP1252",
+			NULL, 0, &row_count, NULL);
+    if (!ret || row_count != 10)
+      {
+	  fprintf (stderr, "dump_shapefile() error (stale)\n");
+	  sqlite3_close (handle);
+	  return -69;
+      }
+    ret = same_dbf ("./shp_3d_fresh.dbf", "./shp_3d_stale.dbf");
+    remove_shapefile ("./shp_3d_fresh");
+    remove_shapefile ("./shp_3d_stale");
+    if (!ret)
+      {
+	  fprintf (stderr, "Unexpected error: mismatching exported DBF\n");
+	  sqlite3_close (handle);
+	  return -70;
+      }
+
+/* a late multi-part row promotes the Geometry type to MULTI */
+    ret =
+	check_multi_promotion (handle, "MULTILINESTRING", 5,
+			       "MULTILINESTRING((%d 0, %d 1, %d 2, %d 3))",
+			       "MULTILINESTRING((%d 0, %d 1), (%d 2, %d 3))",
+			       "0");
+    if (ret == 0)
+	ret =
+	    check_multi_promotion (handle, "MULTIPOLYGON", 6,
+				   "MULTIPOLYGON(((%d 0, %d 1, %d.5 1, %d 0)))",
+				   "MULTIPOLYGON(((%d 0, %d 1, %d.5 1, %d 0)), "
+				   "((%d 5, %d 6, %d.5 6, %d 5)))", "0");
+    if (ret == 0)
+	ret =
+	    check_multi_promotion (handle, "MULTILINESTRING", 5,
+				   "MULTILINESTRING((%d 0, %d 1, %d 2, %d 3))",
+				   "MULTILINESTRING((%d 0, %d 1), (%d 2, %d 3))",
+				   "3");
+    if (ret != 0)
+      {
+	  sqlite3_close (handle);
+	  return ret;
+      }
+
     ret =
 	load_shapefile (handle, "shp/merano-3d/roads", "roads", "CP1252", 25832,
 			"geom", 0, 0, 1, 0, &row_count, err_msg);
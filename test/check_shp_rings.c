@@ -0,0 +1,324 @@
+/*
+
+ check_shp_rings.c -- SpatiaLite Test Case
+
+ Author: Sandro Furieri <a.furieri@lqt.it>
+
+ ------------------------------------------------------------------------------
+ 
+ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ 
+ The contents of this file are subject to the Mozilla Public License Version
+ 1.1 (the "License"); you may not use this file except in compliance with
+ the License. You may obtain a copy of the License at
+ http://www.mozilla.org/MPL/
+ 
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the
+License.
+
+The Original Code is the SpatiaLite library
+
+The Initial Developer of the Original Code is Alessandro Furieri
+ 
+Portions created by the Initial Developer are Copyright (C) 2011
+the Initial Developer. All Rights Reserved.
+
+Contributor(s):
+Brad Hards <bradh@frogmouth.net>
+
+Alternatively, the contents of this file may be used under the terms of
+either the GNU General Public License Version 2 or later (the "GPL"), or
+the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+in which case the provisions of the GPL or the LGPL are applicable instead
+of those above. If you wish to allow use of your version of this file only
+under the terms of either the GPL or the LGPL, and not to allow others to
+use your version of this file under the terms of the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice
+and other provisions required by the GPL or the LGPL. If you do not delete
+the provisions above, a recipient may use your version of this file under
+the terms of any one of the MPL, the GPL or the LGPL.
+ 
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "config.h"
+
+#include "sqlite3.h"
+#include "spatialite.h"
+#include "spatialite/gaiageo.h"
+
+/*
+/ a benchmark for the Shapefile ring arrangement: both records are
+/ pathological, containing thousands of rings to be assembled into
+/ Polygons by the Shapefile reader
+*/
+
+#define BOUNDARY_VERTICES	20000
+#define LAKES_ROWS		50
+#define LAKES_COLS		60
+#define BUILDINGS_ROWS	50
+#define BUILDINGS_COLS	60
+
+static void
+set_square (gaiaRingPtr ring, double x, double y, double side)
+{
+/* a closed square ring */
+    gaiaSetPoint (ring->Coords, 0, x, y);
+    gaiaSetPoint (ring->Coords, 1, x + side, y);
+    gaiaSetPoint (ring->Coords, 2, x + side, y + side);
+    gaiaSetPoint (ring->Coords, 3, x, y + side);
+    gaiaSetPoint (ring->Coords, 4, x, y);
+}
+
+static gaiaGeomCollPtr
+national_boundary (void)
+{
+/* a huge boundary full of small lakes */
+    gaiaGeomCollPtr geom = gaiaAllocGeomColl ();
+    gaiaPolygonPtr polyg;
+    gaiaRingPtr ring;
+    double angle;
+    int row;
+    int col;
+    int iv;
+    geom->Srid = 4326;
+    geom->DeclaredType = GAIA_MULTIPOLYGON;
+    polyg =
+	gaiaAddPolygonToGeomColl (geom, BOUNDARY_VERTICES + 1,
+				  LAKES_ROWS * LAKES_COLS);
+    ring = polyg->Exterior;
+    for (iv = 0; iv < BOUNDARY_VERTICES; iv++)
+      {
+	  angle = (2.0 * M_PI * iv) / BOUNDARY_VERTICES;
+	  gaiaSetPoint (ring->Coords, iv, 1000.0 * cos (angle),
+			1000.0 * sin (angle));
+      }
+    gaiaSetPoint (ring->Coords, BOUNDARY_VERTICES, 1000.0, 0.0);
+    for (row = 0; row < LAKES_ROWS; row++)
+      {
+	  for (col = 0; col < LAKES_COLS; col++)
+	    {
+		ring =
+		    gaiaAddInteriorRing (polyg, (row * LAKES_COLS) + col, 5);
+		set_square (ring, -600.0 + (col * 20.0),
+			    -500.0 + (row * 20.0), 2.0);
+	    }
+      }
+    return geom;
+}
+
+static gaiaGeomCollPtr
+building_footprints (void)
+{
+/* thousands of buildings, each one having a courtyard */
+    gaiaGeomCollPtr geom = gaiaAllocGeomColl ();
+    gaiaPolygonPtr polyg;
+    gaiaRingPtr ring;
+    int row;
+    int col;
+    geom->Srid = 4326;
+    geom->DeclaredType = GAIA_MULTIPOLYGON;
+    for (row = 0; row < BUILDINGS_ROWS; row++)
+      {
+	  for (col = 0; col < BUILDINGS_COLS; col++)
+	    {
+		polyg = gaiaAddPolygonToGeomColl (geom, 5, 1);
+		set_square (polyg->Exterior, col * 10.0, row * 10.0, 4.0);
+		ring = gaiaAddInteriorRing (polyg, 0, 5);
+		set_square (ring, (col * 10.0) + 1.0, (row * 10.0) + 1.0, 2.0);
+	    }
+      }
+    return geom;
+}
+
+static int
+insert_geometry (sqlite3 * handle, int id, gaiaGeomCollPtr geom)
+{
+/* inserting a row into the test table */
+    sqlite3_stmt *stmt;
+    unsigned char *blob;
+    int blob_size;
+    int ret;
+    ret =
+	sqlite3_prepare_v2 (handle,
+			    "INSERT INTO rings_test (id, geom) VALUES (?, ?)",
+			    -1, &stmt, NULL);
+    if (ret != SQLITE_OK)
+	return 0;
+    gaiaToSpatiaLiteBlobWkb (geom, &blob, &blob_size);
+    gaiaFreeGeomColl (geom);
+    sqlite3_bind_int (stmt, 1, id);
+    sqlite3_bind_blob (stmt, 2, blob, blob_size, free);
+    ret = sqlite3_step (stmt);
+    sqlite3_finalize (stmt);
+    if (ret != SQLITE_DONE)
+	return 0;
+    return 1;
+}
+
+static int
+check_geometry (sqlite3 * handle, int id, int polygons, int interiors)
+{
+/* checking a Geometry after the Shapefile round trip */
+    sqlite3_stmt *stmt;
+    gaiaGeomCollPtr geom = NULL;
+    gaiaPolygonPtr polyg;
+    int n_polygs = 0;
+    int ok = 1;
+    int ret;
+    ret =
+	sqlite3_prepare_v2 (handle,
+			    "SELECT geom FROM rings_back WHERE id = ?", -1,
+			    &stmt, NULL);
+    if (ret != SQLITE_OK)
+	return 0;
+    sqlite3_bind_int (stmt, 1, id);
+    if (sqlite3_step (stmt) == SQLITE_ROW
+	&& sqlite3_column_type (stmt, 0) == SQLITE_BLOB)
+	geom =
+	    gaiaFromSpatiaLiteBlobWkb (sqlite3_column_blob (stmt, 0),
+				       sqlite3_column_bytes (stmt, 0));
+    sqlite3_finalize (stmt);
+    if (geom == NULL)
+	return 0;
+    polyg = geom->FirstPolygon;
+    while (polyg)
+      {
+	  n_polygs++;
+	  if (polyg->NumInteriors != interiors)
+	      ok = 0;
+	  polyg = polyg->Next;
+      }
+    if (n_polygs != polygons)
+	ok = 0;
+    gaiaFreeGeomColl (geom);
+    return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+#ifndef OMIT_ICONV		/* only if ICONV is supported */
+    int ret;
+    sqlite3 *handle;
+    char *err_msg = NULL;
+    char *shpname = __FILE__ "rings";
+    char nam[1024];
+    int row_count;
+    void *cache = spatialite_alloc_connection ();
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory database: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -1;
+      }
+
+    spatialite_init_ex (handle, cache, 0);
+
+    ret =
+	sqlite3_exec (handle, "SELECT InitSpatialMetadata(1)", NULL, NULL,
+		      &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "InitSpatialMetadata() error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -2;
+      }
+
+    ret =
+	sqlite3_exec (handle,
+		      "CREATE TABLE rings_test (id INTEGER PRIMARY KEY)",
+		      NULL, NULL, &err_msg);
+    if (ret == SQLITE_OK)
+	ret =
+	    sqlite3_exec (handle,
+			  "SELECT AddGeometryColumn('rings_test', 'geom', "
+			  "4326, 'MULTIPOLYGON', 'XY')", NULL, NULL,
+			  &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "CREATE TABLE error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -3;
+      }
+
+    if (!insert_geometry (handle, 1, national_boundary ())
+	|| !insert_geometry (handle, 2, building_footprints ()))
+      {
+	  fprintf (stderr, "INSERT error: %s\n", sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -4;
+      }
+
+    ret =
+	dump_shapefile (handle, "rings_test", "geom", shpname, "UTF-8", NULL,
+			0, &row_count, NULL);
+    if (!ret || row_count != 2)
+      {
+	  fprintf (stderr, "dump_shapefile() error\n");
+	  sqlite3_close (handle);
+	  return -5;
+      }
+
+    ret =
+	load_shapefile (handle, shpname, "rings_back", "UTF-8", 4326, "geom",
+			0, 0, 0, 0, &row_count, NULL);
+    if (!ret || row_count != 2)
+      {
+	  fprintf (stderr, "load_shapefile() error\n");
+	  sqlite3_close (handle);
+	  return -6;
+      }
+
+    if (!check_geometry (handle, 1, 1, LAKES_ROWS * LAKES_COLS))
+      {
+	  fprintf (stderr, "unexpected national boundary\n");
+	  sqlite3_close (handle);
+	  return -7;
+      }
+    if (!check_geometry (handle, 2, BUILDINGS_ROWS * BUILDINGS_COLS, 1))
+      {
+	  fprintf (stderr, "unexpected building footprints\n");
+	  sqlite3_close (handle);
+	  return -8;
+      }
+
+    snprintf (nam, 1024, "%s.dbf", shpname);
+    unlink (nam);
+    snprintf (nam, 1024, "%s.prj", shpname);
+    unlink (nam);
+    snprintf (nam, 1024, "%s.shp", shpname);
+    unlink (nam);
+    snprintf (nam, 1024, "%s.shx", shpname);
+    unlink (nam);
+
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  return -9;
+      }
+
+    spatialite_cleanup_ex (cache);
+#endif /* end ICONV conditional */
+
+    spatialite_shutdown ();
+    return 0;
+}
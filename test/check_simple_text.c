@@ -0,0 +1,307 @@
+/*
+
+ check_simple_text.c -- SpatiaLite Test Case
+
+ Author: Sandro Furieri <a.furieri@lqt.it>
+
+ ------------------------------------------------------------------------------
+
+ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+
+ The contents of this file are subject to the Mozilla Public License Version
+ 1.1 (the "License"); you may not use this file except in compliance with
+ the License. You may obtain a copy of the License at
+ http://www.mozilla.org/MPL/
+
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the
+License.
+
+The Original Code is the SpatiaLite library
+
+The Initial Developer of the Original Code is Alessandro Furieri
+
+Portions created by the Initial Developer are Copyright (C) 2011
+the Initial Developer. All Rights Reserved.
+
+Contributor(s):
+Brad Hards <bradh@frogmouth.net>
+
+Alternatively, the contents of this file may be used under the terms of
+either the GNU General Public License Version 2 or later (the "GPL"), or
+the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+in which case the provisions of the GPL or the LGPL are applicable instead
+of those above. If you wish to allow use of your version of this file only
+under the terms of either the GPL or the LGPL, and not to allow others to
+use your version of this file under the terms of the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice
+and other provisions required by the GPL or the LGPL. If you do not delete
+the provisions above, a recipient may use your version of this file under
+the terms of any one of the MPL, the GPL or the LGPL.
+
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+
+#include "sqlite3.h"
+#include "spatialite.h"
+#include "spatialite/gaiageo.h"
+
+/*
+/ the direct Text -> BLOB fast path must either decline (so that the
+/ caller falls back to the full parser) or return exactly the same BLOB
+/ the full parser followed by gaiaToSpatiaLiteBlobWkb() would return
+*/
+
+struct simple_case
+{
+    const char *text;
+    short type;
+    int fast;
+};
+
+static struct simple_case wkt_cases[] = {
+    {"POINT(1 2)", -1, 1},
+    {"  point ( -1.5   +2. )  ", -1, 1},
+    {"POINT Z(1 2 3)", -1, 1},
+    {"POINTZ(1 2 3)", GAIA_POINTZ, 1},
+    {"POINT\nz (1 2 3)", -1, 1},
+    {"POINT(1 2)", GAIA_POINT, 1},
+    {"POINT(1 2)", GAIA_LINESTRING, 0},
+    {"POINT Z(1 2 3)", GAIA_POINT, 0},
+    {"LINESTRING(0 0, 10 10, 20 -5)", -1, 1},
+    {"LINESTRING Z(0 0 1, 10 10 2)", GAIA_LINESTRING, 1},
+    {"POLYGON((0 0, 10 0, 10 10, 0 10, 0 0), (2 2, 3 2, 3 3, 2 2))", -1,
+     1},
+    {"POLYGON((0 0, 10 0, 10 10, 0 0), (-20 -20, 30 -20, 30 30, -20 -20))",
+     -1, 1},
+    {"POLYGONZ((0 0 1, 10 0 1, 10 10 1, 0 0 1))", -1, 1},
+    {"MULTIPOINT(1 2, 3 4)", -1, 1},
+    {"MULTIPOINT((1 2), (3 4))", GAIA_MULTIPOINT, 1},
+    {"MULTIPOINT(1 2)", -1, 1},
+    {"MULTIPOINT Z((1 2 3))", -1, 1},
+    {"MULTILINESTRING((0 0, 1 1), (2 2, 3 3, 4 4))", -1, 1},
+    {"MULTILINESTRING Z((0 0 0, 1 1 1))", -1, 1},
+    {"MULTIPOLYGON(((0 0, 1 0, 1 1, 0 0)), ((5 5, 6 5, 6 6, 5 5)))", -1,
+     1},
+    {"MULTIPOLYGONZ(((0 0 0, 1 0 0, 1 1 0, 0 0 0)))", -1, 1},
+/* all the following ones are left to the full parser */
+    {"POINT M(1 2 3)", -1, 0},
+    {"POINT ZM(1 2 3 4)", -1, 0},
+    {"POINTZM(1 2 3 4)", -1, 0},
+    {"POINT(1-2)", -1, 0},
+    {"POINT(1e5 2)", -1, 0},
+    {"POINT(.5 2)", -1, 0},
+    {"POINT(1 2 3)", -1, 0},
+    {"POINT(1 2", -1, 0},
+    {"POINT(1 2) x", -1, 0},
+    {"POINT(1\r2)", -1, 0},
+    {"POINTS(1 2)", -1, 0},
+    {"LINESTRING(0 0)", -1, 0},
+    {"POLYGON((0 0, 1 1, 0 0))", -1, 0},
+    {"MULTIPOINT((1 2), 3 4)", -1, 0},
+    {"GEOMETRYCOLLECTION(POINT(1 2))", -1, 0},
+    {"", -1, 0},
+    {NULL, 0, 0}
+};
+
+static struct simple_case geojson_cases[] = {
+    {"{\"type\":\"Point\",\"coordinates\":[1,2]}", -1, 1},
+    {" { \"type\" : \"Point\" , \"coordinates\" : [ -1.25 , 2 , 3 ] } ", -1,
+     1},
+    {"{\"type\":\"LineString\",\"coordinates\":[[0,0],[10,10],[20,-5]]}", -1,
+     1},
+    {"{\"type\":\"Polygon\",\"coordinates\":[[[0,0],[10,0],[10,10],[0,0]],"
+     "[[-1,-1],[2,-1],[2,2],[-1,-1]]]}", -1, 1},
+    {"{\"type\":\"MultiPoint\",\"coordinates\":[[1,2],[3,4]]}", -1, 1},
+    {"{\"type\":\"MultiLineString\",\"coordinates\":[[[0,0,1],[1,1,1]]]}",
+     -1, 1},
+    {"{\"type\":\"MultiPolygon\",\"coordinates\":[[[[0,0],[1,0],[1,1],[0,0]]],"
+     "[[[5,5],[6,5],[6,6],[5,5]]]]}", -1, 1},
+/* all the following ones are left to the full parser */
+    {"{\"type\":\"Point\",\"coordinates\":[1,2,3,4]}", -1, 0},
+    {"{\"type\":\"Point\",\"coordinates\":[1e3,2]}", -1, 0},
+    {"{\"type\":\"point\",\"coordinates\":[1,2]}", -1, 0},
+    {"{\"type\":\"LineString\",\"coordinates\":[[0,0],[1,1,1]]}", -1, 0},
+    {"{\"type\":\"Point\",\"bbox\":[1,2,1,2],\"coordinates\":[1,2]}", -1, 0},
+    {"{\"type\":\"Point\",\"crs\":{\"type\":\"name\",\"properties\":"
+     "{\"name\":\"EPSG:4326\"}},\"coordinates\":[1,2]}", -1, 0},
+    {"{\"coordinates\":[1,2],\"type\":\"Point\"}", -1, 0},
+    {"{\"type\":\"GeometryCollection\",\"geometries\":[]}", -1, 0},
+    {NULL, 0, 0}
+};
+
+static int
+check_case (const char *format, struct simple_case *test, int srid)
+{
+/* comparing the fast path against the full parser */
+    unsigned char *fast = NULL;
+    int fast_size;
+    unsigned char *full = NULL;
+    int full_size = 0;
+    gaiaGeomCollPtr geom;
+    int ret;
+    int retcode = 0;
+
+    if (strcmp (format, "WKT") == 0)
+      {
+	  ret =
+	      gaiaSimpleWktToBlob ((const unsigned char *) (test->text),
+				   test->type, srid, &fast, &fast_size);
+	  geom = gaiaParseWkt ((const unsigned char *) (test->text),
+			       test->type);
+	  if (geom != NULL)
+	      geom->Srid = srid;
+      }
+    else
+      {
+	  ret =
+	      gaiaSimpleGeoJSONToBlob ((const unsigned char *) (test->text),
+				       &fast, &fast_size);
+	  geom = gaiaParseGeoJSON ((const unsigned char *) (test->text));
+      }
+    if (geom != NULL)
+      {
+	  gaiaToSpatiaLiteBlobWkb (geom, &full, &full_size);
+	  gaiaFreeGeomColl (geom);
+      }
+
+    if (ret != test->fast)
+      {
+	  fprintf (stderr, "%s \"%s\": unexpected fast path result %d\n",
+		   format, test->text, ret);
+	  retcode = -1;
+	  goto end;
+      }
+    if (ret)
+      {
+	  if (full == NULL)
+	    {
+		fprintf (stderr, "%s \"%s\": rejected by the full parser\n",
+			 format, test->text);
+		retcode = -2;
+		goto end;
+	    }
+	  if (fast_size != full_size || memcmp (fast, full, full_size) != 0)
+	    {
+		fprintf (stderr, "%s \"%s\": BLOB mismatch\n", format,
+			 test->text);
+		retcode = -3;
+		goto end;
+	    }
+      }
+    else if (fast != NULL)
+      {
+	  fprintf (stderr, "%s \"%s\": unexpected BLOB on failure\n", format,
+		   test->text);
+	  retcode = -4;
+      }
+
+  end:
+    if (fast != NULL)
+	free (fast);
+    if (full != NULL)
+	free (full);
+    return retcode;
+}
+
+static int
+check_sql (sqlite3 * handle, const char *sql, const char *expected)
+{
+/* checking the SQL functions using the fast path */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    char *err_msg = NULL;
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -1;
+      }
+    if (rows != 1 || columns != 1 || results[1] == NULL
+	|| strcmp (results[1], expected) != 0)
+      {
+	  fprintf (stderr, "%s: unexpected \"%s\"\n", sql,
+		   (rows == 1 && results[1] != NULL) ? results[1] : "NULL");
+	  sqlite3_free_table (results);
+	  return -2;
+      }
+    sqlite3_free_table (results);
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    int ret;
+    int i;
+    sqlite3 *handle;
+    void *cache = spatialite_alloc_connection ();
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    for (i = 0; wkt_cases[i].text != NULL; i++)
+      {
+	  if (check_case ("WKT", wkt_cases + i, 0) < 0)
+	      return -1;
+	  if (check_case ("WKT", wkt_cases + i, 4326) < 0)
+	      return -2;
+      }
+    for (i = 0; geojson_cases[i].text != NULL; i++)
+      {
+	  if (check_case ("GeoJSON", geojson_cases + i, 0) < 0)
+	      return -3;
+      }
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory db: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -4;
+      }
+    spatialite_init_ex (handle, cache, 0);
+
+    if (check_sql
+	(handle, "SELECT AsText(GeomFromText('MULTIPOINT((1 2), (3 4))'))",
+	 "MULTIPOINT(1 2, 3 4)") < 0)
+	return -5;
+    if (check_sql
+	(handle, "SELECT SRID(GeomFromText('POINT(1 2)', 4326))", "4326") < 0)
+	return -6;
+    if (check_sql
+	(handle, "SELECT PointFromText('LINESTRING(1 2, 3 4)') IS NULL",
+	 "1") < 0)
+	return -7;
+    if (check_sql
+	(handle, "SELECT AsText(PolygonFromText('POLYGON M((0 0 1, 1 0 1, "
+	 "1 1 1, 0 0 1))'))", "POLYGON M((0 0 1, 1 0 1, 1 1 1, 0 0 1))") < 0)
+	return -8;
+    if (check_sql
+	(handle, "SELECT MbrMaxX(GeomFromGeoJSON('{\"type\":\"Polygon\","
+	 "\"coordinates\":[[[0,0],[10,0],[10,10],[0,0]],"
+	 "[[-1,-1],[20,-1],[20,20],[-1,-1]]]}'))", "10.0") < 0)
+	return -9;
+
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  return -10;
+      }
+    spatialite_cleanup_ex (cache);
+    spatialite_shutdown ();
+    return 0;
+}
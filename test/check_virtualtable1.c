@@ -478,6 +478,47 @@ main (int argc, char *argv[])
       }
     sqlite3_free_table (results);
 
+    ret =
+	sqlite3_get_table (db_handle,
+			   "SELECT ROWNO FROM places WHERE ROWNO > 2.5 AND ROWNO <= 5 ORDER BY ROWNO",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -59;
+      }
+    if ((rows != 3) || (columns != 1) || strcmp (results[1], "3") != 0
+	|| strcmp (results[3], "5") != 0)
+      {
+	  fprintf (stderr,
+		   "Unexpected error: select ROWNO range bad result: %i/%i.\n",
+		   rows, columns);
+	  return -60;
+      }
+    sqlite3_free_table (results);
+
+    ret =
+	sqlite3_get_table (db_handle,
+			   "SELECT (SELECT count(*) FROM places WHERE col002 <> 'Canbrae') + "
+			   "(SELECT count(*) FROM places WHERE col002 = 'Canbrae') = "
+			   "(SELECT count(*) FROM places WHERE col002 IS NOT NULL)",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -61;
+      }
+    if ((rows != 1) || (columns != 1) || strcmp (results[1], "1") != 0)
+      {
+	  fprintf (stderr,
+		   "Unexpected error: select not-equal bad result: %i/%i.\n",
+		   rows, columns);
+	  return -62;
+      }
+    sqlite3_free_table (results);
+
     ret = sqlite3_exec (db_handle, "DROP TABLE places;", NULL, NULL, &err_msg);
     if (ret != SQLITE_OK)
       {
@@ -486,6 +527,111 @@ main (int argc, char *argv[])
 	  return -47;
       }
 
+/* CR-LF line endings and quoted fields spanning more lines */
+    ret =
+	sqlite3_exec (db_handle,
+		      "create VIRTUAL TABLE crlf USING VirtualText(\"testcase2.csv\", UTF-8, 1, POINT, DOUBLEQUOTE, ',');",
+		      NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "VirtualText error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -48;
+      }
+    ret =
+	sqlite3_get_table (db_handle,
+			   "select name, hex(name), typeof(value) from crlf ORDER BY id;",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -49;
+      }
+    if ((rows != 3) || (columns != 3))
+      {
+	  fprintf (stderr,
+		   "Unexpected error: select crlf bad result: %i/%i.\n",
+		   rows, columns);
+	  return -50;
+      }
+    if (strcmp (results[3], "first, with comma") != 0
+	|| strcmp (results[7], "6D756C74690D0A6C696E65") != 0
+	|| strcmp (results[9], "plain") != 0)
+      {
+	  fprintf (stderr, "Unexpected error: crlf names bad result: %s %s %s.\n",
+		   results[3], results[7], results[9]);
+	  return -51;
+      }
+    if (strcmp (results[5], "real") != 0 || strcmp (results[11], "real") != 0)
+      {
+	  fprintf (stderr, "Unexpected error: crlf types bad result: %s %s.\n",
+		   results[5], results[11]);
+	  return -52;
+      }
+    sqlite3_free_table (results);
+
+    ret = sqlite3_exec (db_handle, "DROP TABLE crlf;", NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "DROP TABLE error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -53;
+      }
+
+#ifndef _WIN32
+/* same file, split into many chunks parsed in parallel */
+    setenv ("SPATIALITE_TXT_THREADS", "7", 1);
+    ret =
+	sqlite3_exec (db_handle,
+		      "create VIRTUAL TABLE crlf USING VirtualText(\"testcase2.csv\", UTF-8, 1, POINT, DOUBLEQUOTE, ',');",
+		      NULL, NULL, &err_msg);
+    unsetenv ("SPATIALITE_TXT_THREADS");
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "VirtualText error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -54;
+      }
+    ret =
+	sqlite3_get_table (db_handle,
+			   "select name, hex(name), typeof(value) from crlf ORDER BY id;",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -55;
+      }
+    if ((rows != 3) || (columns != 3))
+      {
+	  fprintf (stderr,
+		   "Unexpected error: select parallel crlf bad result: %i/%i.\n",
+		   rows, columns);
+	  return -56;
+      }
+    if (strcmp (results[3], "first, with comma") != 0
+	|| strcmp (results[7], "6D756C74690D0A6C696E65") != 0
+	|| strcmp (results[9], "plain") != 0
+	|| strcmp (results[5], "real") != 0
+	|| strcmp (results[11], "real") != 0)
+      {
+	  fprintf (stderr,
+		   "Unexpected error: parallel crlf bad result: %s %s %s.\n",
+		   results[3], results[7], results[9]);
+	  return -57;
+      }
+    sqlite3_free_table (results);
+
+    ret = sqlite3_exec (db_handle, "DROP TABLE crlf;", NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "DROP TABLE error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -58;
+      }
+#endif /* not WIN32 */
+
     sqlite3_close (db_handle);
     spatialite_cleanup_ex (cache);
 #endif /* end ICONV conditional */
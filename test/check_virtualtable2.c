@@ -1089,6 +1089,125 @@ do_test (sqlite3 * db_handle)
       }
     sqlite3_free_table (results);
 
+/* spatial filter pushdown: Geometry = FilterMbrXXX() */
+    ret =
+	sqlite3_exec (db_handle,
+		      "create VIRTUAL TABLE shapembr USING VirtualShape(\"shp/foggia/local_councils\", CP1252, 32633);",
+		      NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "VirtualShape error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -133;
+      }
+    ret =
+	sqlite3_get_table (db_handle,
+			   "SELECT (SELECT Count(*) FROM shapembr "
+			   "WHERE Geometry = FilterMbrIntersects(1000000, 4600000, 1050000, 4650000)), "
+			   "(SELECT Count(*) FROM shapembr "
+			   "WHERE MbrIntersects(Geometry, BuildMbr(1000000, 4600000, 1050000, 4650000))), "
+			   "(SELECT Count(*) FROM shapembr "
+			   "WHERE Geometry = FilterMbrWithin(1000000, 4600000, 1050000, 4650000) AND PKUID > 10), "
+			   "(SELECT Count(*) FROM shapembr "
+			   "WHERE MbrWithin(Geometry, BuildMbr(1000000, 4600000, 1050000, 4650000)) AND PKUID > 10)",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -134;
+      }
+    if ((rows != 1) || (columns != 4))
+      {
+	  fprintf (stderr,
+		   "Unexpected error: select columns bad result: %i/%i.\n",
+		   rows, columns);
+	  return -135;
+      }
+    if (strcmp (results[4], "28") != 0 || strcmp (results[5], "28") != 0)
+      {
+	  fprintf (stderr,
+		   "Unexpected error: FilterMbrIntersects bad result: %s/%s.\n",
+		   results[4], results[5]);
+	  return -136;
+      }
+    if (strcmp (results[6], results[7]) != 0)
+      {
+	  fprintf (stderr,
+		   "Unexpected error: FilterMbrWithin bad result: %s/%s.\n",
+		   results[6], results[7]);
+	  return -137;
+      }
+    sqlite3_free_table (results);
+
+/* self-join: each cursor must decode its own row */
+    ret =
+	sqlite3_get_table (db_handle,
+			   "SELECT Count(*) FROM shapembr AS a, shapembr AS b "
+			   "WHERE a.lc_name = b.lc_name", &results, &rows,
+			   &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "Error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -139;
+      }
+    if ((rows != 1) || (columns != 1))
+      {
+	  fprintf (stderr,
+		   "Unexpected error: select columns bad result: %i/%i.\n",
+		   rows, columns);
+	  return -140;
+      }
+    if (strcmp (results[1], "61") != 0)
+      {
+	  fprintf (stderr, "Unexpected error: self-join bad result: %s.\n",
+		   results[1]);
+	  return -141;
+      }
+    sqlite3_free_table (results);
+    ret =
+	sqlite3_exec (db_handle, "DROP TABLE shapembr", NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "DROP TABLE error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -138;
+      }
+
+/* a charset failure on a filtered column must be an SQL error */
+    ret =
+	sqlite3_exec (db_handle,
+		      "create VIRTUAL TABLE badcharset USING VirtualShape(\"shp/gaza/route\", ASCII, 4326);",
+		      NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "VirtualShape error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -142;
+      }
+    ret =
+	sqlite3_get_table (db_handle,
+			   "SELECT Count(*) FROM badcharset WHERE name = 'none'",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_ERROR)
+      {
+	  fprintf (stderr, "Unexpected result: charset failure ignored\n");
+	  if (ret == SQLITE_OK)
+	      sqlite3_free_table (results);
+	  return -143;
+      }
+    sqlite3_free (err_msg);
+    ret =
+	sqlite3_exec (db_handle, "DROP TABLE badcharset", NULL, NULL,
+		      &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "DROP TABLE error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -144;
+      }
+
 /* final DB cleanup */
     ret =
 	sqlite3_exec (db_handle,
@@ -196,6 +196,37 @@ main (int argc, char *argv[])
 	  return -9;
       }
 
+/* a charset failure on a filtered column must be an SQL error */
+    ret =
+	sqlite3_exec (db_handle,
+		      "create VIRTUAL TABLE dbftest USING VirtualDBF('shp/gaza/route.dbf', ASCII);",
+		      NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "VirtualDBF error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -10;
+      }
+    ret =
+	sqlite3_get_table (db_handle,
+			   "SELECT Count(*) FROM dbftest WHERE name = 'none'",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_ERROR)
+      {
+	  fprintf (stderr, "Unexpected result: charset failure ignored\n");
+	  if (ret == SQLITE_OK)
+	      sqlite3_free_table (results);
+	  return -11;
+      }
+    sqlite3_free (err_msg);
+    ret = sqlite3_exec (db_handle, "DROP TABLE dbftest;", NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "DROP TABLE error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return -12;
+      }
+
     sqlite3_close (db_handle);
     spatialite_cleanup_ex (cache);
 #endif /* end ICONV conditional */
@@ -0,0 +1,459 @@
+/*
+
+ check_wfs_prefetch.c -- SpatiaLite Test Case
+
+ Author: Sandro Furieri <a.furieri@lqt.it>
+
+ ------------------------------------------------------------------------------
+ 
+ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+ 
+ The contents of this file are subject to the Mozilla Public License Version
+ 1.1 (the "License"); you may not use this file except in compliance with
+ the License. You may obtain a copy of the License at
+ http://www.mozilla.org/MPL/
+ 
+Software distributed under the License is distributed on an "AS IS" basis,
+WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+for the specific language governing rights and limitations under the
+License.
+
+The Original Code is the SpatiaLite library
+
+The Initial Developer of the Original Code is Alessandro Furieri
+ 
+Portions created by the Initial Developer are Copyright (C) 2013
+the Initial Developer. All Rights Reserved.
+
+Contributor(s):
+
+Alternatively, the contents of this file may be used under the terms of
+either the GNU General Public License Version 2 or later (the "GPL"), or
+the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+in which case the provisions of the GPL or the LGPL are applicable instead
+of those above. If you wish to allow use of your version of this file only
+under the terms of either the GPL or the LGPL, and not to allow others to
+use your version of this file under the terms of the MPL, indicate your
+decision by deleting the provisions above and replace them with the notice
+and other provisions required by the GPL or the LGPL. If you do not delete
+the provisions above, a recipient may use your version of this file under
+the terms of any one of the MPL, the GPL or the LGPL.
+ 
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#ifdef ENABLE_LIBXML2
+#include <libxml/xmlversion.h>
+#endif
+
+#include "sqlite3.h"
+#include "spatialite.h"
+#include "spatialite/gg_wfs.h"
+
+#if defined(ENABLE_LIBXML2) && defined(LIBXML_HTTP_ENABLED) && !defined(_WIN32)
+#define WFS_STUB
+#endif
+
+#ifdef WFS_STUB
+
+static const char *wfs_schema =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<xsd:schema xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\" "
+    "xmlns:gml=\"http://www.opengis.net/gml\" "
+    "xmlns:topp=\"http://www.openplans.org/topp\" "
+    "elementFormDefault=\"qualified\" "
+    "targetNamespace=\"http://www.openplans.org/topp\">\n"
+    "<xsd:complexType name=\"p02Type\"><xsd:complexContent>"
+    "<xsd:extension base=\"gml:AbstractFeatureType\"><xsd:sequence>\n"
+    "<xsd:element maxOccurs=\"1\" minOccurs=\"0\" name=\"objectid\" "
+    "nillable=\"true\" type=\"xsd:long\"/>\n"
+    "<xsd:element maxOccurs=\"1\" minOccurs=\"0\" name=\"name\" "
+    "nillable=\"true\" type=\"xsd:string\"/>\n"
+    "<xsd:element maxOccurs=\"1\" minOccurs=\"0\" name=\"geometry\" "
+    "nillable=\"true\" type=\"gml:PointPropertyType\"/>\n"
+    "</xsd:sequence></xsd:extension></xsd:complexContent>"
+    "</xsd:complexType>\n"
+    "<xsd:element name=\"p02\" substitutionGroup=\"gml:_Feature\" "
+    "type=\"topp:p02Type\"/>\n</xsd:schema>\n";
+
+struct wfs_stub
+{
+/* a loopback HTTP server returning a paged WFS layer */
+    int sock;
+    int port;
+    int features;		/* how many features the layer contains */
+    int matched;		/* announcing numberMatched on every page */
+    int requests;		/* GetFeature requests served */
+    int stop;
+    pthread_t thread;
+};
+
+static int
+query_arg (const char *request, const char *name, int dflt)
+{
+/* extracting some integer argument from the request line */
+    const char *p = strstr (request, name);
+    const char *eol = strchr (request, '\n');
+    if (p == NULL || (eol != NULL && p > eol))
+	return dflt;
+    return atoi (p + strlen (name));
+}
+
+static char *
+wfs_stub_page (struct wfs_stub *stub, const char *request)
+{
+/* building a GetFeature response */
+    char *xml;
+    char *prev;
+    int i;
+    int first = query_arg (request, "startIndex=", 0);
+    int max = query_arg (request, "maxFeatures=", stub->features);
+    int last = first + max;
+    char matched[64];
+    if (last > stub->features)
+	last = stub->features;
+    if (first > last)
+	first = last;
+    *matched = '\0';
+    if (stub->matched)
+	sprintf (matched, " numberMatched=\"%d\"", stub->features);
+    xml =
+	sqlite3_mprintf
+	("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	 "<wfs:FeatureCollection xmlns:wfs=\"http://www.opengis.net/wfs\" "
+	 "xmlns:topp=\"http://www.openplans.org/topp\" "
+	 "xmlns:gml=\"http://www.opengis.net/gml\" "
+	 "numberOfFeatures=\"%d\"%s>\n", last - first, matched);
+    for (i = first; i < last; i++)
+      {
+	  prev = xml;
+	  xml =
+	      sqlite3_mprintf
+	      ("%s<gml:featureMember><topp:p02 fid=\"p02.%d\">"
+	       "<topp:objectid>%d</topp:objectid><topp:name>n%d</topp:name>"
+	       "<topp:geometry><gml:Point srsName=\"EPSG:4326\">"
+	       "<gml:coordinates>%d,%d</gml:coordinates></gml:Point>"
+	       "</topp:geometry></topp:p02></gml:featureMember>\n", prev, i, i,
+	       i, i % 180, i / 180);
+	  sqlite3_free (prev);
+      }
+    prev = xml;
+    xml = sqlite3_mprintf ("%s</wfs:FeatureCollection>\n", prev);
+    sqlite3_free (prev);
+    return xml;
+}
+
+static void *
+wfs_stub_main (void *arg)
+{
+/* serving one request at each time */
+    struct wfs_stub *stub = (struct wfs_stub *) arg;
+    char request[4096];
+    char header[256];
+    char *body;
+    int len;
+    int ret;
+    int conn;
+    while (1)
+      {
+	  conn = accept (stub->sock, NULL, NULL);
+	  if (conn < 0)
+	      continue;
+	  if (stub->stop)
+	    {
+		close (conn);
+		break;
+	    }
+	  len = 0;
+	  while (len < (int) sizeof (request) - 1)
+	    {
+		ret = read (conn, request + len, sizeof (request) - 1 - len);
+		if (ret <= 0)
+		    break;
+		len += ret;
+		request[len] = '\0';
+		if (strstr (request, "\r\n\r\n") != NULL)
+		    break;
+	    }
+	  request[len] = '\0';
+	  if (strstr (request, "GET /describe") == request)
+	      body = sqlite3_mprintf ("%s", wfs_schema);
+	  else
+	    {
+		body = wfs_stub_page (stub, request);
+		stub->requests += 1;
+	    }
+	  sprintf (header,
+		   "HTTP/1.0 200 OK\r\nContent-Type: text/xml\r\n"
+		   "Content-Length: %d\r\nConnection: close\r\n\r\n",
+		   (int) strlen (body));
+	  if (write (conn, header, strlen (header)) < 0
+	      || write (conn, body, strlen (body)) < 0)
+	      fprintf (stderr, "WFS stub: write error\n");
+	  sqlite3_free (body);
+	  close (conn);
+      }
+    return NULL;
+}
+
+static int
+start_wfs_stub (struct wfs_stub *stub)
+{
+/* starting the loopback server on some free port */
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof (addr);
+    stub->sock = socket (AF_INET, SOCK_STREAM, 0);
+    if (stub->sock < 0)
+	return 0;
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind (stub->sock, (struct sockaddr *) &addr, sizeof (addr)) != 0
+	|| listen (stub->sock, 64) != 0
+	|| getsockname (stub->sock, (struct sockaddr *) &addr,
+			&addr_len) != 0)
+      {
+	  close (stub->sock);
+	  return 0;
+      }
+    stub->port = ntohs (addr.sin_port);
+    stub->stop = 0;
+    if (pthread_create (&(stub->thread), NULL, wfs_stub_main, stub) != 0)
+      {
+	  close (stub->sock);
+	  return 0;
+      }
+    return 1;
+}
+
+static void
+stop_wfs_stub (struct wfs_stub *stub)
+{
+/* waking up the server by a last connection */
+    struct sockaddr_in addr;
+    int sock = socket (AF_INET, SOCK_STREAM, 0);
+    stub->stop = 1;
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = htons (stub->port);
+    if (sock >= 0)
+      {
+	  if (connect (sock, (struct sockaddr *) &addr, sizeof (addr)) != 0)
+	      fprintf (stderr, "WFS stub: unable to stop\n");
+	  close (sock);
+      }
+    pthread_join (stub->thread, NULL);
+    close (stub->sock);
+}
+
+static int
+load_wfs_stub (sqlite3 * handle, struct wfs_stub *stub, const char *threads,
+	       const char *table)
+{
+/* loading the whole layer by pages of 100 features */
+    int ret;
+    int rows;
+    char *err_msg = NULL;
+    char *url =
+	sqlite3_mprintf
+	("http://127.0.0.1:%d/wfs?service=WFS&request=GetFeature&typeName=topp:p02",
+	 stub->port);
+    char *describe =
+	sqlite3_mprintf ("http://127.0.0.1:%d/describe", stub->port);
+    setenv ("SPATIALITE_WFS_THREADS", threads, 1);
+    stub->requests = 0;
+    ret =
+	load_from_wfs_paged (handle, url, describe, "topp:p02", 0, table,
+			     NULL, 0, 100, &rows, &err_msg, NULL, NULL);
+    sqlite3_free (url);
+    sqlite3_free (describe);
+    if (!ret)
+      {
+	  fprintf (stderr, "load_from_wfs_paged() error for %s: %s\n", table,
+		   err_msg);
+	  free (err_msg);
+	  return -1;
+      }
+    return rows;
+}
+
+static int
+same_wfs_rows (sqlite3 * handle, const char *table1, const char *table2)
+{
+/* checking that both tables contain exactly the same features */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    int same = 0;
+    char *sql =
+	sqlite3_mprintf ("SELECT (SELECT Count(*) FROM \"%w\") - "
+			 "(SELECT Count(*) FROM \"%w\"), "
+			 "(SELECT Count(*) FROM (SELECT objectid, name, "
+			 "AsText(geometry) FROM \"%w\" EXCEPT SELECT objectid, "
+			 "name, AsText(geometry) FROM \"%w\"))", table1,
+			 table2, table1, table2);
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    sqlite3_free (sql);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "compare \"%s\" error: %s\n", table1,
+		   sqlite3_errmsg (handle));
+	  return 0;
+      }
+    if (rows == 1)
+	same = atoi (results[2]) == 0 && atoi (results[3]) == 0;
+    sqlite3_free_table (results);
+    if (!same)
+	fprintf (stderr, "\"%s\" and \"%s\" differ\n", table1, table2);
+    return same;
+}
+
+static int
+check_prefetch (sqlite3 * handle, int features, int matched)
+{
+/* loading the same layer sequentially and by prefetching workers */
+    struct wfs_stub stub;
+    const char *threads[] = { "0", "1", "4", "16" };
+    char table[64];
+    char reference[64];
+    int expected;
+    int requests = 0;
+    int i;
+    int rows;
+    int result = 0;
+
+    stub.features = features;
+    stub.matched = matched;
+    if (!start_wfs_stub (&stub))
+      {
+	  fprintf (stderr, "unable to start the WFS stub\n");
+	  return -1;
+      }
+    sprintf (reference, "wfs_%d_%d_%s", features, matched, threads[0]);
+    for (i = 0; i < 4; i++)
+      {
+	  sprintf (table, "wfs_%d_%d_%s", features, matched, threads[i]);
+	  rows = load_wfs_stub (handle, &stub, threads[i], table);
+	  if (rows != features)
+	    {
+		fprintf (stderr, "%s: unexpected %d rows\n", table, rows);
+		result = -2;
+		break;
+	    }
+	  if (i == 0)
+	      requests = stub.requests;
+	  else
+	    {
+		if (!same_wfs_rows (handle, reference, table))
+		  {
+		      result = -3;
+		      break;
+		  }
+		/*
+		   / no page following the last one may be requested when
+		   / the total is known; otherwise only the pages already
+		   / claimed when the short page arrived
+		 */
+		expected = requests + (matched ? 0 : atoi (threads[i]) - 1);
+		if (stub.requests > expected)
+		  {
+		      fprintf (stderr, "%s: %d requests (expected %d)\n",
+			       table, stub.requests, expected);
+		      result = -4;
+		      break;
+		  }
+	    }
+      }
+    stop_wfs_stub (&stub);
+    return result;
+}
+
+#endif /* WFS_STUB */
+
+int
+main (int argc, char *argv[])
+{
+    int ret;
+    sqlite3 *handle;
+    char *err_msg = NULL;
+    void *cache = spatialite_alloc_connection ();
+
+    if (argc > 1 || argv[0] == NULL)
+	argc = 1;		/* silencing stupid compiler warnings */
+
+    ret =
+	sqlite3_open_v2 (":memory:", &handle,
+			 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "cannot open in-memory database: %s\n",
+		   sqlite3_errmsg (handle));
+	  sqlite3_close (handle);
+	  return -1;
+      }
+
+    spatialite_init_ex (handle, cache, 0);
+
+    ret =
+	sqlite3_exec (handle, "SELECT InitSpatialMetadata(1)", NULL, NULL,
+		      &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "InitSpatialMetadata() error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -2;
+      }
+
+#ifdef WFS_STUB
+    /* the loopback server must never be reached through a proxy */
+    unsetenv ("http_proxy");
+    unsetenv ("HTTP_PROXY");
+
+    /* a short last page, then an empty one */
+    if (check_prefetch (handle, 1050, 0) != 0)
+      {
+	  sqlite3_close (handle);
+	  return -3;
+      }
+    if (check_prefetch (handle, 1000, 0) != 0)
+      {
+	  sqlite3_close (handle);
+	  return -4;
+      }
+    /* the last page announced by numberMatched */
+    if (check_prefetch (handle, 1050, 1) != 0)
+      {
+	  sqlite3_close (handle);
+	  return -5;
+      }
+    unsetenv ("SPATIALITE_WFS_THREADS");
+#endif
+
+    ret = sqlite3_close (handle);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "sqlite3_close() error: %s\n",
+		   sqlite3_errmsg (handle));
+	  return -6;
+      }
+
+    spatialite_cleanup_ex (cache);
+    spatialite_shutdown ();
+    return 0;
+}
@@ -69,6 +69,9 @@ main (int argc, char *argv[])
     int type;
     int dims;
     int nillable;
+    char **results;
+    int rows;
+    int columns;
     void *cache = spatialite_alloc_connection ();
 
     if (argc > 1 || argv[0] == NULL)
@@ -137,6 +140,28 @@ main (int argc, char *argv[])
 	  return -6;
       }
 
+    ret =
+	sqlite3_get_table (handle,
+			   "SELECT Count(*) FROM test_wfs2 WHERE "
+			   "ST_Srid(geometry) = 25832 AND "
+			   "ST_AsText(geometry) LIKE 'POINT(66%'", &results,
+			   &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "test_wfs2 geometries error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -78;
+      }
+    if (rows != 1 || columns != 1 || strcmp (results[1], "3") != 0)
+      {
+	  fprintf (stderr, "unexpected geometries for test_wfs2\n");
+	  sqlite3_free_table (results);
+	  sqlite3_close (handle);
+	  return -79;
+      }
+    sqlite3_free_table (results);
+
     catalog = create_wfs_catalog ("./getcapabilities-1.0.0.wfs", &err_msg);
     if (catalog == NULL)
       {
@@ -59,6 +59,9 @@ main (int argc, char *argv[])
     char *err_msg = NULL;
     unsigned int row_count;
     int rcnt;
+    char **results;
+    int rows;
+    int columns;
     void *cache = spatialite_alloc_connection ();
 
     if (argc > 1 || argv[0] == NULL)
@@ -119,6 +122,58 @@ main (int argc, char *argv[])
 	  return -6;
       }
 
+/* two header cells of this worksheet are numbers (1.25 and 2.75) */
+    ret =
+	load_XL (handle, "./testcase2.xls", "test3", 0, 1, &row_count, err_msg);
+    if (!ret)
+      {
+	  fprintf (stderr, "load_XL() error numeric titles: %s\n", err_msg);
+	  sqlite3_close (handle);
+	  return -12;
+      }
+    if (row_count != 16)
+      {
+	  fprintf (stderr, "load_XL() unexpected row count numeric titles: %u\n",
+		   row_count);
+	  sqlite3_close (handle);
+	  return -13;
+      }
+
+/* VirtualXL only fetches the projected and the filtered columns */
+    ret =
+	sqlite3_exec (handle,
+		      "CREATE VIRTUAL TABLE xltest USING VirtualXL('./testcase2.xls', 0, 1)",
+		      NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "VirtualXL error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -14;
+      }
+    ret =
+	sqlite3_get_table (handle,
+			   "SELECT (SELECT group_concat(\"2.75\", ',') FROM test3 "
+			   "WHERE \"1.25\" IS NOT NULL), (SELECT group_concat(\"2.75\", ',') "
+			   "FROM xltest WHERE \"1.25\" IS NOT NULL)", &results,
+			   &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "VirtualXL projection error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -15;
+      }
+    if (rows != 1 || columns != 2 || results[2] == NULL || results[3] == NULL
+	|| strcmp (results[2], results[3]) != 0)
+      {
+	  fprintf (stderr, "VirtualXL projection mismatch\n");
+	  sqlite3_free_table (results);
+	  sqlite3_close (handle);
+	  return -16;
+      }
+    sqlite3_free_table (results);
+
     check_duplicated_rows (handle, "test1", &rcnt);
     if (rcnt != 0)
       {
@@ -51,6 +51,119 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include "sqlite3.h"
 #include "spatialite.h"
 
+#ifndef OMIT_ICONV		/* only if ICONV is supported */
+#ifndef _WIN32
+static int
+check_count (sqlite3 * handle, const char *sql, int expected)
+{
+/* checking a single Count(*) */
+    int ret;
+    char **results;
+    int rows;
+    int columns;
+    int count = -1;
+    ret = sqlite3_get_table (handle, sql, &results, &rows, &columns, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "%s: %s\n", sql, sqlite3_errmsg (handle));
+	  return 0;
+      }
+    if (rows == 1 && results[1] != NULL)
+	count = atoi (results[1]);
+    sqlite3_free_table (results);
+    if (count != expected)
+      {
+	  fprintf (stderr, "%s: unexpected %d (expected %d)\n", sql, count,
+		   expected);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+check_threaded_load (sqlite3 * handle)
+{
+/*
+/ loading a Shapefile long enough to be split into many batches,
+/ first serially and then by three decoding worker threads
+*/
+    int ret;
+    int row_count;
+    char *shpname = __FILE__ "many";
+    char *path;
+    const char *sql =
+	"CREATE TABLE many (id INTEGER PRIMARY KEY, name TEXT);"
+	"SELECT AddGeometryColumn('many', 'geom', 4326, 'POLYGON', 'XY');"
+	"WITH RECURSIVE c(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM c "
+	"WHERE i < 3000) INSERT INTO many SELECT i, 'name #' || i, "
+	"CASE WHEN i % 5 = 0 THEN GeomFromText('POLYGON((' || i || ' 0, ' "
+	"|| (i + 4) || ' 0, ' || (i + 4) || ' 4, ' || i || ' 4, ' || i "
+	"|| ' 0), (' || (i + 1) || ' 1, ' || (i + 1) || ' 3, ' || (i + 3) "
+	"|| ' 3, ' || (i + 3) || ' 1, ' || (i + 1) || ' 1))', 4326) "
+	"ELSE BuildMbr(i, 0, i + 1, 1, 4326) END FROM c";
+
+    ret = sqlite3_exec (handle, sql, NULL, NULL, NULL);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "many: %s\n", sqlite3_errmsg (handle));
+	  return 0;
+      }
+    ret =
+	dump_shapefile (handle, "many", "geom", shpname, "CP1252", "POLYGON",
+			0, &row_count, NULL);
+    if (!ret || row_count != 3000)
+      {
+	  fprintf (stderr, "dump_shapefile() error for many: %d\n",
+		   row_count);
+	  return 0;
+      }
+
+    setenv ("SPATIALITE_SHP_THREADS", "0", 1);
+    ret =
+	load_shapefile (handle, shpname, "many_st", "CP1252", 4326, "geom", 0,
+			0, 0, 0, &row_count, NULL);
+    setenv ("SPATIALITE_SHP_THREADS", "3", 1);
+    if (ret && row_count == 3000)
+	ret =
+	    load_shapefile (handle, shpname, "many_mt", "CP1252", 4326,
+			    "geom", 0, 0, 0, 0, &row_count, NULL);
+    unsetenv ("SPATIALITE_SHP_THREADS");
+    path = sqlite3_mprintf ("%s.shp", shpname);
+    unlink (path);
+    sqlite3_free (path);
+    path = sqlite3_mprintf ("%s.shx", shpname);
+    unlink (path);
+    sqlite3_free (path);
+    path = sqlite3_mprintf ("%s.dbf", shpname);
+    unlink (path);
+    sqlite3_free (path);
+    if (!ret || row_count != 3000)
+      {
+	  fprintf (stderr, "load_shapefile() error for many: %d\n",
+		   row_count);
+	  return 0;
+      }
+
+/* the rows must be inserted in their original order */
+    if (!check_count
+	(handle, "SELECT Count(*) FROM many_mt WHERE PK_UID <> id", 0))
+	return 0;
+    if (!check_count
+	(handle, "SELECT Count(*) FROM many_mt AS a JOIN many AS b "
+	 "ON (a.id = b.id) WHERE a.name <> b.name OR "
+	 "ST_Area(a.geom) <> ST_Area(b.geom) OR "
+	 "MbrMinX(a.geom) <> MbrMinX(b.geom) OR "
+	 "MbrMaxY(a.geom) <> MbrMaxY(b.geom)", 0))
+	return 0;
+    if (!check_count
+	(handle, "SELECT Count(*) FROM (SELECT * FROM many_st "
+	 "EXCEPT SELECT * FROM many_mt)", 0))
+	return 0;
+    return 1;
+}
+#endif
+#endif /* end ICONV conditional */
+
 int
 main (int argc, char *argv[])
 {
@@ -152,6 +265,14 @@ main (int argc, char *argv[])
 	  return -8;
       }
 
+#ifndef _WIN32
+    if (!check_threaded_load (handle))
+      {
+	  sqlite3_close (handle);
+	  return -10;
+      }
+#endif
+
     ret = dump_dbf (handle, "points", dbfname, "CP1252", err_msg);
     if (!ret)
       {
@@ -52,6 +52,103 @@ the terms of any one of the MPL, the GPL or the LGPL.
 #include "sqlite3.h"
 #include "spatialite.h"
 
+#ifndef OMIT_ICONV		/* only if ICONV is supported */
+static int
+check_exported_file (const char *path, const char *expected)
+{
+/* comparing the whole exported file against the expected text */
+    char buf[4096];
+    size_t len;
+    FILE *in = fopen (path, "rb");
+    if (in == NULL)
+      {
+	  fprintf (stderr, "cannot open \"%s\"\n", path);
+	  return 0;
+      }
+    len = fread (buf, 1, sizeof (buf) - 1, in);
+    fclose (in);
+    buf[len] = '\0';
+    if (strcmp (buf, expected) != 0)
+      {
+	  fprintf (stderr, "unexpected \"%s\" content:\n%s\nexpected:\n%s\n",
+		   path, buf, expected);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+check_geojson_features (sqlite3 * handle, char *path)
+{
+/* exporting a few well-known rows and checking the output */
+    int ret;
+    int row_count;
+    char *err_msg = NULL;
+    const char *sql =
+	"CREATE TABLE feat (id INTEGER PRIMARY KEY, name TEXT, "
+	"value DOUBLE, misc BLOB);"
+	"SELECT AddGeometryColumn('feat', 'geom', 4326, 'POINT', 'XY');"
+	"INSERT INTO feat VALUES (1, 'plain', 1.5, NULL, "
+	"MakePoint(11.5, 43.25, 4326));"
+	"INSERT INTO feat VALUES (2, 'tab' || char(9) || '\"q\" \\', -2, "
+	"zeroblob(2), MakePoint(-1, 0.125, 4326));"
+	"INSERT INTO feat VALUES (3, NULL, NULL, NULL, NULL)";
+    const char *feature1 =
+	"{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+	"\"coordinates\":[11.5,43.25]},\"properties\":{\"id\":1,"
+	"\"name\":\"plain\",\"value\":1.5,\"misc\":null}}";
+    const char *feature2 =
+	"{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+	"\"coordinates\":[-1,0.125]},\"properties\":{\"id\":2,"
+	"\"name\":\"tab\\t\\\"q\\\" \\\\\",\"value\":-2.0,\"misc\":null}}";
+    const char *feature3 =
+	"{\"type\":\"Feature\",\"geometry\":null,\"properties\":{\"id\":3,"
+	"\"name\":null,\"value\":null,\"misc\":null}}";
+    char *expected;
+
+    ret = sqlite3_exec (handle, sql, NULL, NULL, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "feat table error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  return 0;
+      }
+
+/* a FeatureCollection, one Feature per line */
+    ret = dump_geojson_features (handle, "feat", "geom", path, 3, 0, 0,
+				 &row_count);
+    if (!ret || row_count != 3)
+      {
+	  fprintf (stderr, "dump_geojson_features() error: %d\n", row_count);
+	  return 0;
+      }
+    expected =
+	sqlite3_mprintf
+	("{\"type\":\"FeatureCollection\",\"features\":[\n%s,\n%s,\n%s\n]}\n",
+	 feature1, feature2, feature3);
+    ret = check_exported_file (path, expected);
+    sqlite3_free (expected);
+    unlink (path);
+    if (!ret)
+	return 0;
+
+/* newline-delimited Features */
+    ret = dump_geojson_features (handle, "feat", "geom", path, 3, 0, 1,
+				 &row_count);
+    if (!ret || row_count != 3)
+      {
+	  fprintf (stderr, "dump_geojson_features() NDJSON error: %d\n",
+		   row_count);
+	  return 0;
+      }
+    expected = sqlite3_mprintf ("%s\n%s\n%s\n", feature1, feature2, feature3);
+    ret = check_exported_file (path, expected);
+    sqlite3_free (expected);
+    unlink (path);
+    return ret;
+}
+#endif /* end ICONV conditional */
+
 int
 main (int argc, char *argv[])
 {
@@ -62,6 +159,10 @@ main (int argc, char *argv[])
     char *geojsonname = __FILE__ "test.geojson";
     char *err_msg = NULL;
     int row_count;
+    int row_count2;
+    char **results;
+    int rows;
+    int columns;
     void *cache = spatialite_alloc_connection ();
 
     if (argc > 1 || argv[0] == NULL)
@@ -219,12 +320,66 @@ main (int argc, char *argv[])
       }
     unlink (geojsonname);
 
+    ret =
+	dump_geojson_features (handle, "route", "col1", geojsonname, 10, 5, 0,
+			       &row_count);
+    if (!ret || row_count <= 0)
+      {
+	  fprintf (stderr,
+		   "dump_geojson_features() error for shp/taiwan/route: %s\n",
+		   err_msg);
+	  sqlite3_close (handle);
+	  return -17;
+      }
+
+    ret =
+	load_geojson (handle, geojsonname, "route_json", "geom", -1, 1, 0,
+		      &row_count2, NULL);
+    if (!ret || row_count2 != row_count)
+      {
+	  fprintf (stderr, "load_geojson() error for shp/taiwan/route: %d\n",
+		   row_count2);
+	  sqlite3_close (handle);
+	  return -18;
+      }
+    unlink (geojsonname);
+
+    ret =
+	sqlite3_get_table (handle,
+			   "SELECT Count(*) FROM route AS a "
+			   "JOIN route_json AS b ON (a.PK_UID = b.PK_UID) "
+			   "WHERE a.name IS NOT b.name OR "
+			   "GeometryType(a.col1) <> GeometryType(b.geom) OR "
+			   "Abs(ST_Length(a.col1) - ST_Length(b.geom)) > 0.000001",
+			   &results, &rows, &columns, &err_msg);
+    if (ret != SQLITE_OK)
+      {
+	  fprintf (stderr, "route_json check error: %s\n", err_msg);
+	  sqlite3_free (err_msg);
+	  sqlite3_close (handle);
+	  return -19;
+      }
+    if (rows != 1 || strcmp (results[1], "0") != 0)
+      {
+	  fprintf (stderr, "route_json: unexpected mismatching rows\n");
+	  sqlite3_free_table (results);
+	  sqlite3_close (handle);
+	  return -20;
+      }
+    sqlite3_free_table (results);
+
+    if (!check_geojson_features (handle, geojsonname))
+      {
+	  sqlite3_close (handle);
+	  return -21;
+      }
+
     ret = sqlite3_close (handle);
     if (ret != SQLITE_OK)
       {
 	  fprintf (stderr, "sqlite3_close() error: %s\n",
 		   sqlite3_errmsg (handle));
-	  return -17;
+	  return -22;
       }
 
     spatialite_cleanup_ex (cache);